@@ -75,6 +75,12 @@ public class AINiagara : ModuleRules
 		{
 			PrivateDependencyModuleNames.Add("AutomationTest");
 		}
+
+		// Loopback server of the tests (Tests/GeminiTestHelpers.h)
+		if (Target.bBuildDeveloperTools)
+		{
+			PrivateDependencyModuleNames.Add("Sockets");
+		}
 		
 		
 		DynamicallyLoadedModuleNames.AddRange(
@@ -8,6 +8,9 @@
 #include "UI/Widgets/SAINiagaraChatWidget.h"
 #include "Core/AINiagaraSettings.h"
 #include "Core/AINiagaraLogMonitor.h"
+#include "Core/VFXDSLCodec.h"
+#include "Core/GeminiResponseCache.h"
+#include "Core/GeminiMetrics.h"
 #include "ToolMenus.h"
 #include "Widgets/Docking/SDockTab.h"
 #include "Framework/Docking/TabManager.h"
@@ -35,6 +38,15 @@ void FAINiagaraModule::StartupModule()
 	// Initialize log monitor for debugging
 	FAINiagaraLogMonitor::Get().Initialize();
 	
+	// Build the DSL field tables from reflection data once, before the first parse
+	FVFXDSLCodec::Initialize();
+	
+	// Console control of the Gemini response cache (AINiagara.ResponseCache)
+	FGeminiResponseCache::RegisterConsoleCommands();
+	
+	// Gemini request timings and token usage (AINiagara.Metrics)
+	FGeminiMetricsRegistry::RegisterConsoleCommands();
+	
 	// Register OnPostEngineInit delegate - this ensures menus are registered after engine is fully initialized
 	OnPostEngineInitDelegateHandle = FCoreDelegates::OnPostEngineInit.AddRaw(this, &FAINiagaraModule::OnPostEngineInit);
 	
@@ -203,10 +215,10 @@ bool FAINiagaraModule::IsChatWindowSpawned()
 
 void FAINiagaraModule::InvokeChatWindowSpawn()
 {
-	// Check if API key is configured
+	// Check if API key is configured; a setup that only uses an OpenAI-compatible server needs none
 	if (UAINiagaraSettings* Settings = UAINiagaraSettings::Get())
 	{
-		if (!Settings->IsAPIKeyConfigured())
+		if (!Settings->IsAPIKeyConfigured() && Settings->IsGeminiBackendUsed())
 		{
 			// Show API key configuration dialog first
 			// After API key is configured, open the chat window tab
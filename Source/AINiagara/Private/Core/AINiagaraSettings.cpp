@@ -78,3 +78,57 @@ void UAINiagaraSettings::SaveConfig()
 	Super::SaveConfig(CPF_Config, *ConfigFileName);
 }
 
+
+ELLMBackendType UAINiagaraSettings::GetBackendForTask(ELLMTask Task) const
+{
+	switch (Task)
+	{
+	case ELLMTask::Shader:
+		return ShaderBackend;
+	case ELLMTask::Texture:
+		return TextureBackend;
+	// Corrections only have their own model tier, not their own backend
+	case ELLMTask::Correction:
+	case ELLMTask::Chat:
+	default:
+		return ChatBackend;
+	}
+}
+
+ELLMModelTier UAINiagaraSettings::GetModelTierForTask(ELLMTask Task) const
+{
+	switch (Task)
+	{
+	case ELLMTask::Shader:
+		return ShaderModelTier;
+	case ELLMTask::Correction:
+		return CorrectionModelTier;
+	case ELLMTask::Texture:
+		return ELLMModelTier::Large;
+	case ELLMTask::Chat:
+	default:
+		return ChatModelTier;
+	}
+}
+
+FString UAINiagaraSettings::GetChatModelForTask(ELLMTask Task) const
+{
+	const ELLMModelTier Tier = GetModelTierForTask(Task);
+	if (GetBackendForTask(Task) == ELLMBackendType::OpenAICompatible)
+	{
+		return Tier == ELLMModelTier::Fast ? LocalFastChatModel : LocalChatModel;
+	}
+	return GetGeminiModel(Tier);
+}
+
+FString UAINiagaraSettings::GetGeminiModel(ELLMModelTier Tier) const
+{
+	return Tier == ELLMModelTier::Fast ? GeminiFastModel : GeminiLargeModel;
+}
+
+bool UAINiagaraSettings::IsGeminiBackendUsed() const
+{
+	return ChatBackend == ELLMBackendType::Gemini
+		|| ShaderBackend == ELLMBackendType::Gemini
+		|| TextureBackend == ELLMBackendType::Gemini;
+}
@@ -0,0 +1,333 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/ConversationContextBuilder.h"
+#include "Core/AINiagaraSettings.h"
+#include "Core/VFXResponseDispatcher.h"
+#include "Core/VFXDSLParser.h"
+
+namespace
+{
+	/** Characters per estimated token; close enough for English prose and JSON */
+	constexpr int32 CharsPerToken = 4;
+
+	/** Tokens added by the role and framing of each history entry */
+	constexpr int32 MessageOverheadTokens = 4;
+
+	/** Characters of a plain message quoted in the summary */
+	constexpr int32 MaxQuotedChars = 200;
+
+	/** Tokens kept free for the line counting omitted messages */
+	constexpr int32 OmittedLineTokens = 12;
+
+	const TCHAR* SummaryHeader = TEXT("Summary of the earlier conversation (older messages condensed to save context):");
+
+	FString DescribeRole(const FString& Role)
+	{
+		if (Role == TEXT("user"))
+		{
+			return TEXT("User");
+		}
+		if (Role == TEXT("assistant") || Role == TEXT("model"))
+		{
+			return TEXT("Assistant");
+		}
+		return Role;
+	}
+
+	/** First line of Text, collapsed to MaxQuotedChars */
+	FString Quote(const FString& Text)
+	{
+		FString Line = Text.TrimStartAndEnd();
+		int32 NewLine = INDEX_NONE;
+		if (Line.FindChar(TEXT('\n'), NewLine))
+		{
+			Line.LeftInline(NewLine);
+			Line.TrimEndInline();
+			Line += TEXT(" ...");
+		}
+		if (Line.Len() > MaxQuotedChars)
+		{
+			Line.LeftInline(MaxQuotedChars);
+			Line += TEXT("...");
+		}
+		return Line;
+	}
+}
+
+FConversationContextOptions FConversationContextOptions::FromSettings()
+{
+	FConversationContextOptions Options;
+	if (UAINiagaraSettings* Settings = UAINiagaraSettings::Get())
+	{
+		Options.TokenBudget = Settings->GetContextTokenBudget();
+		Options.MinRecentMessages = Settings->GetContextRecentMessages();
+		Options.MaxSummaryTokens = Settings->GetContextSummaryTokens();
+	}
+	return Options;
+}
+
+FConversationContextBuilder& FConversationContextBuilder::Get()
+{
+	static FConversationContextBuilder Instance;
+	return Instance;
+}
+
+int32 FConversationContextBuilder::EstimateTokens(const FString& Text)
+{
+	return (Text.Len() + CharsPerToken - 1) / CharsPerToken;
+}
+
+int32 FConversationContextBuilder::EstimateTokens(const FConversationMessage& Message)
+{
+	return EstimateTokens(Message.Content) + MessageOverheadTokens;
+}
+
+void FConversationContextBuilder::Build(
+	const FString& AssetPath,
+	const TArray<FConversationMessage>& History,
+	const FConversationContextOptions& Options,
+	TArray<FConversationMessage>& OutContext,
+	FConversationContextStats& OutStats)
+{
+	OutContext.Reset();
+	OutStats = FConversationContextStats();
+	OutStats.NumMessages = History.Num();
+
+	FAssetState& State = AssetStates.FindOrAdd(AssetPath);
+	ValidateState(State, History);
+	ProcessNewMessages(State, History);
+
+	for (int32 Tokens : State.Tokens)
+	{
+		OutStats.FullTokens += Tokens;
+	}
+
+	if (OutStats.FullTokens <= Options.TokenBudget)
+	{
+		OutContext = History;
+		OutStats.NumKeptMessages = History.Num();
+		OutStats.ContextTokens = OutStats.FullTokens;
+		return;
+	}
+
+	// System instructions, and the latest valid DSL with the patches on top of it, which describe the effect being edited
+	TArray<int32> Pinned = State.SystemIndices;
+	if (State.LatestDSLIndex != INDEX_NONE)
+	{
+		Pinned.Add(State.LatestDSLIndex);
+		Pinned.Append(State.PatchIndices);
+	}
+	Pinned.Sort();
+
+	int32 PinnedTokens = 0;
+	for (int32 Index : Pinned)
+	{
+		PinnedTokens += State.Tokens[Index];
+	}
+
+	// Grow the recent window backwards while it, the pinned replies outside it and the summary fit
+	const int32 WindowBudget = Options.TokenBudget - Options.MaxSummaryTokens;
+	int32 FirstKept = History.Num();
+	int32 WindowTokens = 0;
+	while (FirstKept > 0)
+	{
+		const int32 Index = FirstKept - 1;
+		const int32 Tokens = State.Tokens[Index];
+		const int32 PinnedOutside = PinnedTokens - (Pinned.Contains(Index) ? Tokens : 0);
+		const bool bRequired = History.Num() - Index <= Options.MinRecentMessages;
+		if (!bRequired && WindowTokens + Tokens + PinnedOutside > WindowBudget)
+		{
+			break;
+		}
+
+		WindowTokens += Tokens;
+		PinnedTokens = PinnedOutside;
+		--FirstKept;
+	}
+
+	Pinned.RemoveAll([FirstKept](int32 Index) { return Index >= FirstKept; });
+
+	// System instructions stay in front of the summary
+	for (int32 Index : Pinned)
+	{
+		if (History[Index].Role == TEXT("system"))
+		{
+			OutContext.Add(History[Index]);
+		}
+	}
+
+	if (FirstKept > 0)
+	{
+		// Newest summary lines first, so the oldest are the ones dropped when the summary is over its limit
+		TArray<const FString*> Lines;
+		int32 SummaryTokens = EstimateTokens(SummaryHeader) + MessageOverheadTokens + OmittedLineTokens;
+		int32 NumOmitted = 0;
+		for (int32 Index = FirstKept - 1; Index >= 0; --Index)
+		{
+			if (Pinned.Contains(Index))
+			{
+				continue;
+			}
+
+			const FString& Line = State.SummaryLines[Index];
+			const int32 LineTokens = EstimateTokens(Line) + 1;
+			if (NumOmitted > 0 || SummaryTokens + LineTokens > Options.MaxSummaryTokens)
+			{
+				++NumOmitted;
+				continue;
+			}
+			SummaryTokens += LineTokens;
+			Lines.Add(&Line);
+		}
+
+		FString Summary(SummaryHeader);
+		if (NumOmitted > 0)
+		{
+			Summary += FString::Printf(TEXT("\n- (%d earlier messages omitted)"), NumOmitted);
+		}
+		for (int32 LineIndex = Lines.Num() - 1; LineIndex >= 0; --LineIndex)
+		{
+			Summary += TEXT("\n");
+			Summary += *Lines[LineIndex];
+		}
+
+		OutContext.Add(FConversationMessage(TEXT("user"), Summary));
+		OutStats.NumSummarizedMessages = FirstKept - Pinned.Num();
+		OutStats.ContextTokens += EstimateTokens(OutContext.Last());
+	}
+
+	for (int32 Index : Pinned)
+	{
+		if (History[Index].Role != TEXT("system"))
+		{
+			OutContext.Add(History[Index]);
+		}
+		OutStats.ContextTokens += State.Tokens[Index];
+	}
+	OutStats.NumPinnedMessages = Pinned.Num();
+
+	for (int32 Index = FirstKept; Index < History.Num(); ++Index)
+	{
+		OutContext.Add(History[Index]);
+	}
+	OutStats.ContextTokens += WindowTokens;
+	OutStats.NumKeptMessages = Pinned.Num() + History.Num() - FirstKept;
+
+	UE_LOG(LogTemp, Log, TEXT("AINiagara: Context for %s: %d of %d messages verbatim (%d pinned), %d summarized, ~%d of ~%d tokens (saved ~%d)"),
+		*AssetPath, OutStats.NumKeptMessages, OutStats.NumMessages, OutStats.NumPinnedMessages, OutStats.NumSummarizedMessages,
+		OutStats.ContextTokens, OutStats.FullTokens, OutStats.GetTokensSaved());
+}
+
+void FConversationContextBuilder::Invalidate(const FString& AssetPath)
+{
+	AssetStates.Remove(AssetPath);
+}
+
+void FConversationContextBuilder::Reset()
+{
+	AssetStates.Reset();
+	NumClassifiedMessages = 0;
+}
+
+void FConversationContextBuilder::ValidateState(FAssetState& State, const TArray<FConversationMessage>& History)
+{
+	const int32 NumProcessed = State.SummaryLines.Num();
+	if (NumProcessed == 0)
+	{
+		return;
+	}
+
+	const FConversationMessage* Last = History.IsValidIndex(NumProcessed - 1) ? &History[NumProcessed - 1] : nullptr;
+	const bool bContinues = Last
+		&& History[0].Timestamp == State.FirstTimestamp
+		&& Last->Timestamp == State.LastTimestamp
+		&& Last->Content.Len() == State.LastLength;
+
+	if (!bContinues)
+	{
+		State = FAssetState();
+	}
+}
+
+void FConversationContextBuilder::ProcessNewMessages(FAssetState& State, const TArray<FConversationMessage>& History)
+{
+	const int32 NumProcessed = State.SummaryLines.Num();
+	if (NumProcessed == History.Num())
+	{
+		return;
+	}
+
+	State.SummaryLines.Reserve(History.Num());
+	State.Tokens.Reserve(History.Num());
+
+	for (int32 Index = NumProcessed; Index < History.Num(); ++Index)
+	{
+		const FConversationMessage& Message = History[Index];
+		bool bIsDSL = false;
+		bool bIsPatch = false;
+		State.SummaryLines.Add(SummarizeMessage(Message, bIsDSL, bIsPatch));
+		State.Tokens.Add(EstimateTokens(Message));
+
+		if (Message.Role == TEXT("system"))
+		{
+			State.SystemIndices.Add(Index);
+		}
+		else if (bIsDSL)
+		{
+			State.LatestDSLIndex = Index;
+			State.PatchIndices.Reset();
+		}
+		else if (bIsPatch && State.LatestDSLIndex != INDEX_NONE)
+		{
+			State.PatchIndices.Add(Index);
+		}
+	}
+
+	NumClassifiedMessages += History.Num() - NumProcessed;
+	State.FirstTimestamp = History[0].Timestamp;
+	State.LastTimestamp = History.Last().Timestamp;
+	State.LastLength = History.Last().Content.Len();
+}
+
+FString FConversationContextBuilder::SummarizeMessage(const FConversationMessage& Message, bool& bOutIsDSL, bool& bOutIsPatch)
+{
+	bOutIsDSL = false;
+	bOutIsPatch = false;
+
+	const FString Speaker = DescribeRole(Message.Role);
+	if (Speaker != TEXT("Assistant"))
+	{
+		return FString::Printf(TEXT("- %s: %s"), *Speaker, *Quote(Message.Content));
+	}
+
+	FVFXClassifiedResponse Classified;
+	FVFXResponseDispatcher::Classify(Message.Content, Classified);
+
+	switch (Classified.Kind)
+	{
+	case EVFXResponseKind::DSL:
+	{
+		FVFXDSLValidationResult Validation;
+		UVFXDSLValidator::ValidateInto(Classified.DSL, Validation);
+		bOutIsDSL = Validation.bIsValid;
+
+		TArray<FString> Names;
+		for (const FVFXDSLEmitter& Emitter : Classified.DSL.Emitters)
+		{
+			Names.Add(Emitter.Name);
+		}
+		return FString::Printf(TEXT("- Assistant: generated %s effect DSL with %d emitters (%s)"),
+			bOutIsDSL ? TEXT("an") : TEXT("an invalid"), Names.Num(), *FString::Join(Names, TEXT(", ")));
+	}
+
+	case EVFXResponseKind::Patch:
+		bOutIsPatch = true;
+		return TEXT("- Assistant: patched the effect DSL");
+
+	case EVFXResponseKind::ToolCall:
+		return FString::Printf(TEXT("- Assistant: called %s"), *Classified.ToolName);
+
+	default:
+		return FString::Printf(TEXT("- Assistant: %s"), *Quote(Message.Content));
+	}
+}
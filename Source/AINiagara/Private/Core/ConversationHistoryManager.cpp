@@ -44,6 +44,11 @@ TArray<FConversationMessage> UConversationHistoryManager::GetHistory(const FStri
 	return TArray<FConversationMessage>();
 }
 
+const TArray<FConversationMessage>* UConversationHistoryManager::FindHistory(const FString& AssetPath) const
+{
+	return ConversationHistories.Find(AssetPath);
+}
+
 void UConversationHistoryManager::AddMessage(const FString& AssetPath, const FString& Role, const FString& Content)
 {
 	TArray<FConversationMessage>& History = ConversationHistories.FindOrAdd(AssetPath);
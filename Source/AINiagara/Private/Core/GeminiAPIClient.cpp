@@ -2,12 +2,17 @@
 
 #include "Core/GeminiAPIClient.h"
 #include "Core/AINiagaraSettings.h"
+#include "Core/GeminiPayloadBuilder.h"
+#include "Core/GeminiContextCache.h"
+#include "Core/GeminiResponseCache.h"
+#include "Core/GeminiSSEParser.h"
 #include "HttpModule.h"
 #include "Interfaces/IHttpRequest.h"
 #include "Interfaces/IHttpResponse.h"
 #include "Dom/JsonObject.h"
 #include "Serialization/JsonSerializer.h"
 #include "Serialization/JsonWriter.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
 #include "Misc/DateTime.h"
 #include "HAL/PlatformProcess.h"
 #include "Misc/App.h"
@@ -15,23 +20,978 @@
 #include "HAL/PlatformFilemanager.h"
 #include "Async/Async.h"
 #include "HAL/PlatformTLS.h"
+#include "HAL/PlatformTime.h"
+#include "Containers/Ticker.h"
+#include "Async/ParallelFor.h"
+#include "Misc/ScopeLock.h"
+#include "Tasks/Task.h"
 
 const FString FGeminiAPIClient::BaseURL = TEXT("https://generativelanguage.googleapis.com/v1beta");
-const FString FGeminiAPIClient::ChatCompletionEndpoint = TEXT("/models/gemini-pro:generateContent");
-const FString FGeminiAPIClient::ImageGenerationEndpoint = TEXT("/models/imagen-3-generate-001:generateContent");
-const int32 FGeminiAPIClient::MaxRetries = 3;
-const float FGeminiAPIClient::InitialRetryDelay = 1.0f;
+const FString FGeminiAPIClient::DefaultChatModel = TEXT("gemini-pro");
+const FString FGeminiAPIClient::ImageModel = TEXT("imagen-3-generate-001");
+
+namespace
+{
+	/**
+	 * State shared by the callbacks of one streamed request. The callbacks hold it
+	 * by reference count, so it outlives the client that sent the request.
+	 */
+	struct FGeminiStreamState
+	{
+		FGeminiSSEParser Parser;
+
+		/** Scratch list of completed events */
+		TArray<FString> Events;
+
+		/** Response body bytes already handed to the parser */
+		int64 ConsumedBytes = 0;
+
+		double StartSeconds = 0.0;
+		FGeminiStreamStats Stats;
+
+		/** Text of all chunks so far */
+		FString ResponseText;
+
+		FString FinishReason;
+		FOnGeminiStreamChunk OnChunk;
+
+		/** Latest event carrying usageMetadata or promptFeedback; counts are cumulative, so it is parsed once at the end */
+		FString LastMetadataEvent;
+	};
+
+	/**
+	 * Parse the body bytes received since the last call and report the new text chunks
+	 * @param bEndOfStream Whether Content is the complete body
+	 */
+	void ConsumeStreamBody(FGeminiStreamState& State, const TArray<uint8>& Content, bool bEndOfStream)
+	{
+		if (Content.Num() > State.ConsumedBytes)
+		{
+			State.Parser.AppendBytes(MakeArrayView(Content.GetData() + State.ConsumedBytes, Content.Num() - State.ConsumedBytes), State.Events);
+			State.ConsumedBytes = Content.Num();
+		}
+		if (bEndOfStream)
+		{
+			State.Parser.Flush(State.Events);
+		}
+
+		for (const FString& EventData : State.Events)
+		{
+			FString ChunkText;
+			FString FinishReason;
+			if (!FGeminiSSEParser::ParseEvent(EventData, ChunkText, FinishReason))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("AINiagara: Ignoring malformed stream event: %s"), *EventData.Left(200));
+				continue;
+			}
+
+			if (EventData.Contains(TEXT("usageMetadata")) || EventData.Contains(TEXT("promptFeedback")))
+			{
+				State.LastMetadataEvent = EventData;
+			}
+
+			if (!FinishReason.IsEmpty())
+			{
+				State.FinishReason = FinishReason;
+			}
+			if (ChunkText.IsEmpty())
+			{
+				continue;
+			}
+
+			const double Elapsed = FPlatformTime::Seconds() - State.StartSeconds;
+			if (State.Stats.NumChunks == 0)
+			{
+				State.Stats.FirstChunkSeconds = Elapsed;
+			}
+			++State.Stats.NumChunks;
+			State.Stats.ReceivedBytes = State.ConsumedBytes;
+			State.Stats.ElapsedSeconds = Elapsed;
+
+			State.ResponseText += ChunkText;
+			State.OnChunk.ExecuteIfBound(ChunkText, State.Stats);
+		}
+		State.Events.Reset();
+	}
+
+	/**
+	 * Delay requested by a throttled reply: the Retry-After header, or the
+	 * RetryInfo detail Gemini puts in the error body ("retryDelay": "17s")
+	 */
+	double GetRetryAfterSeconds(const FHttpResponsePtr& Response)
+	{
+		const double HeaderDelay = FGeminiRequestScheduler::ParseRetryAfter(Response->GetHeader(TEXT("Retry-After")));
+		if (HeaderDelay > 0.0)
+		{
+			return HeaderDelay;
+		}
+
+		TSharedPtr<FJsonObject> JsonObject;
+		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Response->GetContentAsString());
+		const TSharedPtr<FJsonObject>* ErrorObject;
+		const TArray<TSharedPtr<FJsonValue>>* Details;
+		if (FJsonSerializer::Deserialize(Reader, JsonObject) && JsonObject.IsValid() &&
+			JsonObject->TryGetObjectField(TEXT("error"), ErrorObject) &&
+			(*ErrorObject)->TryGetArrayField(TEXT("details"), Details))
+		{
+			for (const TSharedPtr<FJsonValue>& Detail : *Details)
+			{
+				FString RetryDelay;
+				const TSharedPtr<FJsonObject> DetailObject = Detail->AsObject();
+				if (DetailObject.IsValid() && DetailObject->TryGetStringField(TEXT("retryDelay"), RetryDelay))
+				{
+					RetryDelay.RemoveFromEnd(TEXT("s"));
+					return FMath::Max(0.0, FCString::Atod(*RetryDelay));
+				}
+			}
+		}
+
+		return 0.0;
+	}
+
+	/** Release the scheduler slot of a finished request, on the game thread */
+	void NotifyRequestFinished(EGeminiEndpoint Endpoint, const FHttpResponsePtr& Response)
+	{
+		const int32 ResponseCode = Response.IsValid() ? Response->GetResponseCode() : 0;
+		const double RetryAfterSeconds = (ResponseCode == 429 || ResponseCode == 503) ? GetRetryAfterSeconds(Response) : 0.0;
+
+		if (IsInGameThread())
+		{
+			FGeminiRequestScheduler::Get().OnRequestFinished(Endpoint, ResponseCode, RetryAfterSeconds);
+		}
+		else
+		{
+			AsyncTask(ENamedThreads::GameThread, [Endpoint, ResponseCode, RetryAfterSeconds]()
+			{
+				FGeminiRequestScheduler::Get().OnRequestFinished(Endpoint, ResponseCode, RetryAfterSeconds);
+			});
+		}
+	}
+
+	/**
+	 * One logical request and its attempts. Held by the callbacks of the attempt in
+	 * flight and by the retry ticker, never by the client.
+	 */
+	struct FGeminiRetryState
+	{
+		EGeminiEndpoint Endpoint = EGeminiEndpoint::Chat;
+		FString URL;
+		FString Payload;
+		FGeminiRequestOptions Options;
+
+		/** Cancelling it stops the attempt in flight and any further attempts */
+		FGeminiRequestHandle Handle;
+
+		/** Cached content Payload refers to, and the inline payload sent if the provider rejects it */
+		FString CachedContent;
+		FString InlinePayload;
+
+		/** Attempts sent so far */
+		int32 NumAttempts = 0;
+
+		/** Time spent waiting between attempts */
+		double TotalDelaySeconds = 0.0;
+
+		FRandomStream Random;
+
+		/** Timings and sizes, completed when the final attempt finishes */
+		FGeminiRequestMetrics Metrics;
+
+		/** When the request was made, when the current attempt was queued and sent, and when its first byte arrived (negative until then) */
+		double CreatedSeconds = 0.0;
+		double EnqueuedSeconds = 0.0;
+		double SentSeconds = 0.0;
+		double FirstByteSeconds = -1.0;
+
+		/** Called on the game thread right before each attempt is sent, to add headers */
+		TFunction<void(const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>&)> PrepareAttempt;
+
+		/** Called with each progress update of the attempt in flight */
+		TFunction<void(FHttpRequestPtr)> OnProgress;
+
+		/** Whether repeating the request is still safe; a stream is not once text has been shown */
+		TFunction<bool()> CanRetry;
+
+		/** Called once with the outcome of the final attempt */
+		TFunction<void(FHttpRequestPtr, FHttpResponsePtr, bool, const FGeminiRequestMetrics&)> OnComplete;
+	};
+
+	/** Complete the timings and sizes of a request whose final attempt finished */
+	void FinishMetrics(FGeminiRetryState& State, const FHttpRequestPtr& Request, const FHttpResponsePtr& Response)
+	{
+		const double Now = FPlatformTime::Seconds();
+		FGeminiRequestMetrics& Metrics = State.Metrics;
+		Metrics.ResponseCode = Response.IsValid() ? Response->GetResponseCode() : 0;
+		Metrics.NumAttempts = State.NumAttempts;
+		Metrics.bCachedContext = !State.CachedContent.IsEmpty();
+
+		// Without a progress callback the whole body arrived at once
+		Metrics.TimeToFirstByteSeconds = (State.FirstByteSeconds >= 0.0 ? State.FirstByteSeconds : Now) - State.SentSeconds;
+		Metrics.TotalSeconds = Now - State.CreatedSeconds;
+
+		Metrics.RequestBytes = Request.IsValid() ? Request->GetContent().Num() : 0;
+		Metrics.ResponseBytes = Response.IsValid() ? Response->GetContent().Num() : 0;
+	}
+
+	/**
+	 * Decide whether a finished attempt is retried, and take the retry from the budget
+	 * @return Seconds to wait before the next attempt, or a negative value to report the outcome
+	 */
+	double GetNextAttemptDelay(FGeminiRetryState& State, const FHttpResponsePtr& Response, bool bWasSuccessful)
+	{
+		const bool bReceivedResponse = bWasSuccessful && Response.IsValid();
+		const int32 ResponseCode = bReceivedResponse ? Response->GetResponseCode() : 0;
+		const FGeminiRetryPolicy& Policy = State.Options.RetryPolicy;
+
+		if (State.NumAttempts >= Policy.MaxAttempts
+			|| !FGeminiRetryPolicy::IsRetryable(ResponseCode, bReceivedResponse)
+			|| (State.CanRetry && !State.CanRetry()))
+		{
+			return -1.0;
+		}
+
+		const double RetryAfterSeconds = bReceivedResponse ? GetRetryAfterSeconds(Response) : 0.0;
+		const double Delay = Policy.GetDelay(State.NumAttempts - 1, RetryAfterSeconds, State.Random);
+		if (Delay < 0.0 || State.TotalDelaySeconds + Delay > Policy.MaxTotalDelaySeconds)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("AINiagara: Not retrying request (%d): server asked to wait %.1f s"), ResponseCode, RetryAfterSeconds);
+			return -1.0;
+		}
+
+		if (!FGeminiRetryBudget::Get().TryWithdraw())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("AINiagara: Not retrying request (%d): retry budget exhausted"), ResponseCode);
+			return -1.0;
+		}
+
+		State.TotalDelaySeconds += Delay;
+		return Delay;
+	}
+
+	void SendAttempt(const TSharedRef<FGeminiRetryState, ESPMode::ThreadSafe>& State);
+
+	/**
+	 * Send a request again with its inline payload if the provider rejected the cached content it referred to
+	 * @return True if the request was sent again
+	 */
+	bool TryResendInline(const TSharedRef<FGeminiRetryState, ESPMode::ThreadSafe>& State, const FHttpResponsePtr& Response)
+	{
+		if (State->CachedContent.IsEmpty() || !Response.IsValid()
+			|| !FGeminiContextCache::IsCachedContentError(Response->GetResponseCode(), Response->GetContentAsString()))
+		{
+			return false;
+		}
+
+		FGeminiContextCache::Get().Invalidate(State->CachedContent);
+		State->CachedContent.Reset();
+		State->Payload = MoveTemp(State->InlinePayload);
+		State->InlinePayload.Reset();
+
+		UE_LOG(LogTemp, Log, TEXT("AINiagara: Cached context rejected (%d), sending the request inline"), Response->GetResponseCode());
+		
+		// The scheduler lives on the game thread
+		if (IsInGameThread())
+		{
+			SendAttempt(State);
+		}
+		else
+		{
+			AsyncTask(ENamedThreads::GameThread, [State]()
+			{
+				SendAttempt(State);
+			});
+		}
+		return true;
+	}
+
+	/**
+	 * Queue the next attempt of a request. Transient failures are sent again after the
+	 * policy's delay; everything else, and the last allowed attempt, goes to OnComplete.
+	 */
+	void SendAttempt(const TSharedRef<FGeminiRetryState, ESPMode::ThreadSafe>& State)
+	{
+		if (State->NumAttempts == 0)
+		{
+			FGeminiRetryBudget::Get().OnRequest();
+		}
+		++State->NumAttempts;
+
+		TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+		Request->SetURL(State->URL);
+		Request->SetVerb(TEXT("POST"));
+		Request->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
+		Request->SetContentAsString(State->Payload);
+
+		Request->OnProcessRequestComplete().BindLambda(
+			[State](FHttpRequestPtr HttpRequest, FHttpResponsePtr HttpResponse, bool bWasSuccessful)
+			{
+				NotifyRequestFinished(State->Endpoint, HttpResponse);
+
+				// Nothing left to abort; also drops the handle's reference to this request
+				State->Handle.SetHttpRequest(nullptr);
+
+				// An aborted attempt is neither retried nor reported
+				if (State->Handle.IsCancelled())
+				{
+					UE_LOG(LogTemp, Log, TEXT("AINiagara: Dropping cancelled request"));
+					return;
+				}
+
+				const double Delay = GetNextAttemptDelay(*State, HttpResponse, bWasSuccessful);
+				if (Delay < 0.0)
+				{
+					if (TryResendInline(State, HttpResponse))
+					{
+						return;
+					}
+					FinishMetrics(*State, HttpRequest, HttpResponse);
+					State->OnComplete(HttpRequest, HttpResponse, bWasSuccessful, State->Metrics);
+					return;
+				}
+
+				UE_LOG(LogTemp, Warning, TEXT("AINiagara: Request failed (%d), retrying in %.2f s (attempt %d of %d)"),
+					HttpResponse.IsValid() ? HttpResponse->GetResponseCode() : 0, Delay, State->NumAttempts + 1, State->Options.RetryPolicy.MaxAttempts);
+
+				// The core ticker runs on the game thread, where the scheduler lives
+				FTSTicker::GetCoreTicker().AddTicker(
+					FTickerDelegate::CreateLambda([State](float DeltaTime) -> bool
+					{
+						if (!State->Handle.IsCancelled())
+						{
+							SendAttempt(State);
+						}
+						return false; // Don't repeat
+					}),
+					static_cast<float>(Delay)
+				);
+			}
+		);
+
+		// The first received byte ends the time to first byte; streams also consume the body here
+		auto OnProgress = [State](FHttpRequestPtr HttpRequest, uint64 BytesReceived)
+		{
+			if (BytesReceived > 0 && State->FirstByteSeconds < 0.0)
+			{
+				State->FirstByteSeconds = FPlatformTime::Seconds();
+			}
+			if (State->OnProgress)
+			{
+				State->OnProgress(HttpRequest);
+			}
+		};
+
+#if ((ENGINE_MAJOR_VERSION == 5) && (ENGINE_MINOR_VERSION >= 4))
+		Request->OnRequestProgress64().BindLambda([OnProgress](FHttpRequestPtr HttpRequest, uint64 BytesSent, uint64 BytesReceived)
+		{
+			OnProgress(HttpRequest, BytesReceived);
+		});
+#else
+		Request->OnRequestProgress().BindLambda([OnProgress](FHttpRequestPtr HttpRequest, int32 BytesSent, int32 BytesReceived)
+		{
+			OnProgress(HttpRequest, static_cast<uint64>(FMath::Max(0, BytesReceived)));
+		});
+#endif
+
+		// Send once the scheduler has a slot for it; retries queue again at the same priority
+		State->EnqueuedSeconds = FPlatformTime::Seconds();
+		FGeminiRequestScheduler::Get().Enqueue(State->Endpoint, State->Options.Priority, [State, Request]()
+		{
+			// Cancelled after the scheduler's last queue check, e.g. by a request started just before it in the same pump
+			if (State->Handle.IsCancelled())
+			{
+				FGeminiRequestScheduler::Get().OnRequestFinished(State->Endpoint, 0);
+				return;
+			}
+
+			if (State->PrepareAttempt)
+			{
+				State->PrepareAttempt(Request);
+			}
+			State->SentSeconds = FPlatformTime::Seconds();
+			State->FirstByteSeconds = -1.0;
+			State->Metrics.QueueSeconds += State->SentSeconds - State->EnqueuedSeconds;
+			State->Handle.SetHttpRequest(Request);
+			Request->ProcessRequest();
+		},
+		[Handle = State->Handle]()
+		{
+			return Handle.IsCancelled();
+		});
+	}
+
+	/**
+	 * Answer a request from the response cache if its mode allows it
+	 * @param OnHit Called on the game thread with the cached body
+	 * @return True if the request was answered, or refused in replay-only mode, and must not be sent
+	 * @note Only the in-memory index is checked here; the entry is read from disk on a worker task
+	 */
+	bool TryAnswerFromCache(const FString& CacheKey, const FString& Endpoint, const FString& Model, const FGeminiRequestOptions& Options, const FGeminiRequestHandle& Handle, TFunction<void(const FString&)> OnHit, FOnGeminiError OnError)
+	{
+		FGeminiResponseCache& Cache = FGeminiResponseCache::Get();
+		const EGeminiResponseCacheMode Mode = Cache.GetMode();
+		if (Mode == EGeminiResponseCacheMode::Disabled)
+		{
+			return false;
+		}
+
+		// Callers expect the reply after the call returns, as with a network reply
+		if ((Options.bReadCache || Mode == EGeminiResponseCacheMode::ReplayOnly) && Cache.Contains(CacheKey))
+		{
+			UE_LOG(LogTemp, Log, TEXT("AINiagara: Answering request from the response cache (%s)"), *CacheKey);
+
+			UE::Tasks::Launch(UE_SOURCE_LOCATION, [CacheKey, Endpoint, Model, Handle, OnHit = MoveTemp(OnHit), OnError]() mutable
+			{
+				FString Body;
+				if (!FGeminiResponseCache::Get().Find(CacheKey, Body))
+				{
+					// Evicted or deleted since the index was checked; the request was already taken off the network path
+					AsyncTask(ENamedThreads::GameThread, [OnError, CacheKey]()
+					{
+						OnError.ExecuteIfBound(404, FString::Printf(TEXT("Cached response could not be read (%s)"), *CacheKey));
+					});
+					return;
+				}
+
+				// Nothing was sent and no quota was spent, so only the reply size is recorded
+				FGeminiRequestMetrics Metrics;
+				Metrics.Endpoint = Endpoint;
+				Metrics.Model = Model;
+				Metrics.Timestamp = FDateTime::UtcNow();
+				Metrics.ResponseCode = EHttpResponseCodes::Ok;
+				Metrics.bFromCache = true;
+				Metrics.ResponseBytes = FTCHARToUTF8(*Body).Length();
+				FGeminiMetricsRegistry::Get().Record(Metrics);
+
+				AsyncTask(ENamedThreads::GameThread, [Handle, OnHit = MoveTemp(OnHit), Body = MoveTemp(Body)]()
+				{
+					if (!Handle.IsCancelled())
+					{
+						OnHit(Body);
+					}
+				});
+			});
+			return true;
+		}
+
+		if (Mode == EGeminiResponseCacheMode::ReplayOnly)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("AINiagara: Replay-only mode has no cached response for %s"), *CacheKey);
+			AsyncTask(ENamedThreads::GameThread, [OnError, CacheKey]()
+			{
+				OnError.ExecuteIfBound(404, FString::Printf(TEXT("Replay-only mode: no cached response for this request (%s)"), *CacheKey));
+			});
+			return true;
+		}
+
+		return false;
+	}
+
+	/** Store a successful reply if the cache is recording */
+	void StoreInCache(const FString& CacheKey, const FString& Body)
+	{
+		FGeminiResponseCache& Cache = FGeminiResponseCache::Get();
+		if (!CacheKey.IsEmpty() && Cache.GetMode() == EGeminiResponseCacheMode::ReadWrite)
+		{
+			Cache.Store(CacheKey, Body);
+		}
+	}
+
+	/** New request state with a per-request jitter seed */
+	TSharedRef<FGeminiRetryState, ESPMode::ThreadSafe> MakeRetryState(EGeminiEndpoint Endpoint, const FString& EndpointPath, const FString& Model, const FString& URL, const FString& Payload, const FGeminiRequestOptions& Options, const FGeminiRequestHandle& Handle)
+	{
+		TSharedRef<FGeminiRetryState, ESPMode::ThreadSafe> State = MakeShared<FGeminiRetryState, ESPMode::ThreadSafe>();
+		State->Endpoint = Endpoint;
+		State->Metrics.Endpoint = EndpointPath;
+		State->Metrics.Model = Model;
+		State->CreatedSeconds = FPlatformTime::Seconds();
+		State->URL = URL;
+		State->Payload = Payload;
+		State->Options = Options;
+		State->Handle = Handle;
+		State->Random.Initialize(static_cast<int32>(FPlatformTime::Cycles()));
+		return State;
+	}
+
+	/** New request state sending the same payload as Template, for a duplicate of a hedged request; callbacks are not copied */
+	TSharedRef<FGeminiRetryState, ESPMode::ThreadSafe> CloneRetryState(const FGeminiRetryState& Template, const FGeminiRequestHandle& Handle)
+	{
+		TSharedRef<FGeminiRetryState, ESPMode::ThreadSafe> State = MakeRetryState(Template.Endpoint, Template.Metrics.Endpoint, Template.Metrics.Model, Template.URL, Template.Payload, Template.Options, Handle);
+		State->CachedContent = Template.CachedContent;
+		State->InlinePayload = Template.InlinePayload;
+		return State;
+	}
+
+	/**
+	 * Make a request refer to cached content instead of carrying the system prompt and tools
+	 * @param CachedContent Name from FGeminiContextCache::Acquire; nothing changes if it is empty
+	 */
+	void ReferToCachedContent(FGeminiRetryState& State, const FString& CachedContent, const FString& Prompt, const TArray<FConversationMessage>& ConversationHistory)
+	{
+		if (CachedContent.IsEmpty())
+		{
+			return;
+		}
+
+		State.CachedContent = CachedContent;
+		State.InlinePayload = MoveTemp(State.Payload);
+		FGeminiPayloadBuilder::Get().BuildChatCompletionWithCachedContent(CachedContent, Prompt, ConversationHistory, State.Payload);
+		FGeminiPayloadBuilder::AppendCandidateCount(State.Options.CandidateCount, State.Payload);
+	}
+
+	/**
+	 * Wrap the delegates of a request so its outcome is delivered at most once,
+	 * and not at all once the request has been cancelled
+	 */
+	void GuardDelegates(const FGeminiRequestHandle& Handle, FOnGeminiResponse& OnResponse, FOnGeminiError& OnError)
+	{
+		OnResponse = FOnGeminiResponse::CreateLambda([Handle, Inner = OnResponse](const FString& ResponseText) mutable
+		{
+			if (Handle.TryFinish())
+			{
+				Inner.ExecuteIfBound(ResponseText);
+			}
+		});
+		OnError = FOnGeminiError::CreateLambda([Handle, Inner = OnError](int32 ErrorCode, const FString& ErrorMessage) mutable
+		{
+			if (Handle.TryFinish())
+			{
+				Inner.ExecuteIfBound(ErrorCode, ErrorMessage);
+			}
+		});
+	}
+
+	/**
+	 * Copies of one request sent because it was slow (see FGeminiHedgePolicy). The
+	 * first copy to produce a reply wins and the others are cancelled; an error is
+	 * only reported by the winner, or by the last copy once every copy has failed.
+	 */
+	struct FGeminiHedgeState
+	{
+		FCriticalSection Mutex;
+
+		/** Handle of each copy, the original first */
+		TArray<FGeminiRequestHandle> Legs;
+
+		/** Copy whose outcome is delivered, INDEX_NONE until one is known */
+		int32 Winner = INDEX_NONE;
+
+		int32 NumFailed = 0;
+
+		/**
+		 * Add a copy unless the outcome is known or a copy has already failed
+		 * @return Index of the copy, or INDEX_NONE if it should not be sent
+		 */
+		int32 TryAddLeg(const FGeminiRequestHandle& Leg)
+		{
+			FScopeLock Lock(&Mutex);
+			if (Legs.Num() > 0 && (Winner != INDEX_NONE || NumFailed > 0))
+			{
+				return INDEX_NONE;
+			}
+			return Legs.Add(Leg);
+		}
+
+		/**
+		 * Make a copy the winner and cancel the others
+		 * @return False if another copy already won
+		 */
+		bool Claim(int32 LegIndex)
+		{
+			TArray<FGeminiRequestHandle> Losers;
+			{
+				FScopeLock Lock(&Mutex);
+				if (Winner != INDEX_NONE)
+				{
+					return Winner == LegIndex;
+				}
+				Winner = LegIndex;
+				for (int32 Index = 0; Index < Legs.Num(); ++Index)
+				{
+					if (Index != LegIndex)
+					{
+						Losers.Add(Legs[Index]);
+					}
+				}
+			}
+
+			// Outside the lock: cancelling may complete a copy synchronously
+			for (FGeminiRequestHandle& Loser : Losers)
+			{
+				Loser.Cancel();
+			}
+			if (Losers.Num() > 0)
+			{
+				FGeminiMetricsRegistry::Get().RecordHedgeWinner(LegIndex > 0);
+			}
+			return true;
+		}
+
+		/**
+		 * Record a failed copy
+		 * @return True if its error is the outcome of the request
+		 */
+		bool Fail(int32 LegIndex)
+		{
+			FScopeLock Lock(&Mutex);
+			if (Winner != INDEX_NONE)
+			{
+				return Winner == LegIndex;
+			}
+			if (++NumFailed < Legs.Num())
+			{
+				return false;
+			}
+			Winner = LegIndex;
+			return true;
+		}
+	};
+
+	/** Wrap the delegates of one copy of a request so they only fire for the copy whose outcome is delivered */
+	void HedgeDelegates(const TSharedRef<FGeminiHedgeState, ESPMode::ThreadSafe>& Hedge, int32 LegIndex, FOnGeminiResponse& OnResponse, FOnGeminiError& OnError)
+	{
+		OnResponse = FOnGeminiResponse::CreateLambda([Hedge, LegIndex, Inner = OnResponse](const FString& ResponseText)
+		{
+			if (Hedge->Claim(LegIndex))
+			{
+				Inner.ExecuteIfBound(ResponseText);
+			}
+		});
+		OnError = FOnGeminiError::CreateLambda([Hedge, LegIndex, Inner = OnError](int32 ErrorCode, const FString& ErrorMessage)
+		{
+			if (Hedge->Fail(LegIndex))
+			{
+				Inner.ExecuteIfBound(ErrorCode, ErrorMessage);
+			}
+		});
+	}
+
+	/** Sets the callbacks of one copy of a request */
+	using FSetLegCallbacks = TFunction<void(FGeminiRetryState& Leg, int32 LegIndex, const TSharedRef<FGeminiHedgeState, ESPMode::ThreadSafe>& Hedge)>;
+
+	/**
+	 * Send a request, and a duplicate of it if there is no reply after the delay of its hedge policy.
+	 * Without hedging, First is sent as it is and is the only copy.
+	 * @param First Request to send, without callbacks
+	 * @param SetLegCallbacks Called for each copy before it is sent
+	 */
+	void SendHedged(const TSharedRef<FGeminiRetryState, ESPMode::ThreadSafe>& First, FSetLegCallbacks SetLegCallbacks)
+	{
+		TSharedRef<FGeminiHedgeState, ESPMode::ThreadSafe> Hedge = MakeShared<FGeminiHedgeState, ESPMode::ThreadSafe>();
+		const double Delay = First->Options.Hedge.GetDelay(First->Metrics.Endpoint);
+		if (Delay < 0.0)
+		{
+			Hedge->TryAddLeg(First->Handle);
+			SetLegCallbacks(*First, 0, Hedge);
+			SendAttempt(First);
+			return;
+		}
+
+		// Each copy gets its own handle, so the loser is cancelled without cancelling the request
+		FGeminiRequestHandle Handle = First->Handle;
+		const TSharedRef<FGeminiRetryState, ESPMode::ThreadSafe> Template = MakeShared<FGeminiRetryState, ESPMode::ThreadSafe>(*First);
+		First->Handle = FGeminiRequestHandle::MakePending();
+		Handle.LinkRequest(First->Handle);
+		Hedge->TryAddLeg(First->Handle);
+		SetLegCallbacks(*First, 0, Hedge);
+		SendAttempt(First);
+
+		// The core ticker runs on the game thread, where the scheduler lives
+		FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateLambda([Template, Handle, Hedge, SetLegCallbacks = MoveTemp(SetLegCallbacks), Delay](float DeltaTime) mutable -> bool
+			{
+				if (!Handle.IsPending())
+				{
+					return false;
+				}
+
+				const FGeminiRequestHandle LegHandle = FGeminiRequestHandle::MakePending();
+				const int32 LegIndex = Hedge->TryAddLeg(LegHandle);
+				if (LegIndex == INDEX_NONE)
+				{
+					return false;
+				}
+
+				UE_LOG(LogTemp, Log, TEXT("AINiagara: No reply after %.2f s, sending a duplicate request"), Delay);
+				FGeminiMetricsRegistry::Get().RecordHedge();
+
+				Handle.LinkRequest(LegHandle);
+				TSharedRef<FGeminiRetryState, ESPMode::ThreadSafe> Duplicate = CloneRetryState(*Template, LegHandle);
+				SetLegCallbacks(*Duplicate, LegIndex, Hedge);
+				SendAttempt(Duplicate);
+				return false; // Don't repeat
+			}),
+			static_cast<float>(Delay)
+		);
+	}
+
+	/** Add the categories of an object's safetyRatings that were blocked */
+	void CollectBlockedCategories(const TSharedPtr<FJsonObject>& Object, TArray<FString>& OutCategories)
+	{
+		const TArray<TSharedPtr<FJsonValue>>* RatingsArray;
+		if (!Object->TryGetArrayField(TEXT("safetyRatings"), RatingsArray))
+		{
+			return;
+		}
+
+		for (const TSharedPtr<FJsonValue>& RatingValue : *RatingsArray)
+		{
+			const TSharedPtr<FJsonObject> RatingObject = RatingValue->AsObject();
+			bool bBlocked = false;
+			FString Category;
+			if (RatingObject.IsValid() && RatingObject->TryGetBoolField(TEXT("blocked"), bBlocked) && bBlocked &&
+				RatingObject->TryGetStringField(TEXT("category"), Category))
+			{
+				OutCategories.AddUnique(Category);
+			}
+		}
+	}
+
+	/**
+	 * Collect the text and functionCall parts of a candidate
+	 * @param OutTextParts Receives each text part, may be null
+	 * @return False if the candidate has no content
+	 */
+	bool ParseCandidateContent(const TSharedPtr<FJsonObject>& CandidateObject, FString& OutText, TArray<FString>* OutTextParts, TArray<FString>& OutFunctionCalls)
+	{
+		const TSharedPtr<FJsonObject>* ContentObject;
+		if (!CandidateObject->TryGetObjectField(TEXT("content"), ContentObject))
+		{
+			return false;
+		}
+
+		const TArray<TSharedPtr<FJsonValue>>* PartsArray;
+		if (!(*ContentObject)->TryGetArrayField(TEXT("parts"), PartsArray))
+		{
+			return true;
+		}
+
+		for (const TSharedPtr<FJsonValue>& PartValue : *PartsArray)
+		{
+			const TSharedPtr<FJsonObject> PartObject = PartValue->AsObject();
+			if (!PartObject.IsValid())
+			{
+				continue;
+			}
+
+			FString PartText;
+			const TSharedPtr<FJsonObject>* FunctionCallObject;
+			if (PartObject->TryGetStringField(TEXT("text"), PartText))
+			{
+				OutText += PartText;
+				if (OutTextParts)
+				{
+					OutTextParts->Add(MoveTemp(PartText));
+				}
+			}
+			else if (PartObject->TryGetObjectField(TEXT("functionCall"), FunctionCallObject))
+			{
+				// Wrapped the way FVFXResponseDispatcher recognizes tool calls
+				TSharedRef<FJsonObject> Wrapper = MakeShared<FJsonObject>();
+				Wrapper->SetObjectField(TEXT("functionCall"), *FunctionCallObject);
+
+				FString FunctionCall;
+				TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&FunctionCall);
+				FJsonSerializer::Serialize(Wrapper, Writer);
+				OutFunctionCalls.Add(MoveTemp(FunctionCall));
+			}
+		}
+		return true;
+	}
+
+	/** What a finished request hands to its delegates: the reply text, or an error */
+	struct FGeminiReplyOutcome
+	{
+		bool bSuccess = false;
+		FString Text;
+		int32 ErrorCode = 0;
+		FString ErrorMessage;
+
+		void Deliver(const FOnGeminiResponse& OnResponse, const FOnGeminiError& OnError) const
+		{
+			if (bSuccess)
+			{
+				OnResponse.ExecuteIfBound(Text);
+			}
+			else
+			{
+				OnError.ExecuteIfBound(ErrorCode, ErrorMessage);
+			}
+		}
+	};
+
+	FGeminiReplyOutcome MakeErrorOutcome(int32 ErrorCode, const FString& ErrorMessage)
+	{
+		FGeminiReplyOutcome Outcome;
+		Outcome.ErrorCode = ErrorCode;
+		Outcome.ErrorMessage = ErrorMessage;
+		return Outcome;
+	}
+
+	/**
+	 * Turn a finished request into the text or error its delegates receive.
+	 * Touches no UObject, so it runs on whichever thread parsed the reply.
+	 * @param Parsed Reply parsed from ResponseBody, or nullptr if it did not parse
+	 * @param AcceptCandidate Picks among several candidates, see FGeminiRequestOptions
+	 */
+	FGeminiReplyOutcome DecodeReply(
+		bool bWasSuccessful,
+		bool bResponseValid,
+		int32 ResponseCode,
+		const FString& ResponseBody,
+		const FGeminiResponse* Parsed,
+		const TFunction<bool(const FString&)>& AcceptCandidate
+	)
+	{
+		if (!bWasSuccessful || !bResponseValid)
+		{
+			// Network error that outlasted the retry policy
+			UE_LOG(LogTemp, Warning, TEXT("AINiagara: HTTP request failed - Network error"));
+			return MakeErrorOutcome(ResponseCode, TEXT("Network error: Request failed or no response received"));
+		}
+		
+		UE_LOG(LogTemp, Log, TEXT("AINiagara: HTTP response code: %d, Body length: %d"), ResponseCode, ResponseBody.Len());
+		
+		if (ResponseCode == 200)
+		{
+			if (!Parsed)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("AINiagara: Failed to parse response. Body: %s"), *ResponseBody.Left(200));
+				return MakeErrorOutcome(500, TEXT("Failed to parse response from API"));
+			}
+			
+			if (Parsed->IsBlocked())
+			{
+				const FString ErrorMessage = Parsed->DescribeBlock();
+				UE_LOG(LogTemp, Warning, TEXT("AINiagara: %s"), *ErrorMessage);
+				return MakeErrorOutcome(400, ErrorMessage);
+			}
+			
+			FGeminiReplyOutcome Outcome;
+			Outcome.bSuccess = true;
+			Outcome.Text = Parsed->GetResponseText();
+			if (Parsed->Candidates.Num() > 1 && AcceptCandidate)
+			{
+				const int32 Selected = FGeminiAPIClient::SelectCandidate(*Parsed, AcceptCandidate);
+				if (Selected == INDEX_NONE)
+				{
+					UE_LOG(LogTemp, Warning, TEXT("AINiagara: None of the %d candidates was accepted, using the first"), Parsed->Candidates.Num());
+				}
+				else
+				{
+					UE_LOG(LogTemp, Log, TEXT("AINiagara: Using candidate %d of %d"), Selected + 1, Parsed->Candidates.Num());
+					Outcome.Text = Parsed->Candidates[Selected];
+				}
+			}
+			
+			UE_LOG(LogTemp, Log, TEXT("AINiagara: Response parsed successfully. Text length: %d, parts: %d, function calls: %d, finish reason: %s"),
+				Outcome.Text.Len(), Parsed->TextParts.Num(), Parsed->FunctionCalls.Num(), *Parsed->FinishReason);
+			return Outcome;
+		}
+		else if (ResponseCode == 401)
+		{
+			// Unauthorized - API key issue
+			UE_LOG(LogTemp, Warning, TEXT("AINiagara: Unauthorized - Invalid API key"));
+			return MakeErrorOutcome(ResponseCode, TEXT("Unauthorized: Invalid or missing API key. Please check your API key configuration."));
+		}
+		else if (ResponseCode == 403)
+		{
+			// Forbidden - API key doesn't have permission
+			UE_LOG(LogTemp, Warning, TEXT("AINiagara: Forbidden - API key lacks permission"));
+			return MakeErrorOutcome(ResponseCode, TEXT("Forbidden: API key does not have permission for this operation."));
+		}
+		else if (ResponseCode == 429)
+		{
+			// Rate limited
+			UE_LOG(LogTemp, Warning, TEXT("AINiagara: Rate limit exceeded"));
+			return MakeErrorOutcome(ResponseCode, TEXT("Rate limit exceeded: Too many requests. Please wait before trying again."));
+		}
+		else if (ResponseCode >= 500)
+		{
+			// Server error that outlasted the retry policy
+			const FString ErrorMessage = FString::Printf(TEXT("Server error (%d): %s"), ResponseCode, *ResponseBody.Left(200));
+			UE_LOG(LogTemp, Warning, TEXT("AINiagara: Server error: %s"), *ErrorMessage);
+			return MakeErrorOutcome(ResponseCode, ErrorMessage);
+		}
+		
+		// Other client errors
+		FString ErrorMessage = ResponseBody;
+		if (ErrorMessage.IsEmpty())
+		{
+			ErrorMessage = FString::Printf(TEXT("Request failed with status code %d"), ResponseCode);
+		}
+		UE_LOG(LogTemp, Warning, TEXT("AINiagara: Client error (%d): %s"), ResponseCode, *ErrorMessage.Left(200));
+		return MakeErrorOutcome(ResponseCode, ErrorMessage);
+	}
+
+	/** Call the delegates with an outcome decoded on a worker; they always run on the game thread */
+	void DeliverOnGameThread(FGeminiReplyOutcome&& Outcome, FOnGeminiResponse OnResponse, FOnGeminiError OnError)
+	{
+		AsyncTask(ENamedThreads::GameThread, [Outcome = MoveTemp(Outcome), OnResponse, OnError]()
+		{
+			Outcome.Deliver(OnResponse, OnError);
+		});
+	}
+
+	/** Parse a reply answered from the response cache on a worker, then deliver it on the game thread */
+	void DeliverCachedReply(const FString& Body, FOnGeminiResponse OnResponse, FOnGeminiError OnError, TFunction<bool(const FString&)> AcceptCandidate = nullptr)
+	{
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [Body, OnResponse, OnError, AcceptCandidate = MoveTemp(AcceptCandidate)]()
+		{
+			FGeminiResponse Parsed;
+			const bool bParsed = FGeminiAPIClient::ParseResponse(Body, Parsed);
+			DeliverOnGameThread(DecodeReply(true, true, EHttpResponseCodes::Ok, Body, bParsed ? &Parsed : nullptr, AcceptCandidate), OnResponse, OnError);
+		});
+	}
+}
 
 FGeminiAPIClient::FGeminiAPIClient()
 {
 	// Load API key from settings on construction
 	LoadAPIKeyFromSettings();
+	
+	// Until ILLMBackend::Create or SetChatModel picks another, chat goes to the default model
+	ChatModel = DefaultChatModel;
+	
+	if (UAINiagaraSettings* Settings = UAINiagaraSettings::Get())
+	{
+		ContextCacheTTLSeconds = Settings->IsContextCacheEnabled() ? Settings->GetContextCacheTTLSeconds() : 0;
+	}
 }
 
 FGeminiAPIClient::~FGeminiAPIClient()
 {
 }
 
+FString FGeminiAPIClient::GetName() const
+{
+	return FString::Printf(TEXT("Gemini %s"), *ChatModel);
+}
+
+void FGeminiAPIClient::SetChatModel(const FString& InModel)
+{
+	ChatModel = InModel;
+	ChatModel.RemoveFromStart(TEXT("models/"));
+	if (ChatModel.IsEmpty())
+	{
+		ChatModel = DefaultChatModel;
+	}
+}
+
+FString FGeminiAPIClient::GetChatCompletionEndpoint() const
+{
+	return FString::Printf(TEXT("/models/%s:generateContent"), *ChatModel);
+}
+
+FString FGeminiAPIClient::GetStreamChatCompletionEndpoint() const
+{
+	return FString::Printf(TEXT("/models/%s:streamGenerateContent"), *ChatModel);
+}
+
+FString FGeminiAPIClient::GetImageGenerationEndpoint()
+{
+	return FString::Printf(TEXT("/models/%s:generateContent"), *ImageModel);
+}
+
 void FGeminiAPIClient::SetAPIKey(const FString& InAPIKey, bool bSaveToSettings)
 {
 	APIKey = InAPIKey;
@@ -73,7 +1033,35 @@ FString FGeminiAPIClient::GetAPIKey() const
 	return TEXT("****");
 }
 
-void FGeminiAPIClient::TestAPIKey(
+void FGeminiAPIClient::SetBaseURL(const FString& InBaseURL)
+{
+	BaseURLOverride = InBaseURL;
+	BaseURLOverride.RemoveFromEnd(TEXT("/"));
+}
+
+const FString& FGeminiAPIClient::GetBaseURL() const
+{
+	return BaseURLOverride.IsEmpty() ? BaseURL : BaseURLOverride;
+}
+
+void FGeminiAPIClient::SetContextCacheTTL(int32 InTTLSeconds)
+{
+	ContextCacheTTLSeconds = FMath::Max(0, InTTLSeconds);
+}
+
+FString FGeminiAPIClient::AcquireCachedContext(
+	const TArray<FConversationMessage>& ConversationHistory,
+	const TArray<FVFXToolFunction>& AvailableTools
+) const
+{
+	if (ContextCacheTTLSeconds <= 0)
+	{
+		return FString();
+	}
+	return FGeminiContextCache::Get().Acquire(GetBaseURL(), APIKey, TEXT("models/") + ChatModel, ConversationHistory, AvailableTools, ContextCacheTTLSeconds);
+}
+
+FGeminiRequestHandle FGeminiAPIClient::TestAPIKey(
 	const FString& InAPIKey,
 	FOnGeminiResponse OnResponse,
 	FOnGeminiError OnError
@@ -89,7 +1077,14 @@ void FGeminiAPIClient::TestAPIKey(
 	FString SavedAPIKey = APIKey;
 	SetAPIKey(InAPIKey, false); // Don't save to settings during test
 	
-	SendChatCompletion(
+	// Any model proves the key, so the test goes to the cheaper fast one
+	const FString SavedChatModel = ChatModel;
+	if (UAINiagaraSettings* Settings = UAINiagaraSettings::Get())
+	{
+		SetChatModel(Settings->GetGeminiModel(ELLMModelTier::Fast));
+	}
+	
+	FGeminiRequestHandle Handle = SendChatCompletion(
 		TestPrompt,
 		EmptyHistory,
 		EmptyTools,
@@ -97,115 +1092,437 @@ void FGeminiAPIClient::TestAPIKey(
 		OnError
 	);
 	
-	// Restore original API key
-	SetAPIKey(SavedAPIKey, false);
+	// Restore original API key and model
+	SetAPIKey(SavedAPIKey, false);
+	ChatModel = SavedChatModel;
+	
+	return Handle;
+}
+
+/**
+ * Sends a chat completion request to the Gemini API.
+ * 
+ * This function constructs an HTTP POST request to the Gemini API endpoint with:
+ * - The user's prompt
+ * - Full conversation history for context
+ * - Available tool functions for function calling
+ * 
+ * The request is asynchronous and uses delegates for success/error handling.
+ * 
+ * @param Prompt The user's current message/prompt
+ * @param ConversationHistory Array of previous conversation messages (user/assistant/system)
+ * @param AvailableTools Array of tool function definitions for function calling
+ * @param OnResponse Delegate called when API responds successfully with the generated text
+ * @param OnError Delegate called when API request fails (HTTP error code and message)
+ * 
+ * @note The API key must be set before calling this function (via SetAPIKey or LoadAPIKeyFromSettings)
+ * @note The request is sent asynchronously - delegates will be called on the game thread when complete
+ * @note Cancelling the returned handle drops the request; neither delegate is called afterwards
+ * @note With a hedge policy, a request still unanswered after its delay is sent a second time and the first reply wins
+ */
+FGeminiRequestHandle FGeminiAPIClient::SendChatCompletion(
+	const FString& Prompt,
+	const TArray<FConversationMessage>& ConversationHistory,
+	const TArray<FVFXToolFunction>& AvailableTools,
+	FOnGeminiResponse OnResponse,
+	FOnGeminiError OnError,
+	const FGeminiRequestOptions& Options
+)
+{
+	FGeminiRequestHandle Handle = FGeminiRequestHandle::MakePending();
+	GuardDelegates(Handle, OnResponse, OnError);
+	
+	if (APIKey.IsEmpty())
+	{
+		OnError.ExecuteIfBound(401, TEXT("API key is not set"));
+		return Handle;
+	}
+	
+	const FString ChatCompletionEndpoint = GetChatCompletionEndpoint();
+	const FString URL = GetBaseURL() + ChatCompletionEndpoint + TEXT("?key=") + APIKey;
+	FString Payload = BuildChatCompletionPayload(Prompt, ConversationHistory, AvailableTools);
+	FGeminiPayloadBuilder::AppendCandidateCount(Options.CandidateCount, Payload);
+	
+	const FString CacheKey = FGeminiResponseCache::MakeKey(ChatCompletionEndpoint, Payload);
+	if (TryAnswerFromCache(CacheKey, ChatCompletionEndpoint, ChatModel, Options, Handle, [OnResponse, OnError, AcceptCandidate = Options.AcceptCandidate](const FString& Body)
+		{
+			DeliverCachedReply(Body, OnResponse, OnError, AcceptCandidate);
+		}, OnError))
+	{
+		return Handle;
+	}
+	
+	// The response cache is keyed by the inline payload, so replies stay valid across cached contexts
+	TSharedRef<FGeminiRetryState, ESPMode::ThreadSafe> State = MakeRetryState(EGeminiEndpoint::Chat, ChatCompletionEndpoint, ChatModel, URL, Payload, Options, Handle);
+	ReferToCachedContent(*State, AcquireCachedContext(ConversationHistory, AvailableTools), Prompt, ConversationHistory);
+	
+	UE_LOG(LogTemp, Log, TEXT("AINiagara: Queueing HTTP request to: %s"), *(GetBaseURL() + ChatCompletionEndpoint));
+	SendHedged(State, [OnResponse, OnError, CacheKey](FGeminiRetryState& Leg, int32 LegIndex, const TSharedRef<FGeminiHedgeState, ESPMode::ThreadSafe>& Hedge)
+	{
+		FOnGeminiResponse LegOnResponse = OnResponse;
+		FOnGeminiError LegOnError = OnError;
+		HedgeDelegates(Hedge, LegIndex, LegOnResponse, LegOnError);
+		
+		Leg.OnComplete = [LegOnResponse, LegOnError, CacheKey, AcceptCandidate = Leg.Options.AcceptCandidate](FHttpRequestPtr HttpRequest, FHttpResponsePtr HttpResponse, bool bWasSuccessful, const FGeminiRequestMetrics& Metrics)
+		{
+			UE_LOG(LogTemp, Log, TEXT("AINiagara: HTTP request completed - Success: %d, Valid: %d"), 
+				bWasSuccessful, HttpResponse.IsValid() ? 1 : 0);
+			
+			HandleRequestComplete(HttpRequest, HttpResponse, bWasSuccessful, LegOnResponse, LegOnError, Metrics, CacheKey, AcceptCandidate);
+		};
+	});
+	
+	return Handle;
+}
+
+/**
+ * Sends a chat completion request to streamGenerateContent with alt=sse.
+ * 
+ * The reply arrives as server-sent events, each a partial GenerateContentResponse.
+ * The HTTP module's progress callback hands the bytes received so far to an
+ * FGeminiSSEParser, and each event's text is reported through OnChunk as soon as
+ * its terminating blank line arrives. On completion the remaining bytes are parsed
+ * and OnResponse receives the concatenated text. Error replies are plain JSON
+ * bodies and are reported exactly like SendChatCompletion reports them.
+ * 
+ * @note Progress callbacks are ticked on the game thread; anything not consumed there is picked up at completion
+ * @note Cancelling the returned handle stops the stream; no chunk or outcome is reported afterwards
+ * @note With a hedge policy, the copy whose first chunk arrives first is streamed and the other copy is cancelled
+ * @note Several candidates cannot be streamed, so such requests go to generateContent and the chosen candidate arrives as one chunk
+ */
+FGeminiRequestHandle FGeminiAPIClient::StreamChatCompletion(
+	const FString& Prompt,
+	const TArray<FConversationMessage>& ConversationHistory,
+	const TArray<FVFXToolFunction>& AvailableTools,
+	FOnGeminiStreamChunk OnChunk,
+	FOnGeminiResponse OnResponse,
+	FOnGeminiError OnError,
+	const FGeminiRequestOptions& Options
+)
+{
+	if (Options.CandidateCount > 1)
+	{
+		const double StartSeconds = FPlatformTime::Seconds();
+		return SendChatCompletion(
+			Prompt,
+			ConversationHistory,
+			AvailableTools,
+			FOnGeminiResponse::CreateLambda([OnChunk, OnResponse, StartSeconds](const FString& ResponseText)
+			{
+				FGeminiStreamStats Stats;
+				Stats.NumChunks = 1;
+				Stats.ReceivedBytes = FTCHARToUTF8(*ResponseText).Length();
+				Stats.FirstChunkSeconds = FPlatformTime::Seconds() - StartSeconds;
+				Stats.ElapsedSeconds = Stats.FirstChunkSeconds;
+				
+				OnChunk.ExecuteIfBound(ResponseText, Stats);
+				OnResponse.ExecuteIfBound(ResponseText);
+			}),
+			OnError,
+			Options
+		);
+	}
+	
+	FGeminiRequestHandle Handle = FGeminiRequestHandle::MakePending();
+	GuardDelegates(Handle, OnResponse, OnError);
+	
+	if (APIKey.IsEmpty())
+	{
+		OnError.ExecuteIfBound(401, TEXT("API key is not set"));
+		return Handle;
+	}
+	
+	const FString StreamChatCompletionEndpoint = GetStreamChatCompletionEndpoint();
+	const FString URL = GetBaseURL() + StreamChatCompletionEndpoint + TEXT("?alt=sse&key=") + APIKey;
+	const FString Payload = BuildChatCompletionPayload(Prompt, ConversationHistory, AvailableTools);
+	
+	// A cached stream is the raw event body, so it is replayed chunk by chunk
+	const FString CacheKey = FGeminiResponseCache::MakeKey(StreamChatCompletionEndpoint, Payload);
+	TSharedRef<FGeminiStreamState, ESPMode::ThreadSafe> CachedState = MakeShared<FGeminiStreamState, ESPMode::ThreadSafe>();
+	CachedState->OnChunk = FOnGeminiStreamChunk::CreateLambda([Handle, OnChunk](const FString& ChunkText, const FGeminiStreamStats& Stats)
+	{
+		if (Handle.IsPending())
+		{
+			OnChunk.ExecuteIfBound(ChunkText, Stats);
+		}
+	});
+	if (TryAnswerFromCache(CacheKey, StreamChatCompletionEndpoint, ChatModel, Options, Handle, [State = CachedState, OnResponse, OnError](const FString& Body)
+		{
+			const FTCHARToUTF8 BodyUTF8(*Body);
+			State->StartSeconds = FPlatformTime::Seconds();
+			ConsumeStreamBody(*State, TArray<uint8>(reinterpret_cast<const uint8*>(BodyUTF8.Get()), BodyUTF8.Length()), true);
+			
+			if (State->Stats.NumChunks == 0)
+			{
+				OnError.ExecuteIfBound(500, TEXT("Stream ended without any response text"));
+				return;
+			}
+			OnResponse.ExecuteIfBound(State->ResponseText);
+		}, OnError))
+	{
+		return Handle;
+	}
+	
+	TSharedRef<FGeminiRetryState, ESPMode::ThreadSafe> RetryState = MakeRetryState(EGeminiEndpoint::Chat, StreamChatCompletionEndpoint, ChatModel, URL, Payload, Options, Handle);
+	ReferToCachedContent(*RetryState, AcquireCachedContext(ConversationHistory, AvailableTools), Prompt, ConversationHistory);
+	
+	UE_LOG(LogTemp, Log, TEXT("AINiagara: Queueing streamed HTTP request to: %s"), *(GetBaseURL() + StreamChatCompletionEndpoint));
+	SendHedged(RetryState, [OnChunk, OnResponse, OnError, CacheKey](FGeminiRetryState& Leg, int32 LegIndex, const TSharedRef<FGeminiHedgeState, ESPMode::ThreadSafe>& Hedge)
+	{
+		// Each copy parses its own body; the first to show text wins
+		const FGeminiRequestHandle LegHandle = Leg.Handle;
+		TSharedRef<FGeminiStreamState, ESPMode::ThreadSafe> State = MakeShared<FGeminiStreamState, ESPMode::ThreadSafe>();
+		State->OnChunk = FOnGeminiStreamChunk::CreateLambda([LegHandle, Hedge, LegIndex, OnChunk](const FString& ChunkText, const FGeminiStreamStats& Stats)
+		{
+			if (LegHandle.IsPending() && Hedge->Claim(LegIndex))
+			{
+				OnChunk.ExecuteIfBound(ChunkText, Stats);
+			}
+		});
+		
+		FOnGeminiResponse LegOnResponse = OnResponse;
+		FOnGeminiError LegOnError = OnError;
+		HedgeDelegates(Hedge, LegIndex, LegOnResponse, LegOnError);
+		
+		// Consume events while the body is still arriving
+		Leg.OnProgress = [State](FHttpRequestPtr HttpRequest)
+		{
+			const FHttpResponsePtr HttpResponse = HttpRequest.IsValid() ? HttpRequest->GetResponse() : nullptr;
+			if (!IsInGameThread() || !HttpResponse.IsValid() || HttpResponse->GetResponseCode() != EHttpResponseCodes::Ok)
+			{
+				return;
+			}
+			ConsumeStreamBody(*State, HttpResponse->GetContent(), false);
+		};
+		
+		Leg.PrepareAttempt = [State](const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Request)
+		{
+			// Nothing has been shown yet if this is a retry, so parse the new body from scratch
+			State->Parser.Reset();
+			State->Events.Reset();
+			State->ConsumedBytes = 0;
+			State->FinishReason.Reset();
+			State->LastMetadataEvent.Reset();
+			
+			// Time to first token excludes the queue wait
+			State->StartSeconds = FPlatformTime::Seconds();
+			
+			Request->SetHeader(TEXT("Accept"), TEXT("text/event-stream"));
+		};
+		
+		// Once a chunk has reached OnChunk, a second attempt would repeat text the caller already has
+		Leg.CanRetry = [State]()
+		{
+			return State->Stats.NumChunks == 0;
+		};
+		
+		Leg.OnComplete = [State, LegHandle, LegOnResponse, LegOnError, CacheKey](
+			FHttpRequestPtr HttpRequest,
+			FHttpResponsePtr HttpResponse,
+			bool bWasSuccessful,
+			const FGeminiRequestMetrics& Metrics
+		)
+		{
+			const bool bResponseValid = HttpResponse.IsValid();
+			const int32 ResponseCode = bResponseValid ? HttpResponse->GetResponseCode() : 0;
+			
+			// Error replies are plain JSON bodies: decoded on a worker task like any other reply, and never cached
+			if (!bWasSuccessful || !bResponseValid || ResponseCode != EHttpResponseCodes::Ok)
+			{
+				if (!LegHandle.IsCancelled())
+				{
+					HandleRequestComplete(HttpRequest, HttpResponse, bWasSuccessful, LegOnResponse, LegOnError, Metrics);
+				}
+				return;
+			}
+			
+			auto Finish = [State, LegHandle, OnResponse = LegOnResponse, OnError = LegOnError, CacheKey, Metrics, HttpResponse]()
+			{
+				// Cancelled while the reply was on its way to the game thread
+				if (LegHandle.IsCancelled())
+				{
+					return;
+				}
+				
+				// The last events go through OnChunk like the ones the progress callbacks parsed, so they stay on this thread
+				ConsumeStreamBody(*State, HttpResponse->GetContent(), true);
+				
+				const double TotalSeconds = FPlatformTime::Seconds() - State->StartSeconds;
+				UE_LOG(LogTemp, Log, TEXT("AINiagara: Stream complete - %d chunks, %lld bytes, first token after %.0f ms, total %.0f ms, finish reason: %s"),
+					State->Stats.NumChunks, State->ConsumedBytes, State->Stats.FirstChunkSeconds * 1000.0, TotalSeconds * 1000.0, *State->FinishReason);
+				
+				// Token counts and prompt feedback come with the last events
+				FGeminiResponse Usage;
+				ParseResponse(State->LastMetadataEvent, Usage);
+				Usage.Text = State->ResponseText;
+				if (!State->FinishReason.IsEmpty())
+				{
+					Usage.FinishReason = State->FinishReason;
+				}
+				RecordMetrics(Metrics, &Usage);
+				
+				if (State->Stats.NumChunks == 0)
+				{
+					if (Usage.IsBlocked())
+					{
+						OnError.ExecuteIfBound(400, Usage.DescribeBlock());
+						return;
+					}
+					OnError.ExecuteIfBound(500, TEXT("Stream ended without any response text"));
+					return;
+				}
+				
+				// Converting and writing a long event body would stall the editor
+				if (FGeminiResponseCache::Get().GetMode() == EGeminiResponseCacheMode::ReadWrite)
+				{
+					UE::Tasks::Launch(UE_SOURCE_LOCATION, [CacheKey, HttpResponse]()
+					{
+						const TArray<uint8>& Content = HttpResponse->GetContent();
+						const FUTF8ToTCHAR Body(reinterpret_cast<const ANSICHAR*>(Content.GetData()), Content.Num());
+						StoreInCache(CacheKey, FString(Body.Length(), Body.Get()));
+					});
+				}
+				
+				OnResponse.ExecuteIfBound(State->ResponseText);
+			};
+			
+			// Always execute delegates on game thread to ensure UI updates work correctly
+			if (IsInGameThread())
+			{
+				Finish();
+			}
+			else
+			{
+				AsyncTask(ENamedThreads::GameThread, MoveTemp(Finish));
+			}
+		};
+	});
+	
+	return Handle;
 }
 
-/**
- * Sends a chat completion request to the Gemini API.
- * 
- * This function constructs an HTTP POST request to the Gemini API endpoint with:
- * - The user's prompt
- * - Full conversation history for context
- * - Available tool functions for function calling
- * 
- * The request is asynchronous and uses delegates for success/error handling.
- * 
- * @param Prompt The user's current message/prompt
- * @param ConversationHistory Array of previous conversation messages (user/assistant/system)
- * @param AvailableTools Array of tool function definitions for function calling
- * @param OnResponse Delegate called when API responds successfully with the generated text
- * @param OnError Delegate called when API request fails (HTTP error code and message)
- * 
- * @note The API key must be set before calling this function (via SetAPIKey or LoadAPIKeyFromSettings)
- * @note The request is sent asynchronously - delegates will be called on the game thread when complete
- */
-void FGeminiAPIClient::SendChatCompletion(
+FGeminiRequestHandle FGeminiAPIClient::GenerateTexture(
 	const FString& Prompt,
-	const TArray<FConversationMessage>& ConversationHistory,
-	const TArray<FVFXToolFunction>& AvailableTools,
+	const FString& TextureType,
+	int32 Resolution,
 	FOnGeminiResponse OnResponse,
-	FOnGeminiError OnError
+	FOnGeminiError OnError,
+	const FGeminiRequestOptions& Options
 )
 {
+	FGeminiRequestHandle Handle = FGeminiRequestHandle::MakePending();
+	GuardDelegates(Handle, OnResponse, OnError);
+	
 	if (APIKey.IsEmpty())
 	{
 		OnError.ExecuteIfBound(401, TEXT("API key is not set"));
-		return;
+		return Handle;
 	}
 	
-	const FString URL = BaseURL + ChatCompletionEndpoint + TEXT("?key=") + APIKey;
-	const FString Payload = BuildChatCompletionPayload(Prompt, ConversationHistory, AvailableTools);
+	const FString ImageGenerationEndpoint = GetImageGenerationEndpoint();
+	const FString URL = GetBaseURL() + ImageGenerationEndpoint + TEXT("?key=") + APIKey;
+	const FString Payload = BuildTextureGenerationPayload(Prompt, TextureType, Resolution);
 	
-	// Create HTTP request
-	FHttpModule& HttpModule = FHttpModule::Get();
-	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = HttpModule.CreateRequest();
+	const FString CacheKey = FGeminiResponseCache::MakeKey(ImageGenerationEndpoint, Payload);
+	if (TryAnswerFromCache(CacheKey, ImageGenerationEndpoint, ImageModel, Options, Handle, [OnResponse, OnError](const FString& Body)
+		{
+			DeliverCachedReply(Body, OnResponse, OnError);
+		}, OnError))
+	{
+		return Handle;
+	}
 	
-	Request->SetURL(URL);
-	Request->SetVerb(TEXT("POST"));
-	Request->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
-	Request->SetContentAsString(Payload);
+	TSharedRef<FGeminiRetryState, ESPMode::ThreadSafe> State = MakeRetryState(EGeminiEndpoint::Image, ImageGenerationEndpoint, ImageModel, URL, Payload, Options, Handle);
+	State->OnComplete = [OnResponse, OnError, CacheKey](FHttpRequestPtr HttpRequest, FHttpResponsePtr HttpResponse, bool bWasSuccessful, const FGeminiRequestMetrics& Metrics)
+	{
+		HandleRequestComplete(HttpRequest, HttpResponse, bWasSuccessful, OnResponse, OnError, Metrics, CacheKey);
+	};
 	
-	// Bind completion callback
-	Request->OnProcessRequestComplete().BindLambda(
-		[this, OnResponse, OnError, URL, Payload](
-			FHttpRequestPtr HttpRequest,
-			FHttpResponsePtr HttpResponse,
-			bool bWasSuccessful
-		)
-		{
-			UE_LOG(LogTemp, Log, TEXT("AINiagara: HTTP request completed - Success: %d, Valid: %d"), 
-				bWasSuccessful, HttpResponse.IsValid() ? 1 : 0);
-			
-			HandleRequestComplete(HttpRequest, HttpResponse, bWasSuccessful, OnResponse, OnError);
-		}
-	);
+	SendAttempt(State);
 	
-	// Send request
-	UE_LOG(LogTemp, Log, TEXT("AINiagara: Sending HTTP request to: %s"), *URL);
-	Request->ProcessRequest();
+	return Handle;
 }
 
-void FGeminiAPIClient::GenerateTexture(
+/**
+ * Same request as GenerateTexture, but the reply is handed over as the HTTP response's
+ * own content array: the response is kept alive by the task that reads it, and
+ * nothing converts, parses or copies the body on the way to OnContent. Error replies
+ * are small and take the usual text path to OnError on the game thread.
+ */
+FGeminiRequestHandle FGeminiAPIClient::GenerateTextureContent(
 	const FString& Prompt,
 	const FString& TextureType,
 	int32 Resolution,
-	FOnGeminiResponse OnResponse,
-	FOnGeminiError OnError
+	FOnGeminiContent OnContent,
+	FOnGeminiError OnError,
+	const FGeminiRequestOptions& Options
 )
 {
+	FGeminiRequestHandle Handle = FGeminiRequestHandle::MakePending();
+	FOnGeminiResponse NoResponse;
+	GuardDelegates(Handle, NoResponse, OnError);
+	
 	if (APIKey.IsEmpty())
 	{
 		OnError.ExecuteIfBound(401, TEXT("API key is not set"));
-		return;
+		return Handle;
 	}
 	
-	const FString URL = BaseURL + ImageGenerationEndpoint + TEXT("?key=") + APIKey;
+	const FString ImageGenerationEndpoint = GetImageGenerationEndpoint();
+	const FString URL = GetBaseURL() + ImageGenerationEndpoint + TEXT("?key=") + APIKey;
 	const FString Payload = BuildTextureGenerationPayload(Prompt, TextureType, Resolution);
 	
-	// Create HTTP request
-	FHttpModule& HttpModule = FHttpModule::Get();
-	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = HttpModule.CreateRequest();
-	
-	Request->SetURL(URL);
-	Request->SetVerb(TEXT("POST"));
-	Request->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
-	Request->SetContentAsString(Payload);
+	const FString CacheKey = FGeminiResponseCache::MakeKey(ImageGenerationEndpoint, Payload);
+	if (TryAnswerFromCache(CacheKey, ImageGenerationEndpoint, ImageModel, Options, Handle, [Handle, OnContent](const FString& Body)
+		{
+			// Cached replies are kept as text, so they take one conversion back to bytes
+			UE::Tasks::Launch(UE_SOURCE_LOCATION, [Handle, OnContent, Body]()
+			{
+				const FTCHARToUTF8 BodyUTF8(*Body);
+				if (Handle.TryFinish())
+				{
+					OnContent(TConstArrayView<uint8>(reinterpret_cast<const uint8*>(BodyUTF8.Get()), BodyUTF8.Length()));
+				}
+			});
+		}, OnError))
+	{
+		return Handle;
+	}
 	
-	// Bind completion callback
-	Request->OnProcessRequestComplete().BindLambda(
-		[this, OnResponse, OnError](
-			FHttpRequestPtr HttpRequest,
-			FHttpResponsePtr HttpResponse,
-			bool bWasSuccessful
-		)
+	TSharedRef<FGeminiRetryState, ESPMode::ThreadSafe> State = MakeRetryState(EGeminiEndpoint::Image, ImageGenerationEndpoint, ImageModel, URL, Payload, Options, Handle);
+	State->OnComplete = [Handle, OnContent, OnError, CacheKey](FHttpRequestPtr HttpRequest, FHttpResponsePtr HttpResponse, bool bWasSuccessful, const FGeminiRequestMetrics& Metrics)
+	{
+		const bool bResponseValid = HttpResponse.IsValid();
+		const int32 ResponseCode = bResponseValid ? HttpResponse->GetResponseCode() : 0;
+		if (!bWasSuccessful || !bResponseValid || ResponseCode != EHttpResponseCodes::Ok)
 		{
-			HandleRequestComplete(HttpRequest, HttpResponse, bWasSuccessful, OnResponse, OnError);
+			RecordMetrics(Metrics, nullptr);
+			const FString ResponseBody = bResponseValid ? HttpResponse->GetContentAsString() : FString();
+			DeliverOnGameThread(DecodeReply(bWasSuccessful, bResponseValid, ResponseCode, ResponseBody, nullptr, nullptr), FOnGeminiResponse(), OnError);
+			return;
 		}
-	);
+		
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [Handle, OnContent, CacheKey, Metrics, HttpResponse]()
+		{
+			RecordMetrics(Metrics, nullptr);
+			
+			const TArray<uint8>& Content = HttpResponse->GetContent();
+			if (FGeminiResponseCache::Get().GetMode() == EGeminiResponseCacheMode::ReadWrite)
+			{
+				const FUTF8ToTCHAR Body(reinterpret_cast<const ANSICHAR*>(Content.GetData()), Content.Num());
+				StoreInCache(CacheKey, FString(Body.Length(), Body.Get()));
+			}
+			
+			if (Handle.TryFinish())
+			{
+				OnContent(Content);
+			}
+		});
+	};
+	
+	SendAttempt(State);
 	
-	// Send request
-	Request->ProcessRequest();
+	return Handle;
 }
 
 /**
@@ -230,6 +1547,7 @@ void FGeminiAPIClient::GenerateTexture(
  * 
  * @note The conversation history is added first, followed by the current prompt
  * @note Tools are only included if AvailableTools is not empty
+ * @note Tool declarations and the system prompt are serialized once and reused, see FGeminiPayloadBuilder
  */
 FString FGeminiAPIClient::BuildChatCompletionPayload(
 	const FString& Prompt,
@@ -237,93 +1555,9 @@ FString FGeminiAPIClient::BuildChatCompletionPayload(
 	const TArray<FVFXToolFunction>& AvailableTools
 ) const
 {
-	TSharedPtr<FJsonObject> RootObject = MakeShareable(new FJsonObject);
-	
-	// Build contents array
-	TArray<TSharedPtr<FJsonValue>> ContentsArray;
-	
-	// Add conversation history
-	for (const FConversationMessage& Message : ConversationHistory)
-	{
-		TSharedPtr<FJsonObject> MessageObject = MakeShareable(new FJsonObject);
-		MessageObject->SetStringField(TEXT("role"), Message.Role);
-		
-		TSharedPtr<FJsonObject> PartObject = MakeShareable(new FJsonObject);
-		PartObject->SetStringField(TEXT("text"), Message.Content);
-		
-		TArray<TSharedPtr<FJsonValue>> PartsArray;
-		PartsArray.Add(MakeShareable(new FJsonValueObject(PartObject)));
-		
-		MessageObject->SetArrayField(TEXT("parts"), PartsArray);
-		ContentsArray.Add(MakeShareable(new FJsonValueObject(MessageObject)));
-	}
-	
-	// Add current user prompt
-	TSharedPtr<FJsonObject> UserMessage = MakeShareable(new FJsonObject);
-	UserMessage->SetStringField(TEXT("role"), TEXT("user"));
-	
-	TSharedPtr<FJsonObject> UserPart = MakeShareable(new FJsonObject);
-	UserPart->SetStringField(TEXT("text"), Prompt);
-	
-	TArray<TSharedPtr<FJsonValue>> UserPartsArray;
-	UserPartsArray.Add(MakeShareable(new FJsonValueObject(UserPart)));
-	
-	UserMessage->SetArrayField(TEXT("parts"), UserPartsArray);
-	ContentsArray.Add(MakeShareable(new FJsonValueObject(UserMessage)));
-	
-	RootObject->SetArrayField(TEXT("contents"), ContentsArray);
-	
-	// Add tools if available
-	if (AvailableTools.Num() > 0)
-	{
-		TArray<TSharedPtr<FJsonValue>> ToolsArray;
-		
-		for (const FVFXToolFunction& Tool : AvailableTools)
-		{
-			TSharedPtr<FJsonObject> ToolObject = MakeShareable(new FJsonObject);
-			TSharedPtr<FJsonObject> FunctionDeclaration = MakeShareable(new FJsonObject);
-			
-			FunctionDeclaration->SetStringField(TEXT("name"), Tool.Name);
-			FunctionDeclaration->SetStringField(TEXT("description"), Tool.Description);
-			
-			// Add parameters if available
-			if (Tool.Parameters.Num() > 0)
-			{
-				TSharedPtr<FJsonObject> ParametersObject = MakeShareable(new FJsonObject);
-				TSharedPtr<FJsonObject> PropertiesObject = MakeShareable(new FJsonObject);
-				
-				for (const auto& ParamPair : Tool.Parameters)
-				{
-					TSharedPtr<FJsonObject> ParamObject = MakeShareable(new FJsonObject);
-					ParamObject->SetStringField(TEXT("type"), ParamPair.Value);
-					PropertiesObject->SetObjectField(ParamPair.Key, ParamObject);
-				}
-				
-				TArray<FString> RequiredArray;
-				Tool.Parameters.GetKeys(RequiredArray);
-				
-				ParametersObject->SetObjectField(TEXT("properties"), PropertiesObject);
-				ParametersObject->SetArrayField(TEXT("required"), TArray<TSharedPtr<FJsonValue>>());
-				ParametersObject->SetStringField(TEXT("type"), TEXT("object"));
-				
-				FunctionDeclaration->SetObjectField(TEXT("parameters"), ParametersObject);
-			}
-			
-			ToolObject->SetObjectField(TEXT("functionDeclaration"), FunctionDeclaration);
-			ToolsArray.Add(MakeShareable(new FJsonValueObject(ToolObject)));
-		}
-		
-		TSharedPtr<FJsonObject> ToolsObject = MakeShareable(new FJsonObject);
-		ToolsObject->SetArrayField(TEXT("tools"), ToolsArray);
-		RootObject->SetObjectField(TEXT("tools"), ToolsObject);
-	}
-	
-	// Convert to JSON string
-	FString OutputString;
-	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&OutputString);
-	FJsonSerializer::Serialize(RootObject.ToSharedRef(), Writer);
-	
-	return OutputString;
+	FString Payload;
+	FGeminiPayloadBuilder::Get().BuildChatCompletion(Prompt, ConversationHistory, AvailableTools, Payload);
+	return Payload;
 }
 
 FString FGeminiAPIClient::BuildTextureGenerationPayload(
@@ -367,274 +1601,188 @@ FString FGeminiAPIClient::BuildTextureGenerationPayload(
 	return OutputString;
 }
 
-bool FGeminiAPIClient::ParseResponse(const FString& ResponseBody, FString& OutResponseText) const
+bool FGeminiResponse::IsBlocked() const
 {
-	TSharedPtr<FJsonObject> JsonObject;
-	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseBody);
-	
-	if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid())
+	if (!BlockReason.IsEmpty())
 	{
-		return false;
+		return true;
 	}
 	
-	// Navigate to the response text
-	// Gemini API response structure: { candidates: [{ content: { parts: [{ text: "..." }] } }] }
-	const TArray<TSharedPtr<FJsonValue>>* CandidatesArray;
-	if (JsonObject->TryGetArrayField(TEXT("candidates"), CandidatesArray) && 
-		CandidatesArray->Num() > 0)
+	// Finish reasons of a candidate whose content was withheld by the provider's filters
+	static const TCHAR* BlockingReasons[] = { TEXT("SAFETY"), TEXT("RECITATION"), TEXT("BLOCKLIST"), TEXT("PROHIBITED_CONTENT"), TEXT("SPII") };
+	if (Text.IsEmpty() && FunctionCalls.Num() == 0)
 	{
-		TSharedPtr<FJsonObject> CandidateObject = (*CandidatesArray)[0]->AsObject();
-		if (CandidateObject.IsValid())
+		for (const TCHAR* Reason : BlockingReasons)
 		{
-			TSharedPtr<FJsonObject> ContentObject = CandidateObject->GetObjectField(TEXT("content"));
-			if (ContentObject.IsValid())
+			if (FinishReason == Reason)
 			{
-				const TArray<TSharedPtr<FJsonValue>>* PartsArray;
-				if (ContentObject->TryGetArrayField(TEXT("parts"), PartsArray) &&
-					PartsArray->Num() > 0)
-				{
-					TSharedPtr<FJsonObject> PartObject = (*PartsArray)[0]->AsObject();
-					if (PartObject.IsValid())
-					{
-						PartObject->TryGetStringField(TEXT("text"), OutResponseText);
-						return true;
-					}
-				}
+				return true;
 			}
 		}
 	}
-	
 	return false;
 }
 
-void FGeminiAPIClient::HandleRequestComplete(
-	FHttpRequestPtr Request,
-	FHttpResponsePtr Response,
-	bool bWasSuccessful,
-	FOnGeminiResponse OnResponse,
-	FOnGeminiError OnError
-)
+FString FGeminiResponse::DescribeBlock() const
 {
-	UE_LOG(LogTemp, Log, TEXT("AINiagara: HandleRequestComplete called - Success: %d, ResponseValid: %d, Thread: %d"), 
-		bWasSuccessful, Response.IsValid() ? 1 : 0, IsInGameThread() ? 1 : 0);
+	FString Message = BlockReason.IsEmpty()
+		? FString::Printf(TEXT("Response withheld by content filters (%s)"), *FinishReason)
+		: FString::Printf(TEXT("Prompt blocked by content filters (%s)"), *BlockReason);
+	if (BlockedCategories.Num() > 0)
+	{
+		Message += TEXT(": ") + FString::Join(BlockedCategories, TEXT(", "));
+	}
+	return Message;
+}
+
+/**
+ * Parses a GenerateContentResponse:
+ * {
+ *   "candidates": [{ "content": { "parts": [{ "text": "..." }, { "functionCall": {...} }] }, "finishReason": "STOP", "safetyRatings": [...] }],
+ *   "promptFeedback": { "blockReason": "SAFETY", "safetyRatings": [...] },
+ *   "usageMetadata": { "promptTokenCount": 10, "candidatesTokenCount": 20, "cachedContentTokenCount": 0, "totalTokenCount": 30 }
+ * }
+ * 
+ * @note A candidate without content only parses if safety filters removed it
+ */
+bool FGeminiAPIClient::ParseResponse(const FString& ResponseBody, FGeminiResponse& OutResponse)
+{
+	OutResponse = FGeminiResponse();
 	
-	// Capture response data before potentially switching threads
-	int32 ResponseCode = 0;
-	FString ResponseBody;
+	TSharedPtr<FJsonObject> JsonObject;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseBody);
 	
-	if (Response.IsValid())
+	if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid())
 	{
-		ResponseCode = Response->GetResponseCode();
-		ResponseBody = Response->GetContentAsString();
+		return false;
 	}
 	
-	// Always execute delegates on game thread to ensure UI updates work correctly
-	// HTTP callbacks may execute on HTTP thread, not game thread
-	if (IsInGameThread())
+	const TSharedPtr<FJsonObject>* UsageObject;
+	if (JsonObject->TryGetObjectField(TEXT("usageMetadata"), UsageObject))
 	{
-		// Already on game thread - execute directly
-		HandleRequestCompleteOnGameThread(bWasSuccessful, Response.IsValid(), ResponseCode, ResponseBody, OnResponse, OnError);
+		(*UsageObject)->TryGetNumberField(TEXT("promptTokenCount"), OutResponse.PromptTokens);
+		(*UsageObject)->TryGetNumberField(TEXT("candidatesTokenCount"), OutResponse.OutputTokens);
+		(*UsageObject)->TryGetNumberField(TEXT("cachedContentTokenCount"), OutResponse.CachedTokens);
+		(*UsageObject)->TryGetNumberField(TEXT("totalTokenCount"), OutResponse.TotalTokens);
 	}
-	else
+	
+	// A blocked prompt has feedback and no candidates
+	const TSharedPtr<FJsonObject>* FeedbackObject;
+	if (JsonObject->TryGetObjectField(TEXT("promptFeedback"), FeedbackObject))
 	{
-		// Not on game thread - schedule for game thread
-		// Capture all data by value to avoid issues with destroyed objects
-		AsyncTask(ENamedThreads::GameThread, [bWasSuccessful, ResponseIsValid = Response.IsValid(), ResponseCode, ResponseBody, OnResponse, OnError]()
-		{
-			HandleRequestCompleteOnGameThread(bWasSuccessful, ResponseIsValid, ResponseCode, ResponseBody, OnResponse, OnError);
-		});
+		(*FeedbackObject)->TryGetStringField(TEXT("blockReason"), OutResponse.BlockReason);
+		CollectBlockedCategories(*FeedbackObject, OutResponse.BlockedCategories);
 	}
-}
-
-void FGeminiAPIClient::HandleRequestCompleteOnGameThread(
-	bool bWasSuccessful,
-	bool bResponseValid,
-	int32 ResponseCode,
-	const FString& ResponseBody,
-	FOnGeminiResponse OnResponse,
-	FOnGeminiError OnError
-)
-{
-	UE_LOG(LogTemp, Log, TEXT("AINiagara: HandleRequestCompleteOnGameThread - Success: %d, Valid: %d, Code: %d, OnGameThread: %d"), 
-		bWasSuccessful, bResponseValid ? 1 : 0, ResponseCode, IsInGameThread() ? 1 : 0);
 	
-	if (!bWasSuccessful || !bResponseValid)
+	const TArray<TSharedPtr<FJsonValue>>* CandidatesArray;
+	if (!JsonObject->TryGetArrayField(TEXT("candidates"), CandidatesArray) || CandidatesArray->Num() == 0)
 	{
-		// Network error - could retry, but for now just report
-		UE_LOG(LogTemp, Warning, TEXT("AINiagara: HTTP request failed - Network error"));
-		OnError.ExecuteIfBound(
-			ResponseCode,
-			TEXT("Network error: Request failed or no response received")
-		);
-		return;
+		return !OutResponse.BlockReason.IsEmpty();
 	}
+	OutResponse.NumCandidates = CandidatesArray->Num();
+	
+	const TSharedPtr<FJsonObject> CandidateObject = (*CandidatesArray)[0]->AsObject();
+	if (!CandidateObject.IsValid())
+	{
+		return !OutResponse.BlockReason.IsEmpty();
+	}
+	
+	CandidateObject->TryGetStringField(TEXT("finishReason"), OutResponse.FinishReason);
+	CollectBlockedCategories(CandidateObject, OutResponse.BlockedCategories);
 	
-	UE_LOG(LogTemp, Log, TEXT("AINiagara: HTTP response code: %d, Body length: %d"), ResponseCode, ResponseBody.Len());
+	const bool bHasContent = ParseCandidateContent(CandidateObject, OutResponse.Text, &OutResponse.TextParts, OutResponse.FunctionCalls);
 	
-	if (ResponseCode == 200)
+	// The other candidates are only needed as text to pick from
+	OutResponse.Candidates.Reserve(CandidatesArray->Num());
+	OutResponse.Candidates.Add(OutResponse.GetResponseText());
+	for (int32 Index = 1; Index < CandidatesArray->Num(); ++Index)
 	{
-		FString ResponseText;
-		if (ParseResponse(ResponseBody, ResponseText))
-		{
-			UE_LOG(LogTemp, Log, TEXT("AINiagara: Response parsed successfully, calling OnResponse. Text length: %d"), ResponseText.Len());
-			OnResponse.ExecuteIfBound(ResponseText);
-		}
-		else
+		FString Text;
+		TArray<FString> FunctionCalls;
+		const TSharedPtr<FJsonObject> OtherObject = (*CandidatesArray)[Index]->AsObject();
+		if (OtherObject.IsValid())
 		{
-			UE_LOG(LogTemp, Warning, TEXT("AINiagara: Failed to parse response. Body: %s"), *ResponseBody.Left(200));
-			OnError.ExecuteIfBound(500, TEXT("Failed to parse response from API"));
+			ParseCandidateContent(OtherObject, Text, nullptr, FunctionCalls);
 		}
+		OutResponse.Candidates.Add((Text.IsEmpty() && FunctionCalls.Num() > 0) ? FunctionCalls[0] : Text);
 	}
-	else if (ResponseCode == 401)
-	{
-		// Unauthorized - API key issue
-		UE_LOG(LogTemp, Warning, TEXT("AINiagara: Unauthorized - Invalid API key"));
-		OnError.ExecuteIfBound(ResponseCode, TEXT("Unauthorized: Invalid or missing API key. Please check your API key configuration."));
-	}
-	else if (ResponseCode == 403)
-	{
-		// Forbidden - API key doesn't have permission
-		UE_LOG(LogTemp, Warning, TEXT("AINiagara: Forbidden - API key lacks permission"));
-		OnError.ExecuteIfBound(ResponseCode, TEXT("Forbidden: API key does not have permission for this operation."));
-	}
-	else if (ResponseCode == 429)
+	
+	return bHasContent || OutResponse.IsBlocked();
+}
+
+/**
+ * Runs AcceptCandidate on every candidate at once; DSL validation of a few
+ * candidates is independent work, so the slowest one bounds the wait.
+ */
+int32 FGeminiAPIClient::SelectCandidate(const FGeminiResponse& Response, const TFunction<bool(const FString&)>& AcceptCandidate)
+{
+	if (!AcceptCandidate)
 	{
-		// Rate limited
-		UE_LOG(LogTemp, Warning, TEXT("AINiagara: Rate limit exceeded"));
-		OnError.ExecuteIfBound(ResponseCode, TEXT("Rate limit exceeded: Too many requests. Please wait before trying again."));
+		return Response.Candidates.Num() > 0 ? 0 : INDEX_NONE;
 	}
-	else if (ResponseCode >= 500)
+	
+	TArray<uint8> Accepted;
+	Accepted.SetNumZeroed(Response.Candidates.Num());
+	ParallelFor(Response.Candidates.Num(), [&Response, &AcceptCandidate, &Accepted](int32 Index)
 	{
-		// Server error - could retry
-		FString ErrorMessage = FString::Printf(TEXT("Server error (%d): %s"), ResponseCode, *ResponseBody.Left(200));
-		UE_LOG(LogTemp, Warning, TEXT("AINiagara: Server error: %s"), *ErrorMessage);
-		OnError.ExecuteIfBound(ResponseCode, ErrorMessage);
-	}
-	else
+		const FString& Candidate = Response.Candidates[Index];
+		Accepted[Index] = (!Candidate.IsEmpty() && AcceptCandidate(Candidate)) ? 1 : 0;
+	});
+	
+	return Accepted.Find(1);
+}
+
+void FGeminiAPIClient::RecordMetrics(FGeminiRequestMetrics Metrics, const FGeminiResponse* Response)
+{
+	Metrics.Timestamp = FDateTime::UtcNow();
+	if (Response)
 	{
-		// Other client errors
-		FString ErrorMessage = ResponseBody;
-		if (ErrorMessage.IsEmpty())
-		{
-			ErrorMessage = FString::Printf(TEXT("Request failed with status code %d"), ResponseCode);
-		}
-		UE_LOG(LogTemp, Warning, TEXT("AINiagara: Client error (%d): %s"), ResponseCode, *ErrorMessage.Left(200));
-		OnError.ExecuteIfBound(ResponseCode, ErrorMessage);
+		Metrics.PromptTokens = Response->PromptTokens;
+		Metrics.OutputTokens = Response->OutputTokens;
+		Metrics.CachedTokens = Response->CachedTokens;
+		Metrics.TotalTokens = Response->TotalTokens;
+		Metrics.FinishReason = Response->BlockReason.IsEmpty() ? Response->FinishReason : Response->BlockReason;
 	}
+	FGeminiMetricsRegistry::Get().Record(Metrics);
 }
 
-void FGeminiAPIClient::RetryRequest(
-	const FString& URL,
-	const FString& Payload,
-	int32 RetryCount,
+void FGeminiAPIClient::HandleRequestComplete(
+	FHttpRequestPtr Request,
+	FHttpResponsePtr Response,
+	bool bWasSuccessful,
 	FOnGeminiResponse OnResponse,
-	FOnGeminiError OnError
+	FOnGeminiError OnError,
+	const FGeminiRequestMetrics& Metrics,
+	const FString& CacheKey,
+	const TFunction<bool(const FString&)>& AcceptCandidate
 )
 {
-	if (RetryCount >= MaxRetries)
-	{
-		OnError.ExecuteIfBound(500, FString::Printf(TEXT("Request failed after %d retry attempts"), MaxRetries));
-		return;
-	}
+	UE_LOG(LogTemp, Log, TEXT("AINiagara: HandleRequestComplete called - Success: %d, ResponseValid: %d, Thread: %d"), 
+		bWasSuccessful, Response.IsValid() ? 1 : 0, IsInGameThread() ? 1 : 0);
 	
-	// Calculate exponential backoff delay
-	float DelaySeconds = InitialRetryDelay * FMath::Pow(2.0f, static_cast<float>(RetryCount));
+	// Everything up to the delegate call runs on a worker task: JSON parsing, candidate
+	// selection and the cache write scale with the reply, and 2K image replies carry
+	// megabytes of base64, so doing them on the game thread stalls the editor
+	const bool bResponseValid = Response.IsValid();
+	const int32 ResponseCode = bResponseValid ? Response->GetResponseCode() : 0;
 	
-	// Schedule retry after delay
-	FTimerHandle RetryTimerHandle;
-	FTimerDelegate RetryDelegate = FTimerDelegate::CreateLambda([this, URL, Payload, RetryCount, OnResponse, OnError]()
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [bWasSuccessful, bResponseValid, ResponseCode, Response, OnResponse, OnError, Metrics, CacheKey, AcceptCandidate]()
 	{
-		// Create HTTP request
-		FHttpModule& HttpModule = FHttpModule::Get();
-		TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = HttpModule.CreateRequest();
-		
-		Request->SetURL(URL);
-		Request->SetVerb(TEXT("POST"));
-		Request->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
-		Request->SetContentAsString(Payload);
+		const double DecodeStartSeconds = FPlatformTime::Seconds();
+		const FString ResponseBody = bResponseValid ? Response->GetContentAsString() : FString();
 		
-		// Bind completion callback with retry logic
-		Request->OnProcessRequestComplete().BindLambda(
-			[this, URL, Payload, RetryCount, OnResponse, OnError](
-				FHttpRequestPtr HttpRequest,
-				FHttpResponsePtr HttpResponse,
-				bool bWasSuccessful
-			)
-			{
-				if (!bWasSuccessful || !HttpResponse.IsValid())
-				{
-					// Retry on network errors
-					RetryRequest(URL, Payload, RetryCount + 1, OnResponse, OnError);
-					return;
-				}
-				
-				const int32 ResponseCode = HttpResponse->GetResponseCode();
-				
-				// Retry on 5xx server errors and 429 (rate limit)
-				if (ResponseCode >= 500 || ResponseCode == 429)
-				{
-					RetryRequest(URL, Payload, RetryCount + 1, OnResponse, OnError);
-					return;
-				}
-				
-				// Handle other responses normally
-				HandleRequestComplete(HttpRequest, HttpResponse, bWasSuccessful, OnResponse, OnError);
-			}
-		);
+		// Only replies that parse are worth replaying
+		FGeminiResponse Parsed;
+		const bool bParsed = bWasSuccessful && ResponseCode == EHttpResponseCodes::Ok && ParseResponse(ResponseBody, Parsed);
+		if (bParsed && !Parsed.IsBlocked())
+		{
+			StoreInCache(CacheKey, ResponseBody);
+		}
+		RecordMetrics(Metrics, bParsed ? &Parsed : nullptr);
 		
-		// Send request
-		Request->ProcessRequest();
+		FGeminiReplyOutcome Outcome = DecodeReply(bWasSuccessful, bResponseValid, ResponseCode, ResponseBody, bParsed ? &Parsed : nullptr, AcceptCandidate);
+		UE_LOG(LogTemp, Verbose, TEXT("AINiagara: Decoded a %d character reply off the game thread in %.2f ms"),
+			ResponseBody.Len(), (FPlatformTime::Seconds() - DecodeStartSeconds) * 1000.0);
+		DeliverOnGameThread(MoveTemp(Outcome), OnResponse, OnError);
 	});
-	
-	// Schedule retry using FTSTicker for delayed execution
-	// This works in both editor and game
-	FTSTicker::GetCoreTicker().AddTicker(
-		FTickerDelegate::CreateLambda([this, URL, Payload, RetryCount, OnResponse, OnError](float DeltaTime) -> bool
-		{
-			// Create HTTP request
-			FHttpModule& HttpModule = FHttpModule::Get();
-			TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = HttpModule.CreateRequest();
-			
-			Request->SetURL(URL);
-			Request->SetVerb(TEXT("POST"));
-			Request->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
-			Request->SetContentAsString(Payload);
-			
-			// Bind completion callback with retry logic
-			Request->OnProcessRequestComplete().BindLambda(
-				[this, URL, Payload, RetryCount, OnResponse, OnError](
-					FHttpRequestPtr HttpRequest,
-					FHttpResponsePtr HttpResponse,
-					bool bWasSuccessful
-				)
-				{
-					if (!bWasSuccessful || !HttpResponse.IsValid())
-					{
-						// Retry on network errors
-						RetryRequest(URL, Payload, RetryCount + 1, OnResponse, OnError);
-						return;
-					}
-					
-					const int32 ResponseCode = HttpResponse->GetResponseCode();
-					
-					// Retry on 5xx server errors and 429 (rate limit)
-					if (ResponseCode >= 500 || ResponseCode == 429)
-					{
-						RetryRequest(URL, Payload, RetryCount + 1, OnResponse, OnError);
-						return;
-					}
-					
-					// Handle other responses normally
-					HandleRequestComplete(HttpRequest, HttpResponse, bWasSuccessful, OnResponse, OnError);
-				}
-			);
-			
-			// Send request
-			Request->ProcessRequest();
-			
-			return false; // Don't repeat
-		}),
-		DelaySeconds
-	);
 }
-
@@ -0,0 +1,181 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/GeminiContextCache.h"
+#include "Core/GeminiPayloadBuilder.h"
+#include "Core/GeminiResponseCache.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+	const TCHAR* CachedContentsEndpoint = TEXT("/cachedContents");
+
+	/** Wait after a failed creation, so a model without caching support is not asked on every turn */
+	const FTimespan CreateRetryDelay = FTimespan::FromMinutes(5.0);
+
+	/** Stop handing out a name this long before it expires, so requests in flight do not outlive it */
+	FTimespan GetExpiryMargin(int32 TTLSeconds)
+	{
+		return FTimespan::FromSeconds(FMath::Min(60.0, TTLSeconds * 0.1));
+	}
+}
+
+FGeminiContextCache::FGeminiContextCache()
+	: State(MakeShared<FState, ESPMode::ThreadSafe>())
+{
+}
+
+FGeminiContextCache& FGeminiContextCache::Get()
+{
+	static FGeminiContextCache Cache;
+	return Cache;
+}
+
+FString FGeminiContextCache::Acquire(
+	const FString& BaseURL,
+	const FString& APIKey,
+	const FString& Model,
+	const TArray<FConversationMessage>& ConversationHistory,
+	const TArray<FVFXToolFunction>& AvailableTools,
+	int32 TTLSeconds)
+{
+	FString Body;
+	if (TTLSeconds <= 0 || !FGeminiPayloadBuilder::Get().BuildCachedContent(Model, ConversationHistory, AvailableTools, TTLSeconds, Body))
+	{
+		return FString();
+	}
+
+	// The key is hashed, so the API key never sits in the map in clear
+	const FString Key = FGeminiResponseCache::MakeKey(BaseURL + TEXT("\n") + APIKey, Body);
+	const FDateTime Now = FDateTime::UtcNow();
+	{
+		FScopeLock Lock(&State->Mutex);
+		FEntry& Entry = State->Entries.FindOrAdd(Key);
+		if (!Entry.Name.IsEmpty())
+		{
+			if (Now < Entry.ExpireTime)
+			{
+				++State->Stats.NumHits;
+				return Entry.Name;
+			}
+
+			UE_LOG(LogTemp, Log, TEXT("AINiagara: Cached context %s expired, recreating it"), *Entry.Name);
+			++State->Stats.NumExpired;
+			Entry.Name.Reset();
+		}
+
+		++State->Stats.NumMisses;
+		if (Entry.bCreating || Now < Entry.RetryTime)
+		{
+			return FString();
+		}
+		Entry.bCreating = true;
+	}
+
+	Create(Key, BaseURL + CachedContentsEndpoint + TEXT("?key=") + APIKey, Body, TTLSeconds);
+	return FString();
+}
+
+void FGeminiContextCache::Create(const FString& Key, const FString& URL, const FString& Body, int32 TTLSeconds)
+{
+	UE_LOG(LogTemp, Log, TEXT("AINiagara: Creating cached context (%d chars, ttl %d s)"), Body.Len(), TTLSeconds);
+
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+	Request->SetURL(URL);
+	Request->SetVerb(TEXT("POST"));
+	Request->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
+	Request->SetContentAsString(Body);
+
+	TWeakPtr<FState, ESPMode::ThreadSafe> WeakState = State;
+	Request->OnProcessRequestComplete().BindLambda([WeakState, Key, TTLSeconds](FHttpRequestPtr HttpRequest, FHttpResponsePtr HttpResponse, bool bWasSuccessful)
+	{
+		if (TSharedPtr<FState, ESPMode::ThreadSafe> PinnedState = WeakState.Pin())
+		{
+			const bool bReceived = bWasSuccessful && HttpResponse.IsValid();
+			OnCreated(*PinnedState, Key, TTLSeconds, bReceived ? HttpResponse->GetResponseCode() : 0, bReceived ? HttpResponse->GetContentAsString() : FString());
+		}
+	});
+	Request->ProcessRequest();
+}
+
+void FGeminiContextCache::OnCreated(FState& CacheState, const FString& Key, int32 TTLSeconds, int32 ResponseCode, const FString& ResponseBody)
+{
+	FString Name;
+	FDateTime ExpireTime = FDateTime::UtcNow() + FTimespan::FromSeconds(TTLSeconds);
+
+	TSharedPtr<FJsonObject> JsonObject;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseBody);
+	if (ResponseCode == 200 && FJsonSerializer::Deserialize(Reader, JsonObject) && JsonObject.IsValid())
+	{
+		JsonObject->TryGetStringField(TEXT("name"), Name);
+
+		// The provider's clock decides; the local TTL is only a fallback
+		FString ExpireTimeString;
+		FDateTime ProviderExpireTime;
+		if (JsonObject->TryGetStringField(TEXT("expireTime"), ExpireTimeString) && FDateTime::ParseIso8601(*ExpireTimeString, ProviderExpireTime))
+		{
+			ExpireTime = ProviderExpireTime;
+		}
+	}
+
+	FScopeLock Lock(&CacheState.Mutex);
+	FEntry* Entry = CacheState.Entries.Find(Key);
+	if (!Entry)
+	{
+		// Reset while the request was in flight
+		return;
+	}
+	Entry->bCreating = false;
+
+	if (Name.IsEmpty())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("AINiagara: Could not create cached context (%d), sending requests inline: %s"), ResponseCode, *ResponseBody.Left(200));
+		++CacheState.Stats.NumCreateFailures;
+		Entry->RetryTime = FDateTime::UtcNow() + CreateRetryDelay;
+		return;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("AINiagara: Created cached context %s, expires %s"), *Name, *ExpireTime.ToIso8601());
+	++CacheState.Stats.NumCreated;
+	Entry->Name = Name;
+	Entry->ExpireTime = ExpireTime - GetExpiryMargin(TTLSeconds);
+}
+
+void FGeminiContextCache::Invalidate(const FString& Name)
+{
+	FScopeLock Lock(&State->Mutex);
+	for (TPair<FString, FEntry>& Pair : State->Entries)
+	{
+		if (Pair.Value.Name == Name)
+		{
+			UE_LOG(LogTemp, Log, TEXT("AINiagara: Cached context %s was rejected, recreating it"), *Name);
+			++State->Stats.NumRejected;
+			Pair.Value.Name.Reset();
+		}
+	}
+}
+
+bool FGeminiContextCache::IsCachedContentError(int32 ResponseCode, const FString& ResponseBody)
+{
+	// Expired or deleted content is reported as NOT_FOUND or PERMISSION_DENIED naming the cached content
+	return (ResponseCode == 400 || ResponseCode == 403 || ResponseCode == 404)
+		&& ResponseBody.Contains(TEXT("CachedContent"), ESearchCase::IgnoreCase);
+}
+
+FGeminiContextCacheStats FGeminiContextCache::GetStats() const
+{
+	FScopeLock Lock(&State->Mutex);
+	return State->Stats;
+}
+
+void FGeminiContextCache::Reset()
+{
+	FScopeLock Lock(&State->Mutex);
+	State->Entries.Reset();
+	State->Stats = FGeminiContextCacheStats();
+}
@@ -0,0 +1,323 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/GeminiMetrics.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+	/** Quote a CSV field, doubling embedded quotes */
+	FString QuoteCSV(const FString& Field)
+	{
+		return TEXT("\"") + Field.Replace(TEXT("\""), TEXT("\"\"")) + TEXT("\"");
+	}
+
+	double Mean(double Sum, int32 Count)
+	{
+		return Count > 0 ? Sum / Count : 0.0;
+	}
+
+	FString FormatTotals(const FString& Name, const FGeminiEndpointTotals& Totals)
+	{
+		// Cache hits never reached the network, so they are left out of the latency means
+		const int32 NumSent = Totals.NumRequests - Totals.NumFromCache;
+		return FString::Printf(
+			TEXT("%s: %d requests (%d errors, %d from cache, %d retries), queue %.0f ms, ttfb %.0f ms, total %.0f ms (max %.0f ms), sent %.1f KB, received %.1f KB, tokens %lld prompt (%lld cached) + %lld output"),
+			*Name, Totals.NumRequests, Totals.NumErrors, Totals.NumFromCache, Totals.NumRetries,
+			Mean(Totals.QueueSeconds, NumSent) * 1000.0, Mean(Totals.TimeToFirstByteSeconds, NumSent) * 1000.0,
+			Mean(Totals.TotalSeconds, NumSent) * 1000.0, Totals.MaxTotalSeconds * 1000.0,
+			Totals.RequestBytes / 1024.0, Totals.ResponseBytes / 1024.0,
+			Totals.PromptTokens, Totals.CachedTokens, Totals.OutputTokens);
+	}
+}
+
+void FGeminiEndpointTotals::Add(const FGeminiRequestMetrics& Metrics)
+{
+	++NumRequests;
+	NumErrors += Metrics.IsError() ? 1 : 0;
+	NumFromCache += Metrics.bFromCache ? 1 : 0;
+	NumRetries += FMath::Max(0, Metrics.NumAttempts - 1);
+
+	RequestBytes += Metrics.RequestBytes;
+	ResponseBytes += Metrics.ResponseBytes;
+
+	PromptTokens += Metrics.PromptTokens;
+	OutputTokens += Metrics.OutputTokens;
+	CachedTokens += Metrics.CachedTokens;
+
+	if (!Metrics.bFromCache)
+	{
+		QueueSeconds += Metrics.QueueSeconds;
+		TimeToFirstByteSeconds += Metrics.TimeToFirstByteSeconds;
+		TotalSeconds += Metrics.TotalSeconds;
+		MaxTotalSeconds = FMath::Max(MaxTotalSeconds, Metrics.TotalSeconds);
+	}
+}
+
+FGeminiMetricsRegistry::FGeminiMetricsRegistry()
+{
+	Records.Reserve(MaxRecords);
+}
+
+FGeminiMetricsRegistry& FGeminiMetricsRegistry::Get()
+{
+	static FGeminiMetricsRegistry Registry;
+	return Registry;
+}
+
+void FGeminiMetricsRegistry::Record(const FGeminiRequestMetrics& Metrics)
+{
+	UE_LOG(LogTemp, Verbose, TEXT("AINiagara: %s [%s] (%d) - queue %.0f ms, ttfb %.0f ms, total %.0f ms, %lld/%lld bytes, %d+%d tokens"),
+		*Metrics.Endpoint, *Metrics.Model, Metrics.ResponseCode, Metrics.QueueSeconds * 1000.0, Metrics.TimeToFirstByteSeconds * 1000.0,
+		Metrics.TotalSeconds * 1000.0, Metrics.RequestBytes, Metrics.ResponseBytes, Metrics.PromptTokens, Metrics.OutputTokens);
+
+	FScopeLock Lock(&Mutex);
+	if (Records.Num() < MaxRecords)
+	{
+		Records.Add(Metrics);
+	}
+	else
+	{
+		Records[NextRecord] = Metrics;
+		NextRecord = (NextRecord + 1) % MaxRecords;
+	}
+	Totals.FindOrAdd(Metrics.Endpoint).Add(Metrics);
+	if (!Metrics.Model.IsEmpty())
+	{
+		ModelTotals.FindOrAdd(Metrics.Model).Add(Metrics);
+	}
+}
+
+TArray<FGeminiRequestMetrics> FGeminiMetricsRegistry::GetRecent() const
+{
+	FScopeLock Lock(&Mutex);
+	TArray<FGeminiRequestMetrics> Recent;
+	Recent.Reserve(Records.Num());
+	for (int32 Offset = 0; Offset < Records.Num(); ++Offset)
+	{
+		Recent.Add(Records[(NextRecord + Offset) % Records.Num()]);
+	}
+	return Recent;
+}
+
+TMap<FString, FGeminiEndpointTotals> FGeminiMetricsRegistry::GetTotals() const
+{
+	FScopeLock Lock(&Mutex);
+	return Totals;
+}
+
+TMap<FString, FGeminiEndpointTotals> FGeminiMetricsRegistry::GetModelTotals() const
+{
+	FScopeLock Lock(&Mutex);
+	return ModelTotals;
+}
+
+FGeminiEndpointTotals FGeminiMetricsRegistry::GetOverallTotals() const
+{
+	FScopeLock Lock(&Mutex);
+	FGeminiEndpointTotals Overall;
+	for (const TPair<FString, FGeminiEndpointTotals>& Pair : Totals)
+	{
+		const FGeminiEndpointTotals& Endpoint = Pair.Value;
+		Overall.NumRequests += Endpoint.NumRequests;
+		Overall.NumErrors += Endpoint.NumErrors;
+		Overall.NumFromCache += Endpoint.NumFromCache;
+		Overall.NumRetries += Endpoint.NumRetries;
+		Overall.RequestBytes += Endpoint.RequestBytes;
+		Overall.ResponseBytes += Endpoint.ResponseBytes;
+		Overall.PromptTokens += Endpoint.PromptTokens;
+		Overall.OutputTokens += Endpoint.OutputTokens;
+		Overall.CachedTokens += Endpoint.CachedTokens;
+		Overall.QueueSeconds += Endpoint.QueueSeconds;
+		Overall.TimeToFirstByteSeconds += Endpoint.TimeToFirstByteSeconds;
+		Overall.TotalSeconds += Endpoint.TotalSeconds;
+		Overall.MaxTotalSeconds = FMath::Max(Overall.MaxTotalSeconds, Endpoint.MaxTotalSeconds);
+	}
+	return Overall;
+}
+
+bool FGeminiMetricsRegistry::GetLatencyPercentile(const FString& Endpoint, double Percentile, int32 MinSamples, double& OutSeconds) const
+{
+	return GetLatencyPercentileOf([&Endpoint](const FGeminiRequestMetrics& Metrics) { return Metrics.Endpoint == Endpoint; }, Percentile, MinSamples, OutSeconds);
+}
+
+bool FGeminiMetricsRegistry::GetModelLatencyPercentile(const FString& Model, double Percentile, int32 MinSamples, double& OutSeconds) const
+{
+	return GetLatencyPercentileOf([&Model](const FGeminiRequestMetrics& Metrics) { return Metrics.Model == Model; }, Percentile, MinSamples, OutSeconds);
+}
+
+bool FGeminiMetricsRegistry::GetLatencyPercentileOf(TFunctionRef<bool(const FGeminiRequestMetrics&)> Filter, double Percentile, int32 MinSamples, double& OutSeconds) const
+{
+	TArray<double> Latencies;
+	{
+		FScopeLock Lock(&Mutex);
+		for (const FGeminiRequestMetrics& Metrics : Records)
+		{
+			if (!Metrics.bFromCache && !Metrics.IsError() && Filter(Metrics))
+			{
+				Latencies.Add(Metrics.TotalSeconds);
+			}
+		}
+	}
+
+	if (Latencies.Num() == 0 || Latencies.Num() < MinSamples)
+	{
+		return false;
+	}
+
+	Latencies.Sort();
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * Latencies.Num()) - 1, 0, Latencies.Num() - 1);
+	OutSeconds = Latencies[Index];
+	return true;
+}
+
+void FGeminiMetricsRegistry::RecordHedge()
+{
+	FScopeLock Lock(&Mutex);
+	++HedgeStats.NumHedged;
+}
+
+void FGeminiMetricsRegistry::RecordHedgeWinner(bool bDuplicateWon)
+{
+	FScopeLock Lock(&Mutex);
+	HedgeStats.NumDuplicateWins += bDuplicateWon ? 1 : 0;
+}
+
+FGeminiHedgeStats FGeminiMetricsRegistry::GetHedgeStats() const
+{
+	FScopeLock Lock(&Mutex);
+	return HedgeStats;
+}
+
+FString FGeminiMetricsRegistry::FormatSummary() const
+{
+	TMap<FString, FGeminiEndpointTotals> TotalsCopy = GetTotals();
+	if (TotalsCopy.Num() == 0)
+	{
+		return TEXT("No Gemini requests recorded");
+	}
+
+	TotalsCopy.KeySort(TLess<FString>());
+
+	TArray<FString> Lines;
+	for (const TPair<FString, FGeminiEndpointTotals>& Pair : TotalsCopy)
+	{
+		Lines.Add(FormatTotals(Pair.Key, Pair.Value));
+	}
+	if (TotalsCopy.Num() > 1)
+	{
+		Lines.Add(FormatTotals(TEXT("All endpoints"), GetOverallTotals()));
+	}
+
+	// The same requests again by model, to compare the large and fast tiers
+	TMap<FString, FGeminiEndpointTotals> ModelTotalsCopy = GetModelTotals();
+	ModelTotalsCopy.KeySort(TLess<FString>());
+	for (const TPair<FString, FGeminiEndpointTotals>& Pair : ModelTotalsCopy)
+	{
+		FString Line = FormatTotals(TEXT("Model ") + Pair.Key, Pair.Value);
+		double P95Seconds = 0.0;
+		if (GetModelLatencyPercentile(Pair.Key, 0.95, 1, P95Seconds))
+		{
+			Line += FString::Printf(TEXT(", p95 %.0f ms"), P95Seconds * 1000.0);
+		}
+		Lines.Add(Line);
+	}
+
+	const FGeminiHedgeStats Hedges = GetHedgeStats();
+	if (Hedges.NumHedged > 0)
+	{
+		Lines.Add(FString::Printf(TEXT("Hedged requests: %d, answered by the duplicate: %d"), Hedges.NumHedged, Hedges.NumDuplicateWins));
+	}
+	return FString::Join(Lines, TEXT("\n"));
+}
+
+bool FGeminiMetricsRegistry::WriteCSV(const FString& Path, FString& OutError) const
+{
+	const TArray<FGeminiRequestMetrics> Recent = GetRecent();
+
+	FString CSV = TEXT("Timestamp,Endpoint,ResponseCode,Attempts,FromCache,CachedContext,QueueMs,TimeToFirstByteMs,TotalMs,RequestBytes,ResponseBytes,PromptTokens,OutputTokens,CachedTokens,TotalTokens,FinishReason,Model\n");
+	for (const FGeminiRequestMetrics& Metrics : Recent)
+	{
+		CSV += FString::Printf(TEXT("%s,%s,%d,%d,%d,%d,%.1f,%.1f,%.1f,%lld,%lld,%d,%d,%d,%d,%s,%s\n"),
+			*Metrics.Timestamp.ToIso8601(), *QuoteCSV(Metrics.Endpoint), Metrics.ResponseCode, Metrics.NumAttempts,
+			Metrics.bFromCache ? 1 : 0, Metrics.bCachedContext ? 1 : 0,
+			Metrics.QueueSeconds * 1000.0, Metrics.TimeToFirstByteSeconds * 1000.0, Metrics.TotalSeconds * 1000.0,
+			Metrics.RequestBytes, Metrics.ResponseBytes,
+			Metrics.PromptTokens, Metrics.OutputTokens, Metrics.CachedTokens, Metrics.TotalTokens,
+			*QuoteCSV(Metrics.FinishReason), *QuoteCSV(Metrics.Model));
+	}
+
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+	if (!FFileHelper::SaveStringToFile(CSV, *Path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+	{
+		OutError = FString::Printf(TEXT("Could not write %s"), *Path);
+		return false;
+	}
+	return true;
+}
+
+FString FGeminiMetricsRegistry::GetDefaultCSVPath()
+{
+	return FPaths::ProjectSavedDir() / TEXT("AINiagara") / TEXT("Metrics") / FString::Printf(TEXT("GeminiMetrics-%s.csv"), *FDateTime::Now().ToString());
+}
+
+void FGeminiMetricsRegistry::Reset()
+{
+	FScopeLock Lock(&Mutex);
+	Records.Reset();
+	NextRecord = 0;
+	Totals.Reset();
+	ModelTotals.Reset();
+	HedgeStats = FGeminiHedgeStats();
+}
+
+void FGeminiMetricsRegistry::RegisterConsoleCommands()
+{
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("AINiagara.Metrics"),
+		TEXT("Gemini request metrics: stats | reset | csv [path]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&FGeminiMetricsRegistry::ConsoleCommand_Metrics),
+		ECVF_Default
+	);
+}
+
+void FGeminiMetricsRegistry::ConsoleCommand_Metrics(const TArray<FString>& Args)
+{
+	FGeminiMetricsRegistry& Registry = Get();
+	const FString Command = Args.Num() > 0 ? Args[0] : TEXT("stats");
+
+	if (Command.Equals(TEXT("reset"), ESearchCase::IgnoreCase))
+	{
+		Registry.Reset();
+		UE_LOG(LogTemp, Log, TEXT("AINiagara: Metrics reset"));
+	}
+	else if (Command.Equals(TEXT("csv"), ESearchCase::IgnoreCase))
+	{
+		const FString Path = Args.Num() > 1 ? Args[1] : GetDefaultCSVPath();
+		FString Error;
+		if (Registry.WriteCSV(Path, Error))
+		{
+			UE_LOG(LogTemp, Log, TEXT("AINiagara: Wrote %d request metrics to %s"), Registry.GetRecent().Num(), *Path);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("AINiagara: %s"), *Error);
+		}
+	}
+	else if (Command.Equals(TEXT("stats"), ESearchCase::IgnoreCase))
+	{
+		TArray<FString> Lines;
+		Registry.FormatSummary().ParseIntoArrayLines(Lines);
+		for (const FString& Line : Lines)
+		{
+			UE_LOG(LogTemp, Log, TEXT("AINiagara: %s"), *Line);
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("AINiagara: Usage: AINiagara.Metrics stats | reset | csv [path]"));
+	}
+}
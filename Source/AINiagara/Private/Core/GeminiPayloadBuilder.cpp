@@ -0,0 +1,411 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/GeminiPayloadBuilder.h"
+#include "Core/JsonStringAppendArchive.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+	using FCondensedJsonWriter = TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>;
+	using FCondensedJsonWriterFactory = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>;
+
+	/** System prompts kept serialized at once */
+	constexpr int32 MaxSystemFragments = 4;
+
+	/** Append one contents entry, {"role":...,"parts":[{"text":...}]} */
+	void AppendContentEntry(const FString& Role, const FString& Text, FString& OutPayload)
+	{
+		FJsonStringAppendArchive Archive(OutPayload);
+		TSharedRef<FCondensedJsonWriter> Writer = FCondensedJsonWriterFactory::Create(&Archive);
+
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("role"), Role);
+		Writer->WriteArrayStart(TEXT("parts"));
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("text"), Text);
+		Writer->WriteObjectEnd();
+		Writer->WriteArrayEnd();
+		Writer->WriteObjectEnd();
+		Writer->Close();
+	}
+
+	/** Whether two tool lists serialize to the same declarations */
+	bool AreToolsEqual(const TArray<FVFXToolFunction>& A, const TArray<FVFXToolFunction>& B)
+	{
+		if (A.Num() != B.Num())
+		{
+			return false;
+		}
+
+		for (int32 Index = 0; Index < A.Num(); ++Index)
+		{
+			const FVFXToolFunction& ToolA = A[Index];
+			const FVFXToolFunction& ToolB = B[Index];
+			if (!ToolA.Name.Equals(ToolB.Name, ESearchCase::CaseSensitive)
+				|| !ToolA.Description.Equals(ToolB.Description, ESearchCase::CaseSensitive)
+				|| ToolA.Parameters.Num() != ToolB.Parameters.Num())
+			{
+				return false;
+			}
+
+			// Declaration order is serialization order
+			auto ItA = ToolA.Parameters.CreateConstIterator();
+			auto ItB = ToolB.Parameters.CreateConstIterator();
+			for (; ItA; ++ItA, ++ItB)
+			{
+				if (!ItA->Key.Equals(ItB->Key, ESearchCase::CaseSensitive) || !ItA->Value.Equals(ItB->Value, ESearchCase::CaseSensitive))
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+}
+
+FGeminiPayloadBuilder& FGeminiPayloadBuilder::Get()
+{
+	static FGeminiPayloadBuilder Builder;
+	return Builder;
+}
+
+void FGeminiPayloadBuilder::BuildChatCompletion(
+	const FString& Prompt,
+	const TArray<FConversationMessage>& ConversationHistory,
+	const TArray<FVFXToolFunction>& AvailableTools,
+	FString& OutPayload
+)
+{
+	// Text plus the fixed characters of each entry; escapes and the tools fragment may still grow it
+	int32 Estimate = 64 + Prompt.Len();
+	for (const FConversationMessage& Message : ConversationHistory)
+	{
+		Estimate += 40 + Message.Role.Len() + Message.Content.Len();
+	}
+	OutPayload.Reset(Estimate);
+
+	FScopeLock Lock(&Mutex);
+
+	OutPayload += TEXT("{\"contents\":[");
+	for (const FConversationMessage& Message : ConversationHistory)
+	{
+		if (Message.Role.Equals(TEXT("system"), ESearchCase::CaseSensitive))
+		{
+			AppendSystemFragment(Message, OutPayload);
+		}
+		else
+		{
+			AppendContentEntry(Message.Role, Message.Content, OutPayload);
+		}
+		OutPayload += TEXT(",");
+	}
+	AppendContentEntry(TEXT("user"), Prompt, OutPayload);
+	OutPayload += TEXT("]");
+
+	if (AvailableTools.Num() > 0)
+	{
+		AppendToolsFragment(AvailableTools, OutPayload);
+	}
+	OutPayload += TEXT("}");
+}
+
+void FGeminiPayloadBuilder::BuildChatCompletionWithCachedContent(
+	const FString& CachedContentName,
+	const FString& Prompt,
+	const TArray<FConversationMessage>& ConversationHistory,
+	FString& OutPayload
+)
+{
+	int32 Estimate = 96 + CachedContentName.Len() + Prompt.Len();
+	for (const FConversationMessage& Message : ConversationHistory)
+	{
+		Estimate += 40 + Message.Role.Len() + Message.Content.Len();
+	}
+	OutPayload.Reset(Estimate);
+
+	// Names are "cachedContents/" followed by an id, nothing to escape
+	OutPayload += TEXT("{\"cachedContent\":\"");
+	OutPayload += CachedContentName;
+	OutPayload += TEXT("\",\"contents\":[");
+	for (const FConversationMessage& Message : ConversationHistory)
+	{
+		if (!Message.Role.Equals(TEXT("system"), ESearchCase::CaseSensitive))
+		{
+			AppendContentEntry(Message.Role, Message.Content, OutPayload);
+			OutPayload += TEXT(",");
+		}
+	}
+	AppendContentEntry(TEXT("user"), Prompt, OutPayload);
+	OutPayload += TEXT("]}");
+}
+
+void FGeminiPayloadBuilder::AppendCandidateCount(int32 CandidateCount, FString& InOutPayload)
+{
+	if (CandidateCount <= 1 || !InOutPayload.EndsWith(TEXT("}")))
+	{
+		return;
+	}
+
+	// Built payloads never carry a generationConfig, so it goes in as the last member
+	InOutPayload.LeftChopInline(1);
+	InOutPayload += FString::Printf(TEXT(",\"generationConfig\":{\"candidateCount\":%d}}"), CandidateCount);
+}
+
+bool FGeminiPayloadBuilder::BuildCachedContent(
+	const FString& Model,
+	const TArray<FConversationMessage>& ConversationHistory,
+	const TArray<FVFXToolFunction>& AvailableTools,
+	int32 TTLSeconds,
+	FString& OutPayload
+)
+{
+	TArray<const FString*, TInlineAllocator<2>> SystemTexts;
+	for (const FConversationMessage& Message : ConversationHistory)
+	{
+		if (Message.Role.Equals(TEXT("system"), ESearchCase::CaseSensitive))
+		{
+			SystemTexts.Add(&Message.Content);
+		}
+	}
+
+	OutPayload.Reset();
+	if (SystemTexts.Num() == 0 && AvailableTools.Num() == 0)
+	{
+		return false;
+	}
+
+	FScopeLock Lock(&Mutex);
+
+	{
+		FJsonStringAppendArchive Archive(OutPayload);
+		TSharedRef<FCondensedJsonWriter> Writer = FCondensedJsonWriterFactory::Create(&Archive);
+
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("model"), Model);
+		if (SystemTexts.Num() > 0)
+		{
+			Writer->WriteObjectStart(TEXT("systemInstruction"));
+			Writer->WriteArrayStart(TEXT("parts"));
+			for (const FString* Text : SystemTexts)
+			{
+				Writer->WriteObjectStart();
+				Writer->WriteValue(TEXT("text"), *Text);
+				Writer->WriteObjectEnd();
+			}
+			Writer->WriteArrayEnd();
+			Writer->WriteObjectEnd();
+		}
+		Writer->WriteValue(TEXT("ttl"), FString::Printf(TEXT("%ds"), TTLSeconds));
+		Writer->WriteObjectEnd();
+		Writer->Close();
+	}
+
+	// Splice the cached tools fragment in before the closing brace
+	if (AvailableTools.Num() > 0)
+	{
+		OutPayload.LeftChopInline(1);
+		AppendToolsFragment(AvailableTools, OutPayload);
+		OutPayload += TEXT("}");
+	}
+	return true;
+}
+
+void FGeminiPayloadBuilder::AppendToolsFragment(const TArray<FVFXToolFunction>& AvailableTools, FString& OutPayload)
+{
+	if (bHasToolsFragment && AreToolsEqual(CachedTools, AvailableTools))
+	{
+		++Stats.NumToolHits;
+		OutPayload += ToolsFragment;
+		return;
+	}
+	++Stats.NumToolMisses;
+
+	// Same layout as the DOM: {"tools":[{"functionDeclaration":{...}}]} under "tools"
+	ToolsFragment = TEXT(",\"tools\":");
+	{
+		FJsonStringAppendArchive Archive(ToolsFragment);
+		TSharedRef<FCondensedJsonWriter> Writer = FCondensedJsonWriterFactory::Create(&Archive);
+
+		Writer->WriteObjectStart();
+		Writer->WriteArrayStart(TEXT("tools"));
+		for (const FVFXToolFunction& Tool : AvailableTools)
+		{
+			Writer->WriteObjectStart();
+			Writer->WriteObjectStart(TEXT("functionDeclaration"));
+			Writer->WriteValue(TEXT("name"), Tool.Name);
+			Writer->WriteValue(TEXT("description"), Tool.Description);
+
+			if (Tool.Parameters.Num() > 0)
+			{
+				Writer->WriteObjectStart(TEXT("parameters"));
+				Writer->WriteObjectStart(TEXT("properties"));
+				for (const TPair<FString, FString>& Parameter : Tool.Parameters)
+				{
+					Writer->WriteObjectStart(Parameter.Key);
+					Writer->WriteValue(TEXT("type"), Parameter.Value);
+					Writer->WriteObjectEnd();
+				}
+				Writer->WriteObjectEnd();
+				Writer->WriteArrayStart(TEXT("required"));
+				Writer->WriteArrayEnd();
+				Writer->WriteValue(TEXT("type"), FString(TEXT("object")));
+				Writer->WriteObjectEnd();
+			}
+
+			Writer->WriteObjectEnd();
+			Writer->WriteObjectEnd();
+		}
+		Writer->WriteArrayEnd();
+		Writer->WriteObjectEnd();
+		Writer->Close();
+	}
+
+	CachedTools = AvailableTools;
+	bHasToolsFragment = true;
+	OutPayload += ToolsFragment;
+}
+
+void FGeminiPayloadBuilder::AppendSystemFragment(const FConversationMessage& Message, FString& OutPayload)
+{
+	for (int32 Index = 0; Index < SystemFragments.Num(); ++Index)
+	{
+		if (SystemFragments[Index].Content.Equals(Message.Content, ESearchCase::CaseSensitive))
+		{
+			++Stats.NumSystemHits;
+			OutPayload += SystemFragments[Index].Json;
+			if (Index > 0)
+			{
+				SystemFragments.Swap(Index, 0);
+			}
+			return;
+		}
+	}
+	++Stats.NumSystemMisses;
+
+	FSystemFragment Fragment;
+	Fragment.Content = Message.Content;
+	AppendContentEntry(Message.Role, Message.Content, Fragment.Json);
+	OutPayload += Fragment.Json;
+
+	if (SystemFragments.Num() >= MaxSystemFragments)
+	{
+		SystemFragments.Pop();
+	}
+	SystemFragments.Insert(MoveTemp(Fragment), 0);
+}
+
+FGeminiPayloadBuilderStats FGeminiPayloadBuilder::GetStats() const
+{
+	FScopeLock Lock(&Mutex);
+	return Stats;
+}
+
+void FGeminiPayloadBuilder::Reset()
+{
+	FScopeLock Lock(&Mutex);
+	CachedTools.Reset();
+	ToolsFragment.Reset();
+	bHasToolsFragment = false;
+	SystemFragments.Reset();
+	Stats = FGeminiPayloadBuilderStats();
+}
+
+FString FGeminiPayloadBuilder::BuildChatCompletionDOM(
+	const FString& Prompt,
+	const TArray<FConversationMessage>& ConversationHistory,
+	const TArray<FVFXToolFunction>& AvailableTools
+)
+{
+	TSharedPtr<FJsonObject> RootObject = MakeShareable(new FJsonObject);
+	
+	// Build contents array
+	TArray<TSharedPtr<FJsonValue>> ContentsArray;
+	
+	// Add conversation history
+	for (const FConversationMessage& Message : ConversationHistory)
+	{
+		TSharedPtr<FJsonObject> MessageObject = MakeShareable(new FJsonObject);
+		MessageObject->SetStringField(TEXT("role"), Message.Role);
+		
+		TSharedPtr<FJsonObject> PartObject = MakeShareable(new FJsonObject);
+		PartObject->SetStringField(TEXT("text"), Message.Content);
+		
+		TArray<TSharedPtr<FJsonValue>> PartsArray;
+		PartsArray.Add(MakeShareable(new FJsonValueObject(PartObject)));
+		
+		MessageObject->SetArrayField(TEXT("parts"), PartsArray);
+		ContentsArray.Add(MakeShareable(new FJsonValueObject(MessageObject)));
+	}
+	
+	// Add current user prompt
+	TSharedPtr<FJsonObject> UserMessage = MakeShareable(new FJsonObject);
+	UserMessage->SetStringField(TEXT("role"), TEXT("user"));
+	
+	TSharedPtr<FJsonObject> UserPart = MakeShareable(new FJsonObject);
+	UserPart->SetStringField(TEXT("text"), Prompt);
+	
+	TArray<TSharedPtr<FJsonValue>> UserPartsArray;
+	UserPartsArray.Add(MakeShareable(new FJsonValueObject(UserPart)));
+	
+	UserMessage->SetArrayField(TEXT("parts"), UserPartsArray);
+	ContentsArray.Add(MakeShareable(new FJsonValueObject(UserMessage)));
+	
+	RootObject->SetArrayField(TEXT("contents"), ContentsArray);
+	
+	// Add tools if available
+	if (AvailableTools.Num() > 0)
+	{
+		TArray<TSharedPtr<FJsonValue>> ToolsArray;
+		
+		for (const FVFXToolFunction& Tool : AvailableTools)
+		{
+			TSharedPtr<FJsonObject> ToolObject = MakeShareable(new FJsonObject);
+			TSharedPtr<FJsonObject> FunctionDeclaration = MakeShareable(new FJsonObject);
+			
+			FunctionDeclaration->SetStringField(TEXT("name"), Tool.Name);
+			FunctionDeclaration->SetStringField(TEXT("description"), Tool.Description);
+			
+			// Add parameters if available
+			if (Tool.Parameters.Num() > 0)
+			{
+				TSharedPtr<FJsonObject> ParametersObject = MakeShareable(new FJsonObject);
+				TSharedPtr<FJsonObject> PropertiesObject = MakeShareable(new FJsonObject);
+				
+				for (const auto& ParamPair : Tool.Parameters)
+				{
+					TSharedPtr<FJsonObject> ParamObject = MakeShareable(new FJsonObject);
+					ParamObject->SetStringField(TEXT("type"), ParamPair.Value);
+					PropertiesObject->SetObjectField(ParamPair.Key, ParamObject);
+				}
+				
+				TArray<FString> RequiredArray;
+				Tool.Parameters.GetKeys(RequiredArray);
+				
+				ParametersObject->SetObjectField(TEXT("properties"), PropertiesObject);
+				ParametersObject->SetArrayField(TEXT("required"), TArray<TSharedPtr<FJsonValue>>());
+				ParametersObject->SetStringField(TEXT("type"), TEXT("object"));
+				
+				FunctionDeclaration->SetObjectField(TEXT("parameters"), ParametersObject);
+			}
+			
+			ToolObject->SetObjectField(TEXT("functionDeclaration"), FunctionDeclaration);
+			ToolsArray.Add(MakeShareable(new FJsonValueObject(ToolObject)));
+		}
+		
+		TSharedPtr<FJsonObject> ToolsObject = MakeShareable(new FJsonObject);
+		ToolsObject->SetArrayField(TEXT("tools"), ToolsArray);
+		RootObject->SetObjectField(TEXT("tools"), ToolsObject);
+	}
+	
+	// Convert to JSON string
+	FString OutputString;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&OutputString);
+	FJsonSerializer::Serialize(RootObject.ToSharedRef(), Writer);
+	
+	return OutputString;
+}
@@ -0,0 +1,121 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/GeminiRequestHandle.h"
+#include "Misc/ScopeLock.h"
+
+FGeminiRequestHandle FGeminiRequestHandle::MakePending()
+{
+	FGeminiRequestHandle Handle;
+	Handle.State = MakeShared<FState, ESPMode::ThreadSafe>();
+	return Handle;
+}
+
+void FGeminiRequestHandle::Cancel()
+{
+	if (!State.IsValid())
+	{
+		return;
+	}
+
+	FHttpRequestPtr HttpRequest;
+	TArray<FGeminiRequestHandle> LinkedRequests;
+	{
+		FScopeLock Lock(&State->Mutex);
+		if (State->Status != EStatus::Pending)
+		{
+			return;
+		}
+		State->Status = EStatus::Cancelled;
+		HttpRequest = MoveTemp(State->HttpRequest);
+		LinkedRequests = MoveTemp(State->LinkedRequests);
+	}
+
+	// Outside the lock: aborting may complete the request synchronously
+	if (HttpRequest.IsValid())
+	{
+		UE_LOG(LogTemp, Log, TEXT("AINiagara: Cancelling request in flight"));
+		HttpRequest->CancelRequest();
+	}
+	for (FGeminiRequestHandle& Linked : LinkedRequests)
+	{
+		Linked.Cancel();
+	}
+}
+
+void FGeminiRequestHandle::LinkRequest(const FGeminiRequestHandle& Linked)
+{
+	if (!State.IsValid() || !Linked.IsValid() || Linked == *this)
+	{
+		return;
+	}
+
+	{
+		FScopeLock Lock(&State->Mutex);
+		if (State->Status == EStatus::Pending)
+		{
+			State->LinkedRequests.Add(Linked);
+			return;
+		}
+		if (State->Status == EStatus::Finished)
+		{
+			return;
+		}
+	}
+
+	// Already cancelled
+	FGeminiRequestHandle(Linked).Cancel();
+}
+
+bool FGeminiRequestHandle::IsCancelled() const
+{
+	if (!State.IsValid())
+	{
+		return false;
+	}
+
+	FScopeLock Lock(&State->Mutex);
+	return State->Status == EStatus::Cancelled;
+}
+
+bool FGeminiRequestHandle::IsPending() const
+{
+	if (!State.IsValid())
+	{
+		return false;
+	}
+
+	FScopeLock Lock(&State->Mutex);
+	return State->Status == EStatus::Pending;
+}
+
+void FGeminiRequestHandle::SetHttpRequest(const FHttpRequestPtr& Request)
+{
+	if (!State.IsValid())
+	{
+		return;
+	}
+
+	FScopeLock Lock(&State->Mutex);
+	if (State->Status == EStatus::Pending)
+	{
+		State->HttpRequest = Request;
+	}
+}
+
+bool FGeminiRequestHandle::TryFinish()
+{
+	if (!State.IsValid())
+	{
+		return true;
+	}
+
+	FScopeLock Lock(&State->Mutex);
+	if (State->Status != EStatus::Pending)
+	{
+		return false;
+	}
+	State->Status = EStatus::Finished;
+	State->HttpRequest.Reset();
+	State->LinkedRequests.Reset();
+	return true;
+}
@@ -0,0 +1,295 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/GeminiRequestScheduler.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/DateTime.h"
+
+namespace
+{
+	/** Heap order: higher priority first, then first come first served */
+	struct FQueueOrder
+	{
+		template <typename QueuedType>
+		bool operator()(const QueuedType& A, const QueuedType& B) const
+		{
+			return A.Priority != B.Priority ? A.Priority < B.Priority : A.Sequence < B.Sequence;
+		}
+	};
+}
+
+FGeminiRequestScheduler::FGeminiRequestScheduler()
+	: Clock([]() { return FPlatformTime::Seconds(); })
+{
+	// Imagen quotas are far lower than chat quotas; a flipbook must not burst through them
+	FGeminiEndpointLimits ImageLimits;
+	ImageLimits.MaxInFlight = 2;
+	ImageLimits.MaxRequestsPerSecond = 0.5;
+	ImageLimits.MinRequestsPerSecond = 0.05;
+	ImageLimits.Burst = 2.0;
+	ImageLimits.RecoveryPerSuccess = 0.05;
+
+	SetLimits(EGeminiEndpoint::Chat, FGeminiEndpointLimits());
+	SetLimits(EGeminiEndpoint::Image, ImageLimits);
+}
+
+FGeminiRequestScheduler::~FGeminiRequestScheduler()
+{
+	if (PumpTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PumpTickerHandle);
+	}
+}
+
+FGeminiRequestScheduler& FGeminiRequestScheduler::Get()
+{
+	// Never destroyed: in-flight callbacks and the core ticker may outlive static destruction order
+	static FGeminiRequestScheduler* Scheduler = new FGeminiRequestScheduler();
+	return *Scheduler;
+}
+
+void FGeminiRequestScheduler::Enqueue(EGeminiEndpoint Endpoint, EGeminiRequestPriority Priority, FStartRequest Start, FIsCancelled IsCancelled)
+{
+	check(IsInGameThread());
+
+	FEndpointState& State = Endpoints[static_cast<int32>(Endpoint)];
+	State.Queue.HeapPush(FQueuedRequest{ Priority, NextSequence++, Clock(), MoveTemp(Start), MoveTemp(IsCancelled) }, FQueueOrder());
+	State.Stats.QueueDepth = State.Queue.Num();
+
+	Pump();
+}
+
+void FGeminiRequestScheduler::OnRequestFinished(EGeminiEndpoint Endpoint, int32 ResponseCode, double RetryAfterSeconds)
+{
+	check(IsInGameThread());
+
+	FEndpointState& State = Endpoints[static_cast<int32>(Endpoint)];
+	State.Stats.InFlight = FMath::Max(0, State.Stats.InFlight - 1);
+
+	const double Now = Clock();
+	Refill(State, Now);
+
+	if (ResponseCode == 429)
+	{
+		// Multiplicative decrease, and nothing starts until the server's delay has passed
+		++State.Stats.NumThrottled;
+		State.RequestsPerSecond = FMath::Max(State.Limits.MinRequestsPerSecond, State.RequestsPerSecond * 0.5);
+		State.Tokens = 0.0;
+		State.BlockedUntilSeconds = FMath::Max(State.BlockedUntilSeconds, Now + RetryAfterSeconds);
+
+		UE_LOG(LogTemp, Warning, TEXT("AINiagara: Rate limited, request rate reduced to %.2f/s (retry after %.1f s, %d queued)"),
+			State.RequestsPerSecond, RetryAfterSeconds, State.Queue.Num());
+	}
+	else if (ResponseCode >= 200 && ResponseCode < 300)
+	{
+		State.RequestsPerSecond = FMath::Min(State.Limits.MaxRequestsPerSecond, State.RequestsPerSecond + State.Limits.RecoveryPerSuccess);
+	}
+	else if (RetryAfterSeconds > 0.0)
+	{
+		// 503 with Retry-After: back off without treating it as a quota signal
+		State.BlockedUntilSeconds = FMath::Max(State.BlockedUntilSeconds, Now + RetryAfterSeconds);
+	}
+
+	Pump();
+}
+
+void FGeminiRequestScheduler::Pump()
+{
+	check(IsInGameThread());
+
+	const double Now = Clock();
+
+	// Starting a request may finish it synchronously, which pumps again; start them after the bookkeeping
+	TArray<FStartRequest, TInlineAllocator<8>> ToStart;
+	for (FEndpointState& State : Endpoints)
+	{
+		Refill(State, Now);
+		DropCancelled(State);
+
+		while (State.Queue.Num() > 0
+			&& State.Stats.InFlight < State.Limits.MaxInFlight
+			&& Now >= State.BlockedUntilSeconds
+			&& State.Tokens >= 1.0)
+		{
+			FQueuedRequest Request;
+			State.Queue.HeapPop(Request, FQueueOrder());
+
+			State.Tokens -= 1.0;
+			++State.Stats.InFlight;
+			++State.Stats.NumStarted;
+
+			const double WaitSeconds = Now - Request.EnqueueSeconds;
+			State.Stats.TotalWaitSeconds += WaitSeconds;
+			State.Stats.MaxWaitSeconds = FMath::Max(State.Stats.MaxWaitSeconds, WaitSeconds);
+
+			ToStart.Add(MoveTemp(Request.Start));
+		}
+
+		State.Stats.QueueDepth = State.Queue.Num();
+	}
+
+	for (FStartRequest& Start : ToStart)
+	{
+		Start();
+	}
+
+	SchedulePump();
+}
+
+void FGeminiRequestScheduler::SetLimits(EGeminiEndpoint Endpoint, const FGeminiEndpointLimits& Limits)
+{
+	FEndpointState& State = Endpoints[static_cast<int32>(Endpoint)];
+	State.Limits = Limits;
+	State.Tokens = Limits.Burst;
+	State.RequestsPerSecond = Limits.MaxRequestsPerSecond;
+	State.LastRefillSeconds = Clock();
+	State.BlockedUntilSeconds = 0.0;
+}
+
+const FGeminiEndpointLimits& FGeminiRequestScheduler::GetLimits(EGeminiEndpoint Endpoint) const
+{
+	return Endpoints[static_cast<int32>(Endpoint)].Limits;
+}
+
+FGeminiEndpointStats FGeminiRequestScheduler::GetStats(EGeminiEndpoint Endpoint) const
+{
+	const FEndpointState& State = Endpoints[static_cast<int32>(Endpoint)];
+	FGeminiEndpointStats Stats = State.Stats;
+	Stats.RequestsPerSecond = State.RequestsPerSecond;
+
+	// Requests cancelled since the last pump are still queued but will never start
+	Stats.QueueDepth = 0;
+	for (const FQueuedRequest& Request : State.Queue)
+	{
+		Stats.QueueDepth += (Request.IsCancelled && Request.IsCancelled()) ? 0 : 1;
+	}
+	return Stats;
+}
+
+void FGeminiRequestScheduler::ResetStats()
+{
+	for (FEndpointState& State : Endpoints)
+	{
+		const int32 InFlight = State.Stats.InFlight;
+		State.Stats = FGeminiEndpointStats();
+		State.Stats.InFlight = InFlight;
+		State.Stats.QueueDepth = State.Queue.Num();
+		State.Tokens = State.Limits.Burst;
+		State.RequestsPerSecond = State.Limits.MaxRequestsPerSecond;
+		State.LastRefillSeconds = Clock();
+		State.BlockedUntilSeconds = 0.0;
+	}
+}
+
+void FGeminiRequestScheduler::SetClock(TFunction<double()> InClock)
+{
+	Clock = MoveTemp(InClock);
+	for (FEndpointState& State : Endpoints)
+	{
+		State.LastRefillSeconds = Clock();
+		State.BlockedUntilSeconds = 0.0;
+	}
+}
+
+void FGeminiRequestScheduler::SetAutoPump(bool bInAutoPump)
+{
+	bAutoPump = bInAutoPump;
+	if (!bAutoPump && PumpTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PumpTickerHandle);
+		PumpTickerHandle.Reset();
+	}
+}
+
+double FGeminiRequestScheduler::ParseRetryAfter(const FString& HeaderValue)
+{
+	const FString Value = HeaderValue.TrimStartAndEnd();
+	if (Value.IsEmpty())
+	{
+		return 0.0;
+	}
+
+	if (Value.IsNumeric())
+	{
+		return FMath::Max(0.0, FCString::Atod(*Value));
+	}
+
+	FDateTime RetryTime;
+	if (FDateTime::ParseHttpDate(Value, RetryTime))
+	{
+		return FMath::Max(0.0, (RetryTime - FDateTime::UtcNow()).GetTotalSeconds());
+	}
+
+	return 0.0;
+}
+
+void FGeminiRequestScheduler::DropCancelled(FEndpointState& State)
+{
+	// Sweep the whole queue, not just the top, so buried cancelled requests stop counting as waiting
+	const int32 NumRemoved = State.Queue.RemoveAll([](const FQueuedRequest& Request)
+	{
+		return Request.IsCancelled && Request.IsCancelled();
+	});
+	if (NumRemoved > 0)
+	{
+		State.Queue.Heapify(FQueueOrder());
+	}
+}
+
+void FGeminiRequestScheduler::Refill(FEndpointState& State, double Now) const
+{
+	const double Elapsed = FMath::Max(0.0, Now - State.LastRefillSeconds);
+	State.Tokens = FMath::Min(State.Limits.Burst, State.Tokens + Elapsed * State.RequestsPerSecond);
+	State.LastRefillSeconds = Now;
+}
+
+double FGeminiRequestScheduler::GetNextStartDelay(const FEndpointState& State, double Now) const
+{
+	// A request finishing pumps again, so a full endpoint needs no timer
+	if (State.Queue.Num() == 0 || State.Stats.InFlight >= State.Limits.MaxInFlight)
+	{
+		return -1.0;
+	}
+
+	const double TokenDelay = State.Tokens >= 1.0 ? 0.0 : (1.0 - State.Tokens) / FMath::Max(State.RequestsPerSecond, UE_SMALL_NUMBER);
+	return FMath::Max3(0.0, State.BlockedUntilSeconds - Now, TokenDelay);
+}
+
+void FGeminiRequestScheduler::SchedulePump()
+{
+	if (!bAutoPump)
+	{
+		return;
+	}
+
+	const double Now = Clock();
+	double Delay = -1.0;
+	for (const FEndpointState& State : Endpoints)
+	{
+		const double EndpointDelay = GetNextStartDelay(State, Now);
+		if (EndpointDelay >= 0.0 && (Delay < 0.0 || EndpointDelay < Delay))
+		{
+			Delay = EndpointDelay;
+		}
+	}
+
+	if (PumpTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PumpTickerHandle);
+		PumpTickerHandle.Reset();
+	}
+
+	if (Delay < 0.0)
+	{
+		return;
+	}
+
+	PumpTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateLambda([this](float DeltaTime) -> bool
+		{
+			PumpTickerHandle.Reset();
+			Pump();
+			return false; // Don't repeat
+		}),
+		static_cast<float>(Delay)
+	);
+}
@@ -0,0 +1,376 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/GeminiResponseCache.h"
+#include "Core/AINiagaraSettings.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Guid.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/SecureHash.h"
+
+namespace
+{
+	const TCHAR* CacheEntryExtension = TEXT(".json");
+
+	void DeleteFiles(const TArray<FString>& Paths)
+	{
+		for (const FString& Path : Paths)
+		{
+			IFileManager::Get().Delete(*Path);
+		}
+	}
+}
+
+FGeminiResponseCache::FGeminiResponseCache(const FString& InDirectory, int64 InMaxBytes)
+	: MaxBytes(InMaxBytes)
+{
+	SetDirectory(InDirectory);
+}
+
+FGeminiResponseCache& FGeminiResponseCache::Get()
+{
+	// Never destroyed: replies may still be stored from in-flight callbacks during shutdown
+	static FGeminiResponseCache* Cache = []()
+	{
+		int64 MaxBytes = 256ll * 1024 * 1024;
+		EGeminiResponseCacheMode Mode = EGeminiResponseCacheMode::Disabled;
+		if (UAINiagaraSettings* Settings = UAINiagaraSettings::Get())
+		{
+			MaxBytes = static_cast<int64>(FMath::Max(1, Settings->GetResponseCacheMaxSizeMB())) * 1024 * 1024;
+			if (Settings->IsResponseCacheEnabled())
+			{
+				Mode = Settings->IsResponseCacheReplayOnly() ? EGeminiResponseCacheMode::ReplayOnly : EGeminiResponseCacheMode::ReadWrite;
+			}
+		}
+
+		FString ModeText;
+		if (FParse::Value(FCommandLine::Get(), TEXT("-AINiagaraResponseCache="), ModeText) && !ParseMode(ModeText, Mode))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("AINiagara: Unknown response cache mode '%s', expected off, on or replay"), *ModeText);
+		}
+
+		FGeminiResponseCache* NewCache = new FGeminiResponseCache(GetDefaultDirectory(), MaxBytes);
+		NewCache->SetMode(Mode);
+		return NewCache;
+	}();
+	return *Cache;
+}
+
+FString FGeminiResponseCache::GetDefaultDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("AINiagara") / TEXT("ResponseCache");
+}
+
+FString FGeminiResponseCache::MakeKey(const FString& Endpoint, const FString& Payload)
+{
+	const FTCHARToUTF8 EndpointUTF8(*Endpoint);
+	const FTCHARToUTF8 PayloadUTF8(*Payload);
+	const uint8 Separator = '\n';
+
+	FSHA1 Sha;
+	Sha.Update(reinterpret_cast<const uint8*>(EndpointUTF8.Get()), EndpointUTF8.Length());
+	Sha.Update(&Separator, 1);
+	Sha.Update(reinterpret_cast<const uint8*>(PayloadUTF8.Get()), PayloadUTF8.Length());
+	Sha.Final();
+
+	FSHAHash Hash;
+	Sha.GetHash(Hash.Hash);
+	return Hash.ToString();
+}
+
+bool FGeminiResponseCache::Contains(const FString& Key)
+{
+	FScopeLock Lock(&Mutex);
+
+	if (!Entries.Contains(Key))
+	{
+		++Stats.NumMisses;
+		return false;
+	}
+	return true;
+}
+
+bool FGeminiResponseCache::Find(const FString& Key, FString& OutBody)
+{
+	FString Path;
+	{
+		FScopeLock Lock(&Mutex);
+
+		FEntry* Entry = Entries.Find(Key);
+		if (!Entry)
+		{
+			++Stats.NumMisses;
+			return false;
+		}
+
+		Entry->LastUse = ++NextUse;
+		Path = GetEntryPath(Key);
+	}
+
+	// Entries are replaced by moving a complete file in place, so the read sees either the old or the new reply
+	const bool bLoaded = FFileHelper::LoadFileToString(OutBody, *Path);
+	if (bLoaded)
+	{
+		IFileManager::Get().SetTimeStamp(*Path, FDateTime::UtcNow());
+	}
+
+	FScopeLock Lock(&Mutex);
+	if (!bLoaded)
+	{
+		// Deleted behind our back, or evicted while we were reading
+		if (const FEntry* Entry = Entries.Find(Key))
+		{
+			Stats.TotalBytes -= Entry->Size;
+			Entries.Remove(Key);
+		}
+		++Stats.NumMisses;
+		return false;
+	}
+
+	++Stats.NumHits;
+	return true;
+}
+
+void FGeminiResponseCache::Store(const FString& Key, const FString& Body)
+{
+	FString Path;
+	{
+		FScopeLock Lock(&Mutex);
+		Path = GetEntryPath(Key);
+	}
+
+	// Write next to the entry and move it in place, so a crash never leaves a truncated reply behind.
+	// The temp name is unique so concurrent stores of the same key never share a file.
+	const FString TempPath = FString::Printf(TEXT("%s.%s.tmp"), *Path, *FGuid::NewGuid().ToString());
+	if (!FFileHelper::SaveStringToFile(Body, *TempPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM)
+		|| !IFileManager::Get().Move(*Path, *TempPath, true))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("AINiagara: Failed to write response cache entry %s"), *Path);
+		IFileManager::Get().Delete(*TempPath);
+		return;
+	}
+	const int64 Size = IFileManager::Get().FileSize(*Path);
+
+	TArray<FString> Victims;
+	{
+		FScopeLock Lock(&Mutex);
+
+		FEntry& Entry = Entries.FindOrAdd(Key);
+		Stats.TotalBytes -= Entry.Size;
+		Entry.Size = Size;
+		Entry.LastUse = ++NextUse;
+		Stats.TotalBytes += Entry.Size;
+
+		Evict(Victims);
+	}
+
+	DeleteFiles(Victims);
+}
+
+void FGeminiResponseCache::Clear()
+{
+	TArray<FString> Paths;
+	{
+		FScopeLock Lock(&Mutex);
+
+		Paths.Reserve(Entries.Num());
+		for (const TPair<FString, FEntry>& Pair : Entries)
+		{
+			Paths.Add(GetEntryPath(Pair.Key));
+		}
+		Entries.Reset();
+		Stats = FGeminiResponseCacheStats();
+	}
+
+	DeleteFiles(Paths);
+}
+
+void FGeminiResponseCache::SetDirectory(const FString& InDirectory)
+{
+	TArray<FString> Victims;
+	{
+		FScopeLock Lock(&Mutex);
+
+		Directory = InDirectory;
+		IFileManager::Get().MakeDirectory(*Directory, true);
+		LoadIndex();
+		Evict(Victims);
+	}
+
+	DeleteFiles(Victims);
+}
+
+void FGeminiResponseCache::SetMaxBytes(int64 InMaxBytes)
+{
+	TArray<FString> Victims;
+	{
+		FScopeLock Lock(&Mutex);
+
+		MaxBytes = InMaxBytes;
+		Evict(Victims);
+	}
+
+	DeleteFiles(Victims);
+}
+
+void FGeminiResponseCache::SetMode(EGeminiResponseCacheMode InMode)
+{
+	if (Mode.exchange(InMode) != InMode)
+	{
+		UE_LOG(LogTemp, Log, TEXT("AINiagara: Response cache %s (%s)"), LexToString(InMode), *GetDirectory());
+	}
+}
+
+EGeminiResponseCacheMode FGeminiResponseCache::GetMode() const
+{
+	return Mode.load();
+}
+
+FGeminiResponseCacheStats FGeminiResponseCache::GetStats() const
+{
+	FScopeLock Lock(&Mutex);
+
+	FGeminiResponseCacheStats Result = Stats;
+	Result.NumEntries = Entries.Num();
+	return Result;
+}
+
+bool FGeminiResponseCache::ParseMode(const FString& Text, EGeminiResponseCacheMode& OutMode)
+{
+	if (Text.Equals(TEXT("off"), ESearchCase::IgnoreCase))
+	{
+		OutMode = EGeminiResponseCacheMode::Disabled;
+	}
+	else if (Text.Equals(TEXT("on"), ESearchCase::IgnoreCase))
+	{
+		OutMode = EGeminiResponseCacheMode::ReadWrite;
+	}
+	else if (Text.Equals(TEXT("replay"), ESearchCase::IgnoreCase))
+	{
+		OutMode = EGeminiResponseCacheMode::ReplayOnly;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+const TCHAR* FGeminiResponseCache::LexToString(EGeminiResponseCacheMode InMode)
+{
+	switch (InMode)
+	{
+	case EGeminiResponseCacheMode::ReadWrite:
+		return TEXT("on");
+	case EGeminiResponseCacheMode::ReplayOnly:
+		return TEXT("replay");
+	default:
+		return TEXT("off");
+	}
+}
+
+void FGeminiResponseCache::RegisterConsoleCommands()
+{
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("AINiagara.ResponseCache"),
+		TEXT("Control the Gemini response cache: off | on | replay | clear | stats"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&FGeminiResponseCache::ConsoleCommand_ResponseCache),
+		ECVF_Default
+	);
+}
+
+void FGeminiResponseCache::ConsoleCommand_ResponseCache(const TArray<FString>& Args)
+{
+	FGeminiResponseCache& Cache = Get();
+	const FString Command = Args.Num() > 0 ? Args[0] : TEXT("stats");
+
+	EGeminiResponseCacheMode NewMode;
+	if (ParseMode(Command, NewMode))
+	{
+		Cache.SetMode(NewMode);
+	}
+	else if (Command.Equals(TEXT("clear"), ESearchCase::IgnoreCase))
+	{
+		Cache.Clear();
+	}
+	else if (!Command.Equals(TEXT("stats"), ESearchCase::IgnoreCase))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("AINiagara: Usage: AINiagara.ResponseCache off | on | replay | clear | stats"));
+		return;
+	}
+
+	const FGeminiResponseCacheStats CacheStats = Cache.GetStats();
+	UE_LOG(LogTemp, Log, TEXT("AINiagara: Response cache %s - %d entries, %.1f MB, %d hits, %d misses, %d evictions (%s)"),
+		LexToString(Cache.GetMode()), CacheStats.NumEntries, CacheStats.TotalBytes / (1024.0 * 1024.0),
+		CacheStats.NumHits, CacheStats.NumMisses, CacheStats.NumEvictions, *Cache.GetDirectory());
+}
+
+FString FGeminiResponseCache::GetEntryPath(const FString& Key) const
+{
+	return Directory / (Key + CacheEntryExtension);
+}
+
+void FGeminiResponseCache::LoadIndex()
+{
+	struct FFoundEntry
+	{
+		FString Key;
+		int64 Size;
+		FDateTime Timestamp;
+	};
+
+	TArray<FFoundEntry> Found;
+	IFileManager::Get().IterateDirectoryStat(*Directory, [&Found](const TCHAR* Filename, const FFileStatData& StatData)
+	{
+		const FString Path(Filename);
+		if (!StatData.bIsDirectory && Path.EndsWith(CacheEntryExtension))
+		{
+			Found.Add(FFoundEntry{ FPaths::GetBaseFilename(Path), StatData.FileSize, StatData.ModificationTime });
+		}
+		return true;
+	});
+
+	// Hits refresh the timestamp, so the oldest file is the least recently used
+	Found.Sort([](const FFoundEntry& A, const FFoundEntry& B) { return A.Timestamp < B.Timestamp; });
+
+	Entries.Reset();
+	Stats = FGeminiResponseCacheStats();
+	for (const FFoundEntry& Entry : Found)
+	{
+		Entries.Add(Entry.Key, FEntry{ Entry.Size, ++NextUse });
+		Stats.TotalBytes += Entry.Size;
+	}
+}
+
+void FGeminiResponseCache::Evict(TArray<FString>& OutVictims)
+{
+	if (Stats.TotalBytes <= MaxBytes)
+	{
+		return;
+	}
+
+	TArray<TPair<uint64, FString>> ByUse;
+	ByUse.Reserve(Entries.Num());
+	for (const TPair<FString, FEntry>& Pair : Entries)
+	{
+		ByUse.Emplace(Pair.Value.LastUse, Pair.Key);
+	}
+	ByUse.Sort([](const TPair<uint64, FString>& A, const TPair<uint64, FString>& B) { return A.Key < B.Key; });
+
+	for (const TPair<uint64, FString>& Oldest : ByUse)
+	{
+		if (Stats.TotalBytes <= MaxBytes)
+		{
+			break;
+		}
+
+		Stats.TotalBytes -= Entries.FindChecked(Oldest.Value).Size;
+		Entries.Remove(Oldest.Value);
+		OutVictims.Add(GetEntryPath(Oldest.Value));
+		++Stats.NumEvictions;
+	}
+}
@@ -0,0 +1,98 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/GeminiRetryPolicy.h"
+#include "Core/GeminiMetrics.h"
+#include "Misc/ScopeLock.h"
+
+FGeminiRetryPolicy FGeminiRetryPolicy::NoRetry()
+{
+	FGeminiRetryPolicy Policy;
+	Policy.MaxAttempts = 1;
+	return Policy;
+}
+
+bool FGeminiRetryPolicy::IsRetryable(int32 ResponseCode, bool bReceivedResponse)
+{
+	if (!bReceivedResponse)
+	{
+		return true;
+	}
+
+	return ResponseCode == 408
+		|| ResponseCode == 429
+		|| (ResponseCode >= 500 && ResponseCode != 501);
+}
+
+double FGeminiRetryPolicy::GetDelay(int32 RetryIndex, double RetryAfterSeconds, FRandomStream& Random) const
+{
+	if (RetryAfterSeconds > MaxDelaySeconds)
+	{
+		return -1.0;
+	}
+
+	const double Backoff = FMath::Min(MaxDelaySeconds, InitialDelaySeconds * FMath::Pow(Multiplier, static_cast<double>(RetryIndex)));
+	const double Delay = bUseJitter ? Random.FRand() * Backoff : Backoff;
+
+	return FMath::Max(Delay, RetryAfterSeconds);
+}
+
+FGeminiHedgePolicy FGeminiHedgePolicy::AtPercentile(double InPercentile)
+{
+	FGeminiHedgePolicy Policy;
+	Policy.Percentile = InPercentile;
+	return Policy;
+}
+
+double FGeminiHedgePolicy::GetDelay(const FString& Endpoint) const
+{
+	if (!IsEnabled())
+	{
+		return -1.0;
+	}
+
+	double Delay = DefaultDelaySeconds;
+	FGeminiMetricsRegistry::Get().GetLatencyPercentile(Endpoint, Percentile, MinSamples, Delay);
+	return FMath::Clamp(Delay, MinDelaySeconds, MaxDelaySeconds);
+}
+
+FGeminiRetryBudget::FGeminiRetryBudget(double InMaxBalance, double InDepositPerRequest)
+	: MaxBalance(InMaxBalance)
+	, DepositPerRequest(InDepositPerRequest)
+	, Balance(InMaxBalance)
+{
+}
+
+FGeminiRetryBudget& FGeminiRetryBudget::Get()
+{
+	static FGeminiRetryBudget Budget;
+	return Budget;
+}
+
+void FGeminiRetryBudget::OnRequest()
+{
+	FScopeLock Lock(&Mutex);
+	Balance = FMath::Min(MaxBalance, Balance + DepositPerRequest);
+}
+
+bool FGeminiRetryBudget::TryWithdraw()
+{
+	FScopeLock Lock(&Mutex);
+	if (Balance < 1.0)
+	{
+		return false;
+	}
+	Balance -= 1.0;
+	return true;
+}
+
+double FGeminiRetryBudget::GetBalance() const
+{
+	FScopeLock Lock(&Mutex);
+	return Balance;
+}
+
+void FGeminiRetryBudget::Reset()
+{
+	FScopeLock Lock(&Mutex);
+	Balance = MaxBalance;
+}
@@ -0,0 +1,156 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/GeminiSSEParser.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+int32 FGeminiSSEParser::AppendBytes(TConstArrayView<uint8> Bytes, TArray<FString>& OutEvents)
+{
+	const int32 NumEventsBefore = OutEvents.Num();
+
+	int32 LineStart = 0;
+	for (int32 Index = 0; Index < Bytes.Num(); ++Index)
+	{
+		if (Bytes[Index] != '\n')
+		{
+			continue;
+		}
+
+		// '\n' never occurs inside a multi-byte UTF-8 sequence, so every line is complete text
+		if (LineBuffer.Num() > 0)
+		{
+			LineBuffer.Append(Bytes.GetData() + LineStart, Index - LineStart);
+			ProcessLine(reinterpret_cast<const ANSICHAR*>(LineBuffer.GetData()), LineBuffer.Num(), OutEvents);
+			LineBuffer.Reset();
+		}
+		else
+		{
+			ProcessLine(reinterpret_cast<const ANSICHAR*>(Bytes.GetData() + LineStart), Index - LineStart, OutEvents);
+		}
+		LineStart = Index + 1;
+	}
+
+	if (LineStart < Bytes.Num())
+	{
+		LineBuffer.Append(Bytes.GetData() + LineStart, Bytes.Num() - LineStart);
+	}
+
+	return OutEvents.Num() - NumEventsBefore;
+}
+
+int32 FGeminiSSEParser::Flush(TArray<FString>& OutEvents)
+{
+	const int32 NumEventsBefore = OutEvents.Num();
+
+	if (LineBuffer.Num() > 0)
+	{
+		ProcessLine(reinterpret_cast<const ANSICHAR*>(LineBuffer.GetData()), LineBuffer.Num(), OutEvents);
+		LineBuffer.Reset();
+	}
+
+	// End of stream ends the pending event
+	ProcessLine(nullptr, 0, OutEvents);
+
+	return OutEvents.Num() - NumEventsBefore;
+}
+
+void FGeminiSSEParser::Reset()
+{
+	LineBuffer.Reset();
+	EventData.Reset();
+	bHasData = false;
+}
+
+void FGeminiSSEParser::ProcessLine(const ANSICHAR* Line, int32 Length, TArray<FString>& OutEvents)
+{
+	if (Length > 0 && Line[Length - 1] == '\r')
+	{
+		--Length;
+	}
+
+	// A blank line dispatches the event
+	if (Length == 0)
+	{
+		if (bHasData)
+		{
+			OutEvents.Add(MoveTemp(EventData));
+			EventData.Reset();
+			bHasData = false;
+		}
+		return;
+	}
+
+	// Comment (keep-alive)
+	if (Line[0] == ':')
+	{
+		return;
+	}
+
+	static constexpr int32 DataFieldLength = 5;
+	if (Length < DataFieldLength || FCStringAnsi::Strncmp(Line, "data:", DataFieldLength) != 0)
+	{
+		return;
+	}
+
+	int32 ValueStart = DataFieldLength;
+	if (ValueStart < Length && Line[ValueStart] == ' ')
+	{
+		++ValueStart;
+	}
+
+	if (bHasData)
+	{
+		EventData.AppendChar(TEXT('\n'));
+	}
+
+	const FUTF8ToTCHAR Converted(Line + ValueStart, Length - ValueStart);
+	EventData.AppendChars(Converted.Get(), Converted.Length());
+	bHasData = true;
+}
+
+bool FGeminiSSEParser::ParseEvent(const FString& EventData, FString& OutText, FString& OutFinishReason)
+{
+	OutText.Reset();
+	OutFinishReason.Reset();
+
+	TSharedPtr<FJsonObject> JsonObject;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(EventData);
+	if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid())
+	{
+		return false;
+	}
+
+	// Usage-only events carry no candidates
+	const TArray<TSharedPtr<FJsonValue>>* CandidatesArray;
+	if (!JsonObject->TryGetArrayField(TEXT("candidates"), CandidatesArray) || CandidatesArray->Num() == 0)
+	{
+		return true;
+	}
+
+	const TSharedPtr<FJsonObject> CandidateObject = (*CandidatesArray)[0]->AsObject();
+	if (!CandidateObject.IsValid())
+	{
+		return true;
+	}
+
+	CandidateObject->TryGetStringField(TEXT("finishReason"), OutFinishReason);
+
+	const TSharedPtr<FJsonObject>* ContentObject;
+	const TArray<TSharedPtr<FJsonValue>>* PartsArray;
+	if (CandidateObject->TryGetObjectField(TEXT("content"), ContentObject) &&
+		(*ContentObject)->TryGetArrayField(TEXT("parts"), PartsArray))
+	{
+		for (const TSharedPtr<FJsonValue>& PartValue : *PartsArray)
+		{
+			const TSharedPtr<FJsonObject> PartObject = PartValue->AsObject();
+			FString PartText;
+			if (PartObject.IsValid() && PartObject->TryGetStringField(TEXT("text"), PartText))
+			{
+				OutText += PartText;
+			}
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,28 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/LLMBackend.h"
+#include "Core/AINiagaraSettings.h"
+#include "Core/GeminiAPIClient.h"
+#include "Core/OpenAICompatibleClient.h"
+
+TSharedRef<ILLMBackend, ESPMode::ThreadSafe> ILLMBackend::Create(ELLMTask Task)
+{
+	const UAINiagaraSettings* Settings = UAINiagaraSettings::Get();
+	if (!Settings)
+	{
+		return MakeShared<FGeminiAPIClient, ESPMode::ThreadSafe>();
+	}
+
+	// Only fresh effect design needs the large model; repairs and tool requests are routed by their tier
+	const FString Model = Settings->GetChatModelForTask(Task);
+	if (Settings->GetBackendForTask(Task) == ELLMBackendType::OpenAICompatible)
+	{
+		TSharedRef<FOpenAICompatibleClient, ESPMode::ThreadSafe> Client = MakeShared<FOpenAICompatibleClient, ESPMode::ThreadSafe>();
+		Client->SetChatModel(Model);
+		return Client;
+	}
+
+	TSharedRef<FGeminiAPIClient, ESPMode::ThreadSafe> Client = MakeShared<FGeminiAPIClient, ESPMode::ThreadSafe>();
+	Client->SetChatModel(Model);
+	return Client;
+}
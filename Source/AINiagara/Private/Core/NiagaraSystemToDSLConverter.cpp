@@ -130,8 +130,7 @@ bool UNiagaraSystemToDSLConverter::ExportDSLToJSON(
 	FString& OutJson,
 	bool bPrettyPrint)
 {
-	// Use the parser's ToJSON method
-	return UVFXDSLParser::ToJSON(DSL, OutJson);
+	return UVFXDSLParser::ToJSONWithFormat(DSL, bPrettyPrint ? EVFXDSLJsonFormat::Pretty : EVFXDSLJsonFormat::Condensed, OutJson);
 }
 
 bool UNiagaraSystemToDSLConverter::ExportDSLToFile(
@@ -0,0 +1,850 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/OpenAICompatibleClient.h"
+#include "Core/AINiagaraSettings.h"
+#include "Core/GeminiSSEParser.h"
+#include "Core/GeminiMetrics.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "HAL/PlatformTime.h"
+#include "Async/Async.h"
+#include "Tasks/Task.h"
+
+const FString FOpenAICompatibleClient::ChatCompletionsEndpoint = TEXT("/chat/completions");
+const FString FOpenAICompatibleClient::ImageGenerationsEndpoint = TEXT("/images/generations");
+
+namespace
+{
+	using FCondensedWriterFactory = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>;
+
+	/**
+	 * State shared by the callbacks of one streamed request. The callbacks hold it
+	 * by reference count, so it outlives the client that sent the request.
+	 */
+	struct FOpenAIStreamState
+	{
+		FGeminiSSEParser Parser;
+
+		/** Scratch list of completed events */
+		TArray<FString> Events;
+
+		/** Response body bytes already handed to the parser */
+		int64 ConsumedBytes = 0;
+
+		/** When the request was sent, and when its first byte arrived (negative until then) */
+		double StartSeconds = 0.0;
+		double FirstByteSeconds = -1.0;
+
+		FGeminiStreamStats Stats;
+
+		/** Text of all chunks so far */
+		FString ResponseText;
+
+		FString FinishReason;
+
+		/** Model the request went to, for the metrics */
+		FString Model;
+
+		/** Pieces of a streamed tool call, joined as they arrive */
+		FString ToolName;
+		FString ToolArguments;
+
+		FOnGeminiStreamChunk OnChunk;
+	};
+
+	/**
+	 * Parse the body bytes received since the last call and report the new text chunks
+	 * @param bEndOfStream Whether Content is the complete body
+	 */
+	void ConsumeStreamBody(FOpenAIStreamState& State, const TArray<uint8>& Content, bool bEndOfStream)
+	{
+		if (Content.Num() > State.ConsumedBytes)
+		{
+			State.Parser.AppendBytes(MakeArrayView(Content.GetData() + State.ConsumedBytes, Content.Num() - State.ConsumedBytes), State.Events);
+			State.ConsumedBytes = Content.Num();
+		}
+		if (bEndOfStream)
+		{
+			State.Parser.Flush(State.Events);
+		}
+
+		for (const FString& EventData : State.Events)
+		{
+			FString ChunkText;
+			FString FinishReason;
+			FString ToolName;
+			FString ToolArguments;
+			if (!FOpenAICompatibleClient::ParseStreamEvent(EventData, ChunkText, FinishReason, ToolName, ToolArguments))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("AINiagara: Ignoring malformed stream event: %s"), *EventData.Left(200));
+				continue;
+			}
+
+			State.ToolName += ToolName;
+			State.ToolArguments += ToolArguments;
+			if (!FinishReason.IsEmpty())
+			{
+				State.FinishReason = FinishReason;
+			}
+			if (ChunkText.IsEmpty())
+			{
+				continue;
+			}
+
+			const double Elapsed = FPlatformTime::Seconds() - State.StartSeconds;
+			if (State.Stats.NumChunks == 0)
+			{
+				State.Stats.FirstChunkSeconds = Elapsed;
+			}
+			++State.Stats.NumChunks;
+			State.Stats.ReceivedBytes = State.ConsumedBytes;
+			State.Stats.ElapsedSeconds = Elapsed;
+
+			State.ResponseText += ChunkText;
+			State.OnChunk.ExecuteIfBound(ChunkText, State.Stats);
+		}
+		State.Events.Reset();
+	}
+
+	/**
+	 * Wrap the delegates of a request so its outcome is delivered at most once,
+	 * and not at all once the request has been cancelled
+	 */
+	void GuardDelegates(const FGeminiRequestHandle& Handle, FOnGeminiResponse& OnResponse, FOnGeminiError& OnError)
+	{
+		OnResponse = FOnGeminiResponse::CreateLambda([Handle, Inner = OnResponse](const FString& ResponseText) mutable
+		{
+			if (Handle.TryFinish())
+			{
+				Inner.ExecuteIfBound(ResponseText);
+			}
+		});
+		OnError = FOnGeminiError::CreateLambda([Handle, Inner = OnError](int32 ErrorCode, const FString& ErrorMessage) mutable
+		{
+			if (Handle.TryFinish())
+			{
+				Inner.ExecuteIfBound(ErrorCode, ErrorMessage);
+			}
+		});
+	}
+
+	/** Delegates always run on the game thread */
+	void RunOnGameThread(TUniqueFunction<void()> Function)
+	{
+		if (IsInGameThread())
+		{
+			Function();
+		}
+		else
+		{
+			AsyncTask(ENamedThreads::GameThread, MoveTemp(Function));
+		}
+	}
+
+	/** Report a failed request on the game thread */
+	void DeliverError(const FOnGeminiError& OnError, int32 ErrorCode, const FString& ErrorMessage)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("AINiagara: %s"), *ErrorMessage.Left(200));
+		RunOnGameThread([OnError, ErrorCode, ErrorMessage]()
+		{
+			OnError.ExecuteIfBound(ErrorCode, ErrorMessage);
+		});
+	}
+
+	/** Error message of a failed request; OpenAI-style servers answer {"error":{"message":"..."}} */
+	FString DescribeError(bool bWasSuccessful, const FHttpResponsePtr& Response)
+	{
+		if (!bWasSuccessful || !Response.IsValid())
+		{
+			return TEXT("Network error: the OpenAI-compatible server did not answer. Check that it is running at the configured URL.");
+		}
+
+		const int32 ResponseCode = Response->GetResponseCode();
+		const FString Body = Response->GetContentAsString();
+
+		FString Message;
+		TSharedPtr<FJsonObject> JsonObject;
+		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Body);
+		if (FJsonSerializer::Deserialize(Reader, JsonObject) && JsonObject.IsValid())
+		{
+			const TSharedPtr<FJsonObject>* ErrorObject;
+			if (JsonObject->TryGetObjectField(TEXT("error"), ErrorObject))
+			{
+				(*ErrorObject)->TryGetStringField(TEXT("message"), Message);
+			}
+			else
+			{
+				// Some servers (Ollama) put the message directly under "error"
+				JsonObject->TryGetStringField(TEXT("error"), Message);
+			}
+		}
+		if (Message.IsEmpty())
+		{
+			Message = Body.IsEmpty() ? FString::Printf(TEXT("Request failed with status code %d"), ResponseCode) : Body.Left(200);
+		}
+
+		if (ResponseCode == 401 || ResponseCode == 403)
+		{
+			return FString::Printf(TEXT("Unauthorized: the OpenAI-compatible server rejected the API key (%s)"), *Message);
+		}
+		return FString::Printf(TEXT("OpenAI-compatible server error (%d): %s"), ResponseCode, *Message);
+	}
+
+	/** A POST of a JSON body to the server */
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> CreateRequest(const FString& URL, const FString& APIKey, const FString& Payload)
+	{
+		TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+		Request->SetURL(URL);
+		Request->SetVerb(TEXT("POST"));
+		Request->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
+		if (!APIKey.IsEmpty())
+		{
+			Request->SetHeader(TEXT("Authorization"), TEXT("Bearer ") + APIKey);
+		}
+		Request->SetContentAsString(Payload);
+		return Request;
+	}
+
+	/** Timings and sizes of a finished request; it is sent once, without queueing */
+	FGeminiRequestMetrics MakeMetrics(const FString& Endpoint, const FString& Model, double StartSeconds, double FirstByteSeconds, const FHttpRequestPtr& Request, const FHttpResponsePtr& Response)
+	{
+		const double Now = FPlatformTime::Seconds();
+
+		FGeminiRequestMetrics Metrics;
+		Metrics.Endpoint = Endpoint;
+		Metrics.Model = Model;
+		Metrics.ResponseCode = Response.IsValid() ? Response->GetResponseCode() : 0;
+		Metrics.NumAttempts = 1;
+		Metrics.TimeToFirstByteSeconds = (FirstByteSeconds >= 0.0 ? FirstByteSeconds : Now) - StartSeconds;
+		Metrics.TotalSeconds = Now - StartSeconds;
+		Metrics.RequestBytes = Request.IsValid() ? Request->GetContent().Num() : 0;
+		Metrics.ResponseBytes = Response.IsValid() ? Response->GetContent().Num() : 0;
+		return Metrics;
+	}
+
+	/** Complete the metrics of a finished request from its parsed reply and record them */
+	void RecordMetrics(FGeminiRequestMetrics Metrics, const FGeminiResponse* Response)
+	{
+		Metrics.Timestamp = FDateTime::UtcNow();
+		if (Response)
+		{
+			Metrics.PromptTokens = Response->PromptTokens;
+			Metrics.OutputTokens = Response->OutputTokens;
+			Metrics.CachedTokens = Response->CachedTokens;
+			Metrics.TotalTokens = Response->TotalTokens;
+			Metrics.FinishReason = Response->FinishReason;
+		}
+		FGeminiMetricsRegistry::Get().Record(Metrics);
+	}
+
+	/** Tool name a declared function name stands for */
+	FString RestoreToolName(const FString& FunctionName, const TArray<FVFXToolFunction>& AvailableTools)
+	{
+		for (const FVFXToolFunction& Tool : AvailableTools)
+		{
+			if (FOpenAICompatibleClient::ToFunctionName(Tool.Name) == FunctionName)
+			{
+				return Tool.Name;
+			}
+		}
+		return FunctionName;
+	}
+
+	/** Arguments of a tool call, which the API sends as a JSON string */
+	TSharedPtr<FJsonObject> ParseToolArguments(const FString& Arguments)
+	{
+		TSharedPtr<FJsonObject> Args;
+		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Arguments);
+		FJsonSerializer::Deserialize(Reader, Args);
+		return Args;
+	}
+
+	/** A tool call in the {"functionCall":{"name":...,"args":{...}}} form FVFXResponseDispatcher reads */
+	FString MakeFunctionCallText(const FString& Name, const TSharedPtr<FJsonObject>& Args)
+	{
+		TSharedRef<FJsonObject> FunctionCall = MakeShared<FJsonObject>();
+		FunctionCall->SetStringField(TEXT("name"), Name);
+		FunctionCall->SetObjectField(TEXT("args"), Args.IsValid() ? Args : TSharedPtr<FJsonObject>(MakeShared<FJsonObject>()));
+
+		TSharedRef<FJsonObject> Wrapper = MakeShared<FJsonObject>();
+		Wrapper->SetObjectField(TEXT("functionCall"), FunctionCall);
+
+		FString Text;
+		FJsonSerializer::Serialize(Wrapper, FCondensedWriterFactory::Create(&Text));
+		return Text;
+	}
+}
+
+FOpenAICompatibleClient::FOpenAICompatibleClient()
+{
+	if (UAINiagaraSettings* Settings = UAINiagaraSettings::Get())
+	{
+		SetBaseURL(Settings->GetLocalServerURL());
+		APIKey = Settings->GetLocalServerAPIKey();
+		ChatModel = Settings->GetLocalChatModel();
+		ImageModel = Settings->GetLocalImageModel();
+	}
+}
+
+FOpenAICompatibleClient::~FOpenAICompatibleClient()
+{
+}
+
+FString FOpenAICompatibleClient::GetName() const
+{
+	return FString::Printf(TEXT("OpenAI-compatible %s at %s"), *ChatModel, *BaseURL);
+}
+
+void FOpenAICompatibleClient::SetBaseURL(const FString& InBaseURL)
+{
+	BaseURL = InBaseURL;
+	BaseURL.RemoveFromEnd(TEXT("/"));
+}
+
+/**
+ * Sends a chat completion request to an OpenAI-compatible server.
+ *
+ * The reply is parsed on a UE::Tasks worker; the text of the first choice, or its
+ * first tool call converted to {"functionCall":{...}}, goes to OnResponse on the
+ * game thread. Errors are reported once, without retrying.
+ *
+ * @note Cancelling the returned handle aborts the request; neither delegate is called afterwards
+ */
+FGeminiRequestHandle FOpenAICompatibleClient::SendChatCompletion(
+	const FString& Prompt,
+	const TArray<FConversationMessage>& ConversationHistory,
+	const TArray<FVFXToolFunction>& AvailableTools,
+	FOnGeminiResponse OnResponse,
+	FOnGeminiError OnError,
+	const FGeminiRequestOptions& Options
+)
+{
+	FGeminiRequestHandle Handle = FGeminiRequestHandle::MakePending();
+	GuardDelegates(Handle, OnResponse, OnError);
+
+	const FString URL = BaseURL + ChatCompletionsEndpoint;
+	const FString Payload = BuildChatPayload(ChatModel, Prompt, ConversationHistory, AvailableTools, false, Options.CandidateCount);
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = CreateRequest(URL, APIKey, Payload);
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	Request->OnProcessRequestComplete().BindLambda(
+		[Handle, OnResponse, OnError, AvailableTools, AcceptCandidate = Options.AcceptCandidate, StartSeconds, Model = ChatModel](FHttpRequestPtr HttpRequest, FHttpResponsePtr HttpResponse, bool bWasSuccessful) mutable
+		{
+			// Nothing left to abort; also drops the handle's reference to this request
+			Handle.SetHttpRequest(nullptr);
+			if (Handle.IsCancelled())
+			{
+				UE_LOG(LogTemp, Log, TEXT("AINiagara: Dropping cancelled request"));
+				return;
+			}
+
+			const FGeminiRequestMetrics Metrics = MakeMetrics(ChatCompletionsEndpoint, Model, StartSeconds, -1.0, HttpRequest, HttpResponse);
+			if (!bWasSuccessful || !HttpResponse.IsValid() || HttpResponse->GetResponseCode() != EHttpResponseCodes::Ok)
+			{
+				RecordMetrics(Metrics, nullptr);
+				DeliverError(OnError, Metrics.ResponseCode, DescribeError(bWasSuccessful, HttpResponse));
+				return;
+			}
+
+			UE::Tasks::Launch(UE_SOURCE_LOCATION, [OnResponse, OnError, AvailableTools, AcceptCandidate, Metrics, HttpResponse]()
+			{
+				FGeminiResponse Parsed;
+				if (!ParseChatResponse(HttpResponse->GetContentAsString(), AvailableTools, Parsed))
+				{
+					RecordMetrics(Metrics, nullptr);
+					DeliverError(OnError, 500, TEXT("Failed to parse response from the OpenAI-compatible server"));
+					return;
+				}
+				RecordMetrics(Metrics, &Parsed);
+
+				FString Text = Parsed.GetResponseText();
+				if (Parsed.Candidates.Num() > 1 && AcceptCandidate)
+				{
+					const int32 Selected = FGeminiAPIClient::SelectCandidate(Parsed, AcceptCandidate);
+					if (Selected != INDEX_NONE)
+					{
+						UE_LOG(LogTemp, Log, TEXT("AINiagara: Using choice %d of %d"), Selected + 1, Parsed.Candidates.Num());
+						Text = Parsed.Candidates[Selected];
+					}
+				}
+
+				if (Text.IsEmpty())
+				{
+					DeliverError(OnError, 500, FString::Printf(TEXT("The OpenAI-compatible server returned no text (finish reason: %s)"), *Parsed.FinishReason));
+					return;
+				}
+
+				AsyncTask(ENamedThreads::GameThread, [OnResponse, Text = MoveTemp(Text)]()
+				{
+					OnResponse.ExecuteIfBound(Text);
+				});
+			});
+		}
+	);
+
+	UE_LOG(LogTemp, Log, TEXT("AINiagara: Sending HTTP request to: %s (model %s)"), *URL, *ChatModel);
+	Handle.SetHttpRequest(Request);
+	Request->ProcessRequest();
+
+	return Handle;
+}
+
+/**
+ * Sends a chat completion request with "stream":true.
+ *
+ * The reply arrives as server-sent events, each a chat.completion.chunk whose
+ * choices[0].delta carries the next piece of text, and ends with "data: [DONE]".
+ * Events are read with FGeminiSSEParser as the body arrives, exactly as Gemini
+ * streams are. A streamed tool call has no text; its name and argument pieces are
+ * joined and delivered as one {"functionCall":{...}} once the stream ends.
+ *
+ * @note Cancelling the returned handle stops the stream; no chunk or outcome is reported afterwards
+ */
+FGeminiRequestHandle FOpenAICompatibleClient::StreamChatCompletion(
+	const FString& Prompt,
+	const TArray<FConversationMessage>& ConversationHistory,
+	const TArray<FVFXToolFunction>& AvailableTools,
+	FOnGeminiStreamChunk OnChunk,
+	FOnGeminiResponse OnResponse,
+	FOnGeminiError OnError,
+	const FGeminiRequestOptions& Options
+)
+{
+	if (Options.CandidateCount > 1)
+	{
+		const double StartSeconds = FPlatformTime::Seconds();
+		return SendChatCompletion(
+			Prompt,
+			ConversationHistory,
+			AvailableTools,
+			FOnGeminiResponse::CreateLambda([OnChunk, OnResponse, StartSeconds](const FString& ResponseText)
+			{
+				FGeminiStreamStats Stats;
+				Stats.NumChunks = 1;
+				Stats.ReceivedBytes = FTCHARToUTF8(*ResponseText).Length();
+				Stats.FirstChunkSeconds = FPlatformTime::Seconds() - StartSeconds;
+				Stats.ElapsedSeconds = Stats.FirstChunkSeconds;
+
+				OnChunk.ExecuteIfBound(ResponseText, Stats);
+				OnResponse.ExecuteIfBound(ResponseText);
+			}),
+			OnError,
+			Options
+		);
+	}
+
+	FGeminiRequestHandle Handle = FGeminiRequestHandle::MakePending();
+	GuardDelegates(Handle, OnResponse, OnError);
+
+	const FString URL = BaseURL + ChatCompletionsEndpoint;
+	const FString Payload = BuildChatPayload(ChatModel, Prompt, ConversationHistory, AvailableTools, true);
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = CreateRequest(URL, APIKey, Payload);
+	Request->SetHeader(TEXT("Accept"), TEXT("text/event-stream"));
+
+	TSharedRef<FOpenAIStreamState, ESPMode::ThreadSafe> State = MakeShared<FOpenAIStreamState, ESPMode::ThreadSafe>();
+	State->StartSeconds = FPlatformTime::Seconds();
+	State->Model = ChatModel;
+	State->OnChunk = FOnGeminiStreamChunk::CreateLambda([Handle, OnChunk](const FString& ChunkText, const FGeminiStreamStats& Stats)
+	{
+		if (Handle.IsPending())
+		{
+			OnChunk.ExecuteIfBound(ChunkText, Stats);
+		}
+	});
+
+	// Consume events while the body is still arriving; progress is ticked on the game thread
+	auto OnProgress = [State](FHttpRequestPtr HttpRequest, uint64 BytesReceived)
+	{
+		if (BytesReceived > 0 && State->FirstByteSeconds < 0.0)
+		{
+			State->FirstByteSeconds = FPlatformTime::Seconds();
+		}
+		const FHttpResponsePtr HttpResponse = HttpRequest.IsValid() ? HttpRequest->GetResponse() : nullptr;
+		if (!IsInGameThread() || !HttpResponse.IsValid() || HttpResponse->GetResponseCode() != EHttpResponseCodes::Ok)
+		{
+			return;
+		}
+		ConsumeStreamBody(*State, HttpResponse->GetContent(), false);
+	};
+
+#if ((ENGINE_MAJOR_VERSION == 5) && (ENGINE_MINOR_VERSION >= 4))
+	Request->OnRequestProgress64().BindLambda([OnProgress](FHttpRequestPtr HttpRequest, uint64 BytesSent, uint64 BytesReceived)
+	{
+		OnProgress(HttpRequest, BytesReceived);
+	});
+#else
+	Request->OnRequestProgress().BindLambda([OnProgress](FHttpRequestPtr HttpRequest, int32 BytesSent, int32 BytesReceived)
+	{
+		OnProgress(HttpRequest, static_cast<uint64>(FMath::Max(0, BytesReceived)));
+	});
+#endif
+
+	Request->OnProcessRequestComplete().BindLambda(
+		[State, Handle, OnResponse, OnError, AvailableTools](FHttpRequestPtr HttpRequest, FHttpResponsePtr HttpResponse, bool bWasSuccessful) mutable
+		{
+			Handle.SetHttpRequest(nullptr);
+
+			RunOnGameThread([State, Handle, OnResponse, OnError, AvailableTools, HttpRequest, HttpResponse, bWasSuccessful]()
+			{
+				// Cancelled while the reply was on its way to the game thread
+				if (Handle.IsCancelled())
+				{
+					return;
+				}
+
+				const FGeminiRequestMetrics Metrics = MakeMetrics(ChatCompletionsEndpoint, State->Model, State->StartSeconds, State->FirstByteSeconds, HttpRequest, HttpResponse);
+				if (!bWasSuccessful || !HttpResponse.IsValid() || HttpResponse->GetResponseCode() != EHttpResponseCodes::Ok)
+				{
+					RecordMetrics(Metrics, nullptr);
+					DeliverError(OnError, Metrics.ResponseCode, DescribeError(bWasSuccessful, HttpResponse));
+					return;
+				}
+
+				ConsumeStreamBody(*State, HttpResponse->GetContent(), true);
+
+				UE_LOG(LogTemp, Log, TEXT("AINiagara: Stream complete - %d chunks, %lld bytes, first token after %.0f ms, total %.0f ms, finish reason: %s"),
+					State->Stats.NumChunks, State->ConsumedBytes, State->Stats.FirstChunkSeconds * 1000.0, Metrics.TotalSeconds * 1000.0, *State->FinishReason);
+
+				FGeminiResponse Usage;
+				Usage.Text = State->ResponseText;
+				Usage.FinishReason = State->FinishReason;
+				RecordMetrics(Metrics, &Usage);
+
+				if (State->Stats.NumChunks == 0)
+				{
+					if (!State->ToolName.IsEmpty())
+					{
+						OnResponse.ExecuteIfBound(MakeFunctionCallText(RestoreToolName(State->ToolName, AvailableTools), ParseToolArguments(State->ToolArguments)));
+						return;
+					}
+					OnError.ExecuteIfBound(500, TEXT("Stream ended without any response text"));
+					return;
+				}
+
+				OnResponse.ExecuteIfBound(State->ResponseText);
+			});
+		}
+	);
+
+	UE_LOG(LogTemp, Log, TEXT("AINiagara: Sending streamed HTTP request to: %s (model %s)"), *URL, *ChatModel);
+	Handle.SetHttpRequest(Request);
+	Request->ProcessRequest();
+
+	return Handle;
+}
+
+FGeminiRequestHandle FOpenAICompatibleClient::GenerateTextureContent(
+	const FString& Prompt,
+	const FString& TextureType,
+	int32 Resolution,
+	FOnGeminiContent OnContent,
+	FOnGeminiError OnError,
+	const FGeminiRequestOptions& Options
+)
+{
+	FGeminiRequestHandle Handle = FGeminiRequestHandle::MakePending();
+	FOnGeminiResponse NoResponse;
+	GuardDelegates(Handle, NoResponse, OnError);
+
+	// Same prompt as the Imagen request
+	TSharedRef<FJsonObject> RootObject = MakeShared<FJsonObject>();
+	RootObject->SetStringField(TEXT("model"), ImageModel);
+	RootObject->SetStringField(TEXT("prompt"), FString::Printf(
+		TEXT("Generate a %s texture. %s Resolution: %dx%d pixels."),
+		*TextureType,
+		*Prompt,
+		Resolution,
+		Resolution
+	));
+	RootObject->SetNumberField(TEXT("n"), 1);
+	RootObject->SetStringField(TEXT("size"), FString::Printf(TEXT("%dx%d"), Resolution, Resolution));
+	RootObject->SetStringField(TEXT("response_format"), TEXT("b64_json"));
+
+	FString Payload;
+	FJsonSerializer::Serialize(RootObject, FCondensedWriterFactory::Create(&Payload));
+
+	const FString URL = BaseURL + ImageGenerationsEndpoint;
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = CreateRequest(URL, APIKey, Payload);
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	// As with FGeminiAPIClient::GenerateTextureContent, the body goes to OnContent as received
+	Request->OnProcessRequestComplete().BindLambda(
+		[Handle, OnContent, OnError, StartSeconds, Model = ImageModel](FHttpRequestPtr HttpRequest, FHttpResponsePtr HttpResponse, bool bWasSuccessful) mutable
+		{
+			Handle.SetHttpRequest(nullptr);
+			if (Handle.IsCancelled())
+			{
+				return;
+			}
+
+			const FGeminiRequestMetrics Metrics = MakeMetrics(ImageGenerationsEndpoint, Model, StartSeconds, -1.0, HttpRequest, HttpResponse);
+			if (!bWasSuccessful || !HttpResponse.IsValid() || HttpResponse->GetResponseCode() != EHttpResponseCodes::Ok)
+			{
+				RecordMetrics(Metrics, nullptr);
+				DeliverError(OnError, Metrics.ResponseCode, DescribeError(bWasSuccessful, HttpResponse));
+				return;
+			}
+
+			UE::Tasks::Launch(UE_SOURCE_LOCATION, [Handle, OnContent, Metrics, HttpResponse]() mutable
+			{
+				RecordMetrics(Metrics, nullptr);
+				if (Handle.TryFinish())
+				{
+					OnContent(HttpResponse->GetContent());
+				}
+			});
+		}
+	);
+
+	UE_LOG(LogTemp, Log, TEXT("AINiagara: Sending HTTP request to: %s (model %s)"), *URL, *ImageModel);
+	Handle.SetHttpRequest(Request);
+	Request->ProcessRequest();
+
+	return Handle;
+}
+
+FString FOpenAICompatibleClient::BuildChatPayload(
+	const FString& Model,
+	const FString& Prompt,
+	const TArray<FConversationMessage>& ConversationHistory,
+	const TArray<FVFXToolFunction>& AvailableTools,
+	bool bStream,
+	int32 CandidateCount
+)
+{
+	TSharedRef<FJsonObject> RootObject = MakeShared<FJsonObject>();
+	RootObject->SetStringField(TEXT("model"), Model);
+
+	TArray<TSharedPtr<FJsonValue>> MessagesArray;
+	auto AddMessage = [&MessagesArray](const FString& Role, const FString& Content)
+	{
+		TSharedPtr<FJsonObject> MessageObject = MakeShared<FJsonObject>();
+		MessageObject->SetStringField(TEXT("role"), Role);
+		MessageObject->SetStringField(TEXT("content"), Content);
+		MessagesArray.Add(MakeShared<FJsonValueObject>(MessageObject));
+	};
+
+	for (const FConversationMessage& Message : ConversationHistory)
+	{
+		AddMessage(Message.Role.Equals(TEXT("model"), ESearchCase::IgnoreCase) ? FString(TEXT("assistant")) : Message.Role, Message.Content);
+	}
+	AddMessage(TEXT("user"), Prompt);
+	RootObject->SetArrayField(TEXT("messages"), MessagesArray);
+
+	// {"tools":[{"type":"function","function":{"name","description","parameters"}}]}
+	if (AvailableTools.Num() > 0)
+	{
+		TArray<TSharedPtr<FJsonValue>> ToolsArray;
+		for (const FVFXToolFunction& Tool : AvailableTools)
+		{
+			TSharedPtr<FJsonObject> PropertiesObject = MakeShared<FJsonObject>();
+			for (const TPair<FString, FString>& Parameter : Tool.Parameters)
+			{
+				TSharedPtr<FJsonObject> ParameterObject = MakeShared<FJsonObject>();
+				ParameterObject->SetStringField(TEXT("type"), Parameter.Value);
+				PropertiesObject->SetObjectField(Parameter.Key, ParameterObject);
+			}
+
+			TSharedPtr<FJsonObject> ParametersObject = MakeShared<FJsonObject>();
+			ParametersObject->SetStringField(TEXT("type"), TEXT("object"));
+			ParametersObject->SetObjectField(TEXT("properties"), PropertiesObject);
+			ParametersObject->SetArrayField(TEXT("required"), TArray<TSharedPtr<FJsonValue>>());
+
+			TSharedPtr<FJsonObject> FunctionObject = MakeShared<FJsonObject>();
+			FunctionObject->SetStringField(TEXT("name"), ToFunctionName(Tool.Name));
+			FunctionObject->SetStringField(TEXT("description"), Tool.Description);
+			FunctionObject->SetObjectField(TEXT("parameters"), ParametersObject);
+
+			TSharedPtr<FJsonObject> ToolObject = MakeShared<FJsonObject>();
+			ToolObject->SetStringField(TEXT("type"), TEXT("function"));
+			ToolObject->SetObjectField(TEXT("function"), FunctionObject);
+			ToolsArray.Add(MakeShared<FJsonValueObject>(ToolObject));
+		}
+		RootObject->SetArrayField(TEXT("tools"), ToolsArray);
+	}
+
+	if (bStream)
+	{
+		RootObject->SetBoolField(TEXT("stream"), true);
+	}
+	if (CandidateCount > 1)
+	{
+		RootObject->SetNumberField(TEXT("n"), CandidateCount);
+	}
+
+	FString OutputString;
+	FJsonSerializer::Serialize(RootObject, FCondensedWriterFactory::Create(&OutputString));
+	return OutputString;
+}
+
+/**
+ * Parses a chat completion:
+ * {
+ *   "choices": [{ "message": { "content": "...", "tool_calls": [{ "function": { "name", "arguments" } }] }, "finish_reason": "stop" }],
+ *   "usage": { "prompt_tokens", "completion_tokens", "total_tokens", "prompt_tokens_details": { "cached_tokens" } }
+ * }
+ */
+bool FOpenAICompatibleClient::ParseChatResponse(const FString& ResponseBody, const TArray<FVFXToolFunction>& AvailableTools, FGeminiResponse& OutResponse)
+{
+	OutResponse = FGeminiResponse();
+
+	TSharedPtr<FJsonObject> JsonObject;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseBody);
+	const TArray<TSharedPtr<FJsonValue>>* Choices;
+	if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid()
+		|| !JsonObject->TryGetArrayField(TEXT("choices"), Choices) || Choices->Num() == 0)
+	{
+		return false;
+	}
+
+	OutResponse.NumCandidates = Choices->Num();
+	for (int32 ChoiceIndex = 0; ChoiceIndex < Choices->Num(); ++ChoiceIndex)
+	{
+		const TSharedPtr<FJsonObject> ChoiceObject = (*Choices)[ChoiceIndex]->AsObject();
+		const TSharedPtr<FJsonObject>* MessageObject;
+		if (!ChoiceObject.IsValid() || !ChoiceObject->TryGetObjectField(TEXT("message"), MessageObject))
+		{
+			OutResponse.Candidates.Add(FString());
+			continue;
+		}
+
+		// "content" is null when the reply is only tool calls
+		FString Content;
+		(*MessageObject)->TryGetStringField(TEXT("content"), Content);
+
+		TArray<FString> FunctionCalls;
+		const TArray<TSharedPtr<FJsonValue>>* ToolCalls;
+		if ((*MessageObject)->TryGetArrayField(TEXT("tool_calls"), ToolCalls))
+		{
+			for (const TSharedPtr<FJsonValue>& ToolCall : *ToolCalls)
+			{
+				const TSharedPtr<FJsonObject> ToolCallObject = ToolCall->AsObject();
+				const TSharedPtr<FJsonObject>* FunctionObject;
+				FString FunctionName;
+				if (!ToolCallObject.IsValid() || !ToolCallObject->TryGetObjectField(TEXT("function"), FunctionObject)
+					|| !(*FunctionObject)->TryGetStringField(TEXT("name"), FunctionName))
+				{
+					continue;
+				}
+
+				// Arguments are a JSON string, though some servers send the object itself
+				TSharedPtr<FJsonObject> Args;
+				const TSharedPtr<FJsonObject>* ArgsObject;
+				FString ArgsText;
+				if ((*FunctionObject)->TryGetObjectField(TEXT("arguments"), ArgsObject))
+				{
+					Args = *ArgsObject;
+				}
+				else if ((*FunctionObject)->TryGetStringField(TEXT("arguments"), ArgsText))
+				{
+					Args = ParseToolArguments(ArgsText);
+				}
+
+				FunctionCalls.Add(MakeFunctionCallText(RestoreToolName(FunctionName, AvailableTools), Args));
+			}
+		}
+
+		OutResponse.Candidates.Add((Content.IsEmpty() && FunctionCalls.Num() > 0) ? FunctionCalls[0] : Content);
+
+		if (ChoiceIndex == 0)
+		{
+			OutResponse.Text = Content;
+			if (!Content.IsEmpty())
+			{
+				OutResponse.TextParts.Add(Content);
+			}
+			OutResponse.FunctionCalls = MoveTemp(FunctionCalls);
+			ChoiceObject->TryGetStringField(TEXT("finish_reason"), OutResponse.FinishReason);
+		}
+	}
+
+	const TSharedPtr<FJsonObject>* UsageObject;
+	if (JsonObject->TryGetObjectField(TEXT("usage"), UsageObject))
+	{
+		(*UsageObject)->TryGetNumberField(TEXT("prompt_tokens"), OutResponse.PromptTokens);
+		(*UsageObject)->TryGetNumberField(TEXT("completion_tokens"), OutResponse.OutputTokens);
+		(*UsageObject)->TryGetNumberField(TEXT("total_tokens"), OutResponse.TotalTokens);
+
+		const TSharedPtr<FJsonObject>* DetailsObject;
+		if ((*UsageObject)->TryGetObjectField(TEXT("prompt_tokens_details"), DetailsObject))
+		{
+			(*DetailsObject)->TryGetNumberField(TEXT("cached_tokens"), OutResponse.CachedTokens);
+		}
+	}
+
+	return true;
+}
+
+bool FOpenAICompatibleClient::ParseStreamEvent(const FString& EventData, FString& OutText, FString& OutFinishReason, FString& OutToolName, FString& OutToolArguments)
+{
+	OutText.Reset();
+	OutFinishReason.Reset();
+	OutToolName.Reset();
+	OutToolArguments.Reset();
+
+	if (EventData.TrimStartAndEnd().Equals(TEXT("[DONE]"), ESearchCase::CaseSensitive))
+	{
+		return true;
+	}
+
+	TSharedPtr<FJsonObject> JsonObject;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(EventData);
+	if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid())
+	{
+		return false;
+	}
+
+	// A final usage-only event has no choices
+	const TArray<TSharedPtr<FJsonValue>>* Choices;
+	if (!JsonObject->TryGetArrayField(TEXT("choices"), Choices) || Choices->Num() == 0)
+	{
+		return JsonObject->HasField(TEXT("usage"));
+	}
+
+	const TSharedPtr<FJsonObject> ChoiceObject = (*Choices)[0]->AsObject();
+	if (!ChoiceObject.IsValid())
+	{
+		return false;
+	}
+	ChoiceObject->TryGetStringField(TEXT("finish_reason"), OutFinishReason);
+
+	const TSharedPtr<FJsonObject>* DeltaObject;
+	if (!ChoiceObject->TryGetObjectField(TEXT("delta"), DeltaObject))
+	{
+		return true;
+	}
+	(*DeltaObject)->TryGetStringField(TEXT("content"), OutText);
+
+	const TArray<TSharedPtr<FJsonValue>>* ToolCalls;
+	if ((*DeltaObject)->TryGetArrayField(TEXT("tool_calls"), ToolCalls) && ToolCalls->Num() > 0)
+	{
+		const TSharedPtr<FJsonObject> ToolCallObject = (*ToolCalls)[0]->AsObject();
+		const TSharedPtr<FJsonObject>* FunctionObject;
+		if (ToolCallObject.IsValid() && ToolCallObject->TryGetObjectField(TEXT("function"), FunctionObject))
+		{
+			(*FunctionObject)->TryGetStringField(TEXT("name"), OutToolName);
+			(*FunctionObject)->TryGetStringField(TEXT("arguments"), OutToolArguments);
+		}
+	}
+
+	return true;
+}
+
+FString FOpenAICompatibleClient::ToFunctionName(const FString& ToolName)
+{
+	FString FunctionName = ToolName;
+	for (int32 Index = 0; Index < FunctionName.Len(); ++Index)
+	{
+		const TCHAR Char = FunctionName[Index];
+		if (!FChar::IsAlnum(Char) && Char != TEXT('_') && Char != TEXT('-'))
+		{
+			FunctionName[Index] = TEXT('_');
+		}
+	}
+	return FunctionName;
+}
@@ -4,6 +4,7 @@
 #include "Core/NiagaraSystemGenerator.h"
 #include "Core/CascadeSystemGenerator.h"
 #include "Core/VFXDSLDiff.h"
+#include "Core/VFXDSLHash.h"
 #include "NiagaraSystem.h"
 #include "Particles/ParticleSystem.h"
 #include "UObject/Package.h"
@@ -63,6 +64,7 @@ bool UPreviewSystemManager::UpdatePreview(const FVFXDSL& DSL, bool bForceUpdate,
 	UNiagaraSystem* PreviousNiagaraPreview = NiagaraPreview;
 	UParticleSystem* PreviousCascadePreview = CascadePreview;
 	FVFXDSL PreviousDSL = CurrentPreviewDSL;
+	uint64 PreviousHash = CurrentPreviewHash;
 	bool bHadPreviousPreview = (PreviousNiagaraPreview != nullptr || PreviousCascadePreview != nullptr);
 
 	// Clean up old preview (but keep references for restoration if needed)
@@ -93,6 +95,7 @@ bool UPreviewSystemManager::UpdatePreview(const FVFXDSL& DSL, bool bForceUpdate,
 	if (bSuccess)
 	{
 		CurrentPreviewDSL = DSL;
+		CurrentPreviewHash = FVFXDSLHash::Hash(DSL);
 		
 		// Mark old previews as garbage now that new one succeeded
 		if (OldNiagaraPreview)
@@ -113,6 +116,7 @@ bool UPreviewSystemManager::UpdatePreview(const FVFXDSL& DSL, bool bForceUpdate,
 		NiagaraPreview = PreviousNiagaraPreview;
 		CascadePreview = PreviousCascadePreview;
 		CurrentPreviewDSL = PreviousDSL;
+		CurrentPreviewHash = PreviousHash;
 		
 		// Mark failed preview attempts as garbage
 		if (OldNiagaraPreview && OldNiagaraPreview != PreviousNiagaraPreview)
@@ -176,6 +180,7 @@ void UPreviewSystemManager::ClearPreview()
 	}
 	
 	CurrentPreviewDSL = FVFXDSL();
+	CurrentPreviewHash = 0;
 }
 
 void UPreviewSystemManager::SetPreviewEnabled(bool bEnabled)
@@ -224,26 +229,21 @@ void UPreviewSystemManager::Cleanup()
 
 FVFXDSLDiffResult UPreviewSystemManager::GetDSLDiff(const FVFXDSL& NewDSL) const
 {
+	// Most preview refreshes change nothing the diff reports; skip building the change list
+	if (!UVFXDSLDiff::AnyDifference(CurrentPreviewDSL, NewDSL))
+	{
+		FVFXDSLDiffResult Result;
+		Result.GenerateSummary();
+		return Result;
+	}
+
 	return UVFXDSLDiff::Compare(CurrentPreviewDSL, NewDSL);
 }
 
 bool UPreviewSystemManager::HasDSLChanged(const FVFXDSL& NewDSL) const
 {
-	// Simple comparison - check if effect type or emitter count changed
-	if (CurrentPreviewDSL.Effect.Type != NewDSL.Effect.Type)
-	{
-		return true;
-	}
-
-	if (CurrentPreviewDSL.Emitters.Num() != NewDSL.Emitters.Num())
-	{
-		return true;
-	}
-
-	// TODO: More sophisticated comparison could be added here
-	// For now, we'll regenerate if type or emitter count changes
-	
-	return false; // Assume no change if basic properties match
+	// Content hash covers every field, so edits such as a new color or spawn rate are detected
+	return CurrentPreviewHash != FVFXDSLHash::Hash(NewDSL);
 }
 
 bool UPreviewSystemManager::CreateNiagaraPreview(const FVFXDSL& DSL, FString& OutError)
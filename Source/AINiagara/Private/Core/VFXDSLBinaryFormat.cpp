@@ -0,0 +1,440 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/VFXDSLBinaryFormat.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+	/** Upper bound on element counts accepted from a record, guards against corrupt input */
+	constexpr int32 MaxElementsPerArray = 1 << 20;
+
+	template <typename ElementType>
+	void SetNumKeepSlack(TArray<ElementType>& Array, int32 Num)
+	{
+#if ((ENGINE_MAJOR_VERSION == 5) && (ENGINE_MINOR_VERSION >= 4))
+		Array.SetNum(Num, EAllowShrinking::No);
+#else
+		Array.SetNum(Num, false);
+#endif
+	}
+
+	/** Reject counts whose elements cannot fit in the bytes left in the record, before anything is allocated for them */
+	bool IsValidCount(FArchive& Ar, int32 Count, int64 MinElementSize)
+	{
+		return Count >= 0 && Count <= MaxElementsPerArray && Count * MinElementSize <= Ar.TotalSize() - Ar.Tell();
+	}
+
+	void SerializeBool(FArchive& Ar, bool& Value)
+	{
+		// FArchive serializes bool as 32 bits; one byte is enough here
+		uint8 Byte = Value ? 1 : 0;
+		Ar << Byte;
+		if (Ar.IsLoading())
+		{
+			Value = Byte != 0;
+		}
+	}
+
+	void SerializeString(FArchive& Ar, FString& Value, TArray<ANSICHAR>& Scratch)
+	{
+		if (Ar.IsSaving())
+		{
+			FTCHARToUTF8 Utf8(*Value, Value.Len());
+			int32 Length = Utf8.Length();
+			Ar << Length;
+			Ar.Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Length);
+			return;
+		}
+
+		int32 Length = 0;
+		Ar << Length;
+		if (Length < 0 || Length > Ar.TotalSize() - Ar.Tell())
+		{
+			Ar.SetError();
+			return;
+		}
+
+		if (Scratch.Num() < Length)
+		{
+			Scratch.SetNumUninitialized(Length);
+		}
+		Ar.Serialize(Scratch.GetData(), Length);
+
+		// Reset keeps the existing allocation when it is large enough
+		bool bIsAscii = true;
+		for (int32 Index = 0; Index < Length && bIsAscii; ++Index)
+		{
+			bIsAscii = static_cast<uint8>(Scratch[Index]) < 0x80;
+		}
+
+		if (bIsAscii)
+		{
+			Value.Reset(Length);
+			for (int32 Index = 0; Index < Length; ++Index)
+			{
+				Value.AppendChar(static_cast<TCHAR>(Scratch[Index]));
+			}
+		}
+		else
+		{
+			FUTF8ToTCHAR Converted(Scratch.GetData(), Length);
+			Value.Reset(Converted.Length());
+			Value.AppendChars(Converted.Get(), Converted.Length());
+		}
+	}
+
+	void SerializeVector(FArchive& Ar, FVFXDSLVelocity& Vector)
+	{
+		Ar << Vector.X;
+		Ar << Vector.Y;
+		Ar << Vector.Z;
+	}
+
+	void SerializeEmitter(FArchive& Ar, FVFXDSLEmitter& Emitter, TArray<ANSICHAR>& Scratch)
+	{
+		SerializeString(Ar, Emitter.Name, Scratch);
+
+		// Spawners
+		Ar << Emitter.Spawners.Burst.Count;
+		Ar << Emitter.Spawners.Burst.Time;
+		int32 NumIntervals = Emitter.Spawners.Burst.Intervals.Num();
+		Ar << NumIntervals;
+		if (Ar.IsLoading())
+		{
+			if (!IsValidCount(Ar, NumIntervals, sizeof(float)))
+			{
+				Ar.SetError();
+				return;
+			}
+			SetNumKeepSlack(Emitter.Spawners.Burst.Intervals, NumIntervals);
+		}
+		for (float& Interval : Emitter.Spawners.Burst.Intervals)
+		{
+			Ar << Interval;
+		}
+		Ar << Emitter.Spawners.Rate.SpawnRate;
+		Ar << Emitter.Spawners.Rate.ScaleOverTime;
+
+		// Initialization
+		Ar << Emitter.Initialization.Color.R;
+		Ar << Emitter.Initialization.Color.G;
+		Ar << Emitter.Initialization.Color.B;
+		Ar << Emitter.Initialization.Color.A;
+		Ar << Emitter.Initialization.Size.Min;
+		Ar << Emitter.Initialization.Size.Max;
+		SerializeVector(Ar, Emitter.Initialization.Velocity);
+
+		// Update
+		Ar << Emitter.Update.Forces.Gravity;
+		SerializeVector(Ar, Emitter.Update.Forces.Wind);
+		Ar << Emitter.Update.Drag;
+		SerializeBool(Ar, Emitter.Update.Collision.bEnabled);
+		Ar << Emitter.Update.Collision.Bounce;
+
+		// Render
+		SerializeString(Ar, Emitter.Render.Material, Scratch);
+		SerializeString(Ar, Emitter.Render.Texture, Scratch);
+		SerializeString(Ar, Emitter.Render.BlendMode, Scratch);
+		SerializeString(Ar, Emitter.Render.Sort, Scratch);
+		SerializeString(Ar, Emitter.Render.Mesh.MeshPath, Scratch);
+		SerializeString(Ar, Emitter.Render.Mesh.MeshType, Scratch);
+		Ar << Emitter.Render.Mesh.Scale;
+		SerializeVector(Ar, Emitter.Render.Mesh.Rotation);
+		SerializeBool(Ar, Emitter.Render.Mesh.bUseMesh);
+	}
+
+	/** Encoded size of an emitter with empty strings and no intervals, the least a record spends on one */
+	int64 GetMinEncodedEmitterSize()
+	{
+		static const int64 MinSize = []()
+		{
+			FVFXDSLEmitter Emitter;
+			Emitter.Name.Reset();
+			Emitter.Render.BlendMode.Reset();
+			Emitter.Render.Sort.Reset();
+			Emitter.Render.Mesh.MeshType.Reset();
+
+			TArray<uint8> Bytes;
+			FMemoryWriter Writer(Bytes);
+			TArray<ANSICHAR> Unused;
+			SerializeEmitter(Writer, Emitter, Unused);
+			return static_cast<int64>(Bytes.Num());
+		}();
+		return MinSize;
+	}
+
+	void SerializeDSL(FArchive& Ar, FVFXDSL& DSL, TArray<ANSICHAR>& Scratch)
+	{
+		uint8 Type = static_cast<uint8>(DSL.Effect.Type);
+		Ar << Type;
+		if (Ar.IsLoading())
+		{
+			DSL.Effect.Type = (Type == static_cast<uint8>(EVFXEffectType::Cascade)) ? EVFXEffectType::Cascade : EVFXEffectType::Niagara;
+		}
+		Ar << DSL.Effect.Duration;
+		SerializeBool(Ar, DSL.Effect.bLooping);
+
+		int32 NumEmitters = DSL.Emitters.Num();
+		Ar << NumEmitters;
+		if (Ar.IsLoading())
+		{
+			if (!IsValidCount(Ar, NumEmitters, GetMinEncodedEmitterSize()))
+			{
+				Ar.SetError();
+				return;
+			}
+			SetNumKeepSlack(DSL.Emitters, NumEmitters);
+		}
+
+		for (FVFXDSLEmitter& Emitter : DSL.Emitters)
+		{
+			SerializeEmitter(Ar, Emitter, Scratch);
+			if (Ar.IsError())
+			{
+				return;
+			}
+		}
+	}
+}
+
+FVFXDSLBinaryWriter::FVFXDSLBinaryWriter(FArchive& InArchive)
+	: Archive(InArchive)
+{
+	check(Archive.IsSaving());
+
+	HeaderOffset = Archive.Tell();
+
+	uint32 Magic = VFXDSLBinary::Magic;
+	uint16 Version = static_cast<uint16>(VFXDSLBinary::EVersion::Latest);
+	uint16 Flags = 0;
+	uint32 RecordCount = 0;
+	Archive << Magic;
+	Archive << Version;
+	Archive << Flags;
+	Archive << RecordCount;
+}
+
+void FVFXDSLBinaryWriter::Write(const FVFXDSL& DSL)
+{
+	// Encode into a reused buffer first so the record can be length-prefixed
+	RecordBuffer.Reset();
+	FMemoryWriter RecordWriter(RecordBuffer);
+	TArray<ANSICHAR> Unused;
+
+	// Saving only reads the DSL: every assignment in the serializers is behind Ar.IsLoading()
+	SerializeDSL(RecordWriter, const_cast<FVFXDSL&>(DSL), Unused);
+
+	uint32 PayloadSize = static_cast<uint32>(RecordBuffer.Num());
+	Archive << PayloadSize;
+	Archive.Serialize(RecordBuffer.GetData(), RecordBuffer.Num());
+	++NumRecords;
+}
+
+bool FVFXDSLBinaryWriter::Finish()
+{
+	const int64 EndOffset = Archive.Tell();
+
+	Archive.Seek(HeaderOffset + sizeof(uint32) + sizeof(uint16) + sizeof(uint16));
+	uint32 RecordCount = static_cast<uint32>(NumRecords);
+	Archive << RecordCount;
+	Archive.Seek(EndOffset);
+
+	return !Archive.IsError();
+}
+
+bool FVFXDSLBinaryWriter::SaveToBytes(TConstArrayView<FVFXDSL> DSLs, TArray<uint8>& OutBytes)
+{
+	OutBytes.Reset();
+	FMemoryWriter MemoryWriter(OutBytes);
+
+	FVFXDSLBinaryWriter Writer(MemoryWriter);
+	for (const FVFXDSL& DSL : DSLs)
+	{
+		Writer.Write(DSL);
+	}
+	return Writer.Finish();
+}
+
+bool FVFXDSLBinaryWriter::SaveToFile(TConstArrayView<FVFXDSL> DSLs, const FString& FilePath, FString& OutError)
+{
+	const FString Directory = FPaths::GetPath(FilePath);
+	if (!Directory.IsEmpty())
+	{
+		IFileManager::Get().MakeDirectory(*Directory, true);
+	}
+
+	TUniquePtr<FArchive> FileWriter(IFileManager::Get().CreateFileWriter(*FilePath));
+	if (!FileWriter)
+	{
+		OutError = FString::Printf(TEXT("Failed to open '%s' for writing"), *FilePath);
+		return false;
+	}
+
+	FVFXDSLBinaryWriter Writer(*FileWriter);
+	for (const FVFXDSL& DSL : DSLs)
+	{
+		Writer.Write(DSL);
+	}
+
+	const bool bFinished = Writer.Finish();
+	const bool bClosed = FileWriter->Close();
+	if (!bFinished || !bClosed)
+	{
+		OutError = FString::Printf(TEXT("Failed to write DSL library '%s'"), *FilePath);
+		return false;
+	}
+
+	return true;
+}
+
+FVFXDSLBinaryReader::FVFXDSLBinaryReader()
+{
+}
+
+FVFXDSLBinaryReader::~FVFXDSLBinaryReader()
+{
+	Close();
+}
+
+bool FVFXDSLBinaryReader::OpenBytes(TConstArrayView<uint8> Bytes, FString& OutError)
+{
+	Close();
+	Data = Bytes;
+	return ReadHeader(OutError);
+}
+
+bool FVFXDSLBinaryReader::OpenFile(const FString& FilePath, bool bMemoryMap, FString& OutError)
+{
+	Close();
+
+	if (bMemoryMap)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		MappedHandle.Reset(PlatformFile.OpenMapped(*FilePath));
+		if (MappedHandle.IsValid() && MappedHandle->GetFileSize() <= MAX_int32)
+		{
+			MappedRegion.Reset(MappedHandle->MapRegion(0, MappedHandle->GetFileSize()));
+		}
+
+		if (MappedRegion.IsValid())
+		{
+			Data = TConstArrayView<uint8>(MappedRegion->GetMappedPtr(), static_cast<int32>(MappedRegion->GetMappedSize()));
+		}
+		else
+		{
+			// Mapping is not supported by every platform file layer; load the file instead
+			MappedHandle.Reset();
+			UE_LOG(LogTemp, Verbose, TEXT("AINiagara: Memory mapping unavailable for '%s', loading DSL library into memory"), *FilePath);
+		}
+	}
+
+	if (!MappedRegion.IsValid())
+	{
+		if (!FFileHelper::LoadFileToArray(OwnedBytes, *FilePath))
+		{
+			OutError = FString::Printf(TEXT("Failed to read DSL library '%s'"), *FilePath);
+			return false;
+		}
+		Data = OwnedBytes;
+	}
+
+	return ReadHeader(OutError);
+}
+
+bool FVFXDSLBinaryReader::ReadHeader(FString& OutError)
+{
+	Offset = 0;
+	RecordIndex = 0;
+	NumRecords = 0;
+	Version = 0;
+	Error.Reset();
+
+	if (Data.Num() < VFXDSLBinary::HeaderSize)
+	{
+		OutError = TEXT("DSL library is too small to contain a header");
+		return false;
+	}
+
+	FMemoryReaderView Reader(Data);
+	uint32 Magic = 0;
+	uint16 Flags = 0;
+	uint32 RecordCount = 0;
+	Reader << Magic;
+	Reader << Version;
+	Reader << Flags;
+	Reader << RecordCount;
+
+	if (Magic != VFXDSLBinary::Magic)
+	{
+		OutError = TEXT("Not a DSL library (bad magic)");
+		return false;
+	}
+
+	if (Version == static_cast<uint16>(VFXDSLBinary::EVersion::Invalid) || Version > static_cast<uint16>(VFXDSLBinary::EVersion::Latest))
+	{
+		OutError = FString::Printf(TEXT("Unsupported DSL library version %d (latest supported is %d)"),
+			Version, static_cast<int32>(VFXDSLBinary::EVersion::Latest));
+		return false;
+	}
+
+	if (RecordCount > static_cast<uint32>(MAX_int32))
+	{
+		OutError = TEXT("DSL library header declares an invalid record count");
+		return false;
+	}
+
+	NumRecords = static_cast<int32>(RecordCount);
+	Offset = Reader.Tell();
+	return true;
+}
+
+bool FVFXDSLBinaryReader::Next(FVFXDSL& InOutDSL)
+{
+	if (!Error.IsEmpty() || RecordIndex >= NumRecords)
+	{
+		return false;
+	}
+
+	FMemoryReaderView Reader(Data);
+	Reader.Seek(Offset);
+
+	uint32 PayloadSize = 0;
+	Reader << PayloadSize;
+	const int64 PayloadStart = Reader.Tell();
+	if (Reader.IsError() || PayloadStart + PayloadSize > Data.Num())
+	{
+		Error = FString::Printf(TEXT("DSL library record %d is truncated"), RecordIndex);
+		return false;
+	}
+
+	// Decode from a view of the payload alone so counts and lengths are checked against the record, not the library
+	FMemoryReaderView RecordReader(Data.Slice(static_cast<int32>(PayloadStart), static_cast<int32>(PayloadSize)));
+	SerializeDSL(RecordReader, InOutDSL, StringScratch);
+	if (RecordReader.IsError())
+	{
+		Error = FString::Printf(TEXT("DSL library record %d is corrupt"), RecordIndex);
+		return false;
+	}
+
+	// Skip any fields appended by a newer revision of the same version
+	Offset = PayloadStart + PayloadSize;
+	++RecordIndex;
+	return true;
+}
+
+void FVFXDSLBinaryReader::Close()
+{
+	MappedRegion.Reset();
+	MappedHandle.Reset();
+	OwnedBytes.Empty();
+	Data = TConstArrayView<uint8>();
+	Offset = 0;
+	NumRecords = 0;
+	RecordIndex = 0;
+}
@@ -0,0 +1,439 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/VFXDSLCodec.h"
+#include "Core/VFXDSLDiff.h"
+#include "UObject/UnrealType.h"
+#include "UObject/EnumProperty.h"
+
+namespace
+{
+	/** Property name as a path segment: bool properties drop their 'b' prefix ("bUseMesh" -> "UseMesh") */
+	FString GetSegmentName(const FProperty& Property)
+	{
+		FString Name = Property.GetName();
+		if (Property.IsA<FBoolProperty>() && Name.Len() > 1 && Name[0] == TEXT('b') && FChar::IsUpper(Name[1]))
+		{
+			Name.RightChopInline(1);
+		}
+		return Name;
+	}
+
+	float ParseTolerance(const FString& Name)
+	{
+		if (Name.Equals(TEXT("Color"), ESearchCase::IgnoreCase))
+		{
+			return VFXDSLTolerance::Color;
+		}
+		if (Name.Equals(TEXT("Count"), ESearchCase::IgnoreCase))
+		{
+			return VFXDSLTolerance::Count;
+		}
+		return VFXDSLTolerance::Default;
+	}
+
+	/** Numeric value of a Float or Int32 leaf */
+	double GetNumber(const FVFXDSLCodecField& Field, const void* Base)
+	{
+		return Field.Type == EVFXDSLCodecType::Int32
+			? static_cast<double>(FVFXDSLCodec::GetValue<int32>(Field, Base))
+			: static_cast<double>(FVFXDSLCodec::GetValue<float>(Field, Base));
+	}
+}
+
+const FVFXDSLCodec& FVFXDSLCodec::Get()
+{
+	static const FVFXDSLCodec Instance;
+	return Instance;
+}
+
+void FVFXDSLCodec::Initialize()
+{
+	const FVFXDSLCodec& Codec = Get();
+	UE_LOG(LogTemp, Log, TEXT("AINiagara: DSL codec ready (%d effect fields, %d emitter fields)"),
+		Codec.EffectTable.Leaves.Num(), Codec.EmitterTable.Leaves.Num());
+}
+
+FVFXDSLCodec::FVFXDSLCodec()
+{
+	BuildTable(FVFXDSLEffect::StaticStruct(), TEXT("Effect"), EffectTable);
+	BuildTable(FVFXDSLEmitter::StaticStruct(), FString(), EmitterTable);
+}
+
+/**
+ * Flattens a DSL struct into a codec table.
+ *
+ * Struct nodes are expanded breadth first so that the children of every node
+ * are contiguous (readers scan one small range per object); leaves are then
+ * listed depth first, which is the declaration order the JSON writer, the diff
+ * and the validator rely on.
+ */
+void FVFXDSLCodec::BuildTable(const UScriptStruct* Struct, const FString& RootPath, FVFXDSLCodecTable& OutTable)
+{
+	FVFXDSLCodecField& Root = OutTable.Fields.AddDefaulted_GetRef();
+	Root.Path = RootPath;
+
+	TArray<TPair<int32, const UStruct*>> Pending;
+	Pending.Emplace(0, Struct);
+
+	for (int32 PendingIndex = 0; PendingIndex < Pending.Num(); ++PendingIndex)
+	{
+		const int32 NodeIndex = Pending[PendingIndex].Key;
+		const UStruct* NodeStruct = Pending[PendingIndex].Value;
+
+		TArray<const FProperty*> Properties;
+		for (TFieldIterator<FProperty> It(NodeStruct); It; ++It)
+		{
+			Properties.Add(*It);
+		}
+		Properties.StableSort([](const FProperty& A, const FProperty& B) { return A.GetOffset_ForInternal() < B.GetOffset_ForInternal(); });
+
+		const int32 FirstChild = OutTable.Fields.Num();
+		for (const FProperty* Property : Properties)
+		{
+			FVFXDSLCodecField Field;
+			if (!DescribeProperty(*Property, *NodeStruct, OutTable.Fields[NodeIndex], Field))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("AINiagara: DSL codec skips %s.%s (unsupported property type)"), *NodeStruct->GetName(), *Property->GetName());
+				continue;
+			}
+
+			const int32 FieldIndex = OutTable.Fields.Add(MoveTemp(Field));
+			if (const FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+			{
+				Pending.Emplace(FieldIndex, StructProperty->Struct);
+			}
+		}
+
+		OutTable.Fields[NodeIndex].FirstChild = FirstChild;
+		OutTable.Fields[NodeIndex].NumChildren = OutTable.Fields.Num() - FirstChild;
+	}
+
+	AssignLeaves(OutTable, 0);
+
+	OutTable.CompareOrder.Reserve(OutTable.Leaves.Num());
+	for (int32 LeafIndex : OutTable.Leaves)
+	{
+		if (OutTable.Fields[LeafIndex].Type != EVFXDSLCodecType::String)
+		{
+			OutTable.CompareOrder.Add(LeafIndex);
+		}
+	}
+	for (int32 LeafIndex : OutTable.Leaves)
+	{
+		if (OutTable.Fields[LeafIndex].Type == EVFXDSLCodecType::String)
+		{
+			OutTable.CompareOrder.Add(LeafIndex);
+		}
+	}
+
+	for (int32 FieldIndex = 1; FieldIndex < OutTable.Fields.Num(); ++FieldIndex)
+	{
+		OutTable.FieldsByPath.Add(OutTable.Fields[FieldIndex].Path, FieldIndex);
+	}
+}
+
+bool FVFXDSLCodec::DescribeProperty(const FProperty& Property, const UStruct& Owner, const FVFXDSLCodecField& Parent, FVFXDSLCodecField& OutField)
+{
+	if (Property.ArrayDim != 1)
+	{
+		return false;
+	}
+
+	if (Property.IsA<FFloatProperty>())
+	{
+		OutField.Type = EVFXDSLCodecType::Float;
+	}
+	else if (Property.IsA<FIntProperty>())
+	{
+		OutField.Type = EVFXDSLCodecType::Int32;
+	}
+	else if (const FBoolProperty* BoolProperty = CastField<FBoolProperty>(&Property))
+	{
+		if (!BoolProperty->IsNativeBool())
+		{
+			return false;
+		}
+		OutField.Type = EVFXDSLCodecType::Bool;
+	}
+	else if (Property.IsA<FStrProperty>())
+	{
+		OutField.Type = EVFXDSLCodecType::String;
+	}
+	else if (Property.IsA<FStructProperty>())
+	{
+		OutField.Type = EVFXDSLCodecType::Struct;
+	}
+	else if (const FArrayProperty* ArrayProperty = CastField<FArrayProperty>(&Property))
+	{
+		if (!ArrayProperty->Inner->IsA<FFloatProperty>())
+		{
+			return false;
+		}
+		OutField.Type = EVFXDSLCodecType::FloatArray;
+	}
+	else
+	{
+		const UEnum* Enum = nullptr;
+		if (const FEnumProperty* EnumProperty = CastField<FEnumProperty>(&Property))
+		{
+			Enum = EnumProperty->GetEnum();
+			OutField.EnumValueProperty = EnumProperty->GetUnderlyingProperty();
+		}
+		else if (const FByteProperty* ByteProperty = CastField<FByteProperty>(&Property))
+		{
+			Enum = ByteProperty->Enum;
+			OutField.EnumValueProperty = ByteProperty;
+		}
+
+		if (!Enum || !OutField.EnumValueProperty)
+		{
+			return false;
+		}
+
+		// Skip the generated _MAX entry
+		const int32 NumNames = Enum->ContainsExistingMax() ? Enum->NumEnums() - 1 : Enum->NumEnums();
+		for (int32 Index = 0; Index < NumNames; ++Index)
+		{
+			OutField.EnumEntries.Emplace(Enum->GetValueByIndex(Index), Enum->GetNameStringByIndex(Index));
+		}
+		if (OutField.EnumEntries.Num() == 0)
+		{
+			return false;
+		}
+		OutField.Type = EVFXDSLCodecType::Enum;
+	}
+
+	const FString Segment = GetSegmentName(Property);
+	OutField.JsonKey = Segment;
+	OutField.JsonKey[0] = FChar::ToLower(OutField.JsonKey[0]);
+	OutField.Path = Parent.Path.IsEmpty() ? Segment : Parent.Path + TEXT(".") + Segment;
+	OutField.Offset = Parent.Offset + Property.GetOffset_ForInternal();
+
+	const int64 FieldId = StaticEnum<EVFXDSLFieldId>()->GetValueByNameString(OutField.Path.Replace(TEXT("."), TEXT("")));
+	if (FieldId != INDEX_NONE)
+	{
+		OutField.FieldId = static_cast<EVFXDSLFieldId>(FieldId);
+	}
+
+#if WITH_EDITORONLY_DATA
+	if (Property.HasMetaData(TEXT("DiffTolerance")))
+	{
+		OutField.Tolerance = ParseTolerance(Property.GetMetaData(TEXT("DiffTolerance")));
+	}
+
+	if (Property.HasMetaData(TEXT("ValidationCode")))
+	{
+		const int64 Code = StaticEnum<EVFXDSLValidationCode>()->GetValueByNameString(Property.GetMetaData(TEXT("ValidationCode")));
+		if (Code == INDEX_NONE)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("AINiagara: DSL codec ignores unknown ValidationCode on %s"), *OutField.Path);
+		}
+		else
+		{
+			OutField.bValidated = true;
+			OutField.RangeCode = static_cast<EVFXDSLValidationCode>(Code);
+		}
+	}
+
+	if (Property.HasMetaData(TEXT("ClampMin")))
+	{
+		OutField.RangeMin = FCString::Atod(*Property.GetMetaData(TEXT("ClampMin")));
+	}
+	if (Property.HasMetaData(TEXT("ClampMax")))
+	{
+		OutField.RangeMax = FCString::Atod(*Property.GetMetaData(TEXT("ClampMax")));
+	}
+
+	if (Property.HasMetaData(TEXT("EditCondition")))
+	{
+		const FBoolProperty* Condition = CastField<FBoolProperty>(Owner.FindPropertyByName(FName(*Property.GetMetaData(TEXT("EditCondition")))));
+		if (Condition && Condition->IsNativeBool())
+		{
+			OutField.ConditionOffset = Parent.Offset + Condition->GetOffset_ForInternal();
+		}
+	}
+#endif
+
+	return true;
+}
+
+void FVFXDSLCodec::AssignLeaves(FVFXDSLCodecTable& Table, int32 NodeIndex)
+{
+	Table.Fields[NodeIndex].FirstLeaf = Table.Leaves.Num();
+
+	if (Table.Fields[NodeIndex].Type == EVFXDSLCodecType::Struct)
+	{
+		const int32 FirstChild = Table.Fields[NodeIndex].FirstChild;
+		const int32 NumChildren = Table.Fields[NodeIndex].NumChildren;
+		for (int32 ChildIndex = FirstChild; ChildIndex < FirstChild + NumChildren; ++ChildIndex)
+		{
+			AssignLeaves(Table, ChildIndex);
+		}
+	}
+	else
+	{
+		Table.Leaves.Add(NodeIndex);
+	}
+
+	Table.Fields[NodeIndex].EndLeaf = Table.Leaves.Num();
+}
+
+int64 FVFXDSLCodec::GetEnumValue(const FVFXDSLCodecField& Field, const void* Base)
+{
+	return Field.EnumValueProperty->GetSignedIntPropertyValue(static_cast<const uint8*>(Base) + Field.Offset);
+}
+
+void FVFXDSLCodec::SetEnumValue(const FVFXDSLCodecField& Field, void* Base, int64 Value)
+{
+	Field.EnumValueProperty->SetIntPropertyValue(static_cast<uint8*>(Base) + Field.Offset, Value);
+}
+
+const FString& FVFXDSLCodec::GetEnumName(const FVFXDSLCodecField& Field, const void* Base)
+{
+	const int64 Value = GetEnumValue(Field, Base);
+	for (const TPair<int64, FString>& Entry : Field.EnumEntries)
+	{
+		if (Entry.Key == Value)
+		{
+			return Entry.Value;
+		}
+	}
+	return Field.EnumEntries[0].Value;
+}
+
+bool FVFXDSLCodec::FindEnumValue(const FVFXDSLCodecField& Field, const FString& Name, int64& OutValue)
+{
+	for (const TPair<int64, FString>& Entry : Field.EnumEntries)
+	{
+		if (Entry.Value.Equals(Name, ESearchCase::IgnoreCase))
+		{
+			OutValue = Entry.Key;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FVFXDSLCodec::FieldDiffers(const FVFXDSLCodecField& Field, const void* OldBase, const void* NewBase)
+{
+	switch (Field.Type)
+	{
+	case EVFXDSLCodecType::Float:
+		return FMath::Abs(GetValue<float>(Field, OldBase) - GetValue<float>(Field, NewBase)) > Field.Tolerance;
+	case EVFXDSLCodecType::Int32:
+		return FMath::Abs(static_cast<float>(GetValue<int32>(Field, OldBase)) - static_cast<float>(GetValue<int32>(Field, NewBase))) > Field.Tolerance;
+	case EVFXDSLCodecType::Bool:
+		return GetValue<bool>(Field, OldBase) != GetValue<bool>(Field, NewBase);
+	case EVFXDSLCodecType::String:
+		return GetValue<FString>(Field, OldBase) != GetValue<FString>(Field, NewBase);
+	case EVFXDSLCodecType::Enum:
+		return GetEnumValue(Field, OldBase) != GetEnumValue(Field, NewBase);
+	case EVFXDSLCodecType::FloatArray:
+	{
+		const TArray<float>& OldArray = GetValue<TArray<float>>(Field, OldBase);
+		const TArray<float>& NewArray = GetValue<TArray<float>>(Field, NewBase);
+		if (OldArray.Num() != NewArray.Num())
+		{
+			return true;
+		}
+		for (int32 Index = 0; Index < OldArray.Num(); ++Index)
+		{
+			if (FMath::Abs(OldArray[Index] - NewArray[Index]) > Field.Tolerance)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+	case EVFXDSLCodecType::Struct:
+	default:
+		return false;
+	}
+}
+
+bool FVFXDSLCodec::AnyDifference(const FVFXDSLCodecTable& Table, const void* OldBase, const void* NewBase)
+{
+	for (int32 FieldIndex : Table.CompareOrder)
+	{
+		if (FieldDiffers(Table.Fields[FieldIndex], OldBase, NewBase))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FVFXDSLCodec::Compare(const FVFXDSLCodecTable& Table, const void* OldBase, const void* NewBase, const FString& PathPrefix, FVFXDSLDiffResult& OutResult)
+{
+	for (int32 FieldIndex : Table.Leaves)
+	{
+		const FVFXDSLCodecField& Field = Table.Fields[FieldIndex];
+		if (!FieldDiffers(Field, OldBase, NewBase))
+		{
+			continue;
+		}
+
+		const FString Path = PathPrefix + Field.Path;
+		const FString OldValue = FormatValue(Field, OldBase);
+		const FString NewValue = FormatValue(Field, NewBase);
+		const FString Description = Field.Type == EVFXDSLCodecType::String
+			? FString::Printf(TEXT("%s changed from '%s' to '%s'"), *Path, *OldValue, *NewValue)
+			: FString::Printf(TEXT("%s changed from %s to %s"), *Path, *OldValue, *NewValue);
+
+		// Enum fields select a kind (Effect.Type), so their changes count as type changes
+		const EVFXDSLChangeType ChangeType = Field.Type == EVFXDSLCodecType::Enum ? EVFXDSLChangeType::TypeChanged : EVFXDSLChangeType::Modified;
+		OutResult.AddChange(Path, ChangeType, OldValue, NewValue, Description);
+	}
+}
+
+FString FVFXDSLCodec::FormatValue(const FVFXDSLCodecField& Field, const void* Base)
+{
+	switch (Field.Type)
+	{
+	case EVFXDSLCodecType::Float:
+		return FString::SanitizeFloat(GetValue<float>(Field, Base));
+	case EVFXDSLCodecType::Int32:
+		return FString::SanitizeFloat(static_cast<float>(GetValue<int32>(Field, Base)));
+	case EVFXDSLCodecType::Bool:
+		return GetValue<bool>(Field, Base) ? TEXT("true") : TEXT("false");
+	case EVFXDSLCodecType::String:
+		return GetValue<FString>(Field, Base);
+	case EVFXDSLCodecType::Enum:
+		return GetEnumName(Field, Base);
+	case EVFXDSLCodecType::FloatArray:
+	{
+		TArray<FString> Elements;
+		for (float Element : GetValue<TArray<float>>(Field, Base))
+		{
+			Elements.Add(FString::SanitizeFloat(Element));
+		}
+		return FString::Printf(TEXT("[%s]"), *FString::Join(Elements, TEXT(", ")));
+	}
+	case EVFXDSLCodecType::Struct:
+	default:
+		return FString();
+	}
+}
+
+void FVFXDSLCodec::ValidateRanges(const FVFXDSLCodecTable& Table, int32 FirstLeaf, int32 EndLeaf, const void* Base, int32 EmitterIndex, FVFXDSLValidationResult& OutResult)
+{
+	for (int32 LeafIndex = FirstLeaf; LeafIndex < EndLeaf; ++LeafIndex)
+	{
+		const FVFXDSLCodecField& Field = Table.Fields[Table.Leaves[LeafIndex]];
+		if (!Field.bValidated || (Field.Type != EVFXDSLCodecType::Float && Field.Type != EVFXDSLCodecType::Int32))
+		{
+			continue;
+		}
+
+		if (Field.ConditionOffset != INDEX_NONE && !*reinterpret_cast<const bool*>(static_cast<const uint8*>(Base) + Field.ConditionOffset))
+		{
+			continue;
+		}
+
+		const double Value = GetNumber(Field, Base);
+		if (Value < Field.RangeMin || Value > Field.RangeMax)
+		{
+			OutResult.AddError(FVFXDSLValidationError(Field.RangeCode, EmitterIndex, Field.FieldId, Value));
+		}
+	}
+}
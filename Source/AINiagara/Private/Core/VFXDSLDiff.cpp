@@ -1,27 +1,14 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "Core/VFXDSLDiff.h"
-#include "Misc/DefaultValueHelper.h"
+#include "Core/VFXDSLCodec.h"
+#include "Algo/BinarySearch.h"
 
 FVFXDSLDiffResult UVFXDSLDiff::Compare(const FVFXDSL& OldDSL, const FVFXDSL& NewDSL)
 {
 	FVFXDSLDiffResult Result;
 
-	// Compare effect type first
-	if (OldDSL.Effect.Type != NewDSL.Effect.Type)
-	{
-		FString OldType = OldDSL.Effect.Type == EVFXEffectType::Niagara ? TEXT("Niagara") : TEXT("Cascade");
-		FString NewType = NewDSL.Effect.Type == EVFXEffectType::Niagara ? TEXT("Niagara") : TEXT("Cascade");
-		Result.AddChange(
-			TEXT("Effect.Type"),
-			EVFXDSLChangeType::TypeChanged,
-			OldType,
-			NewType,
-			FString::Printf(TEXT("Effect type changed from %s to %s"), *OldType, *NewType)
-		);
-	}
-
-	// Compare effect configuration
+	// Compare effect configuration (type changes are reported as TypeChanged)
 	CompareEffect(OldDSL.Effect, NewDSL.Effect, Result);
 
 	// Compare emitters
@@ -35,161 +22,266 @@ FVFXDSLDiffResult UVFXDSLDiff::Compare(const FVFXDSL& OldDSL, const FVFXDSL& New
 
 void UVFXDSLDiff::CompareEffect(const FVFXDSLEffect& OldEffect, const FVFXDSLEffect& NewEffect, FVFXDSLDiffResult& OutResult)
 {
-	CompareFloat(TEXT("Effect.Duration"), OldEffect.Duration, NewEffect.Duration, 0.001f, OutResult);
-	
-	if (OldEffect.bLooping != NewEffect.bLooping)
-	{
-		OutResult.AddChange(
-			TEXT("Effect.Looping"),
-			EVFXDSLChangeType::Modified,
-			OldEffect.bLooping ? TEXT("true") : TEXT("false"),
-			NewEffect.bLooping ? TEXT("true") : TEXT("false"),
-			FString::Printf(TEXT("Looping changed from %s to %s"), 
-				OldEffect.bLooping ? TEXT("enabled") : TEXT("disabled"),
-				NewEffect.bLooping ? TEXT("enabled") : TEXT("disabled"))
-		);
-	}
+	FVFXDSLCodec::Compare(FVFXDSLCodec::Get().GetEffectTable(), &OldEffect, &NewEffect, FString(), OutResult);
 }
 
-void UVFXDSLDiff::CompareEmitters(const TArray<FVFXDSLEmitter>& OldEmitters, const TArray<FVFXDSLEmitter>& NewEmitters, FVFXDSLDiffResult& OutResult)
+bool UVFXDSLDiff::AnyDifference(const FVFXDSL& OldDSL, const FVFXDSL& NewDSL)
 {
-	int32 MaxCount = FMath::Max(OldEmitters.Num(), NewEmitters.Num());
-
-	// Compare common emitters
-	for (int32 i = 0; i < FMath::Min(OldEmitters.Num(), NewEmitters.Num()); i++)
+	if (OldDSL.Emitters.Num() != NewDSL.Emitters.Num()
+		|| FVFXDSLCodec::AnyDifference(FVFXDSLCodec::Get().GetEffectTable(), &OldDSL.Effect, &NewDSL.Effect))
 	{
-		CompareEmitter(OldEmitters[i], NewEmitters[i], i, OutResult);
+		return true;
 	}
 
-	// Check for removed emitters
-	for (int32 i = NewEmitters.Num(); i < OldEmitters.Num(); i++)
+	// Same count and no per-index difference means Compare pairs every emitter with itself
+	for (int32 i = 0; i < NewDSL.Emitters.Num(); i++)
 	{
-		OutResult.AddChange(
-			FString::Printf(TEXT("Emitters[%d]"), i),
-			EVFXDSLChangeType::Removed,
-			OldEmitters[i].Name,
-			TEXT(""),
-			FString::Printf(TEXT("Emitter '%s' removed"), *OldEmitters[i].Name)
-		);
+		if (EmitterDiffers(OldDSL.Emitters[i], NewDSL.Emitters[i]))
+		{
+			return true;
+		}
 	}
 
-	// Check for added emitters
-	for (int32 i = OldEmitters.Num(); i < NewEmitters.Num(); i++)
-	{
-		OutResult.AddChange(
-			FString::Printf(TEXT("Emitters[%d]"), i),
-			EVFXDSLChangeType::Added,
-			TEXT(""),
-			NewEmitters[i].Name,
-			FString::Printf(TEXT("Emitter '%s' added"), *NewEmitters[i].Name)
-		);
-	}
+	return false;
 }
 
-void UVFXDSLDiff::CompareEmitter(const FVFXDSLEmitter& OldEmitter, const FVFXDSLEmitter& NewEmitter, int32 Index, FVFXDSLDiffResult& OutResult)
+bool UVFXDSLDiff::EmitterDiffers(const FVFXDSLEmitter& OldEmitter, const FVFXDSLEmitter& NewEmitter)
 {
-	FString BasePath = FString::Printf(TEXT("Emitters[%d]"), Index);
+	// Numeric fields first; strings are the most expensive to compare
+	return FVFXDSLCodec::AnyDifference(FVFXDSLCodec::Get().GetEmitterTable(), &OldEmitter, &NewEmitter);
+}
 
-	// Compare name
-	CompareString(BasePath + TEXT(".Name"), OldEmitter.Name, NewEmitter.Name, OutResult);
+void UVFXDSLDiff::MatchEmitters(const TArray<FVFXDSLEmitter>& OldEmitters, const TArray<FVFXDSLEmitter>& NewEmitters, TArray<int32>& OutNewToOld)
+{
+	OutNewToOld.Init(INDEX_NONE, NewEmitters.Num());
+	TBitArray<> OldMatched(false, OldEmitters.Num());
 
-	// Compare spawners
-	CompareSpawners(OldEmitter.Spawners, NewEmitter.Spawners, BasePath + TEXT(".Spawners"), OutResult);
+	// 1. Pair emitters whose name is unique in both versions
+	auto IndexUniqueNames = [](const TArray<FVFXDSLEmitter>& Emitters, TMap<FString, int32>& OutIndex)
+	{
+		OutIndex.Reserve(Emitters.Num());
+		for (int32 i = 0; i < Emitters.Num(); i++)
+		{
+			if (int32* Existing = OutIndex.Find(Emitters[i].Name))
+			{
+				*Existing = INDEX_NONE;
+			}
+			else
+			{
+				OutIndex.Add(Emitters[i].Name, i);
+			}
+		}
+	};
 
-	// Compare initialization
-	CompareInitialization(OldEmitter.Initialization, NewEmitter.Initialization, BasePath + TEXT(".Initialization"), OutResult);
+	TMap<FString, int32> OldByName;
+	TMap<FString, int32> NewByName;
+	IndexUniqueNames(OldEmitters, OldByName);
+	IndexUniqueNames(NewEmitters, NewByName);
 
-	// Compare update
-	CompareUpdate(OldEmitter.Update, NewEmitter.Update, BasePath + TEXT(".Update"), OutResult);
+	for (int32 NewIndex = 0; NewIndex < NewEmitters.Num(); NewIndex++)
+	{
+		const int32* OldIndex = OldByName.Find(NewEmitters[NewIndex].Name);
+		if (OldIndex && *OldIndex != INDEX_NONE && NewByName.FindChecked(NewEmitters[NewIndex].Name) == NewIndex)
+		{
+			OutNewToOld[NewIndex] = *OldIndex;
+			OldMatched[*OldIndex] = true;
+		}
+	}
 
-	// Compare render
-	CompareRender(OldEmitter.Render, NewEmitter.Render, BasePath + TEXT(".Render"), OutResult);
-}
+	TArray<int32> LeftOld;
+	TArray<int32> LeftNew;
+	for (int32 i = 0; i < OldEmitters.Num(); i++)
+	{
+		if (!OldMatched[i])
+		{
+			LeftOld.Add(i);
+		}
+	}
+	for (int32 i = 0; i < NewEmitters.Num(); i++)
+	{
+		if (OutNewToOld[i] == INDEX_NONE)
+		{
+			LeftNew.Add(i);
+		}
+	}
 
-void UVFXDSLDiff::CompareSpawners(const FVFXDSLSpawners& OldSpawners, const FVFXDSLSpawners& NewSpawners, const FString& BasePath, FVFXDSLDiffResult& OutResult)
-{
-	CompareFloat(BasePath + TEXT(".Rate.SpawnRate"), OldSpawners.Rate.SpawnRate, NewSpawners.Rate.SpawnRate, 0.001f, OutResult);
-	CompareFloat(BasePath + TEXT(".Rate.ScaleOverTime"), OldSpawners.Rate.ScaleOverTime, NewSpawners.Rate.ScaleOverTime, 0.001f, OutResult);
-	
-	CompareFloat(BasePath + TEXT(".Burst.Count"), (float)OldSpawners.Burst.Count, (float)NewSpawners.Burst.Count, 0.5f, OutResult);
-	CompareFloat(BasePath + TEXT(".Burst.Time"), OldSpawners.Burst.Time, NewSpawners.Burst.Time, 0.001f, OutResult);
-}
+	// 2. Align the remaining emitters (renamed, duplicate or empty names) by content with an LCS
+	if (LeftOld.Num() > 0 && LeftNew.Num() > 0 && static_cast<int64>(LeftOld.Num()) * LeftNew.Num() <= MaxLCSCells)
+	{
+		const int32 Rows = LeftOld.Num();
+		const int32 Cols = LeftNew.Num();
+		TArray<int32> Lengths;
+		Lengths.SetNumZeroed((Rows + 1) * (Cols + 1));
+		auto Cell = [&Lengths, Cols](int32 Row, int32 Col) -> int32& { return Lengths[Row * (Cols + 1) + Col]; };
 
-void UVFXDSLDiff::CompareInitialization(const FVFXDSLInitialization& OldInit, const FVFXDSLInitialization& NewInit, const FString& BasePath, FVFXDSLDiffResult& OutResult)
-{
-	CompareColor(BasePath + TEXT(".Color"), OldInit.Color, NewInit.Color, OutResult);
-	CompareFloat(BasePath + TEXT(".Size.Min"), OldInit.Size.Min, NewInit.Size.Min, 0.001f, OutResult);
-	CompareFloat(BasePath + TEXT(".Size.Max"), OldInit.Size.Max, NewInit.Size.Max, 0.001f, OutResult);
-	CompareVelocity(BasePath + TEXT(".Velocity"), OldInit.Velocity, NewInit.Velocity, OutResult);
-}
+		for (int32 Row = Rows - 1; Row >= 0; Row--)
+		{
+			for (int32 Col = Cols - 1; Col >= 0; Col--)
+			{
+				Cell(Row, Col) = !EmitterDiffers(OldEmitters[LeftOld[Row]], NewEmitters[LeftNew[Col]])
+					? Cell(Row + 1, Col + 1) + 1
+					: FMath::Max(Cell(Row + 1, Col), Cell(Row, Col + 1));
+			}
+		}
 
-void UVFXDSLDiff::CompareUpdate(const FVFXDSLUpdate& OldUpdate, const FVFXDSLUpdate& NewUpdate, const FString& BasePath, FVFXDSLDiffResult& OutResult)
-{
-	CompareFloat(BasePath + TEXT(".Forces.Gravity"), OldUpdate.Forces.Gravity, NewUpdate.Forces.Gravity, 0.001f, OutResult);
-	CompareVelocity(BasePath + TEXT(".Forces.Wind"), OldUpdate.Forces.Wind, NewUpdate.Forces.Wind, OutResult);
-	CompareFloat(BasePath + TEXT(".Drag"), OldUpdate.Drag, NewUpdate.Drag, 0.001f, OutResult);
-	
-	if (OldUpdate.Collision.bEnabled != NewUpdate.Collision.bEnabled)
+		int32 Row = 0;
+		int32 Col = 0;
+		while (Row < Rows && Col < Cols)
+		{
+			if (Cell(Row, Col) == Cell(Row + 1, Col + 1) + 1 && !EmitterDiffers(OldEmitters[LeftOld[Row]], NewEmitters[LeftNew[Col]]))
+			{
+				OutNewToOld[LeftNew[Col]] = LeftOld[Row];
+				OldMatched[LeftOld[Row]] = true;
+				Row++;
+				Col++;
+			}
+			else if (Cell(Row + 1, Col) >= Cell(Row, Col + 1))
+			{
+				Row++;
+			}
+			else
+			{
+				Col++;
+			}
+		}
+	}
+
+	// 3. Pair whatever is still left in order; these are edited emitters (e.g. renamed and retuned)
+	int32 NextOld = 0;
+	for (int32 NewIndex : LeftNew)
 	{
-		OutResult.AddChange(
-			BasePath + TEXT(".Collision.Enabled"),
-			EVFXDSLChangeType::Modified,
-			OldUpdate.Collision.bEnabled ? TEXT("true") : TEXT("false"),
-			NewUpdate.Collision.bEnabled ? TEXT("true") : TEXT("false"),
-			TEXT("Collision enabled state changed")
-		);
+		if (OutNewToOld[NewIndex] != INDEX_NONE)
+		{
+			continue;
+		}
+
+		while (NextOld < LeftOld.Num() && OldMatched[LeftOld[NextOld]])
+		{
+			NextOld++;
+		}
+		if (NextOld == LeftOld.Num())
+		{
+			break;
+		}
+
+		OutNewToOld[NewIndex] = LeftOld[NextOld];
+		OldMatched[LeftOld[NextOld]] = true;
 	}
-	CompareFloat(BasePath + TEXT(".Collision.Bounce"), OldUpdate.Collision.Bounce, NewUpdate.Collision.Bounce, 0.001f, OutResult);
 }
 
-void UVFXDSLDiff::CompareRender(const FVFXDSLRender& OldRender, const FVFXDSLRender& NewRender, const FString& BasePath, FVFXDSLDiffResult& OutResult)
+void UVFXDSLDiff::CompareEmitters(const TArray<FVFXDSLEmitter>& OldEmitters, const TArray<FVFXDSLEmitter>& NewEmitters, FVFXDSLDiffResult& OutResult)
 {
-	CompareString(BasePath + TEXT(".Material"), OldRender.Material, NewRender.Material, OutResult);
-	CompareString(BasePath + TEXT(".Texture"), OldRender.Texture, NewRender.Texture, OutResult);
-	CompareString(BasePath + TEXT(".BlendMode"), OldRender.BlendMode, NewRender.BlendMode, OutResult);
-	CompareString(BasePath + TEXT(".Sort"), OldRender.Sort, NewRender.Sort, OutResult);
-}
+	// Fast path: identical order, only field edits
+	if (OldEmitters.Num() == NewEmitters.Num())
+	{
+		bool bSameNames = true;
+		for (int32 i = 0; i < NewEmitters.Num() && bSameNames; i++)
+		{
+			bSameNames = OldEmitters[i].Name == NewEmitters[i].Name;
+		}
 
-void UVFXDSLDiff::CompareFloat(const FString& Path, float OldValue, float NewValue, float Tolerance, FVFXDSLDiffResult& OutResult)
-{
-	if (FMath::Abs(OldValue - NewValue) > Tolerance)
+		if (bSameNames)
+		{
+			for (int32 i = 0; i < NewEmitters.Num(); i++)
+			{
+				if (EmitterDiffers(OldEmitters[i], NewEmitters[i]))
+				{
+					CompareEmitter(OldEmitters[i], NewEmitters[i], i, OutResult);
+				}
+			}
+			return;
+		}
+	}
+
+	TArray<int32> NewToOld;
+	MatchEmitters(OldEmitters, NewEmitters, NewToOld);
+
+	// Matched emitters whose relative order changed are the ones outside the
+	// longest increasing run of old indices (patience sorting)
+	TBitArray<> InOrder(false, NewEmitters.Num());
 	{
-		OutResult.AddChange(
-			Path,
-			EVFXDSLChangeType::Modified,
-			FString::SanitizeFloat(OldValue),
-			FString::SanitizeFloat(NewValue),
-			FString::Printf(TEXT("%s changed from %s to %s"), *Path, *FString::SanitizeFloat(OldValue), *FString::SanitizeFloat(NewValue))
-		);
+		TArray<int32> TailNew;
+		TArray<int32> Previous;
+		Previous.Init(INDEX_NONE, NewEmitters.Num());
+		for (int32 NewIndex = 0; NewIndex < NewEmitters.Num(); NewIndex++)
+		{
+			const int32 OldIndex = NewToOld[NewIndex];
+			if (OldIndex == INDEX_NONE)
+			{
+				continue;
+			}
+
+			const int32 Position = Algo::LowerBoundBy(TailNew, OldIndex, [&NewToOld](int32 Tail) { return NewToOld[Tail]; });
+			Previous[NewIndex] = Position > 0 ? TailNew[Position - 1] : INDEX_NONE;
+			if (Position == TailNew.Num())
+			{
+				TailNew.Add(NewIndex);
+			}
+			else
+			{
+				TailNew[Position] = NewIndex;
+			}
+		}
+
+		for (int32 NewIndex = TailNew.Num() > 0 ? TailNew.Last() : INDEX_NONE; NewIndex != INDEX_NONE; NewIndex = Previous[NewIndex])
+		{
+			InOrder[NewIndex] = true;
+		}
 	}
-}
 
-void UVFXDSLDiff::CompareString(const FString& Path, const FString& OldValue, const FString& NewValue, FVFXDSLDiffResult& OutResult)
-{
-	if (OldValue != NewValue)
+	TBitArray<> OldMatched(false, OldEmitters.Num());
+	for (int32 NewIndex = 0; NewIndex < NewEmitters.Num(); NewIndex++)
 	{
-		OutResult.AddChange(
-			Path,
-			EVFXDSLChangeType::Modified,
-			OldValue,
-			NewValue,
-			FString::Printf(TEXT("%s changed from '%s' to '%s'"), *Path, *OldValue, *NewValue)
-		);
+		const int32 OldIndex = NewToOld[NewIndex];
+		if (OldIndex == INDEX_NONE)
+		{
+			OutResult.AddChange(
+				FString::Printf(TEXT("Emitters[%d]"), NewIndex),
+				EVFXDSLChangeType::Added,
+				TEXT(""),
+				NewEmitters[NewIndex].Name,
+				FString::Printf(TEXT("Emitter '%s' added"), *NewEmitters[NewIndex].Name)
+			);
+			continue;
+		}
+
+		OldMatched[OldIndex] = true;
+
+		if (!InOrder[NewIndex])
+		{
+			OutResult.AddChange(
+				FString::Printf(TEXT("Emitters[%d]"), NewIndex),
+				EVFXDSLChangeType::Modified,
+				FString::FromInt(OldIndex),
+				FString::FromInt(NewIndex),
+				FString::Printf(TEXT("Emitter '%s' moved from index %d to %d"), *NewEmitters[NewIndex].Name, OldIndex, NewIndex)
+			);
+		}
+
+		if (EmitterDiffers(OldEmitters[OldIndex], NewEmitters[NewIndex]))
+		{
+			CompareEmitter(OldEmitters[OldIndex], NewEmitters[NewIndex], NewIndex, OutResult);
+		}
 	}
-}
 
-void UVFXDSLDiff::CompareColor(const FString& Path, const FVFXDSLColor& OldColor, const FVFXDSLColor& NewColor, FVFXDSLDiffResult& OutResult)
-{
-	CompareFloat(Path + TEXT(".R"), OldColor.R, NewColor.R, 0.01f, OutResult);
-	CompareFloat(Path + TEXT(".G"), OldColor.G, NewColor.G, 0.01f, OutResult);
-	CompareFloat(Path + TEXT(".B"), OldColor.B, NewColor.B, 0.01f, OutResult);
-	CompareFloat(Path + TEXT(".A"), OldColor.A, NewColor.A, 0.01f, OutResult);
+	// Removed emitters keep their old index in the path
+	for (int32 OldIndex = 0; OldIndex < OldEmitters.Num(); OldIndex++)
+	{
+		if (!OldMatched[OldIndex])
+		{
+			OutResult.AddChange(
+				FString::Printf(TEXT("Emitters[%d]"), OldIndex),
+				EVFXDSLChangeType::Removed,
+				OldEmitters[OldIndex].Name,
+				TEXT(""),
+				FString::Printf(TEXT("Emitter '%s' removed"), *OldEmitters[OldIndex].Name)
+			);
+		}
+	}
 }
 
-void UVFXDSLDiff::CompareVelocity(const FString& Path, const FVFXDSLVelocity& OldVel, const FVFXDSLVelocity& NewVel, FVFXDSLDiffResult& OutResult)
+void UVFXDSLDiff::CompareEmitter(const FVFXDSLEmitter& OldEmitter, const FVFXDSLEmitter& NewEmitter, int32 Index, FVFXDSLDiffResult& OutResult)
 {
-	CompareFloat(Path + TEXT(".X"), OldVel.X, NewVel.X, 0.001f, OutResult);
-	CompareFloat(Path + TEXT(".Y"), OldVel.Y, NewVel.Y, 0.001f, OutResult);
-	CompareFloat(Path + TEXT(".Z"), OldVel.Z, NewVel.Z, 0.001f, OutResult);
+	const FString BasePath = FString::Printf(TEXT("Emitters[%d]."), Index);
+	FVFXDSLCodec::Compare(FVFXDSLCodec::Get().GetEmitterTable(), &OldEmitter, &NewEmitter, BasePath, OutResult);
 }
-
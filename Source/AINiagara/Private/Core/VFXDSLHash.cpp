@@ -0,0 +1,138 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/VFXDSLHash.h"
+#include "Hash/xxhash.h"
+
+namespace
+{
+	/** Streams DSL fields into an XXH64 builder: integers as little-endian bytes, strings as UTF-8 */
+	struct FDSLHashWriter
+	{
+		FXxHash64Builder Builder;
+
+		void Int(int64 Value)
+		{
+			uint8 Bytes[sizeof(int64)];
+			for (int32 Index = 0; Index < UE_ARRAY_COUNT(Bytes); ++Index)
+			{
+				Bytes[Index] = static_cast<uint8>(static_cast<uint64>(Value) >> (Index * 8));
+			}
+			Builder.Update(Bytes, sizeof(Bytes));
+		}
+
+		void Bool(bool bValue)
+		{
+			const uint8 Byte = bValue ? 1 : 0;
+			Builder.Update(&Byte, sizeof(Byte));
+		}
+
+		/** Quantize to multiples of Tolerance; non-finite values map to fixed sentinels */
+		void Float(float Value, float Tolerance)
+		{
+			if (!FMath::IsFinite(Value))
+			{
+				Int(FMath::IsNaN(Value) ? MIN_int64 : (Value > 0.0f ? MAX_int64 : MIN_int64 + 1));
+				return;
+			}
+
+			const double Steps = FMath::RoundToDouble(static_cast<double>(Value) / Tolerance);
+			Int(static_cast<int64>(FMath::Clamp(Steps, -9.0e18, 9.0e18)));
+		}
+
+		/** Length-prefixed so that ("ab", "c") and ("a", "bc") differ */
+		void String(const FString& Value)
+		{
+			// TCHAR width differs between platforms; UTF-8 does not
+			FTCHARToUTF8 Utf8(*Value, Value.Len());
+			Int(Utf8.Length());
+			Builder.Update(Utf8.Get(), Utf8.Length());
+		}
+
+		void Velocity(const FVFXDSLVelocity& Velocity)
+		{
+			Float(Velocity.X, VFXDSLTolerance::Default);
+			Float(Velocity.Y, VFXDSLTolerance::Default);
+			Float(Velocity.Z, VFXDSLTolerance::Default);
+		}
+
+		void Emitter(const FVFXDSLEmitter& Emitter)
+		{
+			String(Emitter.Name);
+
+			const FVFXDSLSpawners& Spawners = Emitter.Spawners;
+			Int(Spawners.Burst.Count);
+			Float(Spawners.Burst.Time, VFXDSLTolerance::Default);
+			Int(Spawners.Burst.Intervals.Num());
+			for (float Interval : Spawners.Burst.Intervals)
+			{
+				Float(Interval, VFXDSLTolerance::Default);
+			}
+			Float(Spawners.Rate.SpawnRate, VFXDSLTolerance::Default);
+			Float(Spawners.Rate.ScaleOverTime, VFXDSLTolerance::Default);
+
+			const FVFXDSLInitialization& Init = Emitter.Initialization;
+			Float(Init.Color.R, VFXDSLTolerance::Color);
+			Float(Init.Color.G, VFXDSLTolerance::Color);
+			Float(Init.Color.B, VFXDSLTolerance::Color);
+			Float(Init.Color.A, VFXDSLTolerance::Color);
+			Float(Init.Size.Min, VFXDSLTolerance::Default);
+			Float(Init.Size.Max, VFXDSLTolerance::Default);
+			Velocity(Init.Velocity);
+
+			const FVFXDSLUpdate& Update = Emitter.Update;
+			Float(Update.Forces.Gravity, VFXDSLTolerance::Default);
+			Velocity(Update.Forces.Wind);
+			Float(Update.Drag, VFXDSLTolerance::Default);
+			Bool(Update.Collision.bEnabled);
+			Float(Update.Collision.Bounce, VFXDSLTolerance::Default);
+
+			const FVFXDSLRender& Render = Emitter.Render;
+			String(Render.Material);
+			String(Render.Texture);
+			String(Render.BlendMode);
+			String(Render.Sort);
+			String(Render.Mesh.MeshPath);
+			String(Render.Mesh.MeshType);
+			Float(Render.Mesh.Scale, VFXDSLTolerance::Default);
+			Velocity(Render.Mesh.Rotation);
+			Bool(Render.Mesh.bUseMesh);
+		}
+
+		uint64 Finalize()
+		{
+			const uint64 Hash = Builder.Finalize().Hash;
+			return Hash != 0 ? Hash : 1;
+		}
+	};
+}
+
+uint64 FVFXDSLHash::Hash(const FVFXDSL& DSL)
+{
+	FDSLHashWriter Writer;
+	Writer.Int(FormatVersion);
+
+	Writer.Int(static_cast<int64>(DSL.Effect.Type));
+	Writer.Float(DSL.Effect.Duration, VFXDSLTolerance::Default);
+	Writer.Bool(DSL.Effect.bLooping);
+
+	Writer.Int(DSL.Emitters.Num());
+	for (const FVFXDSLEmitter& Emitter : DSL.Emitters)
+	{
+		Writer.Emitter(Emitter);
+	}
+
+	return Writer.Finalize();
+}
+
+uint64 FVFXDSLHash::HashEmitter(const FVFXDSLEmitter& Emitter)
+{
+	FDSLHashWriter Writer;
+	Writer.Int(FormatVersion);
+	Writer.Emitter(Emitter);
+	return Writer.Finalize();
+}
+
+FString FVFXDSLHash::ToString(uint64 Hash)
+{
+	return FString::Printf(TEXT("%016llx"), Hash);
+}
@@ -0,0 +1,337 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/VFXDSLIncrementalParser.h"
+#include "Core/VFXDSLParser.h"
+#include "Core/VFXDSLStreamParser.h"
+
+namespace
+{
+	/** Length of the UTF-8 sequence introduced by a lead byte (invalid bytes count as one) */
+	int32 GetUTF8SequenceLength(uint8 LeadByte)
+	{
+		if (LeadByte < 0x80)
+		{
+			return 1;
+		}
+		if ((LeadByte & 0xE0) == 0xC0)
+		{
+			return 2;
+		}
+		if ((LeadByte & 0xF0) == 0xE0)
+		{
+			return 3;
+		}
+		if ((LeadByte & 0xF8) == 0xF0)
+		{
+			return 4;
+		}
+		return 1;
+	}
+}
+
+FVFXDSLIncrementalParser::FVFXDSLIncrementalParser()
+{
+}
+
+void FVFXDSLIncrementalParser::AppendChunk(FStringView Chunk)
+{
+	Buffer.Append(Chunk.GetData(), Chunk.Len());
+	Scan();
+}
+
+void FVFXDSLIncrementalParser::AppendUTF8(TConstArrayView<uint8> Bytes)
+{
+	int32 Consumed = 0;
+
+	// Complete a sequence split across the previous call first
+	if (PendingUTF8.Num() > 0)
+	{
+		const int32 ExpectedLength = GetUTF8SequenceLength(PendingUTF8[0]);
+		while (Consumed < Bytes.Num() && PendingUTF8.Num() < ExpectedLength)
+		{
+			PendingUTF8.Add(Bytes[Consumed++]);
+		}
+
+		if (PendingUTF8.Num() < ExpectedLength)
+		{
+			return;
+		}
+
+		FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(PendingUTF8.GetData()), PendingUTF8.Num());
+		PendingUTF8.Reset();
+		Buffer.Append(Converted.Get(), Converted.Length());
+	}
+
+	// Hold back a trailing sequence that is not complete yet
+	int32 CompleteEnd = Bytes.Num();
+	for (int32 Back = 1; Back <= 3 && Bytes.Num() - Back >= Consumed; ++Back)
+	{
+		const uint8 Byte = Bytes[Bytes.Num() - Back];
+		if ((Byte & 0xC0) == 0x80)
+		{
+			continue;
+		}
+
+		if (GetUTF8SequenceLength(Byte) > Back)
+		{
+			CompleteEnd = Bytes.Num() - Back;
+		}
+		break;
+	}
+
+	if (CompleteEnd > Consumed)
+	{
+		FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Bytes.GetData() + Consumed), CompleteEnd - Consumed);
+		Buffer.Append(Converted.Get(), Converted.Length());
+	}
+
+	for (int32 Index = CompleteEnd; Index < Bytes.Num(); ++Index)
+	{
+		PendingUTF8.Add(Bytes[Index]);
+	}
+
+	Scan();
+}
+
+bool FVFXDSLIncrementalParser::Finish(FVFXDSL& OutDSL, FString& OutError) const
+{
+	if (!HasStarted())
+	{
+		return UVFXDSLParser::ParseFromJSON(Buffer, OutDSL, OutError);
+	}
+
+	return UVFXDSLParser::ParseFromJSON(FString(GetJsonText()), OutDSL, OutError);
+}
+
+void FVFXDSLIncrementalParser::Reset()
+{
+	Buffer.Reset();
+	ScanOffset = 0;
+	RootStart = INDEX_NONE;
+	RootEnd = INDEX_NONE;
+	Depth = 0;
+	bInString = false;
+	bEscaped = false;
+	bInFenceLine = false;
+	bAtFenceBody = false;
+	bRootExpectsKey = false;
+	bReadingRootKey = false;
+	RootKey.Reset();
+	bInEmittersArray = false;
+	EmitterValueIndex = 0;
+	TrackedObjectStart = INDEX_NONE;
+	bTrackingEffect = false;
+	NumEmittersParsed = 0;
+	PendingUTF8.Reset();
+}
+
+FStringView FVFXDSLIncrementalParser::GetJsonText() const
+{
+	if (RootStart == INDEX_NONE)
+	{
+		return FStringView();
+	}
+
+	const int32 End = (RootEnd != INDEX_NONE) ? RootEnd + 1 : Buffer.Len();
+	return FStringView(Buffer).Mid(RootStart, End - RootStart);
+}
+
+bool FVFXDSLIncrementalParser::IsRootStart(int32 Offset, bool& bOutNeedMoreText) const
+{
+	bOutNeedMoreText = false;
+	if (bAtFenceBody)
+	{
+		return true;
+	}
+
+	// A DSL object opens with a key (or is empty); prose braces hold words
+	for (int32 Next = Offset + 1; Next < Buffer.Len(); ++Next)
+	{
+		if (!FChar::IsWhitespace(Buffer[Next]))
+		{
+			return Buffer[Next] == TEXT('"') || Buffer[Next] == TEXT('}');
+		}
+	}
+
+	bOutNeedMoreText = true;
+	return false;
+}
+
+void FVFXDSLIncrementalParser::Scan()
+{
+	// A delegate appending text would otherwise re-enter mid-character; the running loop picks the text up
+	if (bScanning)
+	{
+		return;
+	}
+	TGuardValue<bool> ScanGuard(bScanning, true);
+
+	// Buffer is indexed rather than iterated so delegates may append while we scan
+	for (; ScanOffset < Buffer.Len() && RootEnd == INDEX_NONE; ++ScanOffset)
+	{
+		const TCHAR Char = Buffer[ScanOffset];
+
+		if (RootStart == INDEX_NONE)
+		{
+			if (Char == TEXT('{'))
+			{
+				bool bNeedMoreText = false;
+				if (IsRootStart(ScanOffset, bNeedMoreText))
+				{
+					RootStart = ScanOffset;
+					Depth = 1;
+					bRootExpectsKey = true;
+				}
+				else if (bNeedMoreText)
+				{
+					// Decide once the next character arrives
+					return;
+				}
+			}
+			else if (Char == TEXT('`') && ScanOffset >= 2 && Buffer[ScanOffset - 1] == TEXT('`') && Buffer[ScanOffset - 2] == TEXT('`'))
+			{
+				bInFenceLine = true;
+			}
+			else if (Char == TEXT('\n') && bInFenceLine)
+			{
+				bInFenceLine = false;
+				bAtFenceBody = true;
+				continue;
+			}
+
+			if (!FChar::IsWhitespace(Char))
+			{
+				bAtFenceBody = false;
+			}
+			continue;
+		}
+
+		if (bInString)
+		{
+			if (bEscaped)
+			{
+				bEscaped = false;
+			}
+			else if (Char == TEXT('\\'))
+			{
+				bEscaped = true;
+				continue;
+			}
+			else if (Char == TEXT('"'))
+			{
+				bInString = false;
+				bReadingRootKey = false;
+				continue;
+			}
+
+			if (bReadingRootKey)
+			{
+				RootKey.AppendChar(Char);
+			}
+			continue;
+		}
+
+		switch (Char)
+		{
+		case TEXT('"'):
+			bInString = true;
+			if (Depth == 1 && bRootExpectsKey)
+			{
+				bReadingRootKey = true;
+				RootKey.Reset();
+			}
+			break;
+
+		case TEXT(':'):
+			if (Depth == 1)
+			{
+				bRootExpectsKey = false;
+			}
+			break;
+
+		case TEXT(','):
+			if (Depth == 1)
+			{
+				bRootExpectsKey = true;
+			}
+			else if (Depth == 2 && bInEmittersArray)
+			{
+				++EmitterValueIndex;
+			}
+			break;
+
+		case TEXT('{'):
+			++Depth;
+			if (TrackedObjectStart == INDEX_NONE)
+			{
+				if (Depth == 2 && RootKey == TEXT("effect"))
+				{
+					TrackedObjectStart = ScanOffset;
+					bTrackingEffect = true;
+				}
+				else if (Depth == 3 && bInEmittersArray)
+				{
+					TrackedObjectStart = ScanOffset;
+					bTrackingEffect = false;
+				}
+			}
+			break;
+
+		case TEXT('['):
+			++Depth;
+			if (Depth == 2 && RootKey == TEXT("emitters"))
+			{
+				bInEmittersArray = true;
+				EmitterValueIndex = 0;
+			}
+			break;
+
+		case TEXT('}'):
+			if (TrackedObjectStart != INDEX_NONE && Depth == (bTrackingEffect ? 2 : 3))
+			{
+				OnObjectClosed(ScanOffset);
+			}
+			if (--Depth == 0)
+			{
+				RootEnd = ScanOffset;
+			}
+			break;
+
+		case TEXT(']'):
+			if (Depth == 2 && bInEmittersArray)
+			{
+				bInEmittersArray = false;
+			}
+			--Depth;
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+void FVFXDSLIncrementalParser::OnObjectClosed(int32 EndOffset)
+{
+	const FStringView ObjectText = FStringView(Buffer).Mid(TrackedObjectStart, EndOffset - TrackedObjectStart + 1);
+	const bool bWasEffect = bTrackingEffect;
+	TrackedObjectStart = INDEX_NONE;
+	bTrackingEffect = false;
+
+	if (bWasEffect)
+	{
+		FVFXDSLEffect Effect;
+		if (FVFXDSLStreamParser::ParseEffect(ObjectText, Effect))
+		{
+			OnEffectParsed.ExecuteIfBound(Effect);
+		}
+		return;
+	}
+
+	FVFXDSLEmitter Emitter;
+	if (FVFXDSLStreamParser::ParseEmitter(ObjectText, Emitter))
+	{
+		++NumEmittersParsed;
+		OnEmitterParsed.ExecuteIfBound(EmitterValueIndex, Emitter);
+	}
+}
@@ -1,10 +1,56 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "Core/VFXDSLParser.h"
+#include "Core/VFXDSLStreamParser.h"
+#include "Core/VFXDSLCodec.h"
+#include "Core/JsonStringAppendArchive.h"
 #include "Dom/JsonObject.h"
 #include "Serialization/JsonSerializer.h"
 #include "Serialization/JsonWriter.h"
+#include "Serialization/MemoryWriter.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
 #include "Misc/EnumRange.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	/**
+	 * Write a DSL with any TJsonWriter.
+	 * Effect and emitter members come from the FVFXDSLCodec tables in declaration order; ToJSONDOM builds
+	 * the same layout by hand, which keeps pretty output byte-identical to the DOM path.
+	 */
+	template <class CharType, class PrintPolicy>
+	void WriteDSL(TJsonWriter<CharType, PrintPolicy>& Writer, const FVFXDSL& DSL)
+	{
+		const FVFXDSLCodec& Codec = FVFXDSLCodec::Get();
+
+		Writer.WriteObjectStart();
+
+		Writer.WriteObjectStart(TEXT("effect"));
+		FVFXDSLCodec::WriteFields(Writer, Codec.GetEffectTable(), 0, &DSL.Effect);
+		Writer.WriteObjectEnd();
+
+		Writer.WriteArrayStart(TEXT("emitters"));
+		for (const FVFXDSLEmitter& Emitter : DSL.Emitters)
+		{
+			Writer.WriteObjectStart();
+			FVFXDSLCodec::WriteFields(Writer, Codec.GetEmitterTable(), 0, &Emitter);
+			Writer.WriteObjectEnd();
+		}
+		Writer.WriteArrayEnd();
+
+		Writer.WriteObjectEnd();
+	}
+
+	template <class CharType, class PrintPolicy>
+	bool WriteDSLToArchive(FArchive& Archive, const FVFXDSL& DSL)
+	{
+		TSharedRef<TJsonWriter<CharType, PrintPolicy>> Writer = TJsonWriterFactory<CharType, PrintPolicy>::Create(&Archive);
+		WriteDSL(*Writer, DSL);
+		return Writer->Close();
+	}
+}
 
 /**
  * Parses a VFX DSL specification from a JSON string.
@@ -27,8 +73,14 @@
  * @note Requires at least one emitter in the emitters array
  * @note Validates JSON structure and required fields before parsing
  * @note On failure, OutError contains a descriptive error message
+ * @note Uses the single-pass FVFXDSLStreamParser; ParseFromJSONDOM is the DOM reference
  */
 bool UVFXDSLParser::ParseFromJSON(const FString& JsonString, FVFXDSL& OutDSL, FString& OutError)
+{
+	return FVFXDSLStreamParser::Parse(JsonString, OutDSL, OutError);
+}
+
+bool UVFXDSLParser::ParseFromJSONDOM(const FString& JsonString, FVFXDSL& OutDSL, FString& OutError)
 {
 	TSharedPtr<FJsonObject> JsonObject;
 	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonString);
@@ -83,6 +135,56 @@ bool UVFXDSLParser::ParseFromJSON(const FString& JsonString, FVFXDSL& OutDSL, FS
 }
 
 bool UVFXDSLParser::ToJSON(const FVFXDSL& DSL, FString& OutJsonString)
+{
+	return ToJSONWithFormat(DSL, EVFXDSLJsonFormat::Pretty, OutJsonString);
+}
+
+bool UVFXDSLParser::ToJSONWithFormat(const FVFXDSL& DSL, EVFXDSLJsonFormat Format, FString& OutJsonString)
+{
+	OutJsonString.Reset(EstimateJSONLength(DSL, Format));
+
+	FJsonStringAppendArchive Archive(OutJsonString);
+	if (Format == EVFXDSLJsonFormat::Condensed)
+	{
+		return WriteDSLToArchive<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>(Archive, DSL);
+	}
+	return WriteDSLToArchive<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>(Archive, DSL);
+}
+
+bool UVFXDSLParser::ToJSONUTF8(const FVFXDSL& DSL, EVFXDSLJsonFormat Format, TArray<uint8>& OutBytes)
+{
+	OutBytes.Reset(EstimateJSONLength(DSL, Format));
+
+	FMemoryWriter Archive(OutBytes);
+	if (Format == EVFXDSLJsonFormat::Condensed)
+	{
+		return WriteDSLToArchive<UTF8CHAR, TCondensedJsonPrintPolicy<UTF8CHAR>>(Archive, DSL);
+	}
+	return WriteDSLToArchive<UTF8CHAR, TPrettyJsonPrintPolicy<UTF8CHAR>>(Archive, DSL);
+}
+
+int32 UVFXDSLParser::EstimateJSONLength(const FVFXDSL& DSL, EVFXDSLJsonFormat Format)
+{
+	// Measured on typical emitters: ~1.4k characters pretty-printed, ~0.6k condensed, plus string payloads
+	const int32 PerEmitter = (Format == EVFXDSLJsonFormat::Pretty) ? 1408 : 640;
+
+	int32 Estimate = 160;
+	for (const FVFXDSLEmitter& Emitter : DSL.Emitters)
+	{
+		Estimate += PerEmitter
+			+ Emitter.Name.Len()
+			+ Emitter.Render.Material.Len()
+			+ Emitter.Render.Texture.Len()
+			+ Emitter.Render.BlendMode.Len()
+			+ Emitter.Render.Sort.Len()
+			+ Emitter.Render.Mesh.MeshPath.Len()
+			+ Emitter.Render.Mesh.MeshType.Len()
+			+ Emitter.Spawners.Burst.Intervals.Num() * 24;
+	}
+	return Estimate;
+}
+
+bool UVFXDSLParser::ToJSONDOM(const FVFXDSL& DSL, FString& OutJsonString)
 {
 	TSharedPtr<FJsonObject> RootObject = MakeShareable(new FJsonObject);
 	
@@ -174,6 +276,20 @@ bool UVFXDSLParser::ToJSON(const FVFXDSL& DSL, FString& OutJsonString)
 		RenderObject->SetStringField(TEXT("blendMode"), Emitter.Render.BlendMode);
 		RenderObject->SetStringField(TEXT("sort"), Emitter.Render.Sort);
 		
+		TSharedPtr<FJsonObject> MeshObject = MakeShareable(new FJsonObject);
+		MeshObject->SetStringField(TEXT("meshPath"), Emitter.Render.Mesh.MeshPath);
+		MeshObject->SetStringField(TEXT("meshType"), Emitter.Render.Mesh.MeshType);
+		MeshObject->SetNumberField(TEXT("scale"), Emitter.Render.Mesh.Scale);
+		
+		TSharedPtr<FJsonObject> RotationObject = MakeShareable(new FJsonObject);
+		RotationObject->SetNumberField(TEXT("x"), Emitter.Render.Mesh.Rotation.X);
+		RotationObject->SetNumberField(TEXT("y"), Emitter.Render.Mesh.Rotation.Y);
+		RotationObject->SetNumberField(TEXT("z"), Emitter.Render.Mesh.Rotation.Z);
+		MeshObject->SetObjectField(TEXT("rotation"), RotationObject);
+		
+		MeshObject->SetBoolField(TEXT("useMesh"), Emitter.Render.Mesh.bUseMesh);
+		RenderObject->SetObjectField(TEXT("mesh"), MeshObject);
+		
 		EmitterObject->SetObjectField(TEXT("render"), RenderObject);
 		
 		EmittersArray.Add(MakeShareable(new FJsonValueObject(EmitterObject)));
@@ -511,101 +627,166 @@ EVFXEffectType UVFXDSLParser::ParseEffectType(const FString& TypeString)
 FVFXDSLValidationResult UVFXDSLValidator::Validate(const FVFXDSL& DSL)
 {
 	FVFXDSLValidationResult Result;
-	Result.bIsValid = true;
+	ValidateInto(DSL, Result);
+	FormatErrors(Result);
+	return Result;
+}
+
+/**
+ * Validates a DSL into compact error records.
+ *
+ * No strings are built here: each failed check appends an FVFXDSLValidationError
+ * (code, emitter index, field, offending values). A valid DSL therefore costs no
+ * allocations, and a reused result keeps its error array capacity.
+ *
+ * @param DSL The DSL to validate
+ * @param OutResult Result to fill; previous contents are discarded
+ */
+void UVFXDSLValidator::ValidateInto(const FVFXDSL& DSL, FVFXDSLValidationResult& OutResult)
+{
+	OutResult.bIsValid = true;
+	OutResult.Errors.Reset();
+	OutResult.ErrorMessages.Reset();
 	
 	// Validate effect
-	ValidateEffect(DSL.Effect, Result);
+	ValidateEffect(DSL.Effect, OutResult);
 	
 	// Validate emitters
 	if (DSL.Emitters.Num() == 0)
 	{
-		Result.AddError(TEXT("DSL must contain at least one emitter"));
+		OutResult.AddError(FVFXDSLValidationError(EVFXDSLValidationCode::NoEmitters, INDEX_NONE, EVFXDSLFieldId::Emitters));
 	}
 	
 	for (int32 i = 0; i < DSL.Emitters.Num(); ++i)
 	{
-		ValidateEmitter(DSL.Emitters[i], i, Result);
+		ValidateEmitter(DSL.Emitters[i], i, OutResult);
 	}
-	
-	return Result;
 }
 
-void UVFXDSLValidator::ValidateEffect(const FVFXDSLEffect& Effect, FVFXDSLValidationResult& Result)
+int32 UVFXDSLValidator::ValidateBatch(TConstArrayView<FVFXDSL> DSLs, TArray<FVFXDSLValidationResult>& OutResults)
 {
-	if (Effect.Duration < 0.0f)
+	OutResults.SetNum(DSLs.Num());
+
+	ParallelFor(DSLs.Num(), [&DSLs, &OutResults](int32 Index)
+	{
+		ValidateInto(DSLs[Index], OutResults[Index]);
+	});
+
+	int32 NumInvalid = 0;
+	for (const FVFXDSLValidationResult& Result : OutResults)
+	{
+		NumInvalid += Result.bIsValid ? 0 : 1;
+	}
+	return NumInvalid;
+}
+
+FString UVFXDSLValidator::FormatError(const FVFXDSLValidationError& Error)
+{
+	const int32 Index = Error.EmitterIndex;
+
+	switch (Error.Code)
+	{
+	case EVFXDSLValidationCode::NegativeDuration:
+		return FString::Printf(TEXT("Effect duration must be non-negative, got: %f"), Error.Value);
+	case EVFXDSLValidationCode::NoEmitters:
+		return TEXT("DSL must contain at least one emitter");
+	case EVFXDSLValidationCode::EmptyName:
+		return FString::Printf(TEXT("Emitter[%d]: Name is empty"), Index);
+	case EVFXDSLValidationCode::ColorOutOfRange:
+		return FString::Printf(TEXT("Emitter[%d].%s: Color component must be between 0 and 1, got: %f"), Index, GetFieldPath(Error.Field), Error.Value);
+	case EVFXDSLValidationCode::NegativeSize:
+		return FString::Printf(TEXT("Emitter[%d].%s: Size must be non-negative, got: %f"), Index, GetFieldPath(Error.Field), Error.Value);
+	case EVFXDSLValidationCode::SizeMinAboveMax:
+		return FString::Printf(TEXT("Emitter[%d].%s: Min (%f) must be less than or equal to Max (%f)"), Index, GetFieldPath(Error.Field), Error.Value, Error.OtherValue);
+	case EVFXDSLValidationCode::NegativeBurstCount:
+		return FString::Printf(TEXT("Emitter[%d].Spawners.Burst: Count must be non-negative, got: %d"), Index, static_cast<int32>(Error.Value));
+	case EVFXDSLValidationCode::NegativeSpawnRate:
+		return FString::Printf(TEXT("Emitter[%d].Spawners.Rate: SpawnRate must be non-negative, got: %f"), Index, Error.Value);
+	case EVFXDSLValidationCode::BounceOutOfRange:
+		return FString::Printf(TEXT("Emitter[%d].Update.Collision: Bounce must be between 0 and 1, got: %f"), Index, Error.Value);
+	default:
+		return FString::Printf(TEXT("Emitter[%d].%s: Invalid value %f"), Index, GetFieldPath(Error.Field), Error.Value);
+	}
+}
+
+void UVFXDSLValidator::FormatErrors(FVFXDSLValidationResult& Result)
+{
+	Result.ErrorMessages.Reset(Result.Errors.Num());
+	for (const FVFXDSLValidationError& Error : Result.Errors)
 	{
-		Result.AddError(FString::Printf(TEXT("Effect duration must be non-negative, got: %f"), Effect.Duration));
+		Result.ErrorMessages.Add(FormatError(Error));
 	}
 }
 
+const TCHAR* UVFXDSLValidator::GetFieldPath(EVFXDSLFieldId Field)
+{
+	switch (Field)
+	{
+	case EVFXDSLFieldId::EffectDuration:			return TEXT("Effect.Duration");
+	case EVFXDSLFieldId::Emitters:					return TEXT("Emitters");
+	case EVFXDSLFieldId::EmitterName:				return TEXT("Name");
+	case EVFXDSLFieldId::InitializationColorR:		return TEXT("Initialization.Color.R");
+	case EVFXDSLFieldId::InitializationColorG:		return TEXT("Initialization.Color.G");
+	case EVFXDSLFieldId::InitializationColorB:		return TEXT("Initialization.Color.B");
+	case EVFXDSLFieldId::InitializationColorA:		return TEXT("Initialization.Color.A");
+	case EVFXDSLFieldId::InitializationSize:		return TEXT("Initialization.Size");
+	case EVFXDSLFieldId::InitializationSizeMin:		return TEXT("Initialization.Size.Min");
+	case EVFXDSLFieldId::InitializationSizeMax:		return TEXT("Initialization.Size.Max");
+	case EVFXDSLFieldId::SpawnersBurstCount:		return TEXT("Spawners.Burst.Count");
+	case EVFXDSLFieldId::SpawnersRateSpawnRate:		return TEXT("Spawners.Rate.SpawnRate");
+	case EVFXDSLFieldId::UpdateCollisionBounce:		return TEXT("Update.Collision.Bounce");
+	case EVFXDSLFieldId::None:
+	default:
+		return TEXT("");
+	}
+}
+
+void UVFXDSLValidator::ValidateEffect(const FVFXDSLEffect& Effect, FVFXDSLValidationResult& Result)
+{
+	const FVFXDSLCodecTable& Table = FVFXDSLCodec::Get().GetEffectTable();
+	FVFXDSLCodec::ValidateRanges(Table, 0, Table.Leaves.Num(), &Effect, INDEX_NONE, Result);
+}
+
 void UVFXDSLValidator::ValidateEmitter(const FVFXDSLEmitter& Emitter, int32 EmitterIndex, FVFXDSLValidationResult& Result)
 {
-	FString EmitterContext = FString::Printf(TEXT("Emitter[%d]"), EmitterIndex);
-	
+	const FVFXDSLCodecTable& Table = FVFXDSLCodec::Get().GetEmitterTable();
+	static const int32 ColorField = Table.FindField(TEXT("Initialization.Color"));
+	static const int32 SizeField = Table.FindField(TEXT("Initialization.Size"));
+	checkSlow(ColorField != INDEX_NONE && SizeField != INDEX_NONE && Table.Fields[ColorField].EndLeaf == Table.Fields[SizeField].FirstLeaf);
+
 	// Validate emitter name
 	if (Emitter.Name.IsEmpty())
 	{
-		Result.AddError(FString::Printf(TEXT("%s: Name is empty"), *EmitterContext));
+		Result.AddError(FVFXDSLValidationError(EVFXDSLValidationCode::EmptyName, EmitterIndex, EVFXDSLFieldId::EmitterName));
 	}
 	
 	// Validate initialization
-	ValidateColor(Emitter.Initialization.Color, FString::Printf(TEXT("%s.Initialization.Color"), *EmitterContext), Result);
-	ValidateSize(Emitter.Initialization.Size, FString::Printf(TEXT("%s.Initialization.Size"), *EmitterContext), Result);
+	ValidateColor(Emitter, EmitterIndex, Result);
+	ValidateSize(Emitter, EmitterIndex, Result);
 	
-	// Validate spawners
-	if (Emitter.Spawners.Burst.Count < 0)
-	{
-		Result.AddError(FString::Printf(TEXT("%s.Spawners.Burst: Count must be non-negative, got: %d"), *EmitterContext, Emitter.Spawners.Burst.Count));
-	}
-	
-	if (Emitter.Spawners.Rate.SpawnRate < 0.0f)
-	{
-		Result.AddError(FString::Printf(TEXT("%s.Spawners.Rate: SpawnRate must be non-negative, got: %f"), *EmitterContext, Emitter.Spawners.Rate.SpawnRate));
-	}
-	
-	// Validate collision bounce
-	if (Emitter.Update.Collision.bEnabled)
-	{
-		if (Emitter.Update.Collision.Bounce < 0.0f || Emitter.Update.Collision.Bounce > 1.0f)
-		{
-			Result.AddError(FString::Printf(TEXT("%s.Update.Collision: Bounce must be between 0 and 1, got: %f"), *EmitterContext, Emitter.Update.Collision.Bounce));
-		}
-	}
+	// Range-check every other field (spawners, collision bounce, ...) in declaration order
+	FVFXDSLCodec::ValidateRanges(Table, 0, Table.Fields[ColorField].FirstLeaf, &Emitter, EmitterIndex, Result);
+	FVFXDSLCodec::ValidateRanges(Table, Table.Fields[SizeField].EndLeaf, Table.Leaves.Num(), &Emitter, EmitterIndex, Result);
 }
 
-void UVFXDSLValidator::ValidateColor(const FVFXDSLColor& Color, const FString& Context, FVFXDSLValidationResult& Result)
+void UVFXDSLValidator::ValidateColor(const FVFXDSLEmitter& Emitter, int32 EmitterIndex, FVFXDSLValidationResult& Result)
 {
-	if (Color.R < 0.0f || Color.R > 1.0f)
-	{
-		Result.AddError(FString::Printf(TEXT("%s.R: Color component must be between 0 and 1, got: %f"), *Context, Color.R));
-	}
-	if (Color.G < 0.0f || Color.G > 1.0f)
-	{
-		Result.AddError(FString::Printf(TEXT("%s.G: Color component must be between 0 and 1, got: %f"), *Context, Color.G));
-	}
-	if (Color.B < 0.0f || Color.B > 1.0f)
-	{
-		Result.AddError(FString::Printf(TEXT("%s.B: Color component must be between 0 and 1, got: %f"), *Context, Color.B));
-	}
-	if (Color.A < 0.0f || Color.A > 1.0f)
-	{
-		Result.AddError(FString::Printf(TEXT("%s.A: Color component must be between 0 and 1, got: %f"), *Context, Color.A));
-	}
+	const FVFXDSLCodecTable& Table = FVFXDSLCodec::Get().GetEmitterTable();
+	static const int32 ColorField = Table.FindField(TEXT("Initialization.Color"));
+
+	FVFXDSLCodec::ValidateRanges(Table, Table.Fields[ColorField].FirstLeaf, Table.Fields[ColorField].EndLeaf, &Emitter, EmitterIndex, Result);
 }
 
-void UVFXDSLValidator::ValidateSize(const FVFXDSLSize& Size, const FString& Context, FVFXDSLValidationResult& Result)
+void UVFXDSLValidator::ValidateSize(const FVFXDSLEmitter& Emitter, int32 EmitterIndex, FVFXDSLValidationResult& Result)
 {
-	if (Size.Min < 0.0f)
-	{
-		Result.AddError(FString::Printf(TEXT("%s.Min: Size must be non-negative, got: %f"), *Context, Size.Min));
-	}
-	if (Size.Max < 0.0f)
-	{
-		Result.AddError(FString::Printf(TEXT("%s.Max: Size must be non-negative, got: %f"), *Context, Size.Max));
-	}
+	const FVFXDSLCodecTable& Table = FVFXDSLCodec::Get().GetEmitterTable();
+	static const int32 SizeField = Table.FindField(TEXT("Initialization.Size"));
+
+	FVFXDSLCodec::ValidateRanges(Table, Table.Fields[SizeField].FirstLeaf, Table.Fields[SizeField].EndLeaf, &Emitter, EmitterIndex, Result);
+
+	const FVFXDSLSize& Size = Emitter.Initialization.Size;
 	if (Size.Min > Size.Max)
 	{
-		Result.AddError(FString::Printf(TEXT("%s: Min (%f) must be less than or equal to Max (%f)"), *Context, Size.Min, Size.Max));
+		Result.AddError(FVFXDSLValidationError(EVFXDSLValidationCode::SizeMinAboveMax, EmitterIndex, EVFXDSLFieldId::InitializationSize, Size.Min, Size.Max));
 	}
 }
-
@@ -0,0 +1,670 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/VFXDSLPatch.h"
+#include "Core/VFXDSLCodec.h"
+#include "Core/VFXDSLDiff.h"
+#include "Core/VFXDSLParser.h"
+#include "Core/VFXDSLStreamParser.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+
+namespace
+{
+	bool WriteField(const FVFXDSLCodecField& Field, void* Base, const FJsonValue& Value, FString& OutError)
+	{
+		double Number = 0.0;
+		switch (Field.Type)
+		{
+		case EVFXDSLCodecType::Float:
+			if (!Value.TryGetNumber(Number) || !FMath::IsFinite(Number))
+			{
+				OutError = TEXT("expected a number");
+				return false;
+			}
+			FVFXDSLCodec::GetValue<float>(Field, Base) = static_cast<float>(Number);
+			return true;
+
+		case EVFXDSLCodecType::Int32:
+			if (!Value.TryGetNumber(Number) || !FMath::IsFinite(Number))
+			{
+				OutError = TEXT("expected a number");
+				return false;
+			}
+			FVFXDSLCodec::GetValue<int32>(Field, Base) = FMath::RoundToInt(FMath::Clamp(Number, static_cast<double>(MIN_int32), static_cast<double>(MAX_int32)));
+			return true;
+
+		case EVFXDSLCodecType::Bool:
+			if (Value.Type != EJson::Boolean)
+			{
+				OutError = TEXT("expected true or false");
+				return false;
+			}
+			FVFXDSLCodec::GetValue<bool>(Field, Base) = Value.AsBool();
+			return true;
+
+		case EVFXDSLCodecType::String:
+			if (Value.Type != EJson::String)
+			{
+				OutError = TEXT("expected a string");
+				return false;
+			}
+			FVFXDSLCodec::GetValue<FString>(Field, Base) = Value.AsString();
+			return true;
+
+		case EVFXDSLCodecType::Enum:
+		{
+			int64 EnumValue = 0;
+			if (Value.Type != EJson::String || !FVFXDSLCodec::FindEnumValue(Field, Value.AsString(), EnumValue))
+			{
+				TArray<FString> Names;
+				for (const TPair<int64, FString>& Entry : Field.EnumEntries)
+				{
+					Names.Add(FString::Printf(TEXT("\"%s\""), *Entry.Value));
+				}
+				OutError = FString::Printf(TEXT("expected one of %s"), *FString::Join(Names, TEXT(", ")));
+				return false;
+			}
+			FVFXDSLCodec::SetEnumValue(Field, Base, EnumValue);
+			return true;
+		}
+
+		case EVFXDSLCodecType::FloatArray:
+		{
+			const TArray<TSharedPtr<FJsonValue>>* Elements = nullptr;
+			if (!Value.TryGetArray(Elements))
+			{
+				OutError = TEXT("expected an array of numbers");
+				return false;
+			}
+
+			TArray<float> Values;
+			Values.Reserve(Elements->Num());
+			for (const TSharedPtr<FJsonValue>& Element : *Elements)
+			{
+				if (!Element.IsValid() || !Element->TryGetNumber(Number) || !FMath::IsFinite(Number))
+				{
+					OutError = TEXT("expected an array of numbers");
+					return false;
+				}
+				Values.Add(static_cast<float>(Number));
+			}
+			FVFXDSLCodec::GetValue<TArray<float>>(Field, Base) = MoveTemp(Values);
+			return true;
+		}
+
+		case EVFXDSLCodecType::Struct:
+			break;
+		}
+
+		return false;
+	}
+
+	TSharedPtr<FJsonValue> ReadField(const FVFXDSLCodecTable& Table, int32 FieldIndex, const void* Base)
+	{
+		const FVFXDSLCodecField& Field = Table.Fields[FieldIndex];
+		switch (Field.Type)
+		{
+		case EVFXDSLCodecType::Float:
+			return MakeShared<FJsonValueNumber>(FVFXDSLCodec::GetValue<float>(Field, Base));
+		case EVFXDSLCodecType::Int32:
+			return MakeShared<FJsonValueNumber>(FVFXDSLCodec::GetValue<int32>(Field, Base));
+		case EVFXDSLCodecType::Bool:
+			return MakeShared<FJsonValueBoolean>(FVFXDSLCodec::GetValue<bool>(Field, Base));
+		case EVFXDSLCodecType::String:
+			return MakeShared<FJsonValueString>(FVFXDSLCodec::GetValue<FString>(Field, Base));
+		case EVFXDSLCodecType::Enum:
+			return MakeShared<FJsonValueString>(FVFXDSLCodec::GetEnumName(Field, Base));
+		case EVFXDSLCodecType::FloatArray:
+		{
+			TArray<TSharedPtr<FJsonValue>> Elements;
+			for (float Element : FVFXDSLCodec::GetValue<TArray<float>>(Field, Base))
+			{
+				Elements.Add(MakeShared<FJsonValueNumber>(Element));
+			}
+			return MakeShared<FJsonValueArray>(Elements);
+		}
+		case EVFXDSLCodecType::Struct:
+		{
+			// Struct nodes become objects in DSL JSON layout
+			TSharedPtr<FJsonObject> Object = MakeShared<FJsonObject>();
+			for (int32 ChildIndex = Field.FirstChild; ChildIndex < Field.FirstChild + Field.NumChildren; ++ChildIndex)
+			{
+				Object->SetField(Table.Fields[ChildIndex].JsonKey, ReadField(Table, ChildIndex, Base));
+			}
+			return MakeShared<FJsonValueObject>(Object);
+		}
+		}
+
+		return MakeShared<FJsonValueNull>();
+	}
+
+	FVFXDSLPatchOp& AddOp(FVFXDSLPatch& Patch, EVFXDSLPatchOpType Type, FString Path)
+	{
+		FVFXDSLPatchOp& Op = Patch.Ops.AddDefaulted_GetRef();
+		Op.Op = Type;
+		Op.Path = MoveTemp(Path);
+		return Op;
+	}
+}
+
+bool FVFXDSLPatch::ParseFromJSON(const FString& JsonString, FVFXDSLPatch& OutPatch, FString& OutError)
+{
+	OutPatch.Ops.Reset();
+
+	TSharedPtr<FJsonObject> JsonObject;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonString);
+	if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid())
+	{
+		OutError = TEXT("Invalid JSON format");
+		return false;
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>* OpValues = nullptr;
+	if (!JsonObject->TryGetArrayField(TEXT("patch"), OpValues))
+	{
+		OutError = TEXT("Missing 'patch' array");
+		return false;
+	}
+
+	OutPatch.Ops.Reserve(OpValues->Num());
+	for (int32 Index = 0; Index < OpValues->Num(); ++Index)
+	{
+		const TSharedPtr<FJsonObject>* OpObject = nullptr;
+		if (!(*OpValues)[Index].IsValid() || !(*OpValues)[Index]->TryGetObject(OpObject))
+		{
+			OutError = FString::Printf(TEXT("Patch op %d is not an object"), Index);
+			return false;
+		}
+
+		FVFXDSLPatchOp& Op = OutPatch.Ops.AddDefaulted_GetRef();
+
+		FString OpName;
+		(*OpObject)->TryGetStringField(TEXT("op"), OpName);
+		if (OpName.Equals(TEXT("set"), ESearchCase::IgnoreCase) || OpName.Equals(TEXT("replace"), ESearchCase::IgnoreCase))
+		{
+			Op.Op = EVFXDSLPatchOpType::Set;
+		}
+		else if (OpName.Equals(TEXT("add"), ESearchCase::IgnoreCase))
+		{
+			Op.Op = EVFXDSLPatchOpType::Add;
+		}
+		else if (OpName.Equals(TEXT("remove"), ESearchCase::IgnoreCase))
+		{
+			Op.Op = EVFXDSLPatchOpType::Remove;
+		}
+		else if (OpName.Equals(TEXT("move"), ESearchCase::IgnoreCase))
+		{
+			Op.Op = EVFXDSLPatchOpType::Move;
+		}
+		else
+		{
+			OutError = FString::Printf(TEXT("Patch op %d has unknown op '%s'"), Index, *OpName);
+			return false;
+		}
+
+		if (!(*OpObject)->TryGetStringField(TEXT("path"), Op.Path) || Op.Path.IsEmpty())
+		{
+			OutError = FString::Printf(TEXT("Patch op %d is missing 'path'"), Index);
+			return false;
+		}
+
+		if (Op.Op == EVFXDSLPatchOpType::Move
+			&& (!(*OpObject)->TryGetStringField(TEXT("from"), Op.From) || Op.From.IsEmpty()))
+		{
+			OutError = FString::Printf(TEXT("Patch op %d (move) is missing 'from'"), Index);
+			return false;
+		}
+
+		if (Op.Op == EVFXDSLPatchOpType::Set || Op.Op == EVFXDSLPatchOpType::Add)
+		{
+			Op.Value = (*OpObject)->TryGetField(TEXT("value"));
+			if (!Op.Value.IsValid() || Op.Value->IsNull())
+			{
+				OutError = FString::Printf(TEXT("Patch op %d (%s) is missing 'value'"), Index, GetOpName(Op.Op));
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool FVFXDSLPatch::ToJSON(const FVFXDSLPatch& Patch, FString& OutJsonString)
+{
+	TArray<TSharedPtr<FJsonValue>> OpValues;
+	OpValues.Reserve(Patch.Ops.Num());
+	for (const FVFXDSLPatchOp& Op : Patch.Ops)
+	{
+		TSharedPtr<FJsonObject> OpObject = MakeShared<FJsonObject>();
+		OpObject->SetStringField(TEXT("op"), GetOpName(Op.Op));
+		if (Op.Op == EVFXDSLPatchOpType::Move)
+		{
+			OpObject->SetStringField(TEXT("from"), Op.From);
+		}
+		OpObject->SetStringField(TEXT("path"), Op.Path);
+		if (Op.Value.IsValid())
+		{
+			OpObject->SetField(TEXT("value"), Op.Value);
+		}
+		OpValues.Add(MakeShared<FJsonValueObject>(OpObject));
+	}
+
+	TSharedPtr<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetArrayField(TEXT("patch"), OpValues);
+
+	OutJsonString.Reset();
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&OutJsonString);
+	return FJsonSerializer::Serialize(Root.ToSharedRef(), Writer);
+}
+
+FVFXDSLPatch FVFXDSLPatch::FromDiff(const FVFXDSL& OldDSL, const FVFXDSL& NewDSL)
+{
+	FVFXDSLPatch Patch;
+
+	const FVFXDSLCodec& Codec = FVFXDSLCodec::Get();
+	const FVFXDSLCodecTable& EffectTable = Codec.GetEffectTable();
+	const FVFXDSLCodecTable& EmitterTable = Codec.GetEmitterTable();
+
+	for (int32 FieldIndex : EffectTable.Leaves)
+	{
+		const FVFXDSLCodecField& Field = EffectTable.Fields[FieldIndex];
+		if (FVFXDSLCodec::FieldDiffers(Field, &OldDSL.Effect, &NewDSL.Effect))
+		{
+			AddOp(Patch, EVFXDSLPatchOpType::Set, Field.Path).Value = ReadField(EffectTable, FieldIndex, &NewDSL.Effect);
+		}
+	}
+
+	const TArray<FVFXDSLEmitter>& OldEmitters = OldDSL.Emitters;
+	const TArray<FVFXDSLEmitter>& NewEmitters = NewDSL.Emitters;
+
+	// Pair emitters the way UVFXDSLDiff::Compare does: per index when the names line up
+	bool bSameOrder = OldEmitters.Num() == NewEmitters.Num();
+	for (int32 Index = 0; Index < NewEmitters.Num() && bSameOrder; ++Index)
+	{
+		bSameOrder = OldEmitters[Index].Name == NewEmitters[Index].Name;
+	}
+
+	TArray<int32> NewToOld;
+	if (bSameOrder)
+	{
+		NewToOld.SetNumUninitialized(NewEmitters.Num());
+		for (int32 Index = 0; Index < NewEmitters.Num(); ++Index)
+		{
+			NewToOld[Index] = Index;
+		}
+	}
+	else
+	{
+		UVFXDSLDiff::MatchEmitters(OldEmitters, NewEmitters, NewToOld);
+	}
+
+	TBitArray<> OldMatched(false, OldEmitters.Num());
+	for (int32 OldIndex : NewToOld)
+	{
+		if (OldIndex != INDEX_NONE)
+		{
+			OldMatched[OldIndex] = true;
+		}
+	}
+
+	// 1. Remove unmatched emitters, last first so the remaining indices stay valid
+	for (int32 OldIndex = OldEmitters.Num() - 1; OldIndex >= 0; --OldIndex)
+	{
+		if (!OldMatched[OldIndex])
+		{
+			AddOp(Patch, EVFXDSLPatchOpType::Remove, FString::Printf(TEXT("Emitters[%d]"), OldIndex));
+		}
+	}
+
+	// 2. Insert and move into the new order, front to back; Current tracks the old index at each position
+	TArray<int32> Current;
+	Current.Reserve(NewEmitters.Num());
+	for (int32 OldIndex = 0; OldIndex < OldEmitters.Num(); ++OldIndex)
+	{
+		if (OldMatched[OldIndex])
+		{
+			Current.Add(OldIndex);
+		}
+	}
+
+	for (int32 NewIndex = 0; NewIndex < NewEmitters.Num(); ++NewIndex)
+	{
+		const int32 OldIndex = NewToOld[NewIndex];
+		if (OldIndex == INDEX_NONE)
+		{
+			AddOp(Patch, EVFXDSLPatchOpType::Add, FString::Printf(TEXT("Emitters[%d]"), NewIndex)).Value = ReadField(EmitterTable, 0, &NewEmitters[NewIndex]);
+			Current.Insert(INDEX_NONE, NewIndex);
+			continue;
+		}
+
+		const int32 Position = Current.Find(OldIndex);
+		if (Position != NewIndex)
+		{
+			AddOp(Patch, EVFXDSLPatchOpType::Move, FString::Printf(TEXT("Emitters[%d]"), NewIndex)).From = FString::Printf(TEXT("Emitters[%d]"), Position);
+			Current.RemoveAt(Position);
+			Current.Insert(OldIndex, NewIndex);
+		}
+	}
+
+	// 3. Field edits, addressed by final index
+	for (int32 NewIndex = 0; NewIndex < NewEmitters.Num(); ++NewIndex)
+	{
+		const int32 OldIndex = NewToOld[NewIndex];
+		if (OldIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		for (int32 FieldIndex : EmitterTable.Leaves)
+		{
+			const FVFXDSLCodecField& Field = EmitterTable.Fields[FieldIndex];
+			if (FVFXDSLCodec::FieldDiffers(Field, &OldEmitters[OldIndex], &NewEmitters[NewIndex]))
+			{
+				AddOp(Patch, EVFXDSLPatchOpType::Set, FString::Printf(TEXT("Emitters[%d].%s"), NewIndex, *Field.Path)).Value = ReadField(EmitterTable, FieldIndex, &NewEmitters[NewIndex]);
+			}
+		}
+	}
+
+	return Patch;
+}
+
+/**
+ * Applies a patch to a DSL atomically.
+ *
+ * Ops run in order against a working copy, so later ops see the effect of
+ * earlier ones (indices shift after add, remove and move). The copy is then
+ * validated; DSL is only replaced when every op succeeded and validation passed.
+ *
+ * @param DSL DSL to patch
+ * @param Patch Patch to apply
+ * @param OutError "Patch op N (op path): reason", or the validation messages
+ * @param OutValidation Optional validation result of the working copy
+ * @return True if DSL was replaced
+ */
+bool FVFXDSLPatch::ApplyPatch(FVFXDSL& DSL, const FVFXDSLPatch& Patch, FString& OutError, FVFXDSLValidationResult* OutValidation)
+{
+	FVFXDSL Working = DSL;
+
+	for (int32 Index = 0; Index < Patch.Ops.Num(); ++Index)
+	{
+		const FVFXDSLPatchOp& Op = Patch.Ops[Index];
+		FString OpError;
+		if (!ApplyOp(Working, Op, OpError))
+		{
+			OutError = FString::Printf(TEXT("Patch op %d (%s %s): %s"), Index, GetOpName(Op.Op), *Op.Path, *OpError);
+			return false;
+		}
+	}
+
+	FVFXDSLValidationResult Validation = UVFXDSLValidator::Validate(Working);
+	if (!Validation.bIsValid)
+	{
+		OutError = FString::Printf(TEXT("Patched DSL failed validation: %s"), *FString::Join(Validation.ErrorMessages, TEXT("; ")));
+		if (OutValidation)
+		{
+			*OutValidation = MoveTemp(Validation);
+		}
+		return false;
+	}
+
+	if (OutValidation)
+	{
+		*OutValidation = MoveTemp(Validation);
+	}
+
+	UE_LOG(LogTemp, Verbose, TEXT("AINiagara: Applied DSL patch with %d op(s)"), Patch.Ops.Num());
+
+	DSL = MoveTemp(Working);
+	return true;
+}
+
+const TCHAR* FVFXDSLPatch::GetOpName(EVFXDSLPatchOpType Op)
+{
+	switch (Op)
+	{
+	case EVFXDSLPatchOpType::Add:
+		return TEXT("add");
+	case EVFXDSLPatchOpType::Remove:
+		return TEXT("remove");
+	case EVFXDSLPatchOpType::Move:
+		return TEXT("move");
+	case EVFXDSLPatchOpType::Set:
+	default:
+		return TEXT("set");
+	}
+}
+
+bool FVFXDSLPatch::ApplyOp(FVFXDSL& DSL, const FVFXDSLPatchOp& Op, FString& OutError)
+{
+	int32 Index = INDEX_NONE;
+	FString SubPath;
+
+	switch (Op.Op)
+	{
+	case EVFXDSLPatchOpType::Set:
+		return ApplySet(DSL, Op.Path, Op.Value, OutError);
+
+	case EVFXDSLPatchOpType::Add:
+	{
+		if (!ResolveEmitter(Op.Path, DSL, true, Index, SubPath, OutError))
+		{
+			return false;
+		}
+		if (!SubPath.IsEmpty())
+		{
+			OutError = TEXT("add only inserts emitters, use set to change fields");
+			return false;
+		}
+
+		FVFXDSLEmitter Emitter;
+		if (!MakeEmitter(Op.Value, Emitter, OutError))
+		{
+			return false;
+		}
+		DSL.Emitters.Insert(MoveTemp(Emitter), Index);
+		return true;
+	}
+
+	case EVFXDSLPatchOpType::Remove:
+		if (!ResolveEmitter(Op.Path, DSL, false, Index, SubPath, OutError))
+		{
+			return false;
+		}
+		if (!SubPath.IsEmpty())
+		{
+			OutError = TEXT("remove only deletes emitters");
+			return false;
+		}
+		DSL.Emitters.RemoveAt(Index);
+		return true;
+
+	case EVFXDSLPatchOpType::Move:
+	{
+		int32 FromIndex = INDEX_NONE;
+		if (!ResolveEmitter(Op.From, DSL, false, FromIndex, SubPath, OutError))
+		{
+			return false;
+		}
+		if (!SubPath.IsEmpty())
+		{
+			OutError = TEXT("move only reorders emitters");
+			return false;
+		}
+
+		// Like JSON Patch, the target is resolved after the emitter is taken out
+		FVFXDSLEmitter Emitter = MoveTemp(DSL.Emitters[FromIndex]);
+		DSL.Emitters.RemoveAt(FromIndex);
+		if (!ResolveEmitter(Op.Path, DSL, true, Index, SubPath, OutError))
+		{
+			return false;
+		}
+		if (!SubPath.IsEmpty())
+		{
+			OutError = TEXT("move only reorders emitters");
+			return false;
+		}
+		DSL.Emitters.Insert(MoveTemp(Emitter), Index);
+		return true;
+	}
+	}
+
+	return false;
+}
+
+bool FVFXDSLPatch::ApplySet(FVFXDSL& DSL, const FString& Path, const TSharedPtr<FJsonValue>& Value, FString& OutError)
+{
+	if (!Value.IsValid())
+	{
+		OutError = TEXT("missing value");
+		return false;
+	}
+
+	const FVFXDSLCodec& Codec = FVFXDSLCodec::Get();
+	FString CanonicalPath = Path;
+
+	if (Path.StartsWith(TEXT("Emitters["), ESearchCase::IgnoreCase))
+	{
+		int32 EmitterIndex = INDEX_NONE;
+		FString SubPath;
+		if (!ResolveEmitter(Path, DSL, false, EmitterIndex, SubPath, OutError))
+		{
+			return false;
+		}
+
+		// Setting an emitter replaces it
+		if (SubPath.IsEmpty())
+		{
+			return MakeEmitter(Value, DSL.Emitters[EmitterIndex], OutError);
+		}
+
+		const FVFXDSLCodecTable& Table = Codec.GetEmitterTable();
+		const int32 FieldIndex = Table.FindField(SubPath);
+		if (FieldIndex != INDEX_NONE && Table.Fields[FieldIndex].Type != EVFXDSLCodecType::Struct)
+		{
+			return WriteField(Table.Fields[FieldIndex], &DSL.Emitters[EmitterIndex], *Value, OutError);
+		}
+
+		// Address sub-fields by index so that renaming the emitter in the same object is safe
+		CanonicalPath = FString::Printf(TEXT("Emitters[%d].%s"), EmitterIndex, *SubPath);
+	}
+	else
+	{
+		const FVFXDSLCodecTable& Table = Codec.GetEffectTable();
+		const int32 FieldIndex = Table.FindField(Path);
+		if (FieldIndex != INDEX_NONE && Table.Fields[FieldIndex].Type != EVFXDSLCodecType::Struct)
+		{
+			return WriteField(Table.Fields[FieldIndex], &DSL.Effect, *Value, OutError);
+		}
+	}
+
+	// A group of fields, e.g. "Emitters[0].Initialization.Color": {"r": 1.0, "g": 0.2}
+	const TSharedPtr<FJsonObject>* Object = nullptr;
+	if (Value->TryGetObject(Object))
+	{
+		for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : (*Object)->Values)
+		{
+			if (!ApplySet(DSL, CanonicalPath + TEXT(".") + Pair.Key, Pair.Value, OutError))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	OutError = FString::Printf(TEXT("unknown field '%s'"), *Path);
+	return false;
+}
+
+bool FVFXDSLPatch::ResolveEmitter(const FString& Path, const FVFXDSL& DSL, bool bAllowEnd, int32& OutIndex, FString& OutSubPath, FString& OutError)
+{
+	static const FString Prefix = TEXT("Emitters[");
+
+	OutIndex = INDEX_NONE;
+	OutSubPath.Reset();
+
+	const int32 Close = Path.StartsWith(Prefix, ESearchCase::IgnoreCase)
+		? Path.Find(TEXT("]"), ESearchCase::CaseSensitive, ESearchDir::FromStart, Prefix.Len())
+		: INDEX_NONE;
+	if (Close == INDEX_NONE)
+	{
+		OutError = FString::Printf(TEXT("'%s' is not an emitter path"), *Path);
+		return false;
+	}
+
+	if (Close + 1 < Path.Len())
+	{
+		if (Path[Close + 1] != TEXT('.') || Close + 2 == Path.Len())
+		{
+			OutError = FString::Printf(TEXT("malformed path '%s'"), *Path);
+			return false;
+		}
+		OutSubPath = Path.Mid(Close + 2);
+	}
+
+	const FString Key = Path.Mid(Prefix.Len(), Close - Prefix.Len()).TrimStartAndEnd();
+	const int32 NumEmitters = DSL.Emitters.Num();
+
+	if (Key == TEXT("-"))
+	{
+		if (!bAllowEnd)
+		{
+			OutError = TEXT("'Emitters[-]' can only be used to append");
+			return false;
+		}
+		OutIndex = NumEmitters;
+		return true;
+	}
+
+	bool bIsIndex = !Key.IsEmpty();
+	for (TCHAR Char : Key)
+	{
+		bIsIndex &= FChar::IsDigit(Char);
+	}
+
+	if (bIsIndex)
+	{
+		OutIndex = FCString::Atoi(*Key);
+		const int32 MaxIndex = bAllowEnd ? NumEmitters : NumEmitters - 1;
+		if (Key.Len() > 9 || OutIndex > MaxIndex)
+		{
+			OutError = FString::Printf(TEXT("emitter index %s is out of range (%d emitters)"), *Key, NumEmitters);
+			return false;
+		}
+		return true;
+	}
+
+	OutIndex = DSL.Emitters.IndexOfByPredicate([&Key](const FVFXDSLEmitter& Emitter) { return Emitter.Name == Key; });
+	if (OutIndex == INDEX_NONE)
+	{
+		OutError = FString::Printf(TEXT("no emitter named '%s'"), *Key);
+		return false;
+	}
+	return true;
+}
+
+bool FVFXDSLPatch::MakeEmitter(const TSharedPtr<FJsonValue>& Value, FVFXDSLEmitter& OutEmitter, FString& OutError)
+{
+	const TSharedPtr<FJsonObject>* Object = nullptr;
+	if (!Value.IsValid() || !Value->TryGetObject(Object))
+	{
+		OutError = TEXT("expected an emitter object");
+		return false;
+	}
+
+	// Emitter values go through the DSL parser so they accept exactly what a full document does
+	FString EmitterJson;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&EmitterJson);
+	FVFXDSLEmitter Emitter;
+	if (!FJsonSerializer::Serialize(Object->ToSharedRef(), Writer) || !FVFXDSLStreamParser::ParseEmitter(EmitterJson, Emitter))
+	{
+		OutError = TEXT("invalid emitter object");
+		return false;
+	}
+
+	OutEmitter = MoveTemp(Emitter);
+	return true;
+}
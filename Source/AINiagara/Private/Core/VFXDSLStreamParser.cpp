@@ -0,0 +1,408 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/VFXDSLStreamParser.h"
+#include "Core/VFXDSLCodec.h"
+#include "Serialization/JsonReader.h"
+
+namespace
+{
+	bool IsScalar(EJsonNotation Notation)
+	{
+		return Notation == EJsonNotation::String
+			|| Notation == EJsonNotation::Number
+			|| Notation == EJsonNotation::Boolean;
+	}
+}
+
+/**
+ * Parses a VFX DSL specification from a JSON string in a single pass.
+ *
+ * Tokens are consumed in document order and written straight into OutDSL.
+ * Semantic problems (missing effect, missing or empty emitters, non-object
+ * emitter entries) are recorded while reading and reported only after the
+ * whole document has been consumed, so that malformed JSON anywhere in the
+ * input still wins with "Failed to parse JSON string" exactly as it does
+ * when FJsonSerializer builds the DOM first.
+ *
+ * @param JsonString The JSON string to parse (typically from LLM response)
+ * @param OutDSL Output parameter - the parsed DSL structure
+ * @param OutError Output parameter - error message if parsing fails
+ * @return true if parsing was successful, false otherwise
+ *
+ * @note Keys are matched case-insensitively, like FJsonObject field lookups
+ * @note When a key repeats, the last occurrence wins
+ */
+bool FVFXDSLStreamParser::Parse(const FString& JsonString, FVFXDSL& OutDSL, FString& OutError)
+{
+	TSharedRef<FReader> Reader = TJsonReaderFactory<>::Create(JsonString);
+
+	FRootState State;
+	if (!ReadRoot(*Reader, OutDSL, State))
+	{
+		OutError = TEXT("Failed to parse JSON string");
+		return false;
+	}
+
+	if (!State.bHasEffect)
+	{
+		OutError = TEXT("Missing or invalid 'effect' field");
+		return false;
+	}
+
+	if (!State.bHasEmitters)
+	{
+		OutError = TEXT("Missing 'emitters' array");
+		return false;
+	}
+
+	if (State.NumEmitterValues == 0)
+	{
+		OutError = TEXT("Emitters array is empty - at least one emitter is required");
+		return false;
+	}
+
+	if (State.FirstInvalidEmitterIndex != INDEX_NONE)
+	{
+		OutError = FString::Printf(TEXT("Failed to parse emitter at index %d"), State.FirstInvalidEmitterIndex);
+		return false;
+	}
+
+	return true;
+}
+
+bool FVFXDSLStreamParser::ParseEmitter(FStringView JsonString, FVFXDSLEmitter& OutEmitter)
+{
+	return ParseObject(JsonString, OutEmitter, &FVFXDSLStreamParser::ReadEmitter);
+}
+
+bool FVFXDSLStreamParser::ParseEffect(FStringView JsonString, FVFXDSLEffect& OutEffect)
+{
+	return ParseObject(JsonString, OutEffect, &FVFXDSLStreamParser::ReadEffect);
+}
+
+template <typename StructType>
+bool FVFXDSLStreamParser::ParseObject(FStringView JsonString, StructType& OutStruct, bool (*ReadFunction)(FReader&, StructType&))
+{
+	TSharedRef<FReader> Reader = TJsonReaderFactory<>::Create(FString(JsonString));
+
+	EJsonNotation Notation;
+	if (!Reader->ReadNext(Notation) || Notation != EJsonNotation::ObjectStart)
+	{
+		return false;
+	}
+
+	if (!ReadFunction(*Reader, OutStruct))
+	{
+		return false;
+	}
+
+	while (Reader->ReadNext(Notation))
+	{
+	}
+
+	return Reader->GetErrorMessage().IsEmpty();
+}
+
+bool FVFXDSLStreamParser::ReadRoot(FReader& Reader, FVFXDSL& OutDSL, FRootState& OutState)
+{
+	EJsonNotation Notation;
+	if (!Reader.ReadNext(Notation) || Notation != EJsonNotation::ObjectStart)
+	{
+		return false;
+	}
+
+	bool bClosed = false;
+	while (!bClosed && Reader.ReadNext(Notation))
+	{
+		if (Notation == EJsonNotation::ObjectEnd)
+		{
+			bClosed = true;
+			break;
+		}
+
+		const FString& Key = Reader.GetIdentifier();
+		if (Key == TEXT("effect"))
+		{
+			OutState.bHasEffect = (Notation == EJsonNotation::ObjectStart);
+			if (OutState.bHasEffect ? !ReadEffect(Reader, OutDSL.Effect) : !SkipValue(Reader, Notation))
+			{
+				return false;
+			}
+		}
+		else if (Key == TEXT("emitters"))
+		{
+			OutState.bHasEmitters = (Notation == EJsonNotation::ArrayStart);
+			OutState.NumEmitterValues = 0;
+			OutState.FirstInvalidEmitterIndex = INDEX_NONE;
+			if (OutState.bHasEmitters ? !ReadEmitters(Reader, OutDSL, OutState) : !SkipValue(Reader, Notation))
+			{
+				return false;
+			}
+		}
+		else if (!SkipValue(Reader, Notation))
+		{
+			return false;
+		}
+	}
+
+	if (!bClosed)
+	{
+		return false;
+	}
+
+	// Drain the reader so trailing input is rejected exactly like FJsonSerializer::Deserialize
+	while (Reader.ReadNext(Notation))
+	{
+	}
+
+	return Reader.GetErrorMessage().IsEmpty();
+}
+
+bool FVFXDSLStreamParser::ReadEmitters(FReader& Reader, FVFXDSL& OutDSL, FRootState& OutState)
+{
+	OutDSL.Emitters.Reset();
+
+	EJsonNotation Notation;
+	while (Reader.ReadNext(Notation))
+	{
+		if (Notation == EJsonNotation::ArrayEnd)
+		{
+			return true;
+		}
+
+		const int32 ValueIndex = OutState.NumEmitterValues++;
+		if (Notation == EJsonNotation::ObjectStart)
+		{
+			if (!ReadEmitter(Reader, OutDSL.Emitters.AddDefaulted_GetRef()))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			// Matches the DOM parser: the first non-object entry fails at the number of emitters parsed so far
+			if (OutState.FirstInvalidEmitterIndex == INDEX_NONE)
+			{
+				OutState.FirstInvalidEmitterIndex = ValueIndex;
+			}
+
+			if (!SkipValue(Reader, Notation))
+			{
+				return false;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool FVFXDSLStreamParser::ReadEffect(FReader& Reader, FVFXDSLEffect& OutEffect)
+{
+	return ReadStruct(Reader, FVFXDSLCodec::Get().GetEffectTable(), 0, &OutEffect);
+}
+
+bool FVFXDSLStreamParser::ReadEmitter(FReader& Reader, FVFXDSLEmitter& OutEmitter)
+{
+	return ReadStruct(Reader, FVFXDSLCodec::Get().GetEmitterTable(), 0, &OutEmitter);
+}
+
+bool FVFXDSLStreamParser::ReadStruct(FReader& Reader, const FVFXDSLCodecTable& Table, int32 NodeIndex, void* Base)
+{
+	const int32 FirstChild = Table.Fields[NodeIndex].FirstChild;
+	const int32 EndChild = FirstChild + Table.Fields[NodeIndex].NumChildren;
+
+	EJsonNotation Notation;
+	while (Reader.ReadNext(Notation))
+	{
+		if (Notation == EJsonNotation::ObjectEnd)
+		{
+			return true;
+		}
+
+		const FString& Key = Reader.GetIdentifier();
+		int32 FieldIndex = FirstChild;
+		while (FieldIndex < EndChild && !(Key == Table.Fields[FieldIndex].JsonKey))
+		{
+			++FieldIndex;
+		}
+
+		const bool bOk = (FieldIndex < EndChild)
+			? ReadField(Reader, Notation, Table, FieldIndex, Base)
+			: SkipValue(Reader, Notation);
+		if (!bOk)
+		{
+			return false;
+		}
+	}
+
+	return false;
+}
+
+bool FVFXDSLStreamParser::ReadField(FReader& Reader, EJsonNotation Notation, const FVFXDSLCodecTable& Table, int32 FieldIndex, void* Base)
+{
+	const FVFXDSLCodecField& Field = Table.Fields[FieldIndex];
+	switch (Field.Type)
+	{
+	case EVFXDSLCodecType::Struct:
+		return Notation == EJsonNotation::ObjectStart
+			? ReadStruct(Reader, Table, FieldIndex, Base)
+			: SkipValue(Reader, Notation);
+
+	case EVFXDSLCodecType::Float:
+		return ReadFloat(Reader, Notation, FVFXDSLCodec::GetValue<float>(Field, Base));
+
+	case EVFXDSLCodecType::Int32:
+		return ReadInt32(Reader, Notation, FVFXDSLCodec::GetValue<int32>(Field, Base));
+
+	case EVFXDSLCodecType::Bool:
+		return ReadBool(Reader, Notation, FVFXDSLCodec::GetValue<bool>(Field, Base));
+
+	case EVFXDSLCodecType::String:
+		return ReadString(Reader, Notation, FVFXDSLCodec::GetValue<FString>(Field, Base));
+
+	case EVFXDSLCodecType::Enum:
+	{
+		if (!IsScalar(Notation))
+		{
+			return SkipValue(Reader, Notation);
+		}
+
+		// Unknown names fall back to the first value, like UVFXDSLParser::ParseEffectType
+		FString Name;
+		int64 Value = Field.EnumEntries[0].Key;
+		ReadString(Reader, Notation, Name);
+		FVFXDSLCodec::FindEnumValue(Field, Name, Value);
+		FVFXDSLCodec::SetEnumValue(Field, Base, Value);
+		return true;
+	}
+
+	case EVFXDSLCodecType::FloatArray:
+		return Notation == EJsonNotation::ArrayStart
+			? ReadFloatArray(Reader, FVFXDSLCodec::GetValue<TArray<float>>(Field, Base))
+			: SkipValue(Reader, Notation);
+	}
+
+	return SkipValue(Reader, Notation);
+}
+
+bool FVFXDSLStreamParser::ReadFloatArray(FReader& Reader, TArray<float>& OutValues)
+{
+	OutValues.Reset();
+
+	EJsonNotation Notation;
+	while (Reader.ReadNext(Notation))
+	{
+		if (Notation == EJsonNotation::ArrayEnd)
+		{
+			return true;
+		}
+
+		// FJsonValue::AsNumber yields 0 for values that do not convert
+		double Value = 0.0;
+		if (!TryGetNumber(Reader, Notation, Value) && !SkipValue(Reader, Notation))
+		{
+			return false;
+		}
+		OutValues.Add(static_cast<float>(Value));
+	}
+
+	return false;
+}
+
+bool FVFXDSLStreamParser::ReadFloat(FReader& Reader, EJsonNotation Notation, float& InOutValue)
+{
+	double Value;
+	if (TryGetNumber(Reader, Notation, Value))
+	{
+		InOutValue = static_cast<float>(Value);
+		return true;
+	}
+	return SkipValue(Reader, Notation);
+}
+
+bool FVFXDSLStreamParser::ReadInt32(FReader& Reader, EJsonNotation Notation, int32& InOutValue)
+{
+	double Value;
+	if (TryGetNumber(Reader, Notation, Value))
+	{
+		InOutValue = static_cast<int32>(Value);
+		return true;
+	}
+	return SkipValue(Reader, Notation);
+}
+
+bool FVFXDSLStreamParser::ReadBool(FReader& Reader, EJsonNotation Notation, bool& InOutValue)
+{
+	switch (Notation)
+	{
+	case EJsonNotation::Boolean:
+		InOutValue = Reader.GetValueAsBoolean();
+		return true;
+	case EJsonNotation::Number:
+		InOutValue = Reader.GetValueAsNumber() != 0.0;
+		return true;
+	case EJsonNotation::String:
+		InOutValue = Reader.GetValueAsString().ToBool();
+		return true;
+	default:
+		return SkipValue(Reader, Notation);
+	}
+}
+
+bool FVFXDSLStreamParser::ReadString(FReader& Reader, EJsonNotation Notation, FString& InOutValue)
+{
+	switch (Notation)
+	{
+	case EJsonNotation::String:
+		InOutValue = Reader.GetValueAsString();
+		return true;
+	case EJsonNotation::Number:
+		InOutValue = FString::SanitizeFloat(Reader.GetValueAsNumber(), 0);
+		return true;
+	case EJsonNotation::Boolean:
+		InOutValue = Reader.GetValueAsBoolean() ? TEXT("true") : TEXT("false");
+		return true;
+	default:
+		return SkipValue(Reader, Notation);
+	}
+}
+
+bool FVFXDSLStreamParser::TryGetNumber(FReader& Reader, EJsonNotation Notation, double& OutValue)
+{
+	switch (Notation)
+	{
+	case EJsonNotation::Number:
+		OutValue = Reader.GetValueAsNumber();
+		return true;
+	case EJsonNotation::Boolean:
+		OutValue = Reader.GetValueAsBoolean() ? 1.0 : 0.0;
+		return true;
+	case EJsonNotation::String:
+		{
+			const FString& StringValue = Reader.GetValueAsString();
+			if (StringValue.IsNumeric())
+			{
+				OutValue = FCString::Atod(*StringValue);
+				return true;
+			}
+			return false;
+		}
+	default:
+		return false;
+	}
+}
+
+bool FVFXDSLStreamParser::SkipValue(FReader& Reader, EJsonNotation Notation)
+{
+	switch (Notation)
+	{
+	case EJsonNotation::ObjectStart:
+		return Reader.SkipObject();
+	case EJsonNotation::ArrayStart:
+		return Reader.SkipArray();
+	case EJsonNotation::Error:
+		return false;
+	default:
+		return true;
+	}
+}
@@ -6,15 +6,23 @@
 
 FString UVFXPromptBuilder::BuildSystemPrompt()
 {
-	FString SystemPrompt;
-	
-	SystemPrompt += BuildExpertPersonaInstructions();
-	SystemPrompt += TEXT("\n\n");
-	SystemPrompt += BuildDSLFormatInstructions();
-	SystemPrompt += TEXT("\n\n");
-	SystemPrompt += BuildToolUsageInstructions();
-	SystemPrompt += TEXT("\n\n");
-	SystemPrompt += Build3DModelInstructions();
+	// Every section is constant text, so the prompt is assembled once
+	static const FString SystemPrompt = []()
+	{
+		FString Prompt;
+		
+		Prompt += BuildExpertPersonaInstructions();
+		Prompt += TEXT("\n\n");
+		Prompt += BuildDSLFormatInstructions();
+		Prompt += TEXT("\n\n");
+		Prompt += BuildToolUsageInstructions();
+		Prompt += TEXT("\n\n");
+		Prompt += Build3DModelInstructions();
+		Prompt += TEXT("\n\n");
+		Prompt += BuildPatchInstructions();
+		
+		return Prompt;
+	}();
 	
 	return SystemPrompt;
 }
@@ -41,6 +49,31 @@ FString UVFXPromptBuilder::BuildUserPrompt(
 	return UserPrompt;
 }
 
+FString UVFXPromptBuilder::BuildCorrectionSystemPrompt()
+{
+	static const FString SystemPrompt = BuildDSLFormatInstructions();
+	return SystemPrompt;
+}
+
+FString UVFXPromptBuilder::BuildDSLCorrectionPrompt(
+	const FString& InvalidDSL,
+	const TArray<FString>& ErrorMessages
+)
+{
+	FString Prompt = TEXT("The following DSL failed validation. Fix every error listed below and reply with the complete corrected DSL JSON only, changing nothing else.\n\n");
+	
+	Prompt += TEXT("Validation errors:\n");
+	for (const FString& Error : ErrorMessages)
+	{
+		Prompt += TEXT("- ") + Error + TEXT("\n");
+	}
+	
+	Prompt += TEXT("\nDSL:\n");
+	Prompt += InvalidDSL;
+	
+	return Prompt;
+}
+
 TArray<FVFXToolFunction> UVFXPromptBuilder::GetAvailableTools()
 {
 	TArray<FVFXToolFunction> Tools;
@@ -233,3 +266,20 @@ FString UVFXPromptBuilder::Build3DModelInstructions()
 	);
 }
 
+FString UVFXPromptBuilder::BuildPatchInstructions()
+{
+	return TEXT(
+		"Editing an Existing Effect:\n"
+		"- When the user asks to change an effect you already generated, reply with a patch instead of the full DSL\n"
+		"- Patch format: {\"patch\": [{\"op\": \"set\", \"path\": \"Emitters[0].Initialization.Color.R\", \"value\": 1.0}]}\n"
+		"- Include only the fields that change; the patch is applied to the latest DSL of this conversation\n"
+		"- Ops: set (change a field, a group such as Initialization.Color, or replace a whole emitter), add (insert an emitter object; Emitters[-] appends), remove (delete an emitter), move (reorder, with \"from\": \"Emitters[2]\" and \"path\": \"Emitters[0]\")\n"
+		"- Paths: Effect.Type, Effect.Duration, Effect.Looping, Emitters[i].Name, Emitters[i].Spawners.Burst.Count/Time/Intervals, Emitters[i].Spawners.Rate.SpawnRate/ScaleOverTime, "
+		"Emitters[i].Initialization.Color.R/G/B/A, Emitters[i].Initialization.Size.Min/Max, Emitters[i].Initialization.Velocity.X/Y/Z, "
+		"Emitters[i].Update.Forces.Gravity, Emitters[i].Update.Forces.Wind.X/Y/Z, Emitters[i].Update.Drag, Emitters[i].Update.Collision.Enabled/Bounce, "
+		"Emitters[i].Render.Material/Texture/BlendMode/Sort, Emitters[i].Render.Mesh.MeshPath/MeshType/Scale/UseMesh, Emitters[i].Render.Mesh.Rotation.X/Y/Z\n"
+		"- Emitters can be addressed by index or by name, e.g. Emitters[Sparks].Spawners.Burst.Count\n"
+		"- Ops apply in order; indices after an add, remove or move refer to the updated list\n"
+		"- Send the full DSL instead when creating a new effect or when most of the effect changes\n"
+	);
+}
@@ -0,0 +1,425 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/VFXResponseDispatcher.h"
+#include "Core/VFXDSLParser.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Async/Async.h"
+#include "HAL/PlatformTime.h"
+#include "Tasks/Task.h"
+
+/**
+ * Classifies an LLM reply and parses its payload exactly once.
+ *
+ * Candidate JSON objects are located with ScanObject, which only tracks
+ * strings, nesting and root-level keys. Candidates are tried in order; the
+ * first one that parses as a tool call, a patch or a DSL wins. Candidates whose root
+ * keys match neither are skipped without being parsed.
+ *
+ * @param ResponseText Reply text (may contain prose and markdown fences)
+ * @param OutResponse Output classification
+ *
+ * @note NumLegacyParsedChars reproduces the previous widget flow: the whole
+ *       reply was deserialized by ProcessToolCalls and, unless a tool call was
+ *       handled, deserialized again by UVFXDSLParser::ParseFromJSON.
+ */
+void FVFXResponseDispatcher::Classify(const FString& ResponseText, FVFXClassifiedResponse& OutResponse)
+{
+	OutResponse = FVFXClassifiedResponse();
+
+	const FStringView Text(ResponseText);
+	int32 SearchStart = 0;
+	int32 Start = INDEX_NONE;
+	int32 End = INDEX_NONE;
+	uint8 RootKeys = RootKey_None;
+
+	while (OutResponse.Kind == EVFXResponseKind::Text && FindObject(Text, SearchStart, Start, End, RootKeys))
+	{
+		SearchStart = End + 1;
+
+		if (RootKeys == RootKey_None)
+		{
+			continue;
+		}
+
+		const FString JsonText(Text.Mid(Start, End - Start + 1));
+
+		if (RootKeys & (RootKey_FunctionCall | RootKey_Candidates))
+		{
+			OutResponse.NumParsedChars += JsonText.Len();
+
+			TSharedPtr<FJsonObject> JsonObject;
+			TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonText);
+			if (FJsonSerializer::Deserialize(Reader, JsonObject)
+				&& ExtractToolCall(JsonObject, OutResponse.ToolName, OutResponse.ToolArgs))
+			{
+				OutResponse.Kind = EVFXResponseKind::ToolCall;
+			}
+		}
+
+		if (OutResponse.Kind == EVFXResponseKind::Text && (RootKeys & RootKey_Patch))
+		{
+			OutResponse.NumParsedChars += JsonText.Len();
+
+			if (FVFXDSLPatch::ParseFromJSON(JsonText, OutResponse.Patch, OutResponse.DSLError))
+			{
+				OutResponse.Kind = EVFXResponseKind::Patch;
+				OutResponse.DSLError.Reset();
+			}
+			else
+			{
+				OutResponse.Patch = FVFXDSLPatch();
+			}
+		}
+
+		if (OutResponse.Kind == EVFXResponseKind::Text && (RootKeys & (RootKey_Effect | RootKey_Emitters)))
+		{
+			OutResponse.NumParsedChars += JsonText.Len();
+
+			if (UVFXDSLParser::ParseFromJSON(JsonText, OutResponse.DSL, OutResponse.DSLError))
+			{
+				OutResponse.Kind = EVFXResponseKind::DSL;
+				OutResponse.DSLError.Reset();
+			}
+			else
+			{
+				OutResponse.DSL = FVFXDSL();
+			}
+		}
+
+		if (OutResponse.Kind != EVFXResponseKind::Text)
+		{
+			OutResponse.JsonStart = Start;
+			OutResponse.JsonLength = End - Start + 1;
+		}
+	}
+
+	OutResponse.NumLegacyParsedChars = (OutResponse.Kind == EVFXResponseKind::ToolCall)
+		? ResponseText.Len()
+		: ResponseText.Len() * 2;
+
+	UE_LOG(LogTemp, Verbose, TEXT("AINiagara: Reply classified as %s (%d chars) - JSON parsers read %d chars (previously %d)"),
+		GetKindName(OutResponse.Kind), ResponseText.Len(), OutResponse.NumParsedChars, OutResponse.NumLegacyParsedChars);
+}
+
+bool FVFXResponseDispatcher::FindJsonObject(FStringView Text, int32 SearchStart, int32& OutStart, int32& OutLength)
+{
+	int32 End = INDEX_NONE;
+	uint8 RootKeys = RootKey_None;
+	if (!FindObject(Text, SearchStart, OutStart, End, RootKeys))
+	{
+		return false;
+	}
+
+	OutLength = End - OutStart + 1;
+	return true;
+}
+
+bool FVFXResponseDispatcher::IsUsableReply(const FString& ResponseText)
+{
+	FVFXClassifiedResponse Classified;
+	Classify(ResponseText, Classified);
+
+	// A patch can only be checked against the DSL it applies to, which the caller holds
+	if (Classified.Kind != EVFXResponseKind::DSL)
+	{
+		return Classified.DSLError.IsEmpty();
+	}
+
+	FVFXDSLValidationResult Result;
+	UVFXDSLValidator::ValidateInto(Classified.DSL, Result);
+	return Result.bIsValid;
+}
+
+void FVFXResponseDispatcher::Process(const FString& ResponseText, const FVFXDSL* BaseDSL, FVFXProcessedResponse& OutResponse)
+{
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	OutResponse = FVFXProcessedResponse();
+	FVFXClassifiedResponse& Classified = OutResponse.Classified;
+	Classify(ResponseText, Classified);
+
+	// A patch edits the base DSL; ApplyPatch validates the result, so a patched DSL is done here
+	if (Classified.Kind == EVFXResponseKind::Patch)
+	{
+		OutResponse.bWasPatch = true;
+		if (!BaseDSL)
+		{
+			OutResponse.PatchError = TEXT("Received a DSL patch, but there is no current effect to apply it to.");
+		}
+		else
+		{
+			FVFXDSL PatchedDSL = *BaseDSL;
+			FString PatchError;
+			if (FVFXDSLPatch::ApplyPatch(PatchedDSL, Classified.Patch, PatchError, &OutResponse.Validation))
+			{
+				Classified.DSL = MoveTemp(PatchedDSL);
+				Classified.Kind = EVFXResponseKind::DSL;
+			}
+			else
+			{
+				OutResponse.PatchError = FString::Printf(TEXT("Failed to apply DSL patch: %s"), *PatchError);
+			}
+		}
+	}
+	else if (Classified.Kind == EVFXResponseKind::DSL)
+	{
+		UVFXDSLValidator::ValidateInto(Classified.DSL, OutResponse.Validation);
+	}
+
+	if (Classified.Kind == EVFXResponseKind::DSL && !OutResponse.Validation.bIsValid)
+	{
+		UVFXDSLValidator::FormatErrors(OutResponse.Validation);
+	}
+
+	OutResponse.ProcessSeconds = FPlatformTime::Seconds() - StartSeconds;
+}
+
+/**
+ * The reply and the base DSL are copied into the task, so the caller may change
+ * its current DSL while the reply is processed. A result for a caller that has
+ * gone away is still delivered; OnProcessed must check that its owner is alive.
+ */
+void FVFXResponseDispatcher::ProcessAsync(const FString& ResponseText, const FVFXDSL* BaseDSL, TFunction<void(FVFXProcessedResponse&)> OnProcessed)
+{
+	TOptional<FVFXDSL> Base;
+	if (BaseDSL)
+	{
+		Base = *BaseDSL;
+	}
+
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [ResponseText, Base = MoveTemp(Base), OnProcessed = MoveTemp(OnProcessed)]() mutable
+	{
+		TSharedRef<FVFXProcessedResponse, ESPMode::ThreadSafe> Processed = MakeShared<FVFXProcessedResponse, ESPMode::ThreadSafe>();
+		Process(ResponseText, Base.GetPtrOrNull(), *Processed);
+
+		UE_LOG(LogTemp, Log, TEXT("AINiagara: Processed a %s reply off the game thread in %.2f ms"),
+			GetKindName(Processed->Classified.Kind), Processed->ProcessSeconds * 1000.0);
+
+		AsyncTask(ENamedThreads::GameThread, [Processed, OnProcessed = MoveTemp(OnProcessed)]()
+		{
+			OnProcessed(*Processed);
+		});
+	});
+}
+
+const TCHAR* FVFXResponseDispatcher::GetKindName(EVFXResponseKind Kind)
+{
+	switch (Kind)
+	{
+	case EVFXResponseKind::ToolCall:
+		return TEXT("ToolCall");
+	case EVFXResponseKind::DSL:
+		return TEXT("DSL");
+	case EVFXResponseKind::Patch:
+		return TEXT("Patch");
+	case EVFXResponseKind::Text:
+	default:
+		return TEXT("Text");
+	}
+}
+
+bool FVFXResponseDispatcher::FindObject(FStringView Text, int32 SearchStart, int32& OutStart, int32& OutEnd, uint8& OutRootKeys)
+{
+	for (int32 Index = SearchStart; Index < Text.Len(); ++Index)
+	{
+		if (Text[Index] != TEXT('{'))
+		{
+			continue;
+		}
+
+		if (ScanObject(Text, Index, OutEnd, OutRootKeys))
+		{
+			OutStart = Index;
+			return true;
+		}
+
+		// An unterminated object runs to the end of the text; any brace after it is nested inside
+		if (OutEnd == INDEX_NONE)
+		{
+			return false;
+		}
+	}
+
+	return false;
+}
+
+bool FVFXResponseDispatcher::ScanObject(FStringView Text, int32 Start, int32& OutEnd, uint8& OutRootKeys)
+{
+	OutEnd = INDEX_NONE;
+	OutRootKeys = RootKey_None;
+
+	int32 Depth = 0;
+	bool bInString = false;
+	bool bEscaped = false;
+	bool bExpectKey = false;
+	bool bAllowClose = false;
+	int32 KeyStart = INDEX_NONE;
+
+	for (int32 Index = Start; Index < Text.Len(); ++Index)
+	{
+		const TCHAR Char = Text[Index];
+
+		if (bInString)
+		{
+			if (bEscaped)
+			{
+				bEscaped = false;
+			}
+			else if (Char == TEXT('\\'))
+			{
+				bEscaped = true;
+			}
+			else if (Char == TEXT('"'))
+			{
+				bInString = false;
+				if (KeyStart != INDEX_NONE)
+				{
+					const FStringView Key = Text.Mid(KeyStart, Index - KeyStart);
+					if (Key.Equals(TEXT("functionCall"), ESearchCase::IgnoreCase))
+					{
+						OutRootKeys |= RootKey_FunctionCall;
+					}
+					else if (Key.Equals(TEXT("candidates"), ESearchCase::IgnoreCase))
+					{
+						OutRootKeys |= RootKey_Candidates;
+					}
+					else if (Key.Equals(TEXT("effect"), ESearchCase::IgnoreCase))
+					{
+						OutRootKeys |= RootKey_Effect;
+					}
+					else if (Key.Equals(TEXT("emitters"), ESearchCase::IgnoreCase))
+					{
+						OutRootKeys |= RootKey_Emitters;
+					}
+					else if (Key.Equals(TEXT("patch"), ESearchCase::IgnoreCase))
+					{
+						OutRootKeys |= RootKey_Patch;
+					}
+					KeyStart = INDEX_NONE;
+				}
+			}
+			continue;
+		}
+
+		if (bExpectKey)
+		{
+			if (FChar::IsWhitespace(Char))
+			{
+				continue;
+			}
+
+			bExpectKey = false;
+			if (Char == TEXT('"'))
+			{
+				bInString = true;
+				KeyStart = Index + 1;
+				continue;
+			}
+
+			// Prose such as "{placeholder}" is not an object
+			if (Char != TEXT('}') || !bAllowClose)
+			{
+				OutEnd = Index;
+				return false;
+			}
+		}
+
+		switch (Char)
+		{
+		case TEXT('"'):
+			bInString = true;
+			break;
+
+		case TEXT('{'):
+		case TEXT('['):
+			if (++Depth == 1)
+			{
+				bExpectKey = true;
+				bAllowClose = true;
+			}
+			break;
+
+		case TEXT('}'):
+		case TEXT(']'):
+			if (--Depth == 0)
+			{
+				OutEnd = Index;
+				return true;
+			}
+			break;
+
+		case TEXT(','):
+			if (Depth == 1)
+			{
+				bExpectKey = true;
+				bAllowClose = false;
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	return false;
+}
+
+bool FVFXResponseDispatcher::ExtractToolCall(const TSharedPtr<FJsonObject>& JsonObject, FString& OutName, TSharedPtr<FJsonObject>& OutArgs)
+{
+	if (!JsonObject.IsValid())
+	{
+		return false;
+	}
+
+	const TSharedPtr<FJsonObject>* FunctionCallObj = nullptr;
+
+	// Format: { "functionCall": { "name": "tool:texture", "args": {...} } }
+	if (!JsonObject->TryGetObjectField(TEXT("functionCall"), FunctionCallObj))
+	{
+		// Format: { "candidates": [{ "content": { "parts": [{ "functionCall": {...} }] } }] }
+		const TArray<TSharedPtr<FJsonValue>>* Candidates = nullptr;
+		const TSharedPtr<FJsonObject>* ContentObj = nullptr;
+		const TArray<TSharedPtr<FJsonValue>>* Parts = nullptr;
+		if (!JsonObject->TryGetArrayField(TEXT("candidates"), Candidates) || Candidates->Num() == 0)
+		{
+			return false;
+		}
+
+		const TSharedPtr<FJsonObject>& CandidateObj = (*Candidates)[0]->AsObject();
+		if (!CandidateObj.IsValid()
+			|| !CandidateObj->TryGetObjectField(TEXT("content"), ContentObj)
+			|| !(*ContentObj)->TryGetArrayField(TEXT("parts"), Parts))
+		{
+			return false;
+		}
+
+		for (const TSharedPtr<FJsonValue>& PartValue : *Parts)
+		{
+			const TSharedPtr<FJsonObject>& PartObj = PartValue->AsObject();
+			if (PartObj.IsValid() && PartObj->TryGetObjectField(TEXT("functionCall"), FunctionCallObj))
+			{
+				break;
+			}
+			FunctionCallObj = nullptr;
+		}
+
+		if (FunctionCallObj == nullptr)
+		{
+			return false;
+		}
+	}
+
+	if (!(*FunctionCallObj)->TryGetStringField(TEXT("name"), OutName) || OutName.IsEmpty())
+	{
+		return false;
+	}
+
+	const TSharedPtr<FJsonObject>* ArgsObj = nullptr;
+	if ((*FunctionCallObj)->TryGetObjectField(TEXT("args"), ArgsObj))
+	{
+		OutArgs = *ArgsObj;
+	}
+	return true;
+}
@@ -1,7 +1,7 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "Tools/ShaderGenerationHandler.h"
-#include "Core/GeminiAPIClient.h"
+#include "Core/LLMBackend.h"
 #include "Dom/JsonObject.h"
 #include "Serialization/JsonSerializer.h"
 #include "Serialization/JsonReader.h"
@@ -31,8 +31,8 @@ void UShaderGenerationHandler::RequestShaderFromAI(
 	FOnShaderGenerated OnComplete
 )
 {
-	// Create API client
-	FGeminiAPIClient* APIClient = new FGeminiAPIClient();
+	// Create the backend the settings select for shaders; the request does not depend on it staying alive
+	TSharedRef<ILLMBackend, ESPMode::ThreadSafe> Backend = ILLMBackend::Create(ELLMTask::Shader);
 
 	// Build prompt for shader generation
 	FString Prompt = FString::Printf(
@@ -64,15 +64,15 @@ void UShaderGenerationHandler::RequestShaderFromAI(
 		}
 	}
 
-	// Send request to Gemini API
+	// Send the request
 	TArray<FConversationMessage> EmptyHistory;
 	TArray<FVFXToolFunction> EmptyTools;
 
-	APIClient->SendChatCompletion(
+	Backend->SendChatCompletion(
 		Prompt,
 		EmptyHistory,
 		EmptyTools,
-		FOnGeminiResponse::CreateLambda([APIClient, Request, OnComplete](const FString& ResponseText)
+		FOnGeminiResponse::CreateLambda([Request, OnComplete](const FString& ResponseText)
 		{
 			FShaderGenerationResult Result;
 
@@ -94,28 +94,24 @@ void UShaderGenerationHandler::RequestShaderFromAI(
 				UE_LOG(LogTemp, Warning, TEXT("Could not extract HLSL code from AI response, using response as-is"));
 			}
 
-			// Cleanup API client
-			delete APIClient;
-
 			// Call completion callback
 			OnComplete.ExecuteIfBound(Result);
 		}),
-		FOnGeminiError::CreateLambda([APIClient, OnComplete](int32 ErrorCode, const FString& ErrorMessage)
+		FOnGeminiError::CreateLambda([OnComplete, BackendName = Backend->GetName()](int32 ErrorCode, const FString& ErrorMessage)
 		{
 			FShaderGenerationResult Result;
 			Result.bSuccess = false;
 			Result.ErrorMessage = FString::Printf(
-				TEXT("Gemini API error %d: %s"),
+				TEXT("%s error %d: %s"),
+				*BackendName,
 				ErrorCode,
 				*ErrorMessage
 			);
 
-			// Cleanup API client
-			delete APIClient;
-
 			// Call completion callback
 			OnComplete.ExecuteIfBound(Result);
-		})
+		}),
+		FGeminiRequestOptions(EGeminiRequestPriority::Tool)
 	);
 }
 
@@ -1,7 +1,7 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "Tools/TextureGenerationHandler.h"
-#include "Core/GeminiAPIClient.h"
+#include "Core/LLMBackend.h"
 #include "Engine/Texture2D.h"
 #include "IImageWrapper.h"
 #include "IImageWrapperModule.h"
@@ -12,6 +12,9 @@
 #include "Dom/JsonObject.h"
 #include "Serialization/JsonSerializer.h"
 #include "Serialization/JsonReader.h"
+#include "Async/Async.h"
+#include "HAL/PlatformTime.h"
+#include "Tasks/Task.h"
 
 void UTextureGenerationHandler::GenerateTexture(
 	const FTextureGenerationRequest& Request,
@@ -76,7 +79,7 @@ void UTextureGenerationHandler::GenerateFlipbook(
 			Request.Frames
 		);
 
-		// Capture frame index by value
+		// Capture frame index by value; frames are queued as background work so chat stays responsive
 		GenerateSingleFrame(FrameRequest, FrameIndex, 
 			FOnTextureGenerated::CreateLambda([State, FrameIndex](const FTextureGenerationResult& Result)
 			{
@@ -143,7 +146,8 @@ void UTextureGenerationHandler::GenerateFlipbook(
 					// Call completion callback
 					State->Callback.ExecuteIfBound(FinalResult);
 				}
-			})
+			}),
+			EGeminiRequestPriority::Background
 		);
 	}
 }
@@ -151,11 +155,12 @@ void UTextureGenerationHandler::GenerateFlipbook(
 void UTextureGenerationHandler::GenerateSingleFrame(
 	const FTextureGenerationRequest& Request,
 	int32 FrameIndex,
-	FOnTextureGenerated OnComplete
+	FOnTextureGenerated OnComplete,
+	EGeminiRequestPriority Priority
 )
 {
-	// Create API client
-	FGeminiAPIClient* APIClient = new FGeminiAPIClient();
+	// Create the backend the settings select for textures; the request does not depend on it staying alive
+	TSharedRef<ILLMBackend, ESPMode::ThreadSafe> Backend = ILLMBackend::Create(ELLMTask::Texture);
 
 	// Build prompt with color scheme if provided
 	FString FullPrompt = Request.Prompt;
@@ -167,81 +172,40 @@ void UTextureGenerationHandler::GenerateSingleFrame(
 	// Add texture-specific guidance
 	FullPrompt += TEXT(" Generate a seamless, tileable texture suitable for particle effects.");
 
-	// Request texture generation from Imagen 3
-	APIClient->GenerateTexture(
+	// Loading a module is game-thread work; decoding with it is not
+	FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+	// Request texture generation from Imagen 3 or the local image model. The image is decoded from the reply bytes on
+	// the worker that receives them; only the texture is created on the game thread
+	Backend->GenerateTextureContent(
 		FullPrompt,
 		Request.TextureType,
 		Request.Resolution,
-		FOnGeminiResponse::CreateLambda([APIClient, Request, OnComplete](const FString& ResponseText)
+		[Request, OnComplete](TConstArrayView<uint8> Content)
 		{
-			FTextureGenerationResult Result;
+			const double DecodeStartSeconds = FPlatformTime::Seconds();
 
-			// Parse response JSON to extract base64 image
-			TSharedPtr<FJsonObject> JsonObject;
-			TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseText);
+			TSharedRef<FTextureImageData, ESPMode::ThreadSafe> Image = MakeShared<FTextureImageData, ESPMode::ThreadSafe>();
+			FString DecodeError;
+			const bool bDecoded = DecodeImageContent(Content, *Image, DecodeError);
 
-			if (FJsonSerializer::Deserialize(Reader, JsonObject) && JsonObject.IsValid())
+			UE_LOG(LogTemp, Log, TEXT("AINiagara: Decoded a %dx%d image from %d reply bytes off the game thread in %.2f ms"),
+				Image->Width, Image->Height, Content.Num(), (FPlatformTime::Seconds() - DecodeStartSeconds) * 1000.0);
+
+			AsyncTask(ENamedThreads::GameThread, [Request, OnComplete, Image, DecodeError, bDecoded]()
 			{
-				// Try to extract image data from response
-				// Imagen 3 returns: { "predictions": [{ "bytesBase64Encoded": "..." }] }
-				// or { "candidates": [{ "content": { "parts": [{ "inlineData": { "data": "..." } }] } }] }
-				
-				FString Base64Data;
-				
-				// Try predictions format
-				if (JsonObject->HasTypedField<EJson::Array>(TEXT("predictions")))
-				{
-					const TArray<TSharedPtr<FJsonValue>>& Predictions = JsonObject->GetArrayField(TEXT("predictions"));
-					if (Predictions.Num() > 0)
-					{
-						TSharedPtr<FJsonObject> PredictionObj = Predictions[0]->AsObject();
-						if (PredictionObj.IsValid() && PredictionObj->HasTypedField<EJson::String>(TEXT("bytesBase64Encoded")))
-						{
-							Base64Data = PredictionObj->GetStringField(TEXT("bytesBase64Encoded"));
-						}
-					}
-				}
-				// Try candidates format
-				else if (JsonObject->HasTypedField<EJson::Array>(TEXT("candidates")))
-				{
-					const TArray<TSharedPtr<FJsonValue>>& Candidates = JsonObject->GetArrayField(TEXT("candidates"));
-					if (Candidates.Num() > 0)
-					{
-						TSharedPtr<FJsonObject> CandidateObj = Candidates[0]->AsObject();
-						if (CandidateObj.IsValid())
-						{
-							TSharedPtr<FJsonObject> ContentObj = CandidateObj->GetObjectField(TEXT("content"));
-							if (ContentObj.IsValid())
-							{
-								const TArray<TSharedPtr<FJsonValue>>& Parts = ContentObj->GetArrayField(TEXT("parts"));
-								if (Parts.Num() > 0)
-								{
-									TSharedPtr<FJsonObject> PartObj = Parts[0]->AsObject();
-									if (PartObj.IsValid())
-									{
-										TSharedPtr<FJsonObject> InlineDataObj = PartObj->GetObjectField(TEXT("inlineData"));
-										if (InlineDataObj.IsValid() && InlineDataObj->HasTypedField<EJson::String>(TEXT("data")))
-										{
-											Base64Data = InlineDataObj->GetStringField(TEXT("data"));
-										}
-									}
-								}
-							}
-						}
-					}
-				}
+				FTextureGenerationResult Result;
 
-				if (!Base64Data.IsEmpty())
+				if (bDecoded)
 				{
-					// Create texture from base64 data
+					// Create texture from the decoded pixels
 					FString TextureName = FString::Printf(TEXT("T_%s_%d"), *Request.TextureType, FMath::Rand());
-					UTexture2D* GeneratedTexture = nullptr;
+					UTexture2D* GeneratedTexture = CreateTextureFromImage(*Image, TextureName);
 
-					if (CreateTextureFromBase64(Base64Data, TextureName, GeneratedTexture))
+					if (GeneratedTexture)
 					{
 						Result.bSuccess = true;
 						Result.Texture = GeneratedTexture;
-						Result.Base64Data = Base64Data;
 						Result.FrameCount = 1;
 					}
 					else
@@ -253,37 +217,28 @@ void UTextureGenerationHandler::GenerateSingleFrame(
 				else
 				{
 					Result.bSuccess = false;
-					Result.ErrorMessage = TEXT("No image data found in Imagen 3 response");
+					Result.ErrorMessage = DecodeError;
 				}
-			}
-			else
-			{
-				Result.bSuccess = false;
-				Result.ErrorMessage = TEXT("Failed to parse Imagen 3 response JSON");
-			}
 
-			// Cleanup API client
-			delete APIClient;
-
-			// Call completion callback
-			OnComplete.ExecuteIfBound(Result);
-		}),
-		FOnGeminiError::CreateLambda([APIClient, OnComplete](int32 ErrorCode, const FString& ErrorMessage)
+				// Call completion callback
+				OnComplete.ExecuteIfBound(Result);
+			});
+		},
+		FOnGeminiError::CreateLambda([OnComplete, BackendName = Backend->GetName()](int32 ErrorCode, const FString& ErrorMessage)
 		{
 			FTextureGenerationResult Result;
 			Result.bSuccess = false;
 			Result.ErrorMessage = FString::Printf(
-				TEXT("Imagen 3 API error %d: %s"),
+				TEXT("%s image error %d: %s"),
+				*BackendName,
 				ErrorCode,
 				*ErrorMessage
 			);
 
-			// Cleanup API client
-			delete APIClient;
-
 			// Call completion callback
 			OnComplete.ExecuteIfBound(Result);
-		})
+		}),
+		FGeminiRequestOptions(Priority)
 	);
 }
 
@@ -311,8 +266,217 @@ bool UTextureGenerationHandler::CreateTextureFromPNG(
 	UTexture2D*& OutTexture
 )
 {
-	// Get image wrapper module
-	IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+	FTextureImageData Image;
+	if (!DecodePNG(PNGData, Image))
+	{
+		return false;
+	}
+
+	OutTexture = CreateTextureFromImage(Image, TextureName);
+	return OutTexture != nullptr;
+}
+
+bool UTextureGenerationHandler::ExtractImageBase64(const FString& ResponseText, FString& OutBase64, FString& OutError)
+{
+	OutBase64.Reset();
+
+	// Parse response JSON to extract base64 image
+	TSharedPtr<FJsonObject> JsonObject;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseText);
+
+	if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid())
+	{
+		OutError = TEXT("Failed to parse Imagen 3 response JSON");
+		return false;
+	}
+
+	// Try to extract image data from response
+	// Imagen 3 returns: { "predictions": [{ "bytesBase64Encoded": "..." }] }
+	// or { "candidates": [{ "content": { "parts": [{ "inlineData": { "data": "..." } }] } }] }
+	// and an OpenAI-compatible server { "data": [{ "b64_json": "..." }] }
+
+	// Try predictions format
+	if (JsonObject->HasTypedField<EJson::Array>(TEXT("predictions")))
+	{
+		const TArray<TSharedPtr<FJsonValue>>& Predictions = JsonObject->GetArrayField(TEXT("predictions"));
+		if (Predictions.Num() > 0)
+		{
+			TSharedPtr<FJsonObject> PredictionObj = Predictions[0]->AsObject();
+			if (PredictionObj.IsValid() && PredictionObj->HasTypedField<EJson::String>(TEXT("bytesBase64Encoded")))
+			{
+				OutBase64 = PredictionObj->GetStringField(TEXT("bytesBase64Encoded"));
+			}
+		}
+	}
+	// Try images/generations format
+	else if (JsonObject->HasTypedField<EJson::Array>(TEXT("data")))
+	{
+		const TArray<TSharedPtr<FJsonValue>>& Images = JsonObject->GetArrayField(TEXT("data"));
+		if (Images.Num() > 0)
+		{
+			TSharedPtr<FJsonObject> ImageObj = Images[0]->AsObject();
+			if (ImageObj.IsValid() && ImageObj->HasTypedField<EJson::String>(TEXT("b64_json")))
+			{
+				OutBase64 = ImageObj->GetStringField(TEXT("b64_json"));
+			}
+		}
+	}
+	// Try candidates format
+	else if (JsonObject->HasTypedField<EJson::Array>(TEXT("candidates")))
+	{
+		const TArray<TSharedPtr<FJsonValue>>& Candidates = JsonObject->GetArrayField(TEXT("candidates"));
+		if (Candidates.Num() > 0)
+		{
+			TSharedPtr<FJsonObject> CandidateObj = Candidates[0]->AsObject();
+			if (CandidateObj.IsValid())
+			{
+				TSharedPtr<FJsonObject> ContentObj = CandidateObj->GetObjectField(TEXT("content"));
+				if (ContentObj.IsValid())
+				{
+					const TArray<TSharedPtr<FJsonValue>>& Parts = ContentObj->GetArrayField(TEXT("parts"));
+					if (Parts.Num() > 0)
+					{
+						TSharedPtr<FJsonObject> PartObj = Parts[0]->AsObject();
+						if (PartObj.IsValid())
+						{
+							TSharedPtr<FJsonObject> InlineDataObj = PartObj->GetObjectField(TEXT("inlineData"));
+							if (InlineDataObj.IsValid() && InlineDataObj->HasTypedField<EJson::String>(TEXT("data")))
+							{
+								OutBase64 = InlineDataObj->GetStringField(TEXT("data"));
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if (OutBase64.IsEmpty())
+	{
+		OutError = TEXT("No image data found in Imagen 3 response");
+		return false;
+	}
+	return true;
+}
+
+bool UTextureGenerationHandler::FindImageBase64(TConstArrayView<uint8> Content, int32& OutStart, int32& OutLength, bool& bOutEscaped)
+{
+	OutStart = INDEX_NONE;
+	OutLength = 0;
+	bOutEscaped = false;
+
+	const FAnsiStringView Text(reinterpret_cast<const ANSICHAR*>(Content.GetData()), Content.Num());
+
+	// Imagen 3 returns: { "predictions": [{ "bytesBase64Encoded": "..." }] }
+	// or { "candidates": [{ "content": { "parts": [{ "inlineData": { "data": "..." } }] } }] }
+	// and an OpenAI-compatible server { "data": [{ "b64_json": "..." }] }
+	int32 KeyEnd = INDEX_NONE;
+	const int32 PredictionKey = Text.Find(ANSITEXTVIEW("\"bytesBase64Encoded\""));
+	const int32 ImageKey = PredictionKey == INDEX_NONE ? Text.Find(ANSITEXTVIEW("\"b64_json\"")) : INDEX_NONE;
+	if (PredictionKey != INDEX_NONE)
+	{
+		KeyEnd = PredictionKey + ANSITEXTVIEW("\"bytesBase64Encoded\"").Len();
+	}
+	else if (ImageKey != INDEX_NONE)
+	{
+		KeyEnd = ImageKey + ANSITEXTVIEW("\"b64_json\"").Len();
+	}
+	else
+	{
+		const int32 InlineDataKey = Text.Find(ANSITEXTVIEW("\"inlineData\""));
+		const int32 DataKey = InlineDataKey != INDEX_NONE ? Text.Find(ANSITEXTVIEW("\"data\""), InlineDataKey) : INDEX_NONE;
+		if (DataKey != INDEX_NONE)
+		{
+			KeyEnd = DataKey + ANSITEXTVIEW("\"data\"").Len();
+		}
+	}
+	if (KeyEnd == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// The key must be followed by a colon and a string value
+	int32 Index = KeyEnd;
+	auto SkipWhitespace = [&Text, &Index]()
+	{
+		while (Index < Text.Len() && (Text[Index] == ' ' || Text[Index] == '\t' || Text[Index] == '\r' || Text[Index] == '\n'))
+		{
+			++Index;
+		}
+	};
+	SkipWhitespace();
+	if (Index >= Text.Len() || Text[Index] != ':')
+	{
+		return false;
+	}
+	++Index;
+	SkipWhitespace();
+	if (Index >= Text.Len() || Text[Index] != '"')
+	{
+		return false;
+	}
+	++Index;
+
+	// Base64 has no characters JSON must escape, so the value normally ends at the next quote;
+	// a writer that escapes "/" anyway is reported so the caller can unescape it
+	const int32 Start = Index;
+	while (Index < Text.Len() && Text[Index] != '"')
+	{
+		if (Text[Index] == '\\')
+		{
+			bOutEscaped = true;
+			++Index;
+		}
+		++Index;
+	}
+	if (Index >= Text.Len())
+	{
+		return false;
+	}
+
+	OutStart = Start;
+	OutLength = Index - Start;
+	return OutLength > 0;
+}
+
+bool UTextureGenerationHandler::DecodeImageContent(TConstArrayView<uint8> Content, FTextureImageData& OutImage, FString& OutError)
+{
+	int32 Start = INDEX_NONE;
+	int32 Length = 0;
+	bool bEscaped = false;
+	if (!FindImageBase64(Content, Start, Length, bEscaped))
+	{
+		OutError = TEXT("No image data found in Imagen 3 response");
+		return false;
+	}
+
+	if (bEscaped)
+	{
+		// Rare enough to take the text path, which unescapes while parsing
+		const FUTF8ToTCHAR Body(reinterpret_cast<const ANSICHAR*>(Content.GetData()), Content.Num());
+		FString Base64Data;
+		return DecodeImageResponse(FString(Body.Length(), Body.Get()), Base64Data, OutImage, OutError);
+	}
+
+	// Decode the base64 where it lies in the reply; the buffer lives only as long as this image,
+	// since one allocation is cheap next to the PNG decode and workers should not hold megabytes between images
+	const ANSICHAR* Base64 = reinterpret_cast<const ANSICHAR*>(Content.GetData() + Start);
+	TArray<uint8> PNGBuffer;
+	PNGBuffer.AddUninitialized(FBase64::GetDecodedDataSize(Base64, Length));
+	if (!FBase64::Decode(Base64, Length, PNGBuffer.GetData()) || !DecodePNG(PNGBuffer, OutImage))
+	{
+		OutError = TEXT("Failed to create texture from base64 data");
+		return false;
+	}
+	return true;
+}
+
+bool UTextureGenerationHandler::DecodePNG(TConstArrayView<uint8> PNGData, FTextureImageData& OutImage)
+{
+	// Loading a module is game-thread work; workers only look up the module GenerateTexture loaded before sending
+	IImageWrapperModule& ImageWrapperModule = IsInGameThread()
+		? FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"))
+		: FModuleManager::GetModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
 	TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
 
 	if (!ImageWrapper.IsValid())
@@ -328,36 +492,58 @@ bool UTextureGenerationHandler::CreateTextureFromPNG(
 		return false;
 	}
 
-	// Get raw image data
-	TArray<uint8> RawData;
-	if (!ImageWrapper->GetRaw(ERGBFormat::BGRA, 8, RawData))
+	// Get raw image data; the wrapper's buffer is moved out, not copied
+	if (!ImageWrapper->GetRaw(ERGBFormat::BGRA, 8, OutImage.BGRA))
 	{
 		UE_LOG(LogTemp, Error, TEXT("Failed to decompress PNG data"));
 		return false;
 	}
 
 	// Get image dimensions
-	const int32 Width = ImageWrapper->GetWidth();
-	const int32 Height = ImageWrapper->GetHeight();
+	OutImage.Width = ImageWrapper->GetWidth();
+	OutImage.Height = ImageWrapper->GetHeight();
+	return true;
+}
+
+bool UTextureGenerationHandler::DecodeImageResponse(const FString& ResponseText, FString& OutBase64, FTextureImageData& OutImage, FString& OutError)
+{
+	if (!ExtractImageBase64(ResponseText, OutBase64, OutError))
+	{
+		return false;
+	}
+
+	// Decode base64 to bytes
+	TArray<uint8> ImageBytes;
+	if (!DecodeBase64(OutBase64, ImageBytes) || !DecodePNG(ImageBytes, OutImage))
+	{
+		OutError = TEXT("Failed to create texture from base64 data");
+		return false;
+	}
+	return true;
+}
+
+UTexture2D* UTextureGenerationHandler::CreateTextureFromImage(const FTextureImageData& Image, const FString& TextureName)
+{
+	check(IsInGameThread());
 
 	// Create texture
-	OutTexture = UTexture2D::CreateTransient(Width, Height, PF_B8G8R8A8);
-	if (!OutTexture)
+	UTexture2D* Texture = UTexture2D::CreateTransient(Image.Width, Image.Height, PF_B8G8R8A8);
+	if (!Texture)
 	{
 		UE_LOG(LogTemp, Error, TEXT("Failed to create transient texture"));
-		return false;
+		return nullptr;
 	}
 
 	// Copy data to texture
-	void* TextureData = OutTexture->GetPlatformData()->Mips[0].BulkData.Lock(LOCK_READ_WRITE);
-	FMemory::Memcpy(TextureData, RawData.GetData(), RawData.Num());
-	OutTexture->GetPlatformData()->Mips[0].BulkData.Unlock();
+	void* TextureData = Texture->GetPlatformData()->Mips[0].BulkData.Lock(LOCK_READ_WRITE);
+	FMemory::Memcpy(TextureData, Image.BGRA.GetData(), Image.BGRA.Num());
+	Texture->GetPlatformData()->Mips[0].BulkData.Unlock();
 
 	// Update texture
-	OutTexture->UpdateResource();
+	Texture->UpdateResource();
 
-	UE_LOG(LogTemp, Log, TEXT("Created texture '%s' (%dx%d)"), *TextureName, Width, Height);
-	return true;
+	UE_LOG(LogTemp, Log, TEXT("Created texture '%s' (%dx%d)"), *TextureName, Image.Width, Image.Height);
+	return Texture;
 }
 
 bool UTextureGenerationHandler::CreateFlipbookAtlas(
@@ -195,8 +195,7 @@ FReply SAINiagaraAPIKeyDialog::OnTestClicked()
 		{
 			UE_LOG(LogTemp, Log, TEXT("AINiagara: TestAPIKey response callback executed (outside AsyncTask)"));
 			
-			// Always execute on game thread - HandleRequestCompleteOnGameThread already handles thread safety
-			// But we still need to ensure UI updates are on game thread
+			// FGeminiAPIClient delivers replies on the game thread; hop there anyway if a caller ever does not
 			if (IsInGameThread())
 			{
 				UE_LOG(LogTemp, Log, TEXT("AINiagara: Already on game thread, updating UI directly"));
@@ -240,8 +239,7 @@ FReply SAINiagaraAPIKeyDialog::OnTestClicked()
 		{
 			UE_LOG(LogTemp, Log, TEXT("AINiagara: TestAPIKey error callback executed (outside AsyncTask): %d - %s"), ErrorCode, *ErrorMessage);
 			
-			// Always execute on game thread - HandleRequestCompleteOnGameThread already handles thread safety
-			// But we still need to ensure UI updates are on game thread
+			// FGeminiAPIClient delivers replies on the game thread; hop there anyway if a caller ever does not
 			if (IsInGameThread())
 			{
 				UE_LOG(LogTemp, Log, TEXT("AINiagara: Already on game thread, updating UI directly"));
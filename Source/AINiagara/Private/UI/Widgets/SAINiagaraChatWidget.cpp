@@ -2,7 +2,10 @@
 
 #include "UI/Widgets/SAINiagaraChatWidget.h"
 #include "Core/GeminiAPIClient.h"
+#include "Core/LLMBackend.h"
+#include "Core/AINiagaraSettings.h"
 #include "Core/ConversationHistoryManager.h"
+#include "Core/ConversationContextBuilder.h"
 #include "Core/VFXDSLParser.h"
 #include "Core/VFXPromptBuilder.h"
 #include "Core/NiagaraSystemGenerator.h"
@@ -12,11 +15,15 @@
 #include "Core/VFXDSLParser.h"
 #include "Core/PreviewSystemManager.h"
 #include "Core/VFXDSLDiff.h"
+#include "Core/VFXResponseDispatcher.h"
+#include "Core/VFXDSLPatch.h"
+#include "Core/VFXDSLIncrementalParser.h"
 #include "Tools/TextureGenerationHandler.h"
 #include "Tools/TextureMaterialHelper.h"
 #include "Tools/ShaderGenerationHandler.h"
 #include "Tools/MaterialGenerationHandler.h"
 #include "Tools/MeshDetectionHandler.h"
+#include "HAL/PlatformTime.h"
 #include "Particles/ParticleSystem.h"
 #include "Particles/ParticleEmitter.h"
 #include "Particles/ParticleLODLevel.h"
@@ -171,6 +178,12 @@ void SAINiagaraChatWidget::Construct(const FArguments& InArgs)
 	LoadConversationHistory();
 }
 
+SAINiagaraChatWidget::~SAINiagaraChatWidget()
+{
+	// The request's delegates capture this widget
+	ActiveRequest.Cancel();
+}
+
 FReply SAINiagaraChatWidget::OnSendClicked()
 {
 	if (!InputTextBox.IsValid())
@@ -186,6 +199,15 @@ FReply SAINiagaraChatWidget::OnSendClicked()
 
 	FString UserMessage = InputText.ToString();
 	
+	// A new prompt supersedes the reply still on its way; generating from it would be wasted work
+	if (ActiveRequest.IsPending())
+	{
+		UE_LOG(LogTemp, Log, TEXT("AINiagara: Cancelling superseded chat request"));
+		ActiveRequest.Cancel();
+	}
+	++ChatRequestSerial;
+	NumCorrectionAttempts = 0;
+	
 	// Add user message to history
 	AddMessageToHistory(TEXT("user"), UserMessage);
 	
@@ -201,15 +223,19 @@ FReply SAINiagaraChatWidget::OnSendClicked()
 	// Show loading
 	ShowLoading(true, TEXT("Preparing request..."));
 	
-	// Get conversation history
+	// Get conversation history, fitted to the token budget
 	TArray<FConversationMessage> ConversationHistory;
+	FConversationContextStats ContextStats;
 	if (UConversationHistoryManager* HistoryManager = UConversationHistoryManager::Get())
 	{
-		ConversationHistory = HistoryManager->GetHistory(CurrentAssetPath);
+		if (const TArray<FConversationMessage>* History = HistoryManager->FindHistory(CurrentAssetPath))
+		{
+			FConversationContextBuilder::Get().Build(CurrentAssetPath, *History, FConversationContextOptions::FromSettings(), ConversationHistory, ContextStats);
+		}
 	}
 
-	// Create API client
-	FGeminiAPIClient APIClient;
+	// Create the backend the settings select for chat; the request outlives it and is tracked through ActiveRequest
+	TSharedRef<ILLMBackend, ESPMode::ThreadSafe> Backend = ILLMBackend::Create(ELLMTask::Chat);
 	
 	// Build available tools
 	TArray<FVFXToolFunction> AvailableTools = UVFXPromptBuilder::GetAvailableTools();
@@ -225,22 +251,53 @@ FReply SAINiagaraChatWidget::OnSendClicked()
 	}
 	
 	// Show loading with message
-	ShowLoading(true, TEXT("Sending request to AI..."));
+	if (ContextStats.NumSummarizedMessages > 0)
+	{
+		ShowLoading(true, FString::Printf(TEXT("Sending request to AI... (%d older messages summarized, ~%d tokens saved)"),
+			ContextStats.NumSummarizedMessages, ContextStats.GetTokensSaved()));
+	}
+	else
+	{
+		ShowLoading(true, TEXT("Sending request to AI..."));
+	}
 
 	// Check for mesh requirements in user request before sending
 	FMeshDetectionResult MeshResult;
 	bool bMeshDetected = UMeshDetectionHandler::DetectMeshRequirement(UserMessage, MeshResult);
 	
-	// Send request to Gemini API
-	APIClient.SendChatCompletion(
+	// Scan the reply as it streams in to show how much of the DSL has arrived
+	TSharedRef<FVFXDSLIncrementalParser> StreamingParser = MakeShared<FVFXDSLIncrementalParser>();
+	
+	// Optionally duplicate slow requests and ask for several candidates, keeping the first valid DSL
+	FGeminiRequestOptions RequestOptions;
+	if (UAINiagaraSettings* Settings = UAINiagaraSettings::Get())
+	{
+		RequestOptions.Hedge = FGeminiHedgePolicy::AtPercentile(Settings->GetRequestHedgePercentile());
+		RequestOptions.CandidateCount = Settings->GetDSLCandidateCount();
+	}
+	RequestOptions.AcceptCandidate = &FVFXResponseDispatcher::IsUsableReply;
+	
+	// Send the request; the reply is streamed so progress shows from the first token
+	ActiveRequest = Backend->StreamChatCompletion(
 		UserMessage,
 		MessagesWithSystemPrompt,
 		AvailableTools,
-		FOnGeminiResponse::CreateLambda([this, UserMessage, bMeshDetected, MeshResult](const FString& ResponseText)
+		FOnGeminiStreamChunk::CreateLambda([this, StreamingParser](const FString& ChunkText, const FGeminiStreamStats& Stats)
 		{
-			// Hide loading
-			ShowLoading(false);
+			StreamingParser->AppendChunk(ChunkText);
 			
+			if (StreamingParser->HasStarted())
+			{
+				ShowLoading(true, FString::Printf(TEXT("Receiving DSL... %d emitter(s) so far (first token after %.1f s)"),
+					StreamingParser->GetNumEmittersParsed(), Stats.FirstChunkSeconds));
+			}
+			else
+			{
+				ShowLoading(true, FString::Printf(TEXT("Receiving response... (first token after %.1f s)"), Stats.FirstChunkSeconds));
+			}
+		}),
+		FOnGeminiResponse::CreateLambda([this, UserMessage, bMeshDetected, MeshResult, RequestSerial = ChatRequestSerial](const FString& ResponseText)
+		{
 			// Add assistant response to history
 			AddMessageToHistory(TEXT("assistant"), ResponseText);
 			
@@ -250,169 +307,204 @@ FReply SAINiagaraChatWidget::OnSendClicked()
 				HistoryManager->AddMessage(CurrentAssetPath, TEXT("assistant"), ResponseText);
 			}
 			
-			// First, check if response contains tool calls
-			if (ProcessToolCalls(ResponseText))
+			// Classify, patch and validate on a worker; only asset creation and UI updates come back here
+			ShowLoading(true, TEXT("Processing response..."));
+			TWeakPtr<SAINiagaraChatWidget> WeakThis = SharedThis(this);
+			FVFXResponseDispatcher::ProcessAsync(ResponseText, bHasLastDSL ? &LastDSL : nullptr,
+				[WeakThis, RequestSerial, bMeshDetected, MeshResult](FVFXProcessedResponse& Processed)
 			{
-				// Tool call was processed, don't try to parse as DSL
-				return;
-			}
+				TSharedPtr<SAINiagaraChatWidget> Widget = WeakThis.Pin();
+				if (!Widget.IsValid() || Widget->ChatRequestSerial != RequestSerial)
+				{
+					// The tab closed or a newer prompt superseded this reply
+					return;
+				}
+				Widget->ShowLoading(false);
+				
+				const double ApplyStartSeconds = FPlatformTime::Seconds();
+				Widget->HandleProcessedResponse(Processed, bMeshDetected, MeshResult);
+				UE_LOG(LogTemp, Log, TEXT("AINiagara: Reply took %.2f ms on a worker and %.2f ms on the game thread"),
+					Processed.ProcessSeconds * 1000.0, (FPlatformTime::Seconds() - ApplyStartSeconds) * 1000.0);
+			});
+		}),
+		FOnGeminiError::CreateLambda([this](int32 ErrorCode, const FString& ErrorMessage)
+		{
+			// Hide loading
+			ShowLoading(false);
 			
-			// Show mesh detection info if detected
-			if (bMeshDetected && MeshResult.bMeshRequired)
-			{
-				FString MeshInfo = FString::Printf(
-					TEXT("📦 Mesh requirement detected: %s\n")
-					TEXT("Recommended simple mesh: %s\n")
-					TEXT("Detected keywords: %s"),
-					*MeshResult.MeshType,
-					*MeshResult.RecommendedSimpleMesh,
-					*FString::Join(MeshResult.DetectedKeywords, TEXT(", "))
-				);
-				AddMessageToHistory(TEXT("system"), MeshInfo, false, false);
-			}
+			// Show error message
+			FString FullErrorMessage = FString::Printf(TEXT("API Error (%d): %s"), ErrorCode, *ErrorMessage);
+			ShowErrorNotification(FullErrorMessage);
+		}),
+		RequestOptions
+	);
+
+	return FReply::Handled();
+}
+
+void SAINiagaraChatWidget::HandleProcessedResponse(FVFXProcessedResponse& Processed, bool bMeshDetected, const FMeshDetectionResult& MeshResult)
+{
+	FVFXClassifiedResponse& Classified = Processed.Classified;
+	if (Classified.Kind == EVFXResponseKind::ToolCall && DispatchToolCall(Classified.ToolName, Classified.ToolArgs))
+	{
+		// Tool call was processed, don't try to parse as DSL
+		return;
+	}
+	
+	// Show mesh detection info if detected
+	if (bMeshDetected && MeshResult.bMeshRequired)
+	{
+		FString MeshInfo = FString::Printf(
+			TEXT("📦 Mesh requirement detected: %s\n")
+			TEXT("Recommended simple mesh: %s\n")
+			TEXT("Detected keywords: %s"),
+			*MeshResult.MeshType,
+			*MeshResult.RecommendedSimpleMesh,
+			*FString::Join(MeshResult.DetectedKeywords, TEXT(", "))
+		);
+		AddMessageToHistory(TEXT("system"), MeshInfo, false, false);
+	}
+	
+	// A patch reply that applied was turned into the patched DSL on the worker
+	if (Classified.Kind == EVFXResponseKind::Patch)
+	{
+		ShowErrorNotification(Processed.PatchError);
+		return;
+	}
+	
+	// Use the DSL parsed and validated on the worker
+	if (Classified.Kind == EVFXResponseKind::DSL)
+	{
+		const FVFXDSL& DSL = Classified.DSL;
+		const FVFXDSLValidationResult& ValidationResult = Processed.Validation;
+		
+		if (ValidationResult.bIsValid)
+		{
+			LastDSL = DSL;
+			bHasLastDSL = true;
 			
-			// Try to parse DSL from response
-			FVFXDSL DSL;
-			FString ParseError;
-			if (UVFXDSLParser::ParseFromJSON(ResponseText, DSL, ParseError))
+			// Update preview if enabled (shows in editor viewport)
+			UpdatePreview(DSL);
+			
+			// Generate Niagara/Cascade system from DSL
+			if (DSL.Effect.Type == EVFXEffectType::Niagara)
 			{
-				ShowLoading(true, TEXT("Validating DSL..."));
-				
-				// Validate DSL
-				FVFXDSLValidationResult ValidationResult = UVFXDSLValidator::Validate(DSL);
+				ShowLoading(true, TEXT("Generating Niagara system..."));
 				
-				ShowLoading(false);
-				
-				if (ValidationResult.bIsValid)
+				// Determine package path
+				FString PackagePath = TEXT("/Game/VFX");
+				if (!CurrentAssetPath.IsEmpty())
 				{
-					// Update preview if enabled (shows in editor viewport)
-					UpdatePreview(DSL);
-					
-					// Generate Niagara/Cascade system from DSL
-					if (DSL.Effect.Type == EVFXEffectType::Niagara)
+					// Extract package path from asset path
+					int32 LastSlash = CurrentAssetPath.Find(TEXT("/"), ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+					if (LastSlash != INDEX_NONE)
 					{
-						ShowLoading(true, TEXT("Generating Niagara system..."));
-						
-						// Determine package path
-						FString PackagePath = TEXT("/Game/VFX");
-						if (!CurrentAssetPath.IsEmpty())
-						{
-							// Extract package path from asset path
-							int32 LastSlash = CurrentAssetPath.Find(TEXT("/"), ESearchCase::CaseSensitive, ESearchDir::FromEnd);
-							if (LastSlash != INDEX_NONE)
-							{
-								PackagePath = CurrentAssetPath.Left(LastSlash);
-							}
-						}
-						
-						// Generate system name from first emitter name or use default
-						FString SystemName = TEXT("AINiagaraSystem");
-						if (DSL.Emitters.Num() > 0 && !DSL.Emitters[0].Name.IsEmpty())
-						{
-							SystemName = DSL.Emitters[0].Name + TEXT("_System");
-						}
-						
-						UNiagaraSystem* GeneratedSystem = nullptr;
-						FString GenerationError;
-						
-						if (UNiagaraSystemGenerator::CreateSystemFromDSL(DSL, PackagePath, SystemName, GeneratedSystem, GenerationError))
-						{
-							ShowLoading(false);
-							FString SuccessMessage = FString::Printf(
-								TEXT("Niagara system '%s' generated successfully at %s/%s!"),
-								*SystemName,
-								*PackagePath,
-								*SystemName
-							);
-							ShowSuccessNotification(SuccessMessage);
-						}
-						else
-						{
-							ShowLoading(false);
-							FString ErrorMessage = FString::Printf(
-								TEXT("Failed to generate Niagara system: %s"),
-								*GenerationError
-							);
-							ShowErrorNotification(ErrorMessage);
-						}
-					}
-					else if (DSL.Effect.Type == EVFXEffectType::Cascade)
-					{
-						ShowLoading(true, TEXT("Generating Cascade system..."));
-						
-						// Determine package path
-						FString PackagePath = TEXT("/Game/VFX");
-						if (!CurrentAssetPath.IsEmpty())
-						{
-							// Extract package path from asset path
-							int32 LastSlash = CurrentAssetPath.Find(TEXT("/"), ESearchCase::CaseSensitive, ESearchDir::FromEnd);
-							if (LastSlash != INDEX_NONE)
-							{
-								PackagePath = CurrentAssetPath.Left(LastSlash);
-							}
-						}
-						
-						// Generate system name from first emitter name or use default
-						FString SystemName = TEXT("AICascadeSystem");
-						if (DSL.Emitters.Num() > 0 && !DSL.Emitters[0].Name.IsEmpty())
-						{
-							SystemName = DSL.Emitters[0].Name + TEXT("_System");
-						}
-						
-						UParticleSystem* GeneratedSystem = nullptr;
-						FString GenerationError;
-						
-						if (UCascadeSystemGenerator::CreateSystemFromDSL(DSL, PackagePath, SystemName, GeneratedSystem, GenerationError))
-						{
-							ShowLoading(false);
-							FString SuccessMessage = FString::Printf(
-								TEXT("Cascade system '%s' generated successfully at %s/%s!"),
-								*SystemName,
-								*PackagePath,
-								*SystemName
-							);
-							ShowSuccessNotification(SuccessMessage);
-						}
-						else
-						{
-							ShowLoading(false);
-							FString ErrorMessage = FString::Printf(
-								TEXT("Failed to generate Cascade system: %s"),
-								*GenerationError
-							);
-							ShowErrorNotification(ErrorMessage);
-						}
+						PackagePath = CurrentAssetPath.Left(LastSlash);
 					}
 				}
+				
+				// Generate system name from first emitter name or use default
+				FString SystemName = TEXT("AINiagaraSystem");
+				if (DSL.Emitters.Num() > 0 && !DSL.Emitters[0].Name.IsEmpty())
+				{
+					SystemName = DSL.Emitters[0].Name + TEXT("_System");
+				}
+				
+				UNiagaraSystem* GeneratedSystem = nullptr;
+				FString GenerationError;
+				
+				if (UNiagaraSystemGenerator::CreateSystemFromDSL(DSL, PackagePath, SystemName, GeneratedSystem, GenerationError))
+				{
+					ShowLoading(false);
+					FString SuccessMessage = FString::Printf(
+						TEXT("Niagara system '%s' generated successfully at %s/%s!"),
+						*SystemName,
+						*PackagePath,
+						*SystemName
+					);
+					ShowSuccessNotification(SuccessMessage);
+				}
 				else
 				{
-					// Show validation errors
-					FString ErrorMessage = TEXT("DSL validation failed:\n");
-					for (const FString& Error : ValidationResult.ErrorMessages)
+					ShowLoading(false);
+					FString ErrorMessage = FString::Printf(
+						TEXT("Failed to generate Niagara system: %s"),
+						*GenerationError
+					);
+					ShowErrorNotification(ErrorMessage);
+				}
+			}
+			else if (DSL.Effect.Type == EVFXEffectType::Cascade)
+			{
+				ShowLoading(true, TEXT("Generating Cascade system..."));
+				
+				// Determine package path
+				FString PackagePath = TEXT("/Game/VFX");
+				if (!CurrentAssetPath.IsEmpty())
+				{
+					// Extract package path from asset path
+					int32 LastSlash = CurrentAssetPath.Find(TEXT("/"), ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+					if (LastSlash != INDEX_NONE)
 					{
-						ErrorMessage += Error + TEXT("\n");
+						PackagePath = CurrentAssetPath.Left(LastSlash);
 					}
+				}
+				
+				// Generate system name from first emitter name or use default
+				FString SystemName = TEXT("AICascadeSystem");
+				if (DSL.Emitters.Num() > 0 && !DSL.Emitters[0].Name.IsEmpty())
+				{
+					SystemName = DSL.Emitters[0].Name + TEXT("_System");
+				}
+				
+				UParticleSystem* GeneratedSystem = nullptr;
+				FString GenerationError;
+				
+				if (UCascadeSystemGenerator::CreateSystemFromDSL(DSL, PackagePath, SystemName, GeneratedSystem, GenerationError))
+				{
+					ShowLoading(false);
+					FString SuccessMessage = FString::Printf(
+						TEXT("Cascade system '%s' generated successfully at %s/%s!"),
+						*SystemName,
+						*PackagePath,
+						*SystemName
+					);
+					ShowSuccessNotification(SuccessMessage);
+				}
+				else
+				{
+					ShowLoading(false);
+					FString ErrorMessage = FString::Printf(
+						TEXT("Failed to generate Cascade system: %s"),
+						*GenerationError
+					);
 					ShowErrorNotification(ErrorMessage);
 				}
 			}
-			else
+		}
+		else
+		{
+			// Show validation errors
+			FString ErrorMessage = TEXT("DSL validation failed:\n");
+			for (const FString& Error : ValidationResult.ErrorMessages)
 			{
-				// Response is not DSL, just show it
-				// This might be a tool call or other response
+				ErrorMessage += Error + TEXT("\n");
 			}
-		}),
-		FOnGeminiError::CreateLambda([this](int32 ErrorCode, const FString& ErrorMessage)
-		{
-			// Hide loading
-			ShowLoading(false);
+			ShowErrorNotification(ErrorMessage);
 			
-			// Show error message
-			FString FullErrorMessage = FString::Printf(TEXT("API Error (%d): %s"), ErrorCode, *ErrorMessage);
-			ShowErrorNotification(FullErrorMessage);
-		})
-	);
-
-	return FReply::Handled();
+			// Ask for a repair while attempts remain; the corrected reply comes back through here
+			const UAINiagaraSettings* Settings = UAINiagaraSettings::Get();
+			FString InvalidDSL;
+			if (Settings && NumCorrectionAttempts < Settings->GetMaxDSLCorrectionAttempts() && UVFXDSLParser::ToJSON(DSL, InvalidDSL))
+			{
+				RequestDSLCorrection(InvalidDSL, ValidationResult);
+			}
+		}
+	}
+	else
+	{
+		// Response is plain text (or an unsupported tool call), it is already shown
+	}
 }
 
 void SAINiagaraChatWidget::OnInputTextCommitted(const FText& Text, ETextCommit::Type CommitType)
@@ -615,9 +707,48 @@ FString SAINiagaraChatWidget::GetCurrentAssetPath() const
 
 void SAINiagaraChatWidget::RequestDSLCorrection(const FString& InvalidDSL, const FVFXDSLValidationResult& ValidationResult)
 {
-	// TODO: Implement DSL correction request to LLM
-	// This would send the invalid DSL and validation errors back to the LLM
-	// asking for corrections
+	++NumCorrectionAttempts;
+	ShowLoading(true, FString::Printf(TEXT("Asking for a corrected DSL (attempt %d)..."), NumCorrectionAttempts));
+	
+	// A repair needs the format and the errors, not the conversation, so it is routed to the fast model by default
+	TSharedRef<ILLMBackend, ESPMode::ThreadSafe> Backend = ILLMBackend::Create(ELLMTask::Correction);
+	
+	TArray<FConversationMessage> Messages;
+	Messages.Add(FConversationMessage(TEXT("system"), UVFXPromptBuilder::BuildCorrectionSystemPrompt()));
+	
+	ActiveRequest = Backend->SendChatCompletion(
+		UVFXPromptBuilder::BuildDSLCorrectionPrompt(InvalidDSL, ValidationResult.ErrorMessages),
+		Messages,
+		TArray<FVFXToolFunction>(),
+		FOnGeminiResponse::CreateLambda([this, RequestSerial = ChatRequestSerial](const FString& ResponseText)
+		{
+			AddMessageToHistory(TEXT("assistant"), ResponseText);
+			
+			if (UConversationHistoryManager* HistoryManager = UConversationHistoryManager::Get())
+			{
+				HistoryManager->AddMessage(CurrentAssetPath, TEXT("assistant"), ResponseText);
+			}
+			
+			// The correction replaces the invalid DSL, so there is nothing for a patch to apply to
+			ShowLoading(true, TEXT("Processing corrected response..."));
+			TWeakPtr<SAINiagaraChatWidget> WeakThis = SharedThis(this);
+			FVFXResponseDispatcher::ProcessAsync(ResponseText, nullptr, [WeakThis, RequestSerial](FVFXProcessedResponse& Processed)
+			{
+				TSharedPtr<SAINiagaraChatWidget> Widget = WeakThis.Pin();
+				if (!Widget.IsValid() || Widget->ChatRequestSerial != RequestSerial)
+				{
+					return;
+				}
+				Widget->ShowLoading(false);
+				Widget->HandleProcessedResponse(Processed, false, FMeshDetectionResult());
+			});
+		}),
+		FOnGeminiError::CreateLambda([this](int32 ErrorCode, const FString& ErrorMessage)
+		{
+			ShowLoading(false);
+			ShowErrorNotification(FString::Printf(TEXT("Correction request failed (%d): %s"), ErrorCode, *ErrorMessage));
+		})
+	);
 }
 
 void SAINiagaraChatWidget::ShowSuccessNotification(const FString& Message)
@@ -821,6 +952,8 @@ FReply SAINiagaraChatWidget::OnImportDSLClicked()
 			// Store loaded DSL
 			LoadedDSL = ParsedDSL;
 			bHasLoadedDSL = true;
+			LastDSL = ParsedDSL;
+			bHasLastDSL = true;
 
 			// Show success message
 			FString SuccessMessage = FString::Printf(
@@ -1035,95 +1168,25 @@ void SAINiagaraChatWidget::UpdatePreview(const FVFXDSL& DSL)
 	}
 }
 
-bool SAINiagaraChatWidget::ProcessToolCalls(const FString& ResponseText)
+bool SAINiagaraChatWidget::DispatchToolCall(const FString& ToolName, TSharedPtr<FJsonObject> ToolArgs)
 {
-	// Try to parse response as JSON to check for tool calls
-	TSharedPtr<FJsonObject> JsonObject;
-	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseText);
-
-	if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid())
+	if (ToolName == TEXT("tool:texture"))
 	{
-		// Not JSON or invalid - no tool calls
-		return false;
+		ProcessTextureGenerationTool(ToolArgs);
+		return true;
 	}
-
-	// Check for function calls in Gemini API format
-	// Format: { "functionCall": { "name": "tool:texture", "args": {...} } }
-	if (JsonObject->HasTypedField<EJson::Object>(TEXT("functionCall")))
+	else if (ToolName == TEXT("tool:shader"))
 	{
-		TSharedPtr<FJsonObject> FunctionCallObj = JsonObject->GetObjectField(TEXT("functionCall"));
-		if (FunctionCallObj.IsValid())
-		{
-			FString FunctionName = FunctionCallObj->GetStringField(TEXT("name"));
-			
-			if (FunctionName == TEXT("tool:texture"))
-			{
-				TSharedPtr<FJsonObject> ArgsObj = FunctionCallObj->GetObjectField(TEXT("args"));
-				ProcessTextureGenerationTool(ArgsObj);
-				return true;
-			}
-			else if (FunctionName == TEXT("tool:shader"))
-			{
-				TSharedPtr<FJsonObject> ArgsObj = FunctionCallObj->GetObjectField(TEXT("args"));
-				ProcessShaderGenerationTool(ArgsObj);
-				return true;
-			}
-			else if (FunctionName == TEXT("tool:material"))
-			{
-				TSharedPtr<FJsonObject> ArgsObj = FunctionCallObj->GetObjectField(TEXT("args"));
-				ProcessMaterialGenerationTool(ArgsObj);
-				return true;
-			}
-		}
+		ProcessShaderGenerationTool(ToolArgs);
+		return true;
 	}
-
-	// Check for candidates format with function calls
-	// Format: { "candidates": [{ "content": { "parts": [{ "functionCall": {...} }] } }] }
-	if (JsonObject->HasTypedField<EJson::Array>(TEXT("candidates")))
+	else if (ToolName == TEXT("tool:material"))
 	{
-		const TArray<TSharedPtr<FJsonValue>>& Candidates = JsonObject->GetArrayField(TEXT("candidates"));
-		if (Candidates.Num() > 0)
-		{
-			TSharedPtr<FJsonObject> CandidateObj = Candidates[0]->AsObject();
-			if (CandidateObj.IsValid())
-			{
-				TSharedPtr<FJsonObject> ContentObj = CandidateObj->GetObjectField(TEXT("content"));
-				if (ContentObj.IsValid())
-				{
-					const TArray<TSharedPtr<FJsonValue>>& Parts = ContentObj->GetArrayField(TEXT("parts"));
-					for (const TSharedPtr<FJsonValue>& PartValue : Parts)
-					{
-						TSharedPtr<FJsonObject> PartObj = PartValue->AsObject();
-						if (PartObj.IsValid() && PartObj->HasTypedField<EJson::Object>(TEXT("functionCall")))
-						{
-							TSharedPtr<FJsonObject> FunctionCallObj = PartObj->GetObjectField(TEXT("functionCall"));
-							FString FunctionName = FunctionCallObj->GetStringField(TEXT("name"));
-							
-							if (FunctionName == TEXT("tool:texture"))
-							{
-								TSharedPtr<FJsonObject> ArgsObj = FunctionCallObj->GetObjectField(TEXT("args"));
-								ProcessTextureGenerationTool(ArgsObj);
-								return true;
-							}
-							else if (FunctionName == TEXT("tool:shader"))
-							{
-								TSharedPtr<FJsonObject> ArgsObj = FunctionCallObj->GetObjectField(TEXT("args"));
-								ProcessShaderGenerationTool(ArgsObj);
-								return true;
-							}
-							else if (FunctionName == TEXT("tool:material"))
-							{
-								TSharedPtr<FJsonObject> ArgsObj = FunctionCallObj->GetObjectField(TEXT("args"));
-								ProcessMaterialGenerationTool(ArgsObj);
-								return true;
-							}
-						}
-					}
-				}
-			}
-		}
+		ProcessMaterialGenerationTool(ToolArgs);
+		return true;
 	}
 
+	UE_LOG(LogTemp, Warning, TEXT("AINiagara: Ignoring unsupported tool call '%s'"), *ToolName);
 	return false;
 }
 
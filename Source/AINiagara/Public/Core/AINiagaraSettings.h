@@ -6,6 +6,7 @@
 #include "UObject/Object.h"
 #include "UObject/ObjectMacros.h"
 #include "Engine/Engine.h"
+#include "Core/LLMBackend.h"
 #include "AINiagaraSettings.generated.h"
 
 /**
@@ -66,11 +67,237 @@ public:
 	 */
 	void SaveConfig();
 
+	/**
+	 * Check if Gemini replies are cached on disk and reused for identical requests
+	 * @return True if the response cache is enabled
+	 */
+	bool IsResponseCacheEnabled() const { return bEnableResponseCache; }
+
+	/**
+	 * Check if requests may only be answered from the response cache
+	 * @return True if a cache miss must fail instead of reaching the network
+	 */
+	bool IsResponseCacheReplayOnly() const { return bResponseCacheReplayOnly; }
+
+	/**
+	 * Get the size limit of the response cache
+	 * @return Limit in megabytes
+	 */
+	int32 GetResponseCacheMaxSizeMB() const { return ResponseCacheMaxSizeMB; }
+
+	/**
+	 * Get the token budget of the conversation history sent with a chat request
+	 * @return Estimated tokens
+	 */
+	int32 GetContextTokenBudget() const { return ContextTokenBudget; }
+
+	/**
+	 * Get the number of recent messages always sent verbatim
+	 * @return Number of messages
+	 */
+	int32 GetContextRecentMessages() const { return ContextRecentMessages; }
+
+	/**
+	 * Get the token limit of the summary that replaces older messages
+	 * @return Estimated tokens
+	 */
+	int32 GetContextSummaryTokens() const { return ContextSummaryTokens; }
+
+	/**
+	 * Check if the system prompt and tool declarations are kept in provider-side cached content
+	 * @return True if chat requests refer to cached content when it is available
+	 */
+	bool IsContextCacheEnabled() const { return bEnableContextCache; }
+
+	/**
+	 * Get the lifetime of the cached context
+	 * @return Seconds
+	 */
+	int32 GetContextCacheTTLSeconds() const { return ContextCacheTTLSeconds; }
+
+	/**
+	 * Get the latency percentile after which a slow chat request is sent a second time
+	 * @return Percentile between 0 and 1, 0 if requests are never duplicated
+	 */
+	float GetRequestHedgePercentile() const { return FMath::Clamp(RequestHedgePercentile, 0.0f, 1.0f); }
+
+	/**
+	 * Get the number of candidates asked for per chat request; the first that validates is used
+	 * @return Candidates, at least 1
+	 */
+	int32 GetDSLCandidateCount() const { return FMath::Clamp(DSLCandidateCount, 1, 8); }
+
+	/**
+	 * Get the service a kind of request is sent to
+	 * @param Task Kind of request
+	 * @return Backend selected for it
+	 */
+	ELLMBackendType GetBackendForTask(ELLMTask Task) const;
+
+	/**
+	 * Check if any kind of request is sent to Gemini
+	 * @return True if a Gemini API key is needed
+	 */
+	bool IsGeminiBackendUsed() const;
+
+	/**
+	 * Get the size of model a kind of request is routed to
+	 * @param Task Kind of request; texture requests always use the image model
+	 * @return Large or fast model
+	 */
+	ELLMModelTier GetModelTierForTask(ELLMTask Task) const;
+
+	/**
+	 * Get the chat model a kind of request goes to, on the backend selected for it
+	 * @param Task Kind of request
+	 * @return Model name as that backend knows it
+	 */
+	FString GetChatModelForTask(ELLMTask Task) const;
+
+	/**
+	 * Get the Gemini model of a tier
+	 * @param Tier Large or fast model
+	 * @return Model name (e.g. "gemini-1.5-flash")
+	 */
+	FString GetGeminiModel(ELLMModelTier Tier) const;
+
+	/**
+	 * Get the number of times an invalid DSL reply is sent back for repair
+	 * @return Attempts per prompt, 0 if invalid replies are only reported
+	 */
+	int32 GetMaxDSLCorrectionAttempts() const { return FMath::Clamp(MaxDSLCorrectionAttempts, 0, 5); }
+
+	/**
+	 * Get the URL of the OpenAI-compatible server
+	 * @return URL that endpoints such as "/chat/completions" are appended to
+	 */
+	FString GetLocalServerURL() const { return LocalServerURL; }
+
+	/**
+	 * Get the model named in chat requests to the OpenAI-compatible server
+	 * @return Model name
+	 */
+	FString GetLocalChatModel() const { return LocalChatModel; }
+
+	/**
+	 * Get the model named in chat requests routed to the fast tier of the OpenAI-compatible server
+	 * @return Model name
+	 */
+	FString GetLocalFastChatModel() const { return LocalFastChatModel; }
+
+	/**
+	 * Get the model named in image requests to the OpenAI-compatible server
+	 * @return Model name
+	 */
+	FString GetLocalImageModel() const { return LocalImageModel; }
+
+	/**
+	 * Get the key sent to the OpenAI-compatible server
+	 * @return Bearer token, empty if the server needs none
+	 */
+	FString GetLocalServerAPIKey() const { return LocalServerAPIKey; }
+
 private:
 	/** Gemini API key - stored in EditorPerProjectUserSettings config */
 	UPROPERTY(Config)
 	FString GeminiAPIKey;
 
+	/** Cache Gemini replies under Saved/AINiagara/ResponseCache */
+	UPROPERTY(Config)
+	bool bEnableResponseCache = false;
+
+	/** Answer requests only from the response cache (offline, deterministic runs) */
+	UPROPERTY(Config)
+	bool bResponseCacheReplayOnly = false;
+
+	/** Response cache size limit; least recently used replies are evicted beyond it */
+	UPROPERTY(Config)
+	int32 ResponseCacheMaxSizeMB = 256;
+
+	/** Estimated tokens of history sent per chat request; older messages beyond it are summarized */
+	UPROPERTY(Config)
+	int32 ContextTokenBudget = 12000;
+
+	/** Most recent messages sent verbatim even when they exceed the budget */
+	UPROPERTY(Config)
+	int32 ContextRecentMessages = 6;
+
+	/** Estimated tokens of the summary of older messages */
+	UPROPERTY(Config)
+	int32 ContextSummaryTokens = 1000;
+
+	/** Upload the system prompt and tools once as cached content instead of with every chat request */
+	UPROPERTY(Config)
+	bool bEnableContextCache = false;
+
+	/** Lifetime of the cached context; it is recreated when it expires */
+	UPROPERTY(Config)
+	int32 ContextCacheTTLSeconds = 3600;
+
+	/** Send a duplicate of chat requests slower than this percentile of recent ones (e.g. 0.95); 0 disables it */
+	UPROPERTY(Config)
+	float RequestHedgePercentile = 0.0f;
+
+	/** Candidates asked for per chat request; more than 1 costs output tokens but skips invalid DSL replies */
+	UPROPERTY(Config)
+	int32 DSLCandidateCount = 1;
+
+	/** Service effect design requests in the chat window go to */
+	UPROPERTY(Config)
+	ELLMBackendType ChatBackend = ELLMBackendType::Gemini;
+
+	/** Service tool:shader requests go to */
+	UPROPERTY(Config)
+	ELLMBackendType ShaderBackend = ELLMBackendType::Gemini;
+
+	/** Service tool:texture requests go to; the server must implement /images/generations */
+	UPROPERTY(Config)
+	ELLMBackendType TextureBackend = ELLMBackendType::Gemini;
+
+	/** Model size effect design requests in the chat window go to */
+	UPROPERTY(Config)
+	ELLMModelTier ChatModelTier = ELLMModelTier::Large;
+
+	/** Model size tool:shader requests go to */
+	UPROPERTY(Config)
+	ELLMModelTier ShaderModelTier = ELLMModelTier::Fast;
+
+	/** Model size DSL repairs go to */
+	UPROPERTY(Config)
+	ELLMModelTier CorrectionModelTier = ELLMModelTier::Fast;
+
+	/** Gemini model of the large tier */
+	UPROPERTY(Config)
+	FString GeminiLargeModel = TEXT("gemini-pro");
+
+	/** Gemini model of the fast tier, also used to test API keys */
+	UPROPERTY(Config)
+	FString GeminiFastModel = TEXT("gemini-1.5-flash");
+
+	/** Times a reply whose DSL fails validation is sent back with the errors for repair */
+	UPROPERTY(Config)
+	int32 MaxDSLCorrectionAttempts = 1;
+
+	/** OpenAI-compatible server, up to and including the API version (llama.cpp, vLLM, Ollama, LM Studio) */
+	UPROPERTY(Config)
+	FString LocalServerURL = TEXT("http://127.0.0.1:8080/v1");
+
+	/** Model named in chat requests to the OpenAI-compatible server */
+	UPROPERTY(Config)
+	FString LocalChatModel = TEXT("local-model");
+
+	/** Model named in chat requests routed to the fast tier; the same as LocalChatModel if the server runs one */
+	UPROPERTY(Config)
+	FString LocalFastChatModel = TEXT("local-model");
+
+	/** Model named in image requests to the OpenAI-compatible server */
+	UPROPERTY(Config)
+	FString LocalImageModel = TEXT("local-image-model");
+
+	/** Bearer token for the OpenAI-compatible server; most local servers need none */
+	UPROPERTY(Config)
+	FString LocalServerAPIKey;
+
 	/** Config file name */
 	static const FString ConfigSectionName;
 	static const FString ConfigFileName;
@@ -0,0 +1,137 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/GeminiAPIClient.h"
+
+/**
+ * Limits for the history sent with a chat request
+ */
+struct FConversationContextOptions
+{
+	/** Estimated tokens the history may use, summary included */
+	int32 TokenBudget = 12000;
+
+	/** Most recent messages that are always sent verbatim, even past the budget */
+	int32 MinRecentMessages = 6;
+
+	/** Estimated tokens the summary of older messages may use */
+	int32 MaxSummaryTokens = 1000;
+
+	/** Options configured in UAINiagaraSettings */
+	static FConversationContextOptions FromSettings();
+};
+
+/**
+ * What the builder did to one history
+ */
+struct FConversationContextStats
+{
+	/** Messages in the full history */
+	int32 NumMessages = 0;
+
+	/** Messages sent verbatim, pinned DSL replies included */
+	int32 NumKeptMessages = 0;
+
+	/** Older system, DSL and patch messages kept verbatim outside the recent window */
+	int32 NumPinnedMessages = 0;
+
+	/** Messages collapsed into the summary */
+	int32 NumSummarizedMessages = 0;
+
+	/** Estimated tokens of the full history */
+	int32 FullTokens = 0;
+
+	/** Estimated tokens of the history that is sent */
+	int32 ContextTokens = 0;
+
+	int32 GetTokensSaved() const { return FMath::Max(0, FullTokens - ContextTokens); }
+};
+
+/**
+ * Fits a conversation history into a token budget.
+ *
+ * Histories within the budget are sent as they are. Longer ones keep the most
+ * recent messages verbatim, together with any system message, the latest reply
+ * that held a valid DSL and the patch replies after it, so the model still sees
+ * its instructions and the effect it is editing. Everything older is collapsed into one summary message at the front.
+ *
+ * Each message is classified and summarized once per asset and cached, so a turn
+ * only processes the messages added since the previous one. Token counts are
+ * estimates (about four characters per token). Used on the game thread.
+ */
+class AINIAGARA_API FConversationContextBuilder
+{
+public:
+	/** Builder shared by all chat widgets */
+	static FConversationContextBuilder& Get();
+
+	/** Estimated tokens of a text */
+	static int32 EstimateTokens(const FString& Text);
+
+	/** Estimated tokens of a message, including its role and framing */
+	static int32 EstimateTokens(const FConversationMessage& Message);
+
+	/**
+	 * Build the history to send for an asset
+	 * @param AssetPath Asset the history belongs to; the summary cache is kept per asset
+	 * @param History Full conversation history, oldest first
+	 * @param Options Token budget and window
+	 * @param OutContext Receives the messages to send
+	 * @param OutStats Receives what was kept, pinned and summarized
+	 */
+	void Build(
+		const FString& AssetPath,
+		const TArray<FConversationMessage>& History,
+		const FConversationContextOptions& Options,
+		TArray<FConversationMessage>& OutContext,
+		FConversationContextStats& OutStats
+	);
+
+	/** Forget the cached summaries of one asset */
+	void Invalidate(const FString& AssetPath);
+
+	/** Forget all cached summaries */
+	void Reset();
+
+	/** Messages classified since the last reset (tests use it to check the cache) */
+	int32 GetNumClassifiedMessages() const { return NumClassifiedMessages; }
+
+private:
+	/** What is cached about the history of one asset */
+	struct FAssetState
+	{
+		/** One summary line per message, oldest first; also the number of messages processed */
+		TArray<FString> SummaryLines;
+
+		/** Estimated tokens per processed message */
+		TArray<int32> Tokens;
+
+		/** Latest reply holding a valid DSL, INDEX_NONE if none */
+		int32 LatestDSLIndex = INDEX_NONE;
+
+		/** Patch replies after LatestDSLIndex */
+		TArray<int32> PatchIndices;
+
+		/** System messages, which are never summarized */
+		TArray<int32> SystemIndices;
+
+		/** Identity of the first and last processed messages, to notice a cleared or replaced history */
+		FDateTime FirstTimestamp;
+		FDateTime LastTimestamp;
+		int32 LastLength = 0;
+	};
+
+	/** Drop the cache if History is not a continuation of what was processed */
+	static void ValidateState(FAssetState& State, const TArray<FConversationMessage>& History);
+
+	/** Classify and summarize the messages added since the last call */
+	void ProcessNewMessages(FAssetState& State, const TArray<FConversationMessage>& History);
+
+	/** One summary line for a message, and whether it is a valid DSL or a patch */
+	static FString SummarizeMessage(const FConversationMessage& Message, bool& bOutIsDSL, bool& bOutIsPatch);
+
+	TMap<FString, FAssetState> AssetStates;
+	int32 NumClassifiedMessages = 0;
+};
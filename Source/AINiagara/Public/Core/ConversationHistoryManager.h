@@ -31,6 +31,13 @@ public:
 	 */
 	TArray<FConversationMessage> GetHistory(const FString& AssetPath) const;
 
+	/**
+	 * Find conversation history for a specific asset without copying it
+	 * @param AssetPath Path to the asset
+	 * @return Messages of the asset, or nullptr if it has none; invalidated by the next change to the history
+	 */
+	const TArray<FConversationMessage>* FindHistory(const FString& AssetPath) const;
+
 	/**
 	 * Add a message to the conversation history
 	 * @param AssetPath Path to the asset
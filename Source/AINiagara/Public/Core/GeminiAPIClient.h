@@ -3,81 +3,89 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Containers/Array.h"
-#include "Containers/Map.h"
-#include "UObject/ObjectMacros.h"
 #include "Interfaces/IHttpRequest.h"
-#include "GeminiAPIClient.generated.h"
-
-DECLARE_DELEGATE_OneParam(FOnGeminiResponse, const FString& ResponseText);
-DECLARE_DELEGATE_TwoParams(FOnGeminiError, int32 ErrorCode, const FString& ErrorMessage);
+#include "Core/LLMBackend.h"
+#include "Core/GeminiRequestHandle.h"
+#include "Core/GeminiRequestScheduler.h"
+#include "Core/GeminiMetrics.h"
 
 /**
- * Message structure for conversation history
+ * Parsed generateContent reply: the first candidate, its finish state and the token usage
  */
-USTRUCT()
-struct FConversationMessage
+struct FGeminiResponse
 {
-	GENERATED_BODY()
+	/** Text parts of the first candidate, concatenated in order */
+	FString Text;
 
-	/** Message role: "user" or "assistant" */
-	UPROPERTY()
-	FString Role;
+	/** Each text part of the first candidate */
+	TArray<FString> TextParts;
 
-	/** Message content */
-	UPROPERTY()
-	FString Content;
+	/** functionCall parts of the first candidate, each serialized as {"functionCall":{...}} */
+	TArray<FString> FunctionCalls;
 
-	/** Timestamp of the message */
-	UPROPERTY()
-	FDateTime Timestamp;
+	/** Candidates in the reply */
+	int32 NumCandidates = 0;
 
-	FConversationMessage()
-		: Role(TEXT("user"))
-		, Timestamp(FDateTime::Now())
-	{
-	}
+	/** Response text of each candidate, in order, as GetResponseText gives it for the first */
+	TArray<FString> Candidates;
 
-	FConversationMessage(const FString& InRole, const FString& InContent)
-		: Role(InRole)
-		, Content(InContent)
-		, Timestamp(FDateTime::Now())
-	{
-	}
-};
+	/** finishReason of the first candidate (STOP, MAX_TOKENS, SAFETY, ...) */
+	FString FinishReason;
 
-/**
- * Tool function definition for LLM function calling
- */
-USTRUCT()
-struct FVFXToolFunction
-{
-	GENERATED_BODY()
+	/** promptFeedback.blockReason, empty unless the prompt itself was blocked */
+	FString BlockReason;
 
-	/** Tool function name (e.g., "tool:texture") */
-	UPROPERTY()
-	FString Name;
+	/** Safety categories rated as blocked, from the candidate or the prompt feedback */
+	TArray<FString> BlockedCategories;
 
-	/** Tool function description */
-	UPROPERTY()
-	FString Description;
+	/** usageMetadata token counts */
+	int32 PromptTokens = 0;
+	int32 OutputTokens = 0;
+	int32 CachedTokens = 0;
+	int32 TotalTokens = 0;
+
+	/** Whether the prompt was blocked, or content filters withheld the whole reply */
+	bool IsBlocked() const;
+
+	/** Text handed to OnResponse: the text parts, or the first function call when there is no text */
+	FString GetResponseText() const
+	{
+		return (Text.IsEmpty() && FunctionCalls.Num() > 0) ? FunctionCalls[0] : Text;
+	}
 
-	/** Tool function parameters schema */
-	UPROPERTY()
-	TMap<FString, FString> Parameters;
+	/** Error message describing why the reply was blocked */
+	FString DescribeBlock() const;
 };
 
 /**
  * Gemini API client for making requests to Google Gemini API
  */
-class AINIAGARA_API FGeminiAPIClient
+class AINIAGARA_API FGeminiAPIClient : public ILLMBackend
 {
 public:
 	/** Constructor */
 	FGeminiAPIClient();
 
 	/** Destructor */
-	~FGeminiAPIClient();
+	virtual ~FGeminiAPIClient();
+
+	/**
+	 * Get a name for logs and the metrics output
+	 * @return "Gemini" and the chat model
+	 */
+	virtual FString GetName() const override;
+
+	/**
+	 * Set the model chat requests go to
+	 * @param InModel Model name (e.g. "gemini-1.5-flash"), with or without the "models/" prefix; empty restores the default
+	 */
+	void SetChatModel(const FString& InModel);
+
+	/**
+	 * Get the model chat requests go to
+	 * @return Model name without the "models/" prefix
+	 */
+	const FString& GetChatModel() const { return ChatModel; }
 
 	/**
 	 * Set the API key for authentication
@@ -102,8 +110,9 @@ public:
 	 * @param InAPIKey The API key to test
 	 * @param OnResponse Callback when test succeeds
 	 * @param OnError Callback when test fails
+	 * @return Handle to cancel the test request
 	 */
-	void TestAPIKey(
+	FGeminiRequestHandle TestAPIKey(
 		const FString& InAPIKey,
 		FOnGeminiResponse OnResponse,
 		FOnGeminiError OnError
@@ -116,14 +125,63 @@ public:
 	 * @param AvailableTools List of available tool functions
 	 * @param OnResponse Callback when request succeeds
 	 * @param OnError Callback when request fails
+	 * @param Options Scheduling, retry and caching options
+	 * @return Handle to cancel the request; the request does not depend on the client staying alive
 	 */
-	void SendChatCompletion(
+	virtual FGeminiRequestHandle SendChatCompletion(
 		const FString& Prompt,
 		const TArray<FConversationMessage>& ConversationHistory,
 		const TArray<FVFXToolFunction>& AvailableTools,
 		FOnGeminiResponse OnResponse,
-		FOnGeminiError OnError
-	);
+		FOnGeminiError OnError,
+		const FGeminiRequestOptions& Options = FGeminiRequestOptions()
+	) override;
+
+	/**
+	 * Send a chat completion request to streamGenerateContent and report the reply as it arrives
+	 * @param Prompt The user's prompt
+	 * @param ConversationHistory Previous messages in the conversation
+	 * @param AvailableTools List of available tool functions
+	 * @param OnChunk Called on the game thread for every text chunk, in order
+	 * @param OnResponse Called with the complete text once the stream ends
+	 * @param OnError Callback when request fails
+	 * @param Options Scheduling, retry and caching options; with CandidateCount above 1 the reply
+	 *        is not streamed, and OnChunk receives the chosen candidate as a single chunk
+	 * @return Handle to cancel the request; no further chunks arrive once it is cancelled
+	 */
+	virtual FGeminiRequestHandle StreamChatCompletion(
+		const FString& Prompt,
+		const TArray<FConversationMessage>& ConversationHistory,
+		const TArray<FVFXToolFunction>& AvailableTools,
+		FOnGeminiStreamChunk OnChunk,
+		FOnGeminiResponse OnResponse,
+		FOnGeminiError OnError,
+		const FGeminiRequestOptions& Options = FGeminiRequestOptions()
+	) override;
+
+	/**
+	 * Override the service URL, e.g. to point at a local stand-in server
+	 * @param InBaseURL URL that endpoints are appended to (e.g. "http://127.0.0.1:8080/v1beta"), empty restores the default
+	 */
+	void SetBaseURL(const FString& InBaseURL);
+
+	/**
+	 * Get the service URL requests are sent to
+	 * @return Base URL override, or the Gemini API URL
+	 */
+	const FString& GetBaseURL() const;
+
+	/**
+	 * Keep the system prompt and tool declarations of chat requests in provider-side cached content
+	 * @param InTTLSeconds Lifetime of the cached content, 0 to always send them inline
+	 */
+	void SetContextCacheTTL(int32 InTTLSeconds);
+
+	/**
+	 * Get the lifetime of the cached context
+	 * @return Seconds, 0 if chat requests are always sent inline
+	 */
+	int32 GetContextCacheTTL() const { return ContextCacheTTLSeconds; }
 
 	/**
 	 * Send a request to generate texture using Imagen 3
@@ -132,15 +190,55 @@ public:
 	 * @param Resolution Texture resolution
 	 * @param OnResponse Callback with generated image data
 	 * @param OnError Callback when request fails
+	 * @param Options Scheduling, retry and caching options
+	 * @return Handle to cancel the request
 	 */
-	void GenerateTexture(
+	FGeminiRequestHandle GenerateTexture(
 		const FString& Prompt,
 		const FString& TextureType,
 		int32 Resolution,
 		FOnGeminiResponse OnResponse,
-		FOnGeminiError OnError
+		FOnGeminiError OnError,
+		const FGeminiRequestOptions& Options = FGeminiRequestOptions(EGeminiRequestPriority::Tool)
 	);
 
+	/**
+	 * Send a request to generate texture using Imagen 3 and hand over the reply bytes as received.
+	 * The body is neither converted to FString nor parsed, so a caller that only needs the
+	 * image can locate and decode it without copying the megabytes of base64 around it.
+	 * @param Prompt Description of the texture to generate
+	 * @param TextureType Type of texture (noise, fire, smoke, sparks, distortion)
+	 * @param Resolution Texture resolution
+	 * @param OnContent Called on a worker thread with the reply body; it must be thread-safe
+	 * @param OnError Callback on the game thread when request fails
+	 * @param Options Scheduling, retry and caching options
+	 * @return Handle to cancel the request
+	 */
+	virtual FGeminiRequestHandle GenerateTextureContent(
+		const FString& Prompt,
+		const FString& TextureType,
+		int32 Resolution,
+		FOnGeminiContent OnContent,
+		FOnGeminiError OnError,
+		const FGeminiRequestOptions& Options = FGeminiRequestOptions(EGeminiRequestPriority::Tool)
+	) override;
+
+	/**
+	 * Parse a generateContent reply
+	 * @param ResponseBody Response body JSON string
+	 * @param OutResponse Text, function calls, finish state and token usage of the reply
+	 * @return True if the body is a generateContent reply with a candidate or prompt feedback
+	 */
+	static bool ParseResponse(const FString& ResponseBody, FGeminiResponse& OutResponse);
+
+	/**
+	 * Pick the candidate of a reply to deliver
+	 * @param Response Parsed reply
+	 * @param AcceptCandidate Run on the text of every candidate, in parallel
+	 * @return Index into Response.Candidates of the first accepted candidate, INDEX_NONE if none is
+	 */
+	static int32 SelectCandidate(const FGeminiResponse& Response, const TFunction<bool(const FString&)>& AcceptCandidate);
+
 private:
 	/** API key for authentication */
 	FString APIKey;
@@ -148,17 +246,29 @@ private:
 	/** Base URL for Gemini API */
 	static const FString BaseURL;
 
-	/** Model endpoint for chat completion */
-	static const FString ChatCompletionEndpoint;
+	/** Base URL override, empty for BaseURL */
+	FString BaseURLOverride;
+
+	/** Lifetime of the cached context, 0 to send chat requests inline */
+	int32 ContextCacheTTLSeconds = 0;
 
-	/** Model endpoint for image generation */
-	static const FString ImageGenerationEndpoint;
+	/** Model of chat requests, without the "models/" prefix */
+	FString ChatModel;
 
-	/** Maximum number of retry attempts */
-	static const int32 MaxRetries;
+	/** Model of chat requests when none is configured */
+	static const FString DefaultChatModel;
 
-	/** Initial retry delay in seconds */
-	static const float InitialRetryDelay;
+	/** Model of image requests; the endpoint and the metrics are named after it */
+	static const FString ImageModel;
+
+	/** Model endpoint for chat completion (e.g. "/models/gemini-pro:generateContent") */
+	FString GetChatCompletionEndpoint() const;
+
+	/** Model endpoint for streamed chat completion */
+	FString GetStreamChatCompletionEndpoint() const;
+
+	/** Model endpoint for image generation on ImageModel */
+	static FString GetImageGenerationEndpoint();
 
 	/**
 	 * Build the request payload for chat completion
@@ -173,6 +283,17 @@ private:
 		const TArray<FVFXToolFunction>& AvailableTools
 	) const;
 
+	/**
+	 * Get the cached content to refer to instead of the system prompt and tools
+	 * @param ConversationHistory Conversation history
+	 * @param AvailableTools Available tool functions
+	 * @return Cached content name, or empty to send the request inline
+	 */
+	FString AcquireCachedContext(
+		const TArray<FConversationMessage>& ConversationHistory,
+		const TArray<FVFXToolFunction>& AvailableTools
+	) const;
+
 	/**
 	 * Build the request payload for texture generation
 	 * @param Prompt Texture description
@@ -187,61 +308,33 @@ private:
 	) const;
 
 	/**
-	 * Parse response from Gemini API
-	 * @param ResponseBody Response body JSON string
-	 * @param OutResponseText Parsed response text
-	 * @return True if parsing succeeded
+	 * Complete the metrics of a finished request from its parsed reply and record them
+	 * @param Metrics Timings and sizes of the request
+	 * @param Response Parsed reply, or nullptr if there was none
 	 */
-	bool ParseResponse(const FString& ResponseBody, FString& OutResponseText) const;
+	static void RecordMetrics(FGeminiRequestMetrics Metrics, const FGeminiResponse* Response);
 
 	/**
-	 * Handle HTTP request completion
+	 * Handle HTTP request completion. The reply is parsed, cached and recorded on a
+	 * UE::Tasks worker; only the delegate call is marshalled to the game thread.
 	 * @param Request The HTTP request
 	 * @param Response The HTTP response
 	 * @param bWasSuccessful Whether the request was successful
 	 * @param OnResponse Success callback
 	 * @param OnError Error callback
+	 * @param Metrics Timings and sizes of the request, recorded with its token usage
+	 * @param CacheKey Response cache key a successfully parsed reply is stored under, empty to not store it
+	 * @param AcceptCandidate Picks among several candidates, see FGeminiRequestOptions
 	 */
-	void HandleRequestComplete(
+	static void HandleRequestComplete(
 		FHttpRequestPtr Request,
 		FHttpResponsePtr Response,
 		bool bWasSuccessful,
 		FOnGeminiResponse OnResponse,
-		FOnGeminiError OnError
-	);
-
-	/**
-	 * Handle HTTP request completion on game thread
-	 * @param bWasSuccessful Whether the request was successful
-	 * @param bResponseValid Whether the response is valid
-	 * @param ResponseCode HTTP response code
-	 * @param ResponseBody Response body text
-	 * @param OnResponse Response delegate
-	 * @param OnError Error delegate
-	 */
-	void HandleRequestCompleteOnGameThread(
-		bool bWasSuccessful,
-		bool bResponseValid,
-		int32 ResponseCode,
-		const FString& ResponseBody,
-		FOnGeminiResponse OnResponse,
-		FOnGeminiError OnError
-	);
-
-	/**
-	 * Retry a failed request with exponential backoff
-	 * @param URL Request URL
-	 * @param Payload Request payload
-	 * @param RetryCount Current retry count
-	 * @param OnResponse Success callback
-	 * @param OnError Error callback
-	 */
-	void RetryRequest(
-		const FString& URL,
-		const FString& Payload,
-		int32 RetryCount,
-		FOnGeminiResponse OnResponse,
-		FOnGeminiError OnError
+		FOnGeminiError OnError,
+		const FGeminiRequestMetrics& Metrics,
+		const FString& CacheKey = FString(),
+		const TFunction<bool(const FString&)>& AcceptCandidate = nullptr
 	);
 };
 
@@ -0,0 +1,113 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Core/GeminiAPIClient.h"
+
+/**
+ * Counters of the context cache
+ */
+struct FGeminiContextCacheStats
+{
+	/** Chat requests that referred to cached content */
+	int32 NumHits = 0;
+
+	/** Chat requests sent inline because no cached content was ready */
+	int32 NumMisses = 0;
+
+	/** Cached contents created, and creations that failed */
+	int32 NumCreated = 0;
+	int32 NumCreateFailures = 0;
+
+	/** Cached contents that reached their expiry time and were recreated */
+	int32 NumExpired = 0;
+
+	/** Cached contents the provider no longer knew; their requests were sent again inline */
+	int32 NumRejected = 0;
+};
+
+/**
+ * Provider-side cached content for the fixed part of chat requests.
+ *
+ * The system prompt and the tool declarations are the same on every turn, so they
+ * are uploaded once to the cachedContents endpoint and chat requests refer to the
+ * returned name instead of carrying them. Acquire starts creating the content the
+ * first time a fixed part is seen and hands out its name once it is ready; until
+ * then, and whenever creation fails, requests are sent inline. Content is recreated
+ * shortly before its expiry time, or right away when the provider rejects a name.
+ *
+ * Entries are keyed by service URL, API key and the creation body, so a changed
+ * system prompt or tool list gets its own cached content. Thread-safe.
+ */
+class AINIAGARA_API FGeminiContextCache
+{
+public:
+	FGeminiContextCache();
+
+	/** Cache shared by all clients */
+	static FGeminiContextCache& Get();
+
+	/**
+	 * Name of the cached content for the fixed part of a chat request, creating it if needed
+	 * @param BaseURL Service URL the content is created on
+	 * @param APIKey Key the content is created with
+	 * @param Model Model the content is cached for (e.g. "models/gemini-pro")
+	 * @param ConversationHistory Conversation history; only its system messages are cached
+	 * @param AvailableTools Tool functions
+	 * @param TTLSeconds Lifetime of newly created content
+	 * @return Name to refer to ("cachedContents/..."), or empty to send the request inline
+	 */
+	FString Acquire(
+		const FString& BaseURL,
+		const FString& APIKey,
+		const FString& Model,
+		const TArray<FConversationMessage>& ConversationHistory,
+		const TArray<FVFXToolFunction>& AvailableTools,
+		int32 TTLSeconds
+	);
+
+	/** Forget cached content the provider rejected, so the next request recreates it */
+	void Invalidate(const FString& Name);
+
+	/** Whether an error reply means the referenced cached content is expired or unknown */
+	static bool IsCachedContentError(int32 ResponseCode, const FString& ResponseBody);
+
+	FGeminiContextCacheStats GetStats() const;
+
+	/** Forget all cached contents and reset the counters; creations in flight are ignored */
+	void Reset();
+
+private:
+	struct FEntry
+	{
+		/** Name of the ready content, empty if there is none */
+		FString Name;
+
+		/** Time after which Name is no longer handed out */
+		FDateTime ExpireTime;
+
+		/** Creation in flight */
+		bool bCreating = false;
+
+		/** Earliest time to try again after a failed creation */
+		FDateTime RetryTime;
+	};
+
+	/** Shared with creation callbacks, which may outlive the cache */
+	struct FState
+	{
+		mutable FCriticalSection Mutex;
+		TMap<FString, FEntry> Entries;
+		FGeminiContextCacheStats Stats;
+	};
+
+	/** Send the creation request for Key */
+	void Create(const FString& Key, const FString& URL, const FString& Body, int32 TTLSeconds);
+
+	/** Record the outcome of a creation request; may run on the HTTP thread */
+	static void OnCreated(FState& CacheState, const FString& Key, int32 TTLSeconds, int32 ResponseCode, const FString& ResponseBody);
+
+	TSharedRef<FState, ESPMode::ThreadSafe> State;
+};
@@ -0,0 +1,190 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+/**
+ * Timing, size and token usage of one logical Gemini request, retries included
+ */
+struct FGeminiRequestMetrics
+{
+	/** Endpoint path the request went to (e.g. "/models/gemini-pro:generateContent") */
+	FString Endpoint;
+
+	/** Model that answered (e.g. "gemini-1.5-flash"), empty if unknown */
+	FString Model;
+
+	/** UTC time the outcome was known */
+	FDateTime Timestamp;
+
+	/** HTTP status of the final attempt, 0 if no response was received */
+	int32 ResponseCode = 0;
+
+	/** Attempts sent, 0 if answered from the response cache */
+	int32 NumAttempts = 0;
+
+	/** Answered from the response cache without reaching the network */
+	bool bFromCache = false;
+
+	/** Referred to provider-side cached context instead of sending it inline */
+	bool bCachedContext = false;
+
+	/** Seconds spent waiting for a scheduler slot, over all attempts */
+	double QueueSeconds = 0.0;
+
+	/**
+	 * Seconds from sending the final attempt to its first response byte. The HTTP
+	 * module does not report DNS and connect times, so they are included here.
+	 */
+	double TimeToFirstByteSeconds = 0.0;
+
+	/** Seconds from the call to the outcome, including queueing and retry delays */
+	double TotalSeconds = 0.0;
+
+	/** Body bytes of the final attempt */
+	int64 RequestBytes = 0;
+	int64 ResponseBytes = 0;
+
+	/** Tokens reported in usageMetadata; 0 when the reply carried none */
+	int32 PromptTokens = 0;
+	int32 OutputTokens = 0;
+	int32 CachedTokens = 0;
+	int32 TotalTokens = 0;
+
+	/** finishReason of the first candidate, or the prompt's blockReason */
+	FString FinishReason;
+
+	bool IsError() const { return ResponseCode != 200; }
+};
+
+/**
+ * Totals of the requests sent to one endpoint or model
+ */
+struct FGeminiEndpointTotals
+{
+	int32 NumRequests = 0;
+	int32 NumErrors = 0;
+	int32 NumFromCache = 0;
+	int32 NumRetries = 0;
+
+	int64 RequestBytes = 0;
+	int64 ResponseBytes = 0;
+
+	int64 PromptTokens = 0;
+	int64 OutputTokens = 0;
+	int64 CachedTokens = 0;
+
+	double QueueSeconds = 0.0;
+	double TimeToFirstByteSeconds = 0.0;
+	double TotalSeconds = 0.0;
+
+	/** Longest request */
+	double MaxTotalSeconds = 0.0;
+
+	void Add(const FGeminiRequestMetrics& Metrics);
+};
+
+/**
+ * Outcomes of hedged requests (see FGeminiHedgePolicy)
+ */
+struct FGeminiHedgeStats
+{
+	/** Requests that were slow enough to be sent a second time */
+	int32 NumHedged = 0;
+
+	/** Hedged requests answered by the duplicate */
+	int32 NumDuplicateWins = 0;
+};
+
+/**
+ * In-editor record of where Gemini time and quota go.
+ *
+ * Every finished request is recorded once, with its timings, sizes and token usage.
+ * The newest records are kept in a fixed-size ring for inspection and CSV export;
+ * totals per endpoint and per model cover every request since the last reset.
+ * Model totals show what routing requests to the fast model saves. Thread-safe.
+ */
+class AINIAGARA_API FGeminiMetricsRegistry
+{
+public:
+	/** Records kept for GetRecent and WriteCSV */
+	static constexpr int32 MaxRecords = 1024;
+
+	FGeminiMetricsRegistry();
+
+	/** Registry shared by all clients */
+	static FGeminiMetricsRegistry& Get();
+
+	void Record(const FGeminiRequestMetrics& Metrics);
+
+	/** Kept records, oldest first */
+	TArray<FGeminiRequestMetrics> GetRecent() const;
+
+	/** Totals per endpoint since the last reset */
+	TMap<FString, FGeminiEndpointTotals> GetTotals() const;
+
+	/** Totals per model since the last reset; requests of unknown model are left out */
+	TMap<FString, FGeminiEndpointTotals> GetModelTotals() const;
+
+	/** Totals over every endpoint */
+	FGeminiEndpointTotals GetOverallTotals() const;
+
+	/**
+	 * Total time of the kept successful requests to an endpoint at a percentile, cache hits excluded
+	 * @param Percentile Between 0 and 1 (e.g. 0.95)
+	 * @param MinSamples Requests needed for a result
+	 * @param OutSeconds Receives the latency; unchanged if there are too few requests
+	 * @return True if there were at least MinSamples requests
+	 */
+	bool GetLatencyPercentile(const FString& Endpoint, double Percentile, int32 MinSamples, double& OutSeconds) const;
+
+	/** As GetLatencyPercentile, over the kept requests answered by a model */
+	bool GetModelLatencyPercentile(const FString& Model, double Percentile, int32 MinSamples, double& OutSeconds) const;
+
+	/** Record that a request was sent a second time */
+	void RecordHedge();
+
+	/** Record which copy of a hedged request answered */
+	void RecordHedgeWinner(bool bDuplicateWon);
+
+	FGeminiHedgeStats GetHedgeStats() const;
+
+	/** One line per endpoint and per model with counts, mean latencies, bytes and tokens */
+	FString FormatSummary() const;
+
+	/**
+	 * Write the kept records as CSV, one row per request
+	 * @param Path File to write; its folder is created if needed
+	 * @param OutError Why the file could not be written
+	 * @return True if the file was written
+	 */
+	bool WriteCSV(const FString& Path, FString& OutError) const;
+
+	/** Default CSV location, Saved/AINiagara/Metrics/GeminiMetrics-<time>.csv */
+	static FString GetDefaultCSVPath();
+
+	/** Forget every record and total */
+	void Reset();
+
+	/** Register AINiagara.Metrics stats|reset|csv [path] */
+	static void RegisterConsoleCommands();
+
+private:
+	static void ConsoleCommand_Metrics(const TArray<FString>& Args);
+
+	/** Latency percentile of the kept successful requests that Filter accepts, cache hits excluded */
+	bool GetLatencyPercentileOf(TFunctionRef<bool(const FGeminiRequestMetrics&)> Filter, double Percentile, int32 MinSamples, double& OutSeconds) const;
+
+	mutable FCriticalSection Mutex;
+
+	/** Ring of the newest records; NextRecord is where the next one goes once it is full */
+	TArray<FGeminiRequestMetrics> Records;
+	int32 NextRecord = 0;
+
+	TMap<FString, FGeminiEndpointTotals> Totals;
+	TMap<FString, FGeminiEndpointTotals> ModelTotals;
+
+	FGeminiHedgeStats HedgeStats;
+};
@@ -0,0 +1,139 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Core/GeminiAPIClient.h"
+
+/**
+ * Counters of the fragment cache
+ */
+struct FGeminiPayloadBuilderStats
+{
+	/** Payloads that reused the serialized tool declarations */
+	int32 NumToolHits = 0;
+	int32 NumToolMisses = 0;
+
+	/** System messages that reused their serialized entry */
+	int32 NumSystemHits = 0;
+	int32 NumSystemMisses = 0;
+};
+
+/**
+ * Assembles generateContent request bodies for FGeminiAPIClient.
+ *
+ * The tool declarations and the system prompt are the same on every send, so they
+ * are serialized once and kept as JSON fragments. Each payload then only writes the
+ * history entries and the prompt, streamed straight into the output string with a
+ * condensed TJsonWriter, and appends the cached fragments around them. The result
+ * describes the same JSON as the DOM built by BuildChatCompletionDOM.
+ *
+ * Fragments and payloads are kept as TCHAR text, not UTF-8 bytes: the client still
+ * needs the payload as an FString to key the response cache, append a candidate
+ * count and fall back to the inline body. The body is converted to UTF-8 once per
+ * send by SetContentAsString.
+ *
+ * Thread-safe: the fragment cache is guarded by a lock.
+ */
+class AINIAGARA_API FGeminiPayloadBuilder
+{
+public:
+	/** Builder shared by all clients */
+	static FGeminiPayloadBuilder& Get();
+
+	/**
+	 * Build a chat completion payload
+	 * @param Prompt User prompt, added after the history
+	 * @param ConversationHistory Conversation history
+	 * @param AvailableTools Tool functions; the "tools" member is omitted when empty
+	 * @param OutPayload Receives the JSON body; its allocation is reused
+	 */
+	void BuildChatCompletion(
+		const FString& Prompt,
+		const TArray<FConversationMessage>& ConversationHistory,
+		const TArray<FVFXToolFunction>& AvailableTools,
+		FString& OutPayload
+	);
+
+	/**
+	 * Build a chat completion payload whose fixed part lives in provider-side cached content.
+	 * System messages and tools are left out; the cached content holds them.
+	 * @param CachedContentName Name of the cached content ("cachedContents/...")
+	 * @param Prompt User prompt, added after the history
+	 * @param ConversationHistory Conversation history
+	 * @param OutPayload Receives the JSON body; its allocation is reused
+	 */
+	void BuildChatCompletionWithCachedContent(
+		const FString& CachedContentName,
+		const FString& Prompt,
+		const TArray<FConversationMessage>& ConversationHistory,
+		FString& OutPayload
+	);
+
+	/**
+	 * Build the cachedContents body holding the fixed part of chat requests: the system
+	 * messages, as the system instruction, and the tool declarations
+	 * @param Model Model the content is cached for (e.g. "models/gemini-pro")
+	 * @param ConversationHistory Conversation history; only its system messages are used
+	 * @param AvailableTools Tool functions
+	 * @param TTLSeconds Lifetime of the cached content
+	 * @param OutPayload Receives the JSON body
+	 * @return False if there is nothing to cache (no system message and no tools)
+	 */
+	bool BuildCachedContent(
+		const FString& Model,
+		const TArray<FConversationMessage>& ConversationHistory,
+		const TArray<FVFXToolFunction>& AvailableTools,
+		int32 TTLSeconds,
+		FString& OutPayload
+	);
+
+	/**
+	 * Ask for several candidates by adding a generationConfig to a built payload
+	 * @param CandidateCount Candidates to ask for; nothing is added for 1 or less
+	 * @param InOutPayload Payload from BuildChatCompletion or BuildChatCompletionWithCachedContent
+	 */
+	static void AppendCandidateCount(int32 CandidateCount, FString& InOutPayload);
+
+	/**
+	 * Build the same payload through a JSON DOM, without any caching (reference for tests and benchmarks)
+	 * @return Pretty-printed JSON body
+	 */
+	static FString BuildChatCompletionDOM(
+		const FString& Prompt,
+		const TArray<FConversationMessage>& ConversationHistory,
+		const TArray<FVFXToolFunction>& AvailableTools
+	);
+
+	FGeminiPayloadBuilderStats GetStats() const;
+
+	/** Drop the cached fragments and reset the counters */
+	void Reset();
+
+private:
+	/** Serialized system message entry */
+	struct FSystemFragment
+	{
+		FString Content;
+		FString Json;
+	};
+
+	/** Append the "tools" member for AvailableTools, serializing it only if the tools changed; caller holds Mutex */
+	void AppendToolsFragment(const TArray<FVFXToolFunction>& AvailableTools, FString& OutPayload);
+
+	/** Append a system message entry, serializing it only the first time its text is seen; caller holds Mutex */
+	void AppendSystemFragment(const FConversationMessage& Message, FString& OutPayload);
+
+	mutable FCriticalSection Mutex;
+
+	/** Tools the cached fragment was built from */
+	TArray<FVFXToolFunction> CachedTools;
+	FString ToolsFragment;
+	bool bHasToolsFragment = false;
+
+	/** Most recently used first; only a handful of distinct system prompts are ever in use */
+	TArray<FSystemFragment> SystemFragments;
+
+	FGeminiPayloadBuilderStats Stats;
+};
@@ -0,0 +1,81 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Interfaces/IHttpRequest.h"
+
+/**
+ * Handle to a request sent by FGeminiAPIClient.
+ *
+ * Copies refer to the same request. Cancel drops the request wherever it is: a
+ * queued request never starts, the attempt in flight is aborted, a pending retry
+ * is not sent, and a reply that has arrived but not yet been delivered is
+ * discarded. After Cancel none of the request's delegates run.
+ *
+ * Cancel and the delegates both run on the game thread, so a delegate never runs
+ * once Cancel has returned. A default-constructed handle refers to no request and
+ * ignores Cancel.
+ */
+class AINIAGARA_API FGeminiRequestHandle
+{
+public:
+	FGeminiRequestHandle()
+	{
+	}
+
+	/** New handle for a request about to be sent (used by FGeminiAPIClient) */
+	static FGeminiRequestHandle MakePending();
+
+	/** Whether the handle refers to a request */
+	bool IsValid() const { return State.IsValid(); }
+
+	/** Cancel the request; does nothing once it has finished or was already cancelled */
+	void Cancel();
+
+	bool IsCancelled() const;
+
+	/** Whether the request has neither delivered its outcome nor been cancelled */
+	bool IsPending() const;
+
+	/**
+	 * Cancel another request along with this one, e.g. the copies of a hedged request (used by FGeminiAPIClient)
+	 * @param Linked Request to cancel; cancelled right away if this one is no longer pending
+	 */
+	void LinkRequest(const FGeminiRequestHandle& Linked);
+
+	/** Remember the HTTP request of the current attempt so Cancel can abort it (used by FGeminiAPIClient) */
+	void SetHttpRequest(const FHttpRequestPtr& Request);
+
+	/**
+	 * Mark the outcome as delivered (used by FGeminiAPIClient)
+	 * @return False if the request was cancelled or already finished, in which case the outcome is dropped
+	 */
+	bool TryFinish();
+
+	bool operator==(const FGeminiRequestHandle& Other) const { return State == Other.State; }
+	bool operator!=(const FGeminiRequestHandle& Other) const { return State != Other.State; }
+
+private:
+	enum class EStatus : uint8
+	{
+		Pending,
+		Finished,
+		Cancelled
+	};
+
+	struct FState
+	{
+		mutable FCriticalSection Mutex;
+		EStatus Status = EStatus::Pending;
+
+		/** Attempt in flight, released once the request finishes */
+		FHttpRequestPtr HttpRequest;
+
+		/** Requests cancelled with this one */
+		TArray<FGeminiRequestHandle> LinkedRequests;
+	};
+
+	TSharedPtr<FState, ESPMode::ThreadSafe> State;
+};
@@ -0,0 +1,231 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Core/GeminiRetryPolicy.h"
+
+/**
+ * Request priority; lower values are started first
+ */
+enum class EGeminiRequestPriority : uint8
+{
+	/** Chat turns the artist is waiting on */
+	Interactive,
+
+	/** Shader, material and single texture tool calls */
+	Tool,
+
+	/** Bulk work such as flipbook frames */
+	Background
+};
+
+/**
+ * Model endpoint a request counts against; each has its own limits
+ */
+enum class EGeminiEndpoint : uint8
+{
+	/** generateContent / streamGenerateContent on the chat model */
+	Chat,
+
+	/** Imagen generation */
+	Image,
+
+	Count
+};
+
+/**
+ * Per-request scheduling, retry and caching options for FGeminiAPIClient
+ */
+struct FGeminiRequestOptions
+{
+	/** Queue priority */
+	EGeminiRequestPriority Priority = EGeminiRequestPriority::Interactive;
+
+	/** Backoff for transient failures; each retry is queued again at the same priority */
+	FGeminiRetryPolicy RetryPolicy;
+
+	/** False to skip a cached reply (e.g. to ask for a different answer); the fresh reply still replaces it */
+	bool bReadCache = true;
+
+	/** When to send a duplicate of a slow chat request; disabled by default */
+	FGeminiHedgePolicy Hedge;
+
+	/** Candidates asked for per chat request */
+	int32 CandidateCount = 1;
+
+	/**
+	 * Picks among the candidates of a reply: the first accepted one is delivered, or the
+	 * first candidate if none is. Runs on worker threads, several candidates at once.
+	 */
+	TFunction<bool(const FString& ResponseText)> AcceptCandidate;
+
+	FGeminiRequestOptions()
+	{
+	}
+
+	FGeminiRequestOptions(EGeminiRequestPriority InPriority)
+		: Priority(InPriority)
+	{
+	}
+};
+
+/**
+ * Limits of one endpoint
+ */
+struct FGeminiEndpointLimits
+{
+	/** Maximum requests in flight at once */
+	int32 MaxInFlight = 4;
+
+	/** Token bucket refill rate the limiter starts at and recovers to (requests per second) */
+	double MaxRequestsPerSecond = 2.0;
+
+	/** Floor the refill rate is never halved below */
+	double MinRequestsPerSecond = 0.1;
+
+	/** Bucket capacity: requests that can start back to back */
+	double Burst = 4.0;
+
+	/** Rate added back after each successful request (additive increase) */
+	double RecoveryPerSuccess = 0.1;
+};
+
+/**
+ * Counters for one endpoint
+ */
+struct FGeminiEndpointStats
+{
+	/** Requests waiting to start */
+	int32 QueueDepth = 0;
+
+	/** Requests started and not yet finished */
+	int32 InFlight = 0;
+
+	/** Requests started since the last reset */
+	int32 NumStarted = 0;
+
+	/** Requests that finished with 429 */
+	int32 NumThrottled = 0;
+
+	/** Current token bucket refill rate (requests per second) */
+	double RequestsPerSecond = 0.0;
+
+	/** Queue wait of started requests */
+	double TotalWaitSeconds = 0.0;
+	double MaxWaitSeconds = 0.0;
+
+	/** Average queue wait of started requests */
+	double GetAverageWaitSeconds() const { return NumStarted > 0 ? TotalWaitSeconds / NumStarted : 0.0; }
+};
+
+/**
+ * Central queue for outgoing Gemini requests.
+ *
+ * Every FGeminiAPIClient hands its HTTP requests to the shared scheduler instead
+ * of sending them directly. Per endpoint, a request starts only when the number
+ * in flight is below MaxInFlight and a token bucket has a token; waiting requests
+ * start in priority order, first come first served within a priority. A 429 halves
+ * the refill rate and empties the bucket until Retry-After has passed; each success
+ * adds RecoveryPerSuccess back (AIMD), up to MaxRequestsPerSecond.
+ *
+ * The scheduler lives on the game thread. Requests that cannot start immediately
+ * are retried from a core ticker.
+ */
+class AINIAGARA_API FGeminiRequestScheduler
+{
+public:
+	/** Called when the request may be sent */
+	using FStartRequest = TUniqueFunction<void()>;
+
+	/** Returns true once a queued request no longer needs to be sent */
+	using FIsCancelled = TFunction<bool()>;
+
+	FGeminiRequestScheduler();
+	~FGeminiRequestScheduler();
+
+	/** Scheduler shared by all clients */
+	static FGeminiRequestScheduler& Get();
+
+	/**
+	 * Queue a request; Start runs immediately if the endpoint allows it, otherwise later from the ticker.
+	 * Every started request must be matched by one call to OnRequestFinished.
+	 * @param IsCancelled Optional; a cancelled request is dropped from the queue without taking a slot or a token
+	 */
+	void Enqueue(EGeminiEndpoint Endpoint, EGeminiRequestPriority Priority, FStartRequest Start, FIsCancelled IsCancelled = nullptr);
+
+	/**
+	 * Release the slot of a finished request and adjust the rate
+	 * @param ResponseCode HTTP status, 0 if no response was received
+	 * @param RetryAfterSeconds Server-requested delay for 429/503 replies, 0 if none
+	 */
+	void OnRequestFinished(EGeminiEndpoint Endpoint, int32 ResponseCode, double RetryAfterSeconds = 0.0);
+
+	/** Start every queued request the limits allow */
+	void Pump();
+
+	void SetLimits(EGeminiEndpoint Endpoint, const FGeminiEndpointLimits& Limits);
+	const FGeminiEndpointLimits& GetLimits(EGeminiEndpoint Endpoint) const;
+
+	FGeminiEndpointStats GetStats(EGeminiEndpoint Endpoint) const;
+
+	/** Reset counters and the limiter; queued and in-flight requests are kept */
+	void ResetStats();
+
+	/** Replace the clock (seconds); tests use it to step time */
+	void SetClock(TFunction<double()> InClock);
+
+	/** Disable the ticker so only explicit Pump calls start requests (tests) */
+	void SetAutoPump(bool bInAutoPump);
+
+	/**
+	 * Parse a Retry-After header (delta seconds or HTTP date)
+	 * @return Delay in seconds, 0 if the value is empty or invalid
+	 */
+	static double ParseRetryAfter(const FString& HeaderValue);
+
+private:
+	struct FQueuedRequest
+	{
+		EGeminiRequestPriority Priority;
+		uint64 Sequence;
+		double EnqueueSeconds;
+		FStartRequest Start;
+		FIsCancelled IsCancelled;
+	};
+
+	struct FEndpointState
+	{
+		FGeminiEndpointLimits Limits;
+		FGeminiEndpointStats Stats;
+
+		/** Binary heap ordered by (Priority, Sequence) */
+		TArray<FQueuedRequest> Queue;
+
+		double Tokens = 0.0;
+		double RequestsPerSecond = 0.0;
+		double LastRefillSeconds = 0.0;
+
+		/** No request starts before this time (Retry-After) */
+		double BlockedUntilSeconds = 0.0;
+	};
+
+	/** Drop every cancelled request from the queue */
+	static void DropCancelled(FEndpointState& State);
+
+	/** Add the tokens earned since the last refill */
+	void Refill(FEndpointState& State, double Now) const;
+
+	/** Seconds until the next queued request could start, or a negative value if none is waiting */
+	double GetNextStartDelay(const FEndpointState& State, double Now) const;
+
+	/** Schedule a ticker to pump again once a token is available */
+	void SchedulePump();
+
+	FEndpointState Endpoints[static_cast<int32>(EGeminiEndpoint::Count)];
+	uint64 NextSequence = 0;
+	TFunction<double()> Clock;
+	bool bAutoPump = true;
+	FTSTicker::FDelegateHandle PumpTickerHandle;
+};
@@ -0,0 +1,142 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
+
+/**
+ * How FGeminiAPIClient uses the response cache
+ */
+enum class EGeminiResponseCacheMode : uint8
+{
+	/** Every request goes to the network */
+	Disabled,
+
+	/** Identical requests are answered from disk; successful replies are stored */
+	ReadWrite,
+
+	/** Requests are only answered from disk; a miss fails instead of reaching the network */
+	ReplayOnly
+};
+
+/**
+ * Counters of the response cache
+ */
+struct FGeminiResponseCacheStats
+{
+	int32 NumEntries = 0;
+	int64 TotalBytes = 0;
+	int32 NumHits = 0;
+	int32 NumMisses = 0;
+	int32 NumEvictions = 0;
+};
+
+/**
+ * Content-addressed on-disk cache of successful Gemini replies.
+ *
+ * The key is a SHA-1 of the endpoint and the serialized request payload, so the
+ * same prompt, history, tools and model map to the same file regardless of the
+ * API key. Each entry is one file holding the raw response body under
+ * Saved/AINiagara/ResponseCache. When the total size exceeds the limit, the least
+ * recently used entries are deleted; file timestamps are refreshed on every hit
+ * so the order survives editor restarts.
+ *
+ * Thread-safe: clients check the index when a request is sent, then read the
+ * entry and store replies on worker tasks. Mutex only guards the in-memory
+ * index; files are read, written and deleted outside it. A file deleted by a
+ * concurrent eviction is treated as a miss by Find.
+ */
+class AINIAGARA_API FGeminiResponseCache
+{
+public:
+	/**
+	 * @param InDirectory Folder the entries live in; existing entries are indexed
+	 * @param InMaxBytes Size limit of all entries together
+	 */
+	FGeminiResponseCache(const FString& InDirectory, int64 InMaxBytes);
+
+	/**
+	 * Cache shared by all clients, configured from UAINiagaraSettings.
+	 * The -AINiagaraResponseCache=off|on|replay command line switch overrides the mode.
+	 */
+	static FGeminiResponseCache& Get();
+
+	/** Default location, Saved/AINiagara/ResponseCache */
+	static FString GetDefaultDirectory();
+
+	/**
+	 * Key of a request
+	 * @param Endpoint Model endpoint path, e.g. "/models/gemini-pro:generateContent"
+	 * @param Payload Serialized request body
+	 * @return 40 hex digits
+	 */
+	static FString MakeKey(const FString& Endpoint, const FString& Payload);
+
+	/**
+	 * Whether the index has an entry for a key, without touching the disk; an absent key counts as a miss
+	 * @note The entry can still be evicted before it is read, so Find may fail afterwards
+	 */
+	bool Contains(const FString& Key);
+
+	/**
+	 * Look up a reply and mark it as recently used; the file is read outside the lock
+	 * @return True if OutBody was filled
+	 */
+	bool Find(const FString& Key, FString& OutBody);
+
+	/** Store a reply, evicting least recently used entries if the cache grows past its limit */
+	void Store(const FString& Key, const FString& Body);
+
+	/** Delete every entry */
+	void Clear();
+
+	/** Point the cache at another folder and index it (tests use a transient folder) */
+	void SetDirectory(const FString& InDirectory);
+	const FString& GetDirectory() const { return Directory; }
+
+	void SetMaxBytes(int64 InMaxBytes);
+
+	void SetMode(EGeminiResponseCacheMode InMode);
+	EGeminiResponseCacheMode GetMode() const;
+
+	FGeminiResponseCacheStats GetStats() const;
+
+	/** Parse "off", "on" or "replay" */
+	static bool ParseMode(const FString& Text, EGeminiResponseCacheMode& OutMode);
+	static const TCHAR* LexToString(EGeminiResponseCacheMode InMode);
+
+	/** Register AINiagara.ResponseCache off|on|replay|clear|stats */
+	static void RegisterConsoleCommands();
+
+private:
+	static void ConsoleCommand_ResponseCache(const TArray<FString>& Args);
+
+	struct FEntry
+	{
+		int64 Size = 0;
+
+		/** Larger is more recent */
+		uint64 LastUse = 0;
+	};
+
+	FString GetEntryPath(const FString& Key) const;
+
+	/** Rebuild the index from the files in Directory, oldest timestamp first */
+	void LoadIndex();
+
+	/**
+	 * Drop least recently used entries from the index until the cache fits; caller holds Mutex
+	 * @param OutVictims Receives the paths of the dropped entries, to delete once Mutex is released
+	 */
+	void Evict(TArray<FString>& OutVictims);
+
+	mutable FCriticalSection Mutex;
+	FString Directory;
+	int64 MaxBytes;
+	std::atomic<EGeminiResponseCacheMode> Mode{ EGeminiResponseCacheMode::Disabled };
+	TMap<FString, FEntry> Entries;
+	uint64 NextUse = 0;
+	FGeminiResponseCacheStats Stats;
+};
@@ -0,0 +1,128 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Math/RandomStream.h"
+
+/**
+ * When and how long to wait before re-sending a failed Gemini request.
+ *
+ * Connection failures, 408, 429 and 5xx replies (except 501) are retried with
+ * exponential backoff and full jitter: the delay before retry N is uniform in
+ * [0, min(MaxDelaySeconds, InitialDelaySeconds * Multiplier^N)]. A Retry-After
+ * from the server is a lower bound; if it exceeds MaxDelaySeconds the request
+ * fails instead of waiting.
+ */
+struct AINIAGARA_API FGeminiRetryPolicy
+{
+	/** Attempts including the first; 1 disables retries */
+	int32 MaxAttempts = 3;
+
+	/** Backoff cap before the first retry */
+	double InitialDelaySeconds = 1.0;
+
+	/** Backoff growth per retry */
+	double Multiplier = 2.0;
+
+	/** Longest single wait, including a server-requested one */
+	double MaxDelaySeconds = 20.0;
+
+	/** Longest total wait across all retries of one request */
+	double MaxTotalDelaySeconds = 45.0;
+
+	/** Randomise delays (full jitter) so throttled clients do not retry in lockstep */
+	bool bUseJitter = true;
+
+	/** Policy that never retries */
+	static FGeminiRetryPolicy NoRetry();
+
+	/**
+	 * Whether a failure is transient
+	 * @param ResponseCode HTTP status, ignored if bReceivedResponse is false
+	 * @param bReceivedResponse False for connection failures and timeouts
+	 */
+	static bool IsRetryable(int32 ResponseCode, bool bReceivedResponse);
+
+	/**
+	 * Delay before a retry
+	 * @param RetryIndex 0 for the first retry
+	 * @param RetryAfterSeconds Server-requested delay, 0 if none
+	 * @param Random Jitter source
+	 * @return Seconds to wait, or a negative value if the server asked for more than MaxDelaySeconds
+	 */
+	double GetDelay(int32 RetryIndex, double RetryAfterSeconds, FRandomStream& Random) const;
+};
+
+/**
+ * When to send a duplicate of a slow Gemini request.
+ *
+ * A request that has not replied after the Percentile latency of recent successful
+ * requests to its endpoint is sent a second time; the first reply is used and the
+ * other request is cancelled. Until MinSamples requests have been recorded the
+ * delay is DefaultDelaySeconds. The duplicate costs quota, so hedging is off unless
+ * Percentile is set.
+ */
+struct AINIAGARA_API FGeminiHedgePolicy
+{
+	/** Latency percentile after which the duplicate is sent (e.g. 0.95); 0 disables hedging */
+	double Percentile = 0.0;
+
+	/** Delay while fewer than MinSamples requests have been recorded */
+	double DefaultDelaySeconds = 8.0;
+
+	/** Bounds of the delay, so a few fast or very slow replies do not make it useless */
+	double MinDelaySeconds = 1.0;
+	double MaxDelaySeconds = 30.0;
+
+	/** Recorded requests needed before the percentile is used */
+	int32 MinSamples = 20;
+
+	bool IsEnabled() const { return Percentile > 0.0; }
+
+	/** Policy that hedges at the given percentile */
+	static FGeminiHedgePolicy AtPercentile(double InPercentile);
+
+	/**
+	 * Delay before the duplicate of a request
+	 * @param Endpoint Endpoint path whose recorded latencies are used (see FGeminiMetricsRegistry)
+	 * @return Seconds to wait, or a negative value if hedging is disabled
+	 */
+	double GetDelay(const FString& Endpoint) const;
+};
+
+/**
+ * Process-wide cap on retries, so an outage does not multiply the request rate.
+ *
+ * Every first attempt deposits DepositPerRequest and every retry withdraws one
+ * token; when the balance is below one, failures are reported instead of retried.
+ * With the defaults, sustained retries are limited to about 20% of traffic on top
+ * of an initial allowance of MaxBalance retries.
+ */
+class AINIAGARA_API FGeminiRetryBudget
+{
+public:
+	FGeminiRetryBudget(double InMaxBalance = 10.0, double InDepositPerRequest = 0.2);
+
+	/** Budget shared by all clients */
+	static FGeminiRetryBudget& Get();
+
+	/** Record a first attempt */
+	void OnRequest();
+
+	/** Take one retry from the budget; returns false if none is left */
+	bool TryWithdraw();
+
+	/** Current balance */
+	double GetBalance() const;
+
+	/** Refill to MaxBalance (tests) */
+	void Reset();
+
+private:
+	mutable FCriticalSection Mutex;
+	double MaxBalance;
+	double DepositPerRequest;
+	double Balance;
+};
@@ -0,0 +1,57 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Incremental reader for the server-sent-event body of streamGenerateContent (alt=sse).
+ *
+ * Bytes are appended as they arrive; a multi-byte UTF-8 sequence or a line split
+ * across calls is held until complete. Each event's "data:" lines are joined and
+ * returned once the blank line that ends the event has been received. Comments
+ * and other fields (event, id, retry) are ignored.
+ */
+class AINIAGARA_API FGeminiSSEParser
+{
+public:
+	/**
+	 * Append raw body bytes
+	 * @param Bytes Next piece of the response body
+	 * @param OutEvents Receives the data of every event completed by these bytes
+	 * @return Number of events added to OutEvents
+	 */
+	int32 AppendBytes(TConstArrayView<uint8> Bytes, TArray<FString>& OutEvents);
+
+	/**
+	 * Complete a final event that was not followed by a blank line
+	 * @param OutEvents Receives the data of the pending event, if any
+	 * @return Number of events added to OutEvents
+	 */
+	int32 Flush(TArray<FString>& OutEvents);
+
+	/** Discard buffered bytes and the pending event */
+	void Reset();
+
+	/**
+	 * Extract the generated text from one streamGenerateContent event
+	 * @param EventData JSON data of the event ({ candidates: [{ content: { parts: [{ text }] } }] })
+	 * @param OutText Concatenated text of the first candidate's parts (may be empty)
+	 * @param OutFinishReason finishReason of the first candidate, empty until the last event
+	 * @return False if the data is not a GenerateContentResponse object
+	 */
+	static bool ParseEvent(const FString& EventData, FString& OutText, FString& OutFinishReason);
+
+private:
+	/** Handle one complete line (without its terminator) */
+	void ProcessLine(const ANSICHAR* Line, int32 Length, TArray<FString>& OutEvents);
+
+	/** Bytes of the current, incomplete line */
+	TArray<uint8> LineBuffer;
+
+	/** Joined data lines of the current event */
+	FString EventData;
+
+	/** Whether the current event has at least one data line */
+	bool bHasData = false;
+};
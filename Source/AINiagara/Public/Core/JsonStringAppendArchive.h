@@ -0,0 +1,28 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/Archive.h"
+
+/**
+ * Archive that appends the TCHAR stream produced by TJsonWriter to an existing FString,
+ * so the caller controls (and can reuse) the output allocation.
+ */
+class FJsonStringAppendArchive : public FArchive
+{
+public:
+	explicit FJsonStringAppendArchive(FString& InTarget)
+		: Target(InTarget)
+	{
+		SetIsSaving(true);
+	}
+
+	virtual void Serialize(void* Data, int64 Num) override
+	{
+		Target.AppendChars(static_cast<const TCHAR*>(Data), static_cast<int32>(Num / sizeof(TCHAR)));
+	}
+
+private:
+	FString& Target;
+};
@@ -0,0 +1,228 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Array.h"
+#include "Containers/Map.h"
+#include "UObject/ObjectMacros.h"
+#include "Core/GeminiRequestHandle.h"
+#include "Core/GeminiRequestScheduler.h"
+#include "LLMBackend.generated.h"
+
+DECLARE_DELEGATE_OneParam(FOnGeminiResponse, const FString& ResponseText);
+DECLARE_DELEGATE_TwoParams(FOnGeminiError, int32 ErrorCode, const FString& ErrorMessage);
+
+/**
+ * Progress of a streamed chat completion
+ */
+struct FGeminiStreamStats
+{
+	/** Text chunks received so far */
+	int32 NumChunks = 0;
+
+	/** Response body bytes received so far */
+	int64 ReceivedBytes = 0;
+
+	/** Seconds from sending the request to the first text chunk, negative until it arrives */
+	double FirstChunkSeconds = -1.0;
+
+	/** Seconds from sending the request to the latest chunk */
+	double ElapsedSeconds = 0.0;
+};
+
+DECLARE_DELEGATE_TwoParams(FOnGeminiStreamChunk, const FString& ChunkText, const FGeminiStreamStats& Stats);
+
+/**
+ * Receives the undecoded UTF-8 body of a successful reply on a worker thread.
+ * The view is only valid during the call.
+ */
+using FOnGeminiContent = TFunction<void(TConstArrayView<uint8> Content)>;
+
+/**
+ * Message structure for conversation history
+ */
+USTRUCT()
+struct FConversationMessage
+{
+	GENERATED_BODY()
+
+	/** Message role: "user" or "assistant" */
+	UPROPERTY()
+	FString Role;
+
+	/** Message content */
+	UPROPERTY()
+	FString Content;
+
+	/** Timestamp of the message */
+	UPROPERTY()
+	FDateTime Timestamp;
+
+	FConversationMessage()
+		: Role(TEXT("user"))
+		, Timestamp(FDateTime::Now())
+	{
+	}
+
+	FConversationMessage(const FString& InRole, const FString& InContent)
+		: Role(InRole)
+		, Content(InContent)
+		, Timestamp(FDateTime::Now())
+	{
+	}
+};
+
+/**
+ * Tool function definition for LLM function calling
+ */
+USTRUCT()
+struct FVFXToolFunction
+{
+	GENERATED_BODY()
+
+	/** Tool function name (e.g., "tool:texture") */
+	UPROPERTY()
+	FString Name;
+
+	/** Tool function description */
+	UPROPERTY()
+	FString Description;
+
+	/** Tool function parameters schema */
+	UPROPERTY()
+	TMap<FString, FString> Parameters;
+};
+
+/**
+ * Service a kind of request is sent to
+ */
+UENUM(BlueprintType)
+enum class ELLMBackendType : uint8
+{
+	/** Google Gemini and Imagen */
+	Gemini UMETA(DisplayName = "Gemini"),
+
+	/** A server speaking the OpenAI chat completions and images API, e.g. a local llama.cpp, vLLM or Ollama */
+	OpenAICompatible UMETA(DisplayName = "OpenAI-compatible server")
+};
+
+/**
+ * Kinds of request whose backend is chosen separately
+ */
+UENUM(BlueprintType)
+enum class ELLMTask : uint8
+{
+	/** Effect design in the chat window */
+	Chat UMETA(DisplayName = "Chat"),
+
+	/** HLSL generation for tool:shader */
+	Shader UMETA(DisplayName = "Shader"),
+
+	/** Image generation for tool:texture */
+	Texture UMETA(DisplayName = "Texture"),
+
+	/** Repair of a DSL reply that failed validation; sent to the chat backend */
+	Correction UMETA(DisplayName = "DSL Correction")
+};
+
+/**
+ * Size of model a kind of request is routed to
+ */
+UENUM(BlueprintType)
+enum class ELLMModelTier : uint8
+{
+	/** The most capable model, for designing effects from scratch */
+	Large UMETA(DisplayName = "Large"),
+
+	/** A small, fast and cheap model, for repairs and short structured replies */
+	Fast UMETA(DisplayName = "Fast")
+};
+
+/**
+ * A language model service: chat, streamed chat with tool calls, and image generation.
+ *
+ * Every implementation reports the same way, so callers do not know which service
+ * answered: delegates run on the game thread (OnContent on a worker), a tool call
+ * arrives as {"functionCall":{"name":...,"args":{...}}} text, and a request does not
+ * depend on the backend object staying alive. Create picks the implementation the
+ * settings select for a task.
+ */
+class AINIAGARA_API ILLMBackend
+{
+public:
+	virtual ~ILLMBackend() = default;
+
+	/**
+	 * Create the backend the settings select for a kind of request, set to the model its tier routes it to
+	 * @param Task Kind of request the backend is used for
+	 * @return New backend, configured from the settings
+	 */
+	static TSharedRef<ILLMBackend, ESPMode::ThreadSafe> Create(ELLMTask Task);
+
+	/**
+	 * Get a name for logs and the metrics output
+	 * @return Service and model description (e.g. "Gemini", "OpenAI-compatible qwen2.5 at http://127.0.0.1:8080/v1")
+	 */
+	virtual FString GetName() const = 0;
+
+	/**
+	 * Send a chat completion request
+	 * @param Prompt The user's prompt
+	 * @param ConversationHistory Previous messages in the conversation
+	 * @param AvailableTools List of available tool functions
+	 * @param OnResponse Callback when request succeeds
+	 * @param OnError Callback when request fails
+	 * @param Options Scheduling, retry and caching options; a backend ignores those it does not support
+	 * @return Handle to cancel the request
+	 */
+	virtual FGeminiRequestHandle SendChatCompletion(
+		const FString& Prompt,
+		const TArray<FConversationMessage>& ConversationHistory,
+		const TArray<FVFXToolFunction>& AvailableTools,
+		FOnGeminiResponse OnResponse,
+		FOnGeminiError OnError,
+		const FGeminiRequestOptions& Options = FGeminiRequestOptions()
+	) = 0;
+
+	/**
+	 * Send a chat completion request and report the reply as it arrives
+	 * @param Prompt The user's prompt
+	 * @param ConversationHistory Previous messages in the conversation
+	 * @param AvailableTools List of available tool functions
+	 * @param OnChunk Called on the game thread for every text chunk, in order
+	 * @param OnResponse Called with the complete text once the stream ends
+	 * @param OnError Callback when request fails
+	 * @param Options Scheduling, retry and caching options; a backend ignores those it does not support
+	 * @return Handle to cancel the request; no further chunks arrive once it is cancelled
+	 */
+	virtual FGeminiRequestHandle StreamChatCompletion(
+		const FString& Prompt,
+		const TArray<FConversationMessage>& ConversationHistory,
+		const TArray<FVFXToolFunction>& AvailableTools,
+		FOnGeminiStreamChunk OnChunk,
+		FOnGeminiResponse OnResponse,
+		FOnGeminiError OnError,
+		const FGeminiRequestOptions& Options = FGeminiRequestOptions()
+	) = 0;
+
+	/**
+	 * Generate a texture and hand over the reply bytes as received; UTextureGenerationHandler
+	 * finds the base64 image in them
+	 * @param Prompt Description of the texture to generate
+	 * @param TextureType Type of texture (noise, fire, smoke, sparks, distortion)
+	 * @param Resolution Texture resolution
+	 * @param OnContent Called on a worker thread with the reply body; it must be thread-safe
+	 * @param OnError Callback on the game thread when request fails
+	 * @param Options Scheduling, retry and caching options; a backend ignores those it does not support
+	 * @return Handle to cancel the request
+	 */
+	virtual FGeminiRequestHandle GenerateTextureContent(
+		const FString& Prompt,
+		const FString& TextureType,
+		int32 Resolution,
+		FOnGeminiContent OnContent,
+		FOnGeminiError OnError,
+		const FGeminiRequestOptions& Options = FGeminiRequestOptions(EGeminiRequestPriority::Tool)
+	) = 0;
+};
@@ -0,0 +1,173 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/LLMBackend.h"
+#include "Core/GeminiAPIClient.h"
+
+/**
+ * Client for a server speaking the OpenAI chat completions and images API.
+ *
+ * Meant for a model served on the local machine or network (llama.cpp server, vLLM,
+ * Ollama, LM Studio), so requests skip the Gemini scheduler, retry policy and
+ * response cache: there is no quota to protect, and a local failure is better
+ * reported at once. Tool declarations are sent as "tools" of type "function", and
+ * a tool call in the reply is handed on in the {"functionCall":{...}} form Gemini
+ * uses, so FVFXResponseDispatcher handles both alike.
+ */
+class AINIAGARA_API FOpenAICompatibleClient : public ILLMBackend
+{
+public:
+	/** Constructor; reads the server URL, models and key from the settings */
+	FOpenAICompatibleClient();
+
+	/** Destructor */
+	virtual ~FOpenAICompatibleClient();
+
+	/**
+	 * Get a name for logs and the metrics output
+	 * @return Chat model and server URL
+	 */
+	virtual FString GetName() const override;
+
+	/**
+	 * Set the server URL
+	 * @param InBaseURL URL that endpoints are appended to (e.g. "http://127.0.0.1:8080/v1")
+	 */
+	void SetBaseURL(const FString& InBaseURL);
+
+	/**
+	 * Get the server URL
+	 * @return URL that endpoints are appended to
+	 */
+	const FString& GetBaseURL() const { return BaseURL; }
+
+	/**
+	 * Set the key sent as a bearer token
+	 * @param InAPIKey Key, empty to send no Authorization header
+	 */
+	void SetAPIKey(const FString& InAPIKey) { APIKey = InAPIKey; }
+
+	/**
+	 * Set the model named in chat requests
+	 * @param InModel Model name as the server knows it
+	 */
+	void SetChatModel(const FString& InModel) { ChatModel = InModel; }
+
+	/**
+	 * Get the model named in chat requests
+	 * @return Model name
+	 */
+	const FString& GetChatModel() const { return ChatModel; }
+
+	/**
+	 * Set the model named in image requests
+	 * @param InModel Model name as the server knows it
+	 */
+	void SetImageModel(const FString& InModel) { ImageModel = InModel; }
+
+	/**
+	 * Send a request to /chat/completions. CandidateCount is sent as "n" and AcceptCandidate
+	 * picks among the choices; the retry, cache and hedge options are ignored.
+	 */
+	virtual FGeminiRequestHandle SendChatCompletion(
+		const FString& Prompt,
+		const TArray<FConversationMessage>& ConversationHistory,
+		const TArray<FVFXToolFunction>& AvailableTools,
+		FOnGeminiResponse OnResponse,
+		FOnGeminiError OnError,
+		const FGeminiRequestOptions& Options = FGeminiRequestOptions()
+	) override;
+
+	/**
+	 * Send a request to /chat/completions with "stream":true and report each delta as it arrives.
+	 * With CandidateCount above 1 the reply is not streamed, as with FGeminiAPIClient.
+	 */
+	virtual FGeminiRequestHandle StreamChatCompletion(
+		const FString& Prompt,
+		const TArray<FConversationMessage>& ConversationHistory,
+		const TArray<FVFXToolFunction>& AvailableTools,
+		FOnGeminiStreamChunk OnChunk,
+		FOnGeminiResponse OnResponse,
+		FOnGeminiError OnError,
+		const FGeminiRequestOptions& Options = FGeminiRequestOptions()
+	) override;
+
+	/**
+	 * Send a request to /images/generations asking for a base64 PNG ("b64_json")
+	 */
+	virtual FGeminiRequestHandle GenerateTextureContent(
+		const FString& Prompt,
+		const FString& TextureType,
+		int32 Resolution,
+		FOnGeminiContent OnContent,
+		FOnGeminiError OnError,
+		const FGeminiRequestOptions& Options = FGeminiRequestOptions(EGeminiRequestPriority::Tool)
+	) override;
+
+	/**
+	 * Build a /chat/completions request body
+	 * @param Model Model name
+	 * @param Prompt User prompt, sent as the last message
+	 * @param ConversationHistory Previous messages; "system", "user" and "assistant" roles are kept, "model" is sent as "assistant"
+	 * @param AvailableTools Tool functions, declared under names the API accepts (see ToFunctionName)
+	 * @param bStream Ask for server-sent events
+	 * @param CandidateCount Choices asked for, sent as "n" when above 1
+	 * @return JSON string payload
+	 */
+	static FString BuildChatPayload(
+		const FString& Model,
+		const FString& Prompt,
+		const TArray<FConversationMessage>& ConversationHistory,
+		const TArray<FVFXToolFunction>& AvailableTools,
+		bool bStream,
+		int32 CandidateCount = 1
+	);
+
+	/**
+	 * Parse a /chat/completions reply into the form FGeminiAPIClient::ParseResponse gives
+	 * @param ResponseBody Response body JSON string
+	 * @param AvailableTools Tools of the request, to restore the names of called tools
+	 * @param OutResponse Text and tool calls of the first choice, the text of every choice, finish reason and token usage
+	 * @return True if the body is a chat completion with at least one choice
+	 */
+	static bool ParseChatResponse(const FString& ResponseBody, const TArray<FVFXToolFunction>& AvailableTools, FGeminiResponse& OutResponse);
+
+	/**
+	 * Extract the deltas of one streamed chat completion event
+	 * @param EventData JSON data of the event ({ choices: [{ delta: { content, tool_calls } }] }), or "[DONE]"
+	 * @param OutText Content delta of the first choice (may be empty)
+	 * @param OutFinishReason finish_reason of the first choice, empty until the last event
+	 * @param OutToolName Name delta of the first tool call (may be empty)
+	 * @param OutToolArguments Arguments delta of the first tool call; the pieces of all events form its JSON
+	 * @return False if the data is neither a chat completion chunk nor the end marker
+	 */
+	static bool ParseStreamEvent(const FString& EventData, FString& OutText, FString& OutFinishReason, FString& OutToolName, FString& OutToolArguments);
+
+	/**
+	 * Name a tool is declared under; function names may only hold letters, digits, "_" and "-"
+	 * @param ToolName Tool name (e.g. "tool:texture")
+	 * @return Function name (e.g. "tool_texture")
+	 */
+	static FString ToFunctionName(const FString& ToolName);
+
+private:
+	/** Server URL, without a trailing slash */
+	FString BaseURL;
+
+	/** Bearer token, empty for none */
+	FString APIKey;
+
+	/** Model of chat requests */
+	FString ChatModel;
+
+	/** Model of image requests */
+	FString ImageModel;
+
+	/** Endpoint for chat completion, streamed or not */
+	static const FString ChatCompletionsEndpoint;
+
+	/** Endpoint for image generation */
+	static const FString ImageGenerationsEndpoint;
+};
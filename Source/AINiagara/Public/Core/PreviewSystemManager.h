@@ -93,6 +93,11 @@ public:
 	 */
 	FVFXDSLDiffResult GetDSLDiff(const FVFXDSL& NewDSL) const;
 
+	/**
+	 * Content hash of the DSL currently previewed (FVFXDSLHash), 0 if there is no preview
+	 */
+	uint64 GetCurrentPreviewHash() const { return CurrentPreviewHash; }
+
 private:
 	/** Current Niagara preview system */
 	UPROPERTY()
@@ -112,6 +117,9 @@ private:
 	/** Current preview DSL (for change detection) */
 	FVFXDSL CurrentPreviewDSL;
 
+	/** FVFXDSLHash of CurrentPreviewDSL, 0 when nothing is previewed */
+	uint64 CurrentPreviewHash = 0;
+
 	/** Last update time (for throttling) */
 	double LastUpdateTime = 0.0;
 
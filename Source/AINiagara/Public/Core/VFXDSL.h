@@ -7,6 +7,29 @@
 #include "UObject/StructOnScope.h"
 #include "VFXDSL.generated.h"
 
+/**
+ * Float tolerances shared by DSL comparison (UVFXDSLDiff) and content hashing (FVFXDSLHash)
+ */
+namespace VFXDSLTolerance
+{
+	/** Durations, rates, sizes, forces and other scalar values */
+	constexpr float Default = 0.001f;
+
+	/** Color components */
+	constexpr float Color = 0.01f;
+
+	/** Integer counts compared as floats */
+	constexpr float Count = 0.5f;
+}
+
+/*
+ * FVFXDSLCodec builds its field tables from the UPROPERTY data of the structs below.
+ * JSON keys and diff paths come from the property names; metadata adds:
+ *  - ClampMin / ClampMax: valid range, checked when ValidationCode names the EVFXDSLValidationCode to report
+ *  - EditCondition: sibling bool that must be set for the range to apply
+ *  - DiffTolerance: VFXDSLTolerance used when comparing ("Color", "Count"; Default otherwise)
+ */
+
 /**
  * DSL Effect type enumeration
  */
@@ -30,7 +53,7 @@ struct FVFXDSLEffect
 	EVFXEffectType Type = EVFXEffectType::Niagara;
 
 	/** Effect duration in seconds */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX")
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX", meta = (ClampMin = "0", ValidationCode = "NegativeDuration"))
 	float Duration = 5.0f;
 
 	/** Whether the effect loops */
@@ -47,7 +70,7 @@ struct FVFXDSLBurst
 	GENERATED_BODY()
 
 	/** Number of particles to spawn */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX")
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX", meta = (ClampMin = "0", ValidationCode = "NegativeBurstCount", DiffTolerance = "Count"))
 	int32 Count = 10;
 
 	/** Time at which to spawn */
@@ -68,7 +91,7 @@ struct FVFXDSLRate
 	GENERATED_BODY()
 
 	/** Particles per second spawn rate */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX")
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX", meta = (ClampMin = "0", ValidationCode = "NegativeSpawnRate"))
 	float SpawnRate = 10.0f;
 
 	/** Scale factor over time */
@@ -101,16 +124,16 @@ struct FVFXDSLColor
 {
 	GENERATED_BODY()
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX")
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX", meta = (ClampMin = "0", ClampMax = "1", ValidationCode = "ColorOutOfRange", DiffTolerance = "Color"))
 	float R = 1.0f;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX")
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX", meta = (ClampMin = "0", ClampMax = "1", ValidationCode = "ColorOutOfRange", DiffTolerance = "Color"))
 	float G = 1.0f;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX")
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX", meta = (ClampMin = "0", ClampMax = "1", ValidationCode = "ColorOutOfRange", DiffTolerance = "Color"))
 	float B = 1.0f;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX")
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX", meta = (ClampMin = "0", ClampMax = "1", ValidationCode = "ColorOutOfRange", DiffTolerance = "Color"))
 	float A = 1.0f;
 
 	/** Convert to FLinearColor */
@@ -129,11 +152,11 @@ struct FVFXDSLSize
 	GENERATED_BODY()
 
 	/** Minimum size */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX")
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX", meta = (ClampMin = "0", ValidationCode = "NegativeSize"))
 	float Min = 1.0f;
 
 	/** Maximum size */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX")
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX", meta = (ClampMin = "0", ValidationCode = "NegativeSize"))
 	float Max = 1.0f;
 };
 
@@ -212,7 +235,7 @@ struct FVFXDSLCollision
 	bool bEnabled = false;
 
 	/** Bounce coefficient */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX")
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VFX", meta = (ClampMin = "0", ClampMax = "1", ValidationCode = "BounceOutOfRange", EditCondition = "bEnabled"))
 	float Bounce = 0.5f;
 };
 
@@ -341,6 +364,87 @@ struct FVFXDSL
 	TArray<FVFXDSLEmitter> Emitters;
 };
 
+/**
+ * Validation rule that an error record violates
+ */
+UENUM(BlueprintType)
+enum class EVFXDSLValidationCode : uint8
+{
+	NegativeDuration		UMETA(DisplayName = "Negative Duration"),
+	NoEmitters				UMETA(DisplayName = "No Emitters"),
+	EmptyName				UMETA(DisplayName = "Empty Name"),
+	ColorOutOfRange			UMETA(DisplayName = "Color Out Of Range"),
+	NegativeSize			UMETA(DisplayName = "Negative Size"),
+	SizeMinAboveMax			UMETA(DisplayName = "Size Min Above Max"),
+	NegativeBurstCount		UMETA(DisplayName = "Negative Burst Count"),
+	NegativeSpawnRate		UMETA(DisplayName = "Negative Spawn Rate"),
+	BounceOutOfRange		UMETA(DisplayName = "Bounce Out Of Range")
+};
+
+/**
+ * DSL field an error record refers to
+ */
+UENUM(BlueprintType)
+enum class EVFXDSLFieldId : uint8
+{
+	None							UMETA(DisplayName = "None"),
+	EffectDuration					UMETA(DisplayName = "Effect.Duration"),
+	Emitters						UMETA(DisplayName = "Emitters"),
+	EmitterName						UMETA(DisplayName = "Name"),
+	InitializationColorR			UMETA(DisplayName = "Initialization.Color.R"),
+	InitializationColorG			UMETA(DisplayName = "Initialization.Color.G"),
+	InitializationColorB			UMETA(DisplayName = "Initialization.Color.B"),
+	InitializationColorA			UMETA(DisplayName = "Initialization.Color.A"),
+	InitializationSize				UMETA(DisplayName = "Initialization.Size"),
+	InitializationSizeMin			UMETA(DisplayName = "Initialization.Size.Min"),
+	InitializationSizeMax			UMETA(DisplayName = "Initialization.Size.Max"),
+	SpawnersBurstCount				UMETA(DisplayName = "Spawners.Burst.Count"),
+	SpawnersRateSpawnRate			UMETA(DisplayName = "Spawners.Rate.SpawnRate"),
+	UpdateCollisionBounce			UMETA(DisplayName = "Update.Collision.Bounce")
+};
+
+/**
+ * Compact validation error record; the message text is built on demand by UVFXDSLValidator::FormatError
+ */
+USTRUCT(BlueprintType)
+struct FVFXDSLValidationError
+{
+	GENERATED_BODY()
+
+	/** Rule that was violated */
+	UPROPERTY(BlueprintReadOnly, Category = "VFX")
+	EVFXDSLValidationCode Code = EVFXDSLValidationCode::NegativeDuration;
+
+	/** Emitter the error belongs to, INDEX_NONE for effect-level errors */
+	UPROPERTY(BlueprintReadOnly, Category = "VFX")
+	int32 EmitterIndex = INDEX_NONE;
+
+	/** Offending field */
+	UPROPERTY(BlueprintReadOnly, Category = "VFX")
+	EVFXDSLFieldId Field = EVFXDSLFieldId::None;
+
+	/** Offending value */
+	UPROPERTY(BlueprintReadOnly, Category = "VFX")
+	double Value = 0.0;
+
+	/** Second value for rules that compare two fields (e.g. Size.Max) */
+	UPROPERTY(BlueprintReadOnly, Category = "VFX")
+	double OtherValue = 0.0;
+
+	FVFXDSLValidationError()
+	{
+	}
+
+	FVFXDSLValidationError(EVFXDSLValidationCode InCode, int32 InEmitterIndex, EVFXDSLFieldId InField, double InValue = 0.0, double InOtherValue = 0.0)
+		: Code(InCode)
+		, EmitterIndex(InEmitterIndex)
+		, Field(InField)
+		, Value(InValue)
+		, OtherValue(InOtherValue)
+	{
+	}
+};
+
 /**
  * DSL validation result
  */
@@ -353,10 +457,14 @@ struct FVFXDSLValidationResult
 	UPROPERTY(BlueprintReadOnly, Category = "VFX")
 	bool bIsValid = false;
 
-	/** Error messages if validation failed */
+	/** Error messages if validation failed (filled by UVFXDSLValidator::Validate, or FormatErrors on demand) */
 	UPROPERTY(BlueprintReadOnly, Category = "VFX")
 	TArray<FString> ErrorMessages;
 
+	/** Structured error records, in the order the checks ran */
+	UPROPERTY(BlueprintReadOnly, Category = "VFX")
+	TArray<FVFXDSLValidationError> Errors;
+
 	/** Add an error message */
 	void AddError(const FString& ErrorMessage)
 	{
@@ -364,11 +472,24 @@ struct FVFXDSLValidationResult
 		ErrorMessages.Add(ErrorMessage);
 	}
 
+	/** Add a structured error record */
+	void AddError(const FVFXDSLValidationError& Error)
+	{
+		bIsValid = false;
+		Errors.Add(Error);
+	}
+
+	/** Whether any record uses the given code */
+	bool HasError(EVFXDSLValidationCode Code) const
+	{
+		return Errors.ContainsByPredicate([Code](const FVFXDSLValidationError& Error) { return Error.Code == Code; });
+	}
+
 	/** Clear all errors */
 	void Clear()
 	{
 		bIsValid = true;
 		ErrorMessages.Empty();
+		Errors.Reset();
 	}
 };
-
@@ -0,0 +1,159 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/VFXDSL.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Compact, versioned binary encoding of FVFXDSL for large effect libraries.
+ *
+ * Layout (little endian):
+ *   Header:  uint32 Magic ('VDSL'), uint16 Version, uint16 Flags, uint32 RecordCount
+ *   Records: uint32 PayloadSize, followed by PayloadSize bytes of DSL fields
+ *
+ * Records are length-prefixed so a reader can skip trailing fields written by a newer
+ * minor revision. Strings are stored as int32 length + UTF-8 bytes, bools as uint8.
+ */
+namespace VFXDSLBinary
+{
+	/** 'VDSL' */
+	constexpr uint32 Magic = 0x4C534456;
+
+	enum class EVersion : uint16
+	{
+		Invalid = 0,
+		Initial = 1,
+
+		LatestPlusOne,
+		Latest = LatestPlusOne - 1
+	};
+
+	/** Size of the file header in bytes */
+	constexpr int64 HeaderSize = sizeof(uint32) + sizeof(uint16) + sizeof(uint16) + sizeof(uint32);
+}
+
+/**
+ * Writes DSL records to an archive in the binary library format
+ */
+class AINIAGARA_API FVFXDSLBinaryWriter
+{
+public:
+	/**
+	 * Start a library on the given archive (the header is written immediately)
+	 * @param InArchive Saving archive; must support Seek so the record count can be patched by Finish
+	 */
+	explicit FVFXDSLBinaryWriter(FArchive& InArchive);
+
+	/**
+	 * Append one DSL record
+	 * @param DSL DSL to encode
+	 */
+	void Write(const FVFXDSL& DSL);
+
+	/**
+	 * Patch the header with the final record count
+	 * @return True if the archive reported no errors
+	 */
+	bool Finish();
+
+	/** Number of records written so far */
+	int32 GetNumRecords() const { return NumRecords; }
+
+	/**
+	 * Encode a set of DSLs into a byte buffer
+	 * @param DSLs DSLs to encode
+	 * @param OutBytes Output buffer (replaced)
+	 * @return True if encoding succeeded
+	 */
+	static bool SaveToBytes(TConstArrayView<FVFXDSL> DSLs, TArray<uint8>& OutBytes);
+
+	/**
+	 * Encode a set of DSLs into a file
+	 * @param DSLs DSLs to encode
+	 * @param FilePath Destination file path
+	 * @param OutError Error message if saving fails
+	 * @return True if the file was written
+	 */
+	static bool SaveToFile(TConstArrayView<FVFXDSL> DSLs, const FString& FilePath, FString& OutError);
+
+private:
+	FArchive& Archive;
+	int64 HeaderOffset = 0;
+	int32 NumRecords = 0;
+	TArray<uint8> RecordBuffer;
+};
+
+/**
+ * Iterates DSL records from a binary library.
+ *
+ * The source is either a caller-owned byte view, a file loaded into memory, or a
+ * memory-mapped file. Next() decodes into the caller's FVFXDSL and reuses its
+ * emitter, interval and string storage, so iterating a library performs no
+ * per-record allocation once the buffers have grown to the largest record.
+ */
+class AINIAGARA_API FVFXDSLBinaryReader
+{
+public:
+	FVFXDSLBinaryReader();
+	~FVFXDSLBinaryReader();
+
+	/**
+	 * Read from a caller-owned buffer; the bytes must outlive the reader
+	 * @param Bytes Encoded library
+	 * @param OutError Error message if the header is invalid
+	 * @return True if the header was accepted
+	 */
+	bool OpenBytes(TConstArrayView<uint8> Bytes, FString& OutError);
+
+	/**
+	 * Read from a file
+	 * @param FilePath Library file
+	 * @param bMemoryMap Map the file instead of loading it (falls back to loading when mapping is unavailable)
+	 * @param OutError Error message if the file or header is invalid
+	 * @return True if the header was accepted
+	 */
+	bool OpenFile(const FString& FilePath, bool bMemoryMap, FString& OutError);
+
+	/**
+	 * Decode the next record
+	 * @param InOutDSL Destination; its existing allocations are reused
+	 * @return True if a record was decoded, false at the end of the library or on error (see GetError)
+	 */
+	bool Next(FVFXDSL& InOutDSL);
+
+	/** Release the source buffer or mapping */
+	void Close();
+
+	/** Number of records declared in the header */
+	int32 GetNumRecords() const { return NumRecords; }
+
+	/** Format version of the open library */
+	uint16 GetVersion() const { return Version; }
+
+	/** Whether the open library is backed by a memory mapping */
+	bool IsMemoryMapped() const { return MappedRegion.IsValid(); }
+
+	/** Last decoding error, empty if none */
+	const FString& GetError() const { return Error; }
+
+private:
+	bool ReadHeader(FString& OutError);
+
+	TUniquePtr<IMappedFileHandle> MappedHandle;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TArray<uint8> OwnedBytes;
+	TConstArrayView<uint8> Data;
+
+	int64 Offset = 0;
+	int32 NumRecords = 0;
+	int32 RecordIndex = 0;
+	uint16 Version = 0;
+	FString Error;
+
+	/** Scratch space for UTF-8 string decoding */
+	TArray<ANSICHAR> StringScratch;
+};
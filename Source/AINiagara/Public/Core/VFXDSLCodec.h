@@ -0,0 +1,226 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/VFXDSL.h"
+#include "Serialization/JsonWriter.h"
+
+struct FVFXDSLDiffResult;
+class FNumericProperty;
+
+/**
+ * Value type of a codec field
+ */
+enum class EVFXDSLCodecType : uint8
+{
+	Struct,
+	Float,
+	Int32,
+	Bool,
+	String,
+	Enum,
+	FloatArray
+};
+
+/**
+ * One node of a DSL struct, described from its UPROPERTY data
+ */
+struct AINIAGARA_API FVFXDSLCodecField
+{
+	/** JSON key: property name without the bool 'b' prefix, first letter lower-cased ("spawnRate", "enabled") */
+	FString JsonKey;
+
+	/** Diff and patch path from the table root ("Spawners.Rate.SpawnRate", "Effect.Duration") */
+	FString Path;
+
+	EVFXDSLCodecType Type = EVFXDSLCodecType::Struct;
+
+	/** Byte offset from the start of the table's root struct */
+	int32 Offset = 0;
+
+	/** Struct nodes: children are Fields[FirstChild, FirstChild + NumChildren) */
+	int32 FirstChild = INDEX_NONE;
+	int32 NumChildren = 0;
+
+	/** Leaves of this subtree are Leaves[FirstLeaf, EndLeaf) */
+	int32 FirstLeaf = 0;
+	int32 EndLeaf = 0;
+
+	/** Comparison tolerance for Float, Int32 and FloatArray fields (DiffTolerance metadata) */
+	float Tolerance = VFXDSLTolerance::Default;
+
+	/** Whether the field is range-checked (ValidationCode metadata) */
+	bool bValidated = false;
+
+	/** Valid range (ClampMin / ClampMax metadata) */
+	double RangeMin = -DBL_MAX;
+	double RangeMax = DBL_MAX;
+
+	/** Error reported when the value is out of range */
+	EVFXDSLValidationCode RangeCode = EVFXDSLValidationCode::NegativeDuration;
+
+	/** Field id recorded in validation errors, found by path ("Initialization.Color.R" -> InitializationColorR) */
+	EVFXDSLFieldId FieldId = EVFXDSLFieldId::None;
+
+	/** Offset of the bool that must be true for the range to apply (EditCondition metadata), INDEX_NONE if unconditional */
+	int32 ConditionOffset = INDEX_NONE;
+
+	/** Enum fields: the underlying integer property and the (value, name) pairs */
+	const FNumericProperty* EnumValueProperty = nullptr;
+	TArray<TPair<int64, FString>> EnumEntries;
+};
+
+/**
+ * Flat description of one DSL struct (FVFXDSLEffect or FVFXDSLEmitter)
+ */
+struct AINIAGARA_API FVFXDSLCodecTable
+{
+	/** Fields[0] is the root struct; the children of every struct node are contiguous */
+	TArray<FVFXDSLCodecField> Fields;
+
+	/** Leaf field indices in declaration order */
+	TArray<int32> Leaves;
+
+	/** Leaf field indices with strings moved to the end, for early-out comparison */
+	TArray<int32> CompareOrder;
+
+	/** Field index by Path (case-insensitive), for callers that address fields by name */
+	TMap<FString, int32> FieldsByPath;
+
+	/** @return Index of the field with the given path, INDEX_NONE if there is none */
+	int32 FindField(const FString& Path) const
+	{
+		const int32* Index = FieldsByPath.Find(Path);
+		return Index ? *Index : INDEX_NONE;
+	}
+};
+
+/**
+ * Reflection-driven DSL codec.
+ *
+ * Walks the UPROPERTY data of FVFXDSLEffect and FVFXDSLEmitter once (at module
+ * startup, or on first use) and flattens each into an FVFXDSLCodecTable of JSON
+ * keys, offsets, types, tolerances and ranges. The stream parser, the JSON writer,
+ * UVFXDSLDiff, the range checks of UVFXDSLValidator and FVFXDSLPatch all run off
+ * these tables, so a new DSL field only needs its UPROPERTY.
+ *
+ * Versioned encodings (FVFXDSLHash, the binary format) stay explicit on purpose.
+ */
+class AINIAGARA_API FVFXDSLCodec
+{
+public:
+	/** Codec instance; the tables are built on first use */
+	static const FVFXDSLCodec& Get();
+
+	/** Build the tables up front (called from StartupModule) */
+	static void Initialize();
+
+	const FVFXDSLCodecTable& GetEffectTable() const { return EffectTable; }
+	const FVFXDSLCodecTable& GetEmitterTable() const { return EmitterTable; }
+
+	/** Typed access to a field of the table's root struct */
+	template <typename ValueType>
+	static ValueType& GetValue(const FVFXDSLCodecField& Field, void* Base)
+	{
+		return *reinterpret_cast<ValueType*>(static_cast<uint8*>(Base) + Field.Offset);
+	}
+
+	template <typename ValueType>
+	static const ValueType& GetValue(const FVFXDSLCodecField& Field, const void* Base)
+	{
+		return *reinterpret_cast<const ValueType*>(static_cast<const uint8*>(Base) + Field.Offset);
+	}
+
+	/** Enum fields: read, write and look up values */
+	static int64 GetEnumValue(const FVFXDSLCodecField& Field, const void* Base);
+	static void SetEnumValue(const FVFXDSLCodecField& Field, void* Base, int64 Value);
+	static const FString& GetEnumName(const FVFXDSLCodecField& Field, const void* Base);
+
+	/** Find an enum value by name (case-insensitive) */
+	static bool FindEnumValue(const FVFXDSLCodecField& Field, const FString& Name, int64& OutValue);
+
+	/** Whether a leaf differs beyond its tolerance */
+	static bool FieldDiffers(const FVFXDSLCodecField& Field, const void* OldBase, const void* NewBase);
+
+	/** Whether any leaf of the table differs; strings are compared last */
+	static bool AnyDifference(const FVFXDSLCodecTable& Table, const void* OldBase, const void* NewBase);
+
+	/**
+	 * Report every leaf that differs, in declaration order
+	 * @param PathPrefix Prepended to each field path (e.g. "Emitters[2].")
+	 */
+	static void Compare(const FVFXDSLCodecTable& Table, const void* OldBase, const void* NewBase, const FString& PathPrefix, FVFXDSLDiffResult& OutResult);
+
+	/** Leaf value as display text (numbers as FString::SanitizeFloat, arrays as "[a, b]") */
+	static FString FormatValue(const FVFXDSLCodecField& Field, const void* Base);
+
+	/**
+	 * Range-check the leaves Leaves[FirstLeaf, EndLeaf) in declaration order
+	 * @param EmitterIndex Recorded in the error, INDEX_NONE for the effect
+	 */
+	static void ValidateRanges(const FVFXDSLCodecTable& Table, int32 FirstLeaf, int32 EndLeaf, const void* Base, int32 EmitterIndex, FVFXDSLValidationResult& OutResult);
+
+	/**
+	 * Write the children of a struct node as JSON members, in declaration order.
+	 * Numbers are written as doubles, matching the DOM built by UVFXDSLParser::ToJSONDOM.
+	 */
+	template <class CharType, class PrintPolicy>
+	static void WriteFields(TJsonWriter<CharType, PrintPolicy>& Writer, const FVFXDSLCodecTable& Table, int32 NodeIndex, const void* Base);
+
+private:
+	FVFXDSLCodec();
+
+	/** Flatten a struct into a table; Path is prefixed to every field path */
+	static void BuildTable(const UScriptStruct* Struct, const FString& RootPath, FVFXDSLCodecTable& OutTable);
+
+	/** Describe one property; returns false for types the codec does not handle */
+	static bool DescribeProperty(const FProperty& Property, const UStruct& Owner, const FVFXDSLCodecField& Parent, FVFXDSLCodecField& OutField);
+
+	/** Fill FirstLeaf/EndLeaf and the leaf list, depth first */
+	static void AssignLeaves(FVFXDSLCodecTable& Table, int32 NodeIndex);
+
+	FVFXDSLCodecTable EffectTable;
+	FVFXDSLCodecTable EmitterTable;
+};
+
+template <class CharType, class PrintPolicy>
+void FVFXDSLCodec::WriteFields(TJsonWriter<CharType, PrintPolicy>& Writer, const FVFXDSLCodecTable& Table, int32 NodeIndex, const void* Base)
+{
+	const FVFXDSLCodecField& Node = Table.Fields[NodeIndex];
+	for (int32 FieldIndex = Node.FirstChild; FieldIndex < Node.FirstChild + Node.NumChildren; ++FieldIndex)
+	{
+		const FVFXDSLCodecField& Field = Table.Fields[FieldIndex];
+		switch (Field.Type)
+		{
+		case EVFXDSLCodecType::Struct:
+			Writer.WriteObjectStart(Field.JsonKey);
+			WriteFields(Writer, Table, FieldIndex, Base);
+			Writer.WriteObjectEnd();
+			break;
+		case EVFXDSLCodecType::Float:
+			Writer.WriteValue(Field.JsonKey, static_cast<double>(GetValue<float>(Field, Base)));
+			break;
+		case EVFXDSLCodecType::Int32:
+			Writer.WriteValue(Field.JsonKey, static_cast<double>(GetValue<int32>(Field, Base)));
+			break;
+		case EVFXDSLCodecType::Bool:
+			Writer.WriteValue(Field.JsonKey, GetValue<bool>(Field, Base));
+			break;
+		case EVFXDSLCodecType::String:
+			Writer.WriteValue(Field.JsonKey, GetValue<FString>(Field, Base));
+			break;
+		case EVFXDSLCodecType::Enum:
+			Writer.WriteValue(Field.JsonKey, GetEnumName(Field, Base));
+			break;
+		case EVFXDSLCodecType::FloatArray:
+			Writer.WriteArrayStart(Field.JsonKey);
+			for (float Element : GetValue<TArray<float>>(Field, Base))
+			{
+				Writer.WriteValue(static_cast<double>(Element));
+			}
+			Writer.WriteArrayEnd();
+			break;
+		}
+	}
+}
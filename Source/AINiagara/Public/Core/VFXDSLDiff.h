@@ -143,38 +143,41 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "AINiagara|DSL")
 	static FVFXDSLDiffResult Compare(const FVFXDSL& OldDSL, const FVFXDSL& NewDSL);
 
+	/**
+	 * Check whether Compare would report any change, without allocating or formatting
+	 * @param OldDSL Previous DSL version
+	 * @param NewDSL New DSL version
+	 * @return True as soon as the first difference is found
+	 */
+	UFUNCTION(BlueprintCallable, Category = "AINiagara|DSL")
+	static bool AnyDifference(const FVFXDSL& OldDSL, const FVFXDSL& NewDSL);
+
+	/**
+	 * Check whether two emitters differ in any field Compare looks at
+	 */
+	static bool EmitterDiffers(const FVFXDSLEmitter& OldEmitter, const FVFXDSLEmitter& NewEmitter);
+
+	/**
+	 * Match emitters between two versions.
+	 * Emitters are paired by unique name first; the rest are aligned with a longest
+	 * common subsequence over unchanged emitters, and whatever is left is paired in order.
+	 * @param OldEmitters Previous emitters
+	 * @param NewEmitters New emitters
+	 * @param OutNewToOld For each new emitter, the index of its old counterpart or INDEX_NONE if it was added
+	 */
+	static void MatchEmitters(const TArray<FVFXDSLEmitter>& OldEmitters, const TArray<FVFXDSLEmitter>& NewEmitters, TArray<int32>& OutNewToOld);
+
 private:
-	/** Compare effect configurations */
+	/** Largest leftover old x new emitter grid aligned with LCS; bigger grids are paired in order */
+	static constexpr int32 MaxLCSCells = 1 << 20;
+
+	/** Compare effect configurations (FVFXDSLCodec effect table) */
 	static void CompareEffect(const FVFXDSLEffect& OldEffect, const FVFXDSLEffect& NewEffect, FVFXDSLDiffResult& OutResult);
 
 	/** Compare emitters */
 	static void CompareEmitters(const TArray<FVFXDSLEmitter>& OldEmitters, const TArray<FVFXDSLEmitter>& NewEmitters, FVFXDSLDiffResult& OutResult);
 
-	/** Compare a single emitter */
+	/** Compare a single emitter field by field (FVFXDSLCodec emitter table); paths use Index */
 	static void CompareEmitter(const FVFXDSLEmitter& OldEmitter, const FVFXDSLEmitter& NewEmitter, int32 Index, FVFXDSLDiffResult& OutResult);
-
-	/** Compare spawners */
-	static void CompareSpawners(const FVFXDSLSpawners& OldSpawners, const FVFXDSLSpawners& NewSpawners, const FString& BasePath, FVFXDSLDiffResult& OutResult);
-
-	/** Compare initialization */
-	static void CompareInitialization(const FVFXDSLInitialization& OldInit, const FVFXDSLInitialization& NewInit, const FString& BasePath, FVFXDSLDiffResult& OutResult);
-
-	/** Compare update */
-	static void CompareUpdate(const FVFXDSLUpdate& OldUpdate, const FVFXDSLUpdate& NewUpdate, const FString& BasePath, FVFXDSLDiffResult& OutResult);
-
-	/** Compare render */
-	static void CompareRender(const FVFXDSLRender& OldRender, const FVFXDSLRender& NewRender, const FString& BasePath, FVFXDSLDiffResult& OutResult);
-
-	/** Helper to compare float values */
-	static void CompareFloat(const FString& Path, float OldValue, float NewValue, float Tolerance, FVFXDSLDiffResult& OutResult);
-
-	/** Helper to compare string values */
-	static void CompareString(const FString& Path, const FString& OldValue, const FString& NewValue, FVFXDSLDiffResult& OutResult);
-
-	/** Helper to compare color values */
-	static void CompareColor(const FString& Path, const FVFXDSLColor& OldColor, const FVFXDSLColor& NewColor, FVFXDSLDiffResult& OutResult);
-
-	/** Helper to compare velocity values */
-	static void CompareVelocity(const FString& Path, const FVFXDSLVelocity& OldVel, const FVFXDSLVelocity& NewVel, FVFXDSLDiffResult& OutResult);
 };
 
@@ -0,0 +1,43 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/VFXDSL.h"
+
+/**
+ * Stable 64-bit content hash of FVFXDSL.
+ *
+ * Every field is fed to XXH64 in a fixed order, so the hash does not depend on
+ * how the DSL was produced (JSON key order, pretty or condensed layout, binary
+ * library). Floats are quantized with the same tolerances UVFXDSLDiff uses
+ * (see VFXDSLTolerance) so values that only differ by parser noise hash alike;
+ * values that straddle a quantization step can still hash differently, so a
+ * matching hash means "unchanged" while a differing hash means "probably changed".
+ *
+ * Integers are hashed as little-endian bytes and strings as UTF-8, so a hash
+ * stored on one platform matches on another.
+ *
+ * Strings are hashed case-sensitively, while UVFXDSLDiff matches emitter names
+ * case-insensitively: renaming "Sparks" to "sparks" changes the hash even though
+ * the diff pairs the two emitters.
+ *
+ * Emitter order is significant. Cheap enough to call every frame: one pass over
+ * the fields, allocating only for strings longer than the UTF-8 converter's
+ * inline buffer.
+ */
+class AINIAGARA_API FVFXDSLHash
+{
+public:
+	/** Hash of a complete DSL; never returns 0, so callers may use 0 as "no hash" */
+	static uint64 Hash(const FVFXDSL& DSL);
+
+	/** Hash of a single emitter, independent of its position in the DSL */
+	static uint64 HashEmitter(const FVFXDSLEmitter& Emitter);
+
+	/** Fixed-width hexadecimal form, suitable for cache keys and file names */
+	static FString ToString(uint64 Hash);
+
+	/** Bumped whenever the hashed field set or encoding changes, invalidating stored hashes */
+	static constexpr uint32 FormatVersion = 2;
+};
@@ -0,0 +1,134 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/VFXDSL.h"
+
+/** Fired when the "effect" object has been fully received */
+DECLARE_DELEGATE_OneParam(FOnVFXDSLEffectParsed, const FVFXDSLEffect& /*Effect*/);
+
+/** Fired when an element of the "emitters" array has been fully received */
+DECLARE_DELEGATE_TwoParams(FOnVFXDSLEmitterParsed, int32 /*EmitterIndex*/, const FVFXDSLEmitter& /*Emitter*/);
+
+/**
+ * Resumable DSL parser for LLM output that arrives in chunks.
+ *
+ * Chunks are appended as they arrive. A lightweight structural scanner tracks
+ * strings, nesting and the root-level keys, and as soon as an element of the
+ * "emitters" array closes it is parsed with FVFXDSLStreamParser and reported
+ * through OnEmitterParsed. The root object starts at the first '{' that opens
+ * a fenced block or is followed by a key, so braces in leading prose such as
+ * "use {curly} braces" are skipped; text after the root object is ignored.
+ *
+ * Delegates may append more text; it is scanned once the current scan reaches it.
+ *
+ * Finish() parses the complete document with UVFXDSLParser::ParseFromJSON, so
+ * the final result and error messages are identical to the non-incremental path.
+ */
+class AINIAGARA_API FVFXDSLIncrementalParser
+{
+public:
+	FVFXDSLIncrementalParser();
+
+	/** Fired once the "effect" object is complete */
+	FOnVFXDSLEffectParsed OnEffectParsed;
+
+	/** Fired for every completed emitter, in document order */
+	FOnVFXDSLEmitterParsed OnEmitterParsed;
+
+	/**
+	 * Append decoded text
+	 * @param Chunk Next piece of the response
+	 */
+	void AppendChunk(FStringView Chunk);
+
+	/**
+	 * Append raw UTF-8 bytes; a multi-byte sequence split across calls is held until complete
+	 * @param Bytes Next piece of the response body
+	 */
+	void AppendUTF8(TConstArrayView<uint8> Bytes);
+
+	/**
+	 * Parse the complete DSL document received so far
+	 * @param OutDSL Output DSL structure
+	 * @param OutError Error message if parsing fails
+	 * @return True if parsing succeeded
+	 */
+	bool Finish(FVFXDSL& OutDSL, FString& OutError) const;
+
+	/** Discard all buffered text and scanner state */
+	void Reset();
+
+	/** Whether a root '{' has been seen */
+	bool HasStarted() const { return RootStart != INDEX_NONE; }
+
+	/** Whether the root object has been closed */
+	bool IsComplete() const { return RootEnd != INDEX_NONE; }
+
+	/** Number of emitters reported through OnEmitterParsed */
+	int32 GetNumEmittersParsed() const { return NumEmittersParsed; }
+
+	/** JSON text of the root object received so far (excludes surrounding prose) */
+	FStringView GetJsonText() const;
+
+private:
+	/** Scan newly appended characters */
+	void Scan();
+
+	/** Called when a tracked object closes at the given buffer offset */
+	void OnObjectClosed(int32 EndOffset);
+
+	/**
+	 * Whether the '{' at Offset opens the DSL rather than prose
+	 * @param bOutNeedMoreText Set when the answer depends on text that has not arrived yet
+	 */
+	bool IsRootStart(int32 Offset, bool& bOutNeedMoreText) const;
+
+	/** All text received so far */
+	FString Buffer;
+
+	/** Next buffer offset to scan */
+	int32 ScanOffset = 0;
+
+	/** Offset of the root '{' and the matching '}' */
+	int32 RootStart = INDEX_NONE;
+	int32 RootEnd = INDEX_NONE;
+
+	/** Container nesting depth (root object is depth 1) */
+	int32 Depth = 0;
+
+	bool bInString = false;
+	bool bEscaped = false;
+
+	/** True from a ``` fence to the end of its line, and from there to the first non-whitespace character */
+	bool bInFenceLine = false;
+	bool bAtFenceBody = false;
+
+	/** True while Scan runs, so delegates that append text do not re-enter it */
+	bool bScanning = false;
+
+	/** True while the root object expects a key rather than a value */
+	bool bRootExpectsKey = false;
+
+	/** True while the string being scanned is a root-level key */
+	bool bReadingRootKey = false;
+
+	/** Most recent root-level key */
+	FString RootKey;
+
+	/** True while scanning inside the root "emitters" array */
+	bool bInEmittersArray = false;
+
+	/** Index of the next value in the emitters array */
+	int32 EmitterValueIndex = 0;
+
+	/** Start offset of the object currently being tracked (effect or emitter), INDEX_NONE if none */
+	int32 TrackedObjectStart = INDEX_NONE;
+	bool bTrackingEffect = false;
+
+	int32 NumEmittersParsed = 0;
+
+	/** Trailing bytes of an incomplete UTF-8 sequence */
+	TArray<uint8, TInlineAllocator<4>> PendingUTF8;
+};
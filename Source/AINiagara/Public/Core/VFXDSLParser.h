@@ -6,6 +6,18 @@
 #include "Core/VFXDSL.h"
 #include "VFXDSLParser.generated.h"
 
+/**
+ * Output layout for DSL JSON serialization
+ */
+UENUM(BlueprintType)
+enum class EVFXDSLJsonFormat : uint8
+{
+	/** Indented, one field per line (files, export, display) */
+	Pretty		UMETA(DisplayName = "Pretty"),
+	/** No whitespace (prompts, logs) */
+	Condensed	UMETA(DisplayName = "Condensed")
+};
+
 /**
  * Parser for VFX DSL JSON format
  */
@@ -25,6 +37,16 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "AINiagara|DSL")
 	static bool ParseFromJSON(const FString& JsonString, FVFXDSL& OutDSL, FString& OutError);
 
+	/**
+	 * Parse DSL from JSON string by deserializing a full FJsonObject DOM first.
+	 * Kept as the reference implementation for FVFXDSLStreamParser.
+	 * @param JsonString JSON string to parse
+	 * @param OutDSL Output DSL structure
+	 * @param OutError Error message if parsing fails
+	 * @return True if parsing succeeded
+	 */
+	static bool ParseFromJSONDOM(const FString& JsonString, FVFXDSL& OutDSL, FString& OutError);
+
 	/**
 	 * Convert DSL to JSON string
 	 * @param DSL DSL structure to convert
@@ -34,6 +56,50 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "AINiagara|DSL")
 	static bool ToJSON(const FVFXDSL& DSL, FString& OutJsonString);
 
+	/**
+	 * Convert DSL to JSON string in the requested layout.
+	 * Fields are written straight into OutJsonString, which is reset (keeping its allocation)
+	 * and reserved up front, so reusing the same string across calls does not reallocate.
+	 * @param DSL DSL structure to convert
+	 * @param Format Pretty or condensed output
+	 * @param OutJsonString Output JSON string
+	 * @return True if conversion succeeded
+	 */
+	UFUNCTION(BlueprintCallable, Category = "AINiagara|DSL")
+	static bool ToJSONWithFormat(const FVFXDSL& DSL, EVFXDSLJsonFormat Format, FString& OutJsonString);
+
+	/**
+	 * Convert DSL to UTF-8 JSON bytes in the requested layout (for files and HTTP payloads)
+	 * @param DSL DSL structure to convert
+	 * @param Format Pretty or condensed output
+	 * @param OutBytes Output buffer, reset (keeping its allocation) and reserved up front
+	 * @return True if conversion succeeded
+	 */
+	static bool ToJSONUTF8(const FVFXDSL& DSL, EVFXDSLJsonFormat Format, TArray<uint8>& OutBytes);
+
+	/**
+	 * Convert DSL to JSON string by building a full FJsonObject DOM first.
+	 * Kept as the reference implementation for the streaming writer.
+	 * Emits render.mesh since the reflection-driven codec, so the baseline differs from earlier exports there.
+	 * @param DSL DSL structure to convert
+	 * @param OutJsonString Output JSON string
+	 * @return True if conversion succeeded
+	 */
+	static bool ToJSONDOM(const FVFXDSL& DSL, FString& OutJsonString);
+
+	/**
+	 * Estimate the serialized length of a DSL, used to size output buffers
+	 * @param DSL DSL structure that will be serialized
+	 * @param Format Output layout
+	 * @return Estimated number of characters (an upper bound for typical documents)
+	 */
+	static int32 EstimateJSONLength(const FVFXDSL& DSL, EVFXDSLJsonFormat Format);
+
+	/**
+	 * Convert effect type string to enum (case-insensitive, defaults to Niagara)
+	 */
+	static EVFXEffectType ParseEffectType(const FString& TypeString);
+
 private:
 	/**
 	 * Parse effect from JSON object
@@ -74,11 +140,6 @@ private:
 	 * Parse velocity from JSON object
 	 */
 	static bool ParseVelocity(const TSharedPtr<FJsonObject>& JsonObject, FVFXDSLVelocity& OutVelocity);
-
-	/**
-	 * Convert effect type string to enum
-	 */
-	static EVFXEffectType ParseEffectType(const FString& TypeString);
 };
 
 /**
@@ -93,11 +154,42 @@ public:
 	/**
 	 * Validate DSL structure
 	 * @param DSL DSL structure to validate
-	 * @return Validation result with errors if any
+	 * @return Validation result with error records and formatted messages
 	 */
 	UFUNCTION(BlueprintCallable, Category = "AINiagara|DSL")
 	static FVFXDSLValidationResult Validate(const FVFXDSL& DSL);
 
+	/**
+	 * Validate DSL structure, recording errors without formatting messages
+	 * @param DSL DSL structure to validate
+	 * @param OutResult Result to fill; reset first, its allocations are reused
+	 */
+	static void ValidateInto(const FVFXDSL& DSL, FVFXDSLValidationResult& OutResult);
+
+	/**
+	 * Validate many DSLs in parallel; messages are not formatted
+	 * @param DSLs DSLs to validate
+	 * @param OutResults One result per DSL, in the same order
+	 * @return Number of DSLs that failed validation
+	 */
+	static int32 ValidateBatch(TConstArrayView<FVFXDSL> DSLs, TArray<FVFXDSLValidationResult>& OutResults);
+
+	/**
+	 * Build the human-readable message for an error record
+	 */
+	UFUNCTION(BlueprintCallable, Category = "AINiagara|DSL")
+	static FString FormatError(const FVFXDSLValidationError& Error);
+
+	/**
+	 * Fill Result.ErrorMessages from Result.Errors
+	 */
+	static void FormatErrors(FVFXDSLValidationResult& Result);
+
+	/**
+	 * Dotted path of a field relative to its emitter (e.g. "Initialization.Color.R")
+	 */
+	static const TCHAR* GetFieldPath(EVFXDSLFieldId Field);
+
 	/**
 	 * Validate effect structure
 	 */
@@ -109,13 +201,13 @@ public:
 	static void ValidateEmitter(const FVFXDSLEmitter& Emitter, int32 EmitterIndex, FVFXDSLValidationResult& Result);
 
 	/**
-	 * Validate color values (0-1 range)
+	 * Validate color values (0-1 range, from the codec's ClampMin/ClampMax metadata)
 	 */
-	static void ValidateColor(const FVFXDSLColor& Color, const FString& Context, FVFXDSLValidationResult& Result);
+	static void ValidateColor(const FVFXDSLEmitter& Emitter, int32 EmitterIndex, FVFXDSLValidationResult& Result);
 
 	/**
-	 * Validate size values (must be positive)
+	 * Validate size values (must be positive, Min not above Max)
 	 */
-	static void ValidateSize(const FVFXDSLSize& Size, const FString& Context, FVFXDSLValidationResult& Result);
+	static void ValidateSize(const FVFXDSLEmitter& Emitter, int32 EmitterIndex, FVFXDSLValidationResult& Result);
 };
 
@@ -0,0 +1,122 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/VFXDSL.h"
+
+class FJsonValue;
+
+/**
+ * Operation performed by a single patch entry
+ */
+enum class EVFXDSLPatchOpType : uint8
+{
+	/** Change a field, a group of fields (object value) or replace a whole emitter */
+	Set,
+
+	/** Insert an emitter; "Emitters[-]" appends */
+	Add,
+
+	/** Remove an emitter */
+	Remove,
+
+	/** Move an emitter from "from" to "path" */
+	Move
+};
+
+/**
+ * One patch entry.
+ * Paths use the PropertyPath vocabulary of FVFXDSLDiffResult, e.g. "Effect.Duration"
+ * or "Emitters[0].Initialization.Color.R". Segments are matched case-insensitively,
+ * so the JSON key spelling ("emitters[0].initialization.color.r") works too, and
+ * an emitter may be addressed by name instead of index ("Emitters[Sparks].Name").
+ */
+struct AINIAGARA_API FVFXDSLPatchOp
+{
+	EVFXDSLPatchOpType Op = EVFXDSLPatchOpType::Set;
+
+	/** Target path */
+	FString Path;
+
+	/** Source emitter path for Move */
+	FString From;
+
+	/** New value for Set and Add: a scalar for fields, an object for groups and emitters */
+	TSharedPtr<FJsonValue> Value;
+};
+
+/**
+ * Incremental edit of a VFX DSL.
+ *
+ * Lets the LLM answer a refinement ("make it redder") with the handful of
+ * fields that change instead of regenerating the whole document:
+ * {"patch": [{"op": "set", "path": "Emitters[0].Initialization.Color.R", "value": 1.0}]}
+ *
+ * Patches are applied atomically: every op is applied to a copy, the copy is
+ * validated with UVFXDSLValidator, and the target is only replaced on success.
+ */
+struct AINIAGARA_API FVFXDSLPatch
+{
+	/** Ops, applied in order */
+	TArray<FVFXDSLPatchOp> Ops;
+
+	/**
+	 * Parse a patch document ({"patch": [...]})
+	 * @param JsonString JSON text whose root is the patch object
+	 * @param OutPatch Output patch
+	 * @param OutError Error message if parsing fails
+	 * @return True if every op is well-formed (paths are resolved when applying)
+	 */
+	static bool ParseFromJSON(const FString& JsonString, FVFXDSLPatch& OutPatch, FString& OutError);
+
+	/**
+	 * Serialize a patch as condensed JSON
+	 * @param Patch Patch to serialize
+	 * @param OutJsonString Output JSON string
+	 * @return True if serialization succeeded
+	 */
+	static bool ToJSON(const FVFXDSLPatch& Patch, FString& OutJsonString);
+
+	/**
+	 * Build the patch that turns OldDSL into NewDSL.
+	 * Emitters are paired with UVFXDSLDiff::MatchEmitters; removals, insertions and
+	 * moves come first, then field sets addressed by the final emitter index.
+	 * Float fields within the VFXDSLTolerance of UVFXDSLDiff are left out.
+	 */
+	static FVFXDSLPatch FromDiff(const FVFXDSL& OldDSL, const FVFXDSL& NewDSL);
+
+	/**
+	 * Apply a patch to a DSL
+	 * @param DSL DSL to patch; left untouched if any op fails or the result does not validate
+	 * @param Patch Patch to apply
+	 * @param OutError Error message naming the failing op, or the validation errors
+	 * @param OutValidation Optional validation result of the patched DSL
+	 * @return True if the patch was applied
+	 */
+	static bool ApplyPatch(FVFXDSL& DSL, const FVFXDSLPatch& Patch, FString& OutError, FVFXDSLValidationResult* OutValidation = nullptr);
+
+	/** Op name as written in patch JSON ("set", "add", "remove", "move") */
+	static const TCHAR* GetOpName(EVFXDSLPatchOpType Op);
+
+private:
+	/** Apply one op to the working copy */
+	static bool ApplyOp(FVFXDSL& DSL, const FVFXDSLPatchOp& Op, FString& OutError);
+
+	/** Set a field or, for object values, each of its sub-fields */
+	static bool ApplySet(FVFXDSL& DSL, const FString& Path, const TSharedPtr<FJsonValue>& Value, FString& OutError);
+
+	/**
+	 * Resolve "Emitters[<index>|<name>|-]" at the start of a path
+	 * @param Path Path to resolve
+	 * @param DSL DSL the index or name refers to
+	 * @param bAllowEnd Whether "-" and Num() (one past the last emitter) are accepted
+	 * @param OutIndex Resolved emitter index
+	 * @param OutSubPath Rest of the path after "Emitters[...]." or empty
+	 * @return True if the path starts with a valid emitter reference
+	 */
+	static bool ResolveEmitter(const FString& Path, const FVFXDSL& DSL, bool bAllowEnd, int32& OutIndex, FString& OutSubPath, FString& OutError);
+
+	/** Build an emitter from an emitter object value */
+	static bool MakeEmitter(const TSharedPtr<FJsonValue>& Value, FVFXDSLEmitter& OutEmitter, FString& OutError);
+};
@@ -0,0 +1,101 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/VFXDSL.h"
+#include "Serialization/JsonReader.h"
+
+struct FVFXDSLCodecTable;
+
+/**
+ * Single-pass VFX DSL parser built on the TJsonReader token stream.
+ *
+ * Fills FVFXDSL directly while reading, without building an intermediate
+ * FJsonObject DOM. Accepts the same documents and reports the same error
+ * strings as the DOM-based UVFXDSLParser::ParseFromJSONDOM. Effect and
+ * emitter objects are read through the FVFXDSLCodec field tables.
+ */
+class AINIAGARA_API FVFXDSLStreamParser
+{
+public:
+	/**
+	 * Parse DSL from JSON string
+	 * @param JsonString JSON string to parse
+	 * @param OutDSL Output DSL structure
+	 * @param OutError Error message if parsing fails
+	 * @return True if parsing succeeded
+	 */
+	static bool Parse(const FString& JsonString, FVFXDSL& OutDSL, FString& OutError);
+
+	/**
+	 * Parse a single emitter object, e.g. one element of the "emitters" array
+	 * @param JsonString JSON text whose root is the emitter object
+	 * @param OutEmitter Output emitter; fields missing from the JSON keep their current values
+	 * @return True if the text is a well-formed JSON object
+	 */
+	static bool ParseEmitter(FStringView JsonString, FVFXDSLEmitter& OutEmitter);
+
+	/**
+	 * Parse the "effect" object
+	 * @param JsonString JSON text whose root is the effect object
+	 * @param OutEffect Output effect; fields missing from the JSON keep their current values
+	 * @return True if the text is a well-formed JSON object
+	 */
+	static bool ParseEffect(FStringView JsonString, FVFXDSLEffect& OutEffect);
+
+private:
+	typedef TJsonReader<TCHAR> FReader;
+
+	/** Root-level bookkeeping used to reproduce the DOM parser's error precedence */
+	struct FRootState
+	{
+		bool bHasEffect = false;
+		bool bHasEmitters = false;
+		int32 NumEmitterValues = 0;
+		int32 FirstInvalidEmitterIndex = INDEX_NONE;
+	};
+
+	/** Read a standalone object with the given reader function and drain the reader */
+	template <typename StructType>
+	static bool ParseObject(FStringView JsonString, StructType& OutStruct, bool (*ReadFunction)(FReader&, StructType&));
+
+	/** Read the root object and drain the reader; returns false on malformed JSON */
+	static bool ReadRoot(FReader& Reader, FVFXDSL& OutDSL, FRootState& OutState);
+
+	/** Read the emitters array; the ArrayStart token has already been consumed */
+	static bool ReadEmitters(FReader& Reader, FVFXDSL& OutDSL, FRootState& OutState);
+
+	/** Object readers; the ObjectStart token has already been consumed */
+	static bool ReadEffect(FReader& Reader, FVFXDSLEffect& OutEffect);
+	static bool ReadEmitter(FReader& Reader, FVFXDSLEmitter& OutEmitter);
+
+	/**
+	 * Read the members of a struct node of a codec table; the ObjectStart token has already been consumed.
+	 * Keys are matched against the node's children; struct and array fields only take objects and arrays.
+	 */
+	static bool ReadStruct(FReader& Reader, const FVFXDSLCodecTable& Table, int32 NodeIndex, void* Base);
+
+	/** Read the value the reader is positioned on into one field */
+	static bool ReadField(FReader& Reader, EJsonNotation Notation, const FVFXDSLCodecTable& Table, int32 FieldIndex, void* Base);
+
+	/** Read the intervals array; the ArrayStart token has already been consumed */
+	static bool ReadFloatArray(FReader& Reader, TArray<float>& OutValues);
+
+	/**
+	 * Scalar accessors for the value the reader is positioned on.
+	 * The value is only assigned when it converts the way FJsonValue::TryGetNumber,
+	 * TryGetBool and TryGetString would; containers are skipped and left unassigned.
+	 * @return False only if the JSON itself is malformed
+	 */
+	static bool ReadFloat(FReader& Reader, EJsonNotation Notation, float& InOutValue);
+	static bool ReadInt32(FReader& Reader, EJsonNotation Notation, int32& InOutValue);
+	static bool ReadBool(FReader& Reader, EJsonNotation Notation, bool& InOutValue);
+	static bool ReadString(FReader& Reader, EJsonNotation Notation, FString& InOutValue);
+
+	/** Convert a scalar token to a number, mirroring FJsonValue::TryGetNumber */
+	static bool TryGetNumber(FReader& Reader, EJsonNotation Notation, double& OutValue);
+
+	/** Skip the value the reader is positioned on (objects and arrays are consumed) */
+	static bool SkipValue(FReader& Reader, EJsonNotation Notation);
+};
@@ -34,6 +34,24 @@ public:
 		const TArray<FConversationMessage>& ConversationHistory
 	);
 
+	/**
+	 * Build the system prompt for repairing a DSL: the format and its rules only, so the
+	 * fast model a correction is routed to reads a short context
+	 * @return System prompt string
+	 */
+	static FString BuildCorrectionSystemPrompt();
+
+	/**
+	 * Build the prompt asking for a DSL that failed validation to be corrected
+	 * @param InvalidDSL DSL JSON as it was parsed from the reply
+	 * @param ErrorMessages Validation errors to fix
+	 * @return Complete user prompt string
+	 */
+	static FString BuildDSLCorrectionPrompt(
+		const FString& InvalidDSL,
+		const TArray<FString>& ErrorMessages
+	);
+
 	/**
 	 * Get available tool functions for LLM
 	 * @return Array of tool function definitions
@@ -72,5 +90,10 @@ private:
 	 * Build 3D model handling instructions
 	 */
 	static FString Build3DModelInstructions();
+
+	/**
+	 * Build instructions for answering refinements with a DSL patch
+	 */
+	static FString BuildPatchInstructions();
 };
 
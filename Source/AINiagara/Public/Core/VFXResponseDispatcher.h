@@ -0,0 +1,170 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/VFXDSL.h"
+#include "Core/VFXDSLPatch.h"
+
+class FJsonObject;
+
+/**
+ * What an LLM reply turned out to contain
+ */
+enum class EVFXResponseKind : uint8
+{
+	/** Plain text, or JSON that is neither a tool call nor a DSL */
+	Text,
+
+	/** A function call ("functionCall" object, bare or inside a "candidates" envelope) */
+	ToolCall,
+
+	/** A VFX DSL document that parsed successfully */
+	DSL,
+
+	/** A patch ({"patch": [...]}) against the current DSL that parsed successfully */
+	Patch
+};
+
+/**
+ * Result of classifying a single reply
+ */
+struct AINIAGARA_API FVFXClassifiedResponse
+{
+	EVFXResponseKind Kind = EVFXResponseKind::Text;
+
+	/** Tool name (e.g. "tool:texture") when Kind is ToolCall */
+	FString ToolName;
+
+	/** Tool arguments when Kind is ToolCall; may be null if the call had no args */
+	TSharedPtr<FJsonObject> ToolArgs;
+
+	/** Parsed DSL when Kind is DSL */
+	FVFXDSL DSL;
+
+	/** Parsed patch when Kind is Patch; apply it with FVFXDSLPatch::ApplyPatch */
+	FVFXDSLPatch Patch;
+
+	/** Parse error of the last JSON block that looked like a DSL or patch but failed to parse */
+	FString DSLError;
+
+	/** Offset and length of the JSON block that was routed, INDEX_NONE if none */
+	int32 JsonStart = INDEX_NONE;
+	int32 JsonLength = 0;
+
+	/** Characters handed to a JSON parser for this reply */
+	int32 NumParsedChars = 0;
+
+	/** Characters the previous ProcessToolCalls + ParseFromJSON sequence handed to JSON parsers */
+	int32 NumLegacyParsedChars = 0;
+};
+
+/**
+ * Result of processing a reply: classified, patched against the current DSL and validated
+ */
+struct AINIAGARA_API FVFXProcessedResponse
+{
+	/** Classification; a patch that applied leaves the patched DSL here with Kind set to DSL */
+	FVFXClassifiedResponse Classified;
+
+	/** The reply was a patch */
+	bool bWasPatch = false;
+
+	/** Message for a patch that could not be applied; Kind stays Patch */
+	FString PatchError;
+
+	/** Validation of Classified.DSL with formatted messages, when Kind is DSL */
+	FVFXDSLValidationResult Validation;
+
+	/** Seconds spent classifying, patching and validating */
+	double ProcessSeconds = 0.0;
+};
+
+/**
+ * Classifies LLM replies with a single JSON parse.
+ *
+ * A structural scanner locates JSON objects embedded anywhere in the reply
+ * (markdown fences, surrounding prose) and records each candidate's root-level
+ * keys without building anything. Only the first candidate whose root keys
+ * identify it is parsed, and only once: tool calls and patches, which are small,
+ * go through FJsonSerializer; DSL documents go through UVFXDSLParser::ParseFromJSON.
+ */
+class AINIAGARA_API FVFXResponseDispatcher
+{
+public:
+	/**
+	 * Classify a reply and parse its payload
+	 * @param ResponseText Reply text as returned by the API client
+	 * @param OutResponse Classification, payload and instrumentation counters
+	 */
+	static void Classify(const FString& ResponseText, FVFXClassifiedResponse& OutResponse);
+
+	/**
+	 * Find the next complete JSON object in free-form text
+	 * @param Text Text to search
+	 * @param SearchStart Offset to start searching from
+	 * @param OutStart Offset of the opening brace
+	 * @param OutLength Length of the object including both braces
+	 * @return True if a complete, plausibly well-formed object was found
+	 */
+	static bool FindJsonObject(FStringView Text, int32 SearchStart, int32& OutStart, int32& OutLength);
+
+	/**
+	 * Whether a reply is worth showing: a DSL or patch block must parse and a DSL must pass
+	 * UVFXDSLValidator; text and tool calls are accepted.
+	 * Thread-safe, so it can pick among the candidates of a reply in parallel.
+	 */
+	static bool IsUsableReply(const FString& ResponseText);
+
+	/**
+	 * Classify a reply, apply it if it is a patch, and validate the resulting DSL.
+	 * Touches no UObject, so it is safe on any thread.
+	 * @param ResponseText Reply text as returned by the API client
+	 * @param BaseDSL DSL a patch applies to, or nullptr if there is none
+	 * @param OutResponse Processed reply
+	 */
+	static void Process(const FString& ResponseText, const FVFXDSL* BaseDSL, FVFXProcessedResponse& OutResponse);
+
+	/**
+	 * Process a reply on a UE::Tasks worker, then hand the result to the game thread,
+	 * where only asset creation and UI updates are left to do
+	 * @param ResponseText Reply text as returned by the API client
+	 * @param BaseDSL DSL a patch applies to, or nullptr; it is copied before this returns
+	 * @param OnProcessed Called on the game thread with the processed reply
+	 */
+	static void ProcessAsync(const FString& ResponseText, const FVFXDSL* BaseDSL, TFunction<void(FVFXProcessedResponse&)> OnProcessed);
+
+	/** Human-readable kind name for logs and UI */
+	static const TCHAR* GetKindName(EVFXResponseKind Kind);
+
+private:
+	/** Root-level keys the scanner looks for */
+	enum ERootKey : uint8
+	{
+		RootKey_None = 0,
+		RootKey_FunctionCall = 1 << 0,
+		RootKey_Candidates = 1 << 1,
+		RootKey_Effect = 1 << 2,
+		RootKey_Emitters = 1 << 3,
+		RootKey_Patch = 1 << 4
+	};
+
+	/** FindJsonObject that also reports the object's root keys and end offset */
+	static bool FindObject(FStringView Text, int32 SearchStart, int32& OutStart, int32& OutEnd, uint8& OutRootKeys);
+
+	/**
+	 * Scan an object starting at an opening brace
+	 * @param Text Text to scan
+	 * @param Start Offset of the opening brace
+	 * @param OutEnd Offset of the matching closing brace
+	 * @param OutRootKeys Combination of ERootKey flags found at the object's root
+	 * @return False if the object is not closed (OutEnd is INDEX_NONE) or its root is not a key/value list
+	 */
+	static bool ScanObject(FStringView Text, int32 Start, int32& OutEnd, uint8& OutRootKeys);
+
+	/**
+	 * Extract a function call from a parsed tool-call object
+	 * @return True if a "functionCall" with a name was found
+	 */
+	static bool ExtractToolCall(const TSharedPtr<FJsonObject>& JsonObject, FString& OutName, TSharedPtr<FJsonObject>& OutArgs);
+};
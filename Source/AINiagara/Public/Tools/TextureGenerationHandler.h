@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Engine/Texture2D.h"
 #include "UObject/NoExportTypes.h"
+#include "Core/GeminiRequestScheduler.h"
 #include "TextureGenerationHandler.generated.h"
 
 /**
@@ -52,7 +53,7 @@ struct FTextureGenerationResult
 	UPROPERTY()
 	TObjectPtr<UTexture2D> Texture = nullptr;
 
-	/** Base64-encoded PNG data (for debugging/export) */
+	/** Base64-encoded PNG data (for debugging/export); left empty by generation, which decodes the reply bytes in place */
 	UPROPERTY()
 	FString Base64Data;
 
@@ -69,6 +70,18 @@ struct FTextureGenerationResult
 	int32 FrameCount = 1;
 };
 
+/**
+ * Pixels decoded from a generated image, ready to be copied into a texture
+ */
+struct FTextureImageData
+{
+	int32 Width = 0;
+	int32 Height = 0;
+
+	/** Width * Height pixels, 8-bit BGRA */
+	TArray64<uint8> BGRA;
+};
+
 /**
  * Delegate called when texture generation completes
  */
@@ -132,6 +145,64 @@ public:
 		UTexture2D*& OutTexture
 	);
 
+	/**
+	 * Find the base64 image in an Imagen reply ("predictions" or "candidates" format) or an images/generations reply ("data"). Thread-safe.
+	 * @param ResponseText Reply JSON
+	 * @param OutBase64 Base64-encoded image
+	 * @param OutError Why no image was found
+	 * @return True if an image was found
+	 */
+	static bool ExtractImageBase64(const FString& ResponseText, FString& OutBase64, FString& OutError);
+
+	/**
+	 * Decode PNG bytes to BGRA pixels. Off the game thread the ImageWrapper module is
+	 * only looked up, so load it on the game thread before calling this from a worker.
+	 * @param PNGData Raw PNG bytes
+	 * @param OutImage Decoded pixels
+	 * @return True if the PNG was decoded
+	 */
+	static bool DecodePNG(TConstArrayView<uint8> PNGData, FTextureImageData& OutImage);
+
+	/**
+	 * Locate the base64 image in the UTF-8 bytes of an Imagen or images/generations reply without parsing or copying it
+	 * @param Content Reply body as received
+	 * @param OutStart Offset of the first base64 character
+	 * @param OutLength Number of base64 characters
+	 * @param bOutEscaped The value contains JSON escapes and cannot be decoded as it lies
+	 * @return True if an image value was found
+	 */
+	static bool FindImageBase64(TConstArrayView<uint8> Content, int32& OutStart, int32& OutLength, bool& bOutEscaped);
+
+	/**
+	 * Decode the image of an Imagen reply straight from its bytes: the base64 value is decoded
+	 * where it lies into a buffer reused by the calling thread, then decoded to pixels.
+	 * Thread-safe under the same condition as DecodePNG.
+	 * @param Content Reply body as received
+	 * @param OutImage Decoded pixels
+	 * @param OutError Why the reply could not be decoded
+	 * @return True if the image was decoded
+	 */
+	static bool DecodeImageContent(TConstArrayView<uint8> Content, FTextureImageData& OutImage, FString& OutError);
+
+	/**
+	 * Everything between an Imagen reply and its pixels: JSON, base64 and PNG decoding.
+	 * Thread-safe under the same condition as DecodePNG.
+	 * @param ResponseText Reply JSON
+	 * @param OutBase64 Base64-encoded image, kept for FTextureGenerationResult
+	 * @param OutImage Decoded pixels
+	 * @param OutError Why the reply could not be decoded
+	 * @return True if the image was decoded
+	 */
+	static bool DecodeImageResponse(const FString& ResponseText, FString& OutBase64, FTextureImageData& OutImage, FString& OutError);
+
+	/**
+	 * Create a transient texture from decoded pixels. Game thread only.
+	 * @param Image Decoded pixels
+	 * @param TextureName Name for logs
+	 * @return The texture, or nullptr if it could not be created
+	 */
+	static UTexture2D* CreateTextureFromImage(const FTextureImageData& Image, const FString& TextureName);
+
 	/**
 	 * Create a flipbook atlas texture from multiple frames
 	 * @param FrameTextures Array of frame textures
@@ -173,11 +244,13 @@ private:
 	 * @param Request Generation parameters
 	 * @param FrameIndex Frame index (for flipbooks)
 	 * @param OnComplete Callback when complete
+	 * @param Priority Scheduler priority (flipbook frames queue behind interactive requests)
 	 */
 	static void GenerateSingleFrame(
 		const FTextureGenerationRequest& Request,
 		int32 FrameIndex,
-		FOnTextureGenerated OnComplete
+		FOnTextureGenerated OnComplete,
+		EGeminiRequestPriority Priority = EGeminiRequestPriority::Tool
 	);
 };
 
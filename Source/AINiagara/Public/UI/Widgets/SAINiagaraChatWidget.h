@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Widgets/SCompoundWidget.h"
 #include "Widgets/DeclarativeSyntaxSupport.h"
+#include "Core/GeminiRequestHandle.h"
 
 class SScrollBox;
 class SEditableTextBox;
@@ -13,6 +14,8 @@ class SProgressBar;
 class STextBlock;
 class SBorder;
 class UPreviewSystemManager;
+struct FVFXProcessedResponse;
+struct FMeshDetectionResult;
 
 /**
  * Chat widget for AI VFX generation
@@ -28,6 +31,9 @@ public:
 
 	void Construct(const FArguments& InArgs);
 
+	/** Cancels the request in flight so its reply is not delivered to a closed tab */
+	virtual ~SAINiagaraChatWidget();
+
 private:
 	/** Message history scroll box */
 	TSharedPtr<SScrollBox> MessageHistoryBox;
@@ -59,11 +65,29 @@ private:
 	/** Current asset path */
 	FString CurrentAssetPath;
 
+	/** Latest chat request; cancelled when a new prompt supersedes it or the widget closes */
+	FGeminiRequestHandle ActiveRequest;
+
+	/** Incremented for every prompt; replies still being processed for an older prompt are dropped */
+	uint32 ChatRequestSerial = 0;
+
+	/** Corrections asked for since the latest prompt, limited by the settings */
+	int32 NumCorrectionAttempts = 0;
+
 	/**
 	 * Handle send button click
 	 */
 	FReply OnSendClicked();
 
+	/**
+	 * Act on a reply processed by FVFXResponseDispatcher::ProcessAsync: run its tool call,
+	 * or generate the system from its validated DSL. Runs on the game thread.
+	 * @param Processed Classified, patched and validated reply
+	 * @param bMeshDetected Whether the prompt asked for a mesh
+	 * @param MeshResult Mesh detected in the prompt
+	 */
+	void HandleProcessedResponse(FVFXProcessedResponse& Processed, bool bMeshDetected, const FMeshDetectionResult& MeshResult);
+
 	/**
 	 * Handle export DSL button click
 	 */
@@ -99,6 +123,16 @@ private:
 	 */
 	bool bHasLoadedDSL = false;
 
+	/**
+	 * Latest valid DSL from a reply or an import; patch replies are applied to it
+	 */
+	FVFXDSL LastDSL;
+
+	/**
+	 * Whether LastDSL holds a DSL
+	 */
+	bool bHasLastDSL = false;
+
 	/**
 	 * Handle enter key in input box
 	 */
@@ -135,7 +169,10 @@ private:
 	FString GetCurrentAssetPath() const;
 
 	/**
-	 * Request DSL correction from LLM
+	 * Send a DSL that failed validation back for repair, on the backend and model the
+	 * settings route corrections to; the reply is handled like any other
+	 * @param InvalidDSL DSL JSON that failed validation
+	 * @param ValidationResult Its validation errors
 	 */
 	void RequestDSLCorrection(const FString& InvalidDSL, const FVFXDSLValidationResult& ValidationResult);
 
@@ -165,11 +202,12 @@ private:
 	FText GetPreviewToggleText() const;
 
 	/**
-	 * Detect and process tool calls in AI response
-	 * @param ResponseText AI response text
-	 * @return True if tool call was detected and processed
+	 * Route a tool call found by FVFXResponseDispatcher to its handler
+	 * @param ToolName Tool function name (e.g., "tool:texture")
+	 * @param ToolArgs Tool call parameters JSON
+	 * @return True if the tool is supported and was processed
 	 */
-	bool ProcessToolCalls(const FString& ResponseText);
+	bool DispatchToolCall(const FString& ToolName, TSharedPtr<FJsonObject> ToolArgs);
 
 	/**
 	 * Process texture generation tool call
@@ -135,4 +135,39 @@ bool FAINiagaraSettingsMaskedAPIKeyTest::RunTest(const FString& Parameters)
 	return true;
 }
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FAINiagaraSettingsModelRoutingTest,
+	"AINiagara.Settings.ModelRouting",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FAINiagaraSettingsModelRoutingTest::RunTest(const FString& Parameters)
+{
+	UAINiagaraSettings* Settings = UAINiagaraSettings::Get();
+	TestNotNull(TEXT("Settings should exist"), Settings);
+
+	if (!Settings)
+	{
+		return false;
+	}
+
+	// There is no backend setting for corrections, only a model tier, so they share the chat backend
+	TestEqual(TEXT("Corrections use the chat backend"), Settings->GetBackendForTask(ELLMTask::Correction), Settings->GetBackendForTask(ELLMTask::Chat));
+	TestEqual(TEXT("Textures use the image model"), Settings->GetModelTierForTask(ELLMTask::Texture), ELLMModelTier::Large);
+
+	for (ELLMTask Task : { ELLMTask::Chat, ELLMTask::Shader, ELLMTask::Correction })
+	{
+		const ELLMModelTier Tier = Settings->GetModelTierForTask(Task);
+		const FString Expected = Settings->GetBackendForTask(Task) == ELLMBackendType::Gemini
+			? Settings->GetGeminiModel(Tier)
+			: (Tier == ELLMModelTier::Fast ? Settings->GetLocalFastChatModel() : Settings->GetLocalChatModel());
+		TestEqual(TEXT("Model follows the backend and tier of the task"), Settings->GetChatModelForTask(Task), Expected);
+		TestFalse(TEXT("Every task has a model"), Settings->GetChatModelForTask(Task).IsEmpty());
+	}
+
+	TestTrue(TEXT("Correction attempts are bounded"), Settings->GetMaxDSLCorrectionAttempts() >= 0 && Settings->GetMaxDSLCorrectionAttempts() <= 5);
+
+	return true;
+}
+
 #endif // WITH_DEV_AUTOMATION_TESTS
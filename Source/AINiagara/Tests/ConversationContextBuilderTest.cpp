@@ -0,0 +1,204 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/ConversationContextBuilder.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Recorded reply to "Make a campfire" */
+	const TCHAR* RecordedCampfireDSL = TEXT(R"({"effect": {"type": "Niagara", "duration": 4.0, "looping": true}, "emitters": [{"name": "Flames", "spawners": {"rate": {"spawnRate": 30}}}, {"name": "Smoke", "update": {"drag": 0.4}}]})");
+
+	/** Recorded reply to "Add sparks" */
+	const TCHAR* RecordedSparksDSL = TEXT(R"({"effect": {"type": "Niagara", "duration": 4.0, "looping": true}, "emitters": [{"name": "Flames", "spawners": {"rate": {"spawnRate": 30}}}, {"name": "Smoke", "update": {"drag": 0.4}}, {"name": "Sparks", "spawners": {"burst": {"count": 25, "time": 0.0}}}]})");
+
+	/** Alternating user/assistant turns of about 100 estimated tokens each, with a short first line */
+	TArray<FConversationMessage> MakeHistory(int32 NumMessages)
+	{
+		TArray<FConversationMessage> History;
+		for (int32 Index = 0; Index < NumMessages; ++Index)
+		{
+			FString Content = FString::Printf(TEXT("Turn %d: make the embers drift slower.\n"), Index);
+			while (Content.Len() < 400)
+			{
+				Content += TEXT("Keep the smoke soft and the sparks short lived. ");
+			}
+			History.Add(FConversationMessage((Index % 2) ? TEXT("assistant") : TEXT("user"), Content));
+		}
+		return History;
+	}
+
+	FConversationContextOptions MakeOptions(int32 TokenBudget = 1500, int32 MaxSummaryTokens = 300)
+	{
+		FConversationContextOptions Options;
+		Options.TokenBudget = TokenBudget;
+		Options.MinRecentMessages = 4;
+		Options.MaxSummaryTokens = MaxSummaryTokens;
+		return Options;
+	}
+
+	bool ContainsContent(const TArray<FConversationMessage>& Messages, const FString& Content)
+	{
+		return Messages.ContainsByPredicate([&Content](const FConversationMessage& Message) { return Message.Content == Content; });
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FConversationContextBuilderPassthroughTest,
+	"AINiagara.ConversationContextBuilder.UnderBudget",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FConversationContextBuilderPassthroughTest::RunTest(const FString& Parameters)
+{
+	FConversationContextBuilder Builder;
+	const TArray<FConversationMessage> History = MakeHistory(6);
+
+	TArray<FConversationMessage> Context;
+	FConversationContextStats Stats;
+	Builder.Build(TEXT("/Game/VFX/Fire"), History, MakeOptions(), Context, Stats);
+
+	TestEqual(TEXT("Every message is sent"), Context.Num(), History.Num());
+	TestEqual(TEXT("Nothing summarized"), Stats.NumSummarizedMessages, 0);
+	TestEqual(TEXT("Nothing saved"), Stats.GetTokensSaved(), 0);
+	TestTrue(TEXT("Messages are unchanged"), Context.Num() == History.Num() && Context.Last().Content == History.Last().Content);
+
+	Builder.Build(TEXT("/Game/VFX/Empty"), TArray<FConversationMessage>(), MakeOptions(), Context, Stats);
+	TestEqual(TEXT("Empty history gives an empty context"), Context.Num(), 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FConversationContextBuilderBudgetTest,
+	"AINiagara.ConversationContextBuilder.Budget",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FConversationContextBuilderBudgetTest::RunTest(const FString& Parameters)
+{
+	FConversationContextBuilder Builder;
+	TArray<FConversationMessage> History = MakeHistory(60);
+	History.Insert(FConversationMessage(TEXT("system"), TEXT("You are a VFX assistant. Reply with a VFX DSL.")), 0);
+	const FConversationContextOptions Options = MakeOptions();
+
+	TArray<FConversationMessage> Context;
+	FConversationContextStats Stats;
+	Builder.Build(TEXT("/Game/VFX/Fire"), History, Options, Context, Stats);
+
+	TestTrue(TEXT("History exceeds the budget"), Stats.FullTokens > Options.TokenBudget);
+	TestTrue(TEXT("Context fits the budget"), Stats.ContextTokens <= Options.TokenBudget);
+	TestTrue(TEXT("Tokens are saved"), Stats.GetTokensSaved() > 0);
+	TestTrue(TEXT("Older messages are summarized"), Stats.NumSummarizedMessages > 0);
+	TestEqual(TEXT("Every message is either kept or summarized"), Stats.NumKeptMessages + Stats.NumSummarizedMessages, History.Num());
+
+	if (Context.Num() < 3)
+	{
+		AddError(TEXT("Context is missing messages"));
+		return false;
+	}
+
+	TestEqual(TEXT("System prompt comes first"), Context[0].Role, FString(TEXT("system")));
+	TestTrue(TEXT("Summary follows the system prompt"), Context[1].Content.StartsWith(TEXT("Summary of the earlier conversation")));
+	TestTrue(TEXT("Summary respects its limit"), FConversationContextBuilder::EstimateTokens(Context[1]) <= Options.MaxSummaryTokens);
+
+	for (int32 Offset = 1; Offset <= Options.MinRecentMessages; ++Offset)
+	{
+		TestEqual(FString::Printf(TEXT("Recent message %d is verbatim"), Offset),
+			Context[Context.Num() - Offset].Content, History[History.Num() - Offset].Content);
+	}
+
+	// Past the budget the recent messages are still sent
+	FConversationContextOptions Tight = Options;
+	Tight.TokenBudget = 10;
+	Builder.Build(TEXT("/Game/VFX/Fire"), History, Tight, Context, Stats);
+	TestTrue(TEXT("Minimum window is kept"), Context.Num() >= Tight.MinRecentMessages);
+	TestEqual(TEXT("Newest message is kept"), Context.Last().Content, History.Last().Content);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FConversationContextBuilderPinnedDSLTest,
+	"AINiagara.ConversationContextBuilder.PinsLatestDSL",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FConversationContextBuilderPinnedDSLTest::RunTest(const FString& Parameters)
+{
+	FConversationContextBuilder Builder;
+	const FString OldDSL(RecordedCampfireDSL);
+	const FString LatestDSL(RecordedSparksDSL);
+
+	TArray<FConversationMessage> History;
+	History.Add(FConversationMessage(TEXT("user"), TEXT("Make a campfire")));
+	History.Add(FConversationMessage(TEXT("assistant"), OldDSL));
+	History.Add(FConversationMessage(TEXT("user"), TEXT("Add sparks")));
+	History.Add(FConversationMessage(TEXT("assistant"), LatestDSL));
+	History.Append(MakeHistory(40));
+
+	// Room for the pinned DSL and a window that no longer reaches the first turns
+	const FConversationContextOptions Options = MakeOptions(4000, 600);
+
+	TArray<FConversationMessage> Context;
+	FConversationContextStats Stats;
+	Builder.Build(TEXT("/Game/VFX/Fire"), History, Options, Context, Stats);
+
+	TestEqual(TEXT("Latest DSL is pinned"), Stats.NumPinnedMessages, 1);
+	TestTrue(TEXT("Latest DSL is sent verbatim"), ContainsContent(Context, LatestDSL));
+	TestFalse(TEXT("Older DSL is not sent verbatim"), ContainsContent(Context, OldDSL));
+	TestTrue(TEXT("Context fits the budget"), Stats.ContextTokens <= Options.TokenBudget);
+
+	if (Context.Num() > 1)
+	{
+		TestTrue(TEXT("Summary comes first"), Context[0].Content.StartsWith(TEXT("Summary of the earlier conversation")));
+		TestTrue(TEXT("Summary describes the older DSL"), Context[0].Content.Contains(TEXT("effect DSL with 2 emitters (Emitter_0, Emitter_1)")));
+		TestTrue(TEXT("Summary quotes the user"), Context[0].Content.Contains(TEXT("- User: Make a campfire")));
+		TestEqual(TEXT("Pinned DSL follows the summary"), Context[1].Content, LatestDSL);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FConversationContextBuilderCacheTest,
+	"AINiagara.ConversationContextBuilder.SummaryCache",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FConversationContextBuilderCacheTest::RunTest(const FString& Parameters)
+{
+	FConversationContextBuilder Builder;
+	TArray<FConversationMessage> History = MakeHistory(40);
+
+	TArray<FConversationMessage> Context;
+	FConversationContextStats Stats;
+	Builder.Build(TEXT("/Game/VFX/Fire"), History, MakeOptions(), Context, Stats);
+	TestEqual(TEXT("First build classifies every message"), Builder.GetNumClassifiedMessages(), 40);
+	const FString FirstSummary = Context.Num() > 0 ? Context[0].Content : FString();
+
+	Builder.Build(TEXT("/Game/VFX/Fire"), History, MakeOptions(), Context, Stats);
+	TestEqual(TEXT("Unchanged history is not classified again"), Builder.GetNumClassifiedMessages(), 40);
+	TestEqual(TEXT("Same summary"), Context.Num() > 0 ? Context[0].Content : FString(), FirstSummary);
+
+	History.Append(MakeHistory(2));
+	Builder.Build(TEXT("/Game/VFX/Fire"), History, MakeOptions(), Context, Stats);
+	TestEqual(TEXT("Only new messages are classified"), Builder.GetNumClassifiedMessages(), 42);
+
+	// A replaced history (cleared, or loaded from disk) must not reuse the old summary
+	TArray<FConversationMessage> Replaced = MakeHistory(40);
+	Replaced[0].Timestamp = History[0].Timestamp + FTimespan::FromMinutes(1.0);
+	Builder.Build(TEXT("/Game/VFX/Fire"), Replaced, MakeOptions(), Context, Stats);
+	TestEqual(TEXT("Replaced history is classified again"), Builder.GetNumClassifiedMessages(), 82);
+
+	Builder.Build(TEXT("/Game/VFX/Smoke"), History, MakeOptions(), Context, Stats);
+	TestEqual(TEXT("Summaries are kept per asset"), Builder.GetNumClassifiedMessages(), 124);
+
+	Builder.Reset();
+	TestEqual(TEXT("Reset clears the counter"), Builder.GetNumClassifiedMessages(), 0);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
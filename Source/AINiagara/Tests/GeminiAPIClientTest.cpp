@@ -1,11 +1,75 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "Misc/ScopeLock.h"
 #include "Core/GeminiAPIClient.h"
+#include "Core/GeminiResponseCache.h"
 #include "Core/AINiagaraSettings.h"
+#include "Core/NiagaraSystemGenerator.h"
+#include "Core/VFXResponseDispatcher.h"
+#include "NiagaraSystem.h"
+#include "GeminiTestHelpers.h"
+#include "VFXDSLTestHelpers.h"
 
 #if WITH_DEV_AUTOMATION_TESTS
 
+namespace
+{
+	/** What one request to the loopback reported */
+	struct FLoopbackOutcome
+	{
+		FString Response;
+		int32 ErrorCode = 0;
+		bool bDone = false;
+		double StartSeconds = 0.0;
+		double ElapsedSeconds = 0.0;
+	};
+
+	FOnGeminiResponse MakeResponseDelegate(TSharedRef<FLoopbackOutcome> Outcome)
+	{
+		return FOnGeminiResponse::CreateLambda([Outcome](const FString& ResponseText)
+		{
+			Outcome->Response = ResponseText;
+			Outcome->ElapsedSeconds = FPlatformTime::Seconds() - Outcome->StartSeconds;
+			Outcome->bDone = true;
+		});
+	}
+
+	FOnGeminiError MakeErrorDelegate(TSharedRef<FLoopbackOutcome> Outcome)
+	{
+		return FOnGeminiError::CreateLambda([Outcome](int32 ErrorCode, const FString& ErrorMessage)
+		{
+			Outcome->ErrorCode = ErrorCode;
+			Outcome->ElapsedSeconds = FPlatformTime::Seconds() - Outcome->StartSeconds;
+			Outcome->bDone = true;
+		});
+	}
+
+	/** Send a chat request from a client that goes out of scope before the reply arrives */
+	TSharedRef<FLoopbackOutcome> SendLoopbackChat(const FString& BaseURL, const FString& Prompt, const FGeminiRequestOptions& Options = FGeminiRequestOptions())
+	{
+		TSharedRef<FLoopbackOutcome> Outcome = MakeShared<FLoopbackOutcome>();
+		Outcome->StartSeconds = FPlatformTime::Seconds();
+
+		TArray<FConversationMessage> History;
+		History.Add(FConversationMessage(TEXT("user"), TEXT("Use warm colors")));
+
+		FGeminiAPIClient Client;
+		Client.SetAPIKey(TEXT("loopback-key"), false);
+		Client.SetBaseURL(BaseURL);
+		Client.SendChatCompletion(Prompt, History, TArray<FVFXToolFunction>(), MakeResponseDelegate(Outcome), MakeErrorDelegate(Outcome), Options);
+		return Outcome;
+	}
+
+	/** Whether a request started by an earlier latent step has finished or timed out */
+	bool IsFinished(const TSharedPtr<FLoopbackOutcome>& Outcome)
+	{
+		return !Outcome.IsValid() || Outcome->bDone || FPlatformTime::Seconds() - Outcome->StartSeconds > 10.0;
+	}
+}
+
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(
 	FGeminiAPIClientBasicTest,
 	"AINiagara.GeminiAPIClient.BasicFunctionality",
@@ -149,4 +213,348 @@ bool FGeminiAPIClientEdgeCasesTest::RunTest(const FString& Parameters)
 	return true;
 }
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiAPIClientLoopbackTest,
+	"AINiagara.GeminiAPIClient.Loopback",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiAPIClientLoopbackTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+	Server->SetTextReply(TEXT("A warm campfire"));
+
+	TSharedRef<FLoopbackOutcome> Chat = SendLoopbackChat(Server->GetBaseURL(), TEXT("Make a campfire"));
+
+	TSharedRef<FLoopbackOutcome> Texture = MakeShared<FLoopbackOutcome>();
+	Texture->StartSeconds = FPlatformTime::Seconds();
+	{
+		FGeminiAPIClient Client;
+		Client.SetAPIKey(TEXT("loopback-key"), false);
+		Client.SetBaseURL(Server->GetBaseURL());
+		Client.GenerateTexture(TEXT("Soft fire noise"), TEXT("noise"), 256, MakeResponseDelegate(Texture), MakeErrorDelegate(Texture));
+	}
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Chat, Texture]()
+	{
+		if (!IsFinished(Chat) || !IsFinished(Texture))
+		{
+			return false;
+		}
+
+		TestEqual(TEXT("Chat reply"), Chat->Response, FString(TEXT("A warm campfire")));
+		TestEqual(TEXT("Texture reply"), Texture->Response, FString(TEXT("A warm campfire")));
+		TestEqual(TEXT("Both requests reached the loopback"), Server->GetNumRequests(), 2);
+		AddInfo(FString::Printf(TEXT("Chat round trip %.2f ms, texture round trip %.2f ms"), Chat->ElapsedSeconds * 1000.0, Texture->ElapsedSeconds * 1000.0));
+		return true;
+	}));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiAPIClientLoopbackPayloadTest,
+	"AINiagara.GeminiAPIClient.LoopbackPayload",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiAPIClientLoopbackPayloadTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+	Server->SetTextReply(TEXT("OK"));
+
+	TSharedRef<FLoopbackOutcome> Outcome = SendLoopbackChat(Server->GetBaseURL(), TEXT("Make a campfire"));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Outcome]()
+	{
+		if (!IsFinished(Outcome))
+		{
+			return false;
+		}
+
+		// The request body is what BuildChatCompletionPayload produced: history first, then the prompt
+		TSharedPtr<FJsonObject> Payload;
+		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Server->GetLastRequestBody());
+		const TArray<TSharedPtr<FJsonValue>>* Contents = nullptr;
+		if (!TestTrue(TEXT("Payload is JSON"), FJsonSerializer::Deserialize(Reader, Payload) && Payload.IsValid())
+			|| !TestTrue(TEXT("Payload has contents"), Payload->TryGetArrayField(TEXT("contents"), Contents)))
+		{
+			return true;
+		}
+
+		TestEqual(TEXT("History and prompt"), Contents->Num(), 2);
+		if (Contents->Num() == 2)
+		{
+			const TSharedPtr<FJsonObject> Prompt = (*Contents)[1]->AsObject();
+			TestEqual(TEXT("Prompt role"), Prompt->GetStringField(TEXT("role")), FString(TEXT("user")));
+			TestEqual(TEXT("Prompt text"), Prompt->GetArrayField(TEXT("parts"))[0]->AsObject()->GetStringField(TEXT("text")), FString(TEXT("Make a campfire")));
+		}
+		TestFalse(TEXT("API key is not in the body"), Server->GetLastRequestBody().Contains(TEXT("loopback-key")));
+		return true;
+	}));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiAPIClientLoopbackRecordingTest,
+	"AINiagara.GeminiAPIClient.LoopbackRecording",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiAPIClientLoopbackRecordingTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+
+	// Record through the response cache into a transient folder
+	const FString RecordingDirectory = FPaths::AutomationTransientDir() / TEXT("LoopbackRecording");
+	IFileManager::Get().DeleteDirectory(*RecordingDirectory, false, true);
+
+	FGeminiResponseCache& Cache = FGeminiResponseCache::Get();
+	const FString PreviousDirectory = Cache.GetDirectory();
+	const EGeminiResponseCacheMode PreviousMode = Cache.GetMode();
+	Cache.SetDirectory(RecordingDirectory);
+	Cache.SetMode(EGeminiResponseCacheMode::ReadWrite);
+
+	Server->SetTextReply(TEXT("Recorded campfire"));
+	TSharedRef<TSharedPtr<FLoopbackOutcome>> Current = MakeShared<TSharedPtr<FLoopbackOutcome>>(SendLoopbackChat(Server->GetBaseURL(), TEXT("Make a campfire")));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Current, RecordingDirectory]()
+	{
+		if (!IsFinished(*Current))
+		{
+			return false;
+		}
+		TestEqual(TEXT("Live reply"), (*Current)->Response, FString(TEXT("Recorded campfire")));
+
+		// Serve the recording with the cache out of the way; anything else would fail
+		FGeminiResponseCache::Get().SetMode(EGeminiResponseCacheMode::Disabled);
+		Server->SetReply(500, TEXT("application/json"), TEXT("{\"error\": {\"code\": 500}}"));
+		Server->SetRecordingDirectory(RecordingDirectory);
+
+		FGeminiRequestOptions Options;
+		Options.RetryPolicy = FGeminiRetryPolicy::NoRetry();
+		*Current = SendLoopbackChat(Server->GetBaseURL(), TEXT("Make a campfire"), Options);
+		return true;
+	}));
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Current, RecordingDirectory, PreviousDirectory, PreviousMode]()
+	{
+		if (!IsFinished(*Current))
+		{
+			return false;
+		}
+		TestEqual(TEXT("Recorded reply"), (*Current)->Response, FString(TEXT("Recorded campfire")));
+		TestEqual(TEXT("Served from the recording"), Server->GetNumRecordedReplies(), 1);
+
+		FGeminiResponseCache& SharedCache = FGeminiResponseCache::Get();
+		SharedCache.SetDirectory(PreviousDirectory);
+		SharedCache.SetMode(PreviousMode);
+		IFileManager::Get().DeleteDirectory(*RecordingDirectory, false, true);
+		return true;
+	}));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiAPIClientLoopbackFaultTest,
+	"AINiagara.GeminiAPIClient.LoopbackLatencyAndFaults",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiAPIClientLoopbackFaultTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+	Server->SetTextReply(TEXT("OK"));
+	Server->SetLatency(0.25);
+	Server->SetFaultInjection(1.0f, 503);
+
+	FGeminiRequestOptions Options;
+	Options.RetryPolicy = FGeminiRetryPolicy::NoRetry();
+	TSharedRef<FLoopbackOutcome> Outcome = SendLoopbackChat(Server->GetBaseURL(), TEXT("Make a campfire"), Options);
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Outcome]()
+	{
+		if (!IsFinished(Outcome))
+		{
+			return false;
+		}
+		TestEqual(TEXT("Injected fault is reported"), Outcome->ErrorCode, 503);
+		TestEqual(TEXT("One fault injected"), Server->GetNumInjectedFaults(), 1);
+		TestTrue(TEXT("Reply was delayed"), Outcome->ElapsedSeconds >= 0.25);
+
+		FGeminiRequestScheduler::Get().ResetStats();
+		return true;
+	}));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiAPIClientPipelineBenchmarkTest,
+	"AINiagara.GeminiAPIClient.Benchmark.LoopbackPipeline",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter
+)
+
+bool FGeminiAPIClientPipelineBenchmarkTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+
+	// A fenced DSL reply like the model's, with a fixed latency standing in for the model
+	Server->SetTextReply(FString::Printf(TEXT("Here is your effect:\n```json\n%s\n```"), *VFXDSLTestHelpers::MakeDSLJson(4)));
+	Server->SetLatency(0.05);
+
+	struct FPipelineRun
+	{
+		int32 Iteration = 0;
+		TSharedPtr<FLoopbackOutcome> Request;
+		double NetworkSeconds = 0.0;
+		double ClassifySeconds = 0.0;
+		double GenerateSeconds = 0.0;
+		int32 NumGenerated = 0;
+	};
+	const int32 Iterations = 5;
+	TSharedRef<FPipelineRun> Run = MakeShared<FPipelineRun>();
+	Run->Request = SendLoopbackChat(Server->GetBaseURL(), TEXT("Make a campfire"));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Run, Iterations]()
+	{
+		if (!IsFinished(Run->Request))
+		{
+			return false;
+		}
+		Run->NetworkSeconds += Run->Request->ElapsedSeconds;
+
+		// Prompt -> reply -> DSL -> asset, as the chat window does it
+		double StartTime = FPlatformTime::Seconds();
+		FVFXClassifiedResponse Classified;
+		FVFXResponseDispatcher::Classify(Run->Request->Response, Classified);
+		Run->ClassifySeconds += FPlatformTime::Seconds() - StartTime;
+
+		if (Classified.Kind == EVFXResponseKind::DSL)
+		{
+			StartTime = FPlatformTime::Seconds();
+			UNiagaraSystem* System = nullptr;
+			FString Error;
+			if (UNiagaraSystemGenerator::CreateSystemFromDSL(Classified.DSL, TEXT("/Game/Test"), FString::Printf(TEXT("LoopbackPipeline_%d"), Run->Iteration), System, Error))
+			{
+				++Run->NumGenerated;
+			}
+			Run->GenerateSeconds += FPlatformTime::Seconds() - StartTime;
+		}
+
+		if (++Run->Iteration < Iterations)
+		{
+			Run->Request = SendLoopbackChat(Server->GetBaseURL(), TEXT("Make a campfire"));
+			return false;
+		}
+
+		TestEqual(TEXT("Every reply became a system"), Run->NumGenerated, Iterations);
+		AddInfo(FString::Printf(TEXT("Per run: request %.2f ms (50 ms simulated latency), classify %.3f ms, generate %.2f ms"),
+			Run->NetworkSeconds * 1000.0 / Iterations, Run->ClassifySeconds * 1000.0 / Iterations, Run->GenerateSeconds * 1000.0 / Iterations));
+		return true;
+	}));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiAPIClientLoopbackTextureContentTest,
+	"AINiagara.GeminiAPIClient.LoopbackTextureContent",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiAPIClientLoopbackTextureContentTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+
+	const FString ImageReply(TEXT("{\"predictions\": [{\"bytesBase64Encoded\": \"iVBORw0KGgo=\", \"mimeType\": \"image/png\"}]}"));
+	Server->QueueReply(200, TEXT("application/json"), ImageReply);
+	Server->QueueReply(403, TEXT("application/json"), TEXT("{\"error\": {\"code\": 403}}"));
+
+	/** The content arrives on a worker, the error on the game thread */
+	struct FRun
+	{
+		FCriticalSection Mutex;
+		FString Content;
+		bool bContentOnGameThread = true;
+		int32 NumContents = 0;
+		TSharedPtr<FLoopbackOutcome> Error;
+		double StartSeconds = 0.0;
+	};
+	TSharedRef<FRun, ESPMode::ThreadSafe> Run = MakeShared<FRun, ESPMode::ThreadSafe>();
+	Run->StartSeconds = FPlatformTime::Seconds();
+	Run->Error = MakeShared<FLoopbackOutcome>();
+	Run->Error->StartSeconds = Run->StartSeconds;
+
+	FGeminiRequestOptions Options(EGeminiRequestPriority::Tool);
+	Options.RetryPolicy = FGeminiRetryPolicy::NoRetry();
+	Options.bReadCache = false;
+
+	FOnGeminiContent OnContent = [Run](TConstArrayView<uint8> Content)
+	{
+		const FUTF8ToTCHAR Body(reinterpret_cast<const ANSICHAR*>(Content.GetData()), Content.Num());
+		FScopeLock Lock(&Run->Mutex);
+		Run->Content = FString(Body.Length(), Body.Get());
+		Run->bContentOnGameThread = IsInGameThread();
+		++Run->NumContents;
+	};
+
+	// One request gets the image, the other the error reply
+	FGeminiAPIClient Client;
+	Client.SetAPIKey(TEXT("loopback-key"), false);
+	Client.SetBaseURL(Server->GetBaseURL());
+	Client.GenerateTextureContent(TEXT("Soft fire noise"), TEXT("noise"), 256, OnContent, MakeErrorDelegate(Run->Error.ToSharedRef()), Options);
+	Client.GenerateTextureContent(TEXT("Soft fire noise"), TEXT("noise"), 512, OnContent, MakeErrorDelegate(Run->Error.ToSharedRef()), Options);
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Run]()
+	{
+		FScopeLock Lock(&Run->Mutex);
+		if ((Run->NumContents == 0 || !Run->Error->bDone) && FPlatformTime::Seconds() - Run->StartSeconds < 5.0)
+		{
+			return false;
+		}
+
+		TestEqual(TEXT("Reply bytes are handed over unchanged"), Run->Content, FString(TEXT("{\"predictions\": [{\"bytesBase64Encoded\": \"iVBORw0KGgo=\", \"mimeType\": \"image/png\"}]}")));
+		TestFalse(TEXT("Content is handed over on a worker"), Run->bContentOnGameThread);
+		TestEqual(TEXT("One content"), Run->NumContents, 1);
+		TestEqual(TEXT("Error reply reaches OnError"), Run->Error->ErrorCode, 403);
+
+		FGeminiRequestScheduler::Get().ResetStats();
+		return true;
+	}));
+
+	return true;
+}
+
 #endif // WITH_DEV_AUTOMATION_TESTS
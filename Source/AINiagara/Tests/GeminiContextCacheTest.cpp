@@ -0,0 +1,331 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/GeminiAPIClient.h"
+#include "Core/GeminiContextCache.h"
+#include "Core/GeminiPayloadBuilder.h"
+#include "Core/GeminiRequestScheduler.h"
+#include "Core/VFXPromptBuilder.h"
+#include "GeminiTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const TCHAR* SystemPrompt = TEXT("You are a VFX assistant. Reply with a VFX DSL document.");
+
+	/** Replies of the chat requests sent by one test */
+	struct FContextCacheRun
+	{
+		FString BaseURL;
+		int32 NumResponses = 0;
+		int32 NumErrors = 0;
+		double StepStartSeconds = 0.0;
+
+		/** Whether the current step has waited too long */
+		bool HasTimedOut() const { return FPlatformTime::Seconds() - StepStartSeconds > 5.0; }
+	};
+
+	/** Send a chat request with the system prompt and tools from a short-lived client */
+	void SendChat(const TSharedRef<FContextCacheRun>& Run, int32 TTLSeconds)
+	{
+		Run->StepStartSeconds = FPlatformTime::Seconds();
+
+		FGeminiAPIClient Client;
+		Client.SetAPIKey(TEXT("loopback-key"), false);
+		Client.SetBaseURL(Run->BaseURL);
+		Client.SetContextCacheTTL(TTLSeconds);
+
+		FGeminiRequestOptions Options;
+		Options.RetryPolicy = FGeminiRetryPolicy::NoRetry();
+		Options.bReadCache = false;
+
+		Client.SendChatCompletion(
+			TEXT("Make a campfire"),
+			{ FConversationMessage(TEXT("system"), SystemPrompt) },
+			UVFXPromptBuilder::GetAvailableTools(),
+			FOnGeminiResponse::CreateLambda([Run](const FString& ResponseText) { ++Run->NumResponses; }),
+			FOnGeminiError::CreateLambda([Run](int32 ErrorCode, const FString& ErrorMessage) { ++Run->NumErrors; }),
+			Options
+		);
+	}
+
+	TSharedPtr<FJsonObject> ParseJson(const FString& Json)
+	{
+		TSharedPtr<FJsonObject> Object;
+		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Json);
+		FJsonSerializer::Deserialize(Reader, Object);
+		return Object;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiContextCachePayloadTest,
+	"AINiagara.GeminiContextCache.Payloads",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiContextCachePayloadTest::RunTest(const FString& Parameters)
+{
+	const TArray<FConversationMessage> History = {
+		FConversationMessage(TEXT("system"), SystemPrompt),
+		FConversationMessage(TEXT("user"), TEXT("Make a campfire")),
+		FConversationMessage(TEXT("assistant"), TEXT("{\"effect\": {}}"))
+	};
+	const TArray<FVFXToolFunction> Tools = UVFXPromptBuilder::GetAvailableTools();
+
+	FGeminiPayloadBuilder Builder;
+	FString Payload;
+
+	TestTrue(TEXT("Fixed part is cached"), Builder.BuildCachedContent(TEXT("models/gemini-pro"), History, Tools, 600, Payload));
+	TSharedPtr<FJsonObject> Created = ParseJson(Payload);
+	if (!Created.IsValid())
+	{
+		AddError(TEXT("Cached content body is not JSON"));
+		return false;
+	}
+	TestEqual(TEXT("Model"), Created->GetStringField(TEXT("model")), FString(TEXT("models/gemini-pro")));
+	TestEqual(TEXT("TTL"), Created->GetStringField(TEXT("ttl")), FString(TEXT("600s")));
+	TestTrue(TEXT("Tools are cached"), Created->HasField(TEXT("tools")) == (Tools.Num() > 0));
+	TestFalse(TEXT("Conversation turns are not cached"), Payload.Contains(TEXT("Make a campfire")));
+
+	const TSharedPtr<FJsonObject>* Instruction;
+	const TArray<TSharedPtr<FJsonValue>>* Parts;
+	TestTrue(TEXT("System message is the system instruction"),
+		Created->TryGetObjectField(TEXT("systemInstruction"), Instruction)
+		&& (*Instruction)->TryGetArrayField(TEXT("parts"), Parts)
+		&& Parts->Num() == 1
+		&& (*Parts)[0]->AsObject()->GetStringField(TEXT("text")) == SystemPrompt);
+
+	TestFalse(TEXT("Nothing to cache without system message or tools"),
+		Builder.BuildCachedContent(TEXT("models/gemini-pro"), { History[1] }, TArray<FVFXToolFunction>(), 600, Payload));
+
+	Builder.BuildChatCompletionWithCachedContent(TEXT("cachedContents/abc"), TEXT("Add sparks"), History, Payload);
+	TSharedPtr<FJsonObject> Chat = ParseJson(Payload);
+	if (!Chat.IsValid())
+	{
+		AddError(TEXT("Chat payload is not JSON"));
+		return false;
+	}
+	TestEqual(TEXT("Refers to the cached content"), Chat->GetStringField(TEXT("cachedContent")), FString(TEXT("cachedContents/abc")));
+	TestEqual(TEXT("System message is left out"), Chat->GetArrayField(TEXT("contents")).Num(), 3);
+	TestFalse(TEXT("Tools are left out"), Chat->HasField(TEXT("tools")));
+	TestFalse(TEXT("System prompt is not sent"), Payload.Contains(SystemPrompt));
+
+	TestTrue(TEXT("Unknown cached content is recognised"), FGeminiContextCache::IsCachedContentError(404, TEXT("{\"error\": {\"message\": \"CachedContent not found\"}}")));
+	TestTrue(TEXT("Denied cached content is recognised"), FGeminiContextCache::IsCachedContentError(403, TEXT("{\"error\": {\"message\": \"Permission denied on cachedContent\"}}")));
+	TestFalse(TEXT("Other 404s are not"), FGeminiContextCache::IsCachedContentError(404, TEXT("{\"error\": {\"message\": \"Model not found\"}}")));
+	TestFalse(TEXT("Server errors are not"), FGeminiContextCache::IsCachedContentError(500, TEXT("CachedContent backend unavailable")));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiContextCacheReuseTest,
+	"AINiagara.GeminiContextCache.LoopbackReuse",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiContextCacheReuseTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+	Server->SetTextReply(TEXT("campfire"));
+	FGeminiContextCache::Get().Reset();
+
+	TSharedRef<FContextCacheRun> Run = MakeShared<FContextCacheRun>();
+	Run->BaseURL = Server->GetBaseURL();
+
+	// The first request goes inline and starts creating the cached content
+	SendChat(Run, 600);
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Run]()
+	{
+		if ((Run->NumResponses + Run->NumErrors < 1 || FGeminiContextCache::Get().GetStats().NumCreated < 1) && !Run->HasTimedOut())
+		{
+			return false;
+		}
+		TestEqual(TEXT("First reply delivered"), Run->NumResponses, 1);
+		TestTrue(TEXT("First request carried the system prompt"), Server->GetLastRequestBody().Contains(SystemPrompt));
+		TestEqual(TEXT("Cached content created once"), Server->GetNumCachedContentsCreated(), 1);
+		TestTrue(TEXT("Cached content holds the system prompt"), Server->GetLastCachedContentBody().Contains(SystemPrompt));
+
+		SendChat(Run, 600);
+		SendChat(Run, 600);
+		return true;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Run]()
+	{
+		if (Run->NumResponses + Run->NumErrors < 3 && !Run->HasTimedOut())
+		{
+			return false;
+		}
+		const FGeminiContextCacheStats Stats = FGeminiContextCache::Get().GetStats();
+		TestEqual(TEXT("All replies delivered"), Run->NumResponses, 3);
+		TestEqual(TEXT("Later requests refer to the cached content"), Server->GetNumCachedContentReferences(), 2);
+		TestEqual(TEXT("Two hits"), Stats.NumHits, 2);
+		TestEqual(TEXT("Still one cached content"), Server->GetNumCachedContentsCreated(), 1);
+		TestFalse(TEXT("System prompt is not re-uploaded"), Server->GetLastRequestBody().Contains(SystemPrompt));
+		TestTrue(TEXT("Prompt is still sent"), Server->GetLastRequestBody().Contains(TEXT("Make a campfire")));
+
+		FGeminiContextCache::Get().Reset();
+		FGeminiRequestScheduler::Get().ResetStats();
+		return true;
+	}));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiContextCacheRecreateTest,
+	"AINiagara.GeminiContextCache.LoopbackRecreate",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiContextCacheRecreateTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+	Server->SetTextReply(TEXT("campfire"));
+	FGeminiContextCache::Get().Reset();
+
+	TSharedRef<FContextCacheRun> Run = MakeShared<FContextCacheRun>();
+	Run->BaseURL = Server->GetBaseURL();
+
+	// Short lifetime so local expiry is reached within the test
+	const int32 TTLSeconds = 2;
+	SendChat(Run, TTLSeconds);
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Run, TTLSeconds]()
+	{
+		if (FGeminiContextCache::Get().GetStats().NumCreated < 1 && !Run->HasTimedOut())
+		{
+			return false;
+		}
+
+		// The provider drops the content before its expiry time: the request is sent again inline
+		Server->ExpireCachedContents();
+		SendChat(Run, TTLSeconds);
+		return true;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Run]()
+	{
+		if (Run->NumResponses + Run->NumErrors < 2 && !Run->HasTimedOut())
+		{
+			return false;
+		}
+		const FGeminiContextCacheStats Stats = FGeminiContextCache::Get().GetStats();
+		TestEqual(TEXT("Rejected request still gets its reply"), Run->NumResponses, 2);
+		TestEqual(TEXT("No error reaches the caller"), Run->NumErrors, 0);
+		TestEqual(TEXT("Rejection is counted"), Stats.NumRejected, 1);
+		TestTrue(TEXT("Retry carried the system prompt"), Server->GetLastRequestBody().Contains(SystemPrompt));
+
+		SendChat(Run, 2);
+		return true;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Run]()
+	{
+		if ((Run->NumResponses + Run->NumErrors < 3 || FGeminiContextCache::Get().GetStats().NumCreated < 2) && !Run->HasTimedOut())
+		{
+			return false;
+		}
+		TestEqual(TEXT("Rejected content is recreated"), Server->GetNumCachedContentsCreated(), 2);
+		return true;
+	}));
+
+	// Past the lifetime the next request recreates the content instead of referring to it
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(2.5f));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Run]()
+	{
+		const int32 NumReferences = Server->GetNumCachedContentReferences();
+		SendChat(Run, 2);
+
+		const FGeminiContextCacheStats Stats = FGeminiContextCache::Get().GetStats();
+		TestEqual(TEXT("Expiry is noticed locally"), Stats.NumExpired, 1);
+		TestEqual(TEXT("Expired content is not referred to"), Server->GetNumCachedContentReferences(), NumReferences);
+		return true;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Run]()
+	{
+		if ((Run->NumResponses + Run->NumErrors < 4 || FGeminiContextCache::Get().GetStats().NumCreated < 3) && !Run->HasTimedOut())
+		{
+			return false;
+		}
+		TestEqual(TEXT("Expired content is recreated"), Server->GetNumCachedContentsCreated(), 3);
+		TestEqual(TEXT("Every request got its reply"), Run->NumResponses, 4);
+
+		FGeminiContextCache::Get().Reset();
+		FGeminiRequestScheduler::Get().ResetStats();
+		return true;
+	}));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiContextCacheUnsupportedTest,
+	"AINiagara.GeminiContextCache.LoopbackUnsupported",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiContextCacheUnsupportedTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+	Server->SetTextReply(TEXT("campfire"));
+	Server->SetCachedContentsSupported(false);
+	FGeminiContextCache::Get().Reset();
+
+	TSharedRef<FContextCacheRun> Run = MakeShared<FContextCacheRun>();
+	Run->BaseURL = Server->GetBaseURL();
+	SendChat(Run, 600);
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Run]()
+	{
+		if ((Run->NumResponses + Run->NumErrors < 1 || FGeminiContextCache::Get().GetStats().NumCreateFailures < 1) && !Run->HasTimedOut())
+		{
+			return false;
+		}
+		SendChat(Run, 600);
+		SendChat(Run, 600);
+		return true;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Run]()
+	{
+		if (Run->NumResponses + Run->NumErrors < 3 && !Run->HasTimedOut())
+		{
+			return false;
+		}
+		const FGeminiContextCacheStats Stats = FGeminiContextCache::Get().GetStats();
+		TestEqual(TEXT("Requests fall back to inline content"), Run->NumResponses, 3);
+		TestEqual(TEXT("Creation is not retried on every request"), Stats.NumCreateFailures, 1);
+		TestEqual(TEXT("No request refers to cached content"), Server->GetNumCachedContentReferences(), 0);
+		TestTrue(TEXT("System prompt is sent inline"), Server->GetLastRequestBody().Contains(SystemPrompt));
+
+		FGeminiContextCache::Get().Reset();
+		FGeminiRequestScheduler::Get().ResetStats();
+		return true;
+	}));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,268 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/GeminiAPIClient.h"
+#include "Core/GeminiMetrics.h"
+#include "Core/GeminiPayloadBuilder.h"
+#include "Core/GeminiRequestScheduler.h"
+#include "Core/VFXResponseDispatcher.h"
+#include "GeminiTestHelpers.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** DSL candidates that differ only in a size range the validator rejects */
+	const TCHAR* InvalidDSL = TEXT(R"({"effect":{"type":"Niagara","duration":2.0,"looping":true},"emitters":[{"name":"Sparks","spawners":{"rate":{"spawnRate":40.0}},"initialization":{"size":{"min":6.0,"max":2.0}},"render":{"blendMode":"Additive"}}]})");
+	const TCHAR* ValidDSL = TEXT(R"({"effect":{"type":"Niagara","duration":2.0,"looping":true},"emitters":[{"name":"Sparks","spawners":{"rate":{"spawnRate":40.0}},"initialization":{"size":{"min":2.0,"max":6.0}},"render":{"blendMode":"Additive"}}]})");
+
+	/** generateContent reply whose candidates carry the given texts */
+	FString MakeCandidatesReply(const TArray<FString>& Texts)
+	{
+		TArray<TSharedPtr<FJsonValue>> Candidates;
+		for (const FString& Text : Texts)
+		{
+			TSharedRef<FJsonObject> Part = MakeShared<FJsonObject>();
+			Part->SetStringField(TEXT("text"), Text);
+
+			TSharedRef<FJsonObject> Content = MakeShared<FJsonObject>();
+			Content->SetStringField(TEXT("role"), TEXT("model"));
+			Content->SetArrayField(TEXT("parts"), { MakeShared<FJsonValueObject>(Part) });
+
+			TSharedRef<FJsonObject> Candidate = MakeShared<FJsonObject>();
+			Candidate->SetObjectField(TEXT("content"), Content);
+			Candidate->SetStringField(TEXT("finishReason"), TEXT("STOP"));
+			Candidates.Add(MakeShared<FJsonValueObject>(Candidate));
+		}
+
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetArrayField(TEXT("candidates"), Candidates);
+
+		FString Body;
+		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Body);
+		FJsonSerializer::Serialize(Root, Writer);
+		return Body;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiHedgingCandidatesTest,
+	"AINiagara.GeminiHedging.SelectCandidate",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiHedgingCandidatesTest::RunTest(const FString& Parameters)
+{
+	TestFalse(TEXT("Invalid DSL is not usable"), FVFXResponseDispatcher::IsUsableReply(InvalidDSL));
+	TestTrue(TEXT("Valid DSL is usable"), FVFXResponseDispatcher::IsUsableReply(ValidDSL));
+	TestTrue(TEXT("Plain text is usable"), FVFXResponseDispatcher::IsUsableReply(TEXT("What color should the sparks be?")));
+
+	FGeminiResponse Response;
+	TestTrue(TEXT("Reply parses"), FGeminiAPIClient::ParseResponse(MakeCandidatesReply({ InvalidDSL, ValidDSL, ValidDSL }), Response));
+	TestEqual(TEXT("Every candidate is kept"), Response.Candidates.Num(), 3);
+	TestEqual(TEXT("First candidate is the response text"), Response.Candidates[0], Response.GetResponseText());
+
+	TestEqual(TEXT("First valid candidate is picked"), FGeminiAPIClient::SelectCandidate(Response, &FVFXResponseDispatcher::IsUsableReply), 1);
+	TestEqual(TEXT("Without a filter the first candidate is picked"), FGeminiAPIClient::SelectCandidate(Response, nullptr), 0);
+	TestEqual(TEXT("No candidate accepted"), FGeminiAPIClient::SelectCandidate(Response, [](const FString&) { return false; }), (int32)INDEX_NONE);
+
+	// candidateCount goes into a generationConfig of an otherwise unchanged payload
+	FString Payload;
+	FGeminiPayloadBuilder::Get().BuildChatCompletion(TEXT("Make sparks"), TArray<FConversationMessage>(), TArray<FVFXToolFunction>(), Payload);
+	const FString SingleCandidate = Payload;
+	FGeminiPayloadBuilder::AppendCandidateCount(1, Payload);
+	TestEqual(TEXT("One candidate leaves the payload unchanged"), Payload, SingleCandidate);
+
+	FGeminiPayloadBuilder::AppendCandidateCount(3, Payload);
+	TSharedPtr<FJsonObject> Object;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Payload);
+	const TSharedPtr<FJsonObject>* GenerationConfig;
+	int32 CandidateCount = 0;
+	TestTrue(TEXT("Payload is still JSON"), FJsonSerializer::Deserialize(Reader, Object) && Object.IsValid());
+	TestTrue(TEXT("Candidate count is set"), Object.IsValid() && Object->TryGetObjectField(TEXT("generationConfig"), GenerationConfig)
+		&& (*GenerationConfig)->TryGetNumberField(TEXT("candidateCount"), CandidateCount) && CandidateCount == 3);
+	TestTrue(TEXT("Contents are kept"), Object.IsValid() && Object->HasField(TEXT("contents")));
+
+	// The hedge delay follows the recorded latencies once there are enough of them
+	FGeminiMetricsRegistry& Registry = FGeminiMetricsRegistry::Get();
+	Registry.Reset();
+
+	FGeminiHedgePolicy Policy = FGeminiHedgePolicy::AtPercentile(0.9);
+	Policy.MinSamples = 10;
+	TestTrue(TEXT("Disabled policy has no delay"), FGeminiHedgePolicy().GetDelay(TEXT("/test")) < 0.0);
+	TestEqual(TEXT("Default delay without samples"), Policy.GetDelay(TEXT("/test")), Policy.DefaultDelaySeconds);
+
+	for (int32 Index = 1; Index <= 20; ++Index)
+	{
+		FGeminiRequestMetrics Metrics;
+		Metrics.Endpoint = TEXT("/test");
+		Metrics.ResponseCode = 200;
+		Metrics.TotalSeconds = Index;
+		Registry.Record(Metrics);
+	}
+
+	// Failures and cache hits say nothing about how long a reply takes
+	FGeminiRequestMetrics Failed;
+	Failed.Endpoint = TEXT("/test");
+	Failed.ResponseCode = 500;
+	Failed.TotalSeconds = 100.0;
+	Registry.Record(Failed);
+
+	TestEqual(TEXT("Percentile of successful requests"), Policy.GetDelay(TEXT("/test")), 18.0);
+	Policy.MaxDelaySeconds = 5.0;
+	TestEqual(TEXT("Delay is clamped"), Policy.GetDelay(TEXT("/test")), 5.0);
+
+	Registry.Reset();
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiHedgingLoopbackTest,
+	"AINiagara.GeminiHedging.LoopbackHedge",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiHedgingLoopbackTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+
+	// The original request is stuck behind a slow reply; its duplicate is answered at once
+	const double SlowSeconds = 1.5;
+	Server->QueueReply(200, TEXT("application/json"), GeminiTestHelpers::MakeChunkJson(TEXT("slow reply"), TEXT("STOP")), FString(), SlowSeconds);
+	Server->QueueReply(200, TEXT("application/json"), GeminiTestHelpers::MakeChunkJson(TEXT("fast reply"), TEXT("STOP")), FString(), 0.0);
+	FGeminiMetricsRegistry::Get().Reset();
+
+	struct FRun
+	{
+		FString Response;
+		int32 NumResponses = 0;
+		int32 NumErrors = 0;
+		double StartSeconds = 0.0;
+		double ReplySeconds = -1.0;
+	};
+	TSharedRef<FRun> Run = MakeShared<FRun>();
+	Run->StartSeconds = FPlatformTime::Seconds();
+
+	FGeminiAPIClient Client;
+	Client.SetAPIKey(TEXT("loopback-key"), false);
+	Client.SetBaseURL(Server->GetBaseURL());
+	Client.SetContextCacheTTL(0);
+
+	// Too few samples for the percentile, so the duplicate goes out after the default delay
+	FGeminiRequestOptions Options;
+	Options.RetryPolicy = FGeminiRetryPolicy::NoRetry();
+	Options.bReadCache = false;
+	Options.Hedge = FGeminiHedgePolicy::AtPercentile(0.95);
+	Options.Hedge.DefaultDelaySeconds = 0.3;
+	Options.Hedge.MinDelaySeconds = 0.1;
+	Options.Hedge.MinSamples = 1000;
+
+	Client.SendChatCompletion(TEXT("Make sparks"), TArray<FConversationMessage>(), TArray<FVFXToolFunction>(),
+		FOnGeminiResponse::CreateLambda([Run](const FString& ResponseText)
+		{
+			Run->Response = ResponseText;
+			++Run->NumResponses;
+			Run->ReplySeconds = FPlatformTime::Seconds() - Run->StartSeconds;
+		}),
+		FOnGeminiError::CreateLambda([Run](int32 ErrorCode, const FString& ErrorMessage) { ++Run->NumErrors; }),
+		Options);
+
+	// Wait past the slow reply as well, so a late outcome of the cancelled copy would be seen
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Run, SlowSeconds]()
+	{
+		const double Elapsed = FPlatformTime::Seconds() - Run->StartSeconds;
+		if (Elapsed < SlowSeconds + 0.5 || (Run->NumResponses + Run->NumErrors == 0 && Elapsed < 5.0))
+		{
+			return false;
+		}
+
+		TestEqual(TEXT("The duplicate's reply is delivered"), Run->Response, FString(TEXT("fast reply")));
+		TestEqual(TEXT("Delivered once"), Run->NumResponses, 1);
+		TestEqual(TEXT("No error"), Run->NumErrors, 0);
+		TestTrue(TEXT("Faster than the slow reply"), Run->ReplySeconds >= 0.0 && Run->ReplySeconds < SlowSeconds);
+		TestEqual(TEXT("Original and duplicate were sent"), Server->GetNumRequests(), 2);
+
+		const FGeminiHedgeStats Stats = FGeminiMetricsRegistry::Get().GetHedgeStats();
+		TestEqual(TEXT("One hedged request"), Stats.NumHedged, 1);
+		TestEqual(TEXT("Answered by the duplicate"), Stats.NumDuplicateWins, 1);
+
+		FGeminiMetricsRegistry::Get().Reset();
+		FGeminiRequestScheduler::Get().ResetStats();
+		return true;
+	}));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiHedgingLoopbackCandidatesTest,
+	"AINiagara.GeminiHedging.LoopbackCandidates",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiHedgingLoopbackCandidatesTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+	Server->SetReply(200, TEXT("application/json"), MakeCandidatesReply({ InvalidDSL, ValidDSL }));
+
+	struct FRun
+	{
+		FString Response;
+		int32 NumChunks = 0;
+		bool bDone = false;
+		double StartSeconds = 0.0;
+	};
+	TSharedRef<FRun> Run = MakeShared<FRun>();
+	Run->StartSeconds = FPlatformTime::Seconds();
+
+	FGeminiAPIClient Client;
+	Client.SetAPIKey(TEXT("loopback-key"), false);
+	Client.SetBaseURL(Server->GetBaseURL());
+	Client.SetContextCacheTTL(0);
+
+	FGeminiRequestOptions Options;
+	Options.RetryPolicy = FGeminiRetryPolicy::NoRetry();
+	Options.bReadCache = false;
+	Options.CandidateCount = 2;
+	Options.AcceptCandidate = &FVFXResponseDispatcher::IsUsableReply;
+
+	// Candidates cannot be streamed; the chosen one arrives as a single chunk
+	Client.StreamChatCompletion(TEXT("Make sparks"), TArray<FConversationMessage>(), TArray<FVFXToolFunction>(),
+		FOnGeminiStreamChunk::CreateLambda([Run](const FString& ChunkText, const FGeminiStreamStats& Stats) { ++Run->NumChunks; }),
+		FOnGeminiResponse::CreateLambda([Run](const FString& ResponseText) { Run->Response = ResponseText; Run->bDone = true; }),
+		FOnGeminiError::CreateLambda([Run](int32 ErrorCode, const FString& ErrorMessage) { Run->bDone = true; }),
+		Options);
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Run]()
+	{
+		if (!Run->bDone && FPlatformTime::Seconds() - Run->StartSeconds < 5.0)
+		{
+			return false;
+		}
+
+		TestEqual(TEXT("The valid candidate is delivered"), Run->Response, FString(ValidDSL));
+		TestEqual(TEXT("Delivered as one chunk"), Run->NumChunks, 1);
+		TestEqual(TEXT("One request"), Server->GetNumRequests(), 1);
+		TestTrue(TEXT("Candidates were asked for"), Server->GetLastRequestBody().Contains(TEXT("\"candidateCount\":2")));
+
+		FGeminiRequestScheduler::Get().ResetStats();
+		return true;
+	}));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,296 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/GeminiAPIClient.h"
+#include "Core/GeminiMetrics.h"
+#include "Core/GeminiRequestScheduler.h"
+#include "GeminiTestHelpers.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** generateContent reply with two text parts, a function call and usage metadata */
+	const TCHAR* FullReply = TEXT(R"({
+		"candidates": [
+			{
+				"content": { "role": "model", "parts": [
+					{ "text": "Here is " },
+					{ "text": "your campfire." },
+					{ "functionCall": { "name": "tool:texture", "args": { "type": "fire" } } }
+				] },
+				"finishReason": "MAX_TOKENS",
+				"safetyRatings": [ { "category": "HARM_CATEGORY_DANGEROUS_CONTENT", "probability": "LOW" } ]
+			},
+			{ "content": { "role": "model", "parts": [ { "text": "Second candidate" } ] }, "finishReason": "STOP" }
+		],
+		"usageMetadata": { "promptTokenCount": 120, "candidatesTokenCount": 45, "cachedContentTokenCount": 100, "totalTokenCount": 165 }
+	})");
+
+	FGeminiRequestMetrics MakeMetrics(const FString& Endpoint, int32 ResponseCode, double TotalSeconds, int32 PromptTokens)
+	{
+		FGeminiRequestMetrics Metrics;
+		Metrics.Endpoint = Endpoint;
+		Metrics.Timestamp = FDateTime::UtcNow();
+		Metrics.ResponseCode = ResponseCode;
+		Metrics.NumAttempts = 1;
+		Metrics.TotalSeconds = TotalSeconds;
+		Metrics.TimeToFirstByteSeconds = TotalSeconds * 0.5;
+		Metrics.RequestBytes = 1000;
+		Metrics.ResponseBytes = 500;
+		Metrics.PromptTokens = PromptTokens;
+		Metrics.OutputTokens = 10;
+		return Metrics;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiMetricsParseTest,
+	"AINiagara.GeminiMetrics.ParseResponse",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiMetricsParseTest::RunTest(const FString& Parameters)
+{
+	FGeminiResponse Response;
+	TestTrue(TEXT("Full reply parses"), FGeminiAPIClient::ParseResponse(FullReply, Response));
+	TestEqual(TEXT("Text parts are joined"), Response.Text, FString(TEXT("Here is your campfire.")));
+	TestEqual(TEXT("Each text part is kept"), Response.TextParts.Num(), 2);
+	TestEqual(TEXT("Function call is kept"), Response.FunctionCalls.Num(), 1);
+	TestTrue(TEXT("Function call is wrapped"), Response.FunctionCalls.Num() == 1 && Response.FunctionCalls[0].StartsWith(TEXT("{\"functionCall\":")));
+	TestEqual(TEXT("Candidates are counted"), Response.NumCandidates, 2);
+	TestEqual(TEXT("Finish reason"), Response.FinishReason, FString(TEXT("MAX_TOKENS")));
+	TestEqual(TEXT("Prompt tokens"), Response.PromptTokens, 120);
+	TestEqual(TEXT("Output tokens"), Response.OutputTokens, 45);
+	TestEqual(TEXT("Cached tokens"), Response.CachedTokens, 100);
+	TestEqual(TEXT("Total tokens"), Response.TotalTokens, 165);
+	TestFalse(TEXT("Not blocked"), Response.IsBlocked());
+	TestEqual(TEXT("Text is delivered"), Response.GetResponseText(), Response.Text);
+
+	// A reply that only calls a tool hands the call to the dispatcher
+	TestTrue(TEXT("Function call reply parses"), FGeminiAPIClient::ParseResponse(
+		TEXT("{\"candidates\":[{\"content\":{\"parts\":[{\"functionCall\":{\"name\":\"tool:texture\",\"args\":{}}}]},\"finishReason\":\"STOP\"}]}"), Response));
+	TestTrue(TEXT("Function call is delivered"), Response.GetResponseText().Contains(TEXT("tool:texture")));
+
+	// Prompt blocked before generation
+	TestTrue(TEXT("Blocked prompt parses"), FGeminiAPIClient::ParseResponse(
+		TEXT("{\"promptFeedback\":{\"blockReason\":\"SAFETY\",\"safetyRatings\":[{\"category\":\"HARM_CATEGORY_HARASSMENT\",\"probability\":\"HIGH\",\"blocked\":true}]},\"usageMetadata\":{\"promptTokenCount\":8}}"), Response));
+	TestTrue(TEXT("Blocked prompt is blocked"), Response.IsBlocked());
+	TestEqual(TEXT("Block reason"), Response.BlockReason, FString(TEXT("SAFETY")));
+	TestEqual(TEXT("Blocked category"), Response.BlockedCategories.Num() > 0 ? Response.BlockedCategories[0] : FString(), FString(TEXT("HARM_CATEGORY_HARASSMENT")));
+	TestTrue(TEXT("Block is described"), Response.DescribeBlock().Contains(TEXT("HARM_CATEGORY_HARASSMENT")));
+	TestEqual(TEXT("Blocked prompt still counts its tokens"), Response.PromptTokens, 8);
+
+	// Candidate withheld by the filters
+	TestTrue(TEXT("Withheld candidate parses"), FGeminiAPIClient::ParseResponse(
+		TEXT("{\"candidates\":[{\"finishReason\":\"SAFETY\",\"safetyRatings\":[{\"category\":\"HARM_CATEGORY_DANGEROUS_CONTENT\",\"probability\":\"HIGH\",\"blocked\":true}]}]}"), Response));
+	TestTrue(TEXT("Withheld candidate is blocked"), Response.IsBlocked());
+
+	TestFalse(TEXT("Not JSON"), FGeminiAPIClient::ParseResponse(TEXT("not json"), Response));
+	TestFalse(TEXT("No candidates"), FGeminiAPIClient::ParseResponse(TEXT("{}"), Response));
+	TestFalse(TEXT("Candidate without content"), FGeminiAPIClient::ParseResponse(TEXT("{\"candidates\":[{\"finishReason\":\"OTHER\"}]}"), Response));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiMetricsRegistryTest,
+	"AINiagara.GeminiMetrics.Registry",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiMetricsRegistryTest::RunTest(const FString& Parameters)
+{
+	FGeminiMetricsRegistry Registry;
+	Registry.Record(MakeMetrics(TEXT("/chat"), 200, 1.0, 100));
+	Registry.Record(MakeMetrics(TEXT("/chat"), 503, 3.0, 0));
+	Registry.Record(MakeMetrics(TEXT("/image"), 200, 2.0, 50));
+
+	FGeminiRequestMetrics Cached = MakeMetrics(TEXT("/chat"), 200, 0.0, 0);
+	Cached.bFromCache = true;
+	Cached.NumAttempts = 0;
+	Registry.Record(Cached);
+
+	const TMap<FString, FGeminiEndpointTotals> Totals = Registry.GetTotals();
+	const FGeminiEndpointTotals* Chat = Totals.Find(TEXT("/chat"));
+	if (!Chat)
+	{
+		AddError(TEXT("No totals for /chat"));
+		return false;
+	}
+	TestEqual(TEXT("Chat requests"), Chat->NumRequests, 3);
+	TestEqual(TEXT("Chat errors"), Chat->NumErrors, 1);
+	TestEqual(TEXT("Chat cache hits"), Chat->NumFromCache, 1);
+	TestEqual(TEXT("Chat prompt tokens"), Chat->PromptTokens, (int64)100);
+	TestEqual(TEXT("Cache hits stay out of the latencies"), Chat->TotalSeconds, 4.0);
+	TestEqual(TEXT("Longest chat request"), Chat->MaxTotalSeconds, 3.0);
+
+	const FGeminiEndpointTotals Overall = Registry.GetOverallTotals();
+	TestEqual(TEXT("All requests"), Overall.NumRequests, 4);
+	TestEqual(TEXT("All prompt tokens"), Overall.PromptTokens, (int64)150);
+	TestTrue(TEXT("Summary names each endpoint"), Registry.FormatSummary().Contains(TEXT("/image: 1 requests")));
+
+	// The ring keeps the newest records, oldest first; the four above are evicted first
+	for (int32 Index = 0; Index < FGeminiMetricsRegistry::MaxRecords + 10; ++Index)
+	{
+		Registry.Record(MakeMetrics(TEXT("/ring"), 200, 1.0, Index));
+	}
+	const TArray<FGeminiRequestMetrics> Recent = Registry.GetRecent();
+	TestEqual(TEXT("Ring is bounded"), Recent.Num(), FGeminiMetricsRegistry::MaxRecords);
+	TestEqual(TEXT("Oldest kept record"), Recent.Num() > 0 ? Recent[0].PromptTokens : -1, 14);
+	TestEqual(TEXT("Newest record last"), Recent.Num() > 0 ? Recent.Last().PromptTokens : -1, FGeminiMetricsRegistry::MaxRecords + 9);
+	TestEqual(TEXT("Totals cover evicted records"), Registry.GetTotals().FindRef(TEXT("/ring")).NumRequests, FGeminiMetricsRegistry::MaxRecords + 10);
+
+	// CSV has a header and one row per kept record
+	const FString Path = FPaths::ProjectIntermediateDir() / TEXT("AINiagaraTests") / TEXT("GeminiMetrics.csv");
+	FString Error;
+	TestTrue(TEXT("CSV is written"), Registry.WriteCSV(Path, Error));
+
+	TArray<FString> Lines;
+	FFileHelper::LoadFileToStringArray(Lines, *Path);
+	TestEqual(TEXT("CSV rows"), Lines.Num(), FGeminiMetricsRegistry::MaxRecords + 1);
+	TestTrue(TEXT("CSV header"), Lines.Num() > 0 && Lines[0].StartsWith(TEXT("Timestamp,Endpoint,ResponseCode")));
+	TestTrue(TEXT("CSV row"), Lines.Num() > 1 && Lines[1].Contains(TEXT("\"/ring\",200,1")));
+	IFileManager::Get().Delete(*Path);
+
+	Registry.Reset();
+	TestEqual(TEXT("Reset clears the records"), Registry.GetRecent().Num(), 0);
+	TestEqual(TEXT("Reset clears the totals"), Registry.GetTotals().Num(), 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiMetricsModelTotalsTest,
+	"AINiagara.GeminiMetrics.ModelTotals",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiMetricsModelTotalsTest::RunTest(const FString& Parameters)
+{
+	FGeminiMetricsRegistry Registry;
+
+	// One endpoint, two models: the totals per model tell the tiers apart
+	FGeminiRequestMetrics Large = MakeMetrics(TEXT("/chat/completions"), 200, 4.0, 1000);
+	Large.Model = TEXT("large-model");
+	Registry.Record(Large);
+	for (double Seconds : { 0.5, 1.0 })
+	{
+		FGeminiRequestMetrics Fast = MakeMetrics(TEXT("/chat/completions"), 200, Seconds, 200);
+		Fast.Model = TEXT("fast-model");
+		Registry.Record(Fast);
+	}
+	Registry.Record(MakeMetrics(TEXT("/chat/completions"), 200, 2.0, 0));
+
+	const TMap<FString, FGeminiEndpointTotals> ModelTotals = Registry.GetModelTotals();
+	TestEqual(TEXT("Requests of unknown model are left out"), ModelTotals.Num(), 2);
+	TestEqual(TEXT("Fast model requests"), ModelTotals.FindRef(TEXT("fast-model")).NumRequests, 2);
+	TestEqual(TEXT("Fast model latency"), ModelTotals.FindRef(TEXT("fast-model")).TotalSeconds, 1.5);
+	TestEqual(TEXT("Large model prompt tokens"), ModelTotals.FindRef(TEXT("large-model")).PromptTokens, (int64)1000);
+	TestEqual(TEXT("Endpoint totals still cover every request"), Registry.GetTotals().FindRef(TEXT("/chat/completions")).NumRequests, 4);
+
+	double P95Seconds = 0.0;
+	TestTrue(TEXT("Model percentile"), Registry.GetModelLatencyPercentile(TEXT("fast-model"), 0.95, 1, P95Seconds));
+	TestEqual(TEXT("Fast model p95"), P95Seconds, 1.0);
+
+	const FString Summary = Registry.FormatSummary();
+	TestTrue(TEXT("Summary has a line per model"), Summary.Contains(TEXT("Model fast-model: 2 requests")));
+	TestTrue(TEXT("Summary has the model p95"), Summary.Contains(TEXT("p95 4000 ms")));
+
+	const FString Path = FPaths::ProjectIntermediateDir() / TEXT("AINiagaraTests") / TEXT("GeminiModelMetrics.csv");
+	FString Error;
+	TestTrue(TEXT("CSV is written"), Registry.WriteCSV(Path, Error));
+	TArray<FString> Lines;
+	FFileHelper::LoadFileToStringArray(Lines, *Path);
+	TestTrue(TEXT("CSV names the model"), Lines.Num() > 1 && Lines[0].EndsWith(TEXT(",Model")) && Lines[1].EndsWith(TEXT(",\"large-model\"")));
+	IFileManager::Get().Delete(*Path);
+
+	Registry.Reset();
+	TestEqual(TEXT("Reset clears the model totals"), Registry.GetModelTotals().Num(), 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiMetricsLoopbackTest,
+	"AINiagara.GeminiMetrics.LoopbackRecord",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiMetricsLoopbackTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+	Server->SetReply(200, TEXT("application/json"), FullReply);
+	Server->SetLatency(0.2);
+	FGeminiMetricsRegistry::Get().Reset();
+
+	struct FRun
+	{
+		FString Response;
+		bool bDone = false;
+		double StartSeconds = 0.0;
+	};
+	TSharedRef<FRun> Run = MakeShared<FRun>();
+	Run->StartSeconds = FPlatformTime::Seconds();
+
+	FGeminiAPIClient Client;
+	Client.SetAPIKey(TEXT("loopback-key"), false);
+	Client.SetBaseURL(Server->GetBaseURL());
+
+	FGeminiRequestOptions Options;
+	Options.RetryPolicy = FGeminiRetryPolicy::NoRetry();
+	Options.bReadCache = false;
+	Client.SendChatCompletion(TEXT("Make a campfire"), TArray<FConversationMessage>(), TArray<FVFXToolFunction>(),
+		FOnGeminiResponse::CreateLambda([Run](const FString& ResponseText) { Run->Response = ResponseText; Run->bDone = true; }),
+		FOnGeminiError::CreateLambda([Run](int32 ErrorCode, const FString& ErrorMessage) { Run->bDone = true; }),
+		Options);
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Run]()
+	{
+		if (!Run->bDone && FPlatformTime::Seconds() - Run->StartSeconds < 5.0)
+		{
+			return false;
+		}
+
+		TestEqual(TEXT("All text parts are delivered"), Run->Response, FString(TEXT("Here is your campfire.")));
+
+		const TArray<FGeminiRequestMetrics> Recent = FGeminiMetricsRegistry::Get().GetRecent();
+		if (Recent.Num() != 1)
+		{
+			AddError(FString::Printf(TEXT("Expected one record, got %d"), Recent.Num()));
+		}
+		else
+		{
+			const FGeminiRequestMetrics& Metrics = Recent[0];
+			TestEqual(TEXT("Endpoint"), Metrics.Endpoint, FString(TEXT("/models/gemini-pro:generateContent")));
+			TestEqual(TEXT("Model"), Metrics.Model, FString(TEXT("gemini-pro")));
+			TestEqual(TEXT("Response code"), Metrics.ResponseCode, 200);
+			TestEqual(TEXT("One attempt"), Metrics.NumAttempts, 1);
+			TestFalse(TEXT("Sent to the network"), Metrics.bFromCache);
+			TestTrue(TEXT("Latency is measured"), Metrics.TotalSeconds >= 0.2);
+			TestTrue(TEXT("Time to first byte within the total"), Metrics.TimeToFirstByteSeconds > 0.0 && Metrics.TimeToFirstByteSeconds <= Metrics.TotalSeconds);
+			TestTrue(TEXT("Request bytes"), Metrics.RequestBytes > 0);
+			TestEqual(TEXT("Response bytes"), Metrics.ResponseBytes, (int64)FTCHARToUTF8(FullReply).Length());
+			TestEqual(TEXT("Prompt tokens"), Metrics.PromptTokens, 120);
+			TestEqual(TEXT("Output tokens"), Metrics.OutputTokens, 45);
+			TestEqual(TEXT("Cached tokens"), Metrics.CachedTokens, 100);
+			TestEqual(TEXT("Finish reason"), Metrics.FinishReason, FString(TEXT("MAX_TOKENS")));
+		}
+
+		FGeminiMetricsRegistry::Get().Reset();
+		FGeminiRequestScheduler::Get().ResetStats();
+		return true;
+	}));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,175 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/GeminiPayloadBuilder.h"
+#include "Core/VFXPromptBuilder.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Parse a payload and write it back condensed, so payloads compare by content rather than layout */
+	FString NormalizeJson(const FString& Json)
+	{
+		TSharedPtr<FJsonObject> Object;
+		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Json);
+		if (!FJsonSerializer::Deserialize(Reader, Object) || !Object.IsValid())
+		{
+			return FString();
+		}
+
+		FString Normalized;
+		TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Normalized);
+		FJsonSerializer::Serialize(Object.ToSharedRef(), Writer);
+		return Normalized;
+	}
+
+	/** The system prompt followed by alternating user/assistant turns, as the chat widget sends them */
+	TArray<FConversationMessage> MakeHistory(int32 NumMessages)
+	{
+		TArray<FConversationMessage> History;
+		History.Reserve(NumMessages);
+		History.Add(FConversationMessage(TEXT("system"), UVFXPromptBuilder::BuildSystemPrompt()));
+		for (int32 Index = 1; Index < NumMessages; ++Index)
+		{
+			History.Add(FConversationMessage(
+				(Index % 2) ? TEXT("user") : TEXT("assistant"),
+				FString::Printf(TEXT("Turn %d: make the embers drift \"slower\" and fade to orange over 2.5 s\nKeep the smoke soft."), Index)
+			));
+		}
+		return History;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiPayloadBuilderEquivalenceTest,
+	"AINiagara.GeminiPayloadBuilder.MatchesDOM",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiPayloadBuilderEquivalenceTest::RunTest(const FString& Parameters)
+{
+	TArray<FConversationMessage> History = MakeHistory(6);
+	History.Add(FConversationMessage(TEXT("user"), TEXT("Quote \" Backslash \\ Tab \t Newline \n Unicode é")));
+	const TArray<FVFXToolFunction> Tools = UVFXPromptBuilder::GetAvailableTools();
+
+	FGeminiPayloadBuilder Builder;
+	FString Payload;
+
+	struct FCase
+	{
+		const TCHAR* Name;
+		TArray<FConversationMessage> History;
+		TArray<FVFXToolFunction> Tools;
+	};
+	const FCase Cases[] = {
+		{ TEXT("History and tools"), History, Tools },
+		{ TEXT("Cached fragments"), History, Tools },
+		{ TEXT("No tools"), History, TArray<FVFXToolFunction>() },
+		{ TEXT("No history"), TArray<FConversationMessage>(), Tools },
+	};
+
+	for (const FCase& Case : Cases)
+	{
+		Builder.BuildChatCompletion(TEXT("Make a campfire"), Case.History, Case.Tools, Payload);
+		const FString Expected = NormalizeJson(FGeminiPayloadBuilder::BuildChatCompletionDOM(TEXT("Make a campfire"), Case.History, Case.Tools));
+		const FString Actual = NormalizeJson(Payload);
+
+		TestFalse(FString::Printf(TEXT("%s: payload is JSON"), Case.Name), Actual.IsEmpty());
+		TestTrue(FString::Printf(TEXT("%s: payload matches the DOM build"), Case.Name), Actual.Equals(Expected, ESearchCase::CaseSensitive));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiPayloadBuilderFragmentTest,
+	"AINiagara.GeminiPayloadBuilder.Fragments",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiPayloadBuilderFragmentTest::RunTest(const FString& Parameters)
+{
+	FGeminiPayloadBuilder Builder;
+	FString First;
+	FString Second;
+
+	TArray<FConversationMessage> History = MakeHistory(4);
+	TArray<FVFXToolFunction> Tools = UVFXPromptBuilder::GetAvailableTools();
+
+	Builder.BuildChatCompletion(TEXT("Make a campfire"), History, Tools, First);
+	Builder.BuildChatCompletion(TEXT("Make a campfire"), History, Tools, Second);
+	TestTrue(TEXT("Same request gives the same bytes"), First.Equals(Second, ESearchCase::CaseSensitive));
+
+	FGeminiPayloadBuilderStats Stats = Builder.GetStats();
+	TestEqual(TEXT("Tools serialized once"), Stats.NumToolMisses, 1);
+	TestEqual(TEXT("Tools reused"), Stats.NumToolHits, 1);
+	TestEqual(TEXT("System prompt serialized once"), Stats.NumSystemMisses, 1);
+	TestEqual(TEXT("System prompt reused"), Stats.NumSystemHits, 1);
+
+	// A changed declaration or system prompt must not reuse a stale fragment
+	Tools[0].Parameters.Add(TEXT("seed"), TEXT("number"));
+	History[0].Content += TEXT("\nPrefer additive blending.");
+	Builder.BuildChatCompletion(TEXT("Make a campfire"), History, Tools, Second);
+
+	Stats = Builder.GetStats();
+	TestEqual(TEXT("Changed tools are serialized again"), Stats.NumToolMisses, 2);
+	TestEqual(TEXT("Changed system prompt is serialized again"), Stats.NumSystemMisses, 2);
+	TestTrue(TEXT("New tool parameter is sent"), Second.Contains(TEXT("\"seed\"")));
+	TestTrue(TEXT("New system prompt is sent"), Second.Contains(TEXT("Prefer additive blending.")));
+	TestTrue(TEXT("Payload still matches the DOM build"),
+		NormalizeJson(Second).Equals(NormalizeJson(FGeminiPayloadBuilder::BuildChatCompletionDOM(TEXT("Make a campfire"), History, Tools)), ESearchCase::CaseSensitive));
+
+	Builder.Reset();
+	TestEqual(TEXT("Reset clears the counters"), Builder.GetStats().NumToolMisses, 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiPayloadBuilderBenchmarkTest,
+	"AINiagara.GeminiPayloadBuilder.Benchmark.FragmentsVsDOM",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter
+)
+
+bool FGeminiPayloadBuilderBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const int32 MessageCounts[] = { 10, 100, 1000 };
+	const TArray<FVFXToolFunction> Tools = UVFXPromptBuilder::GetAvailableTools();
+
+	for (int32 NumMessages : MessageCounts)
+	{
+		const TArray<FConversationMessage> History = MakeHistory(NumMessages);
+		const int32 Iterations = FMath::Max(5, 2000 / NumMessages);
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			FString Json = FGeminiPayloadBuilder::BuildChatCompletionDOM(TEXT("Make a campfire"), History, Tools);
+		}
+		const double DomMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+
+		// Warm the fragment cache the way the first send of a session does
+		FGeminiPayloadBuilder Builder;
+		FString Buffer;
+		Builder.BuildChatCompletion(TEXT("Make a campfire"), History, Tools, Buffer);
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			Builder.BuildChatCompletion(TEXT("Make a campfire"), History, Tools, Buffer);
+		}
+		const double FragmentMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+
+		AddInfo(FString::Printf(TEXT("%4d messages: DOM %.3f ms, fragments %.3f ms (%.1fx, %d chars)"),
+			NumMessages, DomMs, FragmentMs, FragmentMs > 0.0 ? DomMs / FragmentMs : 0.0, Buffer.Len()));
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,323 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/GeminiAPIClient.h"
+#include "Core/GeminiRequestHandle.h"
+#include "Core/GeminiRequestScheduler.h"
+#include "GeminiTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Delegate calls of one request, and whether any arrived after Cancel */
+	struct FCancelOutcome
+	{
+		FGeminiRequestHandle Handle;
+		TArray<FString> Chunks;
+		int32 NumResponses = 0;
+		int32 NumErrors = 0;
+		bool bCancelled = false;
+		bool bCalledAfterCancel = false;
+		double StartSeconds = 0.0;
+
+		int32 GetNumOutcomes() const { return NumResponses + NumErrors; }
+
+		void OnCall()
+		{
+			bCalledAfterCancel |= bCancelled;
+		}
+
+		void Cancel()
+		{
+			bCancelled = true;
+			Handle.Cancel();
+		}
+	};
+
+	/** Send a chat request from a client that goes out of scope before the reply arrives */
+	TSharedRef<FCancelOutcome> SendCancellableChat(const FString& BaseURL, bool bStream)
+	{
+		TSharedRef<FCancelOutcome> Outcome = MakeShared<FCancelOutcome>();
+		Outcome->StartSeconds = FPlatformTime::Seconds();
+
+		FGeminiAPIClient Client;
+		Client.SetAPIKey(TEXT("loopback-key"), false);
+		Client.SetBaseURL(BaseURL);
+
+		FOnGeminiResponse OnResponse = FOnGeminiResponse::CreateLambda([Outcome](const FString& ResponseText)
+		{
+			Outcome->OnCall();
+			++Outcome->NumResponses;
+		});
+		FOnGeminiError OnError = FOnGeminiError::CreateLambda([Outcome](int32 ErrorCode, const FString& ErrorMessage)
+		{
+			Outcome->OnCall();
+			++Outcome->NumErrors;
+		});
+
+		FGeminiRequestOptions Options;
+		Options.RetryPolicy = FGeminiRetryPolicy::NoRetry();
+
+		if (bStream)
+		{
+			// Cancel from inside the first chunk, while later chunks of the same body are still being parsed
+			Outcome->Handle = Client.StreamChatCompletion(
+				TEXT("Make a campfire"),
+				TArray<FConversationMessage>(),
+				TArray<FVFXToolFunction>(),
+				FOnGeminiStreamChunk::CreateLambda([Outcome](const FString& ChunkText, const FGeminiStreamStats& Stats)
+				{
+					Outcome->OnCall();
+					Outcome->Chunks.Add(ChunkText);
+					Outcome->Cancel();
+				}),
+				OnResponse,
+				OnError,
+				Options
+			);
+		}
+		else
+		{
+			Outcome->Handle = Client.SendChatCompletion(TEXT("Make a campfire"), TArray<FConversationMessage>(), TArray<FVFXToolFunction>(), OnResponse, OnError, Options);
+		}
+		return Outcome;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRequestHandleStateTest,
+	"AINiagara.GeminiRequestHandle.States",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiRequestHandleStateTest::RunTest(const FString& Parameters)
+{
+	FGeminiRequestHandle Empty;
+	TestFalse(TEXT("Default handle refers to no request"), Empty.IsValid());
+	Empty.Cancel();
+	TestFalse(TEXT("Cancelling an empty handle does nothing"), Empty.IsCancelled());
+
+	FGeminiRequestHandle Finished = FGeminiRequestHandle::MakePending();
+	TestTrue(TEXT("New request is pending"), Finished.IsPending());
+	TestTrue(TEXT("First outcome is delivered"), Finished.TryFinish());
+	TestFalse(TEXT("Second outcome is dropped"), Finished.TryFinish());
+	Finished.Cancel();
+	TestFalse(TEXT("Cancel after finishing does nothing"), Finished.IsCancelled());
+
+	FGeminiRequestHandle Cancelled = FGeminiRequestHandle::MakePending();
+	FGeminiRequestHandle Copy = Cancelled;
+	TestTrue(TEXT("Copies refer to the same request"), Copy == Cancelled);
+	Copy.Cancel();
+	Copy.Cancel();
+	TestTrue(TEXT("Cancel through a copy is seen by the original"), Cancelled.IsCancelled());
+	TestFalse(TEXT("Cancelled request is not pending"), Cancelled.IsPending());
+	TestFalse(TEXT("Outcome after Cancel is dropped"), Cancelled.TryFinish());
+	TestTrue(TEXT("Late outcome does not undo Cancel"), Cancelled.IsCancelled());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRequestHandleQueuedTest,
+	"AINiagara.GeminiRequestHandle.CancelQueued",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiRequestHandleQueuedTest::RunTest(const FString& Parameters)
+{
+	FGeminiEndpointLimits Limits;
+	Limits.MaxInFlight = 1;
+	Limits.MaxRequestsPerSecond = 100.0;
+	Limits.Burst = 100.0;
+
+	FGeminiRequestScheduler Scheduler;
+	Scheduler.SetAutoPump(false);
+	Scheduler.SetLimits(EGeminiEndpoint::Chat, Limits);
+
+	TArray<FString> Started;
+	TArray<FGeminiRequestHandle> Handles;
+	for (const TCHAR* Name : { TEXT("A"), TEXT("B"), TEXT("C"), TEXT("D") })
+	{
+		const FGeminiRequestHandle Handle = FGeminiRequestHandle::MakePending();
+		Handles.Add(Handle);
+		Scheduler.Enqueue(EGeminiEndpoint::Chat, EGeminiRequestPriority::Interactive, [&Started, Name]() { Started.Add(Name); }, [Handle]() { return Handle.IsCancelled(); });
+	}
+	TestEqual(TEXT("Only the first request starts"), FString::Join(Started, TEXT("")), FString(TEXT("A")));
+
+	// B is next in line and C is further back; neither may start or take a slot
+	Handles[1].Cancel();
+	Handles[2].Cancel();
+	Scheduler.OnRequestFinished(EGeminiEndpoint::Chat, 200);
+	TestEqual(TEXT("Cancelled requests are skipped"), FString::Join(Started, TEXT("")), FString(TEXT("AD")));
+
+	const FGeminiEndpointStats Stats = Scheduler.GetStats(EGeminiEndpoint::Chat);
+	TestEqual(TEXT("Cancelled requests are not counted as started"), Stats.NumStarted, 2);
+	TestEqual(TEXT("Queue is empty"), Stats.QueueDepth, 0);
+	TestEqual(TEXT("Only D is in flight"), Stats.InFlight, 1);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRequestHandleInFlightTest,
+	"AINiagara.GeminiRequestHandle.LoopbackCancelInFlight",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiRequestHandleInFlightTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+	FGeminiRequestScheduler::Get().ResetStats();
+
+	// The reply is held back long enough for the request to be aborted mid-flight
+	Server->SetTextReply(TEXT("campfire"));
+	Server->SetLatency(0.5);
+
+	TSharedRef<FCancelOutcome> Outcome = SendCancellableChat(Server->GetBaseURL(), false);
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Outcome]()
+	{
+		if (Server->GetNumRequests() == 0 && FPlatformTime::Seconds() - Outcome->StartSeconds < 5.0)
+		{
+			return false;
+		}
+		TestTrue(TEXT("Request reached the server"), Server->GetNumRequests() == 1);
+		Outcome->Cancel();
+		return true;
+	}));
+
+	// Wait past the server's latency so a reply that slipped through would have been delivered
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.0f));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Outcome]()
+	{
+		TestEqual(TEXT("No outcome is reported for a cancelled request"), Outcome->GetNumOutcomes(), 0);
+		TestTrue(TEXT("Handle is cancelled"), Outcome->Handle.IsCancelled());
+		TestEqual(TEXT("Aborted request released its slot"), FGeminiRequestScheduler::Get().GetStats(EGeminiEndpoint::Chat).InFlight, 0);
+
+		FGeminiRequestScheduler::Get().ResetStats();
+		return true;
+	}));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRequestHandleRaceTest,
+	"AINiagara.GeminiRequestHandle.LoopbackCancelRace",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiRequestHandleRaceTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+	FGeminiRequestScheduler::Get().ResetStats();
+	Server->SetTextReply(TEXT("campfire"));
+
+	// Request N is cancelled N frames after it was sent: some while queued or in flight,
+	// some with the reply already on its way to the game thread, some after delivery
+	struct FRace
+	{
+		TArray<TSharedRef<FCancelOutcome>> Requests;
+		int32 Frame = 0;
+		double StartSeconds = 0.0;
+	};
+	const int32 NumRequests = 12;
+	TSharedRef<FRace> Race = MakeShared<FRace>();
+	Race->StartSeconds = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < NumRequests; ++Index)
+	{
+		Race->Requests.Add(SendCancellableChat(Server->GetBaseURL(), false));
+	}
+	Race->Requests[0]->Cancel();
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Race, NumRequests]()
+	{
+		++Race->Frame;
+		if (Race->Frame < NumRequests)
+		{
+			Race->Requests[Race->Frame]->Cancel();
+		}
+
+		const bool bSettled = Race->Frame >= NumRequests
+			&& FGeminiRequestScheduler::Get().GetStats(EGeminiEndpoint::Chat).InFlight == 0;
+		if (!bSettled && FPlatformTime::Seconds() - Race->StartSeconds < 10.0)
+		{
+			return false;
+		}
+
+		int32 NumDelivered = 0;
+		for (const TSharedRef<FCancelOutcome>& Request : Race->Requests)
+		{
+			TestTrue(TEXT("At most one outcome per request"), Request->GetNumOutcomes() <= 1);
+			TestFalse(TEXT("No delegate runs after Cancel"), Request->bCalledAfterCancel);
+			TestFalse(TEXT("No request is left pending"), Request->Handle.IsPending());
+			TestEqual(TEXT("A request is either delivered or cancelled"), Request->Handle.IsCancelled(), Request->GetNumOutcomes() == 0);
+			NumDelivered += Request->NumResponses;
+		}
+		TestEqual(TEXT("Request cancelled right after sending gets nothing"), Race->Requests[0]->GetNumOutcomes(), 0);
+		TestEqual(TEXT("All slots released"), FGeminiRequestScheduler::Get().GetStats(EGeminiEndpoint::Chat).InFlight, 0);
+		AddInfo(FString::Printf(TEXT("%d of %d requests delivered before their cancellation"), NumDelivered, NumRequests));
+
+		FGeminiRequestScheduler::Get().ResetStats();
+		return true;
+	}));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRequestHandleStreamTest,
+	"AINiagara.GeminiRequestHandle.LoopbackCancelStream",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiRequestHandleStreamTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+	FGeminiRequestScheduler::Get().ResetStats();
+	Server->SetTextReply(TEXT("A campfire with rising embers"), 4);
+
+	TSharedRef<FCancelOutcome> Outcome = SendCancellableChat(Server->GetBaseURL(), true);
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Outcome]()
+	{
+		if (Outcome->Chunks.Num() == 0 && Outcome->GetNumOutcomes() == 0 && FPlatformTime::Seconds() - Outcome->StartSeconds < 10.0)
+		{
+			return false;
+		}
+		return true;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.5f));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Outcome]()
+	{
+		TestEqual(TEXT("Chunks after Cancel are dropped"), Outcome->Chunks.Num(), 1);
+		TestEqual(TEXT("Cancelled stream reports no outcome"), Outcome->GetNumOutcomes(), 0);
+		TestFalse(TEXT("No delegate runs after Cancel"), Outcome->bCalledAfterCancel);
+
+		FGeminiRequestScheduler::Get().ResetStats();
+		return true;
+	}));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,312 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/GeminiRequestScheduler.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Scheduler on a stepped clock that only starts requests on explicit pumps */
+	struct FSchedulerFixture
+	{
+		double Now = 100.0;
+		FGeminiRequestScheduler Scheduler;
+		TArray<FString> Started;
+
+		explicit FSchedulerFixture(const FGeminiEndpointLimits& Limits)
+		{
+			Scheduler.SetAutoPump(false);
+			Scheduler.SetClock([this]() { return Now; });
+			Scheduler.SetLimits(EGeminiEndpoint::Image, Limits);
+		}
+
+		void Enqueue(const FString& Name, EGeminiRequestPriority Priority)
+		{
+			Scheduler.Enqueue(EGeminiEndpoint::Image, Priority, [this, Name]() { Started.Add(Name); });
+		}
+
+		void Advance(double Seconds)
+		{
+			Now += Seconds;
+			Scheduler.Pump();
+		}
+	};
+
+	FGeminiEndpointLimits MakeLimits(int32 MaxInFlight, double RequestsPerSecond, double Burst)
+	{
+		FGeminiEndpointLimits Limits;
+		Limits.MaxInFlight = MaxInFlight;
+		Limits.MaxRequestsPerSecond = RequestsPerSecond;
+		Limits.MinRequestsPerSecond = 0.1;
+		Limits.Burst = Burst;
+		Limits.RecoveryPerSuccess = 0.25;
+		return Limits;
+	}
+
+	/**
+	 * Simulated Imagen quota: at most QuotaPerWindow requests per one-second window,
+	 * anything beyond is answered with 429 and Retry-After: 1
+	 */
+	struct FQuotaSimulation
+	{
+		static constexpr int32 QuotaPerWindow = 3;
+		static constexpr double Latency = 0.8;
+
+		int32 NumThrottled = 0;
+		int32 NumSucceeded = 0;
+		double LastFinishSeconds = 0.0;
+
+		int32 WindowIndex = -1;
+		int32 WindowCount = 0;
+
+		/** Answer a request arriving at Now */
+		int32 Respond(double Now)
+		{
+			const int32 Window = FMath::FloorToInt32(Now);
+			if (Window != WindowIndex)
+			{
+				WindowIndex = Window;
+				WindowCount = 0;
+			}
+			return ++WindowCount <= QuotaPerWindow ? 200 : 429;
+		}
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRequestSchedulerPriorityTest,
+	"AINiagara.GeminiRequestScheduler.PriorityAndConcurrency",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiRequestSchedulerPriorityTest::RunTest(const FString& Parameters)
+{
+	FSchedulerFixture Fixture(MakeLimits(2, 100.0, 100.0));
+
+	Fixture.Enqueue(TEXT("Frame0"), EGeminiRequestPriority::Background);
+	Fixture.Enqueue(TEXT("Frame1"), EGeminiRequestPriority::Background);
+	Fixture.Enqueue(TEXT("Frame2"), EGeminiRequestPriority::Background);
+	Fixture.Enqueue(TEXT("Shader"), EGeminiRequestPriority::Tool);
+	Fixture.Enqueue(TEXT("Chat"), EGeminiRequestPriority::Interactive);
+
+	TestEqual(TEXT("Only MaxInFlight requests start"), Fixture.Started.Num(), 2);
+	FGeminiEndpointStats Stats = Fixture.Scheduler.GetStats(EGeminiEndpoint::Image);
+	TestEqual(TEXT("Queue depth"), Stats.QueueDepth, 3);
+	TestEqual(TEXT("In flight"), Stats.InFlight, 2);
+
+	Fixture.Now += 0.5;
+	Fixture.Scheduler.OnRequestFinished(EGeminiEndpoint::Image, 200);
+	Fixture.Scheduler.OnRequestFinished(EGeminiEndpoint::Image, 200);
+	Fixture.Scheduler.OnRequestFinished(EGeminiEndpoint::Image, 200);
+
+	const TArray<FString> ExpectedOrder = { TEXT("Frame0"), TEXT("Frame1"), TEXT("Chat"), TEXT("Shader"), TEXT("Frame2") };
+	TestEqual(TEXT("All requests started"), Fixture.Started.Num(), ExpectedOrder.Num());
+	for (int32 Index = 0; Index < FMath::Min(Fixture.Started.Num(), ExpectedOrder.Num()); ++Index)
+	{
+		TestEqual(FString::Printf(TEXT("Start order %d"), Index), Fixture.Started[Index], ExpectedOrder[Index]);
+	}
+
+	Stats = Fixture.Scheduler.GetStats(EGeminiEndpoint::Image);
+	TestEqual(TEXT("Queue drained"), Stats.QueueDepth, 0);
+	TestEqual(TEXT("Started count"), Stats.NumStarted, 5);
+	TestTrue(TEXT("Queued requests report their wait"), FMath::IsNearlyEqual(Stats.MaxWaitSeconds, 0.5));
+
+	// Other endpoints are independent
+	TestEqual(TEXT("Chat endpoint untouched"), Fixture.Scheduler.GetStats(EGeminiEndpoint::Chat).NumStarted, 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRequestSchedulerRateLimitTest,
+	"AINiagara.GeminiRequestScheduler.TokenBucket",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiRequestSchedulerRateLimitTest::RunTest(const FString& Parameters)
+{
+	FSchedulerFixture Fixture(MakeLimits(100, 1.0, 2.0));
+
+	for (int32 Index = 0; Index < 6; ++Index)
+	{
+		Fixture.Enqueue(FString::Printf(TEXT("Request%d"), Index), EGeminiRequestPriority::Background);
+	}
+	TestEqual(TEXT("Burst starts immediately"), Fixture.Started.Num(), 2);
+
+	Fixture.Advance(0.5);
+	TestEqual(TEXT("No token after half a second"), Fixture.Started.Num(), 2);
+	Fixture.Advance(0.5);
+	TestEqual(TEXT("One token per second"), Fixture.Started.Num(), 3);
+
+	// 429 halves the rate and holds everything until Retry-After has passed
+	Fixture.Scheduler.OnRequestFinished(EGeminiEndpoint::Image, 429, 3.0);
+	FGeminiEndpointStats Stats = Fixture.Scheduler.GetStats(EGeminiEndpoint::Image);
+	TestEqual(TEXT("Throttle counted"), Stats.NumThrottled, 1);
+	TestTrue(TEXT("Rate halved"), FMath::IsNearlyEqual(Stats.RequestsPerSecond, 0.5));
+
+	Fixture.Advance(2.5);
+	TestEqual(TEXT("Nothing starts before Retry-After"), Fixture.Started.Num(), 3);
+	Fixture.Advance(0.5);
+	TestEqual(TEXT("Tokens earned at the halved rate"), Fixture.Started.Num(), 4);
+
+	// Successes recover the rate additively, up to the configured maximum
+	for (int32 Index = 0; Index < 3; ++Index)
+	{
+		Fixture.Scheduler.OnRequestFinished(EGeminiEndpoint::Image, 200);
+	}
+	Stats = Fixture.Scheduler.GetStats(EGeminiEndpoint::Image);
+	TestTrue(TEXT("Rate recovered to the maximum"), FMath::IsNearlyEqual(Stats.RequestsPerSecond, 1.0));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRequestSchedulerCancelTest,
+	"AINiagara.GeminiRequestScheduler.CancelledRequests",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiRequestSchedulerCancelTest::RunTest(const FString& Parameters)
+{
+	FSchedulerFixture Fixture(MakeLimits(1, 100.0, 100.0));
+
+	TSet<FString> Cancelled;
+	for (const TCHAR* Name : { TEXT("Frame0"), TEXT("Frame1"), TEXT("Frame2"), TEXT("Frame3") })
+	{
+		const FString RequestName(Name);
+		Fixture.Scheduler.Enqueue(EGeminiEndpoint::Image, EGeminiRequestPriority::Background,
+			[&Fixture, RequestName]() { Fixture.Started.Add(RequestName); },
+			[&Cancelled, RequestName]() { return Cancelled.Contains(RequestName); });
+	}
+	TestEqual(TEXT("One request in flight"), Fixture.Started.Num(), 1);
+	TestEqual(TEXT("Three waiting"), Fixture.Scheduler.GetStats(EGeminiEndpoint::Image).QueueDepth, 3);
+
+	// Frame2 is behind Frame1 in the queue, so it is not at the top when cancelled
+	Cancelled.Add(TEXT("Frame2"));
+	TestEqual(TEXT("Buried cancellation is not counted before a pump"), Fixture.Scheduler.GetStats(EGeminiEndpoint::Image).QueueDepth, 2);
+	Fixture.Scheduler.Pump();
+	TestEqual(TEXT("Buried cancellation is dropped by a pump"), Fixture.Scheduler.GetStats(EGeminiEndpoint::Image).QueueDepth, 2);
+
+	Fixture.Scheduler.OnRequestFinished(EGeminiEndpoint::Image, 200);
+	Fixture.Scheduler.OnRequestFinished(EGeminiEndpoint::Image, 200);
+	Fixture.Scheduler.OnRequestFinished(EGeminiEndpoint::Image, 200);
+
+	const TArray<FString> ExpectedOrder = { TEXT("Frame0"), TEXT("Frame1"), TEXT("Frame3") };
+	TestEqual(TEXT("Cancelled request never starts"), Fixture.Started.Num(), ExpectedOrder.Num());
+	for (int32 Index = 0; Index < FMath::Min(Fixture.Started.Num(), ExpectedOrder.Num()); ++Index)
+	{
+		TestEqual(FString::Printf(TEXT("Start order %d"), Index), Fixture.Started[Index], ExpectedOrder[Index]);
+	}
+	TestEqual(TEXT("Queue drained"), Fixture.Scheduler.GetStats(EGeminiEndpoint::Image).QueueDepth, 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRequestSchedulerRetryAfterTest,
+	"AINiagara.GeminiRequestScheduler.RetryAfter",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiRequestSchedulerRetryAfterTest::RunTest(const FString& Parameters)
+{
+	TestEqual(TEXT("Delta seconds"), FGeminiRequestScheduler::ParseRetryAfter(TEXT(" 7 ")), 7.0);
+	TestEqual(TEXT("Empty"), FGeminiRequestScheduler::ParseRetryAfter(TEXT("")), 0.0);
+	TestEqual(TEXT("Garbage"), FGeminiRequestScheduler::ParseRetryAfter(TEXT("soon")), 0.0);
+
+	const FDateTime InOneMinute = FDateTime::UtcNow() + FTimespan::FromSeconds(60.0);
+	const double DateDelay = FGeminiRequestScheduler::ParseRetryAfter(InOneMinute.ToHttpDate());
+	TestTrue(TEXT("HTTP date"), DateDelay > 55.0 && DateDelay <= 60.0);
+	TestEqual(TEXT("Past HTTP date"), FGeminiRequestScheduler::ParseRetryAfter(TEXT("Wed, 21 Oct 2015 07:28:00 GMT")), 0.0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRequestSchedulerBenchmarkTest,
+	"AINiagara.GeminiRequestScheduler.Benchmark.FlipbookBurst",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter
+)
+
+bool FGeminiRequestSchedulerBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const int32 NumFrames = 16;
+	const double Step = 0.05;
+
+	// Unscheduled: every frame is sent at once, as GenerateFlipbook used to do
+	FQuotaSimulation Burst;
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		if (Burst.Respond(0.0) == 429)
+		{
+			++Burst.NumThrottled;
+		}
+	}
+
+	// Scheduled: default Image limits; throttled frames are queued again
+	FQuotaSimulation Scheduled;
+	double Now = 0.0;
+	FGeminiRequestScheduler Scheduler;
+	Scheduler.SetAutoPump(false);
+	Scheduler.SetClock([&Now]() { return Now; });
+
+	TArray<TPair<double, int32>> InFlight;
+	TFunction<void()> EnqueueFrame;
+	EnqueueFrame = [&]()
+	{
+		Scheduler.Enqueue(EGeminiEndpoint::Image, EGeminiRequestPriority::Background, [&]()
+		{
+			const int32 Code = Scheduled.Respond(Now);
+			InFlight.Add(TPair<double, int32>(Now + FQuotaSimulation::Latency, Code));
+		});
+	};
+
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		EnqueueFrame();
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	while (Scheduled.NumSucceeded < NumFrames && Now < 600.0)
+	{
+		Now += Step;
+		for (int32 Index = InFlight.Num() - 1; Index >= 0; --Index)
+		{
+			if (InFlight[Index].Key > Now)
+			{
+				continue;
+			}
+			const int32 Code = InFlight[Index].Value;
+			InFlight.RemoveAtSwap(Index);
+
+			if (Code == 429)
+			{
+				++Scheduled.NumThrottled;
+				Scheduler.OnRequestFinished(EGeminiEndpoint::Image, Code, 1.0);
+				EnqueueFrame();
+			}
+			else
+			{
+				++Scheduled.NumSucceeded;
+				Scheduled.LastFinishSeconds = Now;
+				Scheduler.OnRequestFinished(EGeminiEndpoint::Image, Code);
+			}
+		}
+		Scheduler.Pump();
+	}
+	const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	const FGeminiEndpointStats Stats = Scheduler.GetStats(EGeminiEndpoint::Image);
+	TestEqual(TEXT("Every frame completes"), Scheduled.NumSucceeded, NumFrames);
+	TestTrue(TEXT("Scheduling throttles less than a burst"), Scheduled.NumThrottled < Burst.NumThrottled);
+
+	AddInfo(FString::Printf(TEXT("%d-frame flipbook against a %d/s quota: burst gets %d x 429; scheduled gets %d x 429, done after %.1f s simulated (avg wait %.2f s, max %.2f s)"),
+		NumFrames, FQuotaSimulation::QuotaPerWindow, Burst.NumThrottled, Scheduled.NumThrottled, Scheduled.LastFinishSeconds,
+		Stats.GetAverageWaitSeconds(), Stats.MaxWaitSeconds));
+	AddInfo(FString::Printf(TEXT("Scheduler overhead: %.3f ms for %d simulated steps"), ElapsedMs, FMath::RoundToInt32(Now / Step)));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
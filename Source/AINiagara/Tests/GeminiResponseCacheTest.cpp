@@ -0,0 +1,274 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "Core/GeminiAPIClient.h"
+#include "Core/GeminiResponseCache.h"
+#include "GeminiTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Empty transient folder for one test */
+	FString MakeCacheDirectory(const TCHAR* Name)
+	{
+		const FString Directory = FPaths::AutomationTransientDir() / TEXT("ResponseCache") / Name;
+		IFileManager::Get().DeleteDirectory(*Directory, false, true);
+		return Directory;
+	}
+
+	/** What one request reported */
+	struct FCacheOutcome
+	{
+		FString Response;
+		TArray<FString> Chunks;
+		int32 ErrorCode = 0;
+		bool bDone = false;
+		double StartSeconds = 0.0;
+	};
+
+	/** Send a request from a client that goes out of scope before the reply arrives */
+	TSharedRef<FCacheOutcome> StartRequest(const FString& BaseURL, const FString& Prompt, bool bStream)
+	{
+		TSharedRef<FCacheOutcome> Outcome = MakeShared<FCacheOutcome>();
+		Outcome->StartSeconds = FPlatformTime::Seconds();
+
+		FGeminiAPIClient Client;
+		Client.SetAPIKey(TEXT("loopback-key"), false);
+		Client.SetBaseURL(BaseURL);
+
+		FOnGeminiResponse OnResponse = FOnGeminiResponse::CreateLambda([Outcome](const FString& ResponseText)
+		{
+			Outcome->Response = ResponseText;
+			Outcome->bDone = true;
+		});
+		FOnGeminiError OnError = FOnGeminiError::CreateLambda([Outcome](int32 ErrorCode, const FString& ErrorMessage)
+		{
+			Outcome->ErrorCode = ErrorCode;
+			Outcome->bDone = true;
+		});
+
+		if (bStream)
+		{
+			Client.StreamChatCompletion(Prompt, TArray<FConversationMessage>(), TArray<FVFXToolFunction>(),
+				FOnGeminiStreamChunk::CreateLambda([Outcome](const FString& ChunkText, const FGeminiStreamStats& Stats)
+				{
+					Outcome->Chunks.Add(ChunkText);
+				}),
+				OnResponse, OnError);
+		}
+		else
+		{
+			Client.SendChatCompletion(Prompt, TArray<FConversationMessage>(), TArray<FVFXToolFunction>(), OnResponse, OnError);
+		}
+		return Outcome;
+	}
+
+	/** Latent step that waits for a request started by the previous step */
+	bool IsFinished(const TSharedPtr<FCacheOutcome>& Outcome)
+	{
+		return !Outcome.IsValid() || Outcome->bDone || FPlatformTime::Seconds() - Outcome->StartSeconds > 10.0;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiResponseCacheKeyTest,
+	"AINiagara.GeminiResponseCache.Key",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiResponseCacheKeyTest::RunTest(const FString& Parameters)
+{
+	const FString Endpoint = TEXT("/models/gemini-pro:generateContent");
+	const FString Payload = TEXT("{\"contents\":[{\"role\":\"user\",\"parts\":[{\"text\":\"Make a campfire\"}]}]}");
+	const FString Key = FGeminiResponseCache::MakeKey(Endpoint, Payload);
+
+	TestEqual(TEXT("Key is a SHA-1 in hex"), Key.Len(), 40);
+	TestEqual(TEXT("Same request, same key"), FGeminiResponseCache::MakeKey(Endpoint, Payload), Key);
+	TestNotEqual(TEXT("Payload changes the key"), FGeminiResponseCache::MakeKey(Endpoint, Payload.Replace(TEXT("campfire"), TEXT("torch"))), Key);
+	TestNotEqual(TEXT("Endpoint changes the key"), FGeminiResponseCache::MakeKey(TEXT("/models/gemini-pro:streamGenerateContent"), Payload), Key);
+
+	EGeminiResponseCacheMode Mode;
+	TestTrue(TEXT("Parses replay"), FGeminiResponseCache::ParseMode(TEXT("Replay"), Mode) && Mode == EGeminiResponseCacheMode::ReplayOnly);
+	TestFalse(TEXT("Rejects unknown modes"), FGeminiResponseCache::ParseMode(TEXT("sometimes"), Mode));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiResponseCacheEvictionTest,
+	"AINiagara.GeminiResponseCache.Eviction",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiResponseCacheEvictionTest::RunTest(const FString& Parameters)
+{
+	const FString Directory = MakeCacheDirectory(TEXT("Eviction"));
+	const FString Body = FString::ChrN(1000, TEXT('x'));
+
+	{
+		// Room for three replies
+		FGeminiResponseCache Cache(Directory, 3500);
+		Cache.Store(TEXT("A"), Body);
+		Cache.Store(TEXT("B"), Body);
+		Cache.Store(TEXT("C"), Body);
+
+		FString Found;
+		TestTrue(TEXT("Stored reply is found"), Cache.Find(TEXT("A"), Found));
+		TestEqual(TEXT("Reply round-trips"), Found, Body);
+		TestFalse(TEXT("Unknown key misses"), Cache.Find(TEXT("Z"), Found));
+		TestTrue(TEXT("Index knows stored keys"), Cache.Contains(TEXT("B")));
+		TestFalse(TEXT("Index misses unknown keys"), Cache.Contains(TEXT("Z")));
+
+		// A was used after B, so B is the least recently used
+		Cache.Store(TEXT("D"), Body);
+		TestTrue(TEXT("Recently used entry survives"), Cache.Find(TEXT("A"), Found));
+		TestFalse(TEXT("Least recently used entry is evicted"), Cache.Find(TEXT("B"), Found));
+		TestTrue(TEXT("New entry is kept"), Cache.Find(TEXT("D"), Found));
+
+		const FGeminiResponseCacheStats Stats = Cache.GetStats();
+		TestEqual(TEXT("Entries"), Stats.NumEntries, 3);
+		TestEqual(TEXT("Evictions"), Stats.NumEvictions, 1);
+		TestTrue(TEXT("Size stays within the limit"), Stats.TotalBytes <= 3500);
+	}
+
+	{
+		// A new instance indexes what the previous one left on disk
+		FGeminiResponseCache Cache(Directory, 3500);
+		FString Found;
+		TestEqual(TEXT("Entries survive a restart"), Cache.GetStats().NumEntries, 3);
+		TestTrue(TEXT("Reply survives a restart"), Cache.Find(TEXT("C"), Found) && Found == Body);
+
+		// A file deleted behind the cache's back is a miss and leaves the index
+		IFileManager::Get().Delete(*(Directory / TEXT("D.json")));
+		TestTrue(TEXT("Index still lists the deleted entry"), Cache.Contains(TEXT("D")));
+		TestFalse(TEXT("Deleted entry misses"), Cache.Find(TEXT("D"), Found));
+		TestFalse(TEXT("Deleted entry leaves the index"), Cache.Contains(TEXT("D")));
+		TestEqual(TEXT("Remaining entries"), Cache.GetStats().NumEntries, 2);
+
+		Cache.SetMaxBytes(1500);
+		TestEqual(TEXT("Shrinking the limit evicts"), Cache.GetStats().NumEntries, 1);
+		TestTrue(TEXT("Most recently used entry is the one kept"), Cache.Find(TEXT("C"), Found));
+
+		Cache.Clear();
+		TestEqual(TEXT("Clear removes everything"), Cache.GetStats().NumEntries, 0);
+	}
+
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiResponseCacheReplayTest,
+	"AINiagara.GeminiResponseCache.LoopbackReplay",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiResponseCacheReplayTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+
+	// Record into a transient folder, and put the shared cache back afterwards
+	FGeminiResponseCache& Cache = FGeminiResponseCache::Get();
+	const FString PreviousDirectory = Cache.GetDirectory();
+	const EGeminiResponseCacheMode PreviousMode = Cache.GetMode();
+	Cache.SetDirectory(MakeCacheDirectory(TEXT("LoopbackReplay")));
+	Cache.SetMode(EGeminiResponseCacheMode::ReadWrite);
+
+	const FString BaseURL = Server->GetBaseURL();
+	const TArray<FString> StreamChunks = { TEXT("camp"), TEXT("fire") };
+	Server->SetReply(200, TEXT("application/json"), GeminiTestHelpers::MakeChunkJson(TEXT("campfire"), TEXT("STOP")));
+
+	TSharedRef<TSharedPtr<FCacheOutcome>> Current = MakeShared<TSharedPtr<FCacheOutcome>>();
+
+	// 1. First request reaches the network and is recorded
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([Current, BaseURL]()
+	{
+		*Current = StartRequest(BaseURL, TEXT("Make a campfire"), false);
+		return true;
+	}));
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Current, Server, BaseURL]()
+	{
+		if (!IsFinished(*Current))
+		{
+			return false;
+		}
+		TestEqual(TEXT("Recorded reply"), (*Current)->Response, FString(TEXT("campfire")));
+		TestEqual(TEXT("First request reaches the loopback"), Server->GetNumRequests(), 1);
+
+		// 2. The identical request is answered from disk
+		*Current = StartRequest(BaseURL, TEXT("Make a campfire"), false);
+		return true;
+	}));
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Current, Server, BaseURL]()
+	{
+		if (!IsFinished(*Current))
+		{
+			return false;
+		}
+		TestEqual(TEXT("Cached reply"), (*Current)->Response, FString(TEXT("campfire")));
+		TestEqual(TEXT("Cached request does not reach the loopback"), Server->GetNumRequests(), 1);
+
+		// 3. Record a stream
+		Server->SetReply(200, TEXT("text/event-stream"), GeminiTestHelpers::MakeSSEBody(StreamChunks));
+		*Current = StartRequest(BaseURL, TEXT("Make a campfire"), true);
+		return true;
+	}));
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Current, Server, BaseURL, StreamChunks]()
+	{
+		if (!IsFinished(*Current))
+		{
+			return false;
+		}
+		TestEqual(TEXT("Streams are cached separately from generateContent"), Server->GetNumRequests(), 2);
+		TestEqual(TEXT("Recorded stream"), (*Current)->Response, FString::Join(StreamChunks, TEXT("")));
+
+		// 4. Replay only: the stream comes back chunk by chunk without the network
+		FGeminiResponseCache::Get().SetMode(EGeminiResponseCacheMode::ReplayOnly);
+		*Current = StartRequest(BaseURL, TEXT("Make a campfire"), true);
+		return true;
+	}));
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Current, Server, BaseURL, StreamChunks]()
+	{
+		if (!IsFinished(*Current))
+		{
+			return false;
+		}
+		TestEqual(TEXT("Replayed chunk count"), (*Current)->Chunks.Num(), StreamChunks.Num());
+		TestEqual(TEXT("Replayed stream"), (*Current)->Response, FString::Join(StreamChunks, TEXT("")));
+		TestEqual(TEXT("Replay does not reach the loopback"), Server->GetNumRequests(), 2);
+
+		// 5. Replay only: a request that was never recorded fails instead of going out
+		*Current = StartRequest(BaseURL, TEXT("Make a torch"), false);
+		return true;
+	}));
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Current, Server, PreviousDirectory, PreviousMode]()
+	{
+		if (!IsFinished(*Current))
+		{
+			return false;
+		}
+		TestEqual(TEXT("Replay miss is reported"), (*Current)->ErrorCode, 404);
+		TestEqual(TEXT("Replay miss does not reach the loopback"), Server->GetNumRequests(), 2);
+
+		FGeminiResponseCache& SharedCache = FGeminiResponseCache::Get();
+		const FGeminiResponseCacheStats Stats = SharedCache.GetStats();
+		AddInfo(FString::Printf(TEXT("%d entries, %d hits, %d misses"), Stats.NumEntries, Stats.NumHits, Stats.NumMisses));
+
+		SharedCache.Clear();
+		SharedCache.SetDirectory(PreviousDirectory);
+		SharedCache.SetMode(PreviousMode);
+		return true;
+	}));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
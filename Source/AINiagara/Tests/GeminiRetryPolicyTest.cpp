@@ -0,0 +1,315 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/GeminiAPIClient.h"
+#include "Core/GeminiRetryPolicy.h"
+#include "GeminiTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** What a request reported, and what the test expects of it */
+	struct FRetryOutcome
+	{
+		FString Response;
+		TArray<FString> Chunks;
+		int32 ErrorCode = 0;
+		bool bDone = false;
+		double StartSeconds = 0.0;
+
+		int32 ExpectedRequests = 0;
+		int32 ExpectedErrorCode = 0;
+		FString ExpectedResponse;
+	};
+
+	/** Short delays so the loopback tests finish quickly */
+	FGeminiRequestOptions MakeFastRetryOptions(int32 MaxAttempts)
+	{
+		FGeminiRequestOptions Options;
+		Options.RetryPolicy.MaxAttempts = MaxAttempts;
+		Options.RetryPolicy.InitialDelaySeconds = 0.05;
+		Options.RetryPolicy.MaxDelaySeconds = 2.0;
+		return Options;
+	}
+
+	/** Start from a full retry budget and an unthrottled scheduler */
+	void ResetSharedState()
+	{
+		FGeminiRetryBudget::Get().Reset();
+		FGeminiRequestScheduler::Get().ResetStats();
+	}
+
+	/** Send a request from a client that goes out of scope before the reply arrives */
+	void StartRequest(const FString& BaseURL, TSharedRef<FRetryOutcome> Outcome, const FGeminiRequestOptions& Options, bool bStream)
+	{
+		FGeminiAPIClient Client;
+		Client.SetAPIKey(TEXT("loopback-key"), false);
+		Client.SetBaseURL(BaseURL);
+
+		FOnGeminiResponse OnResponse = FOnGeminiResponse::CreateLambda([Outcome](const FString& ResponseText)
+		{
+			Outcome->Response = ResponseText;
+			Outcome->bDone = true;
+		});
+		FOnGeminiError OnError = FOnGeminiError::CreateLambda([Outcome](int32 ErrorCode, const FString& ErrorMessage)
+		{
+			Outcome->ErrorCode = ErrorCode;
+			Outcome->bDone = true;
+		});
+
+		Outcome->StartSeconds = FPlatformTime::Seconds();
+		if (bStream)
+		{
+			Client.StreamChatCompletion(
+				TEXT("Make a campfire"),
+				TArray<FConversationMessage>(),
+				TArray<FVFXToolFunction>(),
+				FOnGeminiStreamChunk::CreateLambda([Outcome](const FString& ChunkText, const FGeminiStreamStats& Stats)
+				{
+					Outcome->Chunks.Add(ChunkText);
+				}),
+				OnResponse,
+				OnError,
+				Options
+			);
+		}
+		else
+		{
+			Client.SendChatCompletion(TEXT("Make a campfire"), TArray<FConversationMessage>(), TArray<FVFXToolFunction>(), OnResponse, OnError, Options);
+		}
+	}
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_THREE_PARAMETER(FVerifyGeminiRetryCommand, FAutomationTestBase*, Test, TSharedRef<FRetryOutcome>, Outcome, TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer>, Server);
+
+bool FVerifyGeminiRetryCommand::Update()
+{
+	if (!Outcome->bDone && FPlatformTime::Seconds() - Outcome->StartSeconds < 15.0)
+	{
+		return false;
+	}
+
+	Test->TestTrue(TEXT("Request completed"), Outcome->bDone);
+	Test->TestEqual(TEXT("Requests sent to the loopback"), Server->GetNumRequests(), Outcome->ExpectedRequests);
+	Test->TestEqual(TEXT("Error code"), Outcome->ErrorCode, Outcome->ExpectedErrorCode);
+	Test->TestEqual(TEXT("Response text"), Outcome->Response, Outcome->ExpectedResponse);
+	if (Outcome->Chunks.Num() > 0)
+	{
+		Test->TestEqual(TEXT("Chunks of failed attempts are not reported"), FString::Join(Outcome->Chunks, TEXT("")), Outcome->ExpectedResponse);
+	}
+	Test->AddInfo(FString::Printf(TEXT("%d request(s) in %.2f s"), Server->GetNumRequests(), FPlatformTime::Seconds() - Outcome->StartSeconds));
+
+	ResetSharedState();
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRetryPolicyDelayTest,
+	"AINiagara.GeminiRetry.Policy",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiRetryPolicyDelayTest::RunTest(const FString& Parameters)
+{
+	TestTrue(TEXT("Connection failures are retried"), FGeminiRetryPolicy::IsRetryable(0, false));
+	for (int32 Code : { 408, 429, 500, 502, 503, 504 })
+	{
+		TestTrue(FString::Printf(TEXT("%d is retried"), Code), FGeminiRetryPolicy::IsRetryable(Code, true));
+	}
+	for (int32 Code : { 200, 400, 401, 403, 404, 501 })
+	{
+		TestFalse(FString::Printf(TEXT("%d is not retried"), Code), FGeminiRetryPolicy::IsRetryable(Code, true));
+	}
+
+	FGeminiRetryPolicy Policy;
+	Policy.InitialDelaySeconds = 1.0;
+	Policy.Multiplier = 2.0;
+	Policy.MaxDelaySeconds = 5.0;
+	FRandomStream Random(1234);
+
+	// Without jitter the delay is the backoff cap itself
+	Policy.bUseJitter = false;
+	TestEqual(TEXT("First retry"), Policy.GetDelay(0, 0.0, Random), 1.0);
+	TestEqual(TEXT("Second retry doubles"), Policy.GetDelay(1, 0.0, Random), 2.0);
+	TestEqual(TEXT("Third retry doubles"), Policy.GetDelay(2, 0.0, Random), 4.0);
+	TestEqual(TEXT("Backoff is capped"), Policy.GetDelay(3, 0.0, Random), 5.0);
+	TestEqual(TEXT("Retry-After is a lower bound"), Policy.GetDelay(0, 3.0, Random), 3.0);
+	TestTrue(TEXT("Retry-After beyond MaxDelaySeconds gives up"), Policy.GetDelay(0, 6.0, Random) < 0.0);
+
+	// Full jitter spreads delays over [0, cap]
+	Policy.bUseJitter = true;
+	double MinDelay = TNumericLimits<double>::Max();
+	double MaxDelay = 0.0;
+	for (int32 Sample = 0; Sample < 1000; ++Sample)
+	{
+		const double Delay = Policy.GetDelay(2, 0.0, Random);
+		MinDelay = FMath::Min(MinDelay, Delay);
+		MaxDelay = FMath::Max(MaxDelay, Delay);
+	}
+	TestTrue(TEXT("Jittered delays are within [0, cap]"), MinDelay >= 0.0 && MaxDelay <= 4.0);
+	TestTrue(TEXT("Jittered delays cover the range"), MinDelay < 1.0 && MaxDelay > 3.0);
+
+	for (int32 Sample = 0; Sample < 100; ++Sample)
+	{
+		if (Policy.GetDelay(0, 2.5, Random) < 2.5)
+		{
+			AddError(TEXT("Jittered delay is shorter than Retry-After"));
+			break;
+		}
+	}
+
+	TestEqual(TEXT("NoRetry allows a single attempt"), FGeminiRetryPolicy::NoRetry().MaxAttempts, 1);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRetryBudgetTest,
+	"AINiagara.GeminiRetry.Budget",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiRetryBudgetTest::RunTest(const FString& Parameters)
+{
+	FGeminiRetryBudget Budget(3.0, 0.5);
+
+	TestTrue(TEXT("Initial allowance 1"), Budget.TryWithdraw());
+	TestTrue(TEXT("Initial allowance 2"), Budget.TryWithdraw());
+	TestTrue(TEXT("Initial allowance 3"), Budget.TryWithdraw());
+	TestFalse(TEXT("Exhausted budget refuses retries"), Budget.TryWithdraw());
+
+	Budget.OnRequest();
+	TestFalse(TEXT("Half a token is not a retry"), Budget.TryWithdraw());
+	Budget.OnRequest();
+	TestTrue(TEXT("Two requests earn one retry"), Budget.TryWithdraw());
+
+	for (int32 Request = 0; Request < 100; ++Request)
+	{
+		Budget.OnRequest();
+	}
+	TestEqual(TEXT("Balance is capped"), Budget.GetBalance(), 3.0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRetryTransientTest,
+	"AINiagara.GeminiRetry.LoopbackTransient",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiRetryTransientTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+	ResetSharedState();
+
+	// An overloaded backend, then a quota error with Retry-After, then success
+	Server->QueueReply(503, TEXT("application/json"), TEXT("{\"error\": {\"code\": 503, \"status\": \"UNAVAILABLE\"}}"));
+	Server->QueueReply(429, TEXT("application/json"), TEXT("{\"error\": {\"code\": 429, \"status\": \"RESOURCE_EXHAUSTED\"}}"), TEXT("1"));
+	Server->SetReply(200, TEXT("application/json"), GeminiTestHelpers::MakeChunkJson(TEXT("campfire"), TEXT("STOP")));
+
+	TSharedRef<FRetryOutcome> Outcome = MakeShared<FRetryOutcome>();
+	Outcome->ExpectedRequests = 3;
+	Outcome->ExpectedResponse = TEXT("campfire");
+
+	StartRequest(Server->GetBaseURL(), Outcome, MakeFastRetryOptions(3), false);
+	ADD_LATENT_AUTOMATION_COMMAND(FVerifyGeminiRetryCommand(this, Outcome, Server));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRetryExhaustedTest,
+	"AINiagara.GeminiRetry.LoopbackExhausted",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiRetryExhaustedTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+	ResetSharedState();
+
+	Server->SetReply(503, TEXT("application/json"), TEXT("{\"error\": {\"code\": 503, \"status\": \"UNAVAILABLE\"}}"));
+
+	TSharedRef<FRetryOutcome> Outcome = MakeShared<FRetryOutcome>();
+	Outcome->ExpectedRequests = 3;
+	Outcome->ExpectedErrorCode = 503;
+
+	StartRequest(Server->GetBaseURL(), Outcome, MakeFastRetryOptions(3), false);
+	ADD_LATENT_AUTOMATION_COMMAND(FVerifyGeminiRetryCommand(this, Outcome, Server));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRetryPermanentErrorTest,
+	"AINiagara.GeminiRetry.LoopbackPermanentError",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiRetryPermanentErrorTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+	ResetSharedState();
+
+	// A malformed request fails the same way every time
+	Server->SetReply(400, TEXT("application/json"), TEXT("{\"error\": {\"code\": 400, \"status\": \"INVALID_ARGUMENT\"}}"));
+
+	TSharedRef<FRetryOutcome> Outcome = MakeShared<FRetryOutcome>();
+	Outcome->ExpectedRequests = 1;
+	Outcome->ExpectedErrorCode = 400;
+
+	StartRequest(Server->GetBaseURL(), Outcome, MakeFastRetryOptions(3), false);
+	ADD_LATENT_AUTOMATION_COMMAND(FVerifyGeminiRetryCommand(this, Outcome, Server));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiRetryStreamTest,
+	"AINiagara.GeminiRetry.LoopbackStream",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiRetryStreamTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+	ResetSharedState();
+
+	// Nothing was streamed before the 503, so the stream is retried
+	const TArray<FString> Chunks = { TEXT("camp"), TEXT("fire") };
+	Server->QueueReply(503, TEXT("application/json"), TEXT("{\"error\": {\"code\": 503, \"status\": \"UNAVAILABLE\"}}"));
+	Server->SetReply(200, TEXT("text/event-stream"), GeminiTestHelpers::MakeSSEBody(Chunks));
+
+	TSharedRef<FRetryOutcome> Outcome = MakeShared<FRetryOutcome>();
+	Outcome->ExpectedRequests = 2;
+	Outcome->ExpectedResponse = FString::Join(Chunks, TEXT(""));
+
+	StartRequest(Server->GetBaseURL(), Outcome, MakeFastRetryOptions(3), true);
+	ADD_LATENT_AUTOMATION_COMMAND(FVerifyGeminiRetryCommand(this, Outcome, Server));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
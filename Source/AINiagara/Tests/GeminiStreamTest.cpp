@@ -0,0 +1,336 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/GeminiAPIClient.h"
+#include "Core/GeminiSSEParser.h"
+#include "GeminiTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** What a streamed request reported, filled in by the client delegates */
+	struct FStreamOutcome
+	{
+		TArray<FString> ExpectedChunks;
+		TArray<FString> Chunks;
+		TArray<FGeminiStreamStats> Stats;
+		FString Response;
+		int32 ErrorCode = 0;
+		bool bDone = false;
+		double StartSeconds = 0.0;
+
+		/** When each chunk callback and the completion ran */
+		TArray<double> ChunkSeconds;
+		double DoneSeconds = 0.0;
+	};
+
+	/** Pause between the events of the paced loopback stream */
+	constexpr double PacedEventInterval = 0.2;
+
+	/** Send a streamed request from a client that goes out of scope before the reply arrives */
+	void StartStream(const FString& BaseURL, TSharedRef<FStreamOutcome> Outcome, const FGeminiRequestOptions& Options = FGeminiRequestOptions())
+	{
+		FGeminiAPIClient Client;
+		Client.SetAPIKey(TEXT("loopback-key"), false);
+		Client.SetBaseURL(BaseURL);
+
+		Outcome->StartSeconds = FPlatformTime::Seconds();
+		Client.StreamChatCompletion(
+			TEXT("Make a campfire"),
+			TArray<FConversationMessage>(),
+			TArray<FVFXToolFunction>(),
+			FOnGeminiStreamChunk::CreateLambda([Outcome](const FString& ChunkText, const FGeminiStreamStats& Stats)
+			{
+				Outcome->Chunks.Add(ChunkText);
+				Outcome->Stats.Add(Stats);
+				Outcome->ChunkSeconds.Add(FPlatformTime::Seconds());
+			}),
+			FOnGeminiResponse::CreateLambda([Outcome](const FString& ResponseText)
+			{
+				Outcome->Response = ResponseText;
+				Outcome->bDone = true;
+				Outcome->DoneSeconds = FPlatformTime::Seconds();
+			}),
+			FOnGeminiError::CreateLambda([Outcome](int32 ErrorCode, const FString& ErrorMessage)
+			{
+				Outcome->ErrorCode = ErrorCode;
+				Outcome->bDone = true;
+			}),
+			Options
+		);
+	}
+
+	/** Split text into chunks of at most ChunkSize bytes */
+	TArray<TConstArrayView<uint8>> SplitBytes(const TArray<uint8>& Bytes, int32 ChunkSize)
+	{
+		TArray<TConstArrayView<uint8>> Chunks;
+		for (int32 Offset = 0; Offset < Bytes.Num(); Offset += ChunkSize)
+		{
+			Chunks.Add(MakeArrayView(Bytes.GetData() + Offset, FMath::Min(ChunkSize, Bytes.Num() - Offset)));
+		}
+		return Chunks;
+	}
+
+	TArray<uint8> ToUTF8(const FString& Text)
+	{
+		const FTCHARToUTF8 Converted(*Text);
+		return TArray<uint8>(reinterpret_cast<const uint8*>(Converted.Get()), Converted.Length());
+	}
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_THREE_PARAMETER(FVerifyGeminiStreamCommand, FAutomationTestBase*, Test, TSharedRef<FStreamOutcome>, Outcome, TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer>, Server);
+
+bool FVerifyGeminiStreamCommand::Update()
+{
+	if (!Outcome->bDone && FPlatformTime::Seconds() - Outcome->StartSeconds < 10.0)
+	{
+		return false;
+	}
+
+	Test->TestTrue(TEXT("Request completed"), Outcome->bDone);
+	Test->TestEqual(TEXT("Loopback received one request"), Server->GetNumRequests(), 1);
+	Test->TestTrue(TEXT("Request carries the prompt"), Server->GetLastRequestBody().Contains(TEXT("Make a campfire")));
+
+	if (Outcome->ExpectedChunks.Num() == 0)
+	{
+		Test->TestEqual(TEXT("Error code is passed through"), Outcome->ErrorCode, 429);
+		Test->TestEqual(TEXT("No chunks on error"), Outcome->Chunks.Num(), 0);
+		return true;
+	}
+
+	Test->TestEqual(TEXT("No error"), Outcome->ErrorCode, 0);
+	Test->TestEqual(TEXT("One callback per event"), Outcome->Chunks.Num(), Outcome->ExpectedChunks.Num());
+	for (int32 Index = 0; Index < FMath::Min(Outcome->Chunks.Num(), Outcome->ExpectedChunks.Num()); ++Index)
+	{
+		Test->TestEqual(FString::Printf(TEXT("Chunk %d"), Index), Outcome->Chunks[Index], Outcome->ExpectedChunks[Index]);
+	}
+	Test->TestEqual(TEXT("Final text is the concatenated chunks"), Outcome->Response, FString::Join(Outcome->ExpectedChunks, TEXT("")));
+
+	for (int32 Index = 0; Index < Outcome->Stats.Num(); ++Index)
+	{
+		const FGeminiStreamStats& Stats = Outcome->Stats[Index];
+		Test->TestEqual(TEXT("Chunk count"), Stats.NumChunks, Index + 1);
+		Test->TestTrue(TEXT("Time to first token is recorded"), Stats.FirstChunkSeconds >= 0.0 && Stats.FirstChunkSeconds <= Stats.ElapsedSeconds);
+	}
+	if (Outcome->Stats.Num() > 0)
+	{
+		Test->AddInfo(FString::Printf(TEXT("Loopback stream: first token after %.2f ms, %d chunks"),
+			Outcome->Stats[0].FirstChunkSeconds * 1000.0, Outcome->Stats.Last().NumChunks));
+	}
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_THREE_PARAMETER(FVerifyPacedGeminiStreamCommand, FAutomationTestBase*, Test, TSharedRef<FStreamOutcome>, Outcome, TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer>, Server);
+
+bool FVerifyPacedGeminiStreamCommand::Update()
+{
+	if (!Outcome->bDone && FPlatformTime::Seconds() - Outcome->StartSeconds < 10.0)
+	{
+		return false;
+	}
+
+	Test->TestTrue(TEXT("Request completed"), Outcome->bDone);
+	Test->TestEqual(TEXT("No error"), Outcome->ErrorCode, 0);
+	Test->TestEqual(TEXT("One callback per event"), Outcome->Chunks.Num(), Outcome->ExpectedChunks.Num());
+	Test->TestEqual(TEXT("Final text is the concatenated chunks"), Outcome->Response, FString::Join(Outcome->ExpectedChunks, TEXT("")));
+
+	// Events sent apart must reach the client apart, not as one body at the end
+	int32 NumEarlyChunks = 0;
+	for (double ChunkSeconds : Outcome->ChunkSeconds)
+	{
+		if (Outcome->DoneSeconds - ChunkSeconds >= PacedEventInterval * 0.5)
+		{
+			++NumEarlyChunks;
+		}
+	}
+	Test->TestTrue(FString::Printf(TEXT("Several chunks arrive before completion (%d of %d)"), NumEarlyChunks, Outcome->ChunkSeconds.Num()), NumEarlyChunks > 1);
+
+	if (Outcome->ChunkSeconds.Num() > 0)
+	{
+		Test->AddInfo(FString::Printf(TEXT("Paced loopback stream: first chunk %.2f ms, completion %.2f ms after the request"),
+			(Outcome->ChunkSeconds[0] - Outcome->StartSeconds) * 1000.0, (Outcome->DoneSeconds - Outcome->StartSeconds) * 1000.0));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiSSEParserTest,
+	"AINiagara.GeminiStream.SSEParser",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiSSEParserTest::RunTest(const FString& Parameters)
+{
+	// Recorded shape of an alt=sse reply, with a keep-alive comment, a multi-line event and a non-ASCII chunk
+	const TArray<FString> Texts = { TEXT("```json\n{\"effect\": "), TEXT("{\"type\": \"Niagara\"}"), TEXT("} // chamas \u00e9 \u2728\n```") };
+	const FString Body = GeminiTestHelpers::MakeSSEBody(Texts)
+		+ TEXT(": keep-alive\n\n")
+		+ TEXT("event: message\ndata: first\ndata: second\n\n")
+		+ TEXT("data: trailing");
+	const TArray<uint8> Bytes = ToUTF8(Body);
+
+	for (int32 ChunkSize : { 1, 3, 64, Bytes.Num() })
+	{
+		FGeminiSSEParser Parser;
+		TArray<FString> Events;
+		for (TConstArrayView<uint8> Chunk : SplitBytes(Bytes, ChunkSize))
+		{
+			Parser.AppendBytes(Chunk, Events);
+		}
+		TestEqual(FString::Printf(TEXT("Chunk size %d: trailing event waits for the end of the stream"), ChunkSize), Events.Num(), 4);
+		TestEqual(FString::Printf(TEXT("Chunk size %d: flush completes it"), ChunkSize), Parser.Flush(Events), 1);
+
+		if (Events.Num() != 5)
+		{
+			continue;
+		}
+
+		for (int32 Index = 0; Index < Texts.Num(); ++Index)
+		{
+			FString Text;
+			FString FinishReason;
+			TestTrue(TEXT("Event parses"), FGeminiSSEParser::ParseEvent(Events[Index], Text, FinishReason));
+			TestEqual(FString::Printf(TEXT("Chunk size %d: text of event %d"), ChunkSize, Index), Text, Texts[Index]);
+			TestEqual(TEXT("Finish reason only on the last event"), FinishReason, FString(Index == Texts.Num() - 1 ? TEXT("STOP") : TEXT("")));
+		}
+		TestEqual(TEXT("Data lines are joined"), Events[3], FString(TEXT("first\nsecond")));
+		TestEqual(TEXT("Trailing event"), Events[4], FString(TEXT("trailing")));
+	}
+
+	FString Text;
+	FString FinishReason;
+	TestFalse(TEXT("Non-JSON data is rejected"), FGeminiSSEParser::ParseEvent(TEXT("[DONE"), Text, FinishReason));
+	TestTrue(TEXT("Usage-only events have no text"), FGeminiSSEParser::ParseEvent(TEXT("{\"usageMetadata\": {\"totalTokenCount\": 12}}"), Text, FinishReason) && Text.IsEmpty());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiStreamLoopbackTest,
+	"AINiagara.GeminiStream.Loopback",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiStreamLoopbackTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+
+	TSharedRef<FStreamOutcome> Outcome = MakeShared<FStreamOutcome>();
+	Outcome->ExpectedChunks = { TEXT("```json\n{\"effect\": {\"type\": \"Niagara\", "), TEXT("\"duration\": 5.0, \"looping\": true}, "), TEXT("\"emitters\": []}\n```") };
+	Server->SetReply(200, TEXT("text/event-stream"), GeminiTestHelpers::MakeSSEBody(Outcome->ExpectedChunks));
+
+	StartStream(Server->GetBaseURL(), Outcome);
+	ADD_LATENT_AUTOMATION_COMMAND(FVerifyGeminiStreamCommand(this, Outcome, Server));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiStreamLoopbackErrorTest,
+	"AINiagara.GeminiStream.LoopbackError",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiStreamLoopbackErrorTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+
+	// Errors come back as a plain JSON body, not as events
+	Server->SetReply(429, TEXT("application/json"), TEXT("{\"error\": {\"code\": 429, \"status\": \"RESOURCE_EXHAUSTED\"}}"));
+
+	// Retries are covered by GeminiRetryPolicyTest; here the first error must reach OnError
+	FGeminiRequestOptions Options;
+	Options.RetryPolicy = FGeminiRetryPolicy::NoRetry();
+
+	TSharedRef<FStreamOutcome> Outcome = MakeShared<FStreamOutcome>();
+	StartStream(Server->GetBaseURL(), Outcome, Options);
+	ADD_LATENT_AUTOMATION_COMMAND(FVerifyGeminiStreamCommand(this, Outcome, Server));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiStreamLoopbackPacedTest,
+	"AINiagara.GeminiStream.LoopbackPaced",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FGeminiStreamLoopbackPacedTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+
+	TSharedRef<FStreamOutcome> Outcome = MakeShared<FStreamOutcome>();
+	Outcome->ExpectedChunks = { TEXT("```json\n{\"effect\": "), TEXT("{\"type\": \"Niagara\", \"duration\": 5.0}, "), TEXT("\"emitters\": []"), TEXT("}\n```") };
+	Server->SetReply(200, TEXT("text/event-stream"), GeminiTestHelpers::MakeSSEBody(Outcome->ExpectedChunks));
+	Server->SetStreamEventInterval(PacedEventInterval);
+
+	StartStream(Server->GetBaseURL(), Outcome);
+	ADD_LATENT_AUTOMATION_COMMAND(FVerifyPacedGeminiStreamCommand(this, Outcome, Server));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGeminiSSEParserBenchmarkTest,
+	"AINiagara.GeminiStream.Benchmark.SSEParse",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter
+)
+
+bool FGeminiSSEParserBenchmarkTest::RunTest(const FString& Parameters)
+{
+	// A long DSL reply split into 200 events, delivered in network-sized pieces
+	TArray<FString> Texts;
+	for (int32 Index = 0; Index < 200; ++Index)
+	{
+		Texts.Add(FString::Printf(TEXT("{\"name\": \"Emitter_%d\", \"spawners\": {\"rate\": {\"spawnRate\": %d}}}, "), Index, Index * 10));
+	}
+	const TArray<uint8> Bytes = ToUTF8(GeminiTestHelpers::MakeSSEBody(Texts));
+	const TArray<TConstArrayView<uint8>> Pieces = SplitBytes(Bytes, 1400);
+
+	const int32 Iterations = 50;
+	const double StartTime = FPlatformTime::Seconds();
+	int32 TotalLength = 0;
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		FGeminiSSEParser Parser;
+		TArray<FString> Events;
+		for (TConstArrayView<uint8> Piece : Pieces)
+		{
+			Parser.AppendBytes(Piece, Events);
+		}
+		Parser.Flush(Events);
+
+		for (const FString& EventData : Events)
+		{
+			FString Text;
+			FString FinishReason;
+			FGeminiSSEParser::ParseEvent(EventData, Text, FinishReason);
+			TotalLength += Text.Len();
+		}
+	}
+	const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	TestEqual(TEXT("All text was recovered"), TotalLength, FString::Join(Texts, TEXT("")).Len() * Iterations);
+	AddInfo(FString::Printf(TEXT("%d events, %d bytes in %d pieces: %.3f ms per reply"),
+		Texts.Num(), Bytes.Num(), Pieces.Num(), ElapsedMs / Iterations));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
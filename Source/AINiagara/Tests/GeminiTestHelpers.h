@@ -0,0 +1,732 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Async/Async.h"
+#include "HAL/PlatformProcess.h"
+#include "IPAddress.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "Core/GeminiResponseCache.h"
+#include <atomic>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Shared fixtures for FGeminiAPIClient tests
+ */
+namespace GeminiTestHelpers
+{
+	/**
+	 * Build one streamGenerateContent event (without the "data: " prefix)
+	 * @param FinishReason Added to the candidate when not empty
+	 */
+	inline FString MakeChunkJson(const FString& Text, const FString& FinishReason = FString())
+	{
+		TSharedRef<FJsonObject> Part = MakeShared<FJsonObject>();
+		Part->SetStringField(TEXT("text"), Text);
+
+		TSharedRef<FJsonObject> Content = MakeShared<FJsonObject>();
+		Content->SetArrayField(TEXT("parts"), { MakeShared<FJsonValueObject>(Part) });
+		Content->SetStringField(TEXT("role"), TEXT("model"));
+
+		TSharedRef<FJsonObject> Candidate = MakeShared<FJsonObject>();
+		Candidate->SetObjectField(TEXT("content"), Content);
+		if (!FinishReason.IsEmpty())
+		{
+			Candidate->SetStringField(TEXT("finishReason"), FinishReason);
+		}
+
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetArrayField(TEXT("candidates"), { MakeShared<FJsonValueObject>(Candidate) });
+
+		FString Json;
+		TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Json);
+		FJsonSerializer::Serialize(Root, Writer);
+		return Json;
+	}
+
+	/**
+	 * Build an alt=sse body with one event per chunk; the last event carries finishReason STOP
+	 */
+	inline FString MakeSSEBody(const TArray<FString>& Chunks)
+	{
+		FString Body;
+		for (int32 Index = 0; Index < Chunks.Num(); ++Index)
+		{
+			Body += TEXT("data: ");
+			Body += MakeChunkJson(Chunks[Index], Index == Chunks.Num() - 1 ? TEXT("STOP") : TEXT(""));
+			Body += TEXT("\r\n\r\n");
+		}
+		return Body;
+	}
+
+	/**
+	 * Split text into NumChunks pieces of about the same length
+	 */
+	inline TArray<FString> SplitText(const FString& Text, int32 NumChunks)
+	{
+		TArray<FString> Chunks;
+		const int32 ChunkLength = FMath::Max(1, FMath::DivideAndRoundUp(Text.Len(), FMath::Max(1, NumChunks)));
+		for (int32 Start = 0; Start < Text.Len(); Start += ChunkLength)
+		{
+			Chunks.Add(Text.Mid(Start, ChunkLength));
+		}
+		return Chunks;
+	}
+
+	/**
+	 * Local stand-in for the Gemini and Imagen APIs on 127.0.0.1; point a client at it
+	 * with SetBaseURL(GetBaseURL()). gemini-pro and the default fast model,
+	 * gemini-1.5-flash, are served alike. The OpenAI-compatible chat/completions and
+	 * images/generations endpoints are served under the same base URL.
+	 *
+	 * Each request is answered by the first source that applies:
+	 * 1. Replies queued with QueueReply, one per request
+	 * 2. Injected faults (SetFaultInjection)
+	 * 3. Recordings: response cache entries (see FGeminiResponseCache) whose key matches
+	 *    the endpoint and request body, e.g. a folder recorded with AINiagara.ResponseCache on
+	 * 4. The SetTextReply text, as one generateContent reply or split into stream events
+	 * 5. The SetReply reply
+	 *
+	 * Replies can be delayed with SetLatency, or one by one through QueueReply. Successful
+	 * replies on streamGenerateContent are sent with chunked transfer encoding, one chunk
+	 * per event, so the client sees them arrive piece by piece; SetStreamEventInterval
+	 * paces them like a model generating text.
+	 *
+	 * The cachedContents endpoint creates named contents. A request referring to a name
+	 * the server does not know (never created, or dropped with ExpireCachedContents) is
+	 * answered with the provider's 404 before any of the sources above.
+	 *
+	 * The listener takes a free port chosen by the OS, so parallel test runs do not collide.
+	 * Every connection is served on its own thread and closed after one reply; the settings
+	 * and counters below may be used from the game thread while requests are in flight.
+	 */
+	class FGeminiLoopbackServer
+	{
+	public:
+		FGeminiLoopbackServer()
+			: State(MakeShared<FState, ESPMode::ThreadSafe>())
+		{
+			AddRoute(TEXT("/models/gemini-pro:generateContent"), false);
+			AddRoute(TEXT("/models/gemini-pro:streamGenerateContent"), true);
+			AddRoute(TEXT("/models/gemini-1.5-flash:generateContent"), false);
+			AddRoute(TEXT("/models/gemini-1.5-flash:streamGenerateContent"), true);
+			AddRoute(TEXT("/models/imagen-3-generate-001:generateContent"), false);
+			AddRoute(TEXT("/chat/completions"), false);
+			AddRoute(TEXT("/images/generations"), false);
+
+			ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+			if (!SocketSubsystem)
+			{
+				return;
+			}
+
+			TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr(FNetworkProtocolTypes::IPv4);
+			Address->SetLoopbackAddress();
+			Address->SetPort(0);
+
+			State->Listener = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("AINiagara loopback"), FNetworkProtocolTypes::IPv4);
+			if (!State->Listener || !State->Listener->Bind(*Address) || !State->Listener->Listen(16))
+			{
+				DestroyListener();
+				return;
+			}
+
+			Port = State->Listener->GetPortNo();
+			AcceptThread = Async(EAsyncExecution::Thread, [ServerState = State]()
+			{
+				AcceptConnections(ServerState);
+			});
+		}
+
+		~FGeminiLoopbackServer()
+		{
+			State->bStopping = true;
+			if (AcceptThread.IsValid())
+			{
+				AcceptThread.Wait();
+			}
+
+			TArray<TFuture<void>> Connections;
+			{
+				FScopeLock Lock(&State->Mutex);
+				Connections = MoveTemp(State->ConnectionThreads);
+			}
+			for (TFuture<void>& Connection : Connections)
+			{
+				Connection.Wait();
+			}
+
+			DestroyListener();
+		}
+
+		/** Whether the listener could be bound */
+		bool IsValid() const { return State->Listener != nullptr && Port != 0; }
+
+		/** Base URL to pass to FGeminiAPIClient::SetBaseURL */
+		FString GetBaseURL() const { return FString::Printf(TEXT("http://127.0.0.1:%d/v1beta"), Port); }
+
+		/** Reply served to every following request */
+		void SetReply(int32 Code, const FString& ContentType, const FString& Body)
+		{
+			FScopeLock Lock(&State->Mutex);
+			State->Code = Code;
+			State->ContentType = ContentType;
+			State->Body = Body;
+			State->bHasTextReply = false;
+		}
+
+		/**
+		 * Successful reply with the given text on every endpoint
+		 * @param NumStreamChunks Events the text is split into on streamGenerateContent
+		 */
+		void SetTextReply(const FString& Text, int32 NumStreamChunks = 1)
+		{
+			FScopeLock Lock(&State->Mutex);
+			State->Text = Text;
+			State->NumStreamChunks = NumStreamChunks;
+			State->bHasTextReply = true;
+		}
+
+		/**
+		 * Reply served to the next request not answered by an earlier queued reply, e.g. an injected 503
+		 * @param LatencySeconds Delay of this reply, negative for the SetLatency delay
+		 */
+		void QueueReply(int32 Code, const FString& ContentType, const FString& Body, const FString& RetryAfter = FString(), double LatencySeconds = -1.0)
+		{
+			FScopeLock Lock(&State->Mutex);
+			State->Queued.Add(FReply{ Code, ContentType, Body, RetryAfter, LatencySeconds });
+		}
+
+		/** Serve recorded replies from a response cache folder */
+		void SetRecordingDirectory(const FString& Directory)
+		{
+			FScopeLock Lock(&State->Mutex);
+			State->RecordingDirectory = Directory;
+		}
+
+		/** Delay every reply */
+		void SetLatency(double Seconds)
+		{
+			FScopeLock Lock(&State->Mutex);
+			State->LatencySeconds = Seconds;
+		}
+
+		/** Pause between the events of a streamed reply, 0 to send them back to back */
+		void SetStreamEventInterval(double Seconds)
+		{
+			FScopeLock Lock(&State->Mutex);
+			State->StreamEventIntervalSeconds = Seconds;
+		}
+
+		/**
+		 * Fail a random share of requests
+		 * @param Probability Share of requests that fail, 0 to disable
+		 * @param Code Status of the injected failures
+		 * @param Seed Random seed, so a run is repeatable
+		 */
+		void SetFaultInjection(float Probability, int32 Code = 503, int32 Seed = 0)
+		{
+			FScopeLock Lock(&State->Mutex);
+			State->FaultProbability = Probability;
+			State->FaultCode = Code;
+			State->FaultRandom.Initialize(Seed);
+		}
+
+		/** Refuse to create cached content, as for a model without caching support */
+		void SetCachedContentsSupported(bool bSupported)
+		{
+			FScopeLock Lock(&State->Mutex);
+			State->bCachedContentsSupported = bSupported;
+		}
+
+		/** Forget every cached content, as if all had expired */
+		void ExpireCachedContents()
+		{
+			FScopeLock Lock(&State->Mutex);
+			State->CachedContents.Reset();
+		}
+
+		int32 GetNumCachedContentsCreated() const { FScopeLock Lock(&State->Mutex); return State->NumCachedContentsCreated; }
+		int32 GetNumCachedContentReferences() const { FScopeLock Lock(&State->Mutex); return State->NumCachedContentReferences; }
+		FString GetLastCachedContentBody() const { FScopeLock Lock(&State->Mutex); return State->LastCachedContentBody; }
+
+		int32 GetNumRequests() const { FScopeLock Lock(&State->Mutex); return State->NumRequests; }
+		int32 GetNumRecordedReplies() const { FScopeLock Lock(&State->Mutex); return State->NumRecordedReplies; }
+		int32 GetNumInjectedFaults() const { FScopeLock Lock(&State->Mutex); return State->NumInjectedFaults; }
+		FString GetLastRequestBody() const { FScopeLock Lock(&State->Mutex); return State->LastRequestBody; }
+
+	private:
+		struct FReply
+		{
+			int32 Code;
+			FString ContentType;
+			FString Body;
+			FString RetryAfter;
+
+			/** Delay of this reply, negative for the server's latency */
+			double LatencySeconds = -1.0;
+		};
+
+		/** What a path under /v1beta serves */
+		struct FRoute
+		{
+			/** Path relative to the base URL, as the client and the response cache key see it */
+			FString Endpoint;
+			bool bStream = false;
+		};
+
+		struct FState
+		{
+			/** Guards everything below except the sockets and bStopping */
+			mutable FCriticalSection Mutex;
+
+			FSocket* Listener = nullptr;
+			std::atomic<bool> bStopping{ false };
+			TArray<TFuture<void>> ConnectionThreads;
+			TMap<FString, FRoute> Routes;
+
+			int32 Code = 200;
+			FString ContentType = TEXT("text/event-stream");
+			FString Body;
+
+			bool bHasTextReply = false;
+			FString Text;
+			int32 NumStreamChunks = 1;
+
+			TArray<FReply> Queued;
+			FString RecordingDirectory;
+			double LatencySeconds = 0.0;
+			double StreamEventIntervalSeconds = 0.0;
+
+			float FaultProbability = 0.0f;
+			int32 FaultCode = 503;
+			FRandomStream FaultRandom;
+
+			int32 NumRequests = 0;
+			int32 NumRecordedReplies = 0;
+			int32 NumInjectedFaults = 0;
+			FString LastRequestBody;
+
+			bool bCachedContentsSupported = true;
+			TSet<FString> CachedContents;
+			int32 NumCachedContentsCreated = 0;
+			int32 NumCachedContentReferences = 0;
+			FString LastCachedContentBody;
+		};
+
+		void AddRoute(const FString& Endpoint, bool bStream)
+		{
+			State->Routes.Add(TEXT("/v1beta") + Endpoint, FRoute{ Endpoint, bStream });
+		}
+
+		void DestroyListener()
+		{
+			if (State->Listener)
+			{
+				State->Listener->Close();
+				ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(State->Listener);
+				State->Listener = nullptr;
+			}
+		}
+
+		/** Accept connections until the server is destroyed, serving each on its own thread */
+		static void AcceptConnections(TSharedRef<FState, ESPMode::ThreadSafe> ServerState)
+		{
+			while (!ServerState->bStopping)
+			{
+				bool bHasPendingConnection = false;
+				if (!ServerState->Listener->WaitForPendingConnection(bHasPendingConnection, FTimespan::FromMilliseconds(20)) || !bHasPendingConnection)
+				{
+					continue;
+				}
+
+				FSocket* Connection = ServerState->Listener->Accept(TEXT("AINiagara loopback connection"));
+				if (!Connection)
+				{
+					continue;
+				}
+
+				TFuture<void> Thread = Async(EAsyncExecution::Thread, [ServerState, Connection]()
+				{
+					ServeConnection(*ServerState, *Connection);
+					Connection->Close();
+					ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Connection);
+				});
+
+				FScopeLock Lock(&ServerState->Mutex);
+				ServerState->ConnectionThreads.Add(MoveTemp(Thread));
+			}
+		}
+
+		/** Wait, but give up early when the server is destroyed */
+		static void SleepUnlessStopping(const FState& ServerState, double Seconds)
+		{
+			const double EndSeconds = FPlatformTime::Seconds() + Seconds;
+			while (!ServerState.bStopping && FPlatformTime::Seconds() < EndSeconds)
+			{
+				FPlatformProcess::Sleep(static_cast<float>(FMath::Min(0.01, EndSeconds - FPlatformTime::Seconds())));
+			}
+		}
+
+		static bool SendAll(FSocket& Connection, const uint8* Data, int32 Num)
+		{
+			while (Num > 0)
+			{
+				int32 Sent = 0;
+				if (!Connection.Send(Data, Num, Sent) || Sent <= 0)
+				{
+					return false;
+				}
+				Data += Sent;
+				Num -= Sent;
+			}
+			return true;
+		}
+
+		static bool SendText(FSocket& Connection, const FString& Text)
+		{
+			const FTCHARToUTF8 Converted(*Text);
+			return SendAll(Connection, reinterpret_cast<const uint8*>(Converted.Get()), Converted.Length());
+		}
+
+		/** Receive more bytes; false once the peer closes, fails or stays silent for a few seconds */
+		static bool Receive(const FState& ServerState, FSocket& Connection, TArray<uint8>& InOutData)
+		{
+			if (ServerState.bStopping || !Connection.Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromSeconds(5)))
+			{
+				return false;
+			}
+
+			uint8 Buffer[4096];
+			int32 Read = 0;
+			if (!Connection.Recv(Buffer, sizeof(Buffer), Read) || Read <= 0)
+			{
+				return false;
+			}
+			InOutData.Append(Buffer, Read);
+			return true;
+		}
+
+		/**
+		 * Read one request
+		 * @param OutPath Request path without the query string
+		 * @return False if the connection closed before a complete request arrived
+		 */
+		static bool ReadRequest(const FState& ServerState, FSocket& Connection, FString& OutPath, FString& OutBody)
+		{
+			static const uint8 HeaderEnd[] = { '\r', '\n', '\r', '\n' };
+
+			TArray<uint8> Data;
+			int32 BodyStart = INDEX_NONE;
+			while (BodyStart == INDEX_NONE)
+			{
+				if (!Receive(ServerState, Connection, Data))
+				{
+					return false;
+				}
+				for (int32 Index = 0; Index + 4 <= Data.Num(); ++Index)
+				{
+					if (FMemory::Memcmp(Data.GetData() + Index, HeaderEnd, 4) == 0)
+					{
+						BodyStart = Index + 4;
+						break;
+					}
+				}
+			}
+
+			const FString Header(BodyStart, reinterpret_cast<const ANSICHAR*>(Data.GetData()));
+			TArray<FString> Lines;
+			Header.ParseIntoArrayLines(Lines);
+			TArray<FString> RequestLine;
+			if (Lines.Num() == 0 || Lines[0].ParseIntoArrayWS(RequestLine) < 2)
+			{
+				return false;
+			}
+			OutPath = RequestLine[1];
+			int32 QueryStart = INDEX_NONE;
+			if (OutPath.FindChar(TEXT('?'), QueryStart))
+			{
+				OutPath.LeftInline(QueryStart);
+			}
+
+			int32 ContentLength = 0;
+			bool bExpectsContinue = false;
+			for (const FString& Line : Lines)
+			{
+				FString Name;
+				FString Value;
+				if (Line.Split(TEXT(":"), &Name, &Value))
+				{
+					Value.TrimStartAndEndInline();
+					if (Name.Equals(TEXT("Content-Length"), ESearchCase::IgnoreCase))
+					{
+						ContentLength = FCString::Atoi(*Value);
+					}
+					else if (Name.Equals(TEXT("Expect"), ESearchCase::IgnoreCase) && Value.Equals(TEXT("100-continue"), ESearchCase::IgnoreCase))
+					{
+						bExpectsContinue = true;
+					}
+				}
+			}
+
+			if (bExpectsContinue && Data.Num() - BodyStart < ContentLength && !SendText(Connection, TEXT("HTTP/1.1 100 Continue\r\n\r\n")))
+			{
+				return false;
+			}
+
+			while (Data.Num() - BodyStart < ContentLength)
+			{
+				if (!Receive(ServerState, Connection, Data))
+				{
+					return false;
+				}
+			}
+
+			const FUTF8ToTCHAR Body(reinterpret_cast<const ANSICHAR*>(Data.GetData() + BodyStart), ContentLength);
+			OutBody = FString(Body.Length(), Body.Get());
+			return true;
+		}
+
+		/** Read one request, pick its reply under the lock and send it */
+		static void ServeConnection(FState& ServerState, FSocket& Connection)
+		{
+			FString Path;
+			FString RequestBody;
+			if (!ReadRequest(ServerState, Connection, Path, RequestBody))
+			{
+				return;
+			}
+
+			FReply Reply;
+			bool bStream = false;
+			double LatencySeconds = 0.0;
+			double EventIntervalSeconds = 0.0;
+			{
+				FScopeLock Lock(&ServerState.Mutex);
+
+				if (Path == TEXT("/v1beta/cachedContents"))
+				{
+					Reply = MakeCachedContentReply(ServerState, RequestBody);
+				}
+				else if (const FRoute* Route = ServerState.Routes.Find(Path))
+				{
+					++ServerState.NumRequests;
+					ServerState.LastRequestBody = RequestBody;
+
+					const TOptional<FReply> Rejected = CheckCachedContent(ServerState, RequestBody);
+					Reply = Rejected.IsSet() ? Rejected.GetValue() : MakeReply(ServerState, Route->Endpoint, Route->bStream, RequestBody);
+					bStream = Route->bStream;
+					LatencySeconds = Reply.LatencySeconds >= 0.0 ? Reply.LatencySeconds : ServerState.LatencySeconds;
+					EventIntervalSeconds = ServerState.StreamEventIntervalSeconds;
+				}
+				else
+				{
+					Reply = FReply{ 404, TEXT("application/json"), TEXT("{\"error\": {\"code\": 404, \"status\": \"NOT_FOUND\"}}"), FString() };
+				}
+			}
+
+			SleepUnlessStopping(ServerState, LatencySeconds);
+			if (ServerState.bStopping)
+			{
+				return;
+			}
+
+			SendReply(ServerState, Connection, Reply, bStream && Reply.Code == 200, EventIntervalSeconds);
+		}
+
+		/** Split an SSE body after each blank line, keeping the separators */
+		static TArray<FString> SplitEvents(const FString& Body)
+		{
+			TArray<FString> Events;
+			int32 EventStart = 0;
+			for (int32 Index = 0; Index < Body.Len(); ++Index)
+			{
+				if (Body[Index] != TEXT('\n'))
+				{
+					continue;
+				}
+
+				int32 Next = Index + 1;
+				if (Next < Body.Len() && Body[Next] == TEXT('\r'))
+				{
+					++Next;
+				}
+				if (Next < Body.Len() && Body[Next] == TEXT('\n'))
+				{
+					Events.Add(Body.Mid(EventStart, Next + 1 - EventStart));
+					EventStart = Next + 1;
+					Index = Next;
+				}
+			}
+			if (EventStart < Body.Len())
+			{
+				Events.Add(Body.Mid(EventStart));
+			}
+			return Events;
+		}
+
+		static const TCHAR* GetReasonPhrase(int32 Code)
+		{
+			switch (Code)
+			{
+			case 200: return TEXT("OK");
+			case 400: return TEXT("Bad Request");
+			case 401: return TEXT("Unauthorized");
+			case 403: return TEXT("Forbidden");
+			case 404: return TEXT("Not Found");
+			case 429: return TEXT("Too Many Requests");
+			case 500: return TEXT("Internal Server Error");
+			case 503: return TEXT("Service Unavailable");
+			default: return TEXT("Status");
+			}
+		}
+
+		/**
+		 * Send a reply and let the connection close
+		 * @param bChunked Send each SSE event as its own chunk, EventIntervalSeconds apart
+		 */
+		static void SendReply(const FState& ServerState, FSocket& Connection, const FReply& Reply, bool bChunked, double EventIntervalSeconds)
+		{
+			const FTCHARToUTF8 Body(*Reply.Body);
+
+			FString Head = FString::Printf(TEXT("HTTP/1.1 %d %s\r\nContent-Type: %s\r\nConnection: close\r\n"), Reply.Code, GetReasonPhrase(Reply.Code), *Reply.ContentType);
+			if (!Reply.RetryAfter.IsEmpty())
+			{
+				Head += FString::Printf(TEXT("Retry-After: %s\r\n"), *Reply.RetryAfter);
+			}
+			Head += bChunked ? FString(TEXT("Transfer-Encoding: chunked\r\n\r\n")) : FString::Printf(TEXT("Content-Length: %d\r\n\r\n"), Body.Length());
+
+			if (!SendText(Connection, Head))
+			{
+				return;
+			}
+
+			if (!bChunked)
+			{
+				SendAll(Connection, reinterpret_cast<const uint8*>(Body.Get()), Body.Length());
+				return;
+			}
+
+			const TArray<FString> Events = SplitEvents(Reply.Body);
+			for (int32 Index = 0; Index < Events.Num(); ++Index)
+			{
+				if (Index > 0)
+				{
+					SleepUnlessStopping(ServerState, EventIntervalSeconds);
+				}
+
+				const FTCHARToUTF8 Event(*Events[Index]);
+				if (ServerState.bStopping
+					|| !SendText(Connection, FString::Printf(TEXT("%x\r\n"), Event.Length()))
+					|| !SendAll(Connection, reinterpret_cast<const uint8*>(Event.Get()), Event.Length())
+					|| !SendText(Connection, TEXT("\r\n")))
+				{
+					return;
+				}
+			}
+			SendText(Connection, TEXT("0\r\n\r\n"));
+		}
+
+		/** The provider's reply to a request referring to unknown cached content, or nothing if the request is fine */
+		static TOptional<FReply> CheckCachedContent(FState& ServerState, const FString& RequestBody)
+		{
+			TSharedPtr<FJsonObject> Object;
+			TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(RequestBody);
+			FString Name;
+			if (!FJsonSerializer::Deserialize(Reader, Object) || !Object.IsValid() || !Object->TryGetStringField(TEXT("cachedContent"), Name))
+			{
+				return TOptional<FReply>();
+			}
+
+			++ServerState.NumCachedContentReferences;
+			if (ServerState.CachedContents.Contains(Name))
+			{
+				return TOptional<FReply>();
+			}
+			return FReply{ 404, TEXT("application/json"),
+				TEXT("{\"error\": {\"code\": 404, \"message\": \"CachedContent not found (or permission denied)\", \"status\": \"NOT_FOUND\"}}"), FString() };
+		}
+
+		/** Pick the reply to a request on Endpoint */
+		static FReply MakeReply(FState& ServerState, const FString& Endpoint, bool bStream, const FString& RequestBody)
+		{
+			if (ServerState.Queued.Num() > 0)
+			{
+				FReply Reply = ServerState.Queued[0];
+				ServerState.Queued.RemoveAt(0);
+				return Reply;
+			}
+
+			if (ServerState.FaultProbability > 0.0f && ServerState.FaultRandom.FRand() < ServerState.FaultProbability)
+			{
+				++ServerState.NumInjectedFaults;
+				return FReply{ ServerState.FaultCode, TEXT("application/json"),
+					FString::Printf(TEXT("{\"error\": {\"code\": %d, \"message\": \"Injected fault\"}}"), ServerState.FaultCode), FString() };
+			}
+
+			const FString ContentType = bStream ? TEXT("text/event-stream") : TEXT("application/json");
+			if (!ServerState.RecordingDirectory.IsEmpty())
+			{
+				FString Recorded;
+				const FString Path = ServerState.RecordingDirectory / (FGeminiResponseCache::MakeKey(Endpoint, RequestBody) + TEXT(".json"));
+				if (FFileHelper::LoadFileToString(Recorded, *Path))
+				{
+					++ServerState.NumRecordedReplies;
+					return FReply{ 200, ContentType, Recorded, FString() };
+				}
+			}
+
+			if (ServerState.bHasTextReply)
+			{
+				const FString Body = bStream
+					? MakeSSEBody(SplitText(ServerState.Text, ServerState.NumStreamChunks))
+					: MakeChunkJson(ServerState.Text, TEXT("STOP"));
+				return FReply{ 200, ContentType, Body, FString() };
+			}
+
+			return FReply{ ServerState.Code, ServerState.ContentType, ServerState.Body, FString() };
+		}
+
+		/** Serve the cachedContents endpoint: hand out a new name that lives for the requested ttl */
+		static FReply MakeCachedContentReply(FState& ServerState, const FString& RequestBody)
+		{
+			ServerState.LastCachedContentBody = RequestBody;
+
+			if (!ServerState.bCachedContentsSupported)
+			{
+				return FReply{ 400, TEXT("application/json"),
+					TEXT("{\"error\": {\"code\": 400, \"message\": \"Model does not support caching\", \"status\": \"INVALID_ARGUMENT\"}}"), FString() };
+			}
+
+			FString TTL;
+			TSharedPtr<FJsonObject> Object;
+			TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(RequestBody);
+			if (FJsonSerializer::Deserialize(Reader, Object) && Object.IsValid())
+			{
+				Object->TryGetStringField(TEXT("ttl"), TTL);
+			}
+			const FDateTime ExpireTime = FDateTime::UtcNow() + FTimespan::FromSeconds(FCString::Atod(*TTL));
+
+			const FString Name = FString::Printf(TEXT("cachedContents/loopback-%d"), ++ServerState.NumCachedContentsCreated);
+			ServerState.CachedContents.Add(Name);
+			return FReply{ 200, TEXT("application/json"),
+				FString::Printf(TEXT("{\"name\": \"%s\", \"model\": \"models/gemini-pro\", \"expireTime\": \"%s\"}"), *Name, *ExpireTime.ToIso8601()), FString() };
+		}
+
+		int32 Port = 0;
+		TSharedRef<FState, ESPMode::ThreadSafe> State;
+		TFuture<void> AcceptThread;
+	};
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
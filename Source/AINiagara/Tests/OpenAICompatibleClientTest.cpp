@@ -0,0 +1,361 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/OpenAICompatibleClient.h"
+#include "Core/LLMBackend.h"
+#include "Core/AINiagaraSettings.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "GeminiTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** What one request to the loopback reported */
+	struct FOpenAIOutcome
+	{
+		FString Response;
+		TArray<FString> Chunks;
+		int32 ErrorCode = 0;
+		FString ErrorMessage;
+		bool bDone = false;
+		double StartSeconds = 0.0;
+	};
+
+	/** Whether a request started by an earlier latent step has finished or timed out */
+	bool IsFinished(const TSharedPtr<FOpenAIOutcome>& Outcome)
+	{
+		return !Outcome.IsValid() || Outcome->bDone || FPlatformTime::Seconds() - Outcome->StartSeconds > 10.0;
+	}
+
+	/** Send a chat request from a client that goes out of scope before the reply arrives */
+	TSharedRef<FOpenAIOutcome> SendLoopbackChat(const FString& BaseURL, bool bStream)
+	{
+		TSharedRef<FOpenAIOutcome> Outcome = MakeShared<FOpenAIOutcome>();
+		Outcome->StartSeconds = FPlatformTime::Seconds();
+
+		FOnGeminiResponse OnResponse = FOnGeminiResponse::CreateLambda([Outcome](const FString& ResponseText)
+		{
+			Outcome->Response = ResponseText;
+			Outcome->bDone = true;
+		});
+		FOnGeminiError OnError = FOnGeminiError::CreateLambda([Outcome](int32 ErrorCode, const FString& ErrorMessage)
+		{
+			Outcome->ErrorCode = ErrorCode;
+			Outcome->ErrorMessage = ErrorMessage;
+			Outcome->bDone = true;
+		});
+
+		FOpenAICompatibleClient Client;
+		Client.SetBaseURL(BaseURL);
+		Client.SetChatModel(TEXT("loopback-model"));
+		Client.SetAPIKey(TEXT("loopback-key"));
+
+		FVFXToolFunction Tool;
+		Tool.Name = TEXT("tool:texture");
+		Tool.Description = TEXT("Generate a texture");
+		Tool.Parameters.Add(TEXT("type"), TEXT("string"));
+		const TArray<FVFXToolFunction> Tools = { Tool };
+
+		if (bStream)
+		{
+			Client.StreamChatCompletion(TEXT("Make fire"), TArray<FConversationMessage>(), Tools,
+				FOnGeminiStreamChunk::CreateLambda([Outcome](const FString& ChunkText, const FGeminiStreamStats& Stats)
+				{
+					Outcome->Chunks.Add(ChunkText);
+				}),
+				OnResponse, OnError);
+		}
+		else
+		{
+			Client.SendChatCompletion(TEXT("Make fire"), TArray<FConversationMessage>(), Tools, OnResponse, OnError);
+		}
+		return Outcome;
+	}
+
+	/** One chat.completion.chunk event */
+	FString MakeDeltaEvent(const FString& DeltaJson, const FString& FinishReason = FString())
+	{
+		const FString Finish = FinishReason.IsEmpty() ? FString(TEXT("null")) : FString::Printf(TEXT("\"%s\""), *FinishReason);
+		return FString::Printf(TEXT("data: {\"object\":\"chat.completion.chunk\",\"choices\":[{\"index\":0,\"delta\":%s,\"finish_reason\":%s}]}\n\n"), *DeltaJson, *Finish);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FOpenAICompatibleClientBuildChatPayloadTest,
+	"AINiagara.OpenAICompatibleClient.BuildChatPayload",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FOpenAICompatibleClientBuildChatPayloadTest::RunTest(const FString& Parameters)
+{
+	TArray<FConversationMessage> History;
+	History.Add(FConversationMessage(TEXT("system"), TEXT("You design Niagara effects")));
+	History.Add(FConversationMessage(TEXT("model"), TEXT("Earlier reply")));
+
+	FVFXToolFunction Tool;
+	Tool.Name = TEXT("tool:texture");
+	Tool.Description = TEXT("Generate a texture");
+	Tool.Parameters.Add(TEXT("type"), TEXT("string"));
+
+	const FString Payload = FOpenAICompatibleClient::BuildChatPayload(TEXT("qwen2.5-coder"), TEXT("Make fire"), History, { Tool }, true, 3);
+
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Payload);
+	if (!TestTrue(TEXT("Payload is JSON"), FJsonSerializer::Deserialize(Reader, Root) && Root.IsValid()))
+	{
+		return false;
+	}
+
+	TestEqual(TEXT("Model"), Root->GetStringField(TEXT("model")), FString(TEXT("qwen2.5-coder")));
+	TestTrue(TEXT("Stream flag"), Root->GetBoolField(TEXT("stream")));
+	TestEqual(TEXT("Choices asked for"), static_cast<int32>(Root->GetNumberField(TEXT("n"))), 3);
+
+	const TArray<TSharedPtr<FJsonValue>>& Messages = Root->GetArrayField(TEXT("messages"));
+	if (TestEqual(TEXT("History and prompt"), Messages.Num(), 3))
+	{
+		TestEqual(TEXT("System role kept"), Messages[0]->AsObject()->GetStringField(TEXT("role")), FString(TEXT("system")));
+		TestEqual(TEXT("Model role sent as assistant"), Messages[1]->AsObject()->GetStringField(TEXT("role")), FString(TEXT("assistant")));
+		TestEqual(TEXT("Prompt last"), Messages[2]->AsObject()->GetStringField(TEXT("content")), FString(TEXT("Make fire")));
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>& Tools = Root->GetArrayField(TEXT("tools"));
+	if (TestEqual(TEXT("One tool"), Tools.Num(), 1))
+	{
+		TestEqual(TEXT("Function tool"), Tools[0]->AsObject()->GetStringField(TEXT("type")), FString(TEXT("function")));
+		const TSharedPtr<FJsonObject> Function = Tools[0]->AsObject()->GetObjectField(TEXT("function"));
+		TestEqual(TEXT("Name the API accepts"), Function->GetStringField(TEXT("name")), FString(TEXT("tool_texture")));
+		TestTrue(TEXT("Parameter declared"), Function->GetObjectField(TEXT("parameters"))->GetObjectField(TEXT("properties"))->HasField(TEXT("type")));
+	}
+
+	const FString Plain = FOpenAICompatibleClient::BuildChatPayload(TEXT("m"), TEXT("p"), TArray<FConversationMessage>(), TArray<FVFXToolFunction>(), false);
+	TestFalse(TEXT("No stream flag unless streaming"), Plain.Contains(TEXT("\"stream\"")));
+	TestFalse(TEXT("No tools key without tools"), Plain.Contains(TEXT("\"tools\"")));
+	TestFalse(TEXT("No n for one choice"), Plain.Contains(TEXT("\"n\"")));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FOpenAICompatibleClientParseChatResponseTest,
+	"AINiagara.OpenAICompatibleClient.ParseChatResponse",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FOpenAICompatibleClientParseChatResponseTest::RunTest(const FString& Parameters)
+{
+	FVFXToolFunction Tool;
+	Tool.Name = TEXT("tool:texture");
+	const TArray<FVFXToolFunction> Tools = { Tool };
+
+	FGeminiResponse Response;
+	const FString TextReply(TEXT("{\"choices\":[{\"message\":{\"role\":\"assistant\",\"content\":\"First\"},\"finish_reason\":\"stop\"},")
+		TEXT("{\"message\":{\"role\":\"assistant\",\"content\":\"Second\"},\"finish_reason\":\"stop\"}],")
+		TEXT("\"usage\":{\"prompt_tokens\":120,\"completion_tokens\":30,\"total_tokens\":150,\"prompt_tokens_details\":{\"cached_tokens\":100}}}"));
+	if (TestTrue(TEXT("Text reply parses"), FOpenAICompatibleClient::ParseChatResponse(TextReply, Tools, Response)))
+	{
+		TestEqual(TEXT("Text of the first choice"), Response.GetResponseText(), FString(TEXT("First")));
+		TestEqual(TEXT("Every choice kept"), Response.Candidates.Num(), 2);
+		TestEqual(TEXT("Second choice"), Response.Candidates.Num() > 1 ? Response.Candidates[1] : FString(), FString(TEXT("Second")));
+		TestEqual(TEXT("Finish reason"), Response.FinishReason, FString(TEXT("stop")));
+		TestEqual(TEXT("Prompt tokens"), Response.PromptTokens, 120);
+		TestEqual(TEXT("Output tokens"), Response.OutputTokens, 30);
+		TestEqual(TEXT("Cached tokens"), Response.CachedTokens, 100);
+	}
+
+	const FString ToolReply(TEXT("{\"choices\":[{\"message\":{\"role\":\"assistant\",\"content\":null,\"tool_calls\":[{\"id\":\"call_1\",\"type\":\"function\",")
+		TEXT("\"function\":{\"name\":\"tool_texture\",\"arguments\":\"{\\\"type\\\":\\\"noise\\\"}\"}}]},\"finish_reason\":\"tool_calls\"}]}"));
+	if (TestTrue(TEXT("Tool call reply parses"), FOpenAICompatibleClient::ParseChatResponse(ToolReply, Tools, Response)))
+	{
+		TestEqual(TEXT("One function call"), Response.FunctionCalls.Num(), 1);
+
+		TSharedPtr<FJsonObject> Call;
+		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Response.GetResponseText());
+		if (TestTrue(TEXT("Tool call is handed on as JSON"), FJsonSerializer::Deserialize(Reader, Call) && Call.IsValid() && Call->HasField(TEXT("functionCall"))))
+		{
+			const TSharedPtr<FJsonObject> FunctionCall = Call->GetObjectField(TEXT("functionCall"));
+			TestEqual(TEXT("Tool name restored"), FunctionCall->GetStringField(TEXT("name")), FString(TEXT("tool:texture")));
+			TestEqual(TEXT("Arguments parsed"), FunctionCall->GetObjectField(TEXT("args"))->GetStringField(TEXT("type")), FString(TEXT("noise")));
+		}
+	}
+
+	TestFalse(TEXT("No choices"), FOpenAICompatibleClient::ParseChatResponse(TEXT("{\"choices\":[]}"), Tools, Response));
+	TestFalse(TEXT("Not JSON"), FOpenAICompatibleClient::ParseChatResponse(TEXT("<html>"), Tools, Response));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FOpenAICompatibleClientParseStreamEventTest,
+	"AINiagara.OpenAICompatibleClient.ParseStreamEvent",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FOpenAICompatibleClientParseStreamEventTest::RunTest(const FString& Parameters)
+{
+	FString Text;
+	FString FinishReason;
+	FString ToolName;
+	FString ToolArguments;
+
+	TestTrue(TEXT("Content delta"), FOpenAICompatibleClient::ParseStreamEvent(
+		TEXT("{\"choices\":[{\"index\":0,\"delta\":{\"content\":\"Hel\"},\"finish_reason\":null}]}"), Text, FinishReason, ToolName, ToolArguments));
+	TestEqual(TEXT("Delta text"), Text, FString(TEXT("Hel")));
+	TestTrue(TEXT("No finish reason yet"), FinishReason.IsEmpty());
+
+	TestTrue(TEXT("Last delta"), FOpenAICompatibleClient::ParseStreamEvent(
+		TEXT("{\"choices\":[{\"index\":0,\"delta\":{},\"finish_reason\":\"stop\"}]}"), Text, FinishReason, ToolName, ToolArguments));
+	TestTrue(TEXT("No text"), Text.IsEmpty());
+	TestEqual(TEXT("Finish reason"), FinishReason, FString(TEXT("stop")));
+
+	TestTrue(TEXT("Tool call delta"), FOpenAICompatibleClient::ParseStreamEvent(
+		TEXT("{\"choices\":[{\"index\":0,\"delta\":{\"tool_calls\":[{\"index\":0,\"function\":{\"name\":\"tool_texture\",\"arguments\":\"{\\\"ty\"}}]}}]}"), Text, FinishReason, ToolName, ToolArguments));
+	TestEqual(TEXT("Tool name piece"), ToolName, FString(TEXT("tool_texture")));
+	TestEqual(TEXT("Arguments piece"), ToolArguments, FString(TEXT("{\"ty")));
+
+	TestTrue(TEXT("End marker"), FOpenAICompatibleClient::ParseStreamEvent(TEXT("[DONE]"), Text, FinishReason, ToolName, ToolArguments));
+	TestTrue(TEXT("Usage-only event"), FOpenAICompatibleClient::ParseStreamEvent(TEXT("{\"choices\":[],\"usage\":{\"total_tokens\":5}}"), Text, FinishReason, ToolName, ToolArguments));
+	TestFalse(TEXT("Malformed event"), FOpenAICompatibleClient::ParseStreamEvent(TEXT("{not json"), Text, FinishReason, ToolName, ToolArguments));
+
+	TestEqual(TEXT("Function name"), FOpenAICompatibleClient::ToFunctionName(TEXT("tool:texture")), FString(TEXT("tool_texture")));
+	TestEqual(TEXT("Valid name unchanged"), FOpenAICompatibleClient::ToFunctionName(TEXT("make-mesh_2")), FString(TEXT("make-mesh_2")));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FLLMBackendCreateTest,
+	"AINiagara.LLMBackend.Create",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FLLMBackendCreateTest::RunTest(const FString& Parameters)
+{
+	UAINiagaraSettings* Settings = UAINiagaraSettings::Get();
+	if (!TestNotNull(TEXT("Settings instance"), Settings))
+	{
+		return false;
+	}
+
+	for (ELLMTask Task : { ELLMTask::Chat, ELLMTask::Shader, ELLMTask::Texture, ELLMTask::Correction })
+	{
+		const TSharedRef<ILLMBackend, ESPMode::ThreadSafe> Backend = ILLMBackend::Create(Task);
+		const bool bExpectGemini = Settings->GetBackendForTask(Task) == ELLMBackendType::Gemini;
+		TestEqual(TEXT("Backend follows the settings"), Backend->GetName().StartsWith(TEXT("Gemini ")), bExpectGemini);
+		TestTrue(TEXT("Model follows the routing"), Backend->GetName().Contains(Settings->GetChatModelForTask(Task)));
+	}
+
+	FGeminiAPIClient GeminiClient;
+	GeminiClient.SetChatModel(TEXT("models/gemini-1.5-flash"));
+	TestEqual(TEXT("Gemini model without the prefix"), GeminiClient.GetChatModel(), FString(TEXT("gemini-1.5-flash")));
+	GeminiClient.SetChatModel(FString());
+	TestEqual(TEXT("Empty model restores the default"), GeminiClient.GetChatModel(), FString(TEXT("gemini-pro")));
+
+	FOpenAICompatibleClient Client;
+	TestEqual(TEXT("Server URL from the settings"), Client.GetBaseURL(), Settings->GetLocalServerURL().TrimChar(TEXT('/')));
+	TestEqual(TEXT("Chat model from the settings"), Client.GetChatModel(), Settings->GetLocalChatModel());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FOpenAICompatibleClientLoopbackTest,
+	"AINiagara.OpenAICompatibleClient.Loopback",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FOpenAICompatibleClientLoopbackTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<GeminiTestHelpers::FGeminiLoopbackServer> Server = MakeShared<GeminiTestHelpers::FGeminiLoopbackServer>();
+	if (!Server->IsValid())
+	{
+		AddError(TEXT("Could not start the loopback server"));
+		return false;
+	}
+
+	// Plain reply, streamed reply, streamed tool call, rejected key
+	Server->QueueReply(200, TEXT("application/json"),
+		TEXT("{\"id\":\"1\",\"object\":\"chat.completion\",\"choices\":[{\"index\":0,\"message\":{\"role\":\"assistant\",\"content\":\"effect: fire\"},\"finish_reason\":\"stop\"}]}"));
+	const TSharedRef<FOpenAIOutcome> Plain = SendLoopbackChat(Server->GetBaseURL(), false);
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Plain]()
+	{
+		if (!IsFinished(Plain))
+		{
+			return false;
+		}
+		TestEqual(TEXT("Reply text"), Plain->Response, FString(TEXT("effect: fire")));
+		TestTrue(TEXT("Request names the model"), Server->GetLastRequestBody().Contains(TEXT("\"model\":\"loopback-model\"")));
+		TestTrue(TEXT("Request declares the tool"), Server->GetLastRequestBody().Contains(TEXT("\"tool_texture\"")));
+		return true;
+	}));
+
+	TSharedRef<TSharedPtr<FOpenAIOutcome>> Streamed = MakeShared<TSharedPtr<FOpenAIOutcome>>();
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([Server, Streamed]()
+	{
+		Server->QueueReply(200, TEXT("text/event-stream"),
+			MakeDeltaEvent(TEXT("{\"role\":\"assistant\",\"content\":\"effect\"}")) +
+			MakeDeltaEvent(TEXT("{\"content\":\": fire\"}")) +
+			MakeDeltaEvent(TEXT("{}"), TEXT("stop")) +
+			TEXT("data: [DONE]\n\n"));
+		*Streamed = SendLoopbackChat(Server->GetBaseURL(), true);
+		return true;
+	}));
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Server, Streamed]()
+	{
+		if (!IsFinished(*Streamed))
+		{
+			return false;
+		}
+		TestEqual(TEXT("Streamed text joined"), (*Streamed)->Response, FString(TEXT("effect: fire")));
+		TestEqual(TEXT("One chunk per content delta"), (*Streamed)->Chunks.Num(), 2);
+		TestTrue(TEXT("Request asks for a stream"), Server->GetLastRequestBody().Contains(TEXT("\"stream\":true")));
+		return true;
+	}));
+
+	TSharedRef<TSharedPtr<FOpenAIOutcome>> ToolCall = MakeShared<TSharedPtr<FOpenAIOutcome>>();
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([Server, ToolCall]()
+	{
+		Server->QueueReply(200, TEXT("text/event-stream"),
+			MakeDeltaEvent(TEXT("{\"tool_calls\":[{\"index\":0,\"id\":\"call_1\",\"type\":\"function\",\"function\":{\"name\":\"tool_texture\",\"arguments\":\"\"}}]}")) +
+			MakeDeltaEvent(TEXT("{\"tool_calls\":[{\"index\":0,\"function\":{\"arguments\":\"{\\\"type\\\":\"}}]}")) +
+			MakeDeltaEvent(TEXT("{\"tool_calls\":[{\"index\":0,\"function\":{\"arguments\":\"\\\"fire\\\"}\"}}]}")) +
+			MakeDeltaEvent(TEXT("{}"), TEXT("tool_calls")) +
+			TEXT("data: [DONE]\n\n"));
+		*ToolCall = SendLoopbackChat(Server->GetBaseURL(), true);
+		return true;
+	}));
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, ToolCall]()
+	{
+		if (!IsFinished(*ToolCall))
+		{
+			return false;
+		}
+		TestEqual(TEXT("Streamed tool call handed on as a functionCall"), (*ToolCall)->Response,
+			FString(TEXT("{\"functionCall\":{\"name\":\"tool:texture\",\"args\":{\"type\":\"fire\"}}}")));
+		return true;
+	}));
+
+	TSharedRef<TSharedPtr<FOpenAIOutcome>> Rejected = MakeShared<TSharedPtr<FOpenAIOutcome>>();
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([Server, Rejected]()
+	{
+		Server->QueueReply(401, TEXT("application/json"), TEXT("{\"error\":{\"message\":\"Invalid API Key\",\"type\":\"invalid_request_error\"}}"));
+		*Rejected = SendLoopbackChat(Server->GetBaseURL(), false);
+		return true;
+	}));
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Rejected]()
+	{
+		if (!IsFinished(*Rejected))
+		{
+			return false;
+		}
+		TestEqual(TEXT("Error code"), (*Rejected)->ErrorCode, 401);
+		TestTrue(TEXT("Server's message kept"), (*Rejected)->ErrorMessage.Contains(TEXT("Invalid API Key")));
+		return true;
+	}));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -5,6 +5,54 @@
 #include "Misc/AutomationTest.h"
 #include "Engine/Texture2D.h"
 #include "Misc/Base64.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Tasks/Task.h"
+
+namespace
+{
+	/**
+	 * Imagen reply carrying a Size x Size PNG with a pattern that depends on the pixel position
+	 * @param bInlineData Use the candidates/inlineData format instead of predictions
+	 */
+	FString MakeImagenReply(int32 Size, bool bInlineData = false)
+	{
+		TArray<uint8> Pixels;
+		Pixels.SetNumUninitialized(Size * Size * 4);
+		for (int32 Y = 0; Y < Size; ++Y)
+		{
+			for (int32 X = 0; X < Size; ++X)
+			{
+				uint8* Pixel = &Pixels[(Y * Size + X) * 4];
+				Pixel[0] = static_cast<uint8>(X * 37);
+				Pixel[1] = static_cast<uint8>(Y * 53);
+				Pixel[2] = static_cast<uint8>(X ^ Y);
+				Pixel[3] = 255;
+			}
+		}
+
+		IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+		TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+		ImageWrapper->SetRaw(Pixels.GetData(), Pixels.Num(), Size, Size, ERGBFormat::BGRA, 8);
+		const TArray64<uint8> PNG = ImageWrapper->GetCompressed();
+
+		const FString Base64 = FBase64::Encode(PNG.GetData(), PNG.Num());
+		if (bInlineData)
+		{
+			return FString::Printf(TEXT("{\"candidates\": [{\"content\": {\"parts\": [{\"inlineData\": {\"mimeType\": \"image/png\", \"data\": \"%s\"}}]}}]}"), *Base64);
+		}
+		return FString::Printf(TEXT("{\"predictions\": [{\"bytesBase64Encoded\": \"%s\"}]}"), *Base64);
+	}
+
+	/** Reply body as the HTTP module receives it */
+	TArray<uint8> ToUTF8(const FString& Text)
+	{
+		const FTCHARToUTF8 Converted(*Text);
+		return TArray<uint8>(reinterpret_cast<const uint8*>(Converted.Get()), Converted.Length());
+	}
+}
 
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTextureGenerationHandler_ValidateRequest_ValidRequest, "AINiagara.Tools.TextureGenerationHandler.ValidateRequest.ValidRequest", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
 bool FTextureGenerationHandler_ValidateRequest_ValidRequest::RunTest(const FString& Parameters)
@@ -206,3 +254,192 @@ bool FTextureGenerationHandler_DecodeBase64_InvalidData::RunTest(const FString&
 	return true;
 }
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTextureGenerationHandler_DecodeImageResponse_Predictions, "AINiagara.Tools.TextureGenerationHandler.DecodeImageResponse.Predictions", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FTextureGenerationHandler_DecodeImageResponse_Predictions::RunTest(const FString& Parameters)
+{
+	// Arrange
+	const FString Reply = MakeImagenReply(4);
+	FString Base64Data;
+	FTextureImageData Image;
+	FString Error;
+
+	// Act
+	bool bSuccess = UTextureGenerationHandler::DecodeImageResponse(Reply, Base64Data, Image, Error);
+
+	// Assert
+	TestTrue(TEXT("Decoding an Imagen reply should succeed"), bSuccess);
+	TestEqual(TEXT("Width"), Image.Width, 4);
+	TestEqual(TEXT("Height"), Image.Height, 4);
+	TestEqual(TEXT("BGRA bytes"), static_cast<int32>(Image.BGRA.Num()), 4 * 4 * 4);
+	TestFalse(TEXT("Base64 data is kept"), Base64Data.IsEmpty());
+	if (Image.BGRA.Num() == 4 * 4 * 4)
+	{
+		// Pixel (2, 1)
+		const uint8* Pixel = &Image.BGRA[(1 * 4 + 2) * 4];
+		TestEqual(TEXT("Blue"), static_cast<int32>(Pixel[0]), 2 * 37);
+		TestEqual(TEXT("Green"), static_cast<int32>(Pixel[1]), 1 * 53);
+		TestEqual(TEXT("Red"), static_cast<int32>(Pixel[2]), 2 ^ 1);
+	}
+
+	// The texture is created from the decoded pixels on the game thread
+	UTexture2D* Texture = UTextureGenerationHandler::CreateTextureFromImage(Image, TEXT("T_DecodeTest"));
+	TestNotNull(TEXT("Texture created"), Texture);
+	if (Texture)
+	{
+		TestEqual(TEXT("Texture width"), Texture->GetSizeX(), 4);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTextureGenerationHandler_DecodeImageResponse_NoImage, "AINiagara.Tools.TextureGenerationHandler.DecodeImageResponse.NoImage", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FTextureGenerationHandler_DecodeImageResponse_NoImage::RunTest(const FString& Parameters)
+{
+	// Arrange
+	FString Base64Data;
+	FTextureImageData Image;
+	FString Error;
+
+	// Act & Assert
+	TestFalse(TEXT("Reply without an image"), UTextureGenerationHandler::DecodeImageResponse(TEXT("{\"predictions\": []}"), Base64Data, Image, Error));
+	TestEqual(TEXT("No image error"), Error, FString(TEXT("No image data found in Imagen 3 response")));
+
+	TestFalse(TEXT("Reply that is not JSON"), UTextureGenerationHandler::DecodeImageResponse(TEXT("A warm campfire"), Base64Data, Image, Error));
+	TestEqual(TEXT("Parse error"), Error, FString(TEXT("Failed to parse Imagen 3 response JSON")));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTextureGenerationHandler_Benchmark_GameThreadHitch, "AINiagara.Tools.TextureGenerationHandler.Benchmark.GameThreadHitch", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+bool FTextureGenerationHandler_Benchmark_GameThreadHitch::RunTest(const FString& Parameters)
+{
+	const int32 Iterations = 5;
+	const FString Reply = MakeImagenReply(2048);
+
+	// Before: JSON, base64 and PNG decoding ran on the game thread along with texture creation
+	double WorstBeforeMs = 0.0;
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		FString Base64Data;
+		FTextureImageData Image;
+		FString Error;
+		if (UTextureGenerationHandler::DecodeImageResponse(Reply, Base64Data, Image, Error))
+		{
+			UTextureGenerationHandler::CreateTextureFromImage(Image, TEXT("T_HitchBefore"));
+		}
+		WorstBeforeMs = FMath::Max(WorstBeforeMs, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+	}
+
+	// After: decoding runs on a worker; the game thread launches it and creates the texture
+	double WorstAfterMs = 0.0;
+	bool bAllCreated = true;
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		TSharedRef<FTextureImageData, ESPMode::ThreadSafe> Image = MakeShared<FTextureImageData, ESPMode::ThreadSafe>();
+		double StartTime = FPlatformTime::Seconds();
+		UE::Tasks::FTask Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [&Reply, Image]()
+		{
+			FString Base64Data;
+			FString Error;
+			UTextureGenerationHandler::DecodeImageResponse(Reply, Base64Data, *Image, Error);
+		});
+		double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		// Waiting stands in for the frames the editor keeps ticking meanwhile
+		Task.Wait();
+
+		StartTime = FPlatformTime::Seconds();
+		bAllCreated &= UTextureGenerationHandler::CreateTextureFromImage(*Image, TEXT("T_HitchAfter")) != nullptr;
+		ElapsedMs += (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		WorstAfterMs = FMath::Max(WorstAfterMs, ElapsedMs);
+	}
+
+	TestTrue(TEXT("Every texture was created"), bAllCreated);
+	AddInfo(FString::Printf(TEXT("2048x2048 image reply of %d chars, worst game thread time: before %.2f ms, after %.2f ms"),
+		Reply.Len(), WorstBeforeMs, WorstAfterMs));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTextureGenerationHandler_DecodeImageContent_Formats, "AINiagara.Tools.TextureGenerationHandler.DecodeImageContent.Formats", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FTextureGenerationHandler_DecodeImageContent_Formats::RunTest(const FString& Parameters)
+{
+	// Arrange
+	const TArray<uint8> Predictions = ToUTF8(MakeImagenReply(8));
+	const TArray<uint8> InlineData = ToUTF8(MakeImagenReply(8, true));
+	FTextureImageData Image;
+	FString Error;
+
+	// Act & Assert
+	TestTrue(TEXT("Predictions reply decodes from bytes"), UTextureGenerationHandler::DecodeImageContent(Predictions, Image, Error));
+	TestEqual(TEXT("Predictions width"), Image.Width, 8);
+
+	Image = FTextureImageData();
+	TestTrue(TEXT("Inline data reply decodes from bytes"), UTextureGenerationHandler::DecodeImageContent(InlineData, Image, Error));
+	TestEqual(TEXT("Inline data height"), Image.Height, 8);
+
+	// Both paths produce the same pixels
+	FTextureImageData TextImage;
+	FString Base64Data;
+	UTextureGenerationHandler::DecodeImageResponse(MakeImagenReply(8), Base64Data, TextImage, Error);
+	TestTrue(TEXT("Same pixels as the text path"), TextImage.BGRA == Image.BGRA);
+
+	// The value is located where it lies
+	int32 Start = INDEX_NONE;
+	int32 Length = 0;
+	bool bEscaped = false;
+	const TArray<uint8> Escaped = ToUTF8(TEXT("{\"predictions\": [{\"bytesBase64Encoded\" : \"ab\\/cd\"}]}"));
+	TestTrue(TEXT("Escaped value is found"), UTextureGenerationHandler::FindImageBase64(Escaped, Start, Length, bEscaped));
+	TestTrue(TEXT("Escape is reported"), bEscaped);
+	TestEqual(TEXT("Value length"), Length, 6);
+
+	TestFalse(TEXT("Reply without an image"), UTextureGenerationHandler::DecodeImageContent(ToUTF8(TEXT("{\"predictions\": []}")), Image, Error));
+	TestEqual(TEXT("No image error"), Error, FString(TEXT("No image data found in Imagen 3 response")));
+	TestFalse(TEXT("Key without a string value"), UTextureGenerationHandler::FindImageBase64(ToUTF8(TEXT("{\"bytesBase64Encoded\": 12}")), Start, Length, bEscaped));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTextureGenerationHandler_Benchmark_BytePath, "AINiagara.Tools.TextureGenerationHandler.Benchmark.BytePath", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+bool FTextureGenerationHandler_Benchmark_BytePath::RunTest(const FString& Parameters)
+{
+	const int32 Iterations = 5;
+	const int32 Sizes[] = { 512, 1024, 2048 };
+
+	for (const int32 Size : Sizes)
+	{
+		const TArray<uint8> Content = ToUTF8(MakeImagenReply(Size));
+
+		// Previous path: body to FString, JSON parse, base64 string copied out, decoded, then PNG
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			const FUTF8ToTCHAR Body(reinterpret_cast<const ANSICHAR*>(Content.GetData()), Content.Num());
+			FString Base64Data;
+			FTextureImageData Image;
+			FString Error;
+			UTextureGenerationHandler::DecodeImageResponse(FString(Body.Length(), Body.Get()), Base64Data, Image, Error);
+			UTextureGenerationHandler::CreateTextureFromImage(Image, TEXT("T_StringPath"));
+		}
+		const double StringPathMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+
+		// Byte path: the base64 is decoded where it lies into a reused buffer
+		bool bAllDecoded = true;
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			FTextureImageData Image;
+			FString Error;
+			bAllDecoded &= UTextureGenerationHandler::DecodeImageContent(Content, Image, Error);
+			UTextureGenerationHandler::CreateTextureFromImage(Image, TEXT("T_BytePath"));
+		}
+		const double BytePathMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+
+		TestTrue(FString::Printf(TEXT("%dx%d decodes from bytes"), Size, Size), bAllDecoded);
+		AddInfo(FString::Printf(TEXT("%dx%d reply of %d bytes: string path %.2f ms, byte path %.2f ms per image"),
+			Size, Size, Content.Num(), StringPathMs, BytePathMs));
+	}
+
+	return true;
+}
@@ -0,0 +1,216 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/VFXDSLBinaryFormat.h"
+#include "Core/VFXDSLParser.h"
+#include "Core/VFXDSL.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "VFXDSLTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLBinaryRoundTripTest,
+	"AINiagara.VFXDSLBinary.RoundTrip",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLBinaryRoundTripTest::RunTest(const FString& Parameters)
+{
+	// Start from parsed JSON so the binary path is checked against UVFXDSLParser
+	FString SourceJSON = TEXT(R"({
+		"effect": { "type": "Cascade", "duration": 3.5, "looping": true },
+		"emitters": [
+			{
+				"name": "Sparks é",
+				"spawners": { "burst": { "count": 40, "time": 0.25, "intervals": [0.1, 0.2, 0.4] }, "rate": { "spawnRate": 12.5 } },
+				"initialization": { "color": { "r": 1.0, "g": 0.4, "b": 0.1, "a": 0.8 }, "size": { "min": 0.5, "max": 3.0 } },
+				"update": { "forces": { "gravity": -500.0, "wind": { "x": 10.0 } }, "drag": 0.2, "collision": { "enabled": true, "bounce": 0.3 } },
+				"render": { "material": "/Game/M_Spark", "blendMode": "Additive", "mesh": { "meshPath": "/Game/SM_Rock", "meshType": "Custom", "scale": 2.0, "rotation": { "z": 45.0 }, "useMesh": true } }
+			},
+			{ "name": "Smoke" }
+		]
+	})");
+
+	FVFXDSL Original;
+	FString Error;
+	TestTrue(TEXT("Source JSON should parse"), UVFXDSLParser::ParseFromJSON(SourceJSON, Original, Error));
+
+	TArray<uint8> Bytes;
+	TestTrue(TEXT("Binary encoding should succeed"), FVFXDSLBinaryWriter::SaveToBytes(MakeArrayView(&Original, 1), Bytes));
+
+	FVFXDSLBinaryReader Reader;
+	TestTrue(TEXT("Binary header should be accepted"), Reader.OpenBytes(Bytes, Error));
+	TestEqual(TEXT("Library should contain one record"), Reader.GetNumRecords(), 1);
+
+	FVFXDSL Decoded;
+	TestTrue(TEXT("Record should decode"), Reader.Next(Decoded));
+	TestFalse(TEXT("No further records"), Reader.Next(Decoded));
+	TestTrue(TEXT("End of library is not an error"), Reader.GetError().IsEmpty());
+
+	FString OriginalJSON;
+	FString DecodedJSON;
+	UVFXDSLParser::ToJSON(Original, OriginalJSON);
+	UVFXDSLParser::ToJSON(Decoded, DecodedJSON);
+	TestTrue(TEXT("Decoded DSL should serialize identically"), DecodedJSON.Equals(OriginalJSON, ESearchCase::CaseSensitive));
+
+	// Check the mesh settings directly as well
+	const FVFXDSLMesh& Mesh = Decoded.Emitters[0].Render.Mesh;
+	TestEqual(TEXT("Mesh path"), Mesh.MeshPath, FString(TEXT("/Game/SM_Rock")));
+	TestEqual(TEXT("Mesh type"), Mesh.MeshType, FString(TEXT("Custom")));
+	TestEqual(TEXT("Mesh scale"), Mesh.Scale, 2.0f);
+	TestEqual(TEXT("Mesh rotation"), Mesh.Rotation.Z, 45.0f);
+	TestTrue(TEXT("Mesh enabled"), Mesh.bUseMesh);
+	TestTrue(TEXT("Non-ASCII names survive"), Decoded.Emitters[0].Name.Equals(TEXT("Sparks é"), ESearchCase::CaseSensitive));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLBinaryLibraryFileTest,
+	"AINiagara.VFXDSLBinary.LibraryFile",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLBinaryLibraryFileTest::RunTest(const FString& Parameters)
+{
+	TArray<FVFXDSL> Library;
+	for (int32 Index = 0; Index < 64; ++Index)
+	{
+		Library.Add(VFXDSLTestHelpers::MakeDSL(1 + (Index % 8), Index));
+	}
+
+	const FString FilePath = FPaths::ProjectSavedDir() / TEXT("AINiagara") / TEXT("Tests") / TEXT("BinaryLibraryTest.vdsl");
+	FString Error;
+	TestTrue(TEXT("Library should save"), FVFXDSLBinaryWriter::SaveToFile(Library, FilePath, Error));
+
+	for (bool bMemoryMap : { false, true })
+	{
+		FVFXDSLBinaryReader Reader;
+		TestTrue(TEXT("Library should open"), Reader.OpenFile(FilePath, bMemoryMap, Error));
+		TestEqual(TEXT("Record count"), Reader.GetNumRecords(), Library.Num());
+		TestEqual(TEXT("Version"), static_cast<int32>(Reader.GetVersion()), static_cast<int32>(VFXDSLBinary::EVersion::Latest));
+
+		// One destination reused for every record
+		FVFXDSL Decoded;
+		int32 RecordIndex = 0;
+		while (Reader.Next(Decoded))
+		{
+			FString Expected;
+			FString Actual;
+			UVFXDSLParser::ToJSON(Library[RecordIndex], Expected);
+			UVFXDSLParser::ToJSON(Decoded, Actual);
+			TestTrue(FString::Printf(TEXT("Record %d (mapped: %d) should match"), RecordIndex, bMemoryMap), Actual.Equals(Expected, ESearchCase::CaseSensitive));
+			++RecordIndex;
+		}
+
+		TestEqual(TEXT("All records should be read"), RecordIndex, Library.Num());
+		TestTrue(TEXT("Iteration should end cleanly"), Reader.GetError().IsEmpty());
+	}
+
+	IFileManager::Get().Delete(*FilePath);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLBinaryCorruptDataTest,
+	"AINiagara.VFXDSLBinary.CorruptData",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLBinaryCorruptDataTest::RunTest(const FString& Parameters)
+{
+	FVFXDSL DSL;
+	DSL.Emitters.AddDefaulted_GetRef().Name = TEXT("Flames");
+	DSL.Emitters.AddDefaulted_GetRef().Name = TEXT("Smoke");
+	TArray<uint8> Bytes;
+	FVFXDSLBinaryWriter::SaveToBytes(MakeArrayView(&DSL, 1), Bytes);
+
+	FString Error;
+	FVFXDSLBinaryReader Reader;
+
+	TestFalse(TEXT("Empty input should be rejected"), Reader.OpenBytes(TConstArrayView<uint8>(), Error));
+
+	TArray<uint8> BadMagic = Bytes;
+	BadMagic[0] ^= 0xFF;
+	TestFalse(TEXT("Bad magic should be rejected"), Reader.OpenBytes(BadMagic, Error));
+
+	TArray<uint8> FutureVersion = Bytes;
+	FutureVersion[4] = 0xFF;
+	TestFalse(TEXT("Future versions should be rejected"), Reader.OpenBytes(FutureVersion, Error));
+	TestTrue(TEXT("Version error should be descriptive"), Error.Contains(TEXT("version")));
+
+	TArray<uint8> Truncated = Bytes;
+	Truncated.SetNum(Bytes.Num() - 16);
+	TestTrue(TEXT("Truncated library header is still readable"), Reader.OpenBytes(Truncated, Error));
+	FVFXDSL Decoded;
+	TestFalse(TEXT("Truncated record should fail"), Reader.Next(Decoded));
+	TestFalse(TEXT("Truncation should be reported"), Reader.GetError().IsEmpty());
+
+	// An emitter count the record cannot hold is rejected before the emitters are allocated
+	TArray<uint8> InflatedCount = Bytes;
+	const int32 NumEmittersOffset = static_cast<int32>(VFXDSLBinary::HeaderSize) + sizeof(uint32) + sizeof(uint8) + sizeof(float) + sizeof(uint8);
+	const int32 BogusCount = 100000;
+	FMemory::Memcpy(&InflatedCount[NumEmittersOffset], &BogusCount, sizeof(BogusCount));
+	TestTrue(TEXT("Inflated count header is still readable"), Reader.OpenBytes(InflatedCount, Error));
+	Decoded.Emitters.Empty();
+	TestFalse(TEXT("Inflated count should fail"), Reader.Next(Decoded));
+	TestTrue(TEXT("Inflated count allocates nothing"), Decoded.Emitters.Max() < BogusCount);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLBinaryBenchmarkTest,
+	"AINiagara.VFXDSLBinary.Benchmark.JSONVsBinaryLoad",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter
+)
+
+bool FVFXDSLBinaryBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const int32 NumDSLs = 2000;
+	const int32 EmittersPerDSL = 6;
+
+	TArray<FVFXDSL> Library;
+	TArray<FString> JsonLibrary;
+	int64 JsonBytes = 0;
+	for (int32 Index = 0; Index < NumDSLs; ++Index)
+	{
+		Library.Add(VFXDSLTestHelpers::MakeDSL(EmittersPerDSL, Index));
+		FString& Json = JsonLibrary.AddDefaulted_GetRef();
+		UVFXDSLParser::ToJSON(Library.Last(), Json);
+		JsonBytes += Json.Len();
+	}
+
+	TArray<uint8> Bytes;
+	FVFXDSLBinaryWriter::SaveToBytes(Library, Bytes);
+
+	FVFXDSL Decoded;
+	FString Error;
+
+	double StartTime = FPlatformTime::Seconds();
+	for (const FString& Json : JsonLibrary)
+	{
+		UVFXDSLParser::ParseFromJSON(Json, Decoded, Error);
+	}
+	const double JsonMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	StartTime = FPlatformTime::Seconds();
+	FVFXDSLBinaryReader Reader;
+	Reader.OpenBytes(Bytes, Error);
+	int32 NumDecoded = 0;
+	while (Reader.Next(Decoded))
+	{
+		++NumDecoded;
+	}
+	const double BinaryMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	TestEqual(TEXT("Every record should decode"), NumDecoded, NumDSLs);
+	AddInfo(FString::Printf(TEXT("%d DSLs x %d emitters: JSON %.2f ms (%lld chars), binary %.2f ms (%d bytes), speedup %.1fx"),
+		NumDSLs, EmittersPerDSL, JsonMs, JsonBytes, BinaryMs, Bytes.Num(), BinaryMs > 0.0 ? JsonMs / BinaryMs : 0.0));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
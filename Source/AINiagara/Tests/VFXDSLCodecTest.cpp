@@ -0,0 +1,351 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/VFXDSLCodec.h"
+#include "Core/VFXDSLDiff.h"
+#include "Core/VFXDSLHash.h"
+#include "Core/VFXDSLParser.h"
+#include "Core/VFXDSL.h"
+#include "Core/VFXDSLStreamParser.h"
+#include "VFXDSLTestHelpers.h"
+#include "VFXDSLHandWrittenCodec.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Change a leaf by more than its tolerance */
+	void BumpField(const FVFXDSLCodecField& Field, void* Base)
+	{
+		switch (Field.Type)
+		{
+		case EVFXDSLCodecType::Float:
+			FVFXDSLCodec::GetValue<float>(Field, Base) += 0.25f;
+			break;
+		case EVFXDSLCodecType::Int32:
+			FVFXDSLCodec::GetValue<int32>(Field, Base) += 3;
+			break;
+		case EVFXDSLCodecType::Bool:
+			FVFXDSLCodec::GetValue<bool>(Field, Base) = !FVFXDSLCodec::GetValue<bool>(Field, Base);
+			break;
+		case EVFXDSLCodecType::String:
+			FVFXDSLCodec::GetValue<FString>(Field, Base) += TEXT("_Edited");
+			break;
+		case EVFXDSLCodecType::Enum:
+			FVFXDSLCodec::SetEnumValue(Field, Base, FVFXDSLCodec::GetEnumValue(Field, Base) == Field.EnumEntries[0].Key ? Field.EnumEntries.Last().Key : Field.EnumEntries[0].Key);
+			break;
+		case EVFXDSLCodecType::FloatArray:
+			FVFXDSLCodec::GetValue<TArray<float>>(Field, Base).Add(0.75f);
+			break;
+		case EVFXDSLCodecType::Struct:
+			break;
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLCodecTablesTest,
+	"AINiagara.VFXDSLCodec.Tables",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLCodecTablesTest::RunTest(const FString& Parameters)
+{
+	const FVFXDSLCodec& Codec = FVFXDSLCodec::Get();
+	const FVFXDSLCodecTable& EffectTable = Codec.GetEffectTable();
+	const FVFXDSLCodecTable& EmitterTable = Codec.GetEmitterTable();
+
+	TestEqual(TEXT("Effect leaves"), EffectTable.Leaves.Num(), 3);
+	TestEqual(TEXT("Emitter leaves"), EmitterTable.Leaves.Num(), 33);
+	TestEqual(TEXT("Compare order covers every leaf"), EmitterTable.CompareOrder.Num(), EmitterTable.Leaves.Num());
+
+	FVFXDSLEmitter Emitter;
+	FVFXDSLEffect Effect;
+
+	const int32 BounceIndex = EmitterTable.FindField(TEXT("Update.Collision.Bounce"));
+	const int32 EnabledIndex = EmitterTable.FindField(TEXT("update.collision.enabled"));
+	const int32 ColorRIndex = EmitterTable.FindField(TEXT("Initialization.Color.R"));
+	const int32 CountIndex = EmitterTable.FindField(TEXT("Spawners.Burst.Count"));
+	const int32 UseMeshIndex = EmitterTable.FindField(TEXT("Render.Mesh.UseMesh"));
+	const int32 TypeIndex = EffectTable.FindField(TEXT("Effect.Type"));
+	const int32 DurationIndex = EffectTable.FindField(TEXT("Effect.Duration"));
+	if (BounceIndex == INDEX_NONE || EnabledIndex == INDEX_NONE || ColorRIndex == INDEX_NONE || CountIndex == INDEX_NONE
+		|| UseMeshIndex == INDEX_NONE || TypeIndex == INDEX_NONE || DurationIndex == INDEX_NONE)
+	{
+		AddError(TEXT("Expected fields are missing from the codec tables"));
+		return false;
+	}
+
+	// Keys, offsets and types come from the UPROPERTY data
+	const FVFXDSLCodecField& Bounce = EmitterTable.Fields[BounceIndex];
+	TestTrue(TEXT("Bounce offset"), &FVFXDSLCodec::GetValue<float>(Bounce, &Emitter) == &Emitter.Update.Collision.Bounce);
+	TestEqual(TEXT("Bool keys drop the b prefix"), EmitterTable.Fields[EnabledIndex].JsonKey, FString(TEXT("enabled")));
+	TestEqual(TEXT("Keys start lower-case"), EmitterTable.Fields[UseMeshIndex].JsonKey, FString(TEXT("useMesh")));
+	TestTrue(TEXT("Mesh flag offset"), &FVFXDSLCodec::GetValue<bool>(EmitterTable.Fields[UseMeshIndex], &Emitter) == &Emitter.Render.Mesh.bUseMesh);
+	TestTrue(TEXT("Effect type is an enum"), EffectTable.Fields[TypeIndex].Type == EVFXDSLCodecType::Enum);
+	TestEqual(TEXT("Enum names"), FVFXDSLCodec::GetEnumName(EffectTable.Fields[TypeIndex], &Effect), FString(TEXT("Niagara")));
+
+	// Metadata
+	TestEqual(TEXT("Color tolerance"), EmitterTable.Fields[ColorRIndex].Tolerance, VFXDSLTolerance::Color);
+	TestEqual(TEXT("Count tolerance"), EmitterTable.Fields[CountIndex].Tolerance, VFXDSLTolerance::Count);
+	TestTrue(TEXT("Color range"), EmitterTable.Fields[ColorRIndex].bValidated && EmitterTable.Fields[ColorRIndex].RangeMax == 1.0);
+	TestTrue(TEXT("Color field id"), EmitterTable.Fields[ColorRIndex].FieldId == EVFXDSLFieldId::InitializationColorR);
+	TestTrue(TEXT("Duration field id"), EffectTable.Fields[DurationIndex].FieldId == EVFXDSLFieldId::EffectDuration);
+	TestTrue(TEXT("Bounce depends on collision being enabled"), Bounce.ConditionOffset == EmitterTable.Fields[EnabledIndex].Offset);
+
+	// Every leaf is compared, serialized and hashed: a one-field edit is one change and survives JSON.
+	// Collision is on for the first emitter, so Bounce is live too.
+	const FVFXDSL Base = VFXDSLTestHelpers::MakeNamedDSL({ TEXT("Sparks") });
+	const uint64 BaseHash = FVFXDSLHash::Hash(Base);
+	for (int32 FieldIndex : EmitterTable.Leaves)
+	{
+		const FVFXDSLCodecField& Field = EmitterTable.Fields[FieldIndex];
+
+		FVFXDSL Edited = Base;
+		BumpField(Field, &Edited.Emitters[0]);
+
+		const FVFXDSLDiffResult Diff = UVFXDSLDiff::Compare(Base, Edited);
+		TestEqual(FString::Printf(TEXT("%s: one change"), *Field.Path), Diff.Changes.Num(), 1);
+		if (Diff.Changes.Num() == 1)
+		{
+			TestEqual(FString::Printf(TEXT("%s: change path"), *Field.Path), Diff.Changes[0].PropertyPath, TEXT("Emitters[0].") + Field.Path);
+		}
+		TestTrue(FString::Printf(TEXT("%s: AnyDifference"), *Field.Path), UVFXDSLDiff::AnyDifference(Base, Edited));
+		TestNotEqual(FString::Printf(TEXT("%s: hashed"), *Field.Path), FVFXDSLHash::Hash(Edited), BaseHash);
+
+		FString Json;
+		FString Error;
+		FVFXDSL Parsed;
+		UVFXDSLParser::ToJSON(Edited, Json);
+		TestTrue(FString::Printf(TEXT("%s: parses"), *Field.Path), UVFXDSLParser::ParseFromJSON(Json, Parsed, Error));
+		TestFalse(FString::Printf(TEXT("%s: JSON round trip"), *Field.Path), UVFXDSLDiff::AnyDifference(Edited, Parsed));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLCodecRangeMetadataTest,
+	"AINiagara.VFXDSLCodec.RangeMetadata",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLCodecRangeMetadataTest::RunTest(const FString& Parameters)
+{
+	const FVFXDSLCodecTable& Table = FVFXDSLCodec::Get().GetEmitterTable();
+	const FVFXDSL Base = VFXDSLTestHelpers::MakeNamedDSL({ TEXT("Sparks") });
+	TestTrue(TEXT("Fixture is valid"), UVFXDSLValidator::Validate(Base).bIsValid);
+
+	int32 NumValidated = 0;
+	for (int32 FieldIndex : Table.Leaves)
+	{
+		const FVFXDSLCodecField& Field = Table.Fields[FieldIndex];
+		if (!Field.bValidated)
+		{
+			continue;
+		}
+		++NumValidated;
+
+		FVFXDSL Invalid = Base;
+		void* EmitterBase = &Invalid.Emitters[0];
+		const double OutOfRange = Field.RangeMin > -DBL_MAX ? Field.RangeMin - 1.0 : Field.RangeMax + 1.0;
+		if (Field.Type == EVFXDSLCodecType::Int32)
+		{
+			FVFXDSLCodec::GetValue<int32>(Field, EmitterBase) = static_cast<int32>(OutOfRange);
+		}
+		else
+		{
+			FVFXDSLCodec::GetValue<float>(Field, EmitterBase) = static_cast<float>(OutOfRange);
+		}
+
+		if (Field.ConditionOffset != INDEX_NONE)
+		{
+			bool& bCondition = *reinterpret_cast<bool*>(static_cast<uint8*>(EmitterBase) + Field.ConditionOffset);
+			bCondition = false;
+			TestFalse(FString::Printf(TEXT("%s: not checked while its condition is off"), *Field.Path),
+				UVFXDSLValidator::Validate(Invalid).HasError(Field.RangeCode));
+			bCondition = true;
+		}
+
+		const FVFXDSLValidationResult Result = UVFXDSLValidator::Validate(Invalid);
+		TestTrue(FString::Printf(TEXT("%s: out of range is reported"), *Field.Path), Result.Errors.ContainsByPredicate([&Field](const FVFXDSLValidationError& Error)
+		{
+			return Error.Code == Field.RangeCode && Error.Field == Field.FieldId && Error.EmitterIndex == 0;
+		}));
+	}
+
+	TestEqual(TEXT("Range-checked emitter fields"), NumValidated, 9);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLCodecBenchmarkTest,
+	"AINiagara.VFXDSLCodec.Benchmark.TableVsHandWritten",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter
+)
+
+bool FVFXDSLCodecBenchmarkTest::RunTest(const FString& Parameters)
+{
+	namespace HandWritten = VFXDSLHandWrittenCodec;
+
+	const int32 Iterations = 20;
+	const int32 DiffIterations = Iterations * 10;
+	const FVFXDSL DSL = VFXDSLTestHelpers::MakeDSL(500, 9);
+	const FString Json = VFXDSLTestHelpers::MakeDSLJson(500, 9);
+
+	// The table path may cost this much more than the hand-written code before the test fails
+	const double Tolerance = 1.5;
+
+	// Best of three runs, to keep scheduler noise out of the comparison
+	auto TimeMs = [](int32 Count, TFunctionRef<void()> Body)
+	{
+		double BestMs = DBL_MAX;
+		for (int32 Run = 0; Run < 3; ++Run)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < Count; ++Iteration)
+			{
+				Body();
+			}
+			BestMs = FMath::Min(BestMs, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+		}
+		return BestMs;
+	};
+
+	auto CheckWithinTolerance = [this, Tolerance](const TCHAR* What, double TableMs, double HandWrittenMs)
+	{
+		TestTrue(FString::Printf(TEXT("%s: table path (%.2f ms) within %.1fx of hand-written (%.2f ms)"), What, TableMs, Tolerance, HandWrittenMs),
+			TableMs <= HandWrittenMs * Tolerance);
+	};
+
+	// Parse: table-driven emitter reader vs the hand-written stream reader it replaced
+	TArray<FString> EmitterJson;
+	for (const FVFXDSLEmitter& Emitter : DSL.Emitters)
+	{
+		EmitterJson.Add(HandWritten::EmitterToJSON(Emitter));
+	}
+
+	TArray<FVFXDSLEmitter> Parsed;
+	Parsed.SetNum(EmitterJson.Num());
+	const double ParseMs = TimeMs(Iterations, [&EmitterJson, &Parsed]()
+	{
+		for (int32 Index = 0; Index < EmitterJson.Num(); ++Index)
+		{
+			FVFXDSLStreamParser::ParseEmitter(EmitterJson[Index], Parsed[Index]);
+		}
+	});
+
+	TArray<FVFXDSLEmitter> ParsedHandWritten;
+	ParsedHandWritten.SetNum(EmitterJson.Num());
+	const double ParseHandWrittenMs = TimeMs(Iterations, [&EmitterJson, &ParsedHandWritten]()
+	{
+		for (int32 Index = 0; Index < EmitterJson.Num(); ++Index)
+		{
+			HandWritten::ParseEmitter(EmitterJson[Index], ParsedHandWritten[Index]);
+		}
+	});
+
+	for (int32 Index = 0; Index < Parsed.Num(); ++Index)
+	{
+		if (UVFXDSLDiff::EmitterDiffers(Parsed[Index], ParsedHandWritten[Index]))
+		{
+			AddError(FString::Printf(TEXT("Parsers disagree on emitter %d"), Index));
+			break;
+		}
+	}
+	CheckWithinTolerance(TEXT("Parse"), ParseMs, ParseHandWrittenMs);
+
+	// Whole documents through the DOM, for reference only
+	FString Error;
+	FVFXDSL ParsedDOM;
+	const double ParseDOMMs = TimeMs(Iterations, [&Json, &ParsedDOM, &Error]()
+	{
+		UVFXDSLParser::ParseFromJSONDOM(Json, ParsedDOM, Error);
+	});
+
+	// Serialize: table-driven writer vs the hand-written stream writer it replaced
+	FString Output;
+	const double WriteMs = TimeMs(Iterations, [&DSL, &Output]()
+	{
+		UVFXDSLParser::ToJSONWithFormat(DSL, EVFXDSLJsonFormat::Pretty, Output);
+	});
+
+	FString OutputHandWritten;
+	const int32 EstimatedLength = UVFXDSLParser::EstimateJSONLength(DSL, EVFXDSLJsonFormat::Pretty);
+	const double WriteHandWrittenMs = TimeMs(Iterations, [&DSL, EstimatedLength, &OutputHandWritten]()
+	{
+		HandWritten::ToJSONPretty(DSL, EstimatedLength, OutputHandWritten);
+	});
+	TestTrue(TEXT("Both writers agree"), Output.Equals(OutputHandWritten, ESearchCase::CaseSensitive));
+	CheckWithinTolerance(TEXT("Write"), WriteMs, WriteHandWrittenMs);
+
+	FString OutputDOM;
+	const double WriteDOMMs = TimeMs(Iterations, [&DSL, &OutputDOM]()
+	{
+		UVFXDSLParser::ToJSONDOM(DSL, OutputDOM);
+	});
+
+	// Unchanged comparison walks every field: the worst case for the early-out
+	const FVFXDSL Copy = DSL;
+	int32 NumDiffering = 0;
+	const double DiffMs = TimeMs(DiffIterations, [&DSL, &Copy, &NumDiffering]()
+	{
+		for (int32 Index = 0; Index < DSL.Emitters.Num(); ++Index)
+		{
+			NumDiffering += UVFXDSLDiff::EmitterDiffers(DSL.Emitters[Index], Copy.Emitters[Index]) ? 1 : 0;
+		}
+	});
+
+	int32 NumDifferingHandWritten = 0;
+	const double DiffHandWrittenMs = TimeMs(DiffIterations, [&DSL, &Copy, &NumDifferingHandWritten]()
+	{
+		for (int32 Index = 0; Index < DSL.Emitters.Num(); ++Index)
+		{
+			NumDifferingHandWritten += HandWritten::EmitterDiffers(DSL.Emitters[Index], Copy.Emitters[Index]) ? 1 : 0;
+		}
+	});
+	TestEqual(TEXT("Comparisons agree"), NumDiffering, NumDifferingHandWritten);
+	CheckWithinTolerance(TEXT("EmitterDiffers"), DiffMs, DiffHandWrittenMs);
+
+	// Emitter range checks only, both recording every error; every fifth emitter is out of range
+	FVFXDSL Invalid = DSL;
+	for (int32 Index = 0; Index < Invalid.Emitters.Num(); Index += 5)
+	{
+		Invalid.Emitters[Index].Initialization.Color.R = 1.5f;
+		Invalid.Emitters[Index].Update.Collision.bEnabled = true;
+		Invalid.Emitters[Index].Update.Collision.Bounce = 2.0f;
+	}
+
+	const FVFXDSLCodecTable& EmitterTable = FVFXDSLCodec::Get().GetEmitterTable();
+	FVFXDSLValidationResult Result;
+	const double ValidateMs = TimeMs(DiffIterations, [&Invalid, &EmitterTable, &Result]()
+	{
+		Result = FVFXDSLValidationResult();
+		for (int32 Index = 0; Index < Invalid.Emitters.Num(); ++Index)
+		{
+			FVFXDSLCodec::ValidateRanges(EmitterTable, 0, EmitterTable.Leaves.Num(), &Invalid.Emitters[Index], Index, Result);
+		}
+	});
+
+	FVFXDSLValidationResult ResultHandWritten;
+	const double ValidateHandWrittenMs = TimeMs(DiffIterations, [&Invalid, &ResultHandWritten]()
+	{
+		ResultHandWritten = FVFXDSLValidationResult();
+		for (int32 Index = 0; Index < Invalid.Emitters.Num(); ++Index)
+		{
+			HandWritten::ValidateEmitterRanges(Invalid.Emitters[Index], Index, ResultHandWritten);
+		}
+	});
+	TestEqual(TEXT("Range checks agree"), Result.Errors.Num(), ResultHandWritten.Errors.Num());
+	TestTrue(TEXT("Range checks found the out-of-range emitters"), Result.Errors.Num() >= Invalid.Emitters.Num() / 5 * 2);
+	CheckWithinTolerance(TEXT("Range checks"), ValidateMs, ValidateHandWrittenMs);
+
+	AddInfo(FString::Printf(TEXT("500 emitters x %d: parse %.2f ms (hand-written %.2f ms, whole document via DOM %.2f ms), write %.2f ms (hand-written %.2f ms, DOM %.2f ms)"),
+		Iterations, ParseMs, ParseHandWrittenMs, ParseDOMMs, WriteMs, WriteHandWrittenMs, WriteDOMMs));
+	AddInfo(FString::Printf(TEXT("500 emitters x %d: EmitterDiffers %.2f ms (hand-written %.2f ms), range checks %.2f ms (hand-written %.2f ms)"),
+		DiffIterations, DiffMs, DiffHandWrittenMs, ValidateMs, ValidateHandWrittenMs));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,174 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/VFXDSLDiff.h"
+#include "Core/VFXDSL.h"
+#include "VFXDSLTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLDiffEmitterMatchingTest,
+	"AINiagara.VFXDSLDiff.EmitterMatching",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLDiffEmitterMatchingTest::RunTest(const FString& Parameters)
+{
+	const FVFXDSL Base = VFXDSLTestHelpers::MakeNamedDSL({ TEXT("Core"), TEXT("Sparks"), TEXT("Smoke"), TEXT("Embers") });
+
+	// Removing one emitter is one removal, not a cascade of modifications
+	FVFXDSL Removed = Base;
+	Removed.Emitters.RemoveAt(1);
+	FVFXDSLDiffResult Result = UVFXDSLDiff::Compare(Base, Removed);
+	TestEqual(TEXT("Removal is a single change"), Result.Changes.Num(), 1);
+	if (Result.Changes.Num() == 1)
+	{
+		TestTrue(TEXT("Reported as removed"), Result.Changes[0].ChangeType == EVFXDSLChangeType::Removed);
+		TestEqual(TEXT("Removal keeps the old path"), Result.Changes[0].PropertyPath, FString(TEXT("Emitters[1]")));
+	}
+
+	// Inserting at the front is one addition
+	FVFXDSL Inserted = Base;
+	FVFXDSLEmitter NewEmitter = Base.Emitters[0];
+	NewEmitter.Name = TEXT("Inserted");
+	Inserted.Emitters.Insert(NewEmitter, 0);
+	Result = UVFXDSLDiff::Compare(Base, Inserted);
+	TestEqual(TEXT("Insertion is a single change"), Result.Changes.Num(), 1);
+	if (Result.Changes.Num() == 1)
+	{
+		TestTrue(TEXT("Reported as added"), Result.Changes[0].ChangeType == EVFXDSLChangeType::Added);
+		TestEqual(TEXT("Addition uses the new path"), Result.Changes[0].PropertyPath, FString(TEXT("Emitters[0]")));
+	}
+
+	// Moving one emitter is one move
+	FVFXDSL Reordered = Base;
+	Reordered.Emitters.Insert(Reordered.Emitters.Pop(), 0);
+	Result = UVFXDSLDiff::Compare(Base, Reordered);
+	TestEqual(TEXT("Reorder is a single change"), Result.Changes.Num(), 1);
+	if (Result.Changes.Num() == 1)
+	{
+		TestTrue(TEXT("Move is described"), Result.Changes[0].Description.Contains(TEXT("moved from index 3 to 0")));
+	}
+
+	// Renaming pairs the emitter with itself
+	FVFXDSL Renamed = Base;
+	Renamed.Emitters[2].Name = TEXT("Renamed");
+	Result = UVFXDSLDiff::Compare(Base, Renamed);
+	TestEqual(TEXT("Rename is a single change"), Result.Changes.Num(), 1);
+	if (Result.Changes.Num() == 1)
+	{
+		TestEqual(TEXT("Rename path"), Result.Changes[0].PropertyPath, FString(TEXT("Emitters[2].Name")));
+	}
+
+	// Duplicate names fall back to content alignment
+	FVFXDSL Duplicates;
+	for (int32 Index = 0; Index < 4; ++Index)
+	{
+		FVFXDSLEmitter& Emitter = Duplicates.Emitters.AddDefaulted_GetRef();
+		Emitter.Spawners.Rate.SpawnRate = 10.0f * (Index + 1);
+	}
+	FVFXDSL DuplicatesInserted = Duplicates;
+	DuplicatesInserted.Emitters.Insert(FVFXDSLEmitter(), 2);
+	DuplicatesInserted.Emitters[2].Spawners.Rate.SpawnRate = 99.0f;
+	Result = UVFXDSLDiff::Compare(Duplicates, DuplicatesInserted);
+	TestEqual(TEXT("LCS reports an insertion among duplicate names"), Result.Changes.Num(), 1);
+	if (Result.Changes.Num() == 1)
+	{
+		TestTrue(TEXT("LCS insertion is an addition"), Result.Changes[0].ChangeType == EVFXDSLChangeType::Added);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLDiffAnyDifferenceTest,
+	"AINiagara.VFXDSLDiff.AnyDifference",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLDiffAnyDifferenceTest::RunTest(const FString& Parameters)
+{
+	const FVFXDSL Base = VFXDSLTestHelpers::MakeNamedDSL({ TEXT("Core"), TEXT("Sparks"), TEXT("Smoke"), TEXT("Embers"), TEXT("Glow"), TEXT("Debris") });
+	TestFalse(TEXT("Identical DSLs"), UVFXDSLDiff::AnyDifference(Base, Base));
+
+	TArray<FVFXDSL> Variants;
+	Variants.Add(Base);
+	Variants.Last().Emitters[5].Render.Sort = TEXT("None");
+	Variants.Add(Base);
+	Variants.Last().Emitters[0].Initialization.Color.B += 0.005f;
+	Variants.Add(Base);
+	Variants.Last().Emitters[3].Update.Collision.bEnabled = !Base.Emitters[3].Update.Collision.bEnabled;
+	Variants.Add(Base);
+	Variants.Last().Emitters.Swap(1, 4);
+	Variants.Add(Base);
+	Variants.Last().Effect.Duration += 1.0f;
+
+	// AnyDifference agrees with the full diff, including changes below tolerance
+	for (int32 Index = 0; Index < Variants.Num(); ++Index)
+	{
+		const bool bFull = UVFXDSLDiff::Compare(Base, Variants[Index]).bHasChanges;
+		TestEqual(FString::Printf(TEXT("Variant %d: AnyDifference matches Compare"), Index), UVFXDSLDiff::AnyDifference(Base, Variants[Index]), bFull);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLDiffBenchmarkTest,
+	"AINiagara.VFXDSLDiff.Benchmark.SingleFieldEdit500",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter
+)
+
+bool FVFXDSLDiffBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const int32 Iterations = 100;
+	const FVFXDSL Base = VFXDSLTestHelpers::MakeDSL(500, 5);
+
+	FVFXDSL Edited = Base;
+	Edited.Emitters[250].Spawners.Rate.SpawnRate += 1.0f;
+
+	FVFXDSL Renamed = Base;
+	Renamed.Emitters[250].Name = TEXT("Renamed");
+
+	double StartTime = FPlatformTime::Seconds();
+	int32 NumChanges = 0;
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		NumChanges = UVFXDSLDiff::Compare(Base, Edited).Changes.Num();
+	}
+	const double CompareMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	StartTime = FPlatformTime::Seconds();
+	int32 NumRenameChanges = 0;
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		NumRenameChanges = UVFXDSLDiff::Compare(Base, Renamed).Changes.Num();
+	}
+	const double RenameMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	StartTime = FPlatformTime::Seconds();
+	bool bAnyDifference = false;
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		bAnyDifference = UVFXDSLDiff::AnyDifference(Base, Edited);
+	}
+	const double AnyMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		bAnyDifference &= !UVFXDSLDiff::AnyDifference(Base, Base);
+	}
+	const double AnyUnchangedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	TestEqual(TEXT("Single-field edit is a single change"), NumChanges, 1);
+	TestEqual(TEXT("Rename is a single change"), NumRenameChanges, 1);
+	TestTrue(TEXT("AnyDifference detects the edit and ignores identical DSLs"), bAnyDifference);
+	AddInfo(FString::Printf(TEXT("500 emitters x %d: Compare %.2f ms, Compare (rename) %.2f ms, AnyDifference %.2f ms, AnyDifference (unchanged) %.2f ms"),
+		Iterations, CompareMs, RenameMs, AnyMs, AnyUnchangedMs));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,552 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/VFXDSL.h"
+#include "Core/JsonStringAppendArchive.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * The hand-written DSL code paths that FVFXDSLCodec replaced, kept as benchmark baselines.
+ * Each function does the same work as its table-driven counterpart and must produce the same result.
+ */
+namespace VFXDSLHandWrittenCodec
+{
+	typedef TJsonReader<TCHAR> FReader;
+
+	inline bool SkipValue(FReader& Reader, EJsonNotation Notation)
+	{
+		switch (Notation)
+		{
+		case EJsonNotation::ObjectStart:
+			return Reader.SkipObject();
+		case EJsonNotation::ArrayStart:
+			return Reader.SkipArray();
+		case EJsonNotation::Error:
+			return false;
+		default:
+			return true;
+		}
+	}
+
+	inline bool TryGetNumber(FReader& Reader, EJsonNotation Notation, double& OutValue)
+	{
+		switch (Notation)
+		{
+		case EJsonNotation::Number:
+			OutValue = Reader.GetValueAsNumber();
+			return true;
+		case EJsonNotation::Boolean:
+			OutValue = Reader.GetValueAsBoolean() ? 1.0 : 0.0;
+			return true;
+		case EJsonNotation::String:
+			{
+				const FString& StringValue = Reader.GetValueAsString();
+				if (StringValue.IsNumeric())
+				{
+					OutValue = FCString::Atod(*StringValue);
+					return true;
+				}
+				return false;
+			}
+		default:
+			return false;
+		}
+	}
+
+	inline bool ReadFloat(FReader& Reader, EJsonNotation Notation, float& InOutValue)
+	{
+		double Value;
+		if (TryGetNumber(Reader, Notation, Value))
+		{
+			InOutValue = static_cast<float>(Value);
+			return true;
+		}
+		return SkipValue(Reader, Notation);
+	}
+
+	inline bool ReadInt32(FReader& Reader, EJsonNotation Notation, int32& InOutValue)
+	{
+		double Value;
+		if (TryGetNumber(Reader, Notation, Value))
+		{
+			InOutValue = static_cast<int32>(Value);
+			return true;
+		}
+		return SkipValue(Reader, Notation);
+	}
+
+	inline bool ReadBool(FReader& Reader, EJsonNotation Notation, bool& InOutValue)
+	{
+		switch (Notation)
+		{
+		case EJsonNotation::Boolean:
+			InOutValue = Reader.GetValueAsBoolean();
+			return true;
+		case EJsonNotation::Number:
+			InOutValue = Reader.GetValueAsNumber() != 0.0;
+			return true;
+		case EJsonNotation::String:
+			InOutValue = Reader.GetValueAsString().ToBool();
+			return true;
+		default:
+			return SkipValue(Reader, Notation);
+		}
+	}
+
+	inline bool ReadString(FReader& Reader, EJsonNotation Notation, FString& InOutValue)
+	{
+		switch (Notation)
+		{
+		case EJsonNotation::String:
+			InOutValue = Reader.GetValueAsString();
+			return true;
+		case EJsonNotation::Number:
+			InOutValue = FString::SanitizeFloat(Reader.GetValueAsNumber(), 0);
+			return true;
+		case EJsonNotation::Boolean:
+			InOutValue = Reader.GetValueAsBoolean() ? TEXT("true") : TEXT("false");
+			return true;
+		default:
+			return SkipValue(Reader, Notation);
+		}
+	}
+
+	inline bool ReadFloatArray(FReader& Reader, TArray<float>& OutValues)
+	{
+		OutValues.Reset();
+
+		EJsonNotation Notation;
+		while (Reader.ReadNext(Notation))
+		{
+			if (Notation == EJsonNotation::ArrayEnd)
+			{
+				return true;
+			}
+
+			double Value = 0.0;
+			if (!TryGetNumber(Reader, Notation, Value) && !SkipValue(Reader, Notation))
+			{
+				return false;
+			}
+			OutValues.Add(static_cast<float>(Value));
+		}
+
+		return false;
+	}
+
+	/**
+	 * Read the members of an object; the ObjectStart token has already been consumed.
+	 * ReadMember returns -1 for unknown keys (skipped), otherwise 1 on success and 0 on malformed JSON.
+	 */
+	template <typename MemberReader>
+	bool ReadObject(FReader& Reader, MemberReader&& ReadMember)
+	{
+		EJsonNotation Notation;
+		while (Reader.ReadNext(Notation))
+		{
+			if (Notation == EJsonNotation::ObjectEnd)
+			{
+				return true;
+			}
+
+			const int32 Result = ReadMember(Reader.GetIdentifier(), Notation);
+			if (Result == 0 || (Result < 0 && !SkipValue(Reader, Notation)))
+			{
+				return false;
+			}
+		}
+
+		return false;
+	}
+
+	inline bool ReadVelocity(FReader& Reader, FVFXDSLVelocity& OutVelocity)
+	{
+		return ReadObject(Reader, [&Reader, &OutVelocity](const FString& Key, EJsonNotation Notation) -> int32
+		{
+			if (Key == TEXT("x")) { return ReadFloat(Reader, Notation, OutVelocity.X); }
+			if (Key == TEXT("y")) { return ReadFloat(Reader, Notation, OutVelocity.Y); }
+			if (Key == TEXT("z")) { return ReadFloat(Reader, Notation, OutVelocity.Z); }
+			return -1;
+		});
+	}
+
+	/** Read an emitter object; the ObjectStart token has already been consumed */
+	inline bool ReadEmitter(FReader& Reader, FVFXDSLEmitter& OutEmitter)
+	{
+		return ReadObject(Reader, [&Reader, &OutEmitter](const FString& Key, EJsonNotation Notation) -> int32
+		{
+			const bool bObject = (Notation == EJsonNotation::ObjectStart);
+			if (Key == TEXT("name"))
+			{
+				return ReadString(Reader, Notation, OutEmitter.Name);
+			}
+			if (bObject && Key == TEXT("spawners"))
+			{
+				FVFXDSLSpawners& Spawners = OutEmitter.Spawners;
+				return ReadObject(Reader, [&Reader, &Spawners](const FString& SpawnerKey, EJsonNotation SpawnerNotation) -> int32
+				{
+					if (SpawnerNotation == EJsonNotation::ObjectStart && SpawnerKey == TEXT("burst"))
+					{
+						return ReadObject(Reader, [&Reader, &Spawners](const FString& BurstKey, EJsonNotation BurstNotation) -> int32
+						{
+							if (BurstKey == TEXT("count")) { return ReadInt32(Reader, BurstNotation, Spawners.Burst.Count); }
+							if (BurstKey == TEXT("time")) { return ReadFloat(Reader, BurstNotation, Spawners.Burst.Time); }
+							if (BurstKey == TEXT("intervals") && BurstNotation == EJsonNotation::ArrayStart) { return ReadFloatArray(Reader, Spawners.Burst.Intervals); }
+							return -1;
+						});
+					}
+					if (SpawnerNotation == EJsonNotation::ObjectStart && SpawnerKey == TEXT("rate"))
+					{
+						return ReadObject(Reader, [&Reader, &Spawners](const FString& RateKey, EJsonNotation RateNotation) -> int32
+						{
+							if (RateKey == TEXT("spawnRate")) { return ReadFloat(Reader, RateNotation, Spawners.Rate.SpawnRate); }
+							if (RateKey == TEXT("scaleOverTime")) { return ReadFloat(Reader, RateNotation, Spawners.Rate.ScaleOverTime); }
+							return -1;
+						});
+					}
+					return -1;
+				});
+			}
+			if (bObject && Key == TEXT("initialization"))
+			{
+				FVFXDSLInitialization& Init = OutEmitter.Initialization;
+				return ReadObject(Reader, [&Reader, &Init](const FString& InitKey, EJsonNotation InitNotation) -> int32
+				{
+					if (InitNotation == EJsonNotation::ObjectStart && InitKey == TEXT("color"))
+					{
+						return ReadObject(Reader, [&Reader, &Init](const FString& ColorKey, EJsonNotation ColorNotation) -> int32
+						{
+							if (ColorKey == TEXT("r")) { return ReadFloat(Reader, ColorNotation, Init.Color.R); }
+							if (ColorKey == TEXT("g")) { return ReadFloat(Reader, ColorNotation, Init.Color.G); }
+							if (ColorKey == TEXT("b")) { return ReadFloat(Reader, ColorNotation, Init.Color.B); }
+							if (ColorKey == TEXT("a")) { return ReadFloat(Reader, ColorNotation, Init.Color.A); }
+							return -1;
+						});
+					}
+					if (InitNotation == EJsonNotation::ObjectStart && InitKey == TEXT("size"))
+					{
+						return ReadObject(Reader, [&Reader, &Init](const FString& SizeKey, EJsonNotation SizeNotation) -> int32
+						{
+							if (SizeKey == TEXT("min")) { return ReadFloat(Reader, SizeNotation, Init.Size.Min); }
+							if (SizeKey == TEXT("max")) { return ReadFloat(Reader, SizeNotation, Init.Size.Max); }
+							return -1;
+						});
+					}
+					if (InitNotation == EJsonNotation::ObjectStart && InitKey == TEXT("velocity"))
+					{
+						return ReadVelocity(Reader, Init.Velocity);
+					}
+					return -1;
+				});
+			}
+			if (bObject && Key == TEXT("update"))
+			{
+				FVFXDSLUpdate& Update = OutEmitter.Update;
+				return ReadObject(Reader, [&Reader, &Update](const FString& UpdateKey, EJsonNotation UpdateNotation) -> int32
+				{
+					if (UpdateNotation == EJsonNotation::ObjectStart && UpdateKey == TEXT("forces"))
+					{
+						return ReadObject(Reader, [&Reader, &Update](const FString& ForceKey, EJsonNotation ForceNotation) -> int32
+						{
+							if (ForceKey == TEXT("gravity")) { return ReadFloat(Reader, ForceNotation, Update.Forces.Gravity); }
+							if (ForceKey == TEXT("wind") && ForceNotation == EJsonNotation::ObjectStart) { return ReadVelocity(Reader, Update.Forces.Wind); }
+							return -1;
+						});
+					}
+					if (UpdateKey == TEXT("drag"))
+					{
+						return ReadFloat(Reader, UpdateNotation, Update.Drag);
+					}
+					if (UpdateNotation == EJsonNotation::ObjectStart && UpdateKey == TEXT("collision"))
+					{
+						return ReadObject(Reader, [&Reader, &Update](const FString& CollisionKey, EJsonNotation CollisionNotation) -> int32
+						{
+							if (CollisionKey == TEXT("enabled")) { return ReadBool(Reader, CollisionNotation, Update.Collision.bEnabled); }
+							if (CollisionKey == TEXT("bounce")) { return ReadFloat(Reader, CollisionNotation, Update.Collision.Bounce); }
+							return -1;
+						});
+					}
+					return -1;
+				});
+			}
+			if (bObject && Key == TEXT("render"))
+			{
+				FVFXDSLRender& Render = OutEmitter.Render;
+				return ReadObject(Reader, [&Reader, &Render](const FString& RenderKey, EJsonNotation RenderNotation) -> int32
+				{
+					if (RenderKey == TEXT("material")) { return ReadString(Reader, RenderNotation, Render.Material); }
+					if (RenderKey == TEXT("texture")) { return ReadString(Reader, RenderNotation, Render.Texture); }
+					if (RenderKey == TEXT("blendMode")) { return ReadString(Reader, RenderNotation, Render.BlendMode); }
+					if (RenderKey == TEXT("sort")) { return ReadString(Reader, RenderNotation, Render.Sort); }
+					if (RenderKey == TEXT("mesh") && RenderNotation == EJsonNotation::ObjectStart)
+					{
+						return ReadObject(Reader, [&Reader, &Render](const FString& MeshKey, EJsonNotation MeshNotation) -> int32
+						{
+							if (MeshKey == TEXT("meshPath")) { return ReadString(Reader, MeshNotation, Render.Mesh.MeshPath); }
+							if (MeshKey == TEXT("meshType")) { return ReadString(Reader, MeshNotation, Render.Mesh.MeshType); }
+							if (MeshKey == TEXT("scale")) { return ReadFloat(Reader, MeshNotation, Render.Mesh.Scale); }
+							if (MeshKey == TEXT("rotation") && MeshNotation == EJsonNotation::ObjectStart) { return ReadVelocity(Reader, Render.Mesh.Rotation); }
+							if (MeshKey == TEXT("useMesh")) { return ReadBool(Reader, MeshNotation, Render.Mesh.bUseMesh); }
+							return -1;
+						});
+					}
+					return -1;
+				});
+			}
+			return -1;
+		});
+	}
+
+	/** Same contract as FVFXDSLStreamParser::ParseEmitter */
+	inline bool ParseEmitter(FStringView JsonString, FVFXDSLEmitter& OutEmitter)
+	{
+		TSharedRef<FReader> Reader = TJsonReaderFactory<>::Create(FString(JsonString));
+
+		EJsonNotation Notation;
+		if (!Reader->ReadNext(Notation) || Notation != EJsonNotation::ObjectStart || !ReadEmitter(*Reader, OutEmitter))
+		{
+			return false;
+		}
+
+		while (Reader->ReadNext(Notation))
+		{
+		}
+
+		return Reader->GetErrorMessage().IsEmpty();
+	}
+
+	template <class CharType, class PrintPolicy>
+	void WriteEmitter(TJsonWriter<CharType, PrintPolicy>& Writer, const FVFXDSLEmitter& Emitter)
+	{
+		auto WriteXYZ = [&Writer](const TCHAR* Identifier, const FVFXDSLVelocity& Vector)
+		{
+			Writer.WriteObjectStart(Identifier);
+			Writer.WriteValue(TEXT("x"), static_cast<double>(Vector.X));
+			Writer.WriteValue(TEXT("y"), static_cast<double>(Vector.Y));
+			Writer.WriteValue(TEXT("z"), static_cast<double>(Vector.Z));
+			Writer.WriteObjectEnd();
+		};
+
+		Writer.WriteObjectStart();
+		Writer.WriteValue(TEXT("name"), Emitter.Name);
+
+		Writer.WriteObjectStart(TEXT("spawners"));
+		Writer.WriteObjectStart(TEXT("burst"));
+		Writer.WriteValue(TEXT("count"), static_cast<double>(Emitter.Spawners.Burst.Count));
+		Writer.WriteValue(TEXT("time"), static_cast<double>(Emitter.Spawners.Burst.Time));
+		Writer.WriteArrayStart(TEXT("intervals"));
+		for (float Interval : Emitter.Spawners.Burst.Intervals)
+		{
+			Writer.WriteValue(static_cast<double>(Interval));
+		}
+		Writer.WriteArrayEnd();
+		Writer.WriteObjectEnd();
+		Writer.WriteObjectStart(TEXT("rate"));
+		Writer.WriteValue(TEXT("spawnRate"), static_cast<double>(Emitter.Spawners.Rate.SpawnRate));
+		Writer.WriteValue(TEXT("scaleOverTime"), static_cast<double>(Emitter.Spawners.Rate.ScaleOverTime));
+		Writer.WriteObjectEnd();
+		Writer.WriteObjectEnd();
+
+		Writer.WriteObjectStart(TEXT("initialization"));
+		Writer.WriteObjectStart(TEXT("color"));
+		Writer.WriteValue(TEXT("r"), static_cast<double>(Emitter.Initialization.Color.R));
+		Writer.WriteValue(TEXT("g"), static_cast<double>(Emitter.Initialization.Color.G));
+		Writer.WriteValue(TEXT("b"), static_cast<double>(Emitter.Initialization.Color.B));
+		Writer.WriteValue(TEXT("a"), static_cast<double>(Emitter.Initialization.Color.A));
+		Writer.WriteObjectEnd();
+		Writer.WriteObjectStart(TEXT("size"));
+		Writer.WriteValue(TEXT("min"), static_cast<double>(Emitter.Initialization.Size.Min));
+		Writer.WriteValue(TEXT("max"), static_cast<double>(Emitter.Initialization.Size.Max));
+		Writer.WriteObjectEnd();
+		WriteXYZ(TEXT("velocity"), Emitter.Initialization.Velocity);
+		Writer.WriteObjectEnd();
+
+		Writer.WriteObjectStart(TEXT("update"));
+		Writer.WriteObjectStart(TEXT("forces"));
+		Writer.WriteValue(TEXT("gravity"), static_cast<double>(Emitter.Update.Forces.Gravity));
+		WriteXYZ(TEXT("wind"), Emitter.Update.Forces.Wind);
+		Writer.WriteObjectEnd();
+		Writer.WriteValue(TEXT("drag"), static_cast<double>(Emitter.Update.Drag));
+		Writer.WriteObjectStart(TEXT("collision"));
+		Writer.WriteValue(TEXT("enabled"), Emitter.Update.Collision.bEnabled);
+		Writer.WriteValue(TEXT("bounce"), static_cast<double>(Emitter.Update.Collision.Bounce));
+		Writer.WriteObjectEnd();
+		Writer.WriteObjectEnd();
+
+		Writer.WriteObjectStart(TEXT("render"));
+		Writer.WriteValue(TEXT("material"), Emitter.Render.Material);
+		Writer.WriteValue(TEXT("texture"), Emitter.Render.Texture);
+		Writer.WriteValue(TEXT("blendMode"), Emitter.Render.BlendMode);
+		Writer.WriteValue(TEXT("sort"), Emitter.Render.Sort);
+		Writer.WriteObjectStart(TEXT("mesh"));
+		Writer.WriteValue(TEXT("meshPath"), Emitter.Render.Mesh.MeshPath);
+		Writer.WriteValue(TEXT("meshType"), Emitter.Render.Mesh.MeshType);
+		Writer.WriteValue(TEXT("scale"), static_cast<double>(Emitter.Render.Mesh.Scale));
+		WriteXYZ(TEXT("rotation"), Emitter.Render.Mesh.Rotation);
+		Writer.WriteValue(TEXT("useMesh"), Emitter.Render.Mesh.bUseMesh);
+		Writer.WriteObjectEnd();
+		Writer.WriteObjectEnd();
+
+		Writer.WriteObjectEnd();
+	}
+
+	/** Same output and buffer handling as UVFXDSLParser::ToJSONWithFormat with EVFXDSLJsonFormat::Pretty */
+	inline bool ToJSONPretty(const FVFXDSL& DSL, int32 EstimatedLength, FString& OutJsonString)
+	{
+		OutJsonString.Reset(EstimatedLength);
+
+		FJsonStringAppendArchive Archive(OutJsonString);
+		TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Archive);
+
+		Writer->WriteObjectStart();
+
+		Writer->WriteObjectStart(TEXT("effect"));
+		Writer->WriteValue(TEXT("type"), DSL.Effect.Type == EVFXEffectType::Niagara ? TEXT("Niagara") : TEXT("Cascade"));
+		Writer->WriteValue(TEXT("duration"), static_cast<double>(DSL.Effect.Duration));
+		Writer->WriteValue(TEXT("looping"), DSL.Effect.bLooping);
+		Writer->WriteObjectEnd();
+
+		Writer->WriteArrayStart(TEXT("emitters"));
+		for (const FVFXDSLEmitter& Emitter : DSL.Emitters)
+		{
+			WriteEmitter(*Writer, Emitter);
+		}
+		Writer->WriteArrayEnd();
+
+		Writer->WriteObjectEnd();
+		return Writer->Close();
+	}
+
+	/** One emitter as condensed JSON, the input of ParseEmitter */
+	inline FString EmitterToJSON(const FVFXDSLEmitter& Emitter)
+	{
+		FString JsonString;
+		TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&JsonString);
+		WriteEmitter(*Writer, Emitter);
+		Writer->Close();
+		return JsonString;
+	}
+
+	/** The emitter comparison the codec replaced, extended to every field */
+	inline bool EmitterDiffers(const FVFXDSLEmitter& OldEmitter, const FVFXDSLEmitter& NewEmitter)
+	{
+		auto Differs = [](float OldValue, float NewValue, float Tolerance)
+		{
+			return FMath::Abs(OldValue - NewValue) > Tolerance;
+		};
+		auto VelocityDiffers = [&Differs](const FVFXDSLVelocity& OldVel, const FVFXDSLVelocity& NewVel)
+		{
+			return Differs(OldVel.X, NewVel.X, VFXDSLTolerance::Default)
+				|| Differs(OldVel.Y, NewVel.Y, VFXDSLTolerance::Default)
+				|| Differs(OldVel.Z, NewVel.Z, VFXDSLTolerance::Default);
+		};
+		auto ArrayDiffers = [&Differs](const TArray<float>& OldArray, const TArray<float>& NewArray)
+		{
+			if (OldArray.Num() != NewArray.Num())
+			{
+				return true;
+			}
+			for (int32 Index = 0; Index < OldArray.Num(); ++Index)
+			{
+				if (Differs(OldArray[Index], NewArray[Index], VFXDSLTolerance::Default))
+				{
+					return true;
+				}
+			}
+			return false;
+		};
+
+		const FVFXDSLSpawners& OldSpawners = OldEmitter.Spawners;
+		const FVFXDSLSpawners& NewSpawners = NewEmitter.Spawners;
+		const FVFXDSLInitialization& OldInit = OldEmitter.Initialization;
+		const FVFXDSLInitialization& NewInit = NewEmitter.Initialization;
+		const FVFXDSLUpdate& OldUpdate = OldEmitter.Update;
+		const FVFXDSLUpdate& NewUpdate = NewEmitter.Update;
+		const FVFXDSLMesh& OldMesh = OldEmitter.Render.Mesh;
+		const FVFXDSLMesh& NewMesh = NewEmitter.Render.Mesh;
+
+		return Differs((float)OldSpawners.Burst.Count, (float)NewSpawners.Burst.Count, VFXDSLTolerance::Count)
+			|| Differs(OldSpawners.Burst.Time, NewSpawners.Burst.Time, VFXDSLTolerance::Default)
+			|| ArrayDiffers(OldSpawners.Burst.Intervals, NewSpawners.Burst.Intervals)
+			|| Differs(OldSpawners.Rate.SpawnRate, NewSpawners.Rate.SpawnRate, VFXDSLTolerance::Default)
+			|| Differs(OldSpawners.Rate.ScaleOverTime, NewSpawners.Rate.ScaleOverTime, VFXDSLTolerance::Default)
+			|| Differs(OldInit.Color.R, NewInit.Color.R, VFXDSLTolerance::Color)
+			|| Differs(OldInit.Color.G, NewInit.Color.G, VFXDSLTolerance::Color)
+			|| Differs(OldInit.Color.B, NewInit.Color.B, VFXDSLTolerance::Color)
+			|| Differs(OldInit.Color.A, NewInit.Color.A, VFXDSLTolerance::Color)
+			|| Differs(OldInit.Size.Min, NewInit.Size.Min, VFXDSLTolerance::Default)
+			|| Differs(OldInit.Size.Max, NewInit.Size.Max, VFXDSLTolerance::Default)
+			|| VelocityDiffers(OldInit.Velocity, NewInit.Velocity)
+			|| Differs(OldUpdate.Forces.Gravity, NewUpdate.Forces.Gravity, VFXDSLTolerance::Default)
+			|| VelocityDiffers(OldUpdate.Forces.Wind, NewUpdate.Forces.Wind)
+			|| Differs(OldUpdate.Drag, NewUpdate.Drag, VFXDSLTolerance::Default)
+			|| OldUpdate.Collision.bEnabled != NewUpdate.Collision.bEnabled
+			|| Differs(OldUpdate.Collision.Bounce, NewUpdate.Collision.Bounce, VFXDSLTolerance::Default)
+			|| Differs(OldMesh.Scale, NewMesh.Scale, VFXDSLTolerance::Default)
+			|| VelocityDiffers(OldMesh.Rotation, NewMesh.Rotation)
+			|| OldMesh.bUseMesh != NewMesh.bUseMesh
+			|| OldEmitter.Name != NewEmitter.Name
+			|| OldEmitter.Render.Material != NewEmitter.Render.Material
+			|| OldEmitter.Render.Texture != NewEmitter.Render.Texture
+			|| OldEmitter.Render.BlendMode != NewEmitter.Render.BlendMode
+			|| OldEmitter.Render.Sort != NewEmitter.Render.Sort
+			|| OldMesh.MeshPath != NewMesh.MeshPath
+			|| OldMesh.MeshType != NewMesh.MeshType;
+	}
+
+	/** The emitter range checks of UVFXDSLValidator the codec replaced, reporting the same errors as FVFXDSLCodec::ValidateRanges */
+	inline void ValidateEmitterRanges(const FVFXDSLEmitter& Emitter, int32 EmitterIndex, FVFXDSLValidationResult& Result)
+	{
+		const FVFXDSLSpawners& Spawners = Emitter.Spawners;
+		if (Spawners.Burst.Count < 0)
+		{
+			Result.AddError(FVFXDSLValidationError(EVFXDSLValidationCode::NegativeBurstCount, EmitterIndex, EVFXDSLFieldId::SpawnersBurstCount, Spawners.Burst.Count));
+		}
+		if (Spawners.Rate.SpawnRate < 0.0f)
+		{
+			Result.AddError(FVFXDSLValidationError(EVFXDSLValidationCode::NegativeSpawnRate, EmitterIndex, EVFXDSLFieldId::SpawnersRateSpawnRate, Spawners.Rate.SpawnRate));
+		}
+
+		const FVFXDSLColor& Color = Emitter.Initialization.Color;
+		if (Color.R < 0.0f || Color.R > 1.0f)
+		{
+			Result.AddError(FVFXDSLValidationError(EVFXDSLValidationCode::ColorOutOfRange, EmitterIndex, EVFXDSLFieldId::InitializationColorR, Color.R));
+		}
+		if (Color.G < 0.0f || Color.G > 1.0f)
+		{
+			Result.AddError(FVFXDSLValidationError(EVFXDSLValidationCode::ColorOutOfRange, EmitterIndex, EVFXDSLFieldId::InitializationColorG, Color.G));
+		}
+		if (Color.B < 0.0f || Color.B > 1.0f)
+		{
+			Result.AddError(FVFXDSLValidationError(EVFXDSLValidationCode::ColorOutOfRange, EmitterIndex, EVFXDSLFieldId::InitializationColorB, Color.B));
+		}
+		if (Color.A < 0.0f || Color.A > 1.0f)
+		{
+			Result.AddError(FVFXDSLValidationError(EVFXDSLValidationCode::ColorOutOfRange, EmitterIndex, EVFXDSLFieldId::InitializationColorA, Color.A));
+		}
+
+		const FVFXDSLSize& Size = Emitter.Initialization.Size;
+		if (Size.Min < 0.0f)
+		{
+			Result.AddError(FVFXDSLValidationError(EVFXDSLValidationCode::NegativeSize, EmitterIndex, EVFXDSLFieldId::InitializationSizeMin, Size.Min));
+		}
+		if (Size.Max < 0.0f)
+		{
+			Result.AddError(FVFXDSLValidationError(EVFXDSLValidationCode::NegativeSize, EmitterIndex, EVFXDSLFieldId::InitializationSizeMax, Size.Max));
+		}
+
+		if (Emitter.Update.Collision.bEnabled && (Emitter.Update.Collision.Bounce < 0.0f || Emitter.Update.Collision.Bounce > 1.0f))
+		{
+			Result.AddError(FVFXDSLValidationError(EVFXDSLValidationCode::BounceOutOfRange, EmitterIndex, EVFXDSLFieldId::UpdateCollisionBounce, Emitter.Update.Collision.Bounce));
+		}
+	}
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
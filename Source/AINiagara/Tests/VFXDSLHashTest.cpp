@@ -0,0 +1,140 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/VFXDSLHash.h"
+#include "Core/VFXDSLBinaryFormat.h"
+#include "Core/VFXDSLDiff.h"
+#include "Core/VFXDSLParser.h"
+#include "Core/VFXDSL.h"
+#include "VFXDSLTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLHashRoundTripTest,
+	"AINiagara.VFXDSLHash.RoundTripStability",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLHashRoundTripTest::RunTest(const FString& Parameters)
+{
+	for (int32 Seed = 0; Seed < 16; ++Seed)
+	{
+		const FVFXDSL Original = VFXDSLTestHelpers::MakeDSL(1 + Seed % 6, Seed);
+		const uint64 OriginalHash = FVFXDSLHash::Hash(Original);
+		FString Error;
+
+		for (EVFXDSLJsonFormat Format : { EVFXDSLJsonFormat::Pretty, EVFXDSLJsonFormat::Condensed })
+		{
+			FString Json;
+			UVFXDSLParser::ToJSONWithFormat(Original, Format, Json);
+
+			FVFXDSL Parsed;
+			TestTrue(TEXT("Serialized DSL should parse"), UVFXDSLParser::ParseFromJSON(Json, Parsed, Error));
+			TestEqual(FString::Printf(TEXT("Seed %d: hash survives a JSON round trip (format %d)"), Seed, static_cast<int32>(Format)),
+				FVFXDSLHash::Hash(Parsed), OriginalHash);
+		}
+
+		TArray<uint8> Bytes;
+		FVFXDSLBinaryWriter::SaveToBytes(MakeArrayView(&Original, 1), Bytes);
+		FVFXDSLBinaryReader Reader;
+		FVFXDSL Decoded;
+		Reader.OpenBytes(Bytes, Error);
+		Reader.Next(Decoded);
+		TestEqual(FString::Printf(TEXT("Seed %d: hash survives a binary round trip"), Seed), FVFXDSLHash::Hash(Decoded), OriginalHash);
+	}
+
+	// Key order and layout do not matter
+	const FString OrderA = TEXT(R"({"effect":{"type":"Niagara","duration":2.5,"looping":true},"emitters":[{"name":"A","spawners":{"rate":{"spawnRate":30}},"render":{"blendMode":"Additive"}}]})");
+	const FString OrderB = TEXT(R"({ "emitters": [ { "render": { "blendMode": "Additive" }, "spawners": { "rate": { "spawnRate": 30.0 } }, "name": "A" } ],
+		"effect": { "looping": true, "duration": 2.5, "type": "Niagara" } })");
+
+	FVFXDSL DSLA;
+	FVFXDSL DSLB;
+	FString Error;
+	UVFXDSLParser::ParseFromJSON(OrderA, DSLA, Error);
+	UVFXDSLParser::ParseFromJSON(OrderB, DSLB, Error);
+	TestEqual(TEXT("JSON key order does not affect the hash"), FVFXDSLHash::Hash(DSLA), FVFXDSLHash::Hash(DSLB));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLHashSensitivityTest,
+	"AINiagara.VFXDSLHash.Sensitivity",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLHashSensitivityTest::RunTest(const FString& Parameters)
+{
+	const FVFXDSL Base = VFXDSLTestHelpers::MakeNamedDSL({ TEXT("Core"), TEXT("Sparks"), TEXT("Smoke") });
+	const uint64 BaseHash = FVFXDSLHash::Hash(Base);
+	TestNotEqual(TEXT("Hash is never zero"), BaseHash, static_cast<uint64>(0));
+
+	FVFXDSL Edited = Base;
+	Edited.Emitters[1].Initialization.Color.G = FMath::Fmod(Edited.Emitters[1].Initialization.Color.G + 0.25f, 1.0f);
+	TestNotEqual(TEXT("Color edits change the hash"), FVFXDSLHash::Hash(Edited), BaseHash);
+
+	Edited = Base;
+	Edited.Emitters[2].Spawners.Rate.SpawnRate += 5.0f;
+	TestNotEqual(TEXT("Spawn rate edits change the hash"), FVFXDSLHash::Hash(Edited), BaseHash);
+
+	Edited = Base;
+	Edited.Emitters[0].Render.Mesh.bUseMesh = !Edited.Emitters[0].Render.Mesh.bUseMesh;
+	TestNotEqual(TEXT("Mesh settings are hashed"), FVFXDSLHash::Hash(Edited), BaseHash);
+
+	Edited = Base;
+	Edited.Emitters.Swap(0, 2);
+	TestNotEqual(TEXT("Emitter order is significant"), FVFXDSLHash::Hash(Edited), BaseHash);
+
+	Edited = Base;
+	Edited.Emitters[0].Spawners.Rate.SpawnRate = 40.0f;
+	const uint64 QuantizedHash = FVFXDSLHash::Hash(Edited);
+	Edited.Emitters[0].Spawners.Rate.SpawnRate = 40.0001f;
+	TestEqual(TEXT("Noise below the diff tolerance is ignored"), FVFXDSLHash::Hash(Edited), QuantizedHash);
+
+	FVFXDSL Moved = Base;
+	Moved.Emitters.Swap(0, 1);
+	TestEqual(TEXT("Emitter hashes ignore position"), FVFXDSLHash::HashEmitter(Moved.Emitters[0]), FVFXDSLHash::HashEmitter(Base.Emitters[1]));
+	TestEqual(TEXT("Hex form is fixed width"), FVFXDSLHash::ToString(BaseHash).Len(), 16);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLHashBenchmarkTest,
+	"AINiagara.VFXDSLHash.Benchmark.HashVsCompare",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter
+)
+
+bool FVFXDSLHashBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const int32 Iterations = 1000;
+	const FVFXDSL Current = VFXDSLTestHelpers::MakeDSL(20, 1);
+	const FVFXDSL Incoming = VFXDSLTestHelpers::MakeDSL(20, 1);
+
+	double StartTime = FPlatformTime::Seconds();
+	int32 NumChanged = 0;
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		NumChanged += UVFXDSLDiff::Compare(Current, Incoming).bHasChanges ? 1 : 0;
+	}
+	const double CompareMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	const uint64 CurrentHash = FVFXDSLHash::Hash(Current);
+	StartTime = FPlatformTime::Seconds();
+	int32 NumHashChanged = 0;
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		NumHashChanged += FVFXDSLHash::Hash(Incoming) != CurrentHash ? 1 : 0;
+	}
+	const double HashMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	TestEqual(TEXT("Both detect no change"), NumHashChanged, NumChanged);
+	AddInfo(FString::Printf(TEXT("%d checks of a 20-emitter DSL: Compare %.3f ms, Hash %.3f ms (%.2f us per frame)"),
+		Iterations, CompareMs, HashMs, HashMs * 1000.0 / Iterations));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,262 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/VFXDSLIncrementalParser.h"
+#include "Core/VFXDSLParser.h"
+#include "Core/VFXDSL.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Recorded Gemini reply: prose, a fenced JSON block and a closing remark */
+	const TCHAR* RecordedFencedReply = TEXT(R"(Here is a campfire effect with embers and smoke:
+
+```json
+{
+  "effect": { "type": "Niagara", "duration": 4.0, "looping": true },
+  "emitters": [
+    {
+      "name": "Flames",
+      "spawners": { "rate": { "spawnRate": 80.0 } },
+      "initialization": { "color": { "r": 1.0, "g": 0.45, "b": 0.05, "a": 1.0 }, "size": { "min": 8.0, "max": 16.0 } },
+      "render": { "blendMode": "Additive", "material": "/Game/FX/M_Flame" }
+    },
+    {
+      "name": "Embers {hot}",
+      "spawners": { "burst": { "count": 25, "time": 0.0, "intervals": [0.5, 1.0] } },
+      "update": { "forces": { "gravity": 50.0, "wind": { "x": 10.0 } }, "drag": 0.1 },
+      "render": { "blendMode": "Additive" }
+    },
+    {
+      "name": "Smoke \"soft\"",
+      "initialization": { "color": { "r": 0.2, "g": 0.2, "b": 0.2, "a": 0.4 } },
+      "render": { "blendMode": "Translucent" }
+    }
+  ]
+}
+```
+
+Let me know if you want the smoke to be denser.)");
+
+	/** Recorded reply with non-ASCII emitter names, used for byte-level feeding */
+	const TCHAR* RecordedUnicodeReply = TEXT(R"({"effect":{"type":"Niagara","duration":2.0},"emitters":[{"name":"Étincelles ✨"},{"name":"火花"}]})");
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLIncrementalParserCharacterFeedTest,
+	"AINiagara.VFXDSLIncrementalParser.CharacterFeed",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLIncrementalParserCharacterFeedTest::RunTest(const FString& Parameters)
+{
+	const FString Reply(RecordedFencedReply);
+
+	FVFXDSLIncrementalParser Parser;
+	TArray<int32> Indices;
+	TArray<FString> Names;
+	TArray<int32> ReceivedAtOffset;
+	int32 Offset = 0;
+	bool bEffectParsed = false;
+
+	Parser.OnEffectParsed.BindLambda([&bEffectParsed](const FVFXDSLEffect& Effect)
+	{
+		bEffectParsed = Effect.bLooping && FMath::IsNearlyEqual(Effect.Duration, 4.0f);
+	});
+	Parser.OnEmitterParsed.BindLambda([&](int32 EmitterIndex, const FVFXDSLEmitter& Emitter)
+	{
+		Indices.Add(EmitterIndex);
+		Names.Add(Emitter.Name);
+		ReceivedAtOffset.Add(Offset);
+	});
+
+	for (Offset = 0; Offset < Reply.Len(); ++Offset)
+	{
+		Parser.AppendChunk(FStringView(&Reply[Offset], 1));
+	}
+
+	TestTrue(TEXT("Effect should be reported"), bEffectParsed);
+	TestEqual(TEXT("All emitters should be reported"), Names.Num(), 3);
+	if (Names.Num() == 3)
+	{
+		for (int32 Index = 0; Index < Indices.Num(); ++Index)
+		{
+			TestEqual(TEXT("Emitters are reported in document order"), Indices[Index], Index);
+		}
+		TestEqual(TEXT("First emitter"), Names[0], FString(TEXT("Flames")));
+		TestEqual(TEXT("Braces inside strings are ignored"), Names[1], FString(TEXT("Embers {hot}")));
+		TestEqual(TEXT("Escaped quotes are handled"), Names[2], FString(TEXT("Smoke \"soft\"")));
+
+		// Each emitter must be available before the rest of the document has arrived
+		const int32 EmittersEnd = Reply.Find(TEXT("]"), ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+		TestTrue(TEXT("First emitter reported before the second was transmitted"), ReceivedAtOffset[0] < Reply.Find(TEXT("Embers")));
+		TestTrue(TEXT("Last emitter reported before the array closed"), ReceivedAtOffset[2] < EmittersEnd);
+	}
+
+	TestTrue(TEXT("Root object should be complete"), Parser.IsComplete());
+
+	FVFXDSL IncrementalDSL;
+	FString Error;
+	TestTrue(TEXT("Finish should parse the fenced document"), Parser.Finish(IncrementalDSL, Error));
+
+	FVFXDSL ReferenceDSL;
+	UVFXDSLParser::ParseFromJSON(FString(Parser.GetJsonText()), ReferenceDSL, Error);
+	FString IncrementalJSON;
+	FString ReferenceJSON;
+	UVFXDSLParser::ToJSON(IncrementalDSL, IncrementalJSON);
+	UVFXDSLParser::ToJSON(ReferenceDSL, ReferenceJSON);
+	TestEqual(TEXT("Final DSL should match a one-shot parse"), IncrementalJSON, ReferenceJSON);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLIncrementalParserByteFeedTest,
+	"AINiagara.VFXDSLIncrementalParser.ByteFeed",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLIncrementalParserByteFeedTest::RunTest(const FString& Parameters)
+{
+	FTCHARToUTF8 Utf8(RecordedUnicodeReply);
+	TConstArrayView<uint8> Bytes(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+
+	FVFXDSLIncrementalParser Parser;
+	TArray<FString> Names;
+	Parser.OnEmitterParsed.BindLambda([&Names](int32 EmitterIndex, const FVFXDSLEmitter& Emitter)
+	{
+		Names.Add(Emitter.Name);
+	});
+
+	// Multi-byte characters are split across calls
+	for (int32 Index = 0; Index < Bytes.Num(); ++Index)
+	{
+		Parser.AppendUTF8(Bytes.Slice(Index, 1));
+	}
+
+	TestEqual(TEXT("Both emitters should be reported"), Names.Num(), 2);
+	if (Names.Num() == 2)
+	{
+		TestTrue(TEXT("Accented name decoded"), Names[0].Equals(TEXT("Étincelles ✨"), ESearchCase::CaseSensitive));
+		TestTrue(TEXT("CJK name decoded"), Names[1].Equals(TEXT("火花"), ESearchCase::CaseSensitive));
+	}
+
+	FVFXDSL DSL;
+	FString Error;
+	TestTrue(TEXT("Finish should succeed"), Parser.Finish(DSL, Error));
+	TestEqual(TEXT("Final emitter count"), DSL.Emitters.Num(), 2);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLIncrementalParserIncompleteTest,
+	"AINiagara.VFXDSLIncrementalParser.Incomplete",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLIncrementalParserIncompleteTest::RunTest(const FString& Parameters)
+{
+	const FString Reply(RecordedFencedReply);
+	const int32 Cut = Reply.Find(TEXT("\"name\": \"Smoke"));
+
+	FVFXDSLIncrementalParser Parser;
+	int32 NumParsed = 0;
+	Parser.OnEmitterParsed.BindLambda([&NumParsed](int32, const FVFXDSLEmitter&)
+	{
+		++NumParsed;
+	});
+
+	// Truncated mid-emitter: finished emitters are reported, the document is not complete
+	Parser.AppendChunk(FStringView(Reply).Left(Cut));
+	TestEqual(TEXT("Two emitters complete before the cut"), NumParsed, 2);
+	TestFalse(TEXT("Root object should not be complete"), Parser.IsComplete());
+
+	FVFXDSL DSL;
+	FString Error;
+	TestFalse(TEXT("Finish should fail on a truncated document"), Parser.Finish(DSL, Error));
+	TestEqual(TEXT("Error matches the one-shot parser"), Error, FString(TEXT("Failed to parse JSON string")));
+
+	// Reset and parse prose with no JSON at all
+	Parser.Reset();
+	Parser.AppendChunk(TEXT("I could not generate an effect for that request."));
+	TestFalse(TEXT("No JSON should be detected"), Parser.HasStarted());
+	TestFalse(TEXT("Finish should fail without JSON"), Parser.Finish(DSL, Error));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLIncrementalParserProseBracesTest,
+	"AINiagara.VFXDSLIncrementalParser.ProseBraces",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLIncrementalParserProseBracesTest::RunTest(const FString& Parameters)
+{
+	// Unfenced reply whose prose uses braces before the DSL
+	const FString Reply(TEXT(R"(Use {curly} braces for placeholders, or { leave them out }. Here it is: {"effect": {"duration": 2.0}, "emitters": [{"name": "Core"}]})"));
+
+	FVFXDSLIncrementalParser Parser;
+	TArray<FString> Names;
+	Parser.OnEmitterParsed.BindLambda([&Names](int32, const FVFXDSLEmitter& Emitter)
+	{
+		Names.Add(Emitter.Name);
+	});
+
+	for (int32 Offset = 0; Offset < Reply.Len(); ++Offset)
+	{
+		Parser.AppendChunk(FStringView(&Reply[Offset], 1));
+		if (Reply[Offset] == TEXT('{') && Offset < Reply.Find(TEXT("{\"effect\"")))
+		{
+			TestFalse(FString::Printf(TEXT("Prose brace at %d should not start the DSL"), Offset), Parser.HasStarted());
+		}
+	}
+
+	TestTrue(TEXT("DSL should be detected after the prose"), Parser.GetJsonText().StartsWith(TEXT("{\"effect\"")));
+	TestEqual(TEXT("Emitter should be reported"), Names.Num(), 1);
+
+	FVFXDSL DSL;
+	FString Error;
+	TestTrue(TEXT("Finish should parse the DSL"), Parser.Finish(DSL, Error));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLIncrementalParserReentrancyTest,
+	"AINiagara.VFXDSLIncrementalParser.AppendFromDelegate",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLIncrementalParserReentrancyTest::RunTest(const FString& Parameters)
+{
+	const FString Reply(RecordedFencedReply);
+	const int32 Cut = Reply.Find(TEXT("\"name\": \"Embers"));
+
+	// The first emitter's delegate appends the rest of the reply while the parser is still scanning
+	FVFXDSLIncrementalParser Parser;
+	TArray<int32> Indices;
+	Parser.OnEmitterParsed.BindLambda([&Parser, &Indices, &Reply, Cut](int32 EmitterIndex, const FVFXDSLEmitter&)
+	{
+		Indices.Add(EmitterIndex);
+		if (Indices.Num() == 1)
+		{
+			Parser.AppendChunk(FStringView(Reply).Mid(Cut));
+		}
+	});
+
+	Parser.AppendChunk(FStringView(Reply).Left(Cut));
+
+	TestEqual(TEXT("Every emitter is reported once"), Indices.Num(), 3);
+	for (int32 Index = 0; Index < Indices.Num(); ++Index)
+	{
+		TestEqual(FString::Printf(TEXT("Emitter %d index"), Index), Indices[Index], Index);
+	}
+	TestTrue(TEXT("Root object should be complete"), Parser.IsComplete());
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
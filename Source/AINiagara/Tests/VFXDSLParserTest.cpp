@@ -3,6 +3,8 @@
 #include "Misc/AutomationTest.h"
 #include "Core/VFXDSLParser.h"
 #include "Core/VFXDSL.h"
+#include "Core/VFXDSLStreamParser.h"
+#include "VFXDSLTestHelpers.h"
 
 #if WITH_DEV_AUTOMATION_TESTS
 
@@ -418,5 +420,218 @@ bool FVFXDSLParserSpecialCharactersTest::RunTest(const FString& Parameters)
 	return true;
 }
 
-#endif // WITH_DEV_AUTOMATION_TESTS
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLParserStreamParityTest,
+	"AINiagara.VFXDSLParser.StreamParity",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLParserStreamParityTest::RunTest(const FString& Parameters)
+{
+	// Each input must produce the same success flag, error text and DSL on both paths
+	TArray<FString> Inputs;
+	Inputs.Add(VFXDSLTestHelpers::MakeDSLJson(3));
+	Inputs.Add(TEXT(R"({"effect":{"type":"cascade","duration":"2.5","looping":1},"emitters":[{"name":"Mesh","unknown":{"nested":[1,2,{"x":3}]},
+		"spawners":{"burst":{"count":7.9,"intervals":[0.1,"0.2",true,null,{"x":1}]}},
+		"render":{"blendMode":"Additive","mesh":{"meshPath":"/Game/Rock","meshType":"Custom","scale":2,"rotation":{"x":90},"useMesh":true}}}]})"));
+	Inputs.Add(TEXT(R"({"EFFECT":{"Duration":3},"Emitters":[{"Name":"CaseInsensitive"}]})"));
+	Inputs.Add(TEXT(R"({"effect":{"duration":1},"emitters":[{"name":"Last"}],"emitters":[{"name":"Wins"}]})"));
+	Inputs.Add(TEXT(""));
+	Inputs.Add(TEXT("not json"));
+	Inputs.Add(TEXT("[]"));
+	Inputs.Add(TEXT(R"({"emitters":[{}]})"));
+	Inputs.Add(TEXT(R"({"effect":5,"emitters":[{}]})"));
+	Inputs.Add(TEXT(R"({"effect":{}})"));
+	Inputs.Add(TEXT(R"({"effect":{},"emitters":{}})"));
+	Inputs.Add(TEXT(R"({"effect":{},"emitters":[]})"));
+	Inputs.Add(TEXT(R"({"effect":{},"emitters":[{},{},3,{}]})"));
+	Inputs.Add(TEXT(R"({"effect":{},"emitters":[{"name":"Unterminated"}])"));
+	Inputs.Add(TEXT(R"({"emitters":[{}],"effect":{}} trailing)"));
+
+	for (int32 Index = 0; Index < Inputs.Num(); ++Index)
+	{
+		FVFXDSL DomDSL;
+		FVFXDSL StreamDSL;
+		FString DomError;
+		FString StreamError;
+		const bool bDomSuccess = UVFXDSLParser::ParseFromJSONDOM(Inputs[Index], DomDSL, DomError);
+		const bool bStreamSuccess = FVFXDSLStreamParser::Parse(Inputs[Index], StreamDSL, StreamError);
+
+		TestEqual(FString::Printf(TEXT("Input %d: success flag should match"), Index), bStreamSuccess, bDomSuccess);
+		TestEqual(FString::Printf(TEXT("Input %d: error should match"), Index), StreamError, DomError);
+
+		if (bDomSuccess && bStreamSuccess)
+		{
+			FString DomJson;
+			FString StreamJson;
+			UVFXDSLParser::ToJSON(DomDSL, DomJson);
+			UVFXDSLParser::ToJSON(StreamDSL, StreamJson);
+			TestEqual(FString::Printf(TEXT("Input %d: parsed DSL should match"), Index), StreamJson, DomJson);
+
+			for (int32 EmitterIndex = 0; EmitterIndex < DomDSL.Emitters.Num(); ++EmitterIndex)
+			{
+				const FVFXDSLMesh& DomMesh = DomDSL.Emitters[EmitterIndex].Render.Mesh;
+				const FVFXDSLMesh& StreamMesh = StreamDSL.Emitters[EmitterIndex].Render.Mesh;
+				TestEqual(TEXT("Mesh path should match"), StreamMesh.MeshPath, DomMesh.MeshPath);
+				TestEqual(TEXT("Mesh scale should match"), StreamMesh.Scale, DomMesh.Scale);
+				TestEqual(TEXT("Mesh rotation should match"), StreamMesh.Rotation.X, DomMesh.Rotation.X);
+				TestEqual(TEXT("Mesh usage should match"), StreamMesh.bUseMesh, DomMesh.bUseMesh);
+			}
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLParserStreamBenchmarkTest,
+	"AINiagara.VFXDSLParser.Benchmark.StreamVsDOM",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter
+)
+
+bool FVFXDSLParserStreamBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const int32 EmitterCounts[] = { 1, 50, 1000 };
+
+	for (int32 NumEmitters : EmitterCounts)
+	{
+		const FString Json = VFXDSLTestHelpers::MakeDSLJson(NumEmitters);
+		const int32 Iterations = FMath::Max(5, 2000 / NumEmitters);
+
+		FVFXDSL DSL;
+		FString Error;
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			UVFXDSLParser::ParseFromJSONDOM(Json, DSL, Error);
+		}
+		const double DomMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+
+		bool bStreamSuccess = true;
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			bStreamSuccess &= FVFXDSLStreamParser::Parse(Json, DSL, Error);
+		}
+		const double StreamMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+
+		TestTrue(FString::Printf(TEXT("%d emitters: stream parse should succeed"), NumEmitters), bStreamSuccess);
+		TestEqual(FString::Printf(TEXT("%d emitters: emitter count"), NumEmitters), DSL.Emitters.Num(), NumEmitters);
+
+		AddInfo(FString::Printf(TEXT("%4d emitters (%d bytes): DOM %.3f ms, stream %.3f ms, speedup %.2fx"),
+			NumEmitters, Json.Len(), DomMs, StreamMs, StreamMs > 0.0 ? DomMs / StreamMs : 0.0));
+	}
+
+	return true;
+}
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLParserStreamWriterTest,
+	"AINiagara.VFXDSLParser.StreamWriter",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLParserStreamWriterTest::RunTest(const FString& Parameters)
+{
+	TArray<FVFXDSL> Samples;
+	Samples.Add(FVFXDSL());
+	Samples.Add(VFXDSLTestHelpers::MakeDSL(1));
+	Samples.Add(VFXDSLTestHelpers::MakeDSL(25, 7));
+
+	FVFXDSL SpecialDSL = VFXDSLTestHelpers::MakeDSL(1);
+	SpecialDSL.Effect.Type = EVFXEffectType::Cascade;
+	SpecialDSL.Emitters[0].Name = TEXT("Quote \" Backslash \\ Tab \t Unicode é");
+	SpecialDSL.Emitters[0].Spawners.Burst.Intervals.Empty();
+	Samples.Add(SpecialDSL);
+
+	FString ReusedBuffer;
+	for (int32 Index = 0; Index < Samples.Num(); ++Index)
+	{
+		FString DomJson;
+		UVFXDSLParser::ToJSONDOM(Samples[Index], DomJson);
+
+		// The DOM baseline moved with the reflection-driven codec: emitters now carry render.mesh
+		if (Samples[Index].Emitters.Num() > 0)
+		{
+			TestTrue(FString::Printf(TEXT("Sample %d: DOM baseline should include render.mesh"), Index), DomJson.Contains(TEXT("\"mesh\"")));
+		}
+
+		TestTrue(TEXT("Pretty serialization should succeed"), UVFXDSLParser::ToJSONWithFormat(Samples[Index], EVFXDSLJsonFormat::Pretty, ReusedBuffer));
+		TestTrue(FString::Printf(TEXT("Sample %d: pretty output should be byte-identical to the DOM writer"), Index), ReusedBuffer.Equals(DomJson, ESearchCase::CaseSensitive));
+
+		FString LegacyEntryPoint;
+		UVFXDSLParser::ToJSON(Samples[Index], LegacyEntryPoint);
+		TestTrue(FString::Printf(TEXT("Sample %d: ToJSON should keep the pretty layout"), Index), LegacyEntryPoint.Equals(DomJson, ESearchCase::CaseSensitive));
+
+		FString Condensed;
+		TestTrue(TEXT("Condensed serialization should succeed"), UVFXDSLParser::ToJSONWithFormat(Samples[Index], EVFXDSLJsonFormat::Condensed, Condensed));
+		TestTrue(TEXT("Condensed output should be smaller"), Condensed.Len() < DomJson.Len());
+		TestFalse(TEXT("Condensed output should not contain line breaks"), Condensed.Contains(TEXT("\n")));
+
+		// Condensed output must describe the same DSL (re-serialize pretty to compare)
+		if (Samples[Index].Emitters.Num() > 0)
+		{
+			FVFXDSL Reparsed;
+			FString Error;
+			TestTrue(TEXT("Condensed output should parse"), UVFXDSLParser::ParseFromJSON(Condensed, Reparsed, Error));
+			FString ReparsedJson;
+			UVFXDSLParser::ToJSON(Reparsed, ReparsedJson);
+			TestTrue(TEXT("Condensed output should round trip"), ReparsedJson.Equals(DomJson, ESearchCase::CaseSensitive));
+		}
+
+		TArray<uint8> Utf8Bytes;
+		TestTrue(TEXT("UTF-8 serialization should succeed"), UVFXDSLParser::ToJSONUTF8(Samples[Index], EVFXDSLJsonFormat::Pretty, Utf8Bytes));
+		FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Utf8Bytes.GetData()), Utf8Bytes.Num());
+		TestTrue(TEXT("UTF-8 output should decode to the pretty string"), FString(Converted.Length(), Converted.Get()).Equals(DomJson, ESearchCase::CaseSensitive));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLParserStreamWriterBenchmarkTest,
+	"AINiagara.VFXDSLParser.Benchmark.WriterVsDOM",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter
+)
+
+bool FVFXDSLParserStreamWriterBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const int32 EmitterCounts[] = { 1, 50, 1000 };
+
+	for (int32 NumEmitters : EmitterCounts)
+	{
+		const FVFXDSL DSL = VFXDSLTestHelpers::MakeDSL(NumEmitters);
+		const int32 Iterations = FMath::Max(5, 2000 / NumEmitters);
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			FString Json;
+			UVFXDSLParser::ToJSONDOM(DSL, Json);
+		}
+		const double DomMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+
+		FString Buffer;
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			UVFXDSLParser::ToJSONWithFormat(DSL, EVFXDSLJsonFormat::Pretty, Buffer);
+		}
+		const double PrettyMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			UVFXDSLParser::ToJSONWithFormat(DSL, EVFXDSLJsonFormat::Condensed, Buffer);
+		}
+		const double CondensedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+
+		AddInfo(FString::Printf(TEXT("%4d emitters: DOM %.3f ms, stream pretty %.3f ms, stream condensed %.3f ms (%d chars)"),
+			NumEmitters, DomMs, PrettyMs, CondensedMs, Buffer.Len()));
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,251 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/VFXDSLPatch.h"
+#include "Core/VFXDSLDiff.h"
+#include "Core/VFXDSLHash.h"
+#include "Core/VFXDSLParser.h"
+#include "Core/VFXResponseDispatcher.h"
+#include "Core/VFXDSL.h"
+#include "VFXDSLTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Effect the recorded refinements below apply to */
+	const TCHAR* RecordedBaseDSL = TEXT(R"({
+  "effect": { "type": "Niagara", "duration": 3.0, "looping": true },
+  "emitters": [
+    { "name": "Core", "spawners": { "rate": { "spawnRate": 40 } }, "initialization": { "color": { "r": 0.6, "g": 0.5, "b": 0.4, "a": 1.0 } }, "render": { "blendMode": "Additive" } },
+    { "name": "Sparks", "spawners": { "burst": { "count": 30, "time": 0.0 } }, "initialization": { "size": { "min": 0.5, "max": 1.0 } } },
+    { "name": "Smoke", "spawners": { "rate": { "spawnRate": 8 } }, "update": { "drag": 0.4 } }
+  ]
+})");
+
+	/** Recorded reply to "make it redder" */
+	const TCHAR* RecordedRedderReply = TEXT(R"(Sure, pushing the core towards red:
+```json
+{"patch": [{"op": "set", "path": "Emitters[0].Initialization.Color", "value": {"r": 1.0, "g": 0.2, "b": 0.1}}]}
+```)");
+
+	/** Recorded reply to "more sparks, drop the smoke and make it last longer" */
+	const TCHAR* RecordedStructuralReply = TEXT(R"({"patch": [
+  {"op": "set", "path": "emitters[Sparks].spawners.burst.count", "value": 120},
+  {"op": "remove", "path": "Emitters[Smoke]"},
+  {"op": "add", "path": "Emitters[-]", "value": {"name": "Embers", "spawners": {"rate": {"spawnRate": 15}}, "render": {"blendMode": "Additive"}}},
+  {"op": "move", "from": "Emitters[2]", "path": "Emitters[0]"},
+  {"op": "set", "path": "Effect.Duration", "value": 5.5}
+]})");
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLPatchRecordedRepliesTest,
+	"AINiagara.VFXDSLPatch.RecordedReplies",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLPatchRecordedRepliesTest::RunTest(const FString& Parameters)
+{
+	FVFXDSL Base;
+	FString Error;
+	TestTrue(TEXT("Base DSL should parse"), UVFXDSLParser::ParseFromJSON(RecordedBaseDSL, Base, Error));
+
+	// Field group edit, fenced behind prose
+	FVFXClassifiedResponse Classified;
+	FVFXResponseDispatcher::Classify(RecordedRedderReply, Classified);
+	TestEqual(TEXT("Reply should be a patch"), FString(FVFXResponseDispatcher::GetKindName(Classified.Kind)), FString(TEXT("Patch")));
+	TestEqual(TEXT("One op"), Classified.Patch.Ops.Num(), 1);
+	const int32 RedderPatchLength = Classified.JsonLength;
+
+	FVFXDSL Redder = Base;
+	TestTrue(TEXT("Redder patch should apply"), FVFXDSLPatch::ApplyPatch(Redder, Classified.Patch, Error));
+	TestEqual(TEXT("Red raised"), Redder.Emitters[0].Initialization.Color.R, 1.0f);
+	TestEqual(TEXT("Green lowered"), Redder.Emitters[0].Initialization.Color.G, 0.2f);
+	TestEqual(TEXT("Alpha untouched"), Redder.Emitters[0].Initialization.Color.A, 1.0f);
+	TestEqual(TEXT("Only the color changed"), UVFXDSLDiff::Compare(Base, Redder).Changes.Num(), 3);
+
+	// Structural edit addressed by name, JSON key spelling and index
+	FVFXResponseDispatcher::Classify(RecordedStructuralReply, Classified);
+	TestTrue(TEXT("Structural reply should be a patch"), Classified.Kind == EVFXResponseKind::Patch);
+
+	FVFXDSL Edited = Base;
+	TestTrue(TEXT("Structural patch should apply"), FVFXDSLPatch::ApplyPatch(Edited, Classified.Patch, Error));
+	TestEqual(TEXT("Emitter count"), Edited.Emitters.Num(), 3);
+	if (Edited.Emitters.Num() == 3)
+	{
+		TestEqual(TEXT("Appended emitter moved to the front"), Edited.Emitters[0].Name, FString(TEXT("Embers")));
+		TestEqual(TEXT("Added emitter parsed"), Edited.Emitters[0].Spawners.Rate.SpawnRate, 15.0f);
+		TestEqual(TEXT("Core shifted"), Edited.Emitters[1].Name, FString(TEXT("Core")));
+		TestEqual(TEXT("Sparks edited by name"), Edited.Emitters[2].Spawners.Burst.Count, 120);
+	}
+	TestEqual(TEXT("Effect duration"), Edited.Effect.Duration, 5.5f);
+
+	// Patches are far smaller than the document they edit
+	FString FullJson;
+	UVFXDSLParser::ToJSONWithFormat(Redder, EVFXDSLJsonFormat::Condensed, FullJson);
+	TestTrue(TEXT("Patch block is much smaller than the full DSL"), RedderPatchLength * 4 < FullJson.Len());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLPatchErrorsTest,
+	"AINiagara.VFXDSLPatch.Errors",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLPatchErrorsTest::RunTest(const FString& Parameters)
+{
+	FVFXDSL Base;
+	FString Error;
+	TestTrue(TEXT("Base DSL should parse"), UVFXDSLParser::ParseFromJSON(RecordedBaseDSL, Base, Error));
+	const uint64 BaseHash = FVFXDSLHash::Hash(Base);
+	FVFXDSLPatch Patch;
+
+	// Malformed documents are rejected by the parser
+	TestFalse(TEXT("Unknown op"), FVFXDSLPatch::ParseFromJSON(TEXT(R"({"patch": [{"op": "copy", "path": "Effect.Duration"}]})"), Patch, Error));
+	TestFalse(TEXT("Missing value"), FVFXDSLPatch::ParseFromJSON(TEXT(R"({"patch": [{"op": "set", "path": "Effect.Duration"}]})"), Patch, Error));
+	TestFalse(TEXT("Missing from"), FVFXDSLPatch::ParseFromJSON(TEXT(R"({"patch": [{"op": "move", "path": "Emitters[0]"}]})"), Patch, Error));
+
+	// Ops that cannot be resolved leave the DSL untouched and name the op
+	const TCHAR* BadPatches[] =
+	{
+		TEXT(R"({"patch": [{"op": "set", "path": "Emitters[0].Initialization.Colour.R", "value": 1.0}]})"),
+		TEXT(R"({"patch": [{"op": "set", "path": "Emitters[7].Name", "value": "Far"}]})"),
+		TEXT(R"({"patch": [{"op": "set", "path": "Emitters[Missing].Name", "value": "X"}]})"),
+		TEXT(R"({"patch": [{"op": "set", "path": "Effect.Duration", "value": "long"}]})"),
+		TEXT(R"({"patch": [{"op": "set", "path": "Effect.Type", "value": "Unity"}]})"),
+		TEXT(R"({"patch": [{"op": "remove", "path": "Emitters[0].Name"}]})"),
+		TEXT(R"({"patch": [{"op": "set", "path": "Effect.Duration", "value": 4.0}, {"op": "remove", "path": "Emitters[-]"}]})"),
+	};
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(BadPatches); ++Index)
+	{
+		TestTrue(FString::Printf(TEXT("Bad patch %d should parse"), Index), FVFXDSLPatch::ParseFromJSON(BadPatches[Index], Patch, Error));
+
+		FVFXDSL Target = Base;
+		Error.Reset();
+		TestFalse(FString::Printf(TEXT("Bad patch %d should fail"), Index), FVFXDSLPatch::ApplyPatch(Target, Patch, Error));
+		TestTrue(FString::Printf(TEXT("Bad patch %d error names the op"), Index), Error.StartsWith(TEXT("Patch op")));
+		TestEqual(FString::Printf(TEXT("Bad patch %d leaves the DSL untouched"), Index), FVFXDSLHash::Hash(Target), BaseHash);
+	}
+
+	// Results that do not validate are rejected as a whole
+	FVFXDSLPatch::ParseFromJSON(TEXT(R"({"patch": [{"op": "set", "path": "Emitters[1].Initialization.Color.R", "value": 2.0}]})"), Patch, Error);
+	FVFXDSL Target = Base;
+	FVFXDSLValidationResult Validation;
+	TestFalse(TEXT("Out-of-range color should fail validation"), FVFXDSLPatch::ApplyPatch(Target, Patch, Error, &Validation));
+	TestTrue(TEXT("Validation error is reported"), Validation.HasError(EVFXDSLValidationCode::ColorOutOfRange));
+	TestEqual(TEXT("Invalid result is discarded"), FVFXDSLHash::Hash(Target), BaseHash);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLPatchFromDiffTest,
+	"AINiagara.VFXDSLPatch.FromDiffRoundTrip",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLPatchFromDiffTest::RunTest(const FString& Parameters)
+{
+	const FVFXDSL Base = VFXDSLTestHelpers::MakeNamedDSL({ TEXT("Core"), TEXT("Sparks"), TEXT("Smoke"), TEXT("Embers"), TEXT("Glow"), TEXT("Debris") });
+
+	FVFXDSLEmitter Inserted;
+	Inserted.Name = TEXT("Inserted");
+	Inserted.Spawners.Burst.Count = 75;
+	Inserted.Update.Collision.bEnabled = true;
+
+	TArray<FVFXDSL> Variants;
+	Variants.Add(Base);
+	Variants.Last().Emitters[2].Initialization.Color.R = 0.95f;
+	Variants.Add(Base);
+	Variants.Last().Emitters.RemoveAt(4);
+	Variants.Last().Emitters.Insert(Inserted, 1);
+	Variants.Add(Base);
+	Variants.Last().Emitters.Insert(Variants.Last().Emitters.Pop(), 0);
+	Variants.Last().Emitters[3].Render.Mesh.bUseMesh = true;
+	Variants.Add(Base);
+	Variants.Last().Emitters[0].Name = TEXT("Renamed");
+	Variants.Last().Emitters.Swap(1, 5);
+	Variants.Last().Effect.Type = EVFXEffectType::Cascade;
+	Variants.Add(VFXDSLTestHelpers::MakeNamedDSL({ TEXT("Flash"), TEXT("Ring") }, 1.5f));
+
+	for (int32 Index = 0; Index < Variants.Num(); ++Index)
+	{
+		const FVFXDSLPatch Patch = FVFXDSLPatch::FromDiff(Base, Variants[Index]);
+
+		// Through JSON, as the model would send it
+		FString PatchJson;
+		FVFXDSLPatch Parsed;
+		FString Error;
+		TestTrue(FString::Printf(TEXT("Variant %d: patch serializes"), Index), FVFXDSLPatch::ToJSON(Patch, PatchJson));
+		TestTrue(FString::Printf(TEXT("Variant %d: patch parses"), Index), FVFXDSLPatch::ParseFromJSON(PatchJson, Parsed, Error));
+
+		FVFXDSL Patched = Base;
+		TestTrue(FString::Printf(TEXT("Variant %d: patch applies (%s)"), Index, *Error), FVFXDSLPatch::ApplyPatch(Patched, Parsed, Error));
+		TestFalse(FString::Printf(TEXT("Variant %d: no difference left"), Index), UVFXDSLDiff::AnyDifference(Patched, Variants[Index]));
+		TestEqual(FString::Printf(TEXT("Variant %d: hash matches"), Index), FVFXDSLHash::Hash(Patched), FVFXDSLHash::Hash(Variants[Index]));
+	}
+
+	TestEqual(TEXT("Single field edit is a single op"), FVFXDSLPatch::FromDiff(Base, Variants[0]).Ops.Num(), 1);
+	TestEqual(TEXT("Identical DSLs need no ops"), FVFXDSLPatch::FromDiff(Base, Base).Ops.Num(), 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLPatchBenchmarkTest,
+	"AINiagara.VFXDSLPatch.Benchmark.PatchVsFullDocument",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter
+)
+
+bool FVFXDSLPatchBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const int32 Iterations = 200;
+	const FVFXDSL Base = VFXDSLTestHelpers::MakeDSL(12, 3);
+
+	// "Make it redder": the same edit answered with the whole document or with a patch
+	FVFXDSL Redder = Base;
+	for (FVFXDSLEmitter& Emitter : Redder.Emitters)
+	{
+		Emitter.Initialization.Color.R = 1.0f;
+	}
+
+	FString FullJson;
+	UVFXDSLParser::ToJSONWithFormat(Redder, EVFXDSLJsonFormat::Condensed, FullJson);
+	const FString FullReply = FString(TEXT("```json\n")) + FullJson + TEXT("\n```");
+
+	FString PatchJson;
+	FVFXDSLPatch::ToJSON(FVFXDSLPatch::FromDiff(Base, Redder), PatchJson);
+	const FString PatchReply = FString(TEXT("```json\n")) + PatchJson + TEXT("\n```");
+
+	FVFXClassifiedResponse Classified;
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		FVFXResponseDispatcher::Classify(FullReply, Classified);
+	}
+	const double FullMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	FVFXDSL Patched;
+	FString Error;
+	bool bApplied = true;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		FVFXResponseDispatcher::Classify(PatchReply, Classified);
+		Patched = Base;
+		bApplied &= FVFXDSLPatch::ApplyPatch(Patched, Classified.Patch, Error);
+	}
+	const double PatchMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	TestTrue(TEXT("Patch applies"), bApplied);
+	TestFalse(TEXT("Patch reproduces the full reply"), UVFXDSLDiff::AnyDifference(Patched, Redder));
+	AddInfo(FString::Printf(TEXT("12-emitter refinement: full reply %d chars (%.2f ms for %d), patch reply %d chars (%.2f ms for %d, including apply and validation)"),
+		FullReply.Len(), FullMs, Iterations, PatchReply.Len(), PatchMs, Iterations));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,92 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/VFXDSL.h"
+#include "Core/VFXDSLParser.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Shared fixtures for DSL tests and benchmarks
+ */
+namespace VFXDSLTestHelpers
+{
+	/**
+	 * Build a deterministic DSL with the given number of emitters, for round trips and size benchmarks.
+	 * Values vary with the seed so a field the parser drops shows up as a mismatch.
+	 */
+	inline FVFXDSL MakeDSL(int32 NumEmitters, int32 Seed = 0)
+	{
+		FRandomStream Random(Seed);
+
+		FVFXDSL DSL;
+		DSL.Effect.Type = EVFXEffectType::Niagara;
+		DSL.Effect.Duration = 2.0f + Random.FRand() * 8.0f;
+		DSL.Effect.bLooping = (Seed % 2) == 0;
+
+		DSL.Emitters.Reserve(NumEmitters);
+		for (int32 Index = 0; Index < NumEmitters; ++Index)
+		{
+			FVFXDSLEmitter& Emitter = DSL.Emitters.AddDefaulted_GetRef();
+			Emitter.Name = FString::Printf(TEXT("Emitter_%d"), Index);
+			Emitter.Spawners.Burst.Count = Random.RandRange(0, 200);
+			Emitter.Spawners.Burst.Time = Random.FRand();
+			Emitter.Spawners.Burst.Intervals = { 0.25f, 0.5f };
+			Emitter.Spawners.Rate.SpawnRate = Random.FRandRange(0.0f, 500.0f);
+			Emitter.Initialization.Color.R = Random.FRand();
+			Emitter.Initialization.Color.G = Random.FRand();
+			Emitter.Initialization.Color.B = Random.FRand();
+			Emitter.Initialization.Size.Min = Random.FRandRange(0.5f, 2.0f);
+			Emitter.Initialization.Size.Max = Emitter.Initialization.Size.Min + Random.FRand() * 4.0f;
+			Emitter.Initialization.Velocity.Z = Random.FRandRange(0.0f, 500.0f);
+			Emitter.Update.Forces.Gravity = -980.0f;
+			Emitter.Update.Forces.Wind.X = Random.FRandRange(-50.0f, 50.0f);
+			Emitter.Update.Drag = Random.FRand();
+			Emitter.Update.Collision.bEnabled = (Index % 3) == 0;
+			Emitter.Update.Collision.Bounce = Random.FRand();
+			Emitter.Render.Material = TEXT("/Game/Materials/M_Particle");
+			Emitter.Render.BlendMode = (Index % 2) == 0 ? TEXT("Additive") : TEXT("Translucent");
+		}
+
+		return DSL;
+	}
+
+	/**
+	 * Build a small DSL with one emitter per name, for tests that edit specific emitters.
+	 * Emitters differ in burst count, spawn rate, tint and blend mode, and collision is on for every other one
+	 * starting with the first, so no two of them compare equal.
+	 */
+	inline FVFXDSL MakeNamedDSL(const TArray<FString>& Names, float Duration = 3.0f)
+	{
+		FVFXDSL DSL;
+		DSL.Effect.Duration = Duration;
+
+		for (int32 Index = 0; Index < Names.Num(); ++Index)
+		{
+			FVFXDSLEmitter& Emitter = DSL.Emitters.AddDefaulted_GetRef();
+			Emitter.Name = Names[Index];
+			Emitter.Spawners.Burst.Count = 20 * (Index + 1);
+			Emitter.Spawners.Rate.SpawnRate = 10.0f * (Index + 1);
+			Emitter.Initialization.Color.G = FMath::Min(0.15f * Index, 1.0f);
+			Emitter.Initialization.Color.B = FMath::Min(0.1f * Index, 1.0f);
+			Emitter.Update.Collision.bEnabled = (Index % 2) == 0;
+			Emitter.Render.BlendMode = (Index % 2) == 0 ? TEXT("Additive") : TEXT("Translucent");
+		}
+
+		return DSL;
+	}
+
+	/**
+	 * Build the JSON text for MakeDSL using the reference serializer
+	 */
+	inline FString MakeDSLJson(int32 NumEmitters, int32 Seed = 0)
+	{
+		FString Json;
+		UVFXDSLParser::ToJSON(MakeDSL(NumEmitters, Seed), Json);
+		return Json;
+	}
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
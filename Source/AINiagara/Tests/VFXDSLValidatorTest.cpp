@@ -3,6 +3,7 @@
 #include "Misc/AutomationTest.h"
 #include "Core/VFXDSLParser.h"
 #include "Core/VFXDSL.h"
+#include "VFXDSLTestHelpers.h"
 
 #if WITH_DEV_AUTOMATION_TESTS
 
@@ -100,5 +101,155 @@ bool FVFXDSLValidatorInvalidEffectTypeTest::RunTest(const FString& Parameters)
 	return true;
 }
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLValidatorStructuredErrorsTest,
+	"AINiagara.VFXDSLValidator.StructuredErrors",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLValidatorStructuredErrorsTest::RunTest(const FString& Parameters)
+{
+	FVFXDSL DSL;
+	DSL.Effect.Duration = -1.0f;
+
+	FVFXDSLEmitter& Valid = DSL.Emitters.AddDefaulted_GetRef();
+	Valid.Name = TEXT("Valid");
+
+	FVFXDSLEmitter& Invalid = DSL.Emitters.AddDefaulted_GetRef();
+	Invalid.Initialization.Color.G = 1.5f;
+	Invalid.Initialization.Size.Min = 4.0f;
+	Invalid.Initialization.Size.Max = 2.0f;
+	Invalid.Spawners.Burst.Count = -3;
+	Invalid.Update.Collision.bEnabled = true;
+	Invalid.Update.Collision.Bounce = 2.0f;
+
+	// Records only, no messages
+	FVFXDSLValidationResult Result;
+	UVFXDSLValidator::ValidateInto(DSL, Result);
+	TestFalse(TEXT("DSL should be invalid"), Result.bIsValid);
+	TestEqual(TEXT("Messages are not formatted eagerly"), Result.ErrorMessages.Num(), 0);
+	TestEqual(TEXT("Error record count"), Result.Errors.Num(), 6);
+
+	if (Result.Errors.Num() == 6)
+	{
+		TestTrue(TEXT("Effect error comes first"), Result.Errors[0].Code == EVFXDSLValidationCode::NegativeDuration && Result.Errors[0].EmitterIndex == INDEX_NONE);
+		TestTrue(TEXT("Empty name on emitter 1"), Result.Errors[1].Code == EVFXDSLValidationCode::EmptyName && Result.Errors[1].EmitterIndex == 1);
+		TestTrue(TEXT("Color field id"), Result.Errors[2].Field == EVFXDSLFieldId::InitializationColorG);
+		TestEqual(TEXT("Color offending value"), Result.Errors[2].Value, 1.5);
+		TestEqual(TEXT("Size comparison keeps both values"), Result.Errors[3].OtherValue, 2.0);
+		TestEqual(TEXT("Burst count value"), Result.Errors[4].Value, -3.0);
+		TestTrue(TEXT("Bounce code"), Result.Errors[5].Code == EVFXDSLValidationCode::BounceOutOfRange);
+	}
+	TestTrue(TEXT("Errors can be filtered by code"), Result.HasError(EVFXDSLValidationCode::SizeMinAboveMax));
+	TestFalse(TEXT("Absent codes are not reported"), Result.HasError(EVFXDSLValidationCode::NoEmitters));
+
+	// Formatted messages match the historical text
+	const FVFXDSLValidationResult Formatted = UVFXDSLValidator::Validate(DSL);
+	TestEqual(TEXT("One message per record"), Formatted.ErrorMessages.Num(), Formatted.Errors.Num());
+	if (Formatted.ErrorMessages.Num() == 6)
+	{
+		TestEqual(TEXT("Duration message"), Formatted.ErrorMessages[0], FString(TEXT("Effect duration must be non-negative, got: -1.000000")));
+		TestEqual(TEXT("Name message"), Formatted.ErrorMessages[1], FString(TEXT("Emitter[1]: Name is empty")));
+		TestEqual(TEXT("Color message"), Formatted.ErrorMessages[2], FString(TEXT("Emitter[1].Initialization.Color.G: Color component must be between 0 and 1, got: 1.500000")));
+		TestEqual(TEXT("Size message"), Formatted.ErrorMessages[3], FString(TEXT("Emitter[1].Initialization.Size: Min (4.000000) must be less than or equal to Max (2.000000)")));
+		TestEqual(TEXT("Burst message"), Formatted.ErrorMessages[4], FString(TEXT("Emitter[1].Spawners.Burst: Count must be non-negative, got: -3")));
+		TestEqual(TEXT("Bounce message"), Formatted.ErrorMessages[5], FString(TEXT("Emitter[1].Update.Collision: Bounce must be between 0 and 1, got: 2.000000")));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLValidatorBatchTest,
+	"AINiagara.VFXDSLValidator.ValidateBatch",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXDSLValidatorBatchTest::RunTest(const FString& Parameters)
+{
+	TArray<FVFXDSL> Corpus;
+	for (int32 Index = 0; Index < 256; ++Index)
+	{
+		FVFXDSL& DSL = Corpus.Add_GetRef(VFXDSLTestHelpers::MakeDSL(1 + (Index % 5), Index));
+		if (Index % 4 == 0)
+		{
+			DSL.Emitters.Last().Initialization.Color.R = 2.0f;
+		}
+	}
+
+	TArray<FVFXDSLValidationResult> Results;
+	const int32 NumInvalid = UVFXDSLValidator::ValidateBatch(Corpus, Results);
+	TestEqual(TEXT("One result per DSL"), Results.Num(), Corpus.Num());
+	TestEqual(TEXT("Every fourth DSL is invalid"), NumInvalid, Corpus.Num() / 4);
+
+	for (int32 Index = 0; Index < Corpus.Num(); ++Index)
+	{
+		const FVFXDSLValidationResult Serial = UVFXDSLValidator::Validate(Corpus[Index]);
+		if (Serial.bIsValid != Results[Index].bIsValid || Serial.Errors.Num() != Results[Index].Errors.Num())
+		{
+			AddError(FString::Printf(TEXT("Batch result %d differs from Validate"), Index));
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXDSLValidatorBenchmarkTest,
+	"AINiagara.VFXDSLValidator.Benchmark.Corpus10k",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter
+)
+
+bool FVFXDSLValidatorBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const int32 NumDSLs = 10000;
+
+	// Generated corpus where roughly a third of the DSLs carry several errors
+	TArray<FVFXDSL> Corpus;
+	Corpus.Reserve(NumDSLs);
+	for (int32 Index = 0; Index < NumDSLs; ++Index)
+	{
+		FVFXDSL& DSL = Corpus.Add_GetRef(VFXDSLTestHelpers::MakeDSL(4, Index));
+		if (Index % 3 == 0)
+		{
+			for (FVFXDSLEmitter& Emitter : DSL.Emitters)
+			{
+				Emitter.Initialization.Color.A = -0.5f;
+				Emitter.Initialization.Size.Min = Emitter.Initialization.Size.Max + 1.0f;
+			}
+		}
+	}
+
+	double StartTime = FPlatformTime::Seconds();
+	int32 NumInvalidFormatted = 0;
+	for (const FVFXDSL& DSL : Corpus)
+	{
+		NumInvalidFormatted += UVFXDSLValidator::Validate(DSL).bIsValid ? 0 : 1;
+	}
+	const double FormattedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	StartTime = FPlatformTime::Seconds();
+	FVFXDSLValidationResult Reused;
+	int32 NumInvalidSerial = 0;
+	for (const FVFXDSL& DSL : Corpus)
+	{
+		UVFXDSLValidator::ValidateInto(DSL, Reused);
+		NumInvalidSerial += Reused.bIsValid ? 0 : 1;
+	}
+	const double SerialMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	TArray<FVFXDSLValidationResult> Results;
+	StartTime = FPlatformTime::Seconds();
+	const int32 NumInvalidBatch = UVFXDSLValidator::ValidateBatch(Corpus, Results);
+	const double BatchMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	TestEqual(TEXT("Serial records agree with formatted validation"), NumInvalidSerial, NumInvalidFormatted);
+	TestEqual(TEXT("Batch agrees with formatted validation"), NumInvalidBatch, NumInvalidFormatted);
+	AddInfo(FString::Printf(TEXT("%d DSLs (%d invalid): formatted %.2f ms, records %.2f ms, parallel batch %.2f ms"),
+		NumDSLs, NumInvalidBatch, FormattedMs, SerialMs, BatchMs));
+
+	return true;
+}
+
 #endif // WITH_DEV_AUTOMATION_TESTS
 
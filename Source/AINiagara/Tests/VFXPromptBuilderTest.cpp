@@ -24,6 +24,7 @@ bool FVFXPromptBuilderSystemPromptTest::RunTest(const FString& Parameters)
 	// Verify it contains key sections
 	TestTrue(TEXT("Should contain VFX expert persona"), SystemPrompt.Contains(TEXT("VFX")) || SystemPrompt.Contains(TEXT("expert")));
 	TestTrue(TEXT("Should contain DSL information"), SystemPrompt.Contains(TEXT("DSL")) || SystemPrompt.Contains(TEXT("format")));
+	TestTrue(TEXT("Should describe DSL patches"), SystemPrompt.Contains(TEXT("\"patch\"")));
 	
 	// Verify it has substantial content
 	TestTrue(TEXT("System prompt should be substantial (>100 chars)"), SystemPrompt.Len() > 100);
@@ -231,6 +232,31 @@ bool FVFXPromptBuilderUnicodeTest::RunTest(const FString& Parameters)
 	return true;
 }
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXPromptBuilderDSLCorrectionTest,
+	"AINiagara.VFXPromptBuilder.DSLCorrection",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXPromptBuilderDSLCorrectionTest::RunTest(const FString& Parameters)
+{
+	const FString InvalidDSL = TEXT("{\"effect\":{\"type\":\"Niagara\",\"duration\":-1},\"emitters\":[]}");
+	TArray<FString> Errors;
+	Errors.Add(TEXT("Duration must be positive"));
+	Errors.Add(TEXT("At least one emitter is required"));
+
+	const FString Prompt = UVFXPromptBuilder::BuildDSLCorrectionPrompt(InvalidDSL, Errors);
+	TestTrue(TEXT("Prompt carries the DSL"), Prompt.Contains(InvalidDSL));
+	TestTrue(TEXT("Prompt lists each error"), Prompt.Contains(TEXT("- Duration must be positive")) && Prompt.Contains(TEXT("- At least one emitter is required")));
+
+	// The fast model gets the format without the persona, tools and patch rules
+	const FString SystemPrompt = UVFXPromptBuilder::BuildCorrectionSystemPrompt();
+	TestTrue(TEXT("Correction system prompt has the format"), SystemPrompt.Contains(TEXT("DSL Format Specification")));
+	TestTrue(TEXT("Correction system prompt is shorter"), SystemPrompt.Len() < UVFXPromptBuilder::BuildSystemPrompt().Len());
+
+	return true;
+}
+
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(
 	FVFXPromptBuilderConsistencyTest,
 	"AINiagara.VFXPromptBuilder.Consistency",
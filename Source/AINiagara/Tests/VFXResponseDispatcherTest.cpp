@@ -0,0 +1,318 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Core/VFXResponseDispatcher.h"
+#include "Core/VFXDSLParser.h"
+#include "Core/VFXDSL.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Core/GeminiAPIClient.h"
+#include "Tasks/Task.h"
+#include "VFXDSLTestHelpers.h"
+#include "GeminiTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Recorded reply: prose with placeholder braces, then a fenced DSL */
+	const TCHAR* RecordedDSLReply = TEXT(R"(Sure! Replace {color} with any tint you like. Here is the effect:
+
+```json
+{
+  "effect": { "type": "Niagara", "duration": 2.0, "looping": false },
+  "emitters": [
+    { "name": "Burst {core}", "spawners": { "burst": { "count": 60, "time": 0.0 } }, "render": { "blendMode": "Additive" } }
+  ]
+}
+```
+Enjoy.)");
+
+	/** Recorded tool call as emitted inline by the model */
+	const TCHAR* RecordedToolReply = TEXT(R"({"functionCall": {"name": "tool:texture", "args": {"prompt": "soft smoke puff", "type": "smoke", "resolution": 512}}})");
+
+	/** Recorded tool call wrapped in a candidates envelope */
+	const TCHAR* RecordedEnvelopeToolReply = TEXT(R"(I'll create a material first.
+{"candidates": [{"content": {"parts": [{"text": "calling"}, {"functionCall": {"name": "tool:material", "args": {"name": "M_Glow"}}}]}}]})");
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXResponseDispatcherClassifyTest,
+	"AINiagara.VFXResponseDispatcher.Classify",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXResponseDispatcherClassifyTest::RunTest(const FString& Parameters)
+{
+	FVFXClassifiedResponse Result;
+
+	// Fenced DSL behind prose that contains braces
+	const FString DSLReply(RecordedDSLReply);
+	FVFXResponseDispatcher::Classify(DSLReply, Result);
+	TestEqual(TEXT("Fenced reply should be a DSL"), FString(FVFXResponseDispatcher::GetKindName(Result.Kind)), FString(TEXT("DSL")));
+	TestEqual(TEXT("Emitter count"), Result.DSL.Emitters.Num(), 1);
+	if (Result.DSL.Emitters.Num() == 1)
+	{
+		TestEqual(TEXT("Braces inside strings are kept"), Result.DSL.Emitters[0].Name, FString(TEXT("Burst {core}")));
+	}
+	TestEqual(TEXT("Only the JSON block is parsed"), Result.NumParsedChars, Result.JsonLength);
+	TestTrue(TEXT("Block starts at the fenced object"), DSLReply.Mid(Result.JsonStart, 12).Contains(TEXT("\"effect\"")));
+	TestEqual(TEXT("Legacy path parsed the reply twice"), Result.NumLegacyParsedChars, DSLReply.Len() * 2);
+
+	// Bare function call
+	FVFXResponseDispatcher::Classify(RecordedToolReply, Result);
+	TestTrue(TEXT("Bare function call should be a tool call"), Result.Kind == EVFXResponseKind::ToolCall);
+	TestEqual(TEXT("Tool name"), Result.ToolName, FString(TEXT("tool:texture")));
+	TestTrue(TEXT("Tool args should be present"), Result.ToolArgs.IsValid() && Result.ToolArgs->GetStringField(TEXT("type")) == TEXT("smoke"));
+
+	// Function call inside a candidates envelope, after prose
+	FVFXResponseDispatcher::Classify(RecordedEnvelopeToolReply, Result);
+	TestTrue(TEXT("Envelope function call should be a tool call"), Result.Kind == EVFXResponseKind::ToolCall);
+	TestEqual(TEXT("Envelope tool name"), Result.ToolName, FString(TEXT("tool:material")));
+
+	// Prose, unrelated JSON and truncated documents are text and are not parsed
+	FVFXResponseDispatcher::Classify(TEXT("Try a {warmer} palette, e.g. {\"r\": 1.0}."), Result);
+	TestTrue(TEXT("Prose should be text"), Result.Kind == EVFXResponseKind::Text);
+	TestEqual(TEXT("Unrelated JSON is not parsed"), Result.NumParsedChars, 0);
+
+	const FString Truncated = DSLReply.Left(DSLReply.Find(TEXT("\"render\"")));
+	FVFXResponseDispatcher::Classify(Truncated, Result);
+	TestTrue(TEXT("Truncated DSL should be text"), Result.Kind == EVFXResponseKind::Text);
+	TestEqual(TEXT("Truncated DSL is not parsed"), Result.NumParsedChars, 0);
+
+	// A DSL-shaped block that fails to parse keeps the parser's error
+	FVFXResponseDispatcher::Classify(TEXT("{\"effect\": {\"type\": \"Niagara\"}, \"emitters\": []}"), Result);
+	TestTrue(TEXT("Invalid DSL should be text"), Result.Kind == EVFXResponseKind::Text);
+	TestFalse(TEXT("Parse error should be reported"), Result.DSLError.IsEmpty());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXResponseDispatcherFindJsonObjectTest,
+	"AINiagara.VFXResponseDispatcher.FindJsonObject",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXResponseDispatcherFindJsonObjectTest::RunTest(const FString& Parameters)
+{
+	const FString Text = TEXT("a {b} c {\"x\": \"}\\\"{\", \"y\": [1, {\"z\": 2}]} d {}");
+	int32 Start = INDEX_NONE;
+	int32 Length = 0;
+
+	TestTrue(TEXT("First object should be found"), FVFXResponseDispatcher::FindJsonObject(Text, 0, Start, Length));
+	TestEqual(TEXT("Placeholder braces are skipped"), Text.Mid(Start, Length), FString(TEXT("{\"x\": \"}\\\"{\", \"y\": [1, {\"z\": 2}]}")));
+
+	TestTrue(TEXT("Empty object should be found"), FVFXResponseDispatcher::FindJsonObject(Text, Start + Length, Start, Length));
+	TestEqual(TEXT("Empty object"), Text.Mid(Start, Length), FString(TEXT("{}")));
+
+	TestFalse(TEXT("No further objects"), FVFXResponseDispatcher::FindJsonObject(Text, Start + Length, Start, Length));
+	TestFalse(TEXT("Unterminated objects are not reported"), FVFXResponseDispatcher::FindJsonObject(TEXT("{\"a\": {\"b\": 1}"), 0, Start, Length));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXResponseDispatcherBenchmarkTest,
+	"AINiagara.VFXResponseDispatcher.Benchmark.OneParseVsLegacy",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter
+)
+
+bool FVFXResponseDispatcherBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const int32 Iterations = 200;
+	const FString Reply = FString(TEXT("Here is your effect:\n```json\n")) + VFXDSLTestHelpers::MakeDSLJson(12) + TEXT("\n```\n");
+
+	// Previous widget flow: DOM deserialization for tool calls, then a DSL parse of the whole reply
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		TSharedPtr<FJsonObject> JsonObject;
+		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Reply);
+		FJsonSerializer::Deserialize(Reader, JsonObject);
+
+		FVFXDSL DSL;
+		FString Error;
+		UVFXDSLParser::ParseFromJSON(Reply, DSL, Error);
+	}
+	const double LegacyMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	FVFXClassifiedResponse Result;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		FVFXResponseDispatcher::Classify(Reply, Result);
+	}
+	const double DispatchMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	TestTrue(TEXT("Fenced DSL should be recognised"), Result.Kind == EVFXResponseKind::DSL);
+	AddInfo(FString::Printf(TEXT("%d replies of %d chars: legacy %.2f ms (%d chars parsed each), dispatcher %.2f ms (%d chars parsed each)"),
+		Iterations, Reply.Len(), LegacyMs, Result.NumLegacyParsedChars, DispatchMs, Result.NumParsedChars));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXResponseDispatcherProcessTest,
+	"AINiagara.VFXResponseDispatcher.Process",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXResponseDispatcherProcessTest::RunTest(const FString& Parameters)
+{
+	FVFXProcessedResponse Result;
+
+	// A valid DSL is validated with no messages
+	FVFXResponseDispatcher::Process(RecordedDSLReply, nullptr, Result);
+	TestTrue(TEXT("DSL reply"), Result.Classified.Kind == EVFXResponseKind::DSL);
+	TestTrue(TEXT("Valid DSL"), Result.Validation.bIsValid);
+	TestFalse(TEXT("Not a patch"), Result.bWasPatch);
+
+	// An invalid DSL comes back with formatted messages
+	FVFXDSL InvalidDSL = VFXDSLTestHelpers::MakeNamedDSL({ TEXT("Core"), TEXT("Sparks") });
+	InvalidDSL.Effect.Duration = -1.0f;
+	FString InvalidJson;
+	UVFXDSLParser::ToJSON(InvalidDSL, InvalidJson);
+	FVFXResponseDispatcher::Process(InvalidJson, nullptr, Result);
+	TestTrue(TEXT("Invalid DSL reply"), Result.Classified.Kind == EVFXResponseKind::DSL);
+	TestFalse(TEXT("Validation failed"), Result.Validation.bIsValid);
+	TestTrue(TEXT("Messages are formatted"), Result.Validation.ErrorMessages.Num() > 0);
+
+	// A patch is applied to a copy of the base DSL
+	const FString PatchReply(TEXT(R"({"patch": [{"op": "set", "path": "Effect.Duration", "value": 7.5}]})"));
+	const FVFXDSL BaseDSL = VFXDSLTestHelpers::MakeNamedDSL({ TEXT("Core"), TEXT("Sparks") });
+	FVFXResponseDispatcher::Process(PatchReply, &BaseDSL, Result);
+	TestTrue(TEXT("Was a patch"), Result.bWasPatch);
+	TestTrue(TEXT("Patched DSL continues as a DSL"), Result.Classified.Kind == EVFXResponseKind::DSL);
+	TestEqual(TEXT("Patch applied"), Result.Classified.DSL.Effect.Duration, 7.5f);
+	TestEqual(TEXT("Base left untouched"), BaseDSL.Effect.Duration, VFXDSLTestHelpers::MakeNamedDSL({ TEXT("Core"), TEXT("Sparks") }).Effect.Duration);
+	TestTrue(TEXT("Patched DSL validated"), Result.Validation.bIsValid);
+
+	// Without a base the patch stays a patch, with a message
+	FVFXResponseDispatcher::Process(PatchReply, nullptr, Result);
+	TestTrue(TEXT("Unapplied patch"), Result.Classified.Kind == EVFXResponseKind::Patch);
+	TestFalse(TEXT("Patch error"), Result.PatchError.IsEmpty());
+
+	// Plain text passes through
+	FVFXResponseDispatcher::Process(TEXT("Just an answer."), nullptr, Result);
+	TestTrue(TEXT("Text reply"), Result.Classified.Kind == EVFXResponseKind::Text);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXResponseDispatcherProcessAsyncTest,
+	"AINiagara.VFXResponseDispatcher.ProcessAsync",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FVFXResponseDispatcherProcessAsyncTest::RunTest(const FString& Parameters)
+{
+	struct FRun
+	{
+		bool bDone = false;
+		bool bOnGameThread = false;
+		FVFXProcessedResponse Result;
+		double StartSeconds = 0.0;
+	};
+	TSharedRef<FRun> Run = MakeShared<FRun>();
+	Run->StartSeconds = FPlatformTime::Seconds();
+
+	// The base DSL is copied, so changing it afterwards does not affect the result
+	FVFXDSL BaseDSL = VFXDSLTestHelpers::MakeNamedDSL({ TEXT("Core"), TEXT("Sparks") });
+	const float BaseDuration = BaseDSL.Effect.Duration;
+	FVFXResponseDispatcher::ProcessAsync(TEXT(R"({"patch": [{"op": "set", "path": "Emitters[0].Name", "value": "Patched"}]})"), &BaseDSL,
+		[Run](FVFXProcessedResponse& Processed)
+		{
+			Run->bOnGameThread = IsInGameThread();
+			Run->Result = MoveTemp(Processed);
+			Run->bDone = true;
+		});
+	BaseDSL.Effect.Duration = -1.0f;
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Run, BaseDuration]()
+	{
+		if (!Run->bDone && FPlatformTime::Seconds() - Run->StartSeconds < 5.0)
+		{
+			return false;
+		}
+
+		TestTrue(TEXT("Delivered"), Run->bDone);
+		TestTrue(TEXT("Delivered on the game thread"), Run->bOnGameThread);
+		TestTrue(TEXT("Patch applied"), Run->Result.Classified.Kind == EVFXResponseKind::DSL);
+		TestTrue(TEXT("Patched DSL is valid"), Run->Result.Validation.bIsValid);
+		if (Run->Result.Classified.DSL.Emitters.Num() > 0)
+		{
+			TestEqual(TEXT("Patched name"), Run->Result.Classified.DSL.Emitters[0].Name, FString(TEXT("Patched")));
+		}
+		TestEqual(TEXT("Applied to the DSL as it was when called"), Run->Result.Classified.DSL.Effect.Duration, BaseDuration);
+		return true;
+	}));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVFXResponseDispatcherHitchBenchmarkTest,
+	"AINiagara.VFXResponseDispatcher.Benchmark.GameThreadHitch",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter
+)
+
+bool FVFXResponseDispatcherHitchBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const int32 Iterations = 50;
+	const FString Reply = FString(TEXT("Here is your effect:\n```json\n")) + VFXDSLTestHelpers::MakeDSLJson(64) + TEXT("\n```\n");
+	const FString Body = GeminiTestHelpers::MakeChunkJson(Reply, TEXT("STOP"));
+
+	// Before: the game thread parsed the HTTP body, classified the reply and validated the DSL
+	double WorstBeforeMs = 0.0;
+	double TotalBeforeMs = 0.0;
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		FGeminiResponse Response;
+		FGeminiAPIClient::ParseResponse(Body, Response);
+		FVFXClassifiedResponse Classified;
+		FVFXResponseDispatcher::Classify(Response.GetResponseText(), Classified);
+		FVFXDSLValidationResult Validation = UVFXDSLValidator::Validate(Classified.DSL);
+		const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		WorstBeforeMs = FMath::Max(WorstBeforeMs, ElapsedMs);
+		TotalBeforeMs += ElapsedMs;
+	}
+
+	// After: the game thread only launches the worker and reads its finished result
+	double WorstAfterMs = 0.0;
+	double TotalAfterMs = 0.0;
+	bool bAllValid = true;
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		TSharedRef<FVFXProcessedResponse, ESPMode::ThreadSafe> Processed = MakeShared<FVFXProcessedResponse, ESPMode::ThreadSafe>();
+		double StartTime = FPlatformTime::Seconds();
+		UE::Tasks::FTask Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [&Body, Processed]()
+		{
+			FGeminiResponse Response;
+			FGeminiAPIClient::ParseResponse(Body, Response);
+			FVFXResponseDispatcher::Process(Response.GetResponseText(), nullptr, *Processed);
+		});
+		double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		// Waiting stands in for the frames the editor keeps ticking meanwhile
+		Task.Wait();
+
+		StartTime = FPlatformTime::Seconds();
+		bAllValid &= Processed->Classified.Kind == EVFXResponseKind::DSL && Processed->Validation.bIsValid;
+		ElapsedMs += (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		WorstAfterMs = FMath::Max(WorstAfterMs, ElapsedMs);
+		TotalAfterMs += ElapsedMs;
+	}
+
+	TestTrue(TEXT("Every reply was processed to a valid DSL"), bAllValid);
+	AddInfo(FString::Printf(TEXT("%d replies of %d chars, game thread time per reply: before %.3f ms mean / %.3f ms worst, after %.3f ms mean / %.3f ms worst"),
+		Iterations, Body.Len(), TotalBeforeMs / Iterations, WorstBeforeMs, TotalAfterMs / Iterations, WorstAfterMs));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS